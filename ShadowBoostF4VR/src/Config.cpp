@@ -1,155 +1,395 @@
 #include "PCH.h"
 #include "Config.h"
 
+#include "ini_schema.h"
+#include "os_file.h"
+
+#include <FileWatch.hpp>
+
 namespace ShadowBoostF4VR
 {
-    void Config::load()
+    namespace
     {
-        const char* iniPath = "Data\\F4SE\\Plugins\\ShadowBoostF4VR.ini";
+        constexpr const char* IniPath   = "Data\\F4SE\\Plugins\\ShadowBoostF4VR.ini";
+        constexpr const char* McmPath   = "Data\\MCM\\Settings\\ShadowBoostF4VR.ini";
+        constexpr const char* CachePath = "Data\\F4SE\\Plugins\\ShadowBoostF4VR.cache";
+
+        using CascadePatch::IniField;
+        using CascadePatch::IniType;
+        using CascadePatch::IniTypeOf;
+        constexpr double U = CascadePatch::IniUnbounded;
+
+        // One entry per setting: section, key, member, range (the member's
+        // initializer is the default). Load, save, the SimpleIni overrides
+        // and the cache key are all generated from this table.
+#define SB_FIELD(section, key, member, lo, hi)                                                       \
+        IniField { section, key, IniTypeOf<decltype(ConfigValues::member)>(),                        \
+                   static_cast<std::uint32_t>(offsetof(ConfigValues, member)),                       \
+                   static_cast<double>(ConfigValues{}.member), lo, hi }
+#define SB_BLOCK_DISTANCE(section, level, key, member)                                               \
+        IniField { section, key, IniType::Float,                                                     \
+                   static_cast<std::uint32_t>(offsetof(ConfigValues, blockLevels) +                  \
+                                              level * sizeof(BlockLevel) + offsetof(BlockLevel, member)), \
+                   static_cast<double>(ConfigValues{}.blockLevels[level].member), -U, U }
+#define SB_BLOCK_LEVEL(section, level)                                                               \
+        SB_BLOCK_DISTANCE(section, level, "fBlockLevel2Distance", fLevel2),                          \
+        SB_BLOCK_DISTANCE(section, level, "fBlockLevel1Distance", fLevel1),                          \
+        SB_BLOCK_DISTANCE(section, level, "fBlockLevel0Distance", fLevel0)
+
+        constexpr IniField Fields[] = {
+            // Performance
+            SB_FIELD("Main", "bAutoAdjust", bAutoAdjust, 0, 1),
+            SB_FIELD("Main", "fFpsTarget", fFpsTarget, -U, U),
+            SB_FIELD("Main", "fFpsDelay", fFpsDelay, -U, U),
+            SB_FIELD("Main", "fMsTolerance", fMsTolerance, -U, U),
+            SB_FIELD("Main", "iFrameTimeMetric", iFrameTimeMetric, 0, 2),
+            SB_FIELD("Main", "iPercentileFrames", iPercentileFrames, 30, 100000),
+            SB_FIELD("Main", "iController", iController, 0, 1),
+            SB_FIELD("Main", "iAllocation", iAllocation, 0, 1),
+
+            // Controller
+            SB_FIELD("Controller", "fKp", fKp, -U, U),
+            SB_FIELD("Controller", "fKi", fKi, -U, U),
+            SB_FIELD("Controller", "fKd", fKd, -U, U),
+            SB_FIELD("Controller", "fDerivativeFilter", fDerivativeFilter, 0.01, 1.0),
+            SB_FIELD("Controller", "fDegradeGain", fDegradeGain, 0.0, U),
+            SB_FIELD("Controller", "fRestoreGain", fRestoreGain, 0.0, U),
+            SB_FIELD("Controller", "fMaxDegradeStep", fMaxDegradeStep, 0.0, 1.0),
+            SB_FIELD("Controller", "fMaxRestoreStep", fMaxRestoreStep, 0.0, 1.0),
+
+            // Cost model
+            SB_FIELD("CostModel", "fForgetting", fCostForgetting, 0.8, 1.0),
+            SB_FIELD("CostModel", "fGain", fCostGain, 0.0, 4.0),
+            SB_FIELD("CostModel", "fProbe", fCostProbe, 0.0, 0.2),
+
+            // Shadow
+            SB_FIELD("Shadow", "bEnable", bShadowEnable, 0, 1),
+            SB_FIELD("Shadow", "fDynamicValueFactor", fShadowFactor, -U, U),
+            SB_FIELD("Shadow", "fMinDistance", fShadowMin, -U, U),
+            SB_FIELD("Shadow", "fMaxDistance", fShadowMax, -U, U),
+
+            // LOD
+            SB_FIELD("Lod", "bEnable", bLodEnable, 0, 1),
+            SB_FIELD("Lod", "fDynamicValueFactor", fLodFactor, -U, U),
+            SB_FIELD("Lod", "fLODFadeOutMultObjectsMin", fLodObjectsMin, -U, U),
+            SB_FIELD("Lod", "fLODFadeOutMultObjectsMax", fLodObjectsMax, -U, U),
+            SB_FIELD("Lod", "fLODFadeOutMultItemsMin", fLodItemsMin, -U, U),
+            SB_FIELD("Lod", "fLODFadeOutMultItemsMax", fLodItemsMax, -U, U),
+            SB_FIELD("Lod", "fLODFadeOutMultActorsMin", fLodActorsMin, -U, U),
+            SB_FIELD("Lod", "fLODFadeOutMultActorsMax", fLodActorsMax, -U, U),
+
+            // Grass
+            SB_FIELD("Grass", "bEnable", bGrassEnable, 0, 1),
+            SB_FIELD("Grass", "fDynamicValueFactor", fGrassFactor, -U, U),
+            SB_FIELD("Grass", "fGrassStartFadeDistanceMin", fGrassMin, -U, U),
+            SB_FIELD("Grass", "fGrassStartFadeDistanceMax", fGrassMax, -U, U),
+
+            // Block levels
+            SB_FIELD("TerrainManager", "bEnable", bBlockEnable, 0, 1),
+            SB_BLOCK_LEVEL("TerrainManager", 0),
+            SB_BLOCK_LEVEL("TerrainManager:Level1", 1),
+            SB_BLOCK_LEVEL("TerrainManager:Level2", 2),
+            SB_BLOCK_LEVEL("TerrainManager:Level3", 3),
+
+            // God Rays
+            SB_FIELD("GodRays", "bEnable", bGodRaysEnable, 0, 1),
+            SB_FIELD("GodRays", "iQuality", iGodRaysQuality, -U, U),
+            SB_FIELD("GodRays", "iGrid", iGodRaysGrid, -U, U),
+            SB_FIELD("GodRays", "fScale", fGodRaysScale, -U, U),
+            SB_FIELD("GodRays", "iCascade", iGodRaysCascade, -U, U),
+
+            // Writes
+            SB_FIELD("Writes", "fShadowEpsilon", fShadowEpsilon, 0.0, U),
+            SB_FIELD("Writes", "fLodEpsilon", fLodEpsilon, 0.0, U),
+            SB_FIELD("Writes", "fGrassEpsilon", fGrassEpsilon, 0.0, U),
+            SB_FIELD("Writes", "iMinFrames", iWriteMinFrames, 0, 900),
+
+            // Cascades
+            SB_FIELD("Cascades", "iSchedule", iCascadeSchedule, 0, 4),
+            SB_FIELD("Cascades", "iWindowFrames", iCascadeWindowFrames, 4, 900),
+            SB_FIELD("Cascades", "fDropHeadroom", fCascadeDropHeadroom, 0.0, U),
+            SB_FIELD("Cascades", "fRaiseHeadroom", fCascadeRaiseHeadroom, 0.0, U),
+            SB_FIELD("Cascades", "bSplitRange", bSplitRange, 0, 1),
+            SB_FIELD("Cascades", "fSplitLambda", fSplitLambda, 0.0, 1.0),
+            SB_FIELD("Cascades", "fSplitNear", fSplitNear, 1.0, 1000.0),
+
+            // Shared shadows
+            SB_FIELD("SharedShadows", "iMode", iSharedShadowMode, 0, 2),
+            SB_FIELD("SharedShadows", "iWindowFrames", iSharedWindowFrames, 4, 900),
+            SB_FIELD("SharedShadows", "fOverBudget", fSharedOverBudget, 0.0, U),
+            SB_FIELD("SharedShadows", "fHeadroom", fSharedHeadroom, 0.0, U),
+            SB_FIELD("SharedShadows", "iMinWindows", iSharedMinWindows, 1, 100),
 
-        CSimpleIniA ini;
-        ini.SetUnicode();
+            // Telemetry
+            SB_FIELD("Telemetry", "bEnable", bTelemetry, 0, 1),
+            SB_FIELD("Telemetry", "iFrames", iTelemetryFrames, 1024, 1 << 24),
+        };
 
-        if (ini.LoadFile(iniPath) < 0) {
-            logger::info("No INI file found at {}, using defaults", iniPath);
+#undef SB_BLOCK_LEVEL
+#undef SB_BLOCK_DISTANCE
+#undef SB_FIELD
+
+        const CascadePatch::IniSchema Schema(Fields, sizeof(ConfigValues));
+        static_assert(std::is_trivially_copyable_v<ConfigValues>, "ShadowBoostF4VR.cache stores ConfigValues as bytes");
+
+        // Settings file sections and what re-applies when their keys change.
+        // [Stats] is written by the plugin itself and deliberately absent.
+        constexpr CascadePatch::SectionRoute Routes[] = {
+            { "Main", Subsystem::Governor },
+            { "Controller", Subsystem::Governor },
+            { "CostModel", Subsystem::Governor },
+            { "Shadow", Subsystem::Governor },
+            { "Lod", Subsystem::Governor },
+            { "Grass", Subsystem::Governor },
+            { "TerrainManager", Subsystem::Governor },
+            { "GodRays", Subsystem::GodRays },
+            { "Writes", Subsystem::Writes },
+            { "Cascades", Subsystem::Governor },
+            { "SharedShadows", Subsystem::Governor },
+            { "Telemetry", Subsystem::Telemetry },
+        };
+    }
+
+    namespace
+    {
+        void LogSummary(const char* what, const ConfigValues& v)
+        {
+            logger::info("{}: auto={} shadow=[{:.0f},{:.0f}] f={:.0f}, lod=[{:.1f},{:.1f}] f={:.2f}, "
+                "grass=[{:.0f},{:.0f}], fps={:.0f}, metric={}",
+                what, v.bAutoAdjust ? "ON" : "OFF",
+                v.fShadowMin, v.fShadowMax, v.fShadowFactor,
+                v.fLodObjectsMin, v.fLodObjectsMax, v.fLodFactor,
+                v.fGrassMin, v.fGrassMax, v.fFpsTarget,
+                v.iFrameTimeMetric == 2 ? "p99" : v.iFrameTimeMetric == 1 ? "p95" : "average");
+        }
+    }
+
+    Config::~Config() = default;
+
+    // Plugin INI, then MCM settings on top. When neither file changed since
+    // the last load, the merged values come from ShadowBoostF4VR.cache
+    // without opening either.
+    void Config::load()
+    {
+        using CascadePatch::ConfigBlob::Stamp;
+        if (Stamp(IniPath) == CascadePatch::ConfigBlob::SourceStamp{}) {
+            logger::info("No INI file found at {}, using defaults", IniPath);
             save();
-            return;
         }
 
-        logger::info("Loaded config from {}", iniPath);
-        loadFromIni(ini);
+        std::lock_guard lock(_loadLock);
+        const CascadePatch::ConfigBlob::SourceStamp sources[2] = { Stamp(IniPath), Stamp(McmPath) };
+        ConfigValues* values = this;
+        auto status = CascadePatch::ConfigBlob::Load(CachePath, Schema.Hash(), sources, std::size(sources), values,
+                                                     sizeof(ConfigValues));
+        if (status == CascadePatch::ConfigBlob::Status::Ok) {
+            std::copy(std::begin(sources), std::end(sources), _sources);
+            logger::info("Loaded config from {} (settings files unchanged)", CachePath);
+        } else {
+            loadFile(IniPath);
+            bool mcm = loadFile(McmPath);
+            saveCache(sources);
+            logger::info("Loaded config from {}{} (cache {})", IniPath, mcm ? " and the MCM settings" : "",
+                         CascadePatch::ConfigBlob::StatusName(status));
+        }
+        publish();
+        LogSummary("Config", *this);
     }
 
     void Config::save()
     {
-        const char* iniPath = "Data\\F4SE\\Plugins\\ShadowBoostF4VR.ini";
+        std::string text;
+        {
+            std::lock_guard lock(_loadLock);
+            const ConfigValues* values = this;
+            Schema.Save(values, text);
+        }
+        if (!CascadePatch::OS::WriteFileAtomic(IniPath, text.data(), text.size())) {
+            logger::warn("Failed to save config to {}", IniPath);
+        }
+    }
 
-        CSimpleIniA ini;
-        ini.SetUnicode();
-        saveIniConfigInternal(ini);
+    // Re-applies the MCM file if it changed since the last load. The watcher
+    // normally got there first, so this is usually one stat.
+    void Config::loadMCMSettings()
+    {
+        std::lock_guard lock(_loadLock);
+        const CascadePatch::ConfigBlob::SourceStamp sources[2] = { _sources[0],
+                                                                   CascadePatch::ConfigBlob::Stamp(McmPath) };
+        if (sources[1] == _sources[1]) return;
 
-        if (ini.SaveFile(iniPath) < 0) {
-            logger::warn("Failed to save config to {}", iniPath);
+        if (!loadFile(McmPath)) {
+            logger::info("MCM file not found, using current config");
+            _sources[1] = sources[1];
+            return;
         }
+        saveCache(sources);
+        publish();
+        LogSummary("MCM loaded", *this);
     }
 
-    void Config::loadMCMSettings()
+    // Applies the known keys of one INI file, mapped, without allocating
+    bool Config::loadFile(const char* path)
+    {
+        CascadePatch::OS::MappedFile file;
+        if (!file.Open(path)) return false;
+        ConfigValues* values = this;
+        Schema.Load(values, { reinterpret_cast<const char*>(file.Data()), file.Size() });
+        return true;
+    }
+
+    // `sources` are stamped before their files were read, so a write racing
+    // the read leaves the cache stale rather than wrong
+    void Config::saveCache(const CascadePatch::ConfigBlob::SourceStamp* sources)
+    {
+        std::copy(sources, sources + std::size(_sources), _sources);
+        const ConfigValues* values = this;
+        if (!CascadePatch::ConfigBlob::Save(CachePath, Schema.Hash(), _sources, std::size(_sources), values,
+                                            sizeof(ConfigValues))) {
+            logger::warn("Failed to write {}", CachePath);
+        }
+    }
+
+    void Config::watch(std::function<void(std::uint32_t)> onChange)
     {
-        const char* mcmPath = "Data\\MCM\\Settings\\ShadowBoostF4VR.ini";
+        if (_watcher) return;
+        _onChange = std::move(onChange);
+        _iniWatch.Open(IniPath, Routes, std::size(Routes));
+        _mcmWatch.Open(McmPath, Routes, std::size(Routes));
 
+        // One watcher over Data (with subdirectories) for both files. Events
+        // arrive on the watcher's thread, one at a time
+        try {
+            _watcher = std::make_unique<filewatch::FileWatch<std::string>>("Data",
+                std::regex(R"(.*ShadowBoostF4VR\.ini$)", std::regex::icase),
+                [this](const std::string&, const filewatch::Event event) {
+                    if (event == filewatch::Event::removed || event == filewatch::Event::renamed_old) return;
+                    if (std::uint32_t changed = reloadChanged(); changed && _onChange) _onChange(changed);
+                });
+            logger::info("Watching {} and {} for changes", _iniWatch.Path(), _mcmWatch.Path());
+        } catch (const std::exception& e) {
+            logger::warn("Cannot watch the settings files ({}); changes apply at the next game load", e.what());
+        }
+    }
+
+    // Reloads when either file's keys changed. The values are rebuilt the way
+    // load() builds them (defaults, plugin INI, MCM on top) from the text the
+    // checks just read, so a deleted key falls back to the plugin INI or the
+    // default. The rebuild is diffed field by field against the current
+    // values: only a setting that really changed is published and re-applied.
+    std::uint32_t Config::reloadChanged()
+    {
+        using CascadePatch::ConfigBlob::Stamp;
+        using CascadePatch::ConfigFileWatch;
+        const CascadePatch::ConfigBlob::SourceStamp sources[2] = { Stamp(IniPath), Stamp(McmPath) };
+        CascadePatch::ConfigChange iniChange, mcmChange;
+        bool ini = _iniWatch.Check(iniChange) == ConfigFileWatch::Result::Changed;
+        bool mcm = _mcmWatch.Check(mcmChange) == ConfigFileWatch::Result::Changed;
+
+        std::lock_guard lock(_loadLock);
+        std::uint32_t subsystems = 0;
+        bool differs = false;
+        if (ini || mcm) {
+            ConfigValues next;
+            Schema.Load(&next, _iniWatch.Text());
+            Schema.Load(&next, _mcmWatch.Text());
+
+            const ConfigValues* values = this;
+            for (const IniField& f : Fields) {
+                double from = CascadePatch::IniSchema::Get(f, values);
+                double to = CascadePatch::IniSchema::Get(f, &next);
+                if (from == to) continue;
+                differs = true;
+                logger::info("Setting changed: [{}] {} {} -> {}", f.section, f.key, from, to);
+                subsystems |= CascadePatch::RouteSection(Routes, std::size(Routes), f.section);
+            }
+            if (differs) static_cast<ConfigValues&>(*this) = next;
+        }
+
+        // Rewritten without a setting change (the Stats page, MCM saving as
+        // is, a key set to its current value): the cached values still hold,
+        // under the new stamps
+        if (differs) {
+            saveCache(sources);
+            publish();
+        } else if (!(sources[0] == _sources[0] && sources[1] == _sources[1])) {
+            saveCache(sources);
+        }
+        return subsystems;
+    }
+
+    // Frame-time percentiles for the MCM's read-only Stats page. Written when
+    // the pause menu opens, so the page shows the values as of that moment.
+    // The user's settings share the file: rewritten under _loadLock so no
+    // reload or second save interleaves, and through a temporary file and
+    // rename so MCM and the watcher only ever read a whole file.
+    void Config::saveMCMStats(float meanMs, float p50Ms, float p95Ms, float p99Ms, float maxMs,
+        std::uint64_t sharedToggles, float sharedSeconds)
+    {
+        std::lock_guard lock(_loadLock);
         CSimpleIniA mcmIni;
         mcmIni.SetUnicode();
-        SI_Error rc = mcmIni.LoadFile(mcmPath);
-        if (rc == SI_OK) {
-            loadFromIni(mcmIni);
-            logger::info("MCM loaded: auto={} shadow=[{:.0f},{:.0f}] f={:.0f}, lod=[{:.1f},{:.1f}] f={:.2f}, "
-                "grass=[{:.0f},{:.0f}], fps={:.0f}",
-                bAutoAdjust ? "ON" : "OFF",
-                fShadowMin, fShadowMax, fShadowFactor,
-                fLodObjectsMin, fLodObjectsMax, fLodFactor,
-                fGrassMin, fGrassMax, fFpsTarget);
-        } else {
-            logger::info("MCM file not found (rc={}), using current config", static_cast<int>(rc));
+        mcmIni.LoadFile(McmPath);  // keeps the user's settings; a missing file starts empty
+        mcmIni.SetDoubleValue("Stats", "fFrameTimeMean", meanMs);
+        mcmIni.SetDoubleValue("Stats", "fFrameTimeP50", p50Ms);
+        mcmIni.SetDoubleValue("Stats", "fFrameTimeP95", p95Ms);
+        mcmIni.SetDoubleValue("Stats", "fFrameTimeP99", p99Ms);
+        mcmIni.SetDoubleValue("Stats", "fFrameTimeMax", maxMs);
+        mcmIni.SetLongValue("Stats", "iSharedToggles", static_cast<long>(sharedToggles));
+        mcmIni.SetDoubleValue("Stats", "fSharedSeconds", sharedSeconds);
+
+        std::string text;
+        if (mcmIni.Save(text) < 0 || !CascadePatch::OS::WriteFileAtomic(McmPath, text.data(), text.size())) {
+            logger::warn("Failed to write frame-time stats to {}", McmPath);
         }
     }
 
+    // ConfigBase's SimpleIni path, through the same table and clamps
     void Config::loadFromIni(const CSimpleIniA& ini)
     {
-        // Performance
-        bAutoAdjust   = ini.GetBoolValue("Main", "bAutoAdjust", bAutoAdjust);
-        fFpsTarget    = static_cast<float>(ini.GetDoubleValue("Main", "fFpsTarget", fFpsTarget));
-        fFpsDelay     = static_cast<float>(ini.GetDoubleValue("Main", "fFpsDelay", fFpsDelay));
-        fMsTolerance  = static_cast<float>(ini.GetDoubleValue("Main", "fMsTolerance", fMsTolerance));
-
-        // Shadow
-        bShadowEnable = ini.GetBoolValue("Shadow", "bEnable", bShadowEnable);
-        fShadowFactor = static_cast<float>(ini.GetDoubleValue("Shadow", "fDynamicValueFactor", fShadowFactor));
-        fShadowMin    = static_cast<float>(ini.GetDoubleValue("Shadow", "fMinDistance", fShadowMin));
-        fShadowMax    = static_cast<float>(ini.GetDoubleValue("Shadow", "fMaxDistance", fShadowMax));
-
-        // LOD
-        bLodEnable     = ini.GetBoolValue("Lod", "bEnable", bLodEnable);
-        fLodFactor     = static_cast<float>(ini.GetDoubleValue("Lod", "fDynamicValueFactor", fLodFactor));
-        fLodObjectsMin = static_cast<float>(ini.GetDoubleValue("Lod", "fLODFadeOutMultObjectsMin", fLodObjectsMin));
-        fLodObjectsMax = static_cast<float>(ini.GetDoubleValue("Lod", "fLODFadeOutMultObjectsMax", fLodObjectsMax));
-        fLodItemsMin   = static_cast<float>(ini.GetDoubleValue("Lod", "fLODFadeOutMultItemsMin", fLodItemsMin));
-        fLodItemsMax   = static_cast<float>(ini.GetDoubleValue("Lod", "fLODFadeOutMultItemsMax", fLodItemsMax));
-        fLodActorsMin  = static_cast<float>(ini.GetDoubleValue("Lod", "fLODFadeOutMultActorsMin", fLodActorsMin));
-        fLodActorsMax  = static_cast<float>(ini.GetDoubleValue("Lod", "fLODFadeOutMultActorsMax", fLodActorsMax));
-
-        // Grass
-        bGrassEnable = ini.GetBoolValue("Grass", "bEnable", bGrassEnable);
-        fGrassFactor = static_cast<float>(ini.GetDoubleValue("Grass", "fDynamicValueFactor", fGrassFactor));
-        fGrassMin    = static_cast<float>(ini.GetDoubleValue("Grass", "fGrassStartFadeDistanceMin", fGrassMin));
-        fGrassMax    = static_cast<float>(ini.GetDoubleValue("Grass", "fGrassStartFadeDistanceMax", fGrassMax));
-
-        // Block levels
-        bBlockEnable = ini.GetBoolValue("TerrainManager", "bEnable", bBlockEnable);
-        const char* blSections[] = { "TerrainManager", "TerrainManager:Level1", "TerrainManager:Level2", "TerrainManager:Level3" };
-        for (int i = 0; i < MaxBlockLevels; i++) {
-            blockLevels[i].fLevel2 = static_cast<float>(ini.GetDoubleValue(blSections[i], "fBlockLevel2Distance", blockLevels[i].fLevel2));
-            blockLevels[i].fLevel1 = static_cast<float>(ini.GetDoubleValue(blSections[i], "fBlockLevel1Distance", blockLevels[i].fLevel1));
-            blockLevels[i].fLevel0 = static_cast<float>(ini.GetDoubleValue(blSections[i], "fBlockLevel0Distance", blockLevels[i].fLevel0));
+        using CascadePatch::IniSchema;
+        ConfigValues* values = this;
+        for (const IniField& f : Fields) {
+            double current = IniSchema::Get(f, values);
+            switch (f.type) {
+            case IniType::Bool:
+                IniSchema::Set(f, values, ini.GetBoolValue(f.section, f.key, current != 0.0) ? 1.0 : 0.0);
+                break;
+            case IniType::Int:
+                IniSchema::Set(f, values, static_cast<double>(ini.GetLongValue(f.section, f.key, static_cast<long>(current))));
+                break;
+            case IniType::Float:
+                IniSchema::Set(f, values, ini.GetDoubleValue(f.section, f.key, current));
+                break;
+            }
         }
+    }
 
-        // God Rays
-        bGodRaysEnable = ini.GetBoolValue("GodRays", "bEnable", bGodRaysEnable);
-        iGodRaysQuality = static_cast<std::int32_t>(ini.GetLongValue("GodRays", "iQuality", iGodRaysQuality));
-        iGodRaysGrid    = static_cast<std::int32_t>(ini.GetLongValue("GodRays", "iGrid", iGodRaysGrid));
-        fGodRaysScale   = static_cast<float>(ini.GetDoubleValue("GodRays", "fScale", fGodRaysScale));
-        iGodRaysCascade = static_cast<std::int32_t>(ini.GetLongValue("GodRays", "iCascade", iGodRaysCascade));
+    // One swap: readers see all of the loads since the last publish or none
+    void Config::publish()
+    {
+        _snapshots.Publish(static_cast<const ConfigValues&>(*this));
     }
 
     void Config::loadIniConfigInternal(const CSimpleIniA& ini)
     {
+        std::lock_guard lock(_loadLock);
         loadFromIni(ini);
+        publish();
     }
 
     void Config::saveIniConfigInternal(CSimpleIniA& ini)
     {
-        // Performance
-        ini.SetBoolValue("Main", "bAutoAdjust", bAutoAdjust);
-        ini.SetDoubleValue("Main", "fFpsTarget", fFpsTarget);
-        ini.SetDoubleValue("Main", "fFpsDelay", fFpsDelay);
-        ini.SetDoubleValue("Main", "fMsTolerance", fMsTolerance);
-
-        // Shadow
-        ini.SetBoolValue("Shadow", "bEnable", bShadowEnable);
-        ini.SetDoubleValue("Shadow", "fDynamicValueFactor", fShadowFactor);
-        ini.SetDoubleValue("Shadow", "fMinDistance", fShadowMin);
-        ini.SetDoubleValue("Shadow", "fMaxDistance", fShadowMax);
-
-        // LOD
-        ini.SetBoolValue("Lod", "bEnable", bLodEnable);
-        ini.SetDoubleValue("Lod", "fDynamicValueFactor", fLodFactor);
-        ini.SetDoubleValue("Lod", "fLODFadeOutMultObjectsMin", fLodObjectsMin);
-        ini.SetDoubleValue("Lod", "fLODFadeOutMultObjectsMax", fLodObjectsMax);
-        ini.SetDoubleValue("Lod", "fLODFadeOutMultItemsMin", fLodItemsMin);
-        ini.SetDoubleValue("Lod", "fLODFadeOutMultItemsMax", fLodItemsMax);
-        ini.SetDoubleValue("Lod", "fLODFadeOutMultActorsMin", fLodActorsMin);
-        ini.SetDoubleValue("Lod", "fLODFadeOutMultActorsMax", fLodActorsMax);
-
-        // Grass
-        ini.SetBoolValue("Grass", "bEnable", bGrassEnable);
-        ini.SetDoubleValue("Grass", "fDynamicValueFactor", fGrassFactor);
-        ini.SetDoubleValue("Grass", "fGrassStartFadeDistanceMin", fGrassMin);
-        ini.SetDoubleValue("Grass", "fGrassStartFadeDistanceMax", fGrassMax);
-
-        // Block levels
-        ini.SetBoolValue("TerrainManager", "bEnable", bBlockEnable);
-        const char* blSections[] = { "TerrainManager", "TerrainManager:Level1", "TerrainManager:Level2", "TerrainManager:Level3" };
-        for (int i = 0; i < MaxBlockLevels; i++) {
-            ini.SetDoubleValue(blSections[i], "fBlockLevel2Distance", blockLevels[i].fLevel2);
-            ini.SetDoubleValue(blSections[i], "fBlockLevel1Distance", blockLevels[i].fLevel1);
-            ini.SetDoubleValue(blSections[i], "fBlockLevel0Distance", blockLevels[i].fLevel0);
+        std::lock_guard lock(_loadLock);
+        const ConfigValues* values = this;
+        for (const IniField& f : Fields) {
+            double v = CascadePatch::IniSchema::Get(f, values);
+            switch (f.type) {
+            case IniType::Bool:  ini.SetBoolValue(f.section, f.key, v != 0.0); break;
+            case IniType::Int:   ini.SetLongValue(f.section, f.key, static_cast<long>(v)); break;
+            case IniType::Float: ini.SetDoubleValue(f.section, f.key, v); break;
+            }
         }
-
-        // God Rays
-        ini.SetBoolValue("GodRays", "bEnable", bGodRaysEnable);
-        ini.SetLongValue("GodRays", "iQuality", iGodRaysQuality);
-        ini.SetLongValue("GodRays", "iGrid", iGodRaysGrid);
-        ini.SetDoubleValue("GodRays", "fScale", fGodRaysScale);
-        ini.SetLongValue("GodRays", "iCascade", iGodRaysCascade);
     }
 
 } // namespace ShadowBoostF4VR
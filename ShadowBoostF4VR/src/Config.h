@@ -1,32 +1,88 @@
 #pragma once
 
 #include "ConfigBase.h"
+#include "config_blob.h"
+#include "config_watch.h"
+#include "rcu_cell.h"
+
+namespace filewatch
+{
+    template <class StringType>
+    class FileWatch;
+}
 
 namespace ShadowBoostF4VR
 {
     constexpr int MaxBlockLevels = 4;
 
+    // iFrameTimeMetric: which frame time the controller holds at the target
+    enum class FrameTimeMetric : std::int32_t {
+        Average = 0,
+        P95     = 1,
+        P99     = 2,
+    };
+
+    // iController: how the frame-time error moves the knobs
+    // (values match CascadePatch::ControllerMode)
+    enum class ControllerType : std::int32_t {
+        P   = 0,
+        PID = 1,
+    };
+
+    // iAllocation: which settings the step goes to
+    // (values match CascadePatch::Allocation)
+    enum class AllocationType : std::int32_t {
+        Factors   = 0,
+        CostModel = 1,
+    };
+
+    // What a settings change re-applies (Config::watch callback bits)
+    namespace Subsystem
+    {
+        enum : std::uint32_t {
+            Governor  = 1 << 0,   // picked up by the next frame's snapshot
+            GodRays   = 1 << 1,   // re-applied on the game thread
+            Writes    = 1 << 2,   // picked up by the next frame's snapshot
+            Telemetry = 1 << 3,   // opened at game load only
+        };
+    }
+
     struct BlockLevel {
         float fLevel2;
         float fLevel1;
         float fLevel0;
     };
 
-    class Config : public f4cf::ConfigBase
+    // Every setting, as plain data. Config loads into its own copy and
+    // publishes an immutable snapshot after each load; the render thread
+    // reads snapshots only (see Config::read). Keys, ranges and sections are
+    // in the schema table in Config.cpp; the initializers are the defaults.
+    struct ConfigValues
     {
-    public:
-        Config() : ConfigBase("ShadowBoostF4VR",
-            "Data\\F4SE\\Plugins\\ShadowBoostF4VR.ini", 0) {}
-
-        void load() override;
-        void save() override;
-        void loadMCMSettings();
-
         // ---- Performance ----
         bool  bAutoAdjust      = false;  // master toggle for FPS-based adjustment
         float fFpsTarget       = 90.0f;
         float fFpsDelay        = 10.0f;  // frames between adjustments
         float fMsTolerance     = 0.5f;   // ms tolerance (dead zone)
+        std::int32_t iFrameTimeMetric  = 0;    // 0 = average over fFpsDelay frames, 1 = p95, 2 = p99
+        std::int32_t iPercentileFrames = 450;  // frames per histogram window (percentiles cover 1-2 windows)
+        std::int32_t iController       = 0;    // 0 = original P step, 1 = PID ([Controller])
+        std::int32_t iAllocation       = 0;    // 0 = per-setting factors, 1 = estimated cost ([CostModel])
+
+        // ---- Controller (iController = 1; defaults of QualityController::Params::PID) ----
+        float fKp               = 1.5f;
+        float fKi               = 2.0f;
+        float fKd               = 0.3f;
+        float fDerivativeFilter = 0.5f;   // 1 = unfiltered D term
+        float fDegradeGain      = 2.0f;   // step multiplier when lowering quality
+        float fRestoreGain      = 0.5f;   // step multiplier when raising it
+        float fMaxDegradeStep   = 0.10f;  // per adjustment, fraction of [min, max]; 0 = unlimited
+        float fMaxRestoreStep   = 0.02f;
+
+        // ---- Cost model (iAllocation = 1; defaults of GovernorConfig) ----
+        float fCostForgetting   = 0.98f;  // 1 = never forget; lower follows scene changes faster
+        float fCostGain         = 0.5f;   // share of the step's ms spent per adjustment
+        float fCostProbe        = 0.02f;  // dither per adjustment, fraction of one setting's range
 
         // ---- Shadow ----
         bool  bShadowEnable    = true;
@@ -66,12 +122,82 @@ namespace ShadowBoostF4VR
         float        fGodRaysScale   = 0.4f;
         std::int32_t iGodRaysCascade = 1;
 
+        // ---- Writes: changes smaller than these are not written to the game ----
+        float        fShadowEpsilon  = 1.0f;   // game units
+        float        fLodEpsilon     = 0.01f;
+        float        fGrassEpsilon   = 1.0f;
+        std::int32_t iWriteMinFrames = 0;      // frames between two writes of one setting
+
+        // ---- Cascades: which cascades render on which frame (defaults of CascadeScheduleConfig) ----
+        std::int32_t iCascadeSchedule      = 1;     // 0 = all, 1 = adaptive, 2 = original, 3 = far half, 4 = far quarter
+        std::int32_t iCascadeWindowFrames  = 48;    // frames per adaptive decision
+        float        fCascadeDropHeadroom  = 0.3f;  // ms
+        float        fCascadeRaiseHeadroom = 1.0f;  // ms
+        bool         bSplitRange           = true;   // cascade split range follows the shadow distance
+        float        fSplitLambda          = 0.75f;  // split layout: 1 = logarithmic, 0 = uniform
+        float        fSplitNear            = 64.0f;  // game units where cascade 0 starts
+
+        // ---- Shared shadows: right eye on the left eye's maps (defaults of SharedShadowConfig) ----
+        std::int32_t iSharedShadowMode   = 2;     // 0 = separate, 1 = shared, 2 = auto
+        std::int32_t iSharedWindowFrames = 45;    // frames per auto decision
+        float        fSharedOverBudget   = 0.5f;  // ms over the budget to share
+        float        fSharedHeadroom     = 1.0f;  // ms left after the saving to separate
+        std::int32_t iSharedMinWindows   = 4;     // windows between two switches
+
+        // ---- Telemetry (read at game load) ----
+        bool         bTelemetry       = false;  // per-frame records to ShadowBoostF4VR.telemetry
+        std::int32_t iTelemetryFrames = 65536;  // ring size; the oldest frames are overwritten
+    };
+
+    class Config : public f4cf::ConfigBase, private ConfigValues
+    {
+    public:
+        using Snapshots = CascadePatch::RcuCell<ConfigValues>;
+
+        Config() : ConfigBase("ShadowBoostF4VR",
+            "Data\\F4SE\\Plugins\\ShadowBoostF4VR.ini", 0) {}
+        ~Config();
+
+        void load() override;              // plugin INI + MCM, or the cache when neither changed
+        void save() override;
+        void loadMCMSettings();            // only if the MCM file changed since the last load
+        void saveMCMStats(float meanMs, float p50Ms, float p95Ms, float p99Ms, float maxMs,
+            std::uint64_t sharedToggles, float sharedSeconds);
+
+        // Lock-free, for any thread: register once, then read() returns the
+        // latest complete snapshot. A reload never changes a snapshot already
+        // handed out; it is freed after its last reader lets go.
+        int registerReader() { return _snapshots.RegisterReader(); }
+        Snapshots::ReadGuard read(int reader) const { return _snapshots.Read(reader); }
+
+        // Watches both INI files from now on. A write that changes a setting
+        // reloads at once, and onChange gets the Subsystem bits touched
+        // (called on the watcher's thread).
+        void watch(std::function<void(std::uint32_t)> onChange);
+
     protected:
         void loadIniConfigInternal(const CSimpleIniA& ini) override;
         void saveIniConfigInternal(CSimpleIniA& ini) override;
 
     private:
+        // Under _loadLock; loads are followed by publish()
         void loadFromIni(const CSimpleIniA& ini);
+        bool loadFile(const char* path);
+        void saveCache(const CascadePatch::ConfigBlob::SourceStamp* sources);
+
+        void publish();
+        std::uint32_t reloadChanged();
+
+        std::mutex _loadLock;       // loaders and save(); readers never take it
+        Snapshots  _snapshots;
+
+        // Plugin INI and MCM file as of the last load (ShadowBoostF4VR.cache key)
+        CascadePatch::ConfigBlob::SourceStamp _sources[2];
+
+        CascadePatch::ConfigFileWatch _iniWatch;
+        CascadePatch::ConfigFileWatch _mcmWatch;
+        std::function<void(std::uint32_t)> _onChange;
+        std::unique_ptr<filewatch::FileWatch<std::string>> _watcher;
     };
 
 } // namespace ShadowBoostF4VR
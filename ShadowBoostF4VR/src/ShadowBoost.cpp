@@ -3,52 +3,96 @@
 
 namespace ShadowBoostF4VR
 {
-    constexpr float Millisecond = 1000.0f;
-
     // ========================================================================
-    // Shared shadow maps patch — applied after game load
+    // Shared shadow maps — sites resolved after game load
     // ========================================================================
-    bool SharedShadowFix::Apply()
+    bool SharedShadowFix::Resolve(std::uintptr_t (&out)[2])
     {
         auto base = REL::Module::get().base();
-        int applied = 0;
-
-        auto patchByte = [&](std::uintptr_t offset, std::uint8_t oldVal, std::uint8_t newVal,
-                             const char* label) -> bool {
-            auto* addr = reinterpret_cast<std::uint8_t*>(base + offset);
-            if (*addr == newVal) {
-                logger::info("  {} already patched (0x{:02X})", label, newVal);
-                applied++;
-                return true;
-            }
-            if (*addr != oldVal) {
-                logger::warn("  {} unexpected byte: 0x{:02X} (expected 0x{:02X})",
-                    label, *addr, oldVal);
+
+        // Resolve both sites (hint first, .text scan if the exe changed)
+        CascadePatch::SigScan::Resolution sites[2];
+        CascadePatch::PE::Section text;
+        const auto* image = reinterpret_cast<const std::uint8_t*>(base);
+        if (CascadePatch::PE::FindSection(image, SIZE_MAX, ".text", text)) {
+            CascadePatch::SigScan::ResolveAll(image, SIZE_MAX, text, Sites, 2, sites);
+        } else {
+            logger::warn("  .text section not found, using 1.2.72 offsets");
+            sites[0].rva = RightActivate_Offset;
+            sites[1].rva = RightDispatch_Offset;
+        }
+
+        for (int i = 0; i < 2; i++) {
+            if (sites[i].rva == 0) {
+                logger::warn("  {} site not found", Sites[i].name);
                 return false;
             }
-            DWORD oldProtect;
-            if (!VirtualProtect(addr, 1, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-                logger::error("  {} VirtualProtect failed", label);
-                return false;
+            if (sites[i].rva != Sites[i].hintRVA) {
+                logger::info("  {} relocated: 0x{:X} -> 0x{:X}", Sites[i].name, Sites[i].hintRVA, sites[i].rva);
             }
-            *addr = newVal;
-            VirtualProtect(addr, 1, oldProtect, &oldProtect);
-            FlushInstructionCache(GetCurrentProcess(), addr, 1);
-            logger::info("  {} patched: 0x{:02X} -> 0x{:02X}", label, oldVal, newVal);
-            applied++;
-            return true;
+            out[i] = base + sites[i].rva;
+        }
+        return true;
+    }
+
+    // ========================================================================
+    // Cascade mask rotation — rewritten on the game thread when it changes
+    // ========================================================================
+    namespace
+    {
+        // Operand per rotation slot
+        constexpr std::uintptr_t SlotOffsets[4] = {
+            CascadeMaskFix::InitMask_Offset, CascadeMaskFix::ArrayEntry1_Offset,
+            CascadeMaskFix::FallbackMask_Offset, CascadeMaskFix::ArrayEntry3_Offset,
         };
+        constexpr const char* SlotNames[4] = { "initial mask", "mask array[1]", "fallback mask", "mask array[3]" };
 
-        logger::info("Applying shared shadow maps (RIGHT eye uses LEFT shadow maps)...");
-        patchByte(RightActivate_Offset, OldDisp, NewDisp, "activate disp");
-        patchByte(RightDispatch_Offset, OldDisp, NewDisp, "dispatch disp");
+        std::uint8_t* slotByte(int slot)
+        {
+            return reinterpret_cast<std::uint8_t*>(REL::Module::get().base() + SlotOffsets[slot]);
+        }
+    }
 
-        if (applied == 2) {
-            logger::info("Shared shadow maps: 2/2 patches applied");
-            return true;
+    bool CascadeMaskFix::Read(CascadePatch::MaskPattern& out)
+    {
+        CascadePatch::MaskPattern p;
+        for (int i = 0; i < 4; i++) p.slot[i] = *slotByte(i);
+        if (p.slot[0] != p.slot[2]) return false;
+        bool known = p == CascadePatch::MaskOriginal;
+        for (const auto& level : CascadePatch::MaskLadder) known |= p == level;
+        if (known) out = p;
+        return known;
+    }
+
+    CascadePatch::Patch::Status CascadeMaskFix::Apply(const CascadePatch::MaskPattern& from, const CascadePatch::MaskPattern& to)
+    {
+        // One rotation in one batch: the writer never sees half of each
+        CascadePatch::Patch::Batch batch;
+        for (int i = 0; i < 4; i++) {
+            if (from.slot[i] != to.slot[i]) {
+                batch.Add(SlotNames[i], reinterpret_cast<std::uintptr_t>(slotByte(i)), &from.slot[i], &to.slot[i], 1, 0);
+            }
         }
-        logger::warn("Shared shadow maps: only {}/2 patches applied", applied);
-        return false;
+        batch.Apply(1u << 0);
+
+        auto result = CascadePatch::Patch::Status::Applied;
+        for (std::size_t i = 0; i < batch.Size(); i++) {
+            const auto& w = batch[i];
+            switch (w.status) {
+            case CascadePatch::Patch::Status::Applied:
+            case CascadePatch::Patch::Status::AlreadyApplied:
+            case CascadePatch::Patch::Status::GroupFailed:
+                break;
+            case CascadePatch::Patch::Status::ProtectFailed:
+                logger::error("  {} VirtualProtect failed ({})", w.name, w.error);
+                return w.status;
+            default:
+                logger::warn("  {} unexpected mask: 0x{:02X} (expected 0x{:02X})", w.name, w.found[0], w.expected[0]);
+                result = w.status;
+                break;
+            }
+        }
+        return result;
     }
 
     // Helper to look up a game setting and log result
@@ -119,6 +163,8 @@ namespace ShadowBoostF4VR
     bool ShadowBoost::init(Config* config)
     {
         _config = config;
+        if (_configReader < 0) _configReader = _config->registerReader();
+        ValuesScope values(*this);
 
         if (!cacheGameSettings()) {
             logger::error("Failed to cache game settings — dynamic adjustment disabled");
@@ -127,10 +173,18 @@ namespace ShadowBoostF4VR
 
         saveOriginalValues();
 
-        // Log current cascade split range (managed by version.dll proxy, not us)
+        // Cascade split range as the proxy set it (before our first write)
         if (offsets::ShadowDist2Cascade.address()) {
-            logger::info("ShadowDist2Cascade (from proxy) = {:.0f}",
-                *offsets::ShadowDist2Cascade);
+            if (_proxyRange <= 0.0f) {
+                _proxyRange = *offsets::ShadowDist2Cascade;
+                // The proxy fitted its default scheme's near pair to the game's
+                // 2-cascade range; recover that range to refit with ours
+                CascadePatch::SplitScheme proxyScheme;
+                _nearPairEnd = CascadePatch::ComputeSplits(proxyScheme, _proxyRange).split[proxyScheme.count / 2];
+            }
+            _splitRange = *offsets::ShadowDist2Cascade;
+            logger::info("ShadowDist2Cascade = {:.0f} (from proxy: {:.0f})", _splitRange, _proxyRange);
+            logSplits("Cascade split", _splitRange);
         }
 
         // Verify renderer shadow distance offset
@@ -140,141 +194,363 @@ namespace ShadowBoostF4VR
             _fDirShadowDistance ? _fDirShadowDistance->GetFloat() : -1.0f);
 
         // Initialize FPS tracking
-        _targetMs = Millisecond / _config->fFpsTarget;
-        _lastTime = std::chrono::steady_clock::now();
-        _frameCount = 0.0f;
-        _blockIndex = 0;
+        _lastFrameTime = std::chrono::steady_clock::now();
+        _governorConfig = governorConfig();
+        _governor.Reset(_governorConfig);
+        _stage.Reset();
+
+        if (_values->bTelemetry && !_telemetry.Ready()) {
+            const char* path = "Data\\F4SE\\Plugins\\ShadowBoostF4VR.telemetry";
+            if (_telemetry.Open(path, static_cast<std::uint32_t>(_values->iTelemetryFrames))) {
+                logger::info("Telemetry: {} ({} frames, export with telemetry_export)", path, _telemetry.Capacity());
+            } else {
+                logger::warn("Telemetry: cannot create {}", path);
+            }
+        }
 
         _initialized = true;
-        logger::info("ShadowBoost initialized (target={:.0f} FPS, {:.2f} ms/frame)",
-            _config->fFpsTarget, _targetMs);
+        static constexpr const char* metrics[] = { "average", "p95", "p99" };
+        static constexpr const char* controllers[] = { "P", "PID" };
+        static constexpr const char* allocations[] = { "factor", "cost model" };
+        logger::info("ShadowBoost initialized (target={:.0f} FPS, {:.2f} ms/frame, {} frame time, {}-frame window, {} controller, {} allocation)",
+            _values->fFpsTarget, _governor.Last().targetMs, metrics[_values->iFrameTimeMetric],
+            _governorConfig.percentileFrames, controllers[_values->iController], allocations[_values->iAllocation]);
         return true;
     }
 
     void ShadowBoost::applyGodRays()
     {
-        if (!_config || !_config->bGodRaysEnable) return;
+        if (!_config) return;
+        ValuesScope values(*this);
+        if (!_values->bGodRaysEnable) return;
 
-        if (_grQuality) _grQuality->SetInt(_config->iGodRaysQuality);
-        if (_grGrid)    _grGrid->SetInt(_config->iGodRaysGrid);
-        if (_grScale)   _grScale->SetFloat(_config->fGodRaysScale);
-        if (_grCascade) _grCascade->SetInt(_config->iGodRaysCascade);
+        if (_grQuality) _grQuality->SetInt(_values->iGodRaysQuality);
+        if (_grGrid)    _grGrid->SetInt(_values->iGodRaysGrid);
+        if (_grScale)   _grScale->SetFloat(_values->fGodRaysScale);
+        if (_grCascade) _grCascade->SetInt(_values->iGodRaysCascade);
 
         logger::info("God rays applied: quality={}, grid={}, scale={:.2f}, cascade={}",
-            _config->iGodRaysQuality, _config->iGodRaysGrid,
-            _config->fGodRaysScale, _config->iGodRaysCascade);
+            _values->iGodRaysQuality, _values->iGodRaysGrid,
+            _values->fGodRaysScale, _values->iGodRaysCascade);
     }
 
-    void ShadowBoost::update(float /*deltaTime*/)
+    CascadePatch::GovernorConfig ShadowBoost::governorConfig() const
     {
-        if (!_config || !_initialized) return;
+        using CascadePatch::Knob;
+        CascadePatch::GovernorConfig g;
+        g.autoAdjust = _values->bAutoAdjust;
+        g.fpsTarget = _values->fFpsTarget;
+        g.fpsDelay = _values->fFpsDelay;
+        g.msTolerance = _values->fMsTolerance;
+        g.metric = static_cast<CascadePatch::FrameMetric>(_values->iFrameTimeMetric);
+        g.percentileFrames = static_cast<std::uint32_t>(_values->iPercentileFrames);
+        g.controller = static_cast<CascadePatch::ControllerMode>(_values->iController);
+        g.pid.kp = _values->fKp;
+        g.pid.ki = _values->fKi;
+        g.pid.kd = _values->fKd;
+        g.pid.derivativeFilter = _values->fDerivativeFilter;
+        g.pid.degradeGain = _values->fDegradeGain;
+        g.pid.restoreGain = _values->fRestoreGain;
+        g.pid.maxDegradeStep = _values->fMaxDegradeStep;
+        g.pid.maxRestoreStep = _values->fMaxRestoreStep;
+        g.allocation = static_cast<CascadePatch::Allocation>(_values->iAllocation);
+        g.costForgetting = _values->fCostForgetting;
+        g.costGain = _values->fCostGain;
+        g.costProbe = _values->fCostProbe;
+        g.Of(Knob::ShadowDistance) = { _values->bShadowEnable, _values->fShadowFactor, _values->fShadowMin, _values->fShadowMax };
+        g.Of(Knob::LodObjects) = { _values->bLodEnable, _values->fLodFactor, _values->fLodObjectsMin, _values->fLodObjectsMax };
+        g.Of(Knob::LodItems) = { _values->bLodEnable, _values->fLodFactor, _values->fLodItemsMin, _values->fLodItemsMax };
+        g.Of(Knob::LodActors) = { _values->bLodEnable, _values->fLodFactor, _values->fLodActorsMin, _values->fLodActorsMax };
+        g.Of(Knob::GrassDistance) = { _values->bGrassEnable, _values->fGrassFactor, _values->fGrassMin, _values->fGrassMax };
+        g.blockEnable = _values->bBlockEnable;
+        g.blockLevels = MaxBlockLevels;
+        return g;
+    }
+
+    void ShadowBoost::applyWriteLimits()
+    {
+        using CascadePatch::Knob;
+        auto frames = static_cast<std::uint32_t>(_values->iWriteMinFrames);
+        _stage.SetLimit(Knob::ShadowDistance, { _values->fShadowEpsilon, frames });
+        _stage.SetLimit(Knob::LodObjects, { _values->fLodEpsilon, frames });
+        _stage.SetLimit(Knob::LodItems, { _values->fLodEpsilon, frames });
+        _stage.SetLimit(Knob::LodActors, { _values->fLodEpsilon, frames });
+        _stage.SetLimit(Knob::GrassDistance, { _values->fGrassEpsilon, frames });
+    }
+
+    // ---- SettingsBackend: the knobs the governor moves ----
+
+    RE::Setting* ShadowBoost::setting(CascadePatch::Knob knob) const
+    {
+        switch (knob) {
+        case CascadePatch::Knob::LodObjects:    return _fLODFadeOutMultObjects;
+        case CascadePatch::Knob::LodItems:      return _fLODFadeOutMultItems;
+        case CascadePatch::Knob::LodActors:     return _fLODFadeOutMultActors;
+        case CascadePatch::Knob::GrassDistance: return _fGrassStartFadeDistance;
+        default: return nullptr;
+        }
+    }
 
-        // ---- Throttle: only run every fFpsDelay frames ----
-        _frameCount += 1.0f;
-        if (_frameCount < _config->fFpsDelay) {
+    bool ShadowBoost::Has(CascadePatch::Knob knob) const
+    {
+        return knob == CascadePatch::Knob::ShadowDistance || setting(knob) != nullptr;
+    }
+
+    float ShadowBoost::Get(CascadePatch::Knob knob) const
+    {
+        if (knob == CascadePatch::Knob::ShadowDistance) return *offsets::ShadowDistRenderer;
+        return setting(knob)->GetFloat();
+    }
+
+    void ShadowBoost::Set(CascadePatch::Knob knob, float value)
+    {
+        // Shadow distance goes to the renderer cache only — NEVER to
+        // RE::Setting, values >3000 in INI crash VR
+        if (knob == CascadePatch::Knob::ShadowDistance) {
+            *offsets::ShadowDistRenderer = value;
             return;
         }
-        _frameCount = 0.0f;
+        setting(knob)->SetFloat(value);
+    }
 
-        // ---- Calculate FPS-based adjustment (only when auto-adjust is on) ----
-        float dyn = 0.0f;
+    bool ShadowBoost::HasBlockLevels() const
+    {
+        return _fBlockLevel0Distance && _fBlockLevel1Distance && _fBlockLevel2Distance;
+    }
 
-        auto now = std::chrono::steady_clock::now();
-        auto delta = std::chrono::duration_cast<std::chrono::microseconds>(now - _lastTime);
-        float avgMs = static_cast<float>(delta.count()) / Millisecond / _config->fFpsDelay;
-        _lastTime = now;
+    void ShadowBoost::SetBlockLevel(int index)
+    {
+        auto& bl = _values->blockLevels[index];
+        _fBlockLevel2Distance->SetFloat(bl.fLevel2);
+        _fBlockLevel1Distance->SetFloat(bl.fLevel1);
+        _fBlockLevel0Distance->SetFloat(bl.fLevel0);
+    }
 
-        _targetMs = Millisecond / _config->fFpsTarget;
+    CascadePatch::FrameTimeStats ShadowBoost::frameStats() const
+    {
+        std::lock_guard lock(_statsLock);
+        return _stats;
+    }
 
-        if (_config->bAutoAdjust) {
-            dyn = avgMs - _targetMs;
+    CascadePatch::SplitScheme ShadowBoost::splitScheme() const
+    {
+        CascadePatch::SplitScheme scheme;
+        scheme.nearDist = _values->fSplitNear;
+        scheme.lambda = _values->fSplitLambda;
+        return scheme;
+    }
 
-            // Dead zone: if barely over target, don't adjust
-            if (dyn >= 0.0f && dyn <= _config->fMsTolerance) {
-                dyn = 0.0f;
-            }
+    float ShadowBoost::splitRange(float shadowDistance)
+    {
+        // Our scheme's near pair on the game's 2-cascade range, as the proxy
+        // does with the default one; refitted only when the scheme changes
+        auto scheme = splitScheme();
+        if (_fitRange <= 0.0f || !(scheme == _fitScheme)) {
+            _fitScheme = scheme;
+            _fitRange = CascadePatch::RangeForNearPair(scheme, _nearPairEnd);
         }
+        return std::max(std::min(_fitRange, shadowDistance), 2.0f * scheme.nearDist);
+    }
 
-        // Periodic debug logging
-        _debugCounter++;
-        if (_debugCounter >= 90) {
-            _debugCounter = 0;
-            float curShadow = offsets::ShadowDistRenderer.address() ? *offsets::ShadowDistRenderer : -1.0f;
-            float curLodObj = _fLODFadeOutMultObjects ? _fLODFadeOutMultObjects->GetFloat() : -1.0f;
-            float curGrass = _fGrassStartFadeDistance ? _fGrassStartFadeDistance->GetFloat() : -1.0f;
-            logger::info("SB: auto={} avg={:.2f}ms tgt={:.2f}ms dyn={:.2f} | "
-                "shadow={:.0f} [{:.0f},{:.0f}] | lod={:.1f} [{:.1f},{:.1f}] | grass={:.0f} [{:.0f},{:.0f}]",
-                _config->bAutoAdjust ? "ON" : "OFF", avgMs, _targetMs, dyn,
-                curShadow, _config->fShadowMin, _config->fShadowMax,
-                curLodObj, _config->fLodObjectsMin, _config->fLodObjectsMax,
-                curGrass, _config->fGrassMin, _config->fGrassMax);
+    void ShadowBoost::updateSplitRange()
+    {
+        // Cascades cover the shadow distance and no further. Checked every
+        // frame, not on distance writes: the stage skips those while the
+        // distance holds, and a reload can change the scheme or bSplitRange
+        if (!offsets::ShadowDist2Cascade.address() || _proxyRange <= 0.0f) return;
+        float distance = *offsets::ShadowDistRenderer;
+        if (_values->bSplitRange && distance <= 0.0f) return;   // renderer not set up yet
+        float range = _values->bSplitRange ? splitRange(distance) : _proxyRange;
+        if (range == _splitRange) return;
+        _splitRange = range;
+        *offsets::ShadowDist2Cascade = range;
+    }
+
+    void ShadowBoost::logSplits(const char* what, float range) const
+    {
+        // Only the range reaches the game, which lays its cascades out in it
+        // itself; the splits are our scheme's model of that layout
+        auto scheme = splitScheme();
+        auto s = CascadePatch::ComputeSplits(scheme, range);
+        logger::info("{}: range {:.0f}, modeled splits {:.0f}-{:.0f} | {:.0f}-{:.0f} | {:.0f}-{:.0f} | {:.0f}-{:.0f} (lambda {:.2f})",
+            what, range, s.split[0], s.split[1], s.split[1], s.split[2], s.split[2], s.split[3], s.split[3], s.split[4],
+            scheme.lambda);
+    }
+
+    void ShadowBoost::updateCascadeMask(std::uint32_t frameUs)
+    {
+        CascadePatch::CascadeScheduleConfig c;
+        c.mode = static_cast<CascadePatch::CascadeSchedule>(_values->iCascadeSchedule);
+        c.adapt = _values->bAutoAdjust;
+        c.budgetMs = 1000.0f / std::max(_values->fFpsTarget, 1.0f);
+        c.windowFrames = static_cast<std::uint32_t>(_values->iCascadeWindowFrames);
+        c.dropHeadroomMs = _values->fCascadeDropHeadroom;
+        c.raiseHeadroomMs = _values->fCascadeRaiseHeadroom;
+        _cascades.Configure(c);
+        _cascades.Frame(frameUs);
+        if (!_maskWritable) return;
+
+        // The writer stays in mask safe mode until the preloader's restore;
+        // nothing is written before a rotation is read back
+        if (!_maskKnown) {
+            if (!CascadeMaskFix::Read(_maskPattern)) return;
+            _maskKnown = true;
         }
+        const auto& p = _cascades.Pattern();
+        if (p == _maskPattern) return;
 
-        // ---- Shadow distance ----
-        // Only write to renderer cache — NEVER to RE::Setting, values >3000 in INI crash VR.
-        if (_config->bAutoAdjust && _config->bShadowEnable) {
-            // P-controller: adjust between min and max based on FPS
-            float cur = *offsets::ShadowDistRenderer;
-            float adj = std::clamp(cur - dyn * _config->fShadowFactor,
-                _config->fShadowMin, _config->fShadowMax);
-            *offsets::ShadowDistRenderer = adj;
-        } else {
-            // Direct: max slider sets the shadow distance
-            *offsets::ShadowDistRenderer = _config->fShadowMax;
+        auto status = CascadeMaskFix::Apply(_maskPattern, p);
+        if (status == CascadePatch::Patch::Status::ProtectFailed) {
+            _maskWritable = false;
+            logger::warn("Cascade schedule: mask rotation not writable, left as is");
+            return;
         }
+        if (status != CascadePatch::Patch::Status::Applied) {
+            // Rewritten behind our back: read it back before the next write
+            _maskKnown = false;
+            return;
+        }
+        _maskPattern = p;
+        logger::info("SB: cascade rotation {{0x{:X},0x{:X},0x{:X},0x{:X}}} (level {}, window mean {:.2f}ms)",
+            p.slot[0], p.slot[1], p.slot[2], p.slot[3], _cascades.Level(), _cascades.LastMeanMs());
+    }
 
-        // ---- LOD fade multipliers ----
-        if (_config->bAutoAdjust && _config->bLodEnable) {
-            float d = dyn * _config->fLodFactor;
-            if (_fLODFadeOutMultObjects) {
-                float cur = _fLODFadeOutMultObjects->GetFloat();
-                _fLODFadeOutMultObjects->SetFloat(
-                    std::clamp(cur - d, _config->fLodObjectsMin, _config->fLodObjectsMax));
-            }
-            if (_fLODFadeOutMultItems) {
-                float cur = _fLODFadeOutMultItems->GetFloat();
-                _fLODFadeOutMultItems->SetFloat(
-                    std::clamp(cur - d, _config->fLodItemsMin, _config->fLodItemsMax));
-            }
-            if (_fLODFadeOutMultActors) {
-                float cur = _fLODFadeOutMultActors->GetFloat();
-                _fLODFadeOutMultActors->SetFloat(
-                    std::clamp(cur - d, _config->fLodActorsMin, _config->fLodActorsMax));
+    void ShadowBoost::attachSharedShadows()
+    {
+        logger::info("Attaching shared shadow maps (RIGHT eye on LEFT shadow maps)...");
+        ValuesScope values(*this);
+        std::uintptr_t sites[2];
+        const char* const names[2] = { SharedShadowFix::Sites[0].name, SharedShadowFix::Sites[1].name };
+        if (!SharedShadowFix::Resolve(sites)) {
+            logger::warn("Shared shadow maps: sites not found, eyes stay separate");
+            return;
+        }
+        if (!_sharedShadows.Attach(sites, names)) {
+            logger::warn("Shared shadow maps: unexpected bytes 0x{:02X}/0x{:02X}, left as is",
+                *reinterpret_cast<const std::uint8_t*>(sites[0]), *reinterpret_cast<const std::uint8_t*>(sites[1]));
+            return;
+        }
+        logger::info("Shared shadow maps: attached ({}), mode {}", _sharedShadows.IsShared() ? "shared" : "separate",
+            _values->iSharedShadowMode);
+    }
+
+    CascadePatch::SharedShadowToggle::Counters ShadowBoost::sharedShadowStats() const
+    {
+        std::lock_guard lock(_statsLock);
+        return _sharedStats;
+    }
+
+    void ShadowBoost::updateSharedShadows(std::uint32_t frameUs)
+    {
+        if (!_sharedShadows.Attached()) return;
+        CascadePatch::SharedShadowConfig c;
+        c.mode = static_cast<CascadePatch::SharedShadowMode>(_values->iSharedShadowMode);
+        c.adapt = _values->bAutoAdjust;
+        c.budgetMs = 1000.0f / std::max(_values->fFpsTarget, 1.0f);
+        c.windowFrames = static_cast<std::uint32_t>(_values->iSharedWindowFrames);
+        c.onOverMs = _values->fSharedOverBudget;
+        c.offHeadroomMs = _values->fSharedHeadroom;
+        c.minWindows = static_cast<std::uint32_t>(_values->iSharedMinWindows);
+        _sharedShadows.Configure(c);
+        if (_sharedShadows.Frame(frameUs)) {
+            const auto& s = _sharedShadows.Stats();
+            logger::info("SB: shared shadow maps {} (window mean {:.2f}ms, saving {:.2f}ms, {} toggles)",
+                _sharedShadows.IsShared() ? "ON" : "OFF", _sharedShadows.LastMeanMs(), _sharedShadows.SavingMs(), s.toggles);
+            return;
+        }
+
+        if (!_sharedShadows.Attached()) {
+            // Neither byte changed; the toggle lets go of the code for good
+            const auto& batch = _sharedShadows.LastBatch();
+            for (std::size_t i = 0; i < batch.Size(); i++) {
+                const auto& w = batch[i];
+                if (w.status == CascadePatch::Patch::Status::ProtectFailed) {
+                    logger::error("  {} VirtualProtect failed ({})", w.name, w.error);
+                } else if (w.status == CascadePatch::Patch::Status::Mismatch) {
+                    logger::warn("  {} unexpected byte: 0x{:02X} (expected 0x{:02X})", w.name, w.found[0], w.expected[0]);
+                }
             }
-        } else {
-            // Direct: max sliders set the LOD values
-            if (_fLODFadeOutMultObjects) _fLODFadeOutMultObjects->SetFloat(_config->fLodObjectsMax);
-            if (_fLODFadeOutMultItems)   _fLODFadeOutMultItems->SetFloat(_config->fLodItemsMax);
-            if (_fLODFadeOutMultActors)  _fLODFadeOutMultActors->SetFloat(_config->fLodActorsMax);
+            logger::warn("Shared shadow maps: rewrite failed, left {}", _sharedShadows.IsShared() ? "shared" : "separate");
         }
+    }
 
-        // ---- Grass distance ----
-        if (_config->bAutoAdjust && _config->bGrassEnable && _fGrassStartFadeDistance) {
-            float cur = _fGrassStartFadeDistance->GetFloat();
-            float adj = std::clamp(cur - dyn * _config->fGrassFactor,
-                _config->fGrassMin, _config->fGrassMax);
-            _fGrassStartFadeDistance->SetFloat(adj);
-        } else if (_fGrassStartFadeDistance) {
-            // Direct: max slider sets the grass distance
-            _fGrassStartFadeDistance->SetFloat(_config->fGrassMax);
+    void ShadowBoost::update(float /*deltaTime*/)
+    {
+        if (!_config || !_initialized) return;
+
+        // ---- Every frame: frame time into the governor ----
+        auto frameNow = std::chrono::steady_clock::now();
+        auto frameUs = std::chrono::duration_cast<std::chrono::microseconds>(frameNow - _lastFrameTime).count();
+        _lastFrameTime = frameNow;
+
+        // One config snapshot for the whole frame. An MCM reload publishes a
+        // new one and never changes this one, so min/max pairs always match;
+        // it applies on the next frame
+        ValuesScope values(*this);
+
+        // Governor and write limits follow the snapshot by themselves; the
+        // rest of a reload is applied here, on the game thread
+        if (auto apply = _pendingApply.exchange(0, std::memory_order_acquire)) {
+            if (apply & Subsystem::GodRays) applyGodRays();
+            if (apply & Subsystem::Telemetry) logger::info("Telemetry settings apply at the next game load");
+        }
+        _governorConfig = governorConfig();
+        applyWriteLimits();
+        auto us = static_cast<std::uint32_t>(std::clamp<long long>(frameUs, 0, UINT32_MAX));
+        bool adjusted = _governor.Frame(us, _governorConfig, _stage);
+
+        // The one point per frame where game settings are written
+        _stage.Commit();
+        updateSplitRange();
+        updateCascadeMask(us);
+        updateSharedShadows(us);
+        _telemetry.Record(us, adjusted, _governorConfig, _governor.Last());
+        if (!adjusted) {
+            return;
         }
 
-        // ---- Block level (draw distance tiers) ----
-        if (_config->bAutoAdjust && _config->bBlockEnable &&
-            _fBlockLevel0Distance && _fBlockLevel1Distance && _fBlockLevel2Distance) {
+        // ---- Adjustment ran: stats for the MCM page, periodic log ----
+        const auto& d = _governor.Last();
+        {
+            std::lock_guard lock(_statsLock);
+            _stats = d.stats;
+            _sharedStats = _sharedShadows.Stats();
+        }
 
-            float shadowDist = *offsets::ShadowDistRenderer;
-            if (shadowDist <= _config->fShadowMin && dyn > 0.0f) {
-                _blockIndex = std::clamp(_blockIndex + 1, 0, MaxBlockLevels - 1);
+        _debugCounter++;
+        if (_debugCounter >= 90) {
+            _debugCounter = 0;
+            float curShadow = offsets::ShadowDistRenderer.address() ? *offsets::ShadowDistRenderer : -1.0f;
+            float curLodObj = _fLODFadeOutMultObjects ? _fLODFadeOutMultObjects->GetFloat() : -1.0f;
+            float curGrass = _fGrassStartFadeDistance ? _fGrassStartFadeDistance->GetFloat() : -1.0f;
+            logger::info("SB: auto={} avg={:.2f}ms p50={:.2f} p95={:.2f} p99={:.2f} max={:.2f} ({} frames) "
+                "tgt={:.2f}ms dyn={:.2f} step={:.2f} | "
+                "shadow={:.0f} [{:.0f},{:.0f}] | lod={:.1f} [{:.1f},{:.1f}] | grass={:.0f} [{:.0f},{:.0f}]",
+                _values->bAutoAdjust ? "ON" : "OFF", d.avgMs, d.stats.p50Ms, d.stats.p95Ms, d.stats.p99Ms,
+                d.stats.maxMs, d.stats.frames, d.targetMs, d.errorMs, d.step,
+                curShadow, _values->fShadowMin, _values->fShadowMax,
+                curLodObj, _values->fLodObjectsMin, _values->fLodObjectsMax,
+                curGrass, _values->fGrassMin, _values->fGrassMax);
+            const auto& w = _stage.Counters();
+            logger::info("SB: writes {} of {} staged ({} unchanged, {} rate-limited), block level {} ({} unchanged)",
+                w.written, w.staged, w.unchanged, w.deferred, w.blockWritten, w.blockUnchanged);
+            if (_values->iAllocation == static_cast<std::int32_t>(AllocationType::CostModel)) {
+                logger::info("SB: cost ms shadow={:.2f} lodObj={:.2f} lodItem={:.2f} lodActor={:.2f} grass={:.2f} base={:.2f}",
+                    d.costMs[0], d.costMs[1], d.costMs[2], d.costMs[3], d.costMs[4], _governor.Cost().Bias());
             }
-            if (shadowDist >= _config->fShadowMax && dyn <= 0.0f) {
-                _blockIndex = std::clamp(_blockIndex - 1, 0, MaxBlockLevels - 1);
+            if (_values->bSplitRange) logSplits("SB: cascade split", _splitRange);
+            if (_values->iCascadeSchedule == static_cast<std::int32_t>(CascadePatch::CascadeSchedule::Adaptive)) {
+                const auto& s = _cascades.Stats();
+                logger::info("SB: cascades level {} mean={:.2f}ms cost ms {:.2f}/{:.2f}/{:.2f} | {} drops, {} raises | frames at level {}/{}/{}/{}",
+                    _cascades.Level(), _cascades.LastMeanMs(), _cascades.LevelCost(0), _cascades.LevelCost(1), _cascades.LevelCost(2),
+                    s.drops, s.raises, s.framesAt[0], s.framesAt[1], s.framesAt[2], s.framesAt[3]);
+            }
+            if (_sharedShadows.Attached()) {
+                const auto& s = _sharedShadows.Stats();
+                logger::info("SB: shared shadows {} mean={:.2f}ms saving={:.2f}ms | {} toggles | {:.1f}s shared",
+                    _sharedShadows.IsShared() ? "ON" : "OFF", _sharedShadows.LastMeanMs(), _sharedShadows.SavingMs(),
+                    s.toggles, s.sharedUs / 1e6);
             }
-
-            auto& bl = _config->blockLevels[_blockIndex];
-            _fBlockLevel2Distance->SetFloat(bl.fLevel2);
-            _fBlockLevel1Distance->SetFloat(bl.fLevel1);
-            _fBlockLevel0Distance->SetFloat(bl.fLevel0);
         }
     }
 
@@ -1,16 +1,28 @@
 #pragma once
 
 #include "Config.h"
+#include "cascade_schedule.h"
+#include "cascade_splits.h"
+#include "frame_histogram.h"
+#include "frame_telemetry.h"
+#include "patch_engine.h"
+#include "quality_governor.h"
+#include "settings_stage.h"
+#include "shared_shadows.h"
+#include "sig_scan.h"
 
 // ============================================================================
 // Shadow Boost F4VR - Dynamic FPS-Based Quality Adjustment
 // ============================================================================
 // Ported from Shadow Boost FO4 by PK0 (https://github.com/P-K-0/Shadow-Boost-FO4)
 // Dynamically adjusts shadow distance, LOD, grass, block levels, and god rays
-// based on real-time frame rate to maintain target FPS.
+// based on real-time frame rate to maintain target FPS. The decisions are made
+// by CascadePatch::QualityGovernor; this class is its game settings backend,
+// behind a CascadePatch::SettingsStage that drops writes that change nothing.
 //
 // Cascade expansion (2→4) is handled by the version.dll proxy.
-// This plugin handles shadow distance + all dynamic quality scaling.
+// This plugin handles shadow distance + all dynamic quality scaling, and
+// which cascades render on which frame (CascadePatch::CascadeScheduler).
 // ============================================================================
 
 namespace ShadowBoostF4VR
@@ -18,8 +30,11 @@ namespace ShadowBoostF4VR
     namespace offsets
     {
         // ShadowDist2Cascade - Cascade split range (.data, writable)
-        // Managed by version.dll proxy (reads original, multiplies by 5x for 4 cascades)
-        // We only READ this for logging — never write, to avoid overriding the proxy's value
+        // Set by the version.dll proxy at startup (cascade_splits.h RangeForNearPair).
+        // With [Cascades] bSplitRange we refit it with our fSplitLambda/fSplitNear,
+        // capped at the renderer's shadow distance, on the first frame any of
+        // them differs from what was written; the proxy's value is restored
+        // on the first frame after bSplitRange is turned off
         inline REL::Relocation<float*> ShadowDist2Cascade{ REL::Offset(0x3924808) };
 
         // Shadow system global object base at DAT_1468787f0 (RVA 0x68787f0)
@@ -29,10 +44,11 @@ namespace ShadowBoostF4VR
     }
 
     // ========================================================================
-    // Shared shadow maps: force RIGHT eye to use LEFT shadow maps
-    // Patches FUN_14290d640's VR instanced path: displacement 0x58 → 0x50
-    // at two MOV instructions so both eyes dispatch with the LEFT scene node.
-    // Applied AFTER game load to avoid infinite loading screen.
+    // Shared shadow maps: RIGHT eye uses LEFT shadow maps
+    // FUN_14290d640's VR instanced path: displacement 0x58 → 0x50 at two MOV
+    // instructions so both eyes dispatch with the LEFT scene node. Switched
+    // at runtime by CascadePatch::SharedShadowToggle ([SharedShadows] iMode).
+    // Attached AFTER game load to avoid infinite loading screen.
     // ========================================================================
     namespace SharedShadowFix
     {
@@ -42,13 +58,47 @@ namespace ShadowBoostF4VR
         // Patch displacement byte 0x58 → 0x50 to use LEFT shadow map instead.
         constexpr std::uintptr_t RightActivate_Offset = 0x290d9d0;  // disp8 byte
         constexpr std::uintptr_t RightDispatch_Offset = 0x290d9d9;  // disp8 byte
-        constexpr std::uint8_t OldDisp = 0x58;
-        constexpr std::uint8_t NewDisp = 0x50;
 
-        bool Apply();
+        // Both MOVs with their disp8 accepted as 0x58 (original) or 0x50 (patched).
+        // The offsets above are hints; a changed exe falls back to a .text scan.
+        constexpr const char* DispPattern = "49 8B 4F 58/F7 [5] 49 8B 57 58/F7";
+
+        inline constexpr CascadePatch::SigScan::Signature Sites[] = {
+            CascadePatch::SigScan::Sig("activate disp", DispPattern, RightActivate_Offset, 3),
+            CascadePatch::SigScan::Sig("dispatch disp", DispPattern, RightDispatch_Offset, 12),
+        };
+        static_assert(CascadePatch::SigScan::AllValid(Sites));
+
+        // Addresses of both disp bytes; false if either is missing
+        bool Resolve(std::uintptr_t (&sites)[2]);
     }
 
-    class ShadowBoost
+    // ========================================================================
+    // Cascade mask rotation: which cascades render on which frame
+    // FUN_14284e9e0 picks the frame's mask from a 4-slot rotation set by four
+    // imm8 operands (preloader cascade_patch.h MaskWriterPatch). The preloader
+    // writes 0xF to all four once both cascade arrays are ready; from then on
+    // the plugin rewrites them when CascadeScheduler changes the rotation.
+    // ========================================================================
+    namespace CascadeMaskFix
+    {
+        constexpr std::uintptr_t InitMask_Offset     = 0x284e9fb;  // slot 0
+        constexpr std::uintptr_t FallbackMask_Offset = 0x284ea38;  // slot 2
+        constexpr std::uintptr_t ArrayEntry1_Offset  = 0x284ea4c;  // slot 1
+        constexpr std::uintptr_t ArrayEntry3_Offset  = 0x284ea5f;  // slot 3
+
+        // A lone imm8 cannot be scanned for (the preloader finds them with its
+        // MaskWriter signature). Nothing is written until Read() finds a
+        // rotation the scheduler knows at all four offsets, which a changed
+        // exe would not have.
+        bool Read(CascadePatch::MaskPattern& out);
+
+        // Rewrites the operands that differ, all or none. Applied, or the
+        // status of the write that failed
+        CascadePatch::Patch::Status Apply(const CascadePatch::MaskPattern& from, const CascadePatch::MaskPattern& to);
+    }
+
+    class ShadowBoost : private CascadePatch::SettingsBackend
     {
     public:
         static ShadowBoost& GetSingleton()
@@ -60,6 +110,16 @@ namespace ShadowBoostF4VR
         bool init(Config* config);
         void update(float deltaTime);
         void applyGodRays();
+        void attachSharedShadows();
+
+        // Shared shadow map toggles and time, as of the last adjustment (any thread)
+        CascadePatch::SharedShadowToggle::Counters sharedShadowStats() const;
+
+        // Frame-time percentiles as of the last adjustment (any thread)
+        CascadePatch::FrameTimeStats frameStats() const;
+
+        // Settings reloaded (any thread): Subsystem bits to re-apply on the next frame
+        void requestApply(std::uint32_t subsystems) { _pendingApply.fetch_or(subsystems, std::memory_order_release); }
 
     private:
         ShadowBoost() = default;
@@ -67,8 +127,48 @@ namespace ShadowBoostF4VR
         bool cacheGameSettings();
         void saveOriginalValues();
         void restoreOriginalValues();
+        CascadePatch::GovernorConfig governorConfig() const;
+        void applyWriteLimits();
+        void updateCascadeMask(std::uint32_t frameUs);
+        CascadePatch::SplitScheme splitScheme() const;
+        float splitRange(float shadowDistance);
+        void updateSplitRange();
+        void logSplits(const char* what, float range) const;
+        void updateSharedShadows(std::uint32_t frameUs);
+
+        // One config read for the running init/update/applyGodRays/attachSharedShadows:
+        // points _values at its snapshot and puts back the previous pointer (the
+        // outer scope's, or null) when the guard goes, so a stale _values never outlives it
+        class ValuesScope
+        {
+        public:
+            explicit ValuesScope(ShadowBoost& owner) :
+                _owner(owner), _guard(owner._config->read(owner._configReader)), _previous(owner._values)
+            {
+                _owner._values = _guard.Get();
+            }
+            ~ValuesScope() { _owner._values = _previous; }
+
+            ValuesScope(const ValuesScope&) = delete;
+            ValuesScope& operator=(const ValuesScope&) = delete;
+
+        private:
+            ShadowBoost&                 _owner;
+            Config::Snapshots::ReadGuard _guard;
+            const ConfigValues*          _previous;
+        };
+
+        // SettingsBackend
+        RE::Setting* setting(CascadePatch::Knob knob) const;
+        bool  Has(CascadePatch::Knob knob) const override;
+        float Get(CascadePatch::Knob knob) const override;
+        void  Set(CascadePatch::Knob knob, float value) override;
+        bool  HasBlockLevels() const override;
+        void  SetBlockLevel(int index) override;
 
         Config* _config = nullptr;
+        int     _configReader = -1;                 // our Config::read slot (game main thread)
+        const ConfigValues* _values = nullptr;      // snapshot of the running ValuesScope, null outside one
         bool    _initialized = false;
 
         // Cached game setting pointers (resolved once on init)
@@ -102,10 +202,31 @@ namespace ShadowBoostF4VR
         std::int32_t o_grCascade = 0;
 
         // FPS tracking
-        std::chrono::steady_clock::time_point _lastTime{};
-        float _frameCount = 0.0f;
-        float _targetMs   = 0.0f;
-        int   _blockIndex = 0;
+        std::chrono::steady_clock::time_point _lastFrameTime{};
+        CascadePatch::QualityGovernor _governor;
+        CascadePatch::GovernorConfig  _governorConfig;  // rebuilt from _config every frame
+        CascadePatch::SettingsStage   _stage{ *this };  // governor writes, committed once per frame
+        CascadePatch::FrameTelemetry  _telemetry;       // [Telemetry] bEnable; one record per frame
+        CascadePatch::FrameTimeStats  _stats;           // guarded by _statsLock
+        CascadePatch::SharedShadowToggle::Counters _sharedStats;  // guarded by _statsLock
+        mutable std::mutex            _statsLock;
+        std::atomic<std::uint32_t>    _pendingApply{ 0 };
+
+        // Right eye on the left eye's shadow maps, switched from the frame time
+        CascadePatch::SharedShadowToggle _sharedShadows;
+
+        // Cascade split range: the proxy's, and the last one written
+        float _proxyRange = 0.0f;
+        float _splitRange = 0.0f;
+        float _nearPairEnd = CascadePatch::DefaultTwoCascadeRange;  // the game's 2-cascade range
+        CascadePatch::SplitScheme _fitScheme;                        // [Cascades] scheme _fitRange is for
+        float _fitRange = 0.0f;                                      // its range for the near pair
+
+        // Cascade rotation: the scheduler's pick and what the mask writer holds
+        CascadePatch::CascadeScheduler _cascades;
+        CascadePatch::MaskPattern     _maskPattern{};
+        bool  _maskWritable = true; // false after a failed protect
+        bool  _maskKnown = false;   // _maskPattern read back from the game
         int   _debugCounter = 0;
     };
 
@@ -5,7 +5,6 @@
 #include "ShadowBoost.h"
 #include "Config.h"
 
-#include <thread>
 #include <chrono>
 
 using namespace ShadowBoostF4VR;
@@ -16,7 +15,8 @@ namespace
     Config g_config;
 
     // ========================================================================
-    // MCM VR Settings Reload — watches for PauseMenu close
+    // MCM Stats page — frame-time percentiles written when PauseMenu opens.
+    // Settings changes are picked up by Config::watch, not here.
     // ========================================================================
     class MenuWatcher : public RE::BSTEventSink<RE::MenuOpenCloseEvent>
     {
@@ -31,14 +31,16 @@ namespace
             const RE::MenuOpenCloseEvent& a_event,
             RE::BSTEventSource<RE::MenuOpenCloseEvent>*) override
         {
-            if (!a_event.opening && a_event.menuName == "PauseMenu")
+            if (a_event.opening && a_event.menuName == "PauseMenu")
             {
-                logger::info("Pause menu closed, reloading MCM settings...");
-                std::thread([]() {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(500));
-                    g_config.loadMCMSettings();
-                    logger::info("MCM settings reloaded");
-                }).detach();
+                // Frame-time percentiles for the MCM Stats page, before MCM reads its
+                // settings. Written right here: one small file, once per pause
+                auto stats = ShadowBoost::GetSingleton().frameStats();
+                auto shared = ShadowBoost::GetSingleton().sharedShadowStats();
+                if (stats.frames > 0) {
+                    g_config.saveMCMStats(stats.meanMs, stats.p50Ms, stats.p95Ms, stats.p99Ms, stats.maxMs,
+                        shared.toggles, static_cast<float>(shared.sharedUs / 1e6));
+                }
             }
 
             return RE::BSEventNotifyControl::kContinue;
@@ -61,7 +63,7 @@ namespace
         {
             logger::info("ShadowBoostF4VR loaded");
             g_config.load();
-            g_config.loadMCMSettings();
+            g_config.watch([](std::uint32_t changed) { ShadowBoost::GetSingleton().requestApply(changed); });
         }
 
         void onGameLoaded() override
@@ -77,9 +79,10 @@ namespace
 
             shadowBoost.applyGodRays();
 
-            // Apply shared shadow maps after game load (avoids infinite loading screen
-            // that occurs when applied during early initialization by the proxy)
-            SharedShadowFix::Apply();
+            // Attach shared shadow maps after game load (avoids infinite loading screen
+            // that occurs when patched during early initialization by the proxy);
+            // from here on they switch per frame with [SharedShadows] iMode
+            shadowBoost.attachSharedShadows();
 
             static bool menuWatcherRegistered = false;
             if (!menuWatcherRegistered) {
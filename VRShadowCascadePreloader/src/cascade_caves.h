@@ -0,0 +1,180 @@
+#pragma once
+
+#include "patch_engine.h"
+#include "x64_asm.h"
+#include "x64_decode.h"
+
+// =============================================================================
+// Safety code caves (steps 7-10), assembled at compile time
+// Each cave leaves through X64::Target slots that Code::Link() points back
+// into the game at install time. The reference encodings below are the
+// hand-assembled caves these replaced (external rel32 fields as 00); the
+// static_asserts keep the generated bytes identical to them.
+// =============================================================================
+
+namespace CascadePatch::Caves
+{
+    using namespace X64;
+
+    // ---- Step 7: null safety, FUN_142813740 ----
+    // Site: mov rbp, [r10+0x180]. r10 (param_2) can be NULL and the loaded
+    // pointer can be garbage with bit 63 set; both are forced to rbp = 0.
+    // Targets: 0 = instruction after the site
+    inline constexpr Patch::Bytes NullSafetySite = Patch::Hex("49 8B AA 80 01 00 00");
+
+    inline constexpr auto NullSafety = Assemble<32>([](auto& a) {
+        Label done = a.NewLabel(), nullCase = a.NewLabel();
+        a.Test(r10, r10);
+        a.Jcc(Cond::Z, nullCase);
+        a.Raw(NullSafetySite.data, NullSafetySite.length);
+        a.Test(rbp, rbp);
+        a.Jcc(Cond::Z, done);       // null is handled by the original code
+        a.Jcc(Cond::S, nullCase);   // bit 63 set = invalid pointer
+        a.Bind(done);
+        a.Jmp(Target{ 0 });
+        a.Bind(nullCase);
+        a.Xor(ebp, ebp);
+        a.Jmp(Target{ 0 });
+    });
+
+    // ---- Step 8: node allocator, FUN_14278e610 ----
+    // Site: function prologue, sub rsp, 0x68 + mov r10, r9. Clears ->next
+    // (+0x40) when a node is reused (rdx != NULL), then runs the prologue.
+    // Installed as NodeAllocHead + the prologue as found, relocated by
+    // X64::Relocate, + jmp back; NodeAlloc is that cave for the 1.2.72 bytes.
+    // Targets: 0 = instruction after the prologue
+    inline constexpr Patch::Bytes NodeAllocSite = Patch::Hex("48 83 EC 68 4D 8B D1");
+
+    template <typename A>
+    constexpr void EmitNodeAllocHead(A& a)
+    {
+        Label skipClear = a.NewLabel();
+        a.Test(rdx, rdx);
+        a.Jcc(Cond::Z, skipClear);
+        a.MovQword(Ptr(rdx, 0x40), 0);
+        a.Bind(skipClear);
+    }
+
+    inline constexpr auto NodeAllocHead = Assemble<32>([](auto& a) { EmitNodeAllocHead(a); });
+
+    inline constexpr auto NodeAlloc = Assemble<32>([](auto& a) {
+        EmitNodeAllocHead(a);
+        a.Raw(NodeAllocSite.data, NodeAllocSite.length);
+        a.Jmp(Target{ 0 });
+    });
+
+    // Room for a relocated prologue: at most 5 instructions cover 5 bytes,
+    // each growing by up to 4 when a rel8 branch is widened; the patch
+    // engine writes at most Patch::MaxBytes
+    constexpr size_t NodeAllocCaveSize = NodeAllocHead.size + RelocatedSize(Patch::MaxBytes, 5) + 5;
+
+    // ---- Step 9: cascade entry zero-init, FUN_1427a51e0 ----
+    // Site: mov [rax+r10+0x90], rdx (tag write in the "not found" path).
+    // Zeroes tag entry +0x08..+0x1F (linked list head, flags; +0x00 is the
+    // tag itself) and the returned data entry at +0x130 (4 cascade pointers)
+    // before the original tag write.
+    // Targets: 0 = instruction after the site
+    inline constexpr Patch::Bytes EntryZeroInitSite = Patch::Hex("4A 89 94 10 90 00 00 00");
+
+    inline constexpr auto EntryZeroInit = Assemble<96>([](auto& a) {
+        a.Push(rcx);
+        a.Lea(rcx, Ptr(rax, r10, 1, 0x90));     // tag entry
+        a.MovQword(Ptr(rcx, 0x08), 0);
+        a.MovQword(Ptr(rcx, 0x10), 0);
+        a.MovQword(Ptr(rcx, 0x18), 0);
+        a.Lea(rcx, Ptr(rax, r10, 1, 0x130));    // data entry
+        a.MovQword(Ptr(rcx), 0);
+        a.MovQword(Ptr(rcx, 0x08), 0);
+        a.MovQword(Ptr(rcx, 0x10), 0);
+        a.MovQword(Ptr(rcx, 0x18), 0);
+        a.Pop(rcx);
+        a.Raw(EntryZeroInitSite.data, EntryZeroInitSite.length);
+        a.Jmp(Target{ 0 });
+    });
+
+    // ---- Step 10: cascade pointer validation, FUN_1427a3f90 ----
+    // Site: test r14, r14 + jz near. R14 = cascade pointer, R12 = its slot.
+    // Garbage (bits 47-63 set, or lower 32 bits zero) is cleared in the slot
+    // and R14 zeroed so the original NULL path creates a fresh node.
+    // Targets: 0 = continue (mov edi, [r14+0x48]), 1 = original jz target
+    inline constexpr Patch::Bytes PtrValidationSite = Patch::Hex("4D 85 F6 0F 84 8A 00 00 00");
+
+    enum PtrValidationTarget : uint8_t
+    {
+        PtrValidationContinue,
+        PtrValidationSkip,
+    };
+
+    inline constexpr auto PtrValidation = Assemble<64>([](auto& a) {
+        Label popFix = a.NewLabel(), skip = a.NewLabel();
+        a.Test(r14, r14);
+        a.Jcc(Cond::Z, skip);
+        a.Push(rax);
+        a.Mov(rax, r14);
+        a.Shr(rax, 47);
+        a.Test(eax, eax);
+        a.Jcc(Cond::NZ, popFix);    // high bits set
+        a.Mov(eax, r14d);
+        a.Test(eax, eax);
+        a.Jcc(Cond::Z, popFix);     // real pointers are never 4GB-aligned
+        a.Pop(rax);
+        a.Jmp(Target{ PtrValidationContinue });
+        a.Bind(popFix);
+        a.Pop(rax);
+        a.MovQword(Ptr(r12), 0);    // self-heal the slot
+        a.Xor(r14d, r14d);
+        a.Bind(skip);
+        a.Jmp(Target{ PtrValidationSkip });
+    });
+
+    // ---- Reference encodings ----
+
+    inline constexpr uint8_t NullSafetyReference[] = {
+        0x4D, 0x85, 0xD2, 0x74, 0x13, 0x49, 0x8B, 0xAA, 0x80, 0x01, 0x00, 0x00,
+        0x48, 0x85, 0xED, 0x74, 0x02, 0x78, 0x05, 0xE9, 0x00, 0x00, 0x00, 0x00,
+        0x31, 0xED, 0xE9, 0x00, 0x00, 0x00, 0x00,
+    };
+
+    inline constexpr uint8_t NodeAllocReference[] = {
+        0x48, 0x85, 0xD2, 0x74, 0x08, 0x48, 0xC7, 0x42, 0x40, 0x00, 0x00, 0x00, 0x00,
+        0x48, 0x83, 0xEC, 0x68, 0x4D, 0x8B, 0xD1, 0xE9, 0x00, 0x00, 0x00, 0x00,
+    };
+
+    inline constexpr uint8_t EntryZeroInitReference[] = {
+        0x51,
+        0x4A, 0x8D, 0x8C, 0x10, 0x90, 0x00, 0x00, 0x00,
+        0x48, 0xC7, 0x41, 0x08, 0x00, 0x00, 0x00, 0x00,
+        0x48, 0xC7, 0x41, 0x10, 0x00, 0x00, 0x00, 0x00,
+        0x48, 0xC7, 0x41, 0x18, 0x00, 0x00, 0x00, 0x00,
+        0x4A, 0x8D, 0x8C, 0x10, 0x30, 0x01, 0x00, 0x00,
+        0x48, 0xC7, 0x01, 0x00, 0x00, 0x00, 0x00,
+        0x48, 0xC7, 0x41, 0x08, 0x00, 0x00, 0x00, 0x00,
+        0x48, 0xC7, 0x41, 0x10, 0x00, 0x00, 0x00, 0x00,
+        0x48, 0xC7, 0x41, 0x18, 0x00, 0x00, 0x00, 0x00,
+        0x59,
+        0x4A, 0x89, 0x94, 0x10, 0x90, 0x00, 0x00, 0x00,
+        0xE9, 0x00, 0x00, 0x00, 0x00,
+    };
+
+    inline constexpr uint8_t PtrValidationReference[] = {
+        0x4D, 0x85, 0xF6, 0x74, 0x25, 0x50, 0x4C, 0x89, 0xF0, 0x48, 0xC1, 0xE8, 0x2F,
+        0x85, 0xC0, 0x75, 0x0D, 0x44, 0x89, 0xF0, 0x85, 0xC0, 0x74, 0x06, 0x58,
+        0xE9, 0x00, 0x00, 0x00, 0x00, 0x58, 0x49, 0xC7, 0x04, 0x24, 0x00, 0x00, 0x00, 0x00,
+        0x45, 0x31, 0xF6, 0xE9, 0x00, 0x00, 0x00, 0x00,
+    };
+
+    static_assert(NullSafety.Equals(NullSafetyReference, sizeof(NullSafetyReference)));
+    static_assert(NodeAlloc.Equals(NodeAllocReference, sizeof(NodeAllocReference)));
+    static_assert(EntryZeroInit.Equals(EntryZeroInitReference, sizeof(EntryZeroInitReference)));
+    static_assert(PtrValidation.Equals(PtrValidationReference, sizeof(PtrValidationReference)));
+
+    // Every site is overwritten by a 5-byte JMP plus NOPs; it must be whole
+    // instructions covering at least those 5 bytes
+    constexpr bool WholeInstructions(const Patch::Bytes& site)
+    {
+        return CoverLength(site.data, site.length, 5) == site.length;
+    }
+
+    static_assert(WholeInstructions(NullSafetySite) && WholeInstructions(NodeAllocSite) &&
+                  WholeInstructions(EntryZeroInitSite) && WholeInstructions(PtrValidationSite));
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "flight_recorder.h"
+#include <cstdint>
+
+// =============================================================================
+// Flight recorder event catalog (see flight_recorder.h)
+// The preloader records these ids with raw argument words; the decoder uses
+// the same table to name and print each argument. Ids are part of the file
+// format: append new events, never renumber.
+// =============================================================================
+
+namespace CascadePatch::Events
+{
+    enum Id : uint16_t
+    {
+        PatchBatch = 1,     // one Patch::Batch applied
+        TimerTick,          // expansion timer callback
+        FlatEntry,          // flat cascade entry, first look
+        FlatEntryLate,      // flat cascade entry once all 4 are valid
+        ShaderFields,       // cascade-count fields of a shader object
+        ShadowMap,          // L/R shadow maps of one cascade
+        ShadowMapBinding,   // render function and scene node of one eye
+        VRArrayEntry,       // VR array entry, followed by its HexDump records
+        HexDump,            // 32 bytes of memory
+        DescMapping,        // descriptor array slot vs. the flat shadow maps
+        SceneNodeSet,       // BSShaderManager::SetShadowSceneNode call seen by the detour
+        SnapshotCaptured,   // game memory snapshot written (see game_snapshot.h)
+    };
+
+    // How an argument word is printed
+    enum class Arg : uint8_t
+    {
+        None,
+        Hex,        // 0x...
+        Unsigned,
+        Signed,     // low 32 bits, sign-extended
+        Float,      // low 32 bits are a float (FloatArg)
+        Bytes,      // 8 bytes in memory order
+        Eye,        // 0 = L, 1 = R, anything else = -
+        Bool,
+    };
+
+    struct Field
+    {
+        const char* name;
+        Arg kind;
+    };
+
+    struct Descriptor
+    {
+        uint16_t id;
+        const char* name;
+        const char* category;
+        Field fields[Flight::MaxArgs];
+    };
+
+    inline constexpr Descriptor Catalog[] = {
+        { PatchBatch, "patch_batch", "patch",
+          { { "writes", Arg::Unsigned }, { "pages", Arg::Unsigned }, { "protect_calls", Arg::Unsigned },
+            { "flushes", Arg::Unsigned }, { "us", Arg::Float } } },
+        { TimerTick, "timer_tick", "timer",
+          { { "tick", Arg::Unsigned }, { "steps", Arg::Hex }, { "next_ms", Arg::Unsigned } } },
+        { FlatEntry, "flat_entry", "diag",
+          { { "index", Arg::Unsigned }, { "+0x50", Arg::Hex }, { "+0x58", Arg::Hex }, { "+0xF8", Arg::Hex } } },
+        { FlatEntryLate, "flat_entry_late", "diag",
+          { { "index", Arg::Unsigned }, { "+0x40", Arg::Hex }, { "+0x48", Arg::Hex }, { "+0x102", Arg::Unsigned } } },
+        { ShaderFields, "shader_fields", "diag",
+          { { "shader", Arg::Hex }, { "+0x158", Arg::Unsigned }, { "+0x1D8", Arg::Unsigned },
+            { "+0x168", Arg::Unsigned }, { "+0x16A", Arg::Unsigned } } },
+        { ShadowMap, "shadow_map", "diag",
+          { { "cascade", Arg::Unsigned }, { "left", Arg::Hex }, { "right", Arg::Hex },
+            { "left_eye_flag", Arg::Unsigned }, { "right_eye_flag", Arg::Unsigned } } },
+        { ShadowMapBinding, "shadow_map_binding", "diag",
+          { { "cascade", Arg::Unsigned }, { "eye", Arg::Eye }, { "func_idx", Arg::Signed },
+            { "scene_node", Arg::Hex } } },
+        { VRArrayEntry, "vr_array_entry", "diag",
+          { { "index", Arg::Unsigned }, { "addr", Arg::Hex }, { "non_zero", Arg::Unsigned },
+            { "size", Arg::Unsigned } } },
+        { HexDump, "hex_dump", "diag",
+          { { "addr", Arg::Hex }, { "+00", Arg::Bytes }, { "+08", Arg::Bytes },
+            { "+10", Arg::Bytes }, { "+18", Arg::Bytes } } },
+        { DescMapping, "desc_mapping", "diag",
+          { { "array", Arg::Unsigned }, { "slot", Arg::Unsigned }, { "map", Arg::Hex },
+            { "eye", Arg::Eye }, { "cascade", Arg::Unsigned } } },
+        { SceneNodeSet, "scene_node_set", "hook",
+          { { "index", Arg::Unsigned }, { "node", Arg::Hex }, { "steps", Arg::Hex } } },
+        { SnapshotCaptured, "snapshot", "diag",
+          { { "point", Arg::Unsigned }, { "regions", Arg::Unsigned }, { "skipped", Arg::Unsigned },
+            { "bytes", Arg::Unsigned }, { "us", Arg::Float } } },
+    };
+
+    inline constexpr const Descriptor* Find(uint16_t id)
+    {
+        for (const Descriptor& d : Catalog) {
+            if (d.id == id) return &d;
+        }
+        return nullptr;
+    }
+}
@@ -1,4 +1,20 @@
+#include <Windows.h>
 #include "cascade_patch.h"
+#include "cascade_sites.h"
+#include "cascade_splits.h"
+#include "offset_cache.h"
+#include "cascade_caves.h"
+#include "code_arena.h"
+#include "detour.h"
+#include "game_snapshot.h"
+#include "game_state.h"
+#include "log_ring.h"
+#include "cascade_events.h"
+#include "cascade_patches.h"
+#include "cascade_steps.h"
+#include "proxy_thunks.h"
+#include "region_watch.h"
+#include <bit>
 #include <cstdio>
 #include <cstdarg>
 #include <cstring>
@@ -10,41 +26,83 @@ namespace CascadePatch
     // =========================================================================
     static uintptr_t g_moduleBase = 0;
     static volatile long g_logInitialized = 0;
-    static volatile long g_textDecrypted = 0;  // SteamStub decryption detected
-    static volatile long g_countReadsPatched = 0; // MOV instructions patched to load 4
-    static volatile long g_shaderPatched = 0;  // Shader constructor patched
-    static volatile long g_maskSafe = 0;       // Mask writer patched to 0x3 (safe mode)
-    static volatile long g_vrExpanded = 0;     // VR array expanded to 4
-    static volatile long g_maskRestored = 0;   // Mask writer restored to full rotation
-    static volatile long g_timerStarted = 0;   // Expansion timer created
+    static StepScheduler g_steps;               // staging state, see cascade_steps.h
+    static uint64_t g_stepsStartMs = 0;
     static HANDLE g_timerHandle = nullptr;      // Timer queue timer handle
     static FILE* g_logFile = nullptr;
-    static CRITICAL_SECTION g_logLock;
-    static bool g_logLockReady = false;
+    static LogRing g_logRing;                   // Log() records, drained by the writer thread
+    static HANDLE g_logThread = nullptr;
+    static volatile long g_logOpen = 0;         // g_logFile opened, records may be drained
+    static volatile long g_logStop = 0;
+    static volatile long g_logWriterDone = 0;   // writer left its loop, after its last drain
+    static FlightRecorder g_flight;             // binary diagnostics (see cascade_events.h)
+    static SigScan::Resolution g_sites[Sites::Count];  // resolved patch sites (RVA 0 = not found)
+
+    // Offset cache (see offset_cache.h), loaded in Initialize()
+    static char g_cachePath[MAX_PATH] = {};
+    static OffsetCache::Fingerprint g_fingerprint;
+    static bool g_fingerprintValid = false;
+    static OffsetCache::Status g_cacheStatus = OffsetCache::Status::Missing;
+    static uint32_t g_cachedRVAs[Sites::Count];
 
     // =========================================================================
     // Logging
     // =========================================================================
+    // Log() only formats into g_logRing; a below-normal priority thread
+    // writes batches to disk. FlushLog() is the synchronous flush point, used
+    // after code patches go live and at Shutdown, so a crash right after a
+    // patch still leaves its lines in the log.
+    static constexpr DWORD LogWriterIntervalMs = 20;
+
+    static void EchoToDebugger(const char* text, size_t length)
+    {
+        char line[LogRing::RecordSize + 32];
+        snprintf(line, sizeof(line), "[VRShadowCascade] %.*s\n", (int)length, text);
+        OutputDebugStringA(line);
+    }
+
+    static DWORD WINAPI LogWriterThread(LPVOID /*param*/)
+    {
+        while (!g_logStop) {
+            g_logRing.Drain(g_logFile, EchoToDebugger);
+            Sleep(LogWriterIntervalMs);
+        }
+        InterlockedExchange(&g_logWriterDone, 1);
+        return 0;
+    }
+
+    static void FlushLog()
+    {
+        if (!g_logOpen) return;
+        for (int i = 0; i < 100 && g_logRing.Pending(); i++) {
+            if (!g_logRing.Drain(g_logFile, EchoToDebugger)) Sleep(0);
+        }
+    }
+
     void Log(const char* format, ...)
     {
-        char buffer[1024];
         va_list args;
         va_start(args, format);
-        vsnprintf(buffer, sizeof(buffer), format, args);
+        bool queued = g_logRing.PushV(format, args);
         va_end(args);
 
-        if (g_logLockReady) EnterCriticalSection(&g_logLock);
-
-        OutputDebugStringA("[VRShadowCascade] ");
-        OutputDebugStringA(buffer);
-        OutputDebugStringA("\n");
-
-        if (g_logFile) {
-            fprintf(g_logFile, "%s\n", buffer);
-            fflush(g_logFile);
+        if (!queued) {
+            // Ring full (a diagnostics burst): help drain on this thread rather
+            // than lose lines; before the log is open there is nowhere to drain to
+            char line[LogRing::RecordSize];
+            va_start(args, format);
+            vsnprintf(line, sizeof(line), format, args);
+            va_end(args);
+            for (int i = 0; i < 1000 && g_logOpen && !queued; i++) {
+                if (!g_logRing.Drain(g_logFile, EchoToDebugger)) Sleep(0);
+                queued = g_logRing.Push("%s", line);
+            }
         }
 
-        if (g_logLockReady) LeaveCriticalSection(&g_logLock);
+        // No writer thread: keep the old write-through behavior
+        if (g_logOpen && !g_logThread) {
+            g_logRing.Drain(g_logFile, EchoToDebugger);
+        }
     }
 
     uintptr_t GetModuleBase()
@@ -57,47 +115,68 @@ namespace CascadePatch
 
     bool IsFullyActive()
     {
-        return g_maskRestored != 0;
+        return g_steps.Done(Steps::MaskRestore);
+    }
+
+    bool IsExportSetupDone()
+    {
+        return g_steps.Done(Steps::StartTimer);
+    }
+
+    static uintptr_t SiteRVA(Sites::Id id)
+    {
+        return g_sites[id].rva;
+    }
+
+    // Absolute address of a resolved site, 0 if the site was not found
+    static uintptr_t SiteAddr(Sites::Id id)
+    {
+        uintptr_t rva = g_sites[id].rva;
+        return rva ? GetModuleBase() + rva : 0;
     }
 
     // =========================================================================
     // Code Patching Utility
+    // Patches are queued into a Patch::Batch (see patch_engine.h) and applied
+    // together: one VirtualProtect pair per page, one icache flush per batch.
     // =========================================================================
-    static bool PatchByte(uintptr_t addr, uint8_t expectedVal, uint8_t newVal, const char* desc)
-    {
-        __try {
-            uint8_t* pByte = reinterpret_cast<uint8_t*>(addr);
 
-            if (*pByte != expectedVal) {
-                Log("  SKIP %s: found 0x%02X, expected 0x%02X", desc, *pByte, expectedVal);
-                return false;
-            }
+    // =========================================================================
+    // Code cave arena (see code_arena.h)
+    // Reserved from DllMain, before the game's heaps crowd the module. Caves and
+    // the expanded VR array are carved from it; nothing is ever returned, a
+    // cave that did not go live is rebuilt in place on the next attempt.
+    // =========================================================================
+    static CodeArena g_arena;
 
-            DWORD oldProtect;
-            if (!VirtualProtect(pByte, 1, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-                Log("  FAIL %s: VirtualProtect error %u", desc, GetLastError());
-                return false;
-            }
+    static bool EnsureArena()
+    {
+        if (g_arena.Ready()) return true;
 
-            *pByte = newVal;
-            VirtualProtect(pByte, 1, oldProtect, &oldProtect);
-            FlushInstructionCache(GetCurrentProcess(), pByte, 1);
+        uintptr_t base = GetModuleBase();
+        PE::ImageInfo info;
+        if (!PE::ReadImageInfo(reinterpret_cast<const uint8_t*>(base), SIZE_MAX, info)) return false;
+        return g_arena.Init(base, info.sizeOfImage);
+    }
 
-            Log("  OK   %s: 0x%02X -> 0x%02X", desc, expectedVal, newVal);
-            return true;
-        }
-        __except (EXCEPTION_EXECUTE_HANDLER) {
-            Log("  FAIL %s: exception during patch", desc);
-            return false;
-        }
+    static void* AllocateCave(size_t size)
+    {
+        return EnsureArena() ? g_arena.AllocCode(size) : nullptr;
     }
 
     // =========================================================================
-    // Patch a MOV reg, [RIP+disp32] instruction to MOV reg, imm32
-    // Detects instruction format, verifies displacement, replaces with immediate
+    // Queue a MOV reg, [RIP+disp32] -> MOV reg, imm32 rewrite
+    // Detects instruction format, verifies displacement, builds the immediate form
     // =========================================================================
-    static bool PatchMovRipToImm(uintptr_t instrRVA, uintptr_t globalRVA, uint32_t newValue, const char* desc)
+    static bool QueueMovRipToImm(Patch::Batch& batch, const Patches::Desc& desc)
     {
+        uintptr_t instrRVA = SiteRVA(desc.site);
+        uintptr_t globalRVA = SiteRVA(desc.xref);
+        if (instrRVA == 0 || globalRVA == 0) {
+            Log("  SKIP %s: site not resolved", desc.name);
+            return false;
+        }
+
         uintptr_t base = GetModuleBase();
         uint8_t* ip = reinterpret_cast<uint8_t*>(base + instrRVA);
 
@@ -115,14 +194,14 @@ namespace CascadePatch
 
             // Verify opcode is 0x8B (MOV r32, r/m32)
             if (ip[opcodeIdx] != 0x8B) {
-                Log("  SKIP %s: opcode 0x%02X != 0x8B", desc, ip[opcodeIdx]);
+                Log("  SKIP %s: opcode 0x%02X != 0x8B", desc.name, ip[opcodeIdx]);
                 return false;
             }
 
             // Verify ModRM: mod=00, rm=101 (RIP-relative)
             uint8_t modrm = ip[opcodeIdx + 1];
             if ((modrm & 0xC7) != 0x05) {
-                Log("  SKIP %s: ModRM 0x%02X not RIP-relative", desc, modrm);
+                Log("  SKIP %s: ModRM 0x%02X not RIP-relative", desc.name, modrm);
                 return false;
             }
 
@@ -132,7 +211,7 @@ namespace CascadePatch
             uint32_t actualDisp = *reinterpret_cast<uint32_t*>(ip + opcodeIdx + 2);
 
             if (actualDisp != expectedDisp) {
-                Log("  SKIP %s: disp 0x%08X != expected 0x%08X", desc, actualDisp, expectedDisp);
+                Log("  SKIP %s: disp 0x%08X != expected 0x%08X", desc.name, actualDisp, expectedDisp);
                 return false;
             }
 
@@ -146,11 +225,11 @@ namespace CascadePatch
             if (extReg) {
                 newInstr[0] = 0x41;         // REX.B (for extended registers)
                 newInstr[1] = 0xB8 + reg;   // MOV r32, imm32
-                memcpy(newInstr + 2, &newValue, 4);
+                memcpy(newInstr + 2, &desc.imm, 4);
                 newLen = 6;
             } else {
                 newInstr[0] = 0xB8 + reg;   // MOV r32, imm32
-                memcpy(newInstr + 1, &newValue, 4);
+                memcpy(newInstr + 1, &desc.imm, 4);
                 newLen = 5;
             }
 
@@ -159,190 +238,287 @@ namespace CascadePatch
                 newInstr[i] = 0x90;
             }
 
-            // Apply patch
-            DWORD oldProtect;
-            if (!VirtualProtect(ip, instrLen, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-                Log("  FAIL %s: VirtualProtect error %u", desc, GetLastError());
+            Patch::Write* w = batch.Add(desc.name, reinterpret_cast<uintptr_t>(ip), ip, newInstr, instrLen, desc.group);
+            if (!w) {
+                Log("  FAIL %s: patch batch full", desc.name);
                 return false;
             }
 
-            memcpy(ip, newInstr, instrLen);
-            VirtualProtect(ip, instrLen, oldProtect, &oldProtect);
-            FlushInstructionCache(GetCurrentProcess(), ip, instrLen);
-
             const char* regNames[] = {"eax","ecx","edx","ebx","esp","ebp","esi","edi"};
             const char* extRegNames[] = {"r8d","r9d","r10d","r11d","r12d","r13d","r14d","r15d"};
             const char* regName = extReg ? extRegNames[reg] : regNames[reg];
 
-            Log("  OK   %s: MOV %s, [RIP+0x%X] -> MOV %s, %u (%d->%d bytes)",
-                desc, regName, actualDisp, regName, newValue, instrLen, instrLen);
+            snprintf(w->detail, sizeof(w->detail), "MOV %s, [RIP+0x%X] -> MOV %s, %u (%d->%d bytes)",
+                     regName, actualDisp, regName, desc.imm, instrLen, instrLen);
             return true;
         }
         __except (EXCEPTION_EXECUTE_HANDLER) {
-            Log("  FAIL %s: exception", desc);
+            Log("  FAIL %s: exception", desc.name);
             return false;
         }
     }
 
-    // =========================================================================
-    // Step 1: SteamStub decryption check
-    // =========================================================================
-    static bool CheckTextDecrypted()
+    // Queues every entry of `table` whose group bit is set in `groups`
+    template <size_t N>
+    static void QueuePatches(Patch::Batch& batch, const Patches::Desc (&table)[N], uint32_t groups)
     {
-        if (g_textDecrypted) return true;
+        for (const Patches::Desc& desc : table) {
+            if (!(groups & (1u << desc.group))) continue;
 
-        uintptr_t base = GetModuleBase();
-        __try {
-            uint8_t sentinel = *reinterpret_cast<uint8_t*>(base + TextSentinel);
-            if (sentinel != TextSentinelExpected) {
-                return false;
+            if (desc.kind == Patches::Kind::MovRipToImm) {
+                QueueMovRipToImm(batch, desc);
+                continue;
             }
-        }
-        __except (EXCEPTION_EXECUTE_HANDLER) {
-            return false;
-        }
 
-        InterlockedExchange(&g_textDecrypted, 1);
-        Log("SteamStub decryption detected");
-        return true;
+            uintptr_t addr = SiteAddr(desc.site);
+            if (addr == 0) {
+                Log("  SKIP %s: site not resolved", desc.name);
+                continue;
+            }
+            if (!batch.Add(desc.name, addr, desc.expected, desc.replacement, desc.group)) {
+                Log("  FAIL %s: patch batch full", desc.name);
+            }
+        }
     }
 
-    // =========================================================================
-    // Step 2: Force cascade count global to 4 (continuous, belt-and-suspenders)
-    // =========================================================================
-    static volatile long g_countForced = 0;
+    static void FormatBytes(char* out, size_t outSize, const uint8_t* bytes, size_t length)
+    {
+        size_t n = 0;
+        out[0] = '\0';
+        for (size_t i = 0; i < length && n + 4 < outSize; i++) {
+            n += snprintf(out + n, outSize - n, i ? " %02X" : "%02X", bytes[i]);
+        }
+    }
 
-    static void ForceCascadeCount4()
+    // Applies the batch and logs one line per write in the usual OK/SKIP/FAIL format
+    static void ApplyBatch(Patch::Batch& batch, uint32_t atomicGroups, const char* label)
     {
-        if (g_countForced) return;
-        uintptr_t base = GetModuleBase();
+        if (batch.Size() == 0) return;
+
+        Patch::ApplyStats stats;
         __try {
-            // .data section is already PAGE_READWRITE — no VirtualProtect needed
-            volatile uint32_t* p = reinterpret_cast<volatile uint32_t*>(base + CascadeCountPatch::CountGlobal);
-            if (*p != CascadeCountPatch::DesiredValue) {
-                *p = CascadeCountPatch::DesiredValue;
+            batch.Apply(atomicGroups, &stats);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            Log("  FAIL %s: exception during patch batch", label);
+        }
+
+        for (size_t i = 0; i < batch.Size(); i++) {
+            const Patch::Write& w = batch[i];
+            char expected[3 * Patch::MaxBytes + 1];
+            char found[3 * Patch::MaxBytes + 1];
+            char replacement[3 * Patch::MaxBytes + 1];
+            FormatBytes(expected, sizeof(expected), w.expected, w.length);
+            FormatBytes(found, sizeof(found), w.found, w.length);
+            FormatBytes(replacement, sizeof(replacement), w.replacement, w.length);
+
+            switch (w.status) {
+            case Patch::Status::Applied:
+                if (w.detail[0]) Log("  OK   %s: %s", w.name, w.detail);
+                else if (w.length == 1) Log("  OK   %s: 0x%s -> 0x%s", w.name, expected, replacement);
+                else Log("  OK   %s: %s -> %s", w.name, expected, replacement);
+                break;
+            case Patch::Status::AlreadyApplied:
+                Log("  OK   %s: already patched (%s)", w.name, replacement);
+                break;
+            case Patch::Status::Mismatch:
+                if (w.length == 1) Log("  SKIP %s: found 0x%s, expected 0x%s", w.name, found, expected);
+                else Log("  SKIP %s: found %s, expected %s", w.name, found, expected);
+                break;
+            case Patch::Status::GroupFailed:
+                Log("  SKIP %s: another patch in its group failed", w.name);
+                break;
+            case Patch::Status::ProtectFailed:
+                Log("  FAIL %s: VirtualProtect error %u", w.name, w.error);
+                break;
+            case Patch::Status::Pending:
+                Log("  FAIL %s: not applied", w.name);
+                break;
             }
-            InterlockedExchange(&g_countForced, 1);
         }
-        __except (EXCEPTION_EXECUTE_HANDLER) {}
+
+        Log("%s: %u writes, %u pages, %u protect calls, %u flush in %.1f us",
+            label, stats.writes, stats.pages, stats.protectCalls, stats.flushes, stats.elapsedUs);
+        g_flight.Record(Events::PatchBatch, stats.writes, stats.pages, stats.protectCalls, stats.flushes,
+                        FloatArg(static_cast<float>(stats.elapsedUs)));
+        FlushLog();
     }
 
     // =========================================================================
-    // Step 3: Patch MOV instructions that read DAT_143924818 to load immediate 4
+    // Step 1a: Resolve patch sites (see cascade_sites.h)
+    // Each site is verified at its 1.2.72 RVA first; only sites whose bytes
+    // moved trigger a scan of .text. Unresolved sites stay 0 and their patch SKIPs.
     // =========================================================================
-    static void PatchCountReadSites()
+    static void ResolveSites()
     {
-        if (g_countReadsPatched) return;
-        if (!g_textDecrypted) return;
-
-        Log("Patching cascade count read instructions (4 sites)");
-
-        const char* names[] = {
-            "ctor read (FUN_1427e8f50)",
-            "setup read (FUN_14290dbd0)",
-            "render read 1 (FUN_1428a4a60)",
-            "render read 2 (FUN_1428a4a60)"
-        };
-
-        int n = 0;
-        for (int i = 0; i < 4; i++) {
-            if (PatchMovRipToImm(
-                    CountReadPatch::AllSites[i],
-                    CascadeCountPatch::CountGlobal,
-                    CascadeCountPatch::DesiredValue,
-                    names[i])) {
-                n++;
+        uintptr_t base = GetModuleBase();
+        const uint8_t* image = reinterpret_cast<const uint8_t*>(base);
+
+        PE::ImageInfo info;
+        PE::Section text;
+        if (!PE::ReadImageInfo(image, SIZE_MAX, info) || !PE::FindSection(image, SIZE_MAX, ".text", text)) {
+            // Same behavior as before site resolution: trust the hints, every
+            // patch still verifies its bytes before writing
+            Log("WARN: could not parse PE headers, using 1.2.72 RVAs");
+            for (size_t i = 0; i < Sites::Count; i++) {
+                g_sites[i].rva = Sites::Table[i].hintRVA;
+                g_sites[i].from = SigScan::Source::Hint;
             }
+            return;
         }
 
-        Log("Count read patches: %d/4 applied", n);
+        const bool cacheHit = (g_cacheStatus == OffsetCache::Status::Ok);
+        Log("Offset cache: %s", OffsetCache::StatusName(g_cacheStatus));
 
-        // v11.0.0: Patch the CMP instruction at setup read site
-        // The setup function FUN_14290dbd0 uses CMP [DAT_143924818], 2 to select
-        // between 2-cascade (shorter) and 4-cascade (longer) shadow distances.
-        // Change immediate from 2 to 0 so the comparison always fails → 4-cascade distance.
-        uintptr_t base2 = GetModuleBase();
-        if (PatchByte(base2 + CountReadPatch::SetupCmpImm,
-                      CountReadPatch::SetupCmpOld, CountReadPatch::SetupCmpNew,
-                      "setup CMP imm 2->4 (redirect to .data distance)")) {
-            Log("Setup function will read from .data distance (avoids .rdata VirtualProtect)");
+        SigScan::ScanOptions options;
+        if (cacheHit) options.cachedRVAs = g_cachedRVAs;
+
+        SigScan::ScanStats stats;
+        bool completed = false;
+        __try {
+            SigScan::ResolveAll(image, info.sizeOfImage, text, Sites::Table, Sites::Count, g_sites, options, &stats);
+            completed = true;
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            Log("WARN: exception while resolving patch sites");
         }
 
-        InterlockedExchange(&g_countReadsPatched, 1);
+        int resolved = 0;
+        bool changed = !cacheHit;
+        for (size_t i = 0; i < Sites::Count; i++) {
+            const SigScan::Resolution& r = g_sites[i];
+            if (r.rva) resolved++;
+            if (cacheHit && r.rva != g_cachedRVAs[i]) changed = true;
+            if (r.from == SigScan::Source::Hint) continue;
+            if (r.from == SigScan::Source::Cache && r.rva == Sites::Table[i].hintRVA) continue;
+            if (r.rva == 0 && Sites::Table[i].IsDerived()) continue;  // base site already logged
+            Log("  site %-36s %s RVA 0x%X (1.2.72: 0x%X, %u hits)",
+                Sites::Table[i].name, SigScan::SourceName(r.from),
+                (uint32_t)r.rva, (uint32_t)Sites::Table[i].hintRVA, r.hits);
+        }
+
+        Log("Patch sites: %d/%d resolved (%u cached, %u at hint) in %.2f ms, %u patterns scanned (%s, %u threads)",
+            resolved, (int)Sites::Count, stats.cacheHits, stats.hintHits, stats.elapsedMs, stats.patternsScanned,
+            stats.usedAvx2 ? "AVX2" : "scalar", stats.threads);
+
+        // Decode each site's function from its entry: a site that is not on an
+        // instruction boundary means the pattern matched the wrong place
+        X64::Location where[Sites::FunctionCount];
+        uint32_t misplaced = 0, walked = 0;
+        __try {
+            misplaced = Sites::CheckBoundaries(image, text, g_sites, where);
+            for (size_t i = 0; i < Sites::FunctionCount; i++) {
+                const Sites::SiteFunction& f = Sites::Functions[i];
+                if (!g_sites[f.site].rva) continue;
+                walked += where[i].instructions;
+                if (!where[i].ok) {
+                    Log("WARN: site %s is not on an instruction boundary (entry RVA 0x%X, %u instructions decoded)",
+                        Sites::Table[f.site].name, (uint32_t)Sites::FunctionEntry(f, g_sites[f.site].rva),
+                        where[i].instructions);
+                }
+            }
+            Log("Instruction boundaries: %u misplaced, %u instructions decoded", misplaced, walked);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            Log("WARN: exception while checking instruction boundaries");
+        }
+
+        // Rewrite the cache only when this run learned something new
+        if (completed && changed && g_fingerprintValid && g_cachePath[0]) {
+            if (OffsetCache::Save(g_cachePath, g_fingerprint, g_sites, Sites::Count)) {
+                Log("Offset cache written: %s", g_cachePath);
+            } else {
+                Log("WARN: could not write offset cache %s", g_cachePath);
+            }
+        }
     }
 
     // =========================================================================
-    // Step 4: Apply mask writer safe mode (ALWAYS, immediately after decryption)
-    // Forces all mask writes to 0x3 - prevents crash while arrays aren't ready
+    // Step 1: SteamStub decryption check (probe for ResolveSites)
+    // Every patch step depends on ResolveSites, so none can run against
+    // unresolved sites.
     // =========================================================================
-    static void ApplyMaskSafeMode()
+    static bool ProbeTextDecrypted()
     {
-        if (g_maskSafe) return;
-        if (!g_textDecrypted) return;
-
         uintptr_t base = GetModuleBase();
-        using namespace MaskWriterPatch;
-
-        Log("Applying mask writer safe mode (force mask=0x3)");
-
-        int n = 0;
-        if (PatchByte(base + InitMask_Byte, InitMask_Old, InitMask_New,
-                      "initial mask 0xF->0x3")) n++;
-        if (PatchByte(base + FallbackMask_Byte, FallbackMask_Old, FallbackMask_New,
-                      "fallback mask 0xF->0x3")) n++;
-        if (PatchByte(base + ArrayEntry1_Byte, ArrayEntry1_Old, ArrayEntry1_New,
-                      "array[1] 0x5->0x3")) n++;
-        if (PatchByte(base + ArrayEntry3_Byte, ArrayEntry3_Old, ArrayEntry3_New,
-                      "array[3] 0x9->0x3")) n++;
-
-        Log("Mask writer safe mode: %d/4 patches applied", n);
-        InterlockedExchange(&g_maskSafe, 1);
+        __try {
+            return *reinterpret_cast<uint8_t*>(base + TextSentinel) == TextSentinelExpected;
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            return false;
+        }
+    }
+
+    static bool ResolveSitesStep()
+    {
+        Log("SteamStub decryption detected");
+        ResolveSites();
+        return true;
     }
 
     // =========================================================================
-    // Step 5: Patch shader constructor (2 -> 4 texture layers)
+    // Step 2: Force cascade count global to 4 (continuous, belt-and-suspenders)
     // =========================================================================
-    static void PatchShaderCtor()
+    static bool ForceCascadeCount4()
     {
-        if (g_shaderPatched) return;
-        if (!g_textDecrypted) return;
-
         uintptr_t base = GetModuleBase();
-        using namespace ShaderCtorPatch;
-
-        Log("Patching shader constructor");
-
-        int n = 0;
-        if (PatchByte(base + ArrayCap_Byte, ArrayCap_Old, ArrayCap_New,
-                      "shader array capacity 2->4")) n++;
-        if (PatchByte(base + StoredCount_Byte, StoredCount_Old, StoredCount_New,
-                      "shader stored count 2->4")) n++;
-
-        Log("Shader constructor: %d/2 patches applied", n);
-        InterlockedExchange(&g_shaderPatched, 1);
+        __try {
+            // .data section is already PAGE_READWRITE — no VirtualProtect needed
+            volatile uint32_t* p = reinterpret_cast<volatile uint32_t*>(base + CascadeCountPatch::CountGlobal);
+            if (*p != CascadeCountPatch::DesiredValue) {
+                *p = CascadeCountPatch::DesiredValue;
+            }
+            return true;
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            return false;
+        }
     }
 
     // =========================================================================
-    // Step 5b: Fix stereo shadow dispatch (JZ -> JMP at FUN_14281bd40+0xDC)
-    // RIGHT eye (flag=1) was skipping geometry marked by LEFT eye's deferred path.
-    // LEFT sets bit 53 on geometry it defers; RIGHT checked bit 53 and skipped.
-    // Fix: make RIGHT always dispatch by changing conditional JZ to unconditional JMP.
+    // Steps 3-5b: Startup code patches (see cascade_patches.h), one batch
+    //   3.  Count reads: MOV reg, [DAT_143924818] -> MOV reg, 4
+    //       v11.0.0: setup CMP [DAT_143924818], 2 immediate 2->4, so FUN_14290dbd0
+    //       takes the .data shadow distance instead of the .rdata one
+    //   4.  Mask writer safe mode (force 0x3) - prevents crash while arrays aren't ready
+    //   5.  Shader constructor 2 -> 4 texture layers
+    //   5b. Stereo dispatch JZ -> JMP at FUN_14281bd40+0xDC: RIGHT eye (flag=1) was
+    //       skipping geometry marked by LEFT eye's deferred path (bit 53); make
+    //       RIGHT always dispatch.
+    // A failed stereo fix is left to the StereoDispatch step, which retries it
+    // alone without touching the other sites.
     // =========================================================================
-    static volatile long g_stereoFixPatched = 0;
-
-    static void PatchStereoDispatch()
+    static bool ApplyStartupPatches()
     {
-        if (g_stereoFixPatched) return;
-        if (!g_textDecrypted) return;
+        using namespace Patches;
 
-        uintptr_t base = GetModuleBase();
-        using namespace StereoDispatchFix;
+        uint32_t groups = (1u << CountReads) | (1u << SetupCmp) | (1u << MaskSafe) |
+                          (1u << ShaderCtor) | (1u << StereoDispatch);
+
+        Log("Applying startup patches (count reads, mask safe mode, shader ctor, stereo dispatch)");
+
+        Patch::Batch batch;
+        QueuePatches(batch, Startup, groups);
+        ApplyBatch(batch, 0, "Startup patch batch");
 
-        Log("Patching stereo dispatch (RIGHT eye bit-53 skip)");
-        if (PatchByte(base + JzInstrRVA, JzOpcode, JmpOpcode,
-                      "stereo fix JZ->JMP at FUN_14281bd40+0xDC")) {
-            InterlockedExchange(&g_stereoFixPatched, 1);
+        Log("Count read patches: %d/4 applied", batch.Applied(CountReads));
+        if (batch.Applied(SetupCmp)) {
+            Log("Setup function will read from .data distance (avoids .rdata VirtualProtect)");
+        }
+        Log("Mask writer safe mode: %d/4 patches applied", batch.Applied(MaskSafe));
+        Log("Shader constructor: %d/2 patches applied", batch.Applied(ShaderCtor));
+        if (batch.Applied(StereoDispatch)) {
+            g_steps.MarkDone(Steps::StereoDispatch, GetTickCount64());
         }
+        return true;
+    }
+
+    static bool RetryStereoDispatch()
+    {
+        Patch::Batch batch;
+        QueuePatches(batch, Patches::Startup, 1u << Patches::StereoDispatch);
+        ApplyBatch(batch, 0, "Stereo dispatch retry");
+        return batch.Applied(Patches::StereoDispatch) != 0;
     }
 
     // =========================================================================
@@ -353,10 +529,29 @@ namespace CascadePatch
     // =========================================================================
     static volatile long g_shadowDistPatched = 0;
 
+    // Range for 4 cascades whose near pair covers the game's 2-cascade range
+    // (cascade_splits.h), and the default scheme's model of the layout inside
+    // it for the log (the game splits the range itself)
+    static float CascadeRange(float dist2)
+    {
+        SplitScheme scheme;
+        bool valid = dist2 > 0.0f && dist2 < 1e10f;
+        return RangeForNearPair(scheme, valid ? dist2 : DefaultTwoCascadeRange);
+    }
+
+    static void LogSplits(float range)
+    {
+        SplitScheme scheme;
+        CascadeSplits s = ComputeSplits(scheme, range);
+        for (uint32_t i = 0; i < s.count; i++) {
+            Log("  cascade %u: %.0f - %.0f (modeled, lambda %.2f)", i, s.Start(i), s.End(i), scheme.lambda);
+        }
+    }
+
     static void PatchShadowDistance()
     {
         if (g_shadowDistPatched) return;
-        if (!g_textDecrypted) return;
+        if (!g_steps.Done(Steps::ResolveSites)) return;
 
         uintptr_t base = GetModuleBase();
         __try {
@@ -364,7 +559,7 @@ namespace CascadePatch
             float dist2 = *reinterpret_cast<float*>(base + ShadowDist2Cascade);
 
             if (*pDist4 > 1e30f) {
-                float newDist = (dist2 > 0.0f) ? dist2 * 5.0f : 15000.0f;
+                float newDist = CascadeRange(dist2);
                 DWORD oldProtect;
                 if (VirtualProtect(pDist4, 4, PAGE_READWRITE, &oldProtect)) {
                     *pDist4 = newDist;
@@ -379,143 +574,181 @@ namespace CascadePatch
         __except (EXCEPTION_EXECUTE_HANDLER) {}
     }
 
-    // =========================================================================
-    // Hex dump helper for VR entry diagnostics
-    // =========================================================================
-    static void HexDumpEntry(const char* label, uintptr_t addr, size_t size)
+    // Write desired shadow distance to .data address (no VirtualProtect needed).
+    // The CMP patch makes FUN_14290dbd0 read from ShadowDist2Cascade (.data)
+    // instead of ShadowDist4Cascade (.rdata). We set the .data value to the split
+    // scheme's range for the original (see cascade_splits.h).
+    // Must run AFTER SteamStub decryption — .data values may not be valid before.
+    static bool WriteShadowDistance()
     {
-        Log("=== %s (0x%llX, %zu bytes) ===", label, addr, size);
-        const uint8_t* p = reinterpret_cast<const uint8_t*>(addr);
-        char line[128];
-        for (size_t off = 0; off < size; off += 16) {
-            int n = snprintf(line, sizeof(line), "  +%03X:", (uint32_t)off);
-            for (size_t j = 0; j < 16 && (off + j) < size; j++) {
-                n += snprintf(line + n, sizeof(line) - n, " %02X", p[off + j]);
+        __try {
+            uintptr_t base = GetModuleBase();
+            float* pDist2 = reinterpret_cast<float*>(base + ShadowDist2Cascade);
+            float origDist2 = *pDist2;
+            if (origDist2 > 0.0f && origDist2 < 1e10f) {
+                float desiredDist = CascadeRange(origDist2);
+                *pDist2 = desiredDist;
+                Log("Shadow distance: wrote %.1f to .data (was %.1f, no .rdata VP needed)", desiredDist, origDist2);
+                LogSplits(desiredDist);
+                return true;
             }
-            Log("%s", line);
+            return false;
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            Log("WARN: shadow distance write failed (exception)");
+            return false;
         }
     }
 
     // =========================================================================
-    // Step 6: Expand VR cascade array (2 -> 4 entries)
-    // Uses template copy from entry 0 to properly initialize entries 2-3
+    // Hex dump helper for VR entry diagnostics
+    // Records raw memory into the flight recorder, 32 bytes per event; the
+    // decoder prints it. `size` is rounded up to whole events.
     // =========================================================================
-    static void TryExpandVRArray()
+    static void RecordHexDump(uintptr_t addr, size_t size)
     {
-        if (g_vrExpanded) return;
-
-        uintptr_t base = GetModuleBase();
-        using namespace VRArrayExpansion;
-
-        __try {
-            uintptr_t* pArrayPtr = reinterpret_cast<uintptr_t*>(base + ArrayPtr);
-            uint32_t* pCapacity = reinterpret_cast<uint32_t*>(base + ArrayPtr + 8);
-            uint32_t* pCount = reinterpret_cast<uint32_t*>(base + ArrayCount);
-            uintptr_t buf = *pArrayPtr;
-            uint32_t capacity = *pCapacity;
-            uint32_t count = *pCount;
-
-            if (buf == 0) return;  // VR array not allocated yet
-
-            // Log VR array state once (no hex dump — minimize heap reads during loading)
-            static volatile long s_dumpOnce = 0;
-            if (InterlockedCompareExchange(&s_dumpOnce, 1, 0) == 0) {
-                Log("VR array: ptr=0x%llX, capacity=%u, count=%u", buf, capacity, count);
-            }
+        const uint64_t* p = reinterpret_cast<const uint64_t*>(addr);
+        for (size_t off = 0; off < size; off += 32, p += 4) {
+            g_flight.Record(Events::HexDump, addr + off, p[0], p[1], p[2], p[3]);
+        }
+    }
 
-            if (capacity >= TargetCount) {
-                // Template copy: use entry 0 as template for entries 2 and 3
-                // Entry 0 is fully initialized by the game; entries 2-3 may have
-                // incomplete pool metadata causing render node corruption.
-                uintptr_t templateEntry = buf + 0 * EntrySize;
-                int entriesFixed = 0;
-
-                for (uint32_t i = 2; i < TargetCount; i++) {
-                    uintptr_t dst = buf + i * EntrySize;
-
-                    // Copy full entry from template (entry 0)
-                    memcpy(reinterpret_cast<void*>(dst),
-                           reinterpret_cast<void*>(templateEntry), EntrySize);
-
-                    // Reset per-entry pool self-ref pointers (must point to OWN entry)
-                    for (size_t poolOff : PoolOffsets) {
-                        // Clear pool head (no allocated nodes)
-                        *reinterpret_cast<uintptr_t*>(dst + poolOff) = 0;
-                        // Set tail -> head (empty list marker)
-                        *reinterpret_cast<uintptr_t*>(dst + poolOff + 8) = dst + poolOff;
-                    }
+    // =========================================================================
+    // Game memory snapshots (see game_snapshot.h)
+    // With VRShadowCascade.capture next to the exe, the game objects the fixes
+    // touch are written to VRShadowCascade.<point>.snap at two points: right
+    // before the setup scene node fix, and at the extended diagnostics once
+    // fully active. tools/snapshot_replay runs the fixes against them offline.
+    // =========================================================================
+    enum CapturePoint : uint8_t { CaptureSetup, CaptureActive };
 
-                    // Clear spinlock (thread ID + lock count)
-                    *reinterpret_cast<uint32_t*>(dst + 0x00) = 0;
-                    *reinterpret_cast<uint32_t*>(dst + 0x04) = 0;
+    static bool g_captureSnapshots = false;
+    static volatile long g_snapshotsTaken = 0;     // Bit per CapturePoint
+    static uint8_t g_snapshotBuffer[Snapshot::MaxBytes];
 
-                    entriesFixed++;
-                }
+    // `name` next to Fallout4VR.exe; false if the path does not fit
+    static bool PathNextToExe(char (&out)[MAX_PATH], const char* name)
+    {
+        DWORD len = GetModuleFileNameA(nullptr, out, MAX_PATH);
+        char* lastSlash = strrchr(out, '\\');
+        if (len == 0 || len >= MAX_PATH || !lastSlash || (lastSlash + 1 - out) + strlen(name) >= MAX_PATH) {
+            return false;
+        }
+        strcpy(lastSlash + 1, name);
+        return true;
+    }
 
-                Log("VR array: template-copied entry 0 -> entries 2-%u (%d entries fixed)",
-                    TargetCount - 1, entriesFixed);
+    static bool GuardedRead(void* dst, uintptr_t addr, size_t size, void* /*context*/)
+    {
+        __try {
+            memcpy(dst, reinterpret_cast<const void*>(addr), size);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            return false;
+        }
+        return true;
+    }
 
-                // Also ensure entries 0-1 have valid pool pointers
-                for (uint32_t i = 0; i < 2; i++) {
-                    uintptr_t entryBase = buf + i * EntrySize;
-                    for (size_t poolOff : PoolOffsets) {
-                        uintptr_t* pTail = reinterpret_cast<uintptr_t*>(entryBase + poolOff + 8);
-                        if (*pTail == 0) {
-                            *pTail = entryBase + poolOff;
-                        }
-                    }
-                }
+    // Once per point; the buffer is shared, so the first caller in wins
+    static void CaptureSnapshot(CapturePoint point)
+    {
+        static const char* const labels[] = { "setup", "active" };
+        long bit = 1L << point;
+        if (!g_captureSnapshots || (InterlockedOr(&g_snapshotsTaken, bit) & bit)) return;
+
+        char name[64];
+        char path[MAX_PATH];
+        snprintf(name, sizeof(name), "VRShadowCascade.%s.snap", labels[point]);
+        if (!PathNextToExe(path, name)) return;
+
+        uint64_t start = OS::Ticks();
+        Snapshot::Writer snap;
+        snap.Init(g_snapshotBuffer, sizeof(g_snapshotBuffer), GetModuleBase(), labels[point]);
+        snap.SetSites(g_sites, Sites::Count);
+        snap.SetSteps(g_steps.State());
+        Snapshot::Capture(snap, GuardedRead, nullptr);
+        float us = static_cast<float>((OS::Ticks() - start) * 1e6 / OS::TicksPerSecond());
+        snap.SetCaptureUs(static_cast<uint32_t>(us));
+
+        g_flight.Record(Events::SnapshotCaptured, point, snap.Regions(), snap.Skipped(), snap.Size(), FloatArg(us));
+        if (OS::WriteFileAtomic(path, snap.Data(), snap.Size())) {
+            Log("Snapshot %s: %u regions (%u unreadable), %zu bytes in %.1f us -> %s", labels[point],
+                snap.Regions(), snap.Skipped(), snap.Size(), us, name);
+        } else {
+            Log("WARN: could not write snapshot %s", path);
+        }
+    }
 
-                if (count < TargetCount) {
-                    *pCount = TargetCount;
-                    Log("VR array: set count %u -> %u (capacity already %u)",
-                        count, TargetCount, capacity);
-                } else {
-                    Log("VR array already has %u entries", count);
-                }
-                InterlockedExchange(&g_vrExpanded, 1);
-                return;
-            }
+    // =========================================================================
+    // Step 6: Expand VR cascade array (2 -> 4 entries)
+    // Uses template copy from entry 0 to properly initialize entries 2-3
+    // =========================================================================
+    static void* AllocateVRArray(size_t size)
+    {
+        void* buf = EnsureArena() ? g_arena.AllocData(size) : nullptr;
+        if (!buf) buf = VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
+        return buf;
+    }
 
-            // Capacity < 4: need to actually expand (shouldn't happen with count=4 patches)
-            size_t newSize = TargetCount * EntrySize;
-            void* newBuf = VirtualAlloc(nullptr, newSize,
-                                        MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE);
-            if (!newBuf) {
-                Log("VR array VirtualAlloc failed, error %u", GetLastError());
-                return;
-            }
+    // Step 6b on or off. Off since v13.2.0: it never triggered and added heap
+    // reads during loading. Off, entry 0 is not watched and nothing about the
+    // refresh is logged.
+    static constexpr bool RefreshVREntries = false;
 
-            // Copy ALL existing entries (use capacity, not count)
-            size_t copySize = capacity * EntrySize;
-            memcpy(newBuf, reinterpret_cast<void*>(buf), copySize);
-
-            // Template-copy entry 0 to remaining entries
-            uintptr_t templateSrc = reinterpret_cast<uintptr_t>(newBuf);
-            for (uint32_t i = capacity; i < TargetCount; i++) {
-                uintptr_t dst = reinterpret_cast<uintptr_t>(newBuf) + i * EntrySize;
-                memcpy(reinterpret_cast<void*>(dst),
-                       reinterpret_cast<void*>(templateSrc), EntrySize);
-
-                // Reset per-entry pool self-ref pointers
-                for (size_t poolOff : PoolOffsets) {
-                    *reinterpret_cast<uintptr_t*>(dst + poolOff) = 0;
-                    *reinterpret_cast<uintptr_t*>(dst + poolOff + 8) = dst + poolOff;
-                }
-                // Clear spinlock
-                *reinterpret_cast<uint32_t*>(dst + 0x00) = 0;
-                *reinterpret_cast<uint32_t*>(dst + 0x04) = 0;
-            }
+    // Entry 0 in the region watch, for the refresh step (6b)
+    static RegionWatch g_watch;
+    static int g_vrEntryWatch = -1;
 
-            *pArrayPtr = reinterpret_cast<uintptr_t>(newBuf);
-            *pCount = TargetCount;
+    static void WatchVREntry(uintptr_t buf)
+    {
+        if (!RefreshVREntries || g_vrEntryWatch >= 0 || buf == 0) return;
+        __try {
+            g_vrEntryWatch = g_watch.Add("vr_entry0", buf, VRArrayExpansion::EntrySize, GameState::VREntryDataWords);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            Log("VR entry watch: exception caught");
+        }
+    }
 
-            Log("VR cascade array expanded: cap %u -> 4 entries (template copy)", capacity);
-            Log("  Old buffer: 0x%llX, New buffer: 0x%llX", buf, (uintptr_t)newBuf);
-            InterlockedExchange(&g_vrExpanded, 1);
+    static bool ExpandVRArray()
+    {
+        using namespace VRArrayExpansion;
+        GameState::ExpandResult r;
+        __try {
+            r = GameState::ExpandVRArray(GetModuleBase(), AllocateVRArray);
         }
         __except (EXCEPTION_EXECUTE_HANDLER) {
             Log("VR array expansion: exception caught");
+            return false;
+        }
+        if (r.result == GameState::Expand::NotAllocated) return false;  // VR array not allocated yet
+
+        // Log VR array state once (no hex dump — minimize heap reads during loading)
+        static volatile long s_dumpOnce = 0;
+        if (InterlockedCompareExchange(&s_dumpOnce, 1, 0) == 0) {
+            Log("VR array: ptr=0x%llX, capacity=%u, count=%u", r.before.buf, r.before.capacity, r.before.count);
+        }
+
+        switch (r.result) {
+        case GameState::Expand::InPlace:
+            Log("VR array: template-copied entry 0 -> entries 2-%u (%u entries fixed)",
+                TargetCount - 1, r.entriesFixed);
+            if (r.before.count < TargetCount) {
+                Log("VR array: set count %u -> %u (capacity already %u)",
+                    r.before.count, TargetCount, r.before.capacity);
+            } else {
+                Log("VR array already has %u entries", r.before.count);
+            }
+            WatchVREntry(r.before.buf);
+            return true;
+        case GameState::Expand::Reallocated:
+            Log("VR cascade array expanded: cap %u -> 4 entries (template copy)", r.before.capacity);
+            Log("  Old buffer: 0x%llX, New buffer: 0x%llX", r.before.buf, r.newBuf);
+            WatchVREntry(r.newBuf);
+            return true;
+        default:
+            Log("VR array VirtualAlloc failed, error %u", GetLastError());
+            return false;
         }
     }
 
@@ -529,91 +762,46 @@ namespace CascadePatch
     // re-copy entry 0→2 and entry 1→3 to give far cascades valid RIGHT eye data.
     // The matrices will be for near cascade distances, but at least shadows will
     // be correctly positioned per-eye. The game updates them each frame.
+    // Entry 0 is registered with the region watch when the array is expanded
+    // (WatchVREntry); a call only hashes it, so the rest of the array is not
+    // read until the game has written one of its data words.
+    // Only runs with RefreshVREntries (see StepTimerCallback).
     // =========================================================================
     static volatile long g_vrEntriesRefreshed = 0;
 
     static void RefreshVRArrayEntries()
     {
         if (g_vrEntriesRefreshed) return;
-        if (!g_vrExpanded) return;
-
-        uintptr_t base = GetModuleBase();
-        using namespace VRArrayExpansion;
+        if (!g_steps.Done(Steps::ExpandVRArray)) return;
 
+        GameState::RefreshResult r;
         __try {
-            uintptr_t buf = *reinterpret_cast<uintptr_t*>(base + ArrayPtr);
-            if (buf == 0) return;
-
-            // Check if entry 0 has more non-zero bytes than our template copy had.
-            // Our template copy set: +0x00 (spinlock=1, 4 bytes), +0x18 (ptr, 8 bytes),
-            // and pool tail pointers. Count non-zero bytes in entry 0 vs entry 2.
-            // If entry 0 has MORE non-zero bytes, the game has written additional data.
-            const uint8_t* e0 = reinterpret_cast<const uint8_t*>(buf);
-            const uint8_t* e2 = reinterpret_cast<const uint8_t*>(buf + 2 * EntrySize);
-            int nz0 = 0, nz2 = 0;
-            for (size_t off = 0; off < EntrySize; off++) {
-                if (e0[off] != 0) nz0++;
-                if (e2[off] != 0) nz2++;
-            }
-
-            // If entry 0 doesn't have significantly more data than entry 2 (our copy),
-            // the game hasn't populated it yet
-            if (nz0 <= nz2 + 2) return;
-
-            Log("=== VR array entry refresh (game has populated entries 0-1) ===");
-
-            // Log first 64 bytes of entries 0-3 for comparison
-            for (uint32_t i = 0; i < 4; i++) {
-                uintptr_t entry = buf + i * EntrySize;
-                const uint8_t* p = reinterpret_cast<const uint8_t*>(entry);
-                // Count non-zero bytes to show how populated each entry is
-                int nonZero = 0;
-                for (size_t off = 0; off < EntrySize; off++) {
-                    if (p[off] != 0) nonZero++;
-                }
-                Log("  VR entry[%u]: %d/%zu non-zero bytes", i, nonZero, EntrySize);
+            // Not watched (expansion failed to register it): compare every call
+            if (g_vrEntryWatch >= 0) {
+                g_watch.Poll(1u << g_vrEntryWatch);
+                if (!g_watch.ChangedSinceBase(g_vrEntryWatch)) return;
             }
-
-            // Re-copy populated entry data: entry 0→2, entry 1→3
-            // This gives far cascades the same per-eye rendering parameters as near cascades.
-            // The game's per-frame update will then adjust cascade-specific parameters.
-            for (uint32_t i = 2; i < TargetCount; i++) {
-                uint32_t src = i - 2;  // 0→2, 1→3
-                uintptr_t srcEntry = buf + src * EntrySize;
-                uintptr_t dstEntry = buf + i * EntrySize;
-
-                memcpy(reinterpret_cast<void*>(dstEntry),
-                       reinterpret_cast<void*>(srcEntry), EntrySize);
-
-                // Reset per-entry pool self-ref pointers (must point to OWN entry, not source)
-                for (size_t poolOff : PoolOffsets) {
-                    *reinterpret_cast<uintptr_t*>(dstEntry + poolOff) = 0;
-                    *reinterpret_cast<uintptr_t*>(dstEntry + poolOff + 8) = dstEntry + poolOff;
-                }
-
-                // Clear spinlock
-                *reinterpret_cast<uint32_t*>(dstEntry + 0x00) = 0;
-                *reinterpret_cast<uint32_t*>(dstEntry + 0x04) = 0;
-            }
-
-            Log("VR array: refreshed entries 2-3 from populated entries 0-1");
-
-            // Log result
-            for (uint32_t i = 0; i < 4; i++) {
-                uintptr_t entry = buf + i * EntrySize;
-                const uint8_t* p = reinterpret_cast<const uint8_t*>(entry);
-                int nonZero = 0;
-                for (size_t off = 0; off < EntrySize; off++) {
-                    if (p[off] != 0) nonZero++;
-                }
-                Log("  VR entry[%u] after refresh: %d/%zu non-zero bytes", i, nonZero, EntrySize);
-            }
-
-            InterlockedExchange(&g_vrEntriesRefreshed, 1);
+            r = GameState::RefreshVRArrayEntries(GetModuleBase());
         }
         __except (EXCEPTION_EXECUTE_HANDLER) {
             Log("RefreshVRArrayEntries: exception caught");
+            return;
         }
+        // No data word of entry 0 differs from our template copy: not populated yet
+        if (!r.refreshed) return;
+
+        using VRArrayExpansion::EntrySize;
+        Log("=== VR array entry refresh (game has populated entries 0-1) ===");
+        Log("  VR entry[0]: %d data words differ from the template copy (mask 0x%llX)",
+            std::popcount(r.changedWords), (unsigned long long)r.changedWords);
+        for (uint32_t i = 0; i < 4; i++) {
+            Log("  VR entry[%u]: %u/%zu non-zero bytes", i, r.nonZeroBefore[i], EntrySize);
+        }
+        Log("VR array: refreshed entries 2-3 from populated entries 0-1");
+        for (uint32_t i = 0; i < 4; i++) {
+            Log("  VR entry[%u] after refresh: %u/%zu non-zero bytes", i, r.nonZeroAfter[i], EntrySize);
+        }
+        InterlockedExchange(&g_vrEntriesRefreshed, 1);
     }
 
     // =========================================================================
@@ -626,138 +814,61 @@ namespace CascadePatch
     static volatile long g_nullSafePatched = 0;
     static void* g_codeCave = nullptr;
 
-    static void* AllocateNearby(uintptr_t target, size_t size)
-    {
-        SYSTEM_INFO si;
-        GetSystemInfo(&si);
-        uintptr_t granularity = si.dwAllocationGranularity;
-
-        // Scan outward from target in both directions, stay within ±2GB
-        for (uintptr_t offset = granularity; offset < 0x7F000000; offset += granularity) {
-            // Try above
-            void* p = VirtualAlloc(reinterpret_cast<void*>(target + offset),
-                                   size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-            if (p) return p;
-
-            // Try below
-            if (target > offset) {
-                p = VirtualAlloc(reinterpret_cast<void*>(target - offset),
-                                 size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
-                if (p) return p;
-            }
-        }
-        return nullptr;
-    }
-
-    static void PatchNullSafetyCheck()
+    static Patch::Write* QueueNullSafetyCheck(Patch::Batch& batch)
     {
-        if (g_nullSafePatched) return;
-        if (!g_textDecrypted) return;
-
-        uintptr_t base = GetModuleBase();
         using namespace NullSafetyPatch;
 
-        const uint8_t expectedBytes[] = { 0x49, 0x8B, 0xAA, 0x80, 0x01, 0x00, 0x00 };
-        uint8_t* crashAddr = reinterpret_cast<uint8_t*>(base + CrashInstrRVA);
+        const uint8_t* expectedBytes = Caves::NullSafetySite.data;
+        static_assert(Caves::NullSafetySite.length == InstrSize);
+        if (!SiteRVA(Sites::NullSafetyCrash)) {
+            Log("SKIP null safety: site not resolved");
+            return nullptr;
+        }
+        uint32_t crashRVA = (uint32_t)SiteRVA(Sites::NullSafetyCrash);
+        uint8_t* crashAddr = reinterpret_cast<uint8_t*>(SiteAddr(Sites::NullSafetyCrash));
         uintptr_t returnAddr = reinterpret_cast<uintptr_t>(crashAddr) + InstrSize;
 
         __try {
             // Verify instruction bytes
             if (memcmp(crashAddr, expectedBytes, InstrSize) != 0) {
-                Log("SKIP null safety: bytes mismatch at RVA 0x%X", (uint32_t)CrashInstrRVA);
+                Log("SKIP null safety: bytes mismatch at RVA 0x%X", crashRVA);
                 Log("  Expected: 49 8B AA 80 01 00 00");
                 Log("  Found:    %02X %02X %02X %02X %02X %02X %02X",
                     crashAddr[0], crashAddr[1], crashAddr[2], crashAddr[3],
                     crashAddr[4], crashAddr[5], crashAddr[6]);
-                return;
+                return nullptr;
             }
 
-            // Allocate code cave within ±2GB of crash site (required for jmp rel32)
-            g_codeCave = AllocateNearby(reinterpret_cast<uintptr_t>(crashAddr), 64);
+            // Code cave from the arena, within ±2GB of the module (required for jmp rel32)
+            if (!g_codeCave) g_codeCave = AllocateCave(Caves::NullSafety.size);
             if (!g_codeCave) {
                 Log("FAIL null safety: could not allocate code cave near 0x%llX",
                     (uintptr_t)crashAddr);
-                return;
+                return nullptr;
             }
 
+            // Code cave: null check + pointer validation (Caves::NullSafety)
             uint8_t* cave = reinterpret_cast<uint8_t*>(g_codeCave);
-            int pos = 0;
-
-            // Code cave with null check AND pointer validation:
-            //   [0]  test r10, r10          ; 3 bytes - null check param_2
-            //   [3]  jz null_case           ; 2 bytes
-            //   [5]  mov rbp, [r10+0x180]   ; 7 bytes - load sub-object pointer
-            //   [12] test rbp, rbp          ; 3 bytes - null/sign check
-            //   [15] jz done               ; 2 bytes - null is OK, original handles
-            //   [17] js null_case           ; 2 bytes - bit 63 set = invalid ptr
-            //   [19] done: jmp return_addr  ; 5 bytes
-            //   [24] null_case: xor ebp,ebp ; 2 bytes - force null
-            //   [26] jmp return_addr        ; 5 bytes
-
-            // [0] test r10, r10
-            cave[pos++] = 0x4D; cave[pos++] = 0x85; cave[pos++] = 0xD2;
-
-            // [3] jz null_case (target at offset 24, rel8 = 24-5 = 19 = 0x13)
-            cave[pos++] = 0x74; cave[pos++] = 0x13;
-
-            // [5] mov rbp, [r10+0x180] (original instruction)
-            memcpy(cave + pos, expectedBytes, InstrSize);
-            pos += (int)InstrSize;
-
-            // [12] test rbp, rbp
-            cave[pos++] = 0x48; cave[pos++] = 0x85; cave[pos++] = 0xED;
-
-            // [15] jz done (target at offset 19, rel8 = 19-17 = 2)
-            cave[pos++] = 0x74; cave[pos++] = 0x02;
-
-            // [17] js null_case (target at offset 24, rel8 = 24-19 = 5)
-            cave[pos++] = 0x78; cave[pos++] = 0x05;
-
-            // [19] done: jmp return_addr
-            cave[pos++] = 0xE9;
-            int32_t rel1 = static_cast<int32_t>(
-                (intptr_t)returnAddr - (intptr_t)(reinterpret_cast<uintptr_t>(cave + pos) + 4));
-            memcpy(cave + pos, &rel1, 4);
-            pos += 4;
-
-            // [24] null_case: xor ebp, ebp
-            cave[pos++] = 0x31; cave[pos++] = 0xED;
-
-            // [26] jmp return_addr
-            cave[pos++] = 0xE9;
-            int32_t rel2 = static_cast<int32_t>(
-                (intptr_t)returnAddr - (intptr_t)(reinterpret_cast<uintptr_t>(cave + pos) + 4));
-            memcpy(cave + pos, &rel2, 4);
-            pos += 4;
-
-            // Patch original: jmp code_cave (5 bytes) + 2 NOPs
-            uint8_t patch[7];
-            patch[0] = 0xE9;
-            int32_t jmpRel = static_cast<int32_t>(
-                (intptr_t)reinterpret_cast<uintptr_t>(cave) -
-                (intptr_t)(reinterpret_cast<uintptr_t>(crashAddr) + 5));
-            memcpy(patch + 1, &jmpRel, 4);
-            patch[5] = 0x90;
-            patch[6] = 0x90;
-
-            DWORD oldProtect;
-            if (!VirtualProtect(crashAddr, InstrSize, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-                Log("FAIL null safety: VirtualProtect error %u", GetLastError());
-                VirtualFree(g_codeCave, 0, MEM_RELEASE);
-                g_codeCave = nullptr;
-                return;
+            const uintptr_t targets[] = { returnAddr };
+            uint8_t patch[InstrSize];
+            if (!Caves::NullSafety.Link(cave, targets, 1) ||
+                !X64::EncodeJmp(patch, InstrSize, reinterpret_cast<uintptr_t>(crashAddr),
+                                reinterpret_cast<uintptr_t>(cave))) {
+                Log("FAIL null safety: code cave out of rel32 range");
+                return nullptr;
             }
 
-            memcpy(crashAddr, patch, InstrSize);
-            VirtualProtect(crashAddr, InstrSize, oldProtect, &oldProtect);
-            FlushInstructionCache(GetCurrentProcess(), crashAddr, InstrSize);
-
-            Log("Null safety patch applied at RVA 0x%X -> code cave 0x%llX",
-                (uint32_t)CrashInstrRVA, (uintptr_t)g_codeCave);
-            InterlockedExchange(&g_nullSafePatched, 1);
+            Patch::Write* w = batch.Add("null safety JMP", reinterpret_cast<uintptr_t>(crashAddr),
+                                        expectedBytes, patch, InstrSize, Patches::SafetyCaves);
+            if (w) {
+                snprintf(w->detail, sizeof(w->detail), "RVA 0x%X -> code cave 0x%llX",
+                         crashRVA, (uintptr_t)g_codeCave);
+            }
+            return w;
         }
         __except (EXCEPTION_EXECUTE_HANDLER) {
             Log("FAIL null safety: exception during patch");
+            return nullptr;
         }
     }
 
@@ -770,13 +881,24 @@ namespace CascadePatch
     static volatile long g_nodeAllocPatched = 0;
     static void* g_nodeAllocCave = nullptr;
 
-    static void PatchNodeAllocator()
+    static Patch::Write* QueueNodeAllocator(Patch::Batch& batch)
     {
-        if (g_nodeAllocPatched) return;
-        if (!g_textDecrypted) return;
-
-        uintptr_t base = GetModuleBase();
-        uint8_t* funcAddr = reinterpret_cast<uint8_t*>(base + NodeAllocPatch::FuncRVA);
+        uint8_t* funcAddr = nullptr;
+        bool fallback = false;
+        if (SiteRVA(Sites::NodeAllocFunc)) {
+            funcAddr = reinterpret_cast<uint8_t*>(SiteAddr(Sites::NodeAllocFunc));
+        } else if (SiteRVA(Sites::NullSafetyCrash) == NullSafetyPatch::CrashInstrRVA) {
+            // The prologue pattern did not match, but the neighbouring site is at
+            // its 1.2.72 RVA: the entry may still be there, hooked by another
+            // module. Only the original prologue or a leading jump is accepted.
+            funcAddr = reinterpret_cast<uint8_t*>(GetModuleBase() + NodeAllocPatch::FuncRVA);
+            fallback = true;
+            Log("Node alloc prologue not matched, using 1.2.72 entry RVA 0x%X",
+                (uint32_t)NodeAllocPatch::FuncRVA);
+        } else {
+            Log("SKIP node alloc patch: site not resolved");
+            return nullptr;
+        }
 
         __try {
             // Log the first 16 bytes for diagnostics
@@ -787,88 +909,66 @@ namespace CascadePatch
                 funcAddr[8], funcAddr[9], funcAddr[10], funcAddr[11],
                 funcAddr[12], funcAddr[13], funcAddr[14], funcAddr[15]);
 
-            // Actual prologue: sub rsp, 0x68 (48 83 EC 68) + mov r10, r9 (4D 8B D1)
-            // = 7 bytes total, two complete instructions we can safely relocate
-            const uint8_t expectedPrologue[] = { 0x48, 0x83, 0xEC, 0x68, 0x4D, 0x8B, 0xD1 };
-            constexpr size_t prologueSize = 7;
-
-            if (memcmp(funcAddr, expectedPrologue, prologueSize) != 0) {
-                Log("SKIP node alloc patch: prologue mismatch");
-                return;
+            // Whole instructions covering the 5-byte JMP. On 1.2.72 this is
+            // sub rsp, 0x68 (48 83 EC 68) + mov r10, r9 (4D 8B D1)
+            uint8_t prologue[Patch::MaxBytes];
+            memcpy(prologue, funcAddr, sizeof(prologue));
+            size_t prologueSize = X64::CoverLength(prologue, sizeof(prologue), 5);
+            if (!prologueSize) {
+                Log("SKIP node alloc patch: prologue does not decode to whole instructions");
+                return nullptr;
             }
+            bool canonical = prologueSize == Caves::NodeAllocSite.length &&
+                             memcmp(prologue, Caves::NodeAllocSite.data, prologueSize) == 0;
+            if (fallback && !canonical) {
+                // Another module's hook: jmp rel32 or jmp [rip+disp32] at the entry
+                bool hooked = (prologue[0] == 0xE9 && prologueSize == 5) ||
+                              (prologue[0] == 0xFF && prologue[1] == 0x25 && prologueSize == 6);
+                if (!hooked) {
+                    Log("SKIP node alloc patch: bytes at the 1.2.72 entry are neither its prologue nor a hook");
+                    return nullptr;
+                }
+            }
+            if (!canonical) Log("Node alloc prologue differs, relocating %zu bytes", prologueSize);
 
             uintptr_t returnAddr = reinterpret_cast<uintptr_t>(funcAddr + prologueSize);
 
-            // Allocate code cave near function
-            g_nodeAllocCave = AllocateNearby(reinterpret_cast<uintptr_t>(funcAddr), 64);
+            // Code cave from the arena, near the module
+            if (!g_nodeAllocCave) g_nodeAllocCave = AllocateCave(Caves::NodeAllocCaveSize);
             if (!g_nodeAllocCave) {
                 Log("FAIL node alloc patch: could not allocate code cave");
-                return;
+                return nullptr;
             }
 
+            // Code cave: clear +0x40 if rdx non-null, then the relocated prologue
+            // and a jump back (Caves::NodeAllocHead)
             uint8_t* cave = reinterpret_cast<uint8_t*>(g_nodeAllocCave);
-            int pos = 0;
-
-            // Code cave: clear +0x40 if rdx non-null, then execute relocated prologue
-            //   [0]  test rdx, rdx           ; 3 bytes - null check param_2
-            //   [3]  jz skip_clear           ; 2 bytes
-            //   [5]  mov qword [rdx+0x40], 0 ; 8 bytes - CLEAR ->next pointer
-            //   [13] skip_clear:
-            //   [13] sub rsp, 0x68           ; 4 bytes (original)
-            //   [17] mov r10, r9             ; 3 bytes (original)
-            //   [20] jmp returnAddr          ; 5 bytes
-
-            // [0] test rdx, rdx
-            cave[pos++] = 0x48; cave[pos++] = 0x85; cave[pos++] = 0xD2;
-
-            // [3] jz skip_clear (target at offset 13, rel8 = 13-5 = 8)
-            cave[pos++] = 0x74; cave[pos++] = 0x08;
-
-            // [5] mov qword ptr [rdx+0x40], 0
-            cave[pos++] = 0x48; cave[pos++] = 0xC7; cave[pos++] = 0x42; cave[pos++] = 0x40;
-            cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [13] sub rsp, 0x68 (relocated original)
-            cave[pos++] = 0x48; cave[pos++] = 0x83; cave[pos++] = 0xEC; cave[pos++] = 0x68;
-
-            // [17] mov r10, r9 (relocated original)
-            cave[pos++] = 0x4D; cave[pos++] = 0x8B; cave[pos++] = 0xD1;
-
-            // [20] jmp returnAddr (funcAddr + 7)
-            cave[pos++] = 0xE9;
-            int32_t rel1 = static_cast<int32_t>(
-                (intptr_t)returnAddr - (intptr_t)(reinterpret_cast<uintptr_t>(cave + pos) + 4));
-            memcpy(cave + pos, &rel1, 4);
-            pos += 4;
-
-            // Patch original function: replace first 7 bytes with jmp cave + 2 NOPs
-            uint8_t patch[7];
-            patch[0] = 0xE9;
-            int32_t jmpRel = static_cast<int32_t>(
-                (intptr_t)reinterpret_cast<uintptr_t>(cave) -
-                (intptr_t)(reinterpret_cast<uintptr_t>(funcAddr) + 5));
-            memcpy(patch + 1, &jmpRel, 4);
-            patch[5] = 0x90;
-            patch[6] = 0x90;
-
-            DWORD oldProtect;
-            if (!VirtualProtect(funcAddr, prologueSize, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-                Log("FAIL node alloc patch: VirtualProtect error %u", GetLastError());
-                VirtualFree(g_nodeAllocCave, 0, MEM_RELEASE);
-                g_nodeAllocCave = nullptr;
-                return;
+            memcpy(cave, Caves::NodeAllocHead.bytes, Caves::NodeAllocHead.size);
+            uint8_t* moved = cave + Caves::NodeAllocHead.size;
+            size_t movedSize = X64::Relocate(prologue, prologueSize, reinterpret_cast<uintptr_t>(funcAddr),
+                                             moved, Caves::NodeAllocCaveSize - Caves::NodeAllocHead.size - 5,
+                                             reinterpret_cast<uintptr_t>(moved));
+            uint8_t* back = moved + movedSize;
+            uint8_t patch[Patch::MaxBytes];
+            if (!movedSize ||
+                !X64::EncodeJmp(back, 5, reinterpret_cast<uintptr_t>(back), returnAddr) ||
+                !X64::EncodeJmp(patch, prologueSize, reinterpret_cast<uintptr_t>(funcAddr),
+                                reinterpret_cast<uintptr_t>(cave))) {
+                Log("FAIL node alloc patch: prologue cannot be relocated to the cave");
+                return nullptr;
             }
 
-            memcpy(funcAddr, patch, prologueSize);
-            VirtualProtect(funcAddr, prologueSize, oldProtect, &oldProtect);
-            FlushInstructionCache(GetCurrentProcess(), funcAddr, prologueSize);
-
-            Log("Node alloc patch applied: +0x40 clear on reuse (cave 0x%llX)",
-                (uintptr_t)g_nodeAllocCave);
-            InterlockedExchange(&g_nodeAllocPatched, 1);
+            Patch::Write* w = batch.Add("node alloc JMP", reinterpret_cast<uintptr_t>(funcAddr),
+                                        prologue, patch, prologueSize, Patches::SafetyCaves);
+            if (w) {
+                snprintf(w->detail, sizeof(w->detail), "+0x40 clear on reuse (cave 0x%llX)",
+                         (uintptr_t)g_nodeAllocCave);
+            }
+            return w;
         }
         __except (EXCEPTION_EXECUTE_HANDLER) {
             Log("FAIL node alloc patch: exception");
+            return nullptr;
         }
     }
 
@@ -884,144 +984,61 @@ namespace CascadePatch
     static volatile long g_entryZeroInitPatched = 0;
     static void* g_entryZeroInitCave = nullptr;
 
-    static void PatchCascadeEntryZeroInit()
+    static Patch::Write* QueueCascadeEntryZeroInit(Patch::Batch& batch)
     {
-        if (g_entryZeroInitPatched) return;
-        if (!g_textDecrypted) return;
-
-        uintptr_t base = GetModuleBase();
         using namespace CascadeEntryZeroInit;
 
-        uint8_t* patchAddr = reinterpret_cast<uint8_t*>(base + TagWriteRVA);
-        uintptr_t returnAddr = base + ReturnRVA;
+        if (!SiteRVA(Sites::EntryZeroInitTagWrite)) {
+            Log("SKIP entry zero-init: site not resolved");
+            return nullptr;
+        }
+        uint32_t tagWriteRVA = (uint32_t)SiteRVA(Sites::EntryZeroInitTagWrite);
+        uint8_t* patchAddr = reinterpret_cast<uint8_t*>(SiteAddr(Sites::EntryZeroInitTagWrite));
+        uintptr_t returnAddr = SiteAddr(Sites::EntryZeroInitReturn);
 
         // Expected bytes: 4A 89 94 10 90 00 00 00 (mov [rax+r10+0x90], rdx)
-        const uint8_t expectedBytes[] = { 0x4A, 0x89, 0x94, 0x10, 0x90, 0x00, 0x00, 0x00 };
+        const uint8_t* expectedBytes = Caves::EntryZeroInitSite.data;
+        static_assert(Caves::EntryZeroInitSite.length == InstrSize);
 
         __try {
             if (memcmp(patchAddr, expectedBytes, InstrSize) != 0) {
-                Log("SKIP entry zero-init: bytes mismatch at RVA 0x%X", (uint32_t)TagWriteRVA);
+                Log("SKIP entry zero-init: bytes mismatch at RVA 0x%X", tagWriteRVA);
                 Log("  Expected: 4A 89 94 10 90 00 00 00");
                 Log("  Found:    %02X %02X %02X %02X %02X %02X %02X %02X",
                     patchAddr[0], patchAddr[1], patchAddr[2], patchAddr[3],
                     patchAddr[4], patchAddr[5], patchAddr[6], patchAddr[7]);
-                return;
+                return nullptr;
             }
 
-            g_entryZeroInitCave = AllocateNearby(reinterpret_cast<uintptr_t>(patchAddr), 128);
+            if (!g_entryZeroInitCave) g_entryZeroInitCave = AllocateCave(Caves::EntryZeroInit.size);
             if (!g_entryZeroInitCave) {
                 Log("FAIL entry zero-init: could not allocate code cave");
-                return;
+                return nullptr;
             }
 
+            // Code cave: zero tag entry +0x08..+0x1F and the data entry's four
+            // cascade pointers, then the relocated tag write (Caves::EntryZeroInit)
             uint8_t* cave = reinterpret_cast<uint8_t*>(g_entryZeroInitCave);
-            int pos = 0;
-
-            // Code cave layout:
-            // At entry: rax = slot*32, r10 = BSLightingShaderProperty, rdx = shadow_tag
-            // Tag entry = r10 + rax + 0x90  (tag at +0x00, linked list head at +0x08)
-            // Data entry = r10 + rax + 0x130 (4 cascade pointers)
-            //
-            // We zero tag entry fields +0x08..+0x1F (skip +0x00, overwritten by tag write)
-            // and data entry fields +0x00..+0x1F (all 4 cascade pointers).
-            //
-            //   [0]  push rcx                          ; 1
-            //   [1]  lea rcx, [rax+r10+0x90]           ; 8  - tag entry base
-            //   [9]  mov qword [rcx+0x08], 0           ; 8  - zero linked list head
-            //   [17] mov qword [rcx+0x10], 0           ; 8  - zero tag field 2
-            //   [25] mov qword [rcx+0x18], 0           ; 8  - zero tag field 3
-            //   [33] lea rcx, [rax+r10+0x130]          ; 8  - data entry base
-            //   [41] mov qword [rcx], 0                ; 7  - zero cascade ptr 0
-            //   [48] mov qword [rcx+0x08], 0           ; 8  - zero cascade ptr 1
-            //   [56] mov qword [rcx+0x10], 0           ; 8  - zero cascade ptr 2
-            //   [64] mov qword [rcx+0x18], 0           ; 8  - zero cascade ptr 3
-            //   [72] pop rcx                           ; 1
-            //   [73] mov [rax+r10+0x90], rdx           ; 8  - original tag write
-            //   [81] jmp returnAddr                    ; 5
-            //   Total: 86 bytes
-
-            // [0] push rcx
-            cave[pos++] = 0x51;
-
-            // [1] lea rcx, [rax + r10 + 0x90]
-            // Encoding: 4A 8D 8C 10 90 00 00 00
-            cave[pos++] = 0x4A; cave[pos++] = 0x8D; cave[pos++] = 0x8C; cave[pos++] = 0x10;
-            cave[pos++] = 0x90; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [9] mov qword [rcx+0x08], 0 — zero linked list head (crash field!)
-            cave[pos++] = 0x48; cave[pos++] = 0xC7; cave[pos++] = 0x41; cave[pos++] = 0x08;
-            cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [17] mov qword [rcx+0x10], 0
-            cave[pos++] = 0x48; cave[pos++] = 0xC7; cave[pos++] = 0x41; cave[pos++] = 0x10;
-            cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [25] mov qword [rcx+0x18], 0
-            cave[pos++] = 0x48; cave[pos++] = 0xC7; cave[pos++] = 0x41; cave[pos++] = 0x18;
-            cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [33] lea rcx, [rax + r10 + 0x130]
-            // Encoding: 4A 8D 8C 10 30 01 00 00
-            cave[pos++] = 0x4A; cave[pos++] = 0x8D; cave[pos++] = 0x8C; cave[pos++] = 0x10;
-            cave[pos++] = 0x30; cave[pos++] = 0x01; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [41] mov qword [rcx], 0
-            cave[pos++] = 0x48; cave[pos++] = 0xC7; cave[pos++] = 0x01;
-            cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [48] mov qword [rcx+0x08], 0
-            cave[pos++] = 0x48; cave[pos++] = 0xC7; cave[pos++] = 0x41; cave[pos++] = 0x08;
-            cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [56] mov qword [rcx+0x10], 0
-            cave[pos++] = 0x48; cave[pos++] = 0xC7; cave[pos++] = 0x41; cave[pos++] = 0x10;
-            cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [64] mov qword [rcx+0x18], 0
-            cave[pos++] = 0x48; cave[pos++] = 0xC7; cave[pos++] = 0x41; cave[pos++] = 0x18;
-            cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [72] pop rcx
-            cave[pos++] = 0x59;
-
-            // [73] mov [rax+r10+0x90], rdx (original instruction, relocated)
-            memcpy(cave + pos, expectedBytes, InstrSize);
-            pos += (int)InstrSize;
-
-            // [81] jmp returnAddr
-            cave[pos++] = 0xE9;
-            int32_t relReturn = static_cast<int32_t>(
-                (intptr_t)returnAddr - (intptr_t)(reinterpret_cast<uintptr_t>(cave + pos) + 4));
-            memcpy(cave + pos, &relReturn, 4);
-            pos += 4;
-
-            // Patch original: jmp code_cave (5 bytes) + 3 NOPs
-            uint8_t patch[8];
-            patch[0] = 0xE9;
-            int32_t jmpRel = static_cast<int32_t>(
-                (intptr_t)reinterpret_cast<uintptr_t>(cave) -
-                (intptr_t)(reinterpret_cast<uintptr_t>(patchAddr) + 5));
-            memcpy(patch + 1, &jmpRel, 4);
-            patch[5] = 0x90; patch[6] = 0x90; patch[7] = 0x90;
-
-            DWORD oldProtect;
-            if (!VirtualProtect(patchAddr, InstrSize, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-                Log("FAIL entry zero-init: VirtualProtect error %u", GetLastError());
-                VirtualFree(g_entryZeroInitCave, 0, MEM_RELEASE);
-                g_entryZeroInitCave = nullptr;
-                return;
+            const uintptr_t targets[] = { returnAddr };
+            uint8_t patch[InstrSize];
+            if (!Caves::EntryZeroInit.Link(cave, targets, 1) ||
+                !X64::EncodeJmp(patch, InstrSize, reinterpret_cast<uintptr_t>(patchAddr),
+                                reinterpret_cast<uintptr_t>(cave))) {
+                Log("FAIL entry zero-init: code cave out of rel32 range");
+                return nullptr;
             }
 
-            memcpy(patchAddr, patch, InstrSize);
-            VirtualProtect(patchAddr, InstrSize, oldProtect, &oldProtect);
-            FlushInstructionCache(GetCurrentProcess(), patchAddr, InstrSize);
-
-            Log("Entry zero-init patch at RVA 0x%X -> cave 0x%llX (%d bytes, tag+data)",
-                (uint32_t)TagWriteRVA, (uintptr_t)g_entryZeroInitCave, pos);
-            InterlockedExchange(&g_entryZeroInitPatched, 1);
+            Patch::Write* w = batch.Add("entry zero-init JMP", reinterpret_cast<uintptr_t>(patchAddr),
+                                        expectedBytes, patch, InstrSize, Patches::SafetyCaves);
+            if (w) {
+                snprintf(w->detail, sizeof(w->detail), "RVA 0x%X -> cave 0x%llX (%d bytes)",
+                         tagWriteRVA, (uintptr_t)g_entryZeroInitCave, (int)Caves::EntryZeroInit.size);
+            }
+            return w;
         }
         __except (EXCEPTION_EXECUTE_HANDLER) {
             Log("FAIL entry zero-init: exception during patch");
+            return nullptr;
         }
     }
 
@@ -1037,181 +1054,157 @@ namespace CascadePatch
     static volatile long g_ptrValidationPatched = 0;
     static void* g_ptrValidationCave = nullptr;
 
-    static void PatchCascadePtrValidation()
+    static Patch::Write* QueueCascadePtrValidation(Patch::Batch& batch)
     {
-        if (g_ptrValidationPatched) return;
-        if (!g_textDecrypted) return;
-
-        uintptr_t base = GetModuleBase();
         using namespace CascadePtrValidation;
 
-        uint8_t* patchAddr = reinterpret_cast<uint8_t*>(base + TestInstrRVA);
-        uintptr_t skipTarget = base + SkipTargetRVA;
-        uintptr_t continueAddr = base + ContinueRVA;
+        if (!SiteRVA(Sites::PtrValidationTest) || !SiteRVA(Sites::PtrValidationSkip) ||
+            !SiteRVA(Sites::PtrValidationContinue)) {
+            Log("SKIP cascade ptr validation: site not resolved");
+            return nullptr;
+        }
+        uint32_t testRVA = (uint32_t)SiteRVA(Sites::PtrValidationTest);
+        uint8_t* patchAddr = reinterpret_cast<uint8_t*>(SiteAddr(Sites::PtrValidationTest));
+        uintptr_t skipTarget = SiteAddr(Sites::PtrValidationSkip);
+        uintptr_t continueAddr = SiteAddr(Sites::PtrValidationContinue);
 
         // Expected bytes: test r14,r14 (4D 85 F6) + jz near (0F 84 8A 00 00 00)
-        const uint8_t expectedBytes[] = { 0x4D, 0x85, 0xF6, 0x0F, 0x84, 0x8A, 0x00, 0x00, 0x00 };
+        const uint8_t* expectedBytes = Caves::PtrValidationSite.data;
+        static_assert(Caves::PtrValidationSite.length == PatchSize);
 
         __try {
             if (memcmp(patchAddr, expectedBytes, PatchSize) != 0) {
-                Log("SKIP cascade ptr validation: bytes mismatch at RVA 0x%X", (uint32_t)TestInstrRVA);
+                Log("SKIP cascade ptr validation: bytes mismatch at RVA 0x%X", testRVA);
                 Log("  Expected: 4D 85 F6 0F 84 8A 00 00 00");
                 Log("  Found:    %02X %02X %02X %02X %02X %02X %02X %02X %02X",
                     patchAddr[0], patchAddr[1], patchAddr[2], patchAddr[3],
                     patchAddr[4], patchAddr[5], patchAddr[6], patchAddr[7], patchAddr[8]);
-                return;
+                return nullptr;
             }
 
-            g_ptrValidationCave = AllocateNearby(reinterpret_cast<uintptr_t>(patchAddr), 128);
+            if (!g_ptrValidationCave) g_ptrValidationCave = AllocateCave(Caves::PtrValidation.size);
             if (!g_ptrValidationCave) {
                 Log("FAIL cascade ptr validation: could not allocate code cave");
-                return;
+                return nullptr;
             }
 
+            // Code cave: self-healing pointer validation (Caves::PtrValidation)
             uint8_t* cave = reinterpret_cast<uint8_t*>(g_ptrValidationCave);
-            int pos = 0;
-
-            // Code cave layout (self-healing pointer validation):
-            // Context: R14 = cascade ptr, R12 = &[rax+rdi*8] (slot addr)
-            //
-            //   [0]  test r14, r14           ; 3  - null check
-            //   [3]  jz skip                 ; 2  - null → skip (create node path)
-            //   [5]  push rax                ; 1  - save temp
-            //   [6]  mov rax, r14            ; 3  - copy pointer
-            //   [9]  shr rax, 47             ; 4  - check bits 47-63
-            //   [13] test eax, eax           ; 2
-            //   [15] jnz pop_fix             ; 2  - high bits set → garbage
-            //   [17] mov eax, r14d           ; 3  - get lower 32 bits
-            //   [20] test eax, eax           ; 2  - real ptrs never have lower 32 bits = 0
-            //   [22] jz pop_fix              ; 2  - lower 32 bits zero → garbage
-            //   [24] pop rax                 ; 1  - valid pointer
-            //   [25] jmp continue_addr       ; 5  - back to mov edi, [r14+0x48]
-            //   [30] pop_fix:
-            //   [30] pop rax                 ; 1  - restore rax
-            //   [31] mov qword [r12], 0      ; 8  - zero cascade slot (self-heal)
-            //   [39] xor r14d, r14d          ; 3  - r14 = 0 → NULL path creates node
-            //   [42] skip:
-            //   [42] jmp skip_target         ; 5  - to original jz target (0x27A4A6D)
-            //   Total: 47 bytes
-
-            // [0] test r14, r14
-            cave[pos++] = 0x4D; cave[pos++] = 0x85; cave[pos++] = 0xF6;
-
-            // [3] jz skip (target at offset 42, rel8 = 42-5 = 37 = 0x25)
-            cave[pos++] = 0x74; cave[pos++] = 0x25;
-
-            // [5] push rax
-            cave[pos++] = 0x50;
-
-            // [6] mov rax, r14  (4C 89 F0)
-            cave[pos++] = 0x4C; cave[pos++] = 0x89; cave[pos++] = 0xF0;
-
-            // [9] shr rax, 47  (48 C1 E8 2F)
-            cave[pos++] = 0x48; cave[pos++] = 0xC1; cave[pos++] = 0xE8; cave[pos++] = 0x2F;
-
-            // [13] test eax, eax
-            cave[pos++] = 0x85; cave[pos++] = 0xC0;
-
-            // [15] jnz pop_fix (target at offset 30, rel8 = 30-17 = 13 = 0x0D)
-            cave[pos++] = 0x75; cave[pos++] = 0x0D;
-
-            // [17] mov eax, r14d  (44 89 F0) — lower 32 bits of r14
-            cave[pos++] = 0x44; cave[pos++] = 0x89; cave[pos++] = 0xF0;
-
-            // [20] test eax, eax
-            cave[pos++] = 0x85; cave[pos++] = 0xC0;
-
-            // [22] jz pop_fix (target at offset 30, rel8 = 30-24 = 6)
-            cave[pos++] = 0x74; cave[pos++] = 0x06;
-
-            // [24] pop rax — valid pointer path
-            cave[pos++] = 0x58;
-
-            // [25] jmp continue_addr (back to mov edi, [r14+0x48])
-            cave[pos++] = 0xE9;
-            int32_t relContinue = static_cast<int32_t>(
-                (intptr_t)continueAddr - (intptr_t)(reinterpret_cast<uintptr_t>(cave + pos) + 4));
-            memcpy(cave + pos, &relContinue, 4);
-            pos += 4;
-
-            // [30] pop_fix: pop rax — garbage detected, self-heal
-            cave[pos++] = 0x58;
-
-            // [31] mov qword ptr [r12], 0 — zero the cascade slot
-            // Encoding: 49 C7 04 24 00 00 00 00
-            cave[pos++] = 0x49; cave[pos++] = 0xC7; cave[pos++] = 0x04; cave[pos++] = 0x24;
-            cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00; cave[pos++] = 0x00;
-
-            // [39] xor r14d, r14d — set r14 = 0 so NULL path creates new node
-            // Encoding: 45 31 F6
-            cave[pos++] = 0x45; cave[pos++] = 0x31; cave[pos++] = 0xF6;
-
-            // [42] skip: jmp skip_target (to original jz target, creates new node)
-            cave[pos++] = 0xE9;
-            int32_t relSkip = static_cast<int32_t>(
-                (intptr_t)skipTarget - (intptr_t)(reinterpret_cast<uintptr_t>(cave + pos) + 4));
-            memcpy(cave + pos, &relSkip, 4);
-            pos += 4;
-
-            // Patch original: jmp code_cave (5 bytes) + 4 NOPs
-            uint8_t patch[9];
-            patch[0] = 0xE9;
-            int32_t jmpRel = static_cast<int32_t>(
-                (intptr_t)reinterpret_cast<uintptr_t>(cave) -
-                (intptr_t)(reinterpret_cast<uintptr_t>(patchAddr) + 5));
-            memcpy(patch + 1, &jmpRel, 4);
-            patch[5] = 0x90; patch[6] = 0x90; patch[7] = 0x90; patch[8] = 0x90;
-
-            DWORD oldProtect;
-            if (!VirtualProtect(patchAddr, PatchSize, PAGE_EXECUTE_READWRITE, &oldProtect)) {
-                Log("FAIL cascade ptr validation: VirtualProtect error %u", GetLastError());
-                VirtualFree(g_ptrValidationCave, 0, MEM_RELEASE);
-                g_ptrValidationCave = nullptr;
-                return;
+            uintptr_t targets[2] = {};
+            targets[Caves::PtrValidationContinue] = continueAddr;
+            targets[Caves::PtrValidationSkip] = skipTarget;
+            uint8_t patch[PatchSize];
+            if (!Caves::PtrValidation.Link(cave, targets, 2) ||
+                !X64::EncodeJmp(patch, PatchSize, reinterpret_cast<uintptr_t>(patchAddr),
+                                reinterpret_cast<uintptr_t>(cave))) {
+                Log("FAIL cascade ptr validation: code cave out of rel32 range");
+                return nullptr;
             }
 
-            memcpy(patchAddr, patch, PatchSize);
-            VirtualProtect(patchAddr, PatchSize, oldProtect, &oldProtect);
-            FlushInstructionCache(GetCurrentProcess(), patchAddr, PatchSize);
-
-            Log("Cascade ptr validation patch at RVA 0x%X -> cave 0x%llX (%d bytes, self-healing)",
-                (uint32_t)TestInstrRVA, (uintptr_t)g_ptrValidationCave, pos);
-            InterlockedExchange(&g_ptrValidationPatched, 1);
+            Patch::Write* w = batch.Add("cascade ptr validation JMP", reinterpret_cast<uintptr_t>(patchAddr),
+                                        expectedBytes, patch, PatchSize, Patches::SafetyCaves);
+            if (w) {
+                snprintf(w->detail, sizeof(w->detail), "RVA 0x%X -> cave 0x%llX (%d bytes)",
+                         testRVA, (uintptr_t)g_ptrValidationCave, (int)Caves::PtrValidation.size);
+            }
+            return w;
         }
         __except (EXCEPTION_EXECUTE_HANDLER) {
             Log("FAIL cascade ptr validation: exception during patch");
+            return nullptr;
         }
     }
 
+    // =========================================================================
+    // Steps 7-10 install: all four safety caves in one all-or-nothing batch.
+    // Each Queue* builds its cave and queues the site JMP; nothing is written
+    // unless every cave still pending verified, so there is no partial state.
+    // Caves that did not go live stay allocated and are rebuilt next attempt.
+    // =========================================================================
+    static void FinishCave(Patch::Write* w, volatile long& patched, const char* label)
+    {
+        if (patched) return;
+        if (w && w->Ok()) {
+            Log("%s patch applied: %s", label, w->detail);
+            InterlockedExchange(&patched, 1);
+        }
+    }
+
+    static bool SafetyPatchesDone()
+    {
+        return g_entryZeroInitPatched && g_nodeAllocPatched && g_nullSafePatched && g_ptrValidationPatched;
+    }
+
+    // Must be live BEFORE cascade 3 is enabled (MaskRestore depends on it):
+    //   entry zero-init  ROOT CAUSE: zero per-cascade ptrs on first use
+    //   node alloc       Defense: clear ->next on node reuse
+    //   null safety      Defense: null check in FUN_142813740
+    //   ptr validation   Defense: pointer range check at crash site
+    static bool InstallSafetyPatches()
+    {
+        if (SafetyPatchesDone()) return true;
+
+        Patch::Batch batch;
+        Patch::Write* zeroInit = g_entryZeroInitPatched ? nullptr : QueueCascadeEntryZeroInit(batch);
+        Patch::Write* nodeAlloc = g_nodeAllocPatched ? nullptr : QueueNodeAllocator(batch);
+        Patch::Write* nullSafe = g_nullSafePatched ? nullptr : QueueNullSafetyCheck(batch);
+        Patch::Write* ptrValid = g_ptrValidationPatched ? nullptr : QueueCascadePtrValidation(batch);
+
+        bool ready = (g_entryZeroInitPatched || zeroInit) && (g_nodeAllocPatched || nodeAlloc) &&
+                     (g_nullSafePatched || nullSafe) && (g_ptrValidationPatched || ptrValid);
+        if (ready) {
+            ApplyBatch(batch, 1u << Patches::SafetyCaves, "Safety cave batch");
+        }
+
+        FinishCave(zeroInit, g_entryZeroInitPatched, "Entry zero-init");
+        FinishCave(nodeAlloc, g_nodeAllocPatched, "Node alloc");
+        FinishCave(nullSafe, g_nullSafePatched, "Null safety");
+        FinishCave(ptrValid, g_ptrValidationPatched, "Cascade ptr validation");
+
+        if (!SafetyPatchesDone()) {
+            Log("WARN: safety patches incomplete (zeroinit=%ld, node=%ld, null=%ld, ptrval=%ld), staying in safe mode",
+                g_entryZeroInitPatched, g_nodeAllocPatched, g_nullSafePatched, g_ptrValidationPatched);
+            return false;
+        }
+        return true;
+    }
+
     // =========================================================================
     // Step 10: Restore mask writer to full rotation (only after both arrays ready)
+    // FlatArrayReady waits for 4 flat entries with shadow maps and prepares
+    // them; SafetyCaves (above) then goes live, and MaskRestore flips the mask.
     // =========================================================================
-    static void TryRestoreMaskRotation()
+    static bool ReadFlatArray(uintptr_t& cascadeGroup, uintptr_t& flatBuf, uint32_t& flatCount)
     {
-        if (g_maskRestored) return;
-        if (!g_vrExpanded) return;
-        if (!g_maskSafe) return;
+        GameState::FlatArray flat;
+        __try {
+            if (!GameState::ReadFlatArray(GetModuleBase(), flat)) return false;
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            return false;
+        }
+        cascadeGroup = flat.cascadeGroup;
+        flatBuf = flat.buf;
+        flatCount = flat.count;
+        return true;
+    }
 
+    static bool ProbeFlatArray()
+    {
         uintptr_t base = GetModuleBase();
+        uintptr_t cascadeGroup = 0, flatBuf = 0;
+        uint32_t flatCount = 0;
+        if (!ReadFlatArray(cascadeGroup, flatBuf, flatCount)) return false;
 
         // Verify flat cascade array has 4 valid entries before restoring
         static volatile long g_flatDiagLogged = 0;
         __try {
-            uintptr_t sceneNode = *reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr);
-            if (sceneNode == 0) return;
-
-            uintptr_t cascadeGroup = *reinterpret_cast<uintptr_t*>(sceneNode + CascadeGroupOffset);
-            if (cascadeGroup == 0) return;
-
-            uint32_t flatCount = *reinterpret_cast<uint32_t*>(cascadeGroup + FlatCountOffset);
-            uintptr_t flatBuf = *reinterpret_cast<uintptr_t*>(cascadeGroup + FlatBufferOffset);
-
             // Log diagnostics once
             if (InterlockedCompareExchange(&g_flatDiagLogged, 1, 0) == 0) {
                 uint32_t currentGlobal = *reinterpret_cast<uint32_t*>(base + CascadeCountPatch::CountGlobal);
                 Log("=== Flat array diagnostics ===");
                 Log("DAT_143924818 (current) = %u", currentGlobal);
-                Log("Scene node: 0x%llX", sceneNode);
+                Log("Scene node: 0x%llX", *reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr));
                 Log("Cascade group: 0x%llX, vtable: 0x%llX",
                     cascadeGroup, *reinterpret_cast<uintptr_t*>(cascadeGroup));
                 Log("Flat count (0x190): %u, buffer (0x198): 0x%llX", flatCount, flatBuf);
@@ -1219,42 +1212,42 @@ namespace CascadePatch
                 Log("Flat capacity (0x1A0): %u", capacity);
 
                 if (flatBuf != 0) {
-                    for (uint32_t i = 0; i < flatCount && i < 8; i++) {
+                    uint32_t i = 0;
+                    for (; i < flatCount && i < 8; i++) {
                         uintptr_t entry = flatBuf + i * FlatEntrySize;
-                        Log("  flat[%u]: +0x50=0x%llX +0x58=0x%llX +0xF8=0x%llX",
-                            i,
-                            *reinterpret_cast<uintptr_t*>(entry + 0x50),
-                            *reinterpret_cast<uintptr_t*>(entry + 0x58),
-                            *reinterpret_cast<uintptr_t*>(entry + 0xF8));
+                        g_flight.Record(Events::FlatEntry, i,
+                                        *reinterpret_cast<uintptr_t*>(entry + 0x50),
+                                        *reinterpret_cast<uintptr_t*>(entry + 0x58),
+                                        *reinterpret_cast<uintptr_t*>(entry + 0xF8));
                     }
+                    Log("  %u flat entries recorded (flat_entry)", i);
                 }
             }
 
-            if (flatBuf == 0 || flatCount < 4) {
-                return;  // Keep safe mode
-            }
-
-            // Check shadow map pointers at +0x50 for all 4 entries
-            bool allValid = true;
-            for (uint32_t i = 0; i < 4; i++) {
-                uintptr_t entry = flatBuf + i * FlatEntrySize;
-                uintptr_t shadowMap = *reinterpret_cast<uintptr_t*>(entry + FlatShadowMapOff);
-                if (shadowMap == 0) { allValid = false; break; }
-            }
+            // Keep safe mode until 4 entries have their shadow maps
+            return GameState::FlatArrayReady({ cascadeGroup, flatBuf, flatCount });
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            return false;
+        }
+    }
 
-            if (!allValid) {
-                return;  // Keep safe mode until all shadow maps initialized
-            }
+    static bool PrepareFlatArray()
+    {
+        uintptr_t base = GetModuleBase();
+        uintptr_t cascadeGroup = 0, flatBuf = 0;
+        uint32_t flatCount = 0;
+        if (!ReadFlatArray(cascadeGroup, flatBuf, flatCount)) return false;
 
+        __try {
             Log("All 4 flat entries valid!");
-            // Log additional fields for cascade 3 investigation
+            // Record additional fields for cascade 3 investigation
             for (uint32_t i = 0; i < 4; i++) {
                 uintptr_t entry = flatBuf + i * FlatEntrySize;
-                Log("  flat[%u]: +0x40=0x%llX +0x48=0x%llX +0x102=%u",
-                    i,
-                    *reinterpret_cast<uintptr_t*>(entry + 0x40),
-                    *reinterpret_cast<uintptr_t*>(entry + 0x48),
-                    (uint32_t)*reinterpret_cast<uint8_t*>(entry + 0x102));
+                g_flight.Record(Events::FlatEntryLate, i,
+                                *reinterpret_cast<uintptr_t*>(entry + 0x40),
+                                *reinterpret_cast<uintptr_t*>(entry + 0x48),
+                                *reinterpret_cast<uint8_t*>(entry + 0x102));
             }
 
             // ======= v11.0.0: Shadow distance diagnostics =======
@@ -1266,8 +1259,9 @@ namespace CascadePatch
                 Log("DAT_143924818 (cascade count) = %u", countGlobal);
                 Log("Shadow dist 4-cascade (0x2c7f648) = %.1f", dist4);
                 Log("Shadow dist 2-cascade (0x3924808) = %.1f", dist2);
+                uintptr_t cmpImm = SiteAddr(Sites::SetupCmpImm);
                 Log("Setup CMP patched: %s (should use 4-cascade distance)",
-                    *reinterpret_cast<uint8_t*>(base + CountReadPatch::SetupCmpImm) == 0x00 ? "YES" : "NO");
+                    cmpImm && *reinterpret_cast<uint8_t*>(cmpImm) == CountReadPatch::SetupCmpNew ? "YES" : "NO");
             }
 
             // ======= Shader and cascade group diagnostics =======
@@ -1283,12 +1277,10 @@ namespace CascadePatch
                 uint32_t shaderField158 = *reinterpret_cast<uint32_t*>(shaderObj + 0x158);
                 uint16_t shaderCap = *reinterpret_cast<uint16_t*>(shaderObj + 0x158 + 0x10);
                 uint16_t shaderCount = *reinterpret_cast<uint16_t*>(shaderObj + 0x158 + 0x12);
-                Log("shader+0x158 (cascade field): %u", shaderField158);
-                Log("shader+0x168 (array capacity): %u, +0x16A (array count): %u",
-                    (uint32_t)shaderCap, (uint32_t)shaderCount);
-                Log("shader+0x11C: %u, shader+0x1D8 (stored count): %u",
-                    (uint32_t)*reinterpret_cast<uint8_t*>(shaderObj + 0x11C),
-                    *reinterpret_cast<uint32_t*>(shaderObj + 0x1D8));
+                g_flight.Record(Events::ShaderFields, shaderObj, shaderField158,
+                                *reinterpret_cast<uint32_t*>(shaderObj + 0x1D8), shaderCap, shaderCount);
+                Log("shader+0x158 (cascade field): %u, shader+0x11C: %u", shaderField158,
+                    (uint32_t)*reinterpret_cast<uint8_t*>(shaderObj + 0x11C));
             } else {
                 Log("WARN: shader object is NULL at cascade_group+0x2B8");
             }
@@ -1299,28 +1291,24 @@ namespace CascadePatch
                 Log("Forced cascade_group+0x173 = 1 (shader will use 4 cascades)");
             }
 
-            // Shadow map validation
-            Log("=== Shadow map validation ===");
+            // Shadow map validation (decoded from the flight recorder)
             for (uint32_t i = 0; i < 4; i++) {
                 uintptr_t entry = flatBuf + i * FlatEntrySize;
                 uintptr_t leftMap = *reinterpret_cast<uintptr_t*>(entry + FlatShadowMapOff);
                 uintptr_t rightMap = *reinterpret_cast<uintptr_t*>(entry + FlatShadowMapRightOff);
-                Log("  cascade[%u]: L=0x%llX R=0x%llX eye_flag: L=%u R=%u",
-                    i, leftMap, rightMap,
-                    leftMap ? (uint32_t)*reinterpret_cast<uint8_t*>(leftMap + 0xf6dc) : 99,
-                    rightMap ? (uint32_t)*reinterpret_cast<uint8_t*>(rightMap + 0xf6dc) : 99);
-                // v11.0.0: Log rendering function index and scene node binding
-                if (leftMap) {
-                    int32_t lFuncIdx = *reinterpret_cast<int32_t*>(leftMap + 0xf688);
-                    uintptr_t lSceneNode = *reinterpret_cast<uintptr_t*>(leftMap + 0xf680);
-                    Log("    L: funcIdx=%d sceneNode=0x%llX", lFuncIdx, lSceneNode);
-                }
-                if (rightMap) {
-                    int32_t rFuncIdx = *reinterpret_cast<int32_t*>(rightMap + 0xf688);
-                    uintptr_t rSceneNode = *reinterpret_cast<uintptr_t*>(rightMap + 0xf680);
-                    Log("    R: funcIdx=%d sceneNode=0x%llX", rFuncIdx, rSceneNode);
+                g_flight.Record(Events::ShadowMap, i, leftMap, rightMap,
+                                leftMap ? *reinterpret_cast<uint8_t*>(leftMap + 0xf6dc) : 99,
+                                rightMap ? *reinterpret_cast<uint8_t*>(rightMap + 0xf6dc) : 99);
+                // v11.0.0: rendering function index and scene node binding
+                for (uint32_t eye = 0; eye < 2; eye++) {
+                    uintptr_t map = eye ? rightMap : leftMap;
+                    if (!map) continue;
+                    g_flight.Record(Events::ShadowMapBinding, i, eye,
+                                    static_cast<uint32_t>(*reinterpret_cast<int32_t*>(map + 0xf688)),
+                                    *reinterpret_cast<uintptr_t*>(map + 0xf680));
                 }
             }
+            Log("Shadow maps recorded (shadow_map, shadow_map_binding)");
 
             // Clear the "last cascade" flag on flat[3]
             {
@@ -1334,200 +1322,227 @@ namespace CascadePatch
                     Log("flat[3]+0x102 already 0, no change needed");
                 }
             }
-
-            Log("Enabling 4-cascade mode (mask=0xF ALL frames): cascades 0,1,2,3");
         }
         __except (EXCEPTION_EXECUTE_HANDLER) {
-            return;
-        }
-
-        // Apply safety patches BEFORE enabling cascade 3
-        PatchCascadeEntryZeroInit();  // ROOT CAUSE: zero per-cascade ptrs on first use
-        PatchNodeAllocator();         // Defense: clear ->next on node reuse
-        PatchNullSafetyCheck();       // Defense: null check in FUN_142813740
-        PatchCascadePtrValidation();  // Defense: pointer range check at crash site
-        if (!g_entryZeroInitPatched || !g_nodeAllocPatched || !g_nullSafePatched || !g_ptrValidationPatched) {
-            Log("WARN: safety patches incomplete (zeroinit=%ld, node=%ld, null=%ld, ptrval=%ld), staying in safe mode",
-                g_entryZeroInitPatched, g_nodeAllocPatched, g_nullSafePatched, g_ptrValidationPatched);
-            return;
+            return false;
         }
+        return true;
+    }
 
+    static bool RestoreMaskRotation()
+    {
         // v10.0.0: Force ALL mask values to 0xF — render all 4 cascades EVERY frame.
         // Eliminates temporal rotation {0xF,0x5,0xF,0x9} which caused:
         //   - LEFT eye flickering (cascades missing on non-0xF frames)
         //   - Possible RIGHT eye issues due to stale/missing temporal data
         // Trade-off: ~2x shadow rendering cost, but VR has the GPU headroom.
-        using namespace MaskWriterPatch;
-
-        int n = 0;
-        if (PatchByte(base + InitMask_Byte, 0x03, 0x0F,
-                      "initial mask 0x3->0xF")) n++;
-        if (PatchByte(base + FallbackMask_Byte, 0x03, 0x0F,
-                      "fallback mask 0x3->0xF")) n++;
-        if (PatchByte(base + ArrayEntry1_Byte, 0x03, 0x0F,
-                      "array[1] 0x3->0xF")) n++;
-        if (PatchByte(base + ArrayEntry3_Byte, 0x03, 0x0F,
-                      "array[3] 0x3->0xF")) n++;
+        Log("Enabling 4-cascade mode (mask=0xF ALL frames): cascades 0,1,2,3");
+        Patch::Batch batch;
+        QueuePatches(batch, Patches::MaskRestoreAll, 1u << Patches::MaskRestore);
+        ApplyBatch(batch, 0, "Mask restore batch");
+        int n = batch.Applied(Patches::MaskRestore);
 
         Log("4-cascade mode: %d/4 patches applied (ALL frames render ALL cascades, mask=0xF)", n);
-        InterlockedExchange(&g_maskRestored, 1);
+        return true;
     }
 
     // =========================================================================
-    // v13.0.0: Fix setup scene node (DAT_146885d40)
-    // The VR engine adds a second scene node pointer for shadow setup but never
-    // initializes it. BSShaderManager::SetShadowSceneNode(1, ...) is never called.
-    // Fix: copy the render scene node pointer to the setup slot.
-    // This mirrors the SE behavior where only one scene node exists.
+    // BSShaderManager::SetShadowSceneNode detour (see detour.h)
+    // The scene node chain used to wait for the timer to notice
+    // DAT_146879520 change. With the detour, the engine's own call runs the
+    // original and then polls the Hook lane, so the setup node fix and
+    // everything after it happen in that call. While the detour is in, the
+    // timer no longer probes the scene node globals; it only runs the chain
+    // if the detour lost the race for Poll().
+    // The entry has no pattern, so it is only hooked when every resolved site
+    // is at its 1.2.72 RVA.
     // =========================================================================
-    static volatile long g_setupNodeFixed = 0;
+    static void PollSteps(uint8_t lane);
+
+    // Declared with a return value so whatever the original leaves in rax
+    // reaches the caller unchanged
+    using SetShadowSceneNodeFn = uintptr_t (*)(uint32_t index, void* node);
+
+    static Detour::Hook g_sceneNodeHook;
+    static volatile long g_sceneNodeHooked = 0;
+    static volatile long g_sceneNodeSeen = 0;     // render node set (through the detour or before it)
+    static volatile long g_sceneNodeCalls = 0;
+
+    static uintptr_t SetShadowSceneNodeDetour(uint32_t index, void* node)
+    {
+        uintptr_t result = g_sceneNodeHook.Original<SetShadowSceneNodeFn>()(index, node);
+
+        long calls = InterlockedIncrement(&g_sceneNodeCalls);
+        g_flight.Record(Events::SceneNodeSet, index, reinterpret_cast<uintptr_t>(node), g_steps.State());
+        if (calls <= 8) Log("SetShadowSceneNode(%u, 0x%llX)", index, reinterpret_cast<uintptr_t>(node));
+
+        if (index == 0 && node) {
+            InterlockedExchange(&g_sceneNodeSeen, 1);
+            g_steps.Wake(Sched::Bit(Steps::SetupSceneNode));
+            PollSteps(Steps::Hook);
+        }
+        return result;
+    }
 
-    static void FixSetupSceneNode()
+    static bool SitesAtHints()
     {
-        if (g_setupNodeFixed) return;
+        for (size_t i = 0; i < Sites::Count; i++) {
+            if (g_sites[i].rva && g_sites[i].rva != Sites::Table[i].hintRVA) return false;
+        }
+        return true;
+    }
 
+    // Runs once: a hook that cannot go in leaves the timer polling as before
+    static bool InstallSceneNodeHook()
+    {
         uintptr_t base = GetModuleBase();
+        if (!SitesAtHints()) {
+            Log("SKIP scene node hook: image differs from 1.2.72, scene node stays timer-polled");
+            return true;
+        }
+        if (!EnsureArena()) {
+            Log("SKIP scene node hook: no code arena");
+            return true;
+        }
+
+        Patch::Batch batch;
         __try {
-            uintptr_t renderNode = *reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr);
-            if (renderNode == 0) return;  // Render node not yet initialized
-
-            uintptr_t setupNode = *reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr2);
-            if (setupNode != 0) {
-                // Already valid — might have been set by the engine or a previous fix
-                InterlockedExchange(&g_setupNodeFixed, 1);
-                return;
+            if (!Detour::Prepare(g_sceneNodeHook, "SetShadowSceneNode detour", base + SetShadowSceneNodeFuncRVA,
+                                 reinterpret_cast<const void*>(&SetShadowSceneNodeDetour), g_arena)) {
+                Log("SKIP scene node hook: %s", Detour::ErrorName(g_sceneNodeHook.error));
+                return true;
             }
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            Log("SKIP scene node hook: exception reading the entry");
+            return true;
+        }
 
-            // Copy render node to setup node
-            // .data section is already PAGE_READWRITE — no VirtualProtect needed
-            volatile uintptr_t* pSetup = reinterpret_cast<volatile uintptr_t*>(base + ShadowSceneNodePtr2);
-            *pSetup = renderNode;
-            Log("Setup scene node fixed: NULL -> 0x%llX (copied from render node)", renderNode);
+        Patch::Write* w = Detour::QueueInstall(g_sceneNodeHook, batch, Patches::EngineHooks);
+        if (w) {
+            snprintf(w->detail, sizeof(w->detail), "%u prologue bytes -> trampoline 0x%llX",
+                     g_sceneNodeHook.length, reinterpret_cast<uintptr_t>(g_sceneNodeHook.trampoline));
+        }
+        ApplyBatch(batch, 0, "Engine hook batch");
+        if (!batch.Applied(Patches::EngineHooks)) return true;
 
-            // Also verify by reading cascade group from the now-valid setup node
-            uintptr_t cg = *reinterpret_cast<uintptr_t*>(renderNode + CascadeGroupOffset);
-            Log("  Setup cascade group: 0x%llX (via render node+0x248)", cg);
+        // Hooked from here on; a node set before that is picked up now
+        InterlockedExchange(&g_sceneNodeHooked, 1);
+        __try {
+            if (*reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr)) InterlockedExchange(&g_sceneNodeSeen, 1);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {}
+        return true;
+    }
 
-            InterlockedExchange(&g_setupNodeFixed, 1);
+    // Timer probe for the setup node fix: no scene node reads while the
+    // detour will report it
+    static bool ProbeSceneNode()
+    {
+        return !g_sceneNodeHooked || g_sceneNodeSeen;
+    }
+
+    // =========================================================================
+    // v13.0.0: Fix setup scene node (DAT_146885d40)
+    // The VR engine adds a second scene node pointer for shadow setup but never
+    // initializes it. BSShaderManager::SetShadowSceneNode(1, ...) is never called.
+    // Fix: copy the render scene node pointer to the setup slot.
+    // This mirrors the SE behavior where only one scene node exists.
+    // =========================================================================
+    static bool FixSetupSceneNode()
+    {
+        uintptr_t base = GetModuleBase();
+        GameState::SceneNodeResult r;
+        __try {
+            // The state every later fix starts from, while the setup slot is still empty
+            if (g_captureSnapshots && *reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr) &&
+                !*reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr2)) {
+                CaptureSnapshot(CaptureSetup);
+            }
+            r = GameState::FixSetupSceneNode(base);
         }
         __except (EXCEPTION_EXECUTE_HANDLER) {
             Log("FixSetupSceneNode: exception caught");
+            return false;
+        }
+
+        switch (r.result) {
+        case GameState::SceneNode::NoRenderNode:
+            return false;  // Render node not yet initialized
+        case GameState::SceneNode::AlreadySet:
+            return true;   // Might have been set by the engine
+        case GameState::SceneNode::Copied:
+            Log("Setup scene node fixed: NULL -> 0x%llX (copied from render node)", r.renderNode);
+            Log("  Setup cascade group: 0x%llX (via render node+0x248)", r.cascadeGroup);
+            return true;
         }
+        return false;
     }
 
     // =========================================================================
     // v13.0.0: Force shader cascade fields on cascade group's shader object
     // The ISCopy shader at cascade_group+0x2B8 may have been constructed before
     // our constructor patches, leaving capacity/count at 0 or 2.
-    // Force fields to 4 so the ISCopy shader processes all 4 cascades.
+    // Force fields to 4 so the ISCopy shader processes all 4 cascades. Done
+    // once the render node's shader exists and all three fields are 4.
     // =========================================================================
-    static volatile long g_shaderFieldsForced = 0;
-
-    static void ForceShaderFields()
+    static bool ForceShaderFields()
     {
-        if (g_shaderFieldsForced) return;
-        uintptr_t base = GetModuleBase();
+        GameState::ShaderResult shaders[2];
+        bool renderDone;
         __try {
-            // Process both scene nodes' cascade groups
-            uintptr_t nodeAddrs[] = { ShadowSceneNodePtr, ShadowSceneNodePtr2 };
-            const char* labels[] = { "RENDER", "SETUP" };
-
-            for (int n = 0; n < 2; n++) {
-                uintptr_t sceneNode = *reinterpret_cast<uintptr_t*>(base + nodeAddrs[n]);
-                if (sceneNode == 0) continue;
-
-                uintptr_t cg = *reinterpret_cast<uintptr_t*>(sceneNode + CascadeGroupOffset);
-                if (cg == 0) continue;
-
-                uintptr_t shader = *reinterpret_cast<uintptr_t*>(cg + ShaderObjectOffset);
-                if (shader == 0) continue;
-
-                // Force shader+0x1D8 (stored cascade count)
-                uint32_t* pStored = reinterpret_cast<uint32_t*>(shader + 0x1D8);
-                if (*pStored < 4) {
-                    uint32_t old = *pStored;
-                    *pStored = 4;
-                    if (InterlockedCompareExchange(&g_shaderFieldsForced, 1, 0) == 0) {
-                        Log("Forced %s shader+0x1D8 (stored count): %u -> 4", labels[n], old);
-                    }
-                }
-
-                // Force shader+0x168 (array capacity) — uint16_t
-                uint16_t* pCap = reinterpret_cast<uint16_t*>(shader + 0x168);
-                if (*pCap < 4) {
-                    uint16_t old = *pCap;
-                    *pCap = 4;
-                    if (g_shaderFieldsForced == 1) {
-                        Log("Forced %s shader+0x168 (array cap): %u -> 4", labels[n], (uint32_t)old);
-                    }
-                }
+            renderDone = GameState::ForceShaderFields(GetModuleBase(), shaders);
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            return false;
+        }
 
-                // Force shader+0x16A (array count) — uint16_t
-                uint16_t* pCnt = reinterpret_cast<uint16_t*>(shader + 0x16A);
-                if (*pCnt < 4) {
-                    uint16_t old = *pCnt;
-                    *pCnt = 4;
-                    if (g_shaderFieldsForced == 1) {
-                        Log("Forced %s shader+0x16A (array count): %u -> 4", labels[n], (uint32_t)old);
-                    }
-                }
+        const char* labels[] = { "RENDER", "SETUP" };
+        for (int n = 0; n < 2; n++) {
+            const GameState::ShaderResult& s = shaders[n];
+            if (s.forced & GameState::ShaderStored) {
+                Log("Forced %s shader+0x1D8 (stored count): %u -> 4", labels[n], s.stored);
+            }
+            if (s.forced & GameState::ShaderCap) {
+                Log("Forced %s shader+0x168 (array cap): %u -> 4", labels[n], (uint32_t)s.capacity);
+            }
+            if (s.forced & GameState::ShaderCount) {
+                Log("Forced %s shader+0x16A (array count): %u -> 4", labels[n], (uint32_t)s.count);
             }
         }
-        __except (EXCEPTION_EXECUTE_HANDLER) {}
+        return renderDone;
     }
 
     // =========================================================================
     // v12.0.0: Force cascade_group+0x173 = 1 on BOTH scene nodes' cascade groups
     // Also fix 4-cascade shadow distance if it's FLT_MAX (uninitialized in VR mode)
     // =========================================================================
-    static volatile long g_extDiagLogged = 0;
-
-    static volatile long g_cascadeGroupsForced = 0;
-
-    static void ForceBothCascadeGroups()
+    static bool ForceBothCascadeGroups()
     {
-        if (g_cascadeGroupsForced) return;
-
-        uintptr_t base = GetModuleBase();
         __try {
-            // Need both scene nodes to be valid before forcing
-            uintptr_t sceneNode1 = *reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr);
-            if (sceneNode1 == 0) return;
-            uintptr_t cg1 = *reinterpret_cast<uintptr_t*>(sceneNode1 + CascadeGroupOffset);
-            if (cg1 == 0) return;
-
-            // Force +0x173 on rendering cascade group
-            uint8_t* pFlag1 = reinterpret_cast<uint8_t*>(cg1 + CascadeGroupVRFlag);
-            if (*pFlag1 == 0) *pFlag1 = 1;
-
-            // Force +0x173 on setup cascade group (same object after FixSetupSceneNode)
-            uintptr_t sceneNode2 = *reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr2);
-            if (sceneNode2 != 0) {
-                uintptr_t cg2 = *reinterpret_cast<uintptr_t*>(sceneNode2 + CascadeGroupOffset);
-                if (cg2 != 0) {
-                    uint8_t* pFlag2 = reinterpret_cast<uint8_t*>(cg2 + CascadeGroupVRFlag);
-                    if (*pFlag2 == 0) *pFlag2 = 1;
-                }
-            }
-
-            InterlockedExchange(&g_cascadeGroupsForced, 1);
+            // Setup group is the same object after FixSetupSceneNode
+            return GameState::ForceCascadeGroups(GetModuleBase());
+        }
+        __except (EXCEPTION_EXECUTE_HANDLER) {
+            return false;
         }
-        __except (EXCEPTION_EXECUTE_HANDLER) {}
     }
 
     // =========================================================================
     // v12.0.0: Extended diagnostics — log shader state after full initialization
     // =========================================================================
-    static void LogExtendedDiagnostics()
+    static bool LogExtendedDiagnostics()
     {
-        if (InterlockedCompareExchange(&g_extDiagLogged, 1, 0) != 0) return;
-
         uintptr_t base = GetModuleBase();
         __try {
+            CaptureSnapshot(CaptureActive);
             Log("=== v13.3.0 Extended Diagnostics ===");
-            Log("Setup scene node fixed: %s", g_setupNodeFixed ? "YES" : "NO");
-            Log("Shader fields forced: %s", g_shaderFieldsForced ? "YES" : "NO");
-            Log("VR entries refreshed: %s", g_vrEntriesRefreshed ? "YES" : "NO");
+            Log("Setup scene node fixed: %s", g_steps.Done(Steps::SetupSceneNode) ? "YES" : "NO");
+            Log("Shader fields forced: %s", g_steps.Done(Steps::ShaderFields) ? "YES" : "NO");
+            if (RefreshVREntries) Log("VR entries refreshed: %s", g_vrEntriesRefreshed ? "YES" : "NO");
+            Log("Proxy thunks retargeted: %s (%llu init-path calls)", Thunks::Retargeted() ? "YES" : "NO",
+                (unsigned long long)Thunks::InitCalls());
+            Log("Scene node hook: %s (%ld calls)", g_sceneNodeHooked ? "YES" : "NO", g_sceneNodeCalls);
 
             // Check both scene nodes
             uintptr_t sn1 = *reinterpret_cast<uintptr_t*>(base + ShadowSceneNodePtr);
@@ -1554,12 +1569,11 @@ namespace CascadePatch
                 Log("  %s cg+0x173=%u, shader=0x%llX", label, (uint32_t)vrFlag, shaderObj);
 
                 if (shaderObj != 0) {
-                    uint32_t s158 = *reinterpret_cast<uint32_t*>(shaderObj + 0x158);
-                    uint32_t s1D8 = *reinterpret_cast<uint32_t*>(shaderObj + 0x1D8);
-                    uint16_t cap = *reinterpret_cast<uint16_t*>(shaderObj + 0x168);
-                    uint16_t cnt = *reinterpret_cast<uint16_t*>(shaderObj + 0x16A);
-                    Log("    shader+0x158(cascades)=%u, +0x1D8(stored)=%u, +0x168(cap)=%u, +0x16A(cnt)=%u",
-                        s158, s1D8, (uint32_t)cap, (uint32_t)cnt);
+                    g_flight.Record(Events::ShaderFields, shaderObj,
+                                    *reinterpret_cast<uint32_t*>(shaderObj + 0x158),
+                                    *reinterpret_cast<uint32_t*>(shaderObj + 0x1D8),
+                                    *reinterpret_cast<uint16_t*>(shaderObj + 0x168),
+                                    *reinterpret_cast<uint16_t*>(shaderObj + 0x16A));
                 }
             }
 
@@ -1582,29 +1596,11 @@ namespace CascadePatch
                 if (vrBuf != 0) {
                     for (uint32_t i = 0; i < 4 && i < vrCount; i++) {
                         uintptr_t entry = vrBuf + i * VRArrayExpansion::EntrySize;
-                        const uint8_t* p = reinterpret_cast<const uint8_t*>(entry);
-                        int nonZero = 0;
-                        for (size_t off = 0; off < VRArrayExpansion::EntrySize; off++) {
-                            if (p[off] != 0) nonZero++;
-                        }
-                        // Show first 64 bytes of each entry
-                        Log("  VR[%u] (%d/%zu nz): %02X%02X%02X%02X %02X%02X%02X%02X "
-                            "%02X%02X%02X%02X %02X%02X%02X%02X "
-                            "%02X%02X%02X%02X %02X%02X%02X%02X "
-                            "%02X%02X%02X%02X %02X%02X%02X%02X "
-                            "%02X%02X%02X%02X %02X%02X%02X%02X "
-                            "%02X%02X%02X%02X %02X%02X%02X%02X "
-                            "%02X%02X%02X%02X %02X%02X%02X%02X "
-                            "%02X%02X%02X%02X %02X%02X%02X%02X",
-                            i, nonZero, VRArrayExpansion::EntrySize,
-                            p[0],p[1],p[2],p[3],p[4],p[5],p[6],p[7],
-                            p[8],p[9],p[10],p[11],p[12],p[13],p[14],p[15],
-                            p[16],p[17],p[18],p[19],p[20],p[21],p[22],p[23],
-                            p[24],p[25],p[26],p[27],p[28],p[29],p[30],p[31],
-                            p[32],p[33],p[34],p[35],p[36],p[37],p[38],p[39],
-                            p[40],p[41],p[42],p[43],p[44],p[45],p[46],p[47],
-                            p[48],p[49],p[50],p[51],p[52],p[53],p[54],p[55],
-                            p[56],p[57],p[58],p[59],p[60],p[61],p[62],p[63]);
+                        uint32_t nonZero = Watch::NonZeroBytes(reinterpret_cast<const uint8_t*>(entry),
+                                                               VRArrayExpansion::EntrySize);
+                        // Record the first 64 bytes of each entry
+                        g_flight.Record(Events::VRArrayEntry, i, entry, nonZero, VRArrayExpansion::EntrySize);
+                        RecordHexDump(entry, 64);
                     }
                 }
             }
@@ -1622,22 +1618,17 @@ namespace CascadePatch
                     for (uint32_t e = 0; e < arrCount && e < 8; e++) {
                         uintptr_t mapPtr = *reinterpret_cast<uintptr_t*>(arrPtr + e * 8);
                         // Check if this matches any LEFT or RIGHT flat map
-                        const char* match = "?";
+                        uint32_t eye = 0xFF, cascade = 0xFF;
                         if (flatBuf) {
-                            for (uint32_t c = 0; c < 4; c++) {
+                            for (uint32_t c = 0; c < 4 && eye == 0xFF; c++) {
                                 uintptr_t lm = *reinterpret_cast<uintptr_t*>(flatBuf + c * FlatEntrySize + FlatShadowMapOff);
                                 uintptr_t rm = *reinterpret_cast<uintptr_t*>(flatBuf + c * FlatEntrySize + FlatShadowMapRightOff);
-                                if (mapPtr == lm) {
-                                    static char buf[32]; snprintf(buf, sizeof(buf), "LEFT[%u]", c);
-                                    match = buf; break;
-                                }
-                                if (mapPtr == rm) {
-                                    static char buf[32]; snprintf(buf, sizeof(buf), "RIGHT[%u]", c);
-                                    match = buf; break;
-                                }
+                                if (mapPtr == lm) eye = 0;
+                                else if (mapPtr == rm) eye = 1;
+                                if (eye != 0xFF) cascade = c;
                             }
                         }
-                        Log("    [%u] 0x%llX = %s", e, mapPtr, match);
+                        g_flight.Record(Events::DescMapping, d, e, mapPtr, eye, cascade);
                     }
                 }
             }
@@ -1645,80 +1636,107 @@ namespace CascadePatch
         __except (EXCEPTION_EXECUTE_HANDLER) {
             Log("Extended diagnostics: exception");
         }
+        return true;
     }
 
     // =========================================================================
-    // Timer callback: polls for VR array expansion from Windows thread pool
-    // v12.0.0: Continues running after activation for diagnostics and +0x173 forcing
+    // Step scheduler (see cascade_steps.h)
+    // Exports poll the Export lane until StartTimer hands over; the timer then
+    // polls the Timer lane and re-arms itself for the next due step instead of
+    // ticking at a fixed rate. It deletes itself once no timer step is pending.
     // =========================================================================
-    static VOID CALLBACK ExpansionTimerCallback(PVOID /*lpParameter*/, BOOLEAN /*TimerOrWaitFired*/)
+    template <bool (*Fn)()>
+    static bool StepHook(void* /*context*/)
     {
-        static volatile long s_tickCount = 0;
-        long tick = InterlockedIncrement(&s_tickCount);
-
-        // Keep forcing cascade count = 4 (belt-and-suspenders with instruction patches)
-        ForceCascadeCount4();
+        return Fn();
+    }
 
-        // v12.0.0: Always force +0x173 on both cascade groups and fix shadow distance
-        ForceBothCascadeGroups();
+    static bool StartStepTimer();
+
+    static constexpr Sched::Hooks g_stepHooks[Steps::Count] = {
+        { nullptr,                       StepHook<ForceCascadeCount4> },
+        { StepHook<ProbeTextDecrypted>,  StepHook<ResolveSitesStep> },
+        { nullptr,                       StepHook<ApplyStartupPatches> },
+        { nullptr,                       StepHook<RetryStereoDispatch> },
+        { nullptr,                       StepHook<WriteShadowDistance> },
+        { nullptr,                       StepHook<ExpandVRArray> },
+        { nullptr,                       StepHook<StartStepTimer> },
+        { nullptr,                       StepHook<InstallSceneNodeHook> },
+        { StepHook<ProbeSceneNode>,      StepHook<FixSetupSceneNode> },
+        { nullptr,                       StepHook<ForceBothCascadeGroups> },
+        { nullptr,                       StepHook<ForceShaderFields> },
+        { StepHook<ProbeFlatArray>,      StepHook<PrepareFlatArray> },
+        { nullptr,                       StepHook<InstallSafetyPatches> },
+        { nullptr,                       StepHook<RestoreMaskRotation> },
+        { nullptr,                       StepHook<LogExtendedDiagnostics> },
+    };
+
+    static void PollSteps(uint8_t lane)
+    {
+        uint64_t now = GetTickCount64();
+        uint32_t completed = g_steps.Poll(now, lane);
+        for (size_t id = 0; id < Steps::Count; id++) {
+            if (!(completed & Sched::Bit(id))) continue;
+            const Sched::StepStats& stats = g_steps.Stats(id);
+            Log("Step %s done at %.1f s (%u attempts)", g_steps.Step(id).name,
+                (stats.doneAtMs - g_stepsStartMs) / 1000.0, stats.probes);
+        }
+        if (completed & Sched::Bit(Steps::MaskRestore)) {
+            Log("4-cascade shadow rendering active (%s)", lane == Steps::Timer ? "via timer"
+                                                          : lane == Steps::Hook  ? "via SetShadowSceneNode"
+                                                                                 : "via export");
+        }
+    }
 
-        // v13.0.0: Fix setup scene node (NULL in VR) and force shader fields
-        FixSetupSceneNode();
-        ForceShaderFields();
+    static VOID CALLBACK StepTimerCallback(PVOID /*lpParameter*/, BOOLEAN /*TimerOrWaitFired*/)
+    {
+        static volatile long s_tickCount = 0;
+        long tick = InterlockedIncrement(&s_tickCount);
 
-        // v13.2.0: RefreshVRArrayEntries disabled — never triggers and adds heap reads during loading
+        if constexpr (RefreshVREntries) RefreshVRArrayEntries();
+        PollSteps(Steps::Timer);
 
-        if (!g_maskRestored) {
-            // Log state on first few ticks
-            if (tick <= 3 || (tick % 20) == 0) {
-                Log("Timer tick #%ld: vrExpanded=%ld, maskRestored=%ld",
-                    tick, g_vrExpanded, g_maskRestored);
-            }
+        uint64_t now = GetTickCount64();
+        uint64_t due = g_steps.NextDue(Steps::Timer);
+        g_flight.Record(Events::TimerTick, tick, g_steps.State(), due == Sched::Never ? 0 : due - now);
 
-            TryExpandVRArray();
-            TryRestoreMaskRotation();
+        if (!g_steps.Done(Steps::MaskRestore) && (tick <= 3 || (tick % 20) == 0)) {
+            Log("Timer tick #%ld: steps=0x%X", tick, g_steps.State());
+        }
 
-            if (g_maskRestored) {
-                Log("4-cascade shadow rendering active (via timer, tick #%ld)", tick);
-            }
-        } else {
-            // v12.0.0: After activation, run extended diagnostics once (after ~5s of gameplay)
-            if (tick > 30) {
-                LogExtendedDiagnostics();
-
-                // Kill timer after diagnostics logged (no longer needed)
-                if (g_extDiagLogged && g_timerHandle) {
-                    DeleteTimerQueueTimer(nullptr, g_timerHandle, nullptr);
-                    g_timerHandle = nullptr;
-                }
-            }
+        if (!g_timerHandle) return;
+        if (due == Sched::Never) {
+            // Nothing left for the timer (no longer needed)
+            Log("Timer stopped after %ld ticks, steps=0x%X", tick, g_steps.State());
+            DeleteTimerQueueTimer(nullptr, g_timerHandle, nullptr);
+            g_timerHandle = nullptr;
+            return;
         }
+
+        uint64_t wait = due > now ? due - now : 0;
+        DWORD delay = (DWORD)(wait < Steps::TimerMinMs ? Steps::TimerMinMs
+                              : wait > Steps::TimerMaxMs ? Steps::TimerMaxMs : wait);
+        ChangeTimerQueueTimer(nullptr, g_timerHandle, delay, delay);
     }
 
-    static void StartExpansionTimer()
+    static bool StartStepTimer()
     {
-        if (g_timerStarted) return;
-        if (!g_maskSafe) return;
-        if (g_maskRestored) return;
-
-        if (InterlockedCompareExchange(&g_timerStarted, 1, 0) != 0) return;
-
         BOOL ok = CreateTimerQueueTimer(
             &g_timerHandle,
             nullptr,
-            ExpansionTimerCallback,
+            StepTimerCallback,
             nullptr,
-            2000,              // 2s initial delay
-            500,               // 500ms polling interval
+            Steps::TimerStartMs,
+            Steps::TimerStartMs,   // re-armed from the callback
             WT_EXECUTEDEFAULT
         );
 
         if (ok) {
-            Log("Expansion timer started (2s delay, 500ms interval)");
+            Log("Step timer started (%u ms delay, re-armed per due step)", Steps::TimerStartMs);
         } else {
             Log("WARN: CreateTimerQueueTimer failed, error %u", GetLastError());
-            InterlockedExchange(&g_timerStarted, 0);
         }
+        return ok != 0;
     }
 
     // =========================================================================
@@ -1726,8 +1744,6 @@ namespace CascadePatch
     // =========================================================================
     static void ClampMask()
     {
-        if (g_maskSafe) return;
-
         __try {
             uintptr_t base = GetModuleBase();
             uint32_t* pMask = reinterpret_cast<uint32_t*>(base + CascadeMaskGlobal);
@@ -1745,6 +1761,34 @@ namespace CascadePatch
     bool Initialize()
     {
         OutputDebugStringA("[VRShadowCascade] DllMain: version.dll proxy loaded\n");
+
+        g_stepsStartMs = GetTickCount64();
+        g_steps.Init(Steps::Table, g_stepHooks, Steps::Count, nullptr);
+
+        // Reserve cave memory while the space around the module is still empty
+        EnsureArena();
+
+        char capturePath[MAX_PATH];
+        g_captureSnapshots = PathNextToExe(capturePath, "VRShadowCascade.capture") &&
+                             GetFileAttributesA(capturePath) != INVALID_FILE_ATTRIBUTES;
+
+        // Map the offset cache now so the first EnsureInitialized() after
+        // SteamStub decryption resolves every site without scanning.
+        // PE headers are not encrypted and are readable this early.
+        DWORD len = GetModuleFileNameA(nullptr, g_cachePath, MAX_PATH);
+        char* lastSlash = strrchr(g_cachePath, '\\');
+        if (len == 0 || len >= MAX_PATH || !lastSlash ||
+            (lastSlash + 1 - g_cachePath) + strlen(OffsetCache::FileName) >= MAX_PATH) {
+            g_cachePath[0] = '\0';
+            return true;
+        }
+        strcpy(lastSlash + 1, OffsetCache::FileName);
+
+        const uint8_t* image = reinterpret_cast<const uint8_t*>(GetModuleBase());
+        g_fingerprintValid = OffsetCache::ComputeFingerprint(image, SIZE_MAX, Sites::Table, Sites::Count, g_fingerprint);
+        if (g_fingerprintValid) {
+            g_cacheStatus = OffsetCache::Load(g_cachePath, g_fingerprint, g_cachedRVAs, Sites::Count);
+        }
         return true;
     }
 
@@ -1753,13 +1797,10 @@ namespace CascadePatch
         // Fast path: once the timer is running, all continuous work is done there.
         // Avoids doing VirtualProtect/memory ops on every version.dll proxy call,
         // which caused timing interference with BackgroundProcessThread NIF loading.
-        if (g_timerStarted) return;
+        if (g_steps.Done(Steps::StartTimer)) return;
 
         // One-time log setup
         if (InterlockedCompareExchange(&g_logInitialized, 1, 0) == 0) {
-            InitializeCriticalSection(&g_logLock);
-            g_logLockReady = true;
-
             char logPath[MAX_PATH];
             GetModuleFileNameA(nullptr, logPath, MAX_PATH);
             char* lastSlash = strrchr(logPath, '\\');
@@ -1767,85 +1808,108 @@ namespace CascadePatch
                 strcpy(lastSlash + 1, "VRShadowCascade.log");
             }
             g_logFile = fopen(logPath, "w");
+            InterlockedExchange(&g_logOpen, 1);
+
+            // Binary diagnostics go next to the log; without it they are dropped
+            bool flightOpen = false;
+            if (lastSlash && (lastSlash + 1 - logPath) + strlen("VRShadowCascade.flight") < MAX_PATH) {
+                strcpy(lastSlash + 1, "VRShadowCascade.flight");
+                flightOpen = g_flight.Open(logPath, FlightRecorder::DefaultCapacity, GetModuleBase());
+            }
+
+            // Lines logged before this point are still in the ring and go first
+            g_logThread = CreateThread(nullptr, 0, LogWriterThread, nullptr, 0, nullptr);
+            if (g_logThread) SetThreadPriority(g_logThread, THREAD_PRIORITY_BELOW_NORMAL);
 
             Log("VR Shadow Cascade Pre-loader v13.4.1 (no .rdata VP: redirect setup to .data distance)");
             Log("Module base: 0x%llX", GetModuleBase());
-        }
-
-        // Force cascade count to 4 (covers window before instruction patches)
-        ForceCascadeCount4();
-
-        // Progression after SteamStub decryption:
-        // 1. Patch MOV instructions to load 4 instead of reading DAT_143924818
-        // 2. Apply mask safe mode (force 0x3)
-        // 3. Patch shader constructor
-        // 4. Expand VR array (when initialized)
-        // 5. Restore full mask rotation (after both arrays have 4 valid entries)
-        CheckTextDecrypted();
-        PatchCountReadSites();
-        ApplyMaskSafeMode();
-        PatchShaderCtor();
-        PatchStereoDispatch();
-        // Write desired shadow distance to .data address (no VirtualProtect needed).
-        // The CMP patch above makes FUN_14290dbd0 read from ShadowDist2Cascade (.data)
-        // instead of ShadowDist4Cascade (.rdata). We set the .data value to 5x original.
-        // Must run AFTER SteamStub decryption — .data values may not be valid before.
-        if (!g_shadowDistPatched && g_textDecrypted) {
-            __try {
-                uintptr_t base = GetModuleBase();
-                float* pDist2 = reinterpret_cast<float*>(base + ShadowDist2Cascade);
-                float origDist2 = *pDist2;
-                if (origDist2 > 0.0f && origDist2 < 1e10f) {
-                    float desiredDist = origDist2 * 5.0f;
-                    *pDist2 = desiredDist;
-                    InterlockedExchange(&g_shadowDistPatched, 1);
-                    Log("Shadow distance: wrote %.1f to .data (was %.1f, no .rdata VP needed)", desiredDist, origDist2);
-                }
+            if (g_arena.Ready()) {
+                Log("Cave arena: 0x%llX (%zu KB, found in %u region queries)",
+                    g_arena.Base(), g_arena.Size() / 1024, g_arena.Queries());
+            } else {
+                Log("WARN: cave arena not reserved yet");
             }
-            __except (EXCEPTION_EXECUTE_HANDLER) {
-                Log("WARN: shadow distance write failed (exception)");
+            if (flightOpen) {
+                Log("Flight recorder: VRShadowCascade.flight (%u events, decode with flight_decode)",
+                    g_flight.Capacity());
+            } else {
+                Log("WARN: flight recorder not available, diagnostics will be dropped");
             }
+            if (g_captureSnapshots) Log("Snapshot capture on (VRShadowCascade.capture found)");
         }
-        TryExpandVRArray();
-        TryRestoreMaskRotation();
-        ClampMask();
 
-        StartExpansionTimer();
+        // Progression (cascade_steps.h), from the exports until the timer starts:
+        // force count -> resolve sites after SteamStub decryption -> one startup
+        // patch batch (count reads, mask safe mode 0x3, shader ctor, stereo
+        // dispatch) -> .data shadow distance -> VR array expansion -> timer.
+        // Flat array, safety caves and the full mask follow when the game is ready.
+        PollSteps(Steps::Export);
+
+        // Mask clamp covers the window before the safe-mode patches are in
+        if (!g_steps.Done(Steps::StartupPatches)) ClampMask();
     }
 
-    void Shutdown()
+    void Shutdown(bool processExit)
     {
         if (g_timerHandle) {
             DeleteTimerQueueTimer(nullptr, g_timerHandle, INVALID_HANDLE_VALUE);
             g_timerHandle = nullptr;
         }
 
-        if (g_logLockReady) {
+        if (g_logOpen) {
             Log("=== Shutdown ===");
-            Log("Count reads patched: %s", g_countReadsPatched ? "YES" : "NO");
-            Log("Mask safe mode: %s", g_maskSafe ? "YES" : "NO");
-            Log("Shader patched: %s", g_shaderPatched ? "YES" : "NO");
-            Log("Stereo dispatch fix: %s", g_stereoFixPatched ? "YES" : "NO");
-            Log("Shadow dist patched: %s", g_shadowDistPatched ? "YES" : "NO");
-            Log("VR expanded: %s", g_vrExpanded ? "YES" : "NO");
+            for (size_t id = 0; id < Steps::Count; id++) {
+                const Sched::StepStats& stats = g_steps.Stats(id);
+                if (g_steps.Done(id)) {
+                    Log("Step %-22s done at %.1f s (%u attempts)", g_steps.Step(id).name,
+                        (stats.doneAtMs - g_stepsStartMs) / 1000.0, stats.probes);
+                } else {
+                    Log("Step %-22s PENDING (%u attempts, %u failed)", g_steps.Step(id).name,
+                        stats.probes, stats.failures);
+                }
+            }
             Log("Entry zero-init patched: %s", g_entryZeroInitPatched ? "YES" : "NO");
             Log("Node alloc patched: %s", g_nodeAllocPatched ? "YES" : "NO");
             Log("Null safety patched: %s", g_nullSafePatched ? "YES" : "NO");
             Log("Ptr validation patched: %s", g_ptrValidationPatched ? "YES" : "NO");
-            Log("Setup scene node fixed: %s", g_setupNodeFixed ? "YES" : "NO");
-            Log("Shader fields forced: %s", g_shaderFieldsForced ? "YES" : "NO");
-            Log("VR entries refreshed: %s", g_vrEntriesRefreshed ? "YES" : "NO");
-            Log("Mask restored: %s", g_maskRestored ? "YES" : "NO");
+            Log("Scene node hook: %s (%ld SetShadowSceneNode calls)", g_sceneNodeHooked ? "YES" : "NO",
+                g_sceneNodeCalls);
+            if (RefreshVREntries) Log("VR entries refreshed: %s", g_vrEntriesRefreshed ? "YES" : "NO");
+            if (g_vrEntryWatch >= 0) {
+                const RegionWatch::Stats& watch = g_watch.GetStats(g_vrEntryWatch);
+                Log("VR entry watch: %u polls, %u unchanged by hash, %u with data changes",
+                    watch.polls, watch.unchanged, watch.changes);
+            }
+            if (g_captureSnapshots) Log("Snapshots captured: setup %s, active %s",
+                                        (g_snapshotsTaken & (1L << CaptureSetup)) ? "YES" : "NO",
+                                        (g_snapshotsTaken & (1L << CaptureActive)) ? "YES" : "NO");
+            Log("Log ring overflows: %llu", (unsigned long long)g_logRing.Overflows());
+            Log("Flight recorder events: %llu", (unsigned long long)g_flight.Recorded());
         }
 
+        // At process exit the writer is already gone, possibly mid-drain, so
+        // this thread takes the ring over. On FreeLibrary it is still running:
+        // it is stopped and waited for before the last drain and the close.
+        // Its handle is not waited on, because a thread cannot finish exiting
+        // while this one holds the loader lock; it signals g_logWriterDone
+        // after its last drain instead.
+        InterlockedExchange(&g_logStop, 1);
+        bool writerStopped = processExit || !g_logThread;
+        for (int i = 0; i < 200 && !writerStopped; i++) {
+            Sleep(LogWriterIntervalMs / 4);
+            writerStopped = g_logWriterDone != 0;
+        }
+        if (g_logThread) {
+            CloseHandle(g_logThread);
+            g_logThread = nullptr;
+        }
+        if (!writerStopped) return;  // never race a live writer; the file is left to the OS
+
+        // Closed to write-through from other threads before the last drain
+        if (InterlockedExchange(&g_logOpen, 0)) g_logRing.Drain(g_logFile, EchoToDebugger, processExit);
         if (g_logFile) {
             fclose(g_logFile);
             g_logFile = nullptr;
         }
-
-        if (g_logLockReady) {
-            DeleteCriticalSection(&g_logLock);
-            g_logLockReady = false;
-        }
     }
 }
@@ -1,6 +1,6 @@
 #pragma once
 
-#include <Windows.h>
+#include <cstddef>
 #include <cstdint>
 
 namespace CascadePatch
@@ -8,6 +8,8 @@ namespace CascadePatch
     // =========================================================================
     // Game offsets (Fallout 4 VR 1.2.72, relative to module base 0x140000000)
     // All verified via Ghidra disassembly
+    // Code sites are resolved at startup through cascade_sites.h; the RVAs
+    // below are the hints checked first and remain exact for 1.2.72.
     // =========================================================================
 
     // Cascade mask global - written each frame by FUN_14284e9e0
@@ -239,8 +241,9 @@ namespace CascadePatch
 
     // Public API
     bool Initialize();        // Called from DllMain - minimal setup only
-    void EnsureInitialized(); // Called from every proxy export
-    void Shutdown();          // Called from DLL_PROCESS_DETACH
+    void EnsureInitialized(); // Called from proxy exports until IsExportSetupDone()
+    bool IsExportSetupDone(); // EnsureInitialized() has nothing left to do
+    void Shutdown(bool processExit);  // Called from DLL_PROCESS_DETACH (lpReserved != NULL: process exit)
 
     void Log(const char* format, ...);
     uintptr_t GetModuleBase();
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "cascade_sites.h"
+#include "patch_engine.h"
+
+// =============================================================================
+// Byte patch table
+// Every fixed code patch the preloader writes, by site, expected bytes and
+// replacement. Entries are queued into a Patch::Batch and applied together, so
+// the SteamStub window costs one protect round-trip per page instead of per site.
+// Code caves are built at runtime; only their entry JMPs go through a batch.
+// =============================================================================
+
+namespace CascadePatch::Patches
+{
+    // Dependency groups: one log summary and one state flag each
+    enum Group : uint8_t
+    {
+        CountReads,
+        SetupCmp,
+        MaskSafe,
+        ShaderCtor,
+        StereoDispatch,
+        MaskRestore,
+        SafetyCaves,    // all-or-nothing: mask restore needs every cave
+        EngineHooks,    // detour entry JMPs (see detour.h)
+    };
+
+    enum class Kind : uint8_t
+    {
+        Bytes,
+        MovRipToImm,    // MOV r32, [RIP+disp32] -> MOV r32, imm32; encoding read from the site
+    };
+
+    struct Desc
+    {
+        const char*  name;
+        Sites::Id    site;
+        Kind         kind;
+        Patch::Bytes expected;
+        Patch::Bytes replacement;
+        Group        group;
+        Sites::Id    xref;      // MovRipToImm: global the MOV must read
+        uint32_t     imm;       // MovRipToImm: value loaded instead
+    };
+
+    constexpr Desc Byte(const char* name, Sites::Id site, uint8_t oldVal, uint8_t newVal, Group group)
+    {
+        Desc d{ name, site, Kind::Bytes, {}, {}, group, site, 0 };
+        d.expected.data[0] = oldVal;
+        d.expected.length = 1;
+        d.replacement.data[0] = newVal;
+        d.replacement.length = 1;
+        return d;
+    }
+
+    constexpr Desc MovImm(const char* name, Sites::Id site, Sites::Id global, uint32_t imm, Group group)
+    {
+        return Desc{ name, site, Kind::MovRipToImm, {}, {}, group, global, imm };
+    }
+
+    // ---- Applied once SteamStub has decrypted .text (Steps 3-5b) ----
+    inline constexpr Desc Startup[] = {
+        // Same order as CountReadPatch::AllSites. The setup read is a CMP and is
+        // reported as a SKIP here; its immediate is patched by the SetupCmp entry.
+        MovImm("ctor read (FUN_1427e8f50)", Sites::CountReadCtor, Sites::CountGlobal,
+               CascadeCountPatch::DesiredValue, CountReads),
+        MovImm("setup read (FUN_14290dbd0)", Sites::CountReadSetup, Sites::CountGlobal,
+               CascadeCountPatch::DesiredValue, CountReads),
+        MovImm("render read 1 (FUN_1428a4a60)", Sites::CountReadRender1, Sites::CountGlobal,
+               CascadeCountPatch::DesiredValue, CountReads),
+        MovImm("render read 2 (FUN_1428a4a60)", Sites::CountReadRender2, Sites::CountGlobal,
+               CascadeCountPatch::DesiredValue, CountReads),
+        Byte("setup CMP imm 2->4 (redirect to .data distance)", Sites::SetupCmpImm,
+             CountReadPatch::SetupCmpOld, CountReadPatch::SetupCmpNew, SetupCmp),
+
+        Byte("initial mask 0xF->0x3", Sites::MaskInit,
+             MaskWriterPatch::InitMask_Old, MaskWriterPatch::InitMask_New, MaskSafe),
+        Byte("fallback mask 0xF->0x3", Sites::MaskFallback,
+             MaskWriterPatch::FallbackMask_Old, MaskWriterPatch::FallbackMask_New, MaskSafe),
+        Byte("array[1] 0x5->0x3", Sites::MaskEntry1,
+             MaskWriterPatch::ArrayEntry1_Old, MaskWriterPatch::ArrayEntry1_New, MaskSafe),
+        Byte("array[3] 0x9->0x3", Sites::MaskEntry3,
+             MaskWriterPatch::ArrayEntry3_Old, MaskWriterPatch::ArrayEntry3_New, MaskSafe),
+
+        Byte("shader array capacity 2->4", Sites::ShaderArrayCap,
+             ShaderCtorPatch::ArrayCap_Old, ShaderCtorPatch::ArrayCap_New, ShaderCtor),
+        Byte("shader stored count 2->4", Sites::ShaderStoredCount,
+             ShaderCtorPatch::StoredCount_Old, ShaderCtorPatch::StoredCount_New, ShaderCtor),
+
+        Byte("stereo fix JZ->JMP at FUN_14281bd40+0xDC", Sites::StereoDispatchJz,
+             StereoDispatchFix::JzOpcode, StereoDispatchFix::JmpOpcode, StereoDispatch),
+    };
+
+    // ---- Full 4-cascade rotation (Step 10, after the safety caves) ----
+    inline constexpr Desc MaskRestoreAll[] = {
+        Byte("initial mask 0x3->0xF", Sites::MaskInit, 0x03, 0x0F, MaskRestore),
+        Byte("fallback mask 0x3->0xF", Sites::MaskFallback, 0x03, 0x0F, MaskRestore),
+        Byte("array[1] 0x3->0xF", Sites::MaskEntry1, 0x03, 0x0F, MaskRestore),
+        Byte("array[3] 0x3->0xF", Sites::MaskEntry3, 0x03, 0x0F, MaskRestore),
+    };
+
+    static_assert(sizeof(Startup) / sizeof(Startup[0]) <= Patch::MaxWrites, "startup batch too large");
+}
@@ -0,0 +1,92 @@
+#include "cascade_schedule.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace CascadePatch
+{
+    void CascadeScheduler::Configure(const CascadeScheduleConfig& config)
+    {
+        if (_configured && config == _config) return;
+        bool reset = !_configured || config.mode != _config.mode;
+        if (!_configured || config.levelCostMs != _config.levelCostMs) {
+            std::fill(std::begin(_cost), std::end(_cost), std::max(config.levelCostMs, 0.0f));
+        }
+        _config = config;
+        _configured = true;
+        if (!reset) return;
+
+        _windowFrames = 0;
+        _windowUs = 0;
+        _changedFrom = -1;
+        switch (config.mode) {
+        case CascadeSchedule::Original:
+            _level = -1;
+            _pattern = MaskOriginal;
+            break;
+        case CascadeSchedule::FarHalf:    SetLevel(2); break;
+        case CascadeSchedule::FarQuarter: SetLevel(3); break;
+        default:                          SetLevel(0); break;
+        }
+    }
+
+    void CascadeScheduler::SetLevel(int level)
+    {
+        _level = level;
+        _pattern = MaskLadder[level];
+        _windowsAtLevel = 0;
+    }
+
+    // The first full window after a change against the last one before it
+    void CascadeScheduler::Learn(float meanMs)
+    {
+        int low = std::min(_changedFrom, _level);
+        float saved = _changedFrom < _level ? _beforeMs - meanMs : meanMs - _beforeMs;
+        saved = std::clamp(saved, 0.0f, _config.budgetMs);
+        _cost[low] += 0.5f * (saved - _cost[low]);
+        _changedFrom = -1;
+    }
+
+    bool CascadeScheduler::Frame(uint32_t frameUs)
+    {
+        if (!_configured) Configure(_config);
+        _counters.frames++;
+        if (_level >= 0) _counters.framesAt[_level]++;
+        if (_config.mode != CascadeSchedule::Adaptive) return false;
+
+        // A loading hitch is not a cost the mask can buy back
+        _windowUs += std::min<uint64_t>(frameUs, static_cast<uint64_t>(_config.budgetMs * 2000.0f));
+        uint32_t window = (std::max(_config.windowFrames, 4u) + 3) & ~3u;
+        if (++_windowFrames < window) return false;
+
+        float meanMs = static_cast<float>(_windowUs) / 1000.0f / static_cast<float>(_windowFrames);
+        _windowFrames = 0;
+        _windowUs = 0;
+        _lastMeanMs = meanMs;
+        _counters.windows++;
+        if (_changedFrom >= 0) Learn(meanMs);
+        _windowsAtLevel++;
+
+        int from = _level;
+        float headroom = _config.budgetMs - meanMs;
+        if (!_config.adapt) {
+            if (_level == 0) return false;
+            SetLevel(0);
+            _counters.raises++;
+            return true;
+        }
+        if (headroom < _config.dropHeadroomMs && _level + 1 < static_cast<int>(MaskLevels)) {
+            SetLevel(_level + 1);
+            _counters.drops++;
+        } else if (_level > 0 && _windowsAtLevel >= _config.minWindows &&
+                   headroom - _cost[_level - 1] >= _config.raiseHeadroomMs) {
+            SetLevel(_level - 1);
+            _counters.raises++;
+        } else {
+            return false;
+        }
+        _changedFrom = from;
+        _beforeMs = meanMs;
+        return true;
+    }
+}
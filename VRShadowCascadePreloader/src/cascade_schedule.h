@@ -0,0 +1,123 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Cascade mask scheduler
+// The game's mask writer (FUN_14284e9e0) picks the frame's cascade mask from a
+// 4-entry rotation. Four code immediates set it: slot 0 and 2 share the
+// initial/fallback pair, and slots 1 and 3 have one each (cascade_patch.h
+// MaskWriterPatch). The preloader restores all four to 0xF, so every frame
+// renders every cascade in both eyes. The scheduler picks the rotation
+// instead. The near cascades (bits 0 and 1) stay in every slot; the far ones
+// (bits 2 and 3) drop to 3, 2 or 1 frames in 4 as the ladder goes down.
+// Adaptive mode decides once per window of frames from the mean frame time
+// against the budget, with hitches clipped at twice the budget. With too little headroom it goes one level cheaper.
+// It goes one level richer only when the headroom minus that level's cost
+// still leaves the raise margin, and only after a minimum time at the current
+// level. Each level's cost starts at a guess and is learned from the windows
+// on either side of every change, so a raise that did not fit is not retried
+// at the same headroom. The fixed modes are a single rotation: everything,
+// the game's original {0xF,0x5,0xF,0x9}, or a ladder level.
+// Pure logic on frame times; the plugin owns the code patch.
+// tools/mask_sched_sim runs it on synthetic and recorded traces.
+// =============================================================================
+
+namespace CascadePatch
+{
+    // Mask per rotation slot; slots 0 and 2 must match (one immediate pair)
+    struct MaskPattern
+    {
+        uint8_t slot[4];
+
+        uint8_t ForFrame(uint64_t frame) const { return slot[frame & 3]; }
+        bool operator==(const MaskPattern&) const = default;
+    };
+
+    constexpr size_t MaskLevels = 4;
+
+    // Level 0 renders everything; each level down halves the far cascades' rate
+    // a little more (4, 3, 2, 1 frames in 4), alternating cascade 2 and 3
+    inline constexpr MaskPattern MaskLadder[MaskLevels] = {
+        { { 0xF, 0xF, 0xF, 0xF } },
+        { { 0xF, 0x7, 0xF, 0xB } },
+        { { 0x7, 0xB, 0x7, 0xB } },
+        { { 0x3, 0x7, 0x3, 0xB } },
+    };
+
+    // The game's own rotation (cascade 1 skipped on slots 1 and 3)
+    inline constexpr MaskPattern MaskOriginal = { { 0xF, 0x5, 0xF, 0x9 } };
+
+    // Values match the plugin's iCascadeSchedule
+    enum class CascadeSchedule : int32_t
+    {
+        All        = 0,  // 0xF every frame (the preloader's restore)
+        Adaptive   = 1,  // ladder level from the frame-time headroom
+        Original   = 2,  // {0xF,0x5,0xF,0x9}
+        FarHalf    = 3,  // ladder level 2
+        FarQuarter = 4,  // ladder level 3
+    };
+
+    struct CascadeScheduleConfig
+    {
+        CascadeSchedule mode = CascadeSchedule::Adaptive;
+        bool     adapt = true;            // false holds Adaptive at level 0 (bAutoAdjust off)
+        float    budgetMs = 1000.0f / 90.0f;
+        uint32_t windowFrames = 48;       // frames per decision, rounded up to whole rotations
+        float    dropHeadroomMs = 0.3f;   // less headroom than this: one level cheaper
+        float    raiseHeadroomMs = 1.0f;  // headroom left after the richer level's cost to raise
+        uint32_t minWindows = 4;          // windows at a level before raising again
+        float    levelCostMs = 0.5f;      // first guess of the ms between two levels
+
+        bool operator==(const CascadeScheduleConfig&) const = default;
+    };
+
+    class CascadeScheduler
+    {
+    public:
+        struct Counters
+        {
+            uint64_t frames = 0;
+            uint64_t windows = 0;
+            uint64_t drops = 0;           // level changes to a cheaper pattern
+            uint64_t raises = 0;
+            uint64_t framesAt[MaskLevels] = {};
+        };
+
+        // A changed mode resets to its pattern (Adaptive starts at level 0);
+        // other changes apply from the next window
+        void Configure(const CascadeScheduleConfig& config);
+
+        // One rendered frame; true when Pattern() changed with it
+        bool Frame(uint32_t frameUs);
+
+        const MaskPattern& Pattern() const { return _pattern; }
+        int Level() const { return _level; }           // -1 for the Original rotation
+        float LevelCost(int level) const { return _cost[level]; }
+        float LastMeanMs() const { return _lastMeanMs; }
+        const CascadeScheduleConfig& Config() const { return _config; }
+        const Counters& Stats() const { return _counters; }
+
+    private:
+        void SetLevel(int level);
+        void Learn(float meanMs);
+
+        CascadeScheduleConfig _config;
+        bool        _configured = false;
+        MaskPattern _pattern = MaskLadder[0];
+        int         _level = 0;
+        float       _cost[MaskLevels - 1] = {};   // ms saved going from level i to i + 1
+
+        uint32_t _windowFrames = 0;
+        uint64_t _windowUs = 0;
+        uint32_t _windowsAtLevel = 0;
+        float    _lastMeanMs = 0.0f;
+
+        // The change being measured: the window mean before it and the level it left
+        int      _changedFrom = -1;
+        float    _beforeMs = 0.0f;
+
+        Counters _counters;
+    };
+}
@@ -0,0 +1,191 @@
+#pragma once
+
+#include "cascade_patch.h"
+#include "sig_scan.h"
+#include "x64_decode.h"
+
+// =============================================================================
+// Patch site table
+// Every code site patched by the preloader, described by the bytes the patch
+// already verifies. The RVAs in cascade_patch.h are kept as hints: on 1.2.72
+// each site resolves from its hint with a single compare, and only a changed
+// exe falls back to scanning .text.
+// Intra-function distances (shader ctor, mask writer) are encoded as wildcard
+// runs so those sites move together with their function.
+// =============================================================================
+
+namespace CascadePatch::Sites
+{
+    using SigScan::Sig;
+    using SigScan::Data;
+    using SigScan::Derived;
+    using SigScan::BranchTarget;
+
+    enum Id : uint8_t
+    {
+        CountGlobal,
+
+        CountReadCtor,
+        CountReadRender1,
+        CountReadRender2,
+        CountReadSetup,
+        SetupCmpImm,
+
+        ShaderArrayCap,
+        ShaderStoredCount,
+
+        MaskInit,
+        MaskFallback,
+        MaskEntry1,
+        MaskEntry3,
+
+        StereoDispatchJz,
+        NullSafetyCrash,
+        NodeAllocFunc,
+
+        EntryZeroInitTagWrite,
+        EntryZeroInitReturn,
+
+        PtrValidationTest,
+        PtrValidationSkip,
+        PtrValidationContinue,
+
+        Count
+    };
+
+    // MOV r32, [rip+disp32] / CMP dword [rip+disp32], imm8 reading DAT_143924818
+    constexpr const char* CountReadMov = "8B 05/C7 [4]";
+    constexpr const char* CountReadCmp = "83 3D [4] 02";
+
+    // FUN_1427c33d0 entry .. MOV EDX,2 (+0x3B) .. MOV dword [RBX+0x1D8],2 (+0x102)
+    constexpr const char* ShaderCtor =
+        "48 89 5C 24 08 [54] BA 02 00 00 00 [194] C7 83 D8 01 00 00 02 00 00 00";
+
+    // FUN_14284e9e0 mask immediates {0xF init, 0xF fallback, 0x5 array[1], 0x9 array[3]}
+    constexpr const char* MaskWriter = "0F [60] 0F [19] 05 [18] 09";
+
+    inline constexpr SigScan::Signature Table[] = {
+        Data("cascade count global", CascadeCountPatch::CountGlobal),
+
+        Sig("ctor read (FUN_1427e8f50)", CountReadMov, CountReadPatch::CtorRead)
+            .Xref(CountGlobal, 2, 6).Nth(0, 3).WithFlags(SigScan::OptionalRex),
+        Sig("render read 1 (FUN_1428a4a60)", CountReadMov, CountReadPatch::RenderRead1)
+            .Xref(CountGlobal, 2, 6).Nth(1, 3).WithFlags(SigScan::OptionalRex),
+        Sig("render read 2 (FUN_1428a4a60)", CountReadMov, CountReadPatch::RenderRead2)
+            .Xref(CountGlobal, 2, 6).Nth(2, 3).WithFlags(SigScan::OptionalRex),
+        Sig("setup read (FUN_14290dbd0)", CountReadCmp, CountReadPatch::SetupRead)
+            .Xref(CountGlobal, 2, 7),
+        Derived("setup CMP imm", CountReadSetup, CountReadPatch::SetupCmpImm, 6),
+
+        Sig("shader array capacity", ShaderCtor, ShaderCtorPatch::ArrayCap_Byte, 0x3C),
+        Sig("shader stored count", ShaderCtor, ShaderCtorPatch::StoredCount_Byte, 0x108),
+
+        Sig("initial mask", MaskWriter, MaskWriterPatch::InitMask_Byte, 0),
+        Sig("fallback mask", MaskWriter, MaskWriterPatch::FallbackMask_Byte, 61),
+        Sig("mask array[1]", MaskWriter, MaskWriterPatch::ArrayEntry1_Byte, 81),
+        Sig("mask array[3]", MaskWriter, MaskWriterPatch::ArrayEntry3_Byte, 100),
+
+        // A lone JZ rel8 cannot be scanned for; it resolves from the hint only
+        Sig("stereo dispatch JZ", "74 ??", StereoDispatchFix::JzInstrRVA)
+            .WithFlags(SigScan::HintOnly),
+
+        Sig("null safety (mov rbp,[r10+0x180])", "49 8B AA 80 01 00 00", NullSafetyPatch::CrashInstrRVA),
+        Sig("node alloc prologue", "48 83 EC 68 4D 8B D1", NodeAllocPatch::FuncRVA),
+
+        Sig("entry zero-init tag write", "4A 89 94 10 90 00 00 00", CascadeEntryZeroInit::TagWriteRVA),
+        Derived("entry zero-init return", EntryZeroInitTagWrite, CascadeEntryZeroInit::ReturnRVA,
+                static_cast<int32_t>(CascadeEntryZeroInit::InstrSize)),
+
+        Sig("ptr validation test/jz", "4D 85 F6 0F 84 8A 00 00 00", CascadePtrValidation::TestInstrRVA),
+        BranchTarget("ptr validation skip target", PtrValidationTest, CascadePtrValidation::SkipTargetRVA, 5, 9),
+        Derived("ptr validation continue", PtrValidationTest, CascadePtrValidation::ContinueRVA,
+                static_cast<int32_t>(CascadePtrValidation::PatchSize)),
+    };
+
+    static_assert(sizeof(Table) / sizeof(Table[0]) == Count, "site table out of sync with Sites::Id");
+    static_assert(SigScan::AllValid(Table), "invalid pattern or forward reference in site table");
+
+    // ---- Instruction boundaries ----
+    // Entry of the function holding each code site (1.2.72). Decoding from
+    // the entry must reach the site as an instruction start, or find the
+    // patched byte inside an immediate, before anything is written there.
+    struct SiteFunction
+    {
+        Id             site;
+        uintptr_t      entryRVA;
+        X64::Boundary  kind;
+    };
+
+    inline constexpr SiteFunction Functions[] = {
+        { CountReadCtor,         0x27e8f50, X64::Boundary::Start },   // FUN_1427e8f50
+        { CountReadRender1,      0x28a4a60, X64::Boundary::Start },   // FUN_1428a4a60
+        { CountReadRender2,      0x28a4a60, X64::Boundary::Start },
+        { CountReadSetup,        0x290dbd0, X64::Boundary::Start },   // FUN_14290dbd0
+        { SetupCmpImm,           0x290dbd0, X64::Boundary::Imm },
+        { ShaderArrayCap,        TextSentinel, X64::Boundary::Imm },  // FUN_1427c33d0
+        { ShaderStoredCount,     TextSentinel, X64::Boundary::Imm },
+        { MaskInit,              0x284e9e0, X64::Boundary::Imm },     // FUN_14284e9e0
+        { MaskFallback,          0x284e9e0, X64::Boundary::Imm },
+        { MaskEntry1,            0x284e9e0, X64::Boundary::Imm },
+        { MaskEntry3,            0x284e9e0, X64::Boundary::Imm },
+        { StereoDispatchJz,      0x281bd40, X64::Boundary::Start },   // FUN_14281bd40
+        { NullSafetyCrash,       0x2813740, X64::Boundary::Start },   // FUN_142813740
+        { NodeAllocFunc,         NodeAllocPatch::FuncRVA, X64::Boundary::Start },
+        { EntryZeroInitTagWrite, 0x27a51e0, X64::Boundary::Start },   // FUN_1427a51e0
+        { EntryZeroInitReturn,   0x27a51e0, X64::Boundary::Start },
+        { PtrValidationTest,     0x27a3f90, X64::Boundary::Start },   // FUN_1427a3f90
+        { PtrValidationSkip,     0x27a3f90, X64::Boundary::Start },
+        { PtrValidationContinue, 0x27a3f90, X64::Boundary::Start },
+    };
+
+    // Function entry for a site that resolved at `rva`; the site keeps its
+    // 1.2.72 distance from the entry
+    constexpr uintptr_t FunctionEntry(const SiteFunction& f, uintptr_t rva)
+    {
+        return rva - (Table[f.site].hintRVA - f.entryRVA);
+    }
+
+    // Longest function walk Locate() is given
+    constexpr size_t MaxFunctionWalk = 0x4000;
+
+    constexpr bool FunctionsValid()
+    {
+        for (const SiteFunction& f : Functions) {
+            uintptr_t hint = Table[f.site].hintRVA;
+            if (f.site >= Count || hint < f.entryRVA || hint - f.entryRVA >= MaxFunctionWalk) return false;
+        }
+        return true;
+    }
+    static_assert(FunctionsValid(), "site function entry missing or too far from its site");
+
+    constexpr size_t FunctionCount = sizeof(Functions) / sizeof(Functions[0]);
+
+    // Locate() for every resolved site of a mapped image; out[i] stays !ok
+    // for unresolved sites. Returns the number of resolved sites that failed.
+    inline uint32_t CheckBoundaries(const uint8_t* image, const PE::Section& text,
+                                    const SigScan::Resolution* results, X64::Location* out)
+    {
+        uint32_t failed = 0;
+        uintptr_t textEnd = text.rva + text.virtualSize;
+        for (size_t i = 0; i < FunctionCount; i++) {
+            const SiteFunction& f = Functions[i];
+            uintptr_t rva = results[f.site].rva;
+            out[i] = X64::Location{};
+            if (!rva) continue;
+
+            uintptr_t entry = FunctionEntry(f, rva);
+            if (entry < text.rva || rva >= textEnd) {
+                failed++;
+                continue;
+            }
+            size_t avail = textEnd - entry;
+            if (avail > MaxFunctionWalk + X64::MaxInstructionLength) avail = MaxFunctionWalk + X64::MaxInstructionLength;
+            out[i] = X64::Locate(image + entry, avail, rva - entry, f.kind);
+            if (!out[i].ok) failed++;
+        }
+        return failed;
+    }
+
+    // Same order as CountReadPatch::AllSites
+    constexpr Id CountReadSites[] = { CountReadCtor, CountReadSetup, CountReadRender1, CountReadRender2 };
+}
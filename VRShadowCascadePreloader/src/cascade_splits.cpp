@@ -0,0 +1,61 @@
+#include "cascade_splits.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace CascadePatch
+{
+    CascadeSplits ComputeSplits(const SplitScheme& scheme, float far)
+    {
+        CascadeSplits s;
+        s.count = std::clamp<uint32_t>(scheme.count, 1, MaxCascades);
+        float n = std::max(scheme.nearDist, 1.0f);
+        float f = std::max(far, 2.0f * n);
+        float lambda = std::clamp(scheme.lambda, 0.0f, 1.0f);
+        for (uint32_t i = 0; i <= s.count; i++) {
+            float t = static_cast<float>(i) / static_cast<float>(s.count);
+            float logSplit = n * std::pow(f / n, t);
+            float uniSplit = n + (f - n) * t;
+            s.split[i] = lambda * logSplit + (1.0f - lambda) * uniSplit;
+        }
+        // Exact ends, whatever pow() rounded to
+        s.split[0] = n;
+        s.split[s.count] = f;
+        return s;
+    }
+
+    float RangeForNearPair(const SplitScheme& scheme, float nearPairEnd)
+    {
+        uint32_t count = std::clamp<uint32_t>(scheme.count, 1, MaxCascades);
+        uint32_t half = count / 2;
+        float n = std::max(scheme.nearDist, 1.0f);
+        if (half == 0) return std::max(nearPairEnd, 2.0f * n);
+
+        // split[half] grows with far: double until it is past, then bisect
+        float lo = std::max(nearPairEnd, 2.0f * n);
+        float hi = lo;
+        for (int i = 0; i < 64 && ComputeSplits(scheme, hi).split[half] < nearPairEnd; i++) hi *= 2.0f;
+        for (int i = 0; i < 48; i++) {
+            float mid = 0.5f * (lo + hi);
+            if (ComputeSplits(scheme, mid).split[half] < nearPairEnd) lo = mid;
+            else hi = mid;
+        }
+        return hi;
+    }
+
+    float CascadeSpan(float start, float end, float tanHalfFov, float aspect)
+    {
+        // Corners of a slice at depth z are z * k off the view axis
+        float k2 = tanHalfFov * tanHalfFov * (1.0f + aspect * aspect);
+        // Center on the axis equidistant from the near and far corners,
+        // or the far cap's center when that lies beyond the slice
+        float center = std::min(0.5f * (start + end) * (1.0f + k2), end);
+        float dz = end - center;
+        return 2.0f * std::sqrt(dz * dz + end * end * k2);
+    }
+
+    float TexelDensity(const CascadeSplits& splits, uint32_t i, float tanHalfFov, float aspect, uint32_t resolution)
+    {
+        return static_cast<float>(resolution) / CascadeSpan(splits.Start(i), splits.End(i), tanHalfFov, aspect);
+    }
+}
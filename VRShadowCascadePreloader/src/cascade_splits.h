@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Cascade split scheme
+// Where each shadow cascade starts and ends along the view direction. The
+// practical split scheme blends the two classic layouts with a weight lambda:
+//   split_i = lambda * near * (far / near)^(i / N)
+//           + (1 - lambda) * (near + (far - near) * i / N)
+// Lambda 1 is the logarithmic layout. Each cascade is a fixed factor deeper
+// than the one before it, so shadow texels per screen pixel are about equal
+// everywhere. Lambda 0 is the uniform layout. Every cascade is equally deep,
+// so the near cascade spans as much as the far ones and is blurry. Texel
+// density is the shadow map resolution over the world span one cascade's map
+// covers: the diameter of the sphere around its slice of the view frustum,
+// as stable cascades fit it.
+// The renderer reads a single range from ShadowDist2Cascade (.data) and lays
+// its cascades out inside it; the old value was 5x the game's 2-cascade range.
+// RangeForNearPair() picks the range instead. The near pair of the four
+// cascades ends where the game's two cascades ended, so nothing close gets
+// blurrier, and lambda decides how far cascades 2 and 3 reach. The plugin
+// refits it with its own scheme and caps it at the shadow distance it
+// drives. Past that nothing casts a shadow, so cascades stretched further
+// only waste texels.
+// tools/split_check checks the layouts and the texel density per cascade.
+// =============================================================================
+
+namespace CascadePatch
+{
+    constexpr uint32_t MaxCascades = 4;
+
+    // Game's 2-cascade range (ShadowDist2Cascade) when it cannot be read
+    constexpr float DefaultTwoCascadeRange = 3000.0f;
+
+    struct SplitScheme
+    {
+        uint32_t count = 4;
+        float    nearDist = 64.0f;     // where cascade 0 starts (game units, ~1 m)
+        float    lambda = 0.75f;       // 1 = logarithmic, 0 = uniform
+
+        bool operator==(const SplitScheme&) const = default;
+    };
+
+    struct CascadeSplits
+    {
+        uint32_t count = 0;
+        float    split[MaxCascades + 1] = {};   // split[0] = near, split[count] = far
+
+        float Start(uint32_t i) const { return split[i]; }
+        float End(uint32_t i) const { return split[i + 1]; }
+    };
+
+    // Splits of [scheme.nearDist, far]; count is clamped to [1, MaxCascades]
+    // and far to at least twice the near distance
+    CascadeSplits ComputeSplits(const SplitScheme& scheme, float far);
+
+    // The far distance whose split at count / 2 (the end of the near half)
+    // lands on `nearPairEnd`
+    float RangeForNearPair(const SplitScheme& scheme, float nearPairEnd);
+
+    // Diameter of the sphere around the frustum slice [start, end];
+    // tanHalfFov is vertical, aspect is width over height
+    float CascadeSpan(float start, float end, float tanHalfFov, float aspect);
+
+    // Shadow map texels per game unit in cascade i
+    float TexelDensity(const CascadeSplits& splits, uint32_t i, float tanHalfFov, float aspect, uint32_t resolution);
+}
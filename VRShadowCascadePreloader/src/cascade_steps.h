@@ -0,0 +1,86 @@
+#pragma once
+
+#include "step_scheduler.h"
+
+// =============================================================================
+// Preloader staging graph (see step_scheduler.h)
+// Order follows the old EnsureInitialized() ladder. Export-lane steps are
+// polled from version.dll exports until the timer takes over; they probe on
+// every call (zero backoff) because exports arrive sporadically during
+// startup. Everything after that is timer-driven and backs off while the
+// game is still loading. Once the SetShadowSceneNode detour is in, the
+// scene node chain is also polled from the detour the moment the engine
+// sets the node, and the timer no longer probes for it. tools/sched_sim runs
+// this table against a simulated game.
+// =============================================================================
+
+namespace CascadePatch::Steps
+{
+    enum Id : uint8_t
+    {
+        ForceCount,         // DAT_143924818 = 4
+        ResolveSites,       // SteamStub decrypted, patch sites resolved
+        StartupPatches,     // count reads, mask safe mode, shader ctor (+ stereo)
+        StereoDispatch,     // retried alone if it failed in the startup batch
+        ShadowDistance,     // 4-cascade distance written to .data
+        ExpandVRArray,      // VR cascade array 2 -> 4 entries
+        StartTimer,         // hands polling from the exports to the timer
+        SceneNodeHook,      // detour on BSShaderManager::SetShadowSceneNode
+        SetupSceneNode,     // DAT_146885d40 = render scene node
+        CascadeGroups,      // cascade_group+0x173 = 1 on both groups
+        ShaderFields,       // ISCopy shader count/capacity fields = 4
+        FlatArrayReady,     // 4 flat entries with shadow maps
+        SafetyCaves,        // the four code caves live
+        MaskRestore,        // full 4-cascade mask: fully active
+        ExtendedDiagnostics,
+        Count
+    };
+
+    // Poll() lanes
+    enum Lane : uint8_t
+    {
+        Export = 1,
+        Timer  = 2,
+        Hook   = 4,     // from the SetShadowSceneNode detour, right after the engine sets a node
+    };
+    inline constexpr uint8_t AnyLane = Export | Timer | Hook;
+    inline constexpr uint8_t NodeLanes = Timer | Hook;    // steps that wait on the scene node
+
+    using Sched::Bit;
+
+    inline constexpr Sched::StepDesc Table[] = {
+        // name                 after                                                   lanes    delay  backoff
+        { "force_count",        0,                                                      AnyLane, 0,     100, 2000 },
+        { "resolve_sites",      0,                                                      Export,  0,     0,   0 },
+        { "startup_patches",    Bit(ResolveSites),                                      Export,  0,     0,   0 },
+        { "stereo_dispatch",    Bit(StartupPatches),                                    AnyLane, 0,     500, 8000 },
+        { "shadow_distance",    Bit(ResolveSites),                                      AnyLane, 0,     100, 2000 },
+        { "expand_vr_array",    0,                                                      AnyLane, 0,     100, 2000 },
+        { "start_timer",        Bit(StartupPatches),                                    Export,  0,     0,   0 },
+        { "scene_node_hook",    Bit(StartupPatches),                                    AnyLane, 0,     0,   0 },
+        { "setup_scene_node",   Bit(SceneNodeHook),                                     NodeLanes, 0,   100, 2000 },
+        { "cascade_groups",     Bit(SetupSceneNode),                                    NodeLanes, 0,   100, 2000 },
+        { "shader_fields",      Bit(SetupSceneNode),                                    NodeLanes, 0,   100, 2000 },
+        { "flat_array_ready",   Bit(StartupPatches) | Bit(ExpandVRArray),               AnyLane, 0,     100, 2000 },
+        { "safety_caves",       Bit(FlatArrayReady),                                    AnyLane, 0,     100, 4000 },
+        { "mask_restore",       Bit(SafetyCaves),                                       AnyLane, 0,     100, 4000 },
+        { "extended_diagnostics", Bit(MaskRestore) | Bit(CascadeGroups) | Bit(ShaderFields), Timer, 5000, 100, 2000 },
+    };
+    static_assert(sizeof(Table) / sizeof(Table[0]) == Count);
+
+    // Steps listed after their prerequisites, so one Poll() can finish a chain
+    constexpr bool Ordered()
+    {
+        for (size_t i = 0; i < Count; i++) {
+            if (Table[i].after >> i) return false;
+        }
+        return true;
+    }
+    static_assert(Ordered());
+
+    // First timer callback after StartTimer, then the interval bounds used
+    // when the timer is re-armed for the next due step
+    inline constexpr uint32_t TimerStartMs   = 2000;
+    inline constexpr uint32_t TimerMinMs     = 50;
+    inline constexpr uint32_t TimerMaxMs     = 8000;
+}
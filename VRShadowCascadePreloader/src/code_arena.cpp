@@ -0,0 +1,97 @@
+#include "code_arena.h"
+
+namespace CascadePatch
+{
+    bool CodeArena::Init(uintptr_t moduleBase, size_t moduleSize, size_t size)
+    {
+        int state = Empty;
+        if (!_state.compare_exchange_strong(state, Reserving, std::memory_order_acq_rel)) {
+            while (state == Reserving) state = _state.load(std::memory_order_acquire);
+            if (state == Reserved) return true;
+            return false;
+        }
+
+        const size_t granularity = OS::AllocationGranularity();
+        size = AlignUp(size, granularity);
+
+        OS::AddressMap map;
+        if (!map.Refresh()) {
+            _state.store(Empty, std::memory_order_release);
+            return false;
+        }
+
+        // A range can be taken between the query and the reservation; walk
+        // again from a fresh view a few times before giving up
+        void* p = nullptr;
+        uint32_t total = 0;
+        for (int attempt = 0; attempt < 4 && !p; attempt++) {
+            uintptr_t addr = 0;
+            uint32_t queries = 0;
+            bool found = FindFreeNear([&](uintptr_t a, OS::Region& r) { return map.Query(a, r); },
+                                      moduleBase, moduleBase + moduleSize, size, granularity, addr, &queries);
+            total += queries;
+            if (!found) break;
+            p = OS::MapAt(addr, size);
+            if (!p) map.Refresh();
+        }
+
+        if (!p) {
+            _queries = total;
+            _state.store(Empty, std::memory_order_release);
+            return false;
+        }
+
+        _base = reinterpret_cast<uintptr_t>(p);
+        _size = size;
+        _queries = total;
+        _cursor.store(static_cast<uint64_t>(size) << 32, std::memory_order_relaxed);
+        _state.store(Reserved, std::memory_order_release);
+        return true;
+    }
+
+    void* CodeArena::Alloc(size_t size, size_t align, bool fromTop)
+    {
+        if (!Ready() || size == 0 || align == 0 || (align & (align - 1))) return nullptr;
+
+        uint64_t cur = _cursor.load(std::memory_order_relaxed);
+        for (;;) {
+            uint64_t codeTop = cur & 0xFFFFFFFF;
+            uint64_t dataBottom = cur >> 32;
+            uint64_t next;
+            uintptr_t result;
+
+            if (fromTop) {
+                if (dataBottom < size) return nullptr;
+                uint64_t start = AlignDown(static_cast<uintptr_t>(dataBottom - size), align);
+                if (start < codeTop) return nullptr;
+                next = (start << 32) | codeTop;
+                result = _base + static_cast<uintptr_t>(start);
+            } else {
+                uint64_t start = AlignUp(static_cast<uintptr_t>(codeTop), align);
+                if (start + size > dataBottom) return nullptr;
+                next = (dataBottom << 32) | (start + size);
+                result = _base + static_cast<uintptr_t>(start);
+            }
+
+            if (_cursor.compare_exchange_weak(cur, next, std::memory_order_acq_rel)) {
+                return reinterpret_cast<void*>(result);
+            }
+        }
+    }
+
+    void* CodeArena::AllocCode(size_t size)
+    {
+        return Alloc(size, CodeAlign, false);
+    }
+
+    void* CodeArena::AllocData(size_t size, size_t align)
+    {
+        return Alloc(size, align, true);
+    }
+
+    size_t CodeArena::Used() const
+    {
+        uint64_t cur = _cursor.load(std::memory_order_relaxed);
+        return static_cast<size_t>((cur & 0xFFFFFFFF) + (_size - (cur >> 32)));
+    }
+}
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "os_memory.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Code cave arena
+// One region reserved next to the game module, from which caves (executable,
+// must be within rel32 of their sites) and patch-owned data are carved. The
+// region is found by walking the free ranges of the address space instead of
+// probing one allocation granule at a time, and it is reserved once, so four
+// ~50-byte caves no longer cost four 64 KB reservations.
+// =============================================================================
+
+namespace CascadePatch
+{
+    // Keep a 64 KB margin inside the ±2 GB a rel32 can reach
+    constexpr uint64_t Rel32Reach = 0x7FFF0000;
+
+    constexpr uintptr_t AlignUp(uintptr_t v, size_t a) { return (v + a - 1) & ~(uintptr_t)(a - 1); }
+    constexpr uintptr_t AlignDown(uintptr_t v, size_t a) { return v & ~(uintptr_t)(a - 1); }
+
+    // Finds the granularity-aligned free range of `size` bytes closest to
+    // [lo, hi) such that a rel32 anywhere in [lo, hi) reaches all of it.
+    // `query(addr, OS::Region&)` describes the region containing addr, the
+    // same contract as VirtualQuery: a free region spans the whole gap.
+    // `queries` (optional) receives the number of query calls made.
+    template <typename Query>
+    bool FindFreeNear(Query&& query, uintptr_t lo, uintptr_t hi, size_t size, size_t granularity,
+                      uintptr_t& out, uint32_t* queries = nullptr)
+    {
+        uint32_t calls = 0;
+        uintptr_t up = 0, down = 0;
+        OS::Region r;
+
+        // Above the image
+        for (uintptr_t addr = AlignUp(hi, granularity); addr + size - lo <= Rel32Reach;) {
+            calls++;
+            if (!query(addr, r)) break;
+            uintptr_t end = r.base + r.size;
+            if (r.free) {
+                uintptr_t c = AlignUp(addr > r.base ? addr : r.base, granularity);
+                if (c + size <= end && c + size - lo <= Rel32Reach) {
+                    up = c;
+                    break;
+                }
+            }
+            if (end <= addr) break;
+            addr = end;
+        }
+
+        // Below the image. Each step asks about the highest aligned candidate
+        // under `addr`; a free region reported from there up (VirtualQuery
+        // starts free regions at the queried page) settles it.
+        for (uintptr_t addr = AlignDown(lo, granularity); addr >= size + granularity;) {
+            uintptr_t c = AlignDown(addr - size, granularity);
+            if (hi - c > Rel32Reach) break;
+            calls++;
+            if (!query(c, r)) break;
+            uintptr_t end = r.base + r.size;
+            if (r.free && end >= c + size) {
+                down = c;
+                break;
+            }
+            uintptr_t next = r.free ? end : r.base;  // below whatever is in the way
+            if (next >= addr) break;
+            addr = next;
+        }
+
+        if (queries) *queries = calls;
+        if (!up && !down) return false;
+        if (up && down) out = (up - hi <= lo - (down + size)) ? up : down;
+        else out = up ? up : down;
+        return true;
+    }
+
+    class CodeArena
+    {
+    public:
+        static constexpr size_t DefaultSize = 64 * 1024;
+        static constexpr size_t CodeAlign   = 16;
+
+        CodeArena() = default;
+        CodeArena(const CodeArena&) = delete;
+        CodeArena& operator=(const CodeArena&) = delete;
+
+        // Reserves the arena near the module image [moduleBase, moduleBase +
+        // moduleSize). Retried on later calls if it fails; concurrent callers
+        // are safe, the loser returns the winner's result.
+        bool Init(uintptr_t moduleBase, size_t moduleSize, size_t size = DefaultSize);
+
+        // Executable chunks grow up from the base, data chunks down from the
+        // top. Lock-free; nullptr when the arena is full or not reserved.
+        void* AllocCode(size_t size);
+        void* AllocData(size_t size, size_t align = 64);
+
+        bool      Ready() const { return _state.load(std::memory_order_acquire) == Reserved; }
+        uintptr_t Base() const { return _base; }
+        size_t    Size() const { return _size; }
+        size_t    Used() const;
+        uint32_t  Queries() const { return _queries; }   // region queries the search took
+
+    private:
+        enum : int { Empty, Reserving, Reserved };
+
+        void* Alloc(size_t size, size_t align, bool fromTop);
+
+        std::atomic<int>      _state{ Empty };
+        uintptr_t             _base = 0;
+        size_t                _size = 0;
+        uint32_t              _queries = 0;
+        std::atomic<uint64_t> _cursor{ 0 };  // low 32: code top, high 32: data bottom
+    };
+}
@@ -0,0 +1,73 @@
+#include "config_blob.h"
+#include "offset_cache.h"
+#include "os_file.h"
+
+#include <cstring>
+#include <vector>
+
+namespace CascadePatch::ConfigBlob
+{
+    SourceStamp Stamp(const char* path)
+    {
+        SourceStamp s;
+        if (!OS::FileStamp(path, s.size, s.writeTime)) return SourceStamp{};
+        return s;
+    }
+
+    Status Load(const char* path, uint64_t schemaHash, const SourceStamp* sources, size_t count, void* values,
+                size_t size)
+    {
+        OS::MappedFile file;
+        if (!file.Open(path)) return Status::Missing;
+
+        Header header;
+        if (file.Size() < sizeof(header)) return Status::Corrupt;
+        memcpy(&header, file.Data(), sizeof(header));
+
+        if (header.magic != Magic || header.version != Version || header.sourceCount > MaxSources) {
+            return Status::Corrupt;
+        }
+        if (file.Size() != sizeof(header) + header.size) return Status::Corrupt;
+
+        const uint8_t* bytes = file.Data() + sizeof(header);
+        if (OffsetCache::Fnv1a(bytes, header.size) != header.checksum) return Status::Corrupt;
+        if (header.schemaHash != schemaHash || header.size != size || header.sourceCount != count) return Status::Stale;
+        for (size_t i = 0; i < count; i++) {
+            if (!(header.sources[i] == sources[i])) return Status::Stale;
+        }
+
+        memcpy(values, bytes, size);
+        return Status::Ok;
+    }
+
+    bool Save(const char* path, uint64_t schemaHash, const SourceStamp* sources, size_t count, const void* values,
+              size_t size)
+    {
+        if (count > MaxSources || size > UINT32_MAX) return false;
+
+        Header header{};
+        header.magic = Magic;
+        header.version = Version;
+        header.sourceCount = static_cast<uint16_t>(count);
+        header.size = static_cast<uint32_t>(size);
+        header.schemaHash = schemaHash;
+        for (size_t i = 0; i < count; i++) header.sources[i] = sources[i];
+        header.checksum = OffsetCache::Fnv1a(values, size);
+
+        std::vector<uint8_t> buffer(sizeof(header) + size);
+        memcpy(buffer.data(), &header, sizeof(header));
+        memcpy(buffer.data() + sizeof(header), values, size);
+        return OS::WriteFileAtomic(path, buffer.data(), buffer.size());
+    }
+
+    const char* StatusName(Status s)
+    {
+        switch (s) {
+        case Status::Ok:      return "ok";
+        case Status::Missing: return "missing";
+        case Status::Corrupt: return "corrupt";
+        case Status::Stale:   return "stale";
+        }
+        return "?";
+    }
+}
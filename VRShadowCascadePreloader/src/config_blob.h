@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Binary cache of loaded settings
+// Startup used to parse the same two INI files three times before the first
+// frame, and again at every game load. The merged settings struct is saved
+// as a small blob next to the INI. Like the offset cache, it is keyed by
+// what it was built from: a stamp (size and last write time) of each source
+// file, the settings schema's hash (keys, offsets, defaults and ranges) and
+// the struct size. Load() only stats the sources, so a matching blob loads
+// in microseconds without opening the INI files. A stale, corrupt or
+// missing blob just means the INI files are parsed and the blob rewritten.
+// The struct must be trivially copyable.
+//
+// File layout (little endian):
+//   Header  magic "SBCB", version, source count, struct size, schema hash,
+//           source stamps, checksum of the struct bytes
+//   uint8   values[size]
+// =============================================================================
+
+namespace CascadePatch::ConfigBlob
+{
+    constexpr uint32_t Magic      = 0x42434253;  // "SBCB"
+    constexpr uint16_t Version    = 1;
+    constexpr size_t   MaxSources = 4;
+
+    // All zero for a missing file
+    struct SourceStamp
+    {
+        uint64_t size      = 0;
+        uint64_t writeTime = 0;
+
+        bool operator==(const SourceStamp&) const = default;
+    };
+
+    struct Header
+    {
+        uint32_t    magic;
+        uint16_t    version;
+        uint16_t    sourceCount;
+        uint32_t    size;
+        uint32_t    reserved;
+        uint64_t    schemaHash;
+        SourceStamp sources[MaxSources];
+        uint64_t    checksum;       // FNV-1a of the struct bytes
+    };
+    static_assert(sizeof(Header) == 96, "blob header layout changed");
+
+    enum class Status : uint8_t { Ok, Missing, Corrupt, Stale };
+
+    SourceStamp Stamp(const char* path);
+
+    // Copies the cached struct into values[size] if the schema hash, size
+    // and every source stamp match. `values` is left untouched otherwise.
+    Status Load(const char* path, uint64_t schemaHash, const SourceStamp* sources, size_t count, void* values,
+                size_t size);
+
+    bool Save(const char* path, uint64_t schemaHash, const SourceStamp* sources, size_t count, const void* values,
+              size_t size);
+
+    const char* StatusName(Status s);
+}
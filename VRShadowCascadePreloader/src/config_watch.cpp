@@ -0,0 +1,139 @@
+#include "config_watch.h"
+#include "ini_schema.h"
+#include "offset_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace CascadePatch
+{
+    namespace
+    {
+        std::string Lower(std::string_view s)
+        {
+            std::string out(s);
+            for (char& c : out) {
+                if (c >= 'A' && c <= 'Z') c = static_cast<char>(c - 'A' + 'a');
+            }
+            return out;
+        }
+
+        bool Less(const IniValues::Entry& a, const IniValues::Entry& b)
+        {
+            return a.section != b.section ? a.section < b.section : a.key < b.key;
+        }
+
+        // Whole file into `out`; shared with writers, unlike a mapping, so MCM
+        // can always rewrite the file while it is being read
+        bool ReadFile(const char* path, std::string& out)
+        {
+            out.clear();
+            FILE* f = fopen(path, "rb");
+            if (!f) return false;
+            char buffer[4096];
+            size_t n;
+            while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) out.append(buffer, n);
+            fclose(f);
+            return !out.empty();
+        }
+    }
+
+    void IniValues::Parse(std::string_view text)
+    {
+        // Same syntax as IniSchema::Load(), so a change is seen exactly where it applies
+        _entries.clear();
+        ForEachIniValue(text, [&](std::string_view section, std::string_view key, std::string_view value) {
+            _entries.push_back({ Lower(section), Lower(key), std::string(value) });
+        });
+
+        // A key set twice keeps its last value, as in SimpleIni without multi-keys
+        std::stable_sort(_entries.begin(), _entries.end(), Less);
+        auto last = std::unique(_entries.rbegin(), _entries.rend(), [](const Entry& a, const Entry& b) {
+            return a.section == b.section && a.key == b.key;
+        });
+        _entries.erase(_entries.begin(), last.base());
+    }
+
+    const std::string* IniValues::Find(std::string_view section, std::string_view key) const
+    {
+        Entry probe{ Lower(section), Lower(key), {} };
+        auto it = std::lower_bound(_entries.begin(), _entries.end(), probe, Less);
+        if (it == _entries.end() || it->section != probe.section || it->key != probe.key) return nullptr;
+        return &it->value;
+    }
+
+    uint32_t RouteSection(const SectionRoute* routes, size_t routeCount, std::string_view section)
+    {
+        std::string name = Lower(section);
+        uint32_t mask = 0;
+        for (size_t i = 0; i < routeCount; i++) {
+            std::string route = Lower(routes[i].section);
+            bool match = name == route ||
+                         (name.size() > route.size() && name.compare(0, route.size(), route) == 0 &&
+                          name[route.size()] == ':');
+            if (match) mask |= routes[i].subsystems;
+        }
+        return mask;
+    }
+
+    void ConfigFileWatch::Open(std::string path, const SectionRoute* routes, size_t routeCount)
+    {
+        _path = std::move(path);
+        _routes = routes;
+        _routeCount = routeCount;
+        _counters = Counters{};
+        _hash = 0;
+        _values = IniValues{};
+        if (ReadFile(_path.c_str(), _text)) {
+            _hash = OffsetCache::Fnv1a(_text.data(), _text.size());
+            _values.Parse(_text);
+        }
+    }
+
+    ConfigFileWatch::Result ConfigFileWatch::Check(ConfigChange& change)
+    {
+        change = ConfigChange{};
+        _counters.checks++;
+        if (!ReadFile(_path.c_str(), _text)) {
+            _counters.missing++;
+            return Result::Missing;
+        }
+        uint64_t hash = OffsetCache::Fnv1a(_text.data(), _text.size());
+        if (hash == _hash) {
+            _counters.sameHash++;
+            return Result::Unchanged;
+        }
+        _hash = hash;
+
+        IniValues next;
+        next.Parse(_text);
+
+        // Both sorted: one merge pass finds changed, added and removed keys
+        auto note = [&](const IniValues::Entry& e) {
+            change.keys.push_back(e.section + "/" + e.key);
+            change.subsystems |= RouteSection(_routes, _routeCount, e.section);
+        };
+        const auto& a = _values.Entries();
+        const auto& b = next.Entries();
+        size_t i = 0, j = 0;
+        while (i < a.size() || j < b.size()) {
+            if (j == b.size() || (i < a.size() && Less(a[i], b[j]))) {
+                note(a[i++]);
+            } else if (i == a.size() || Less(b[j], a[i])) {
+                note(b[j++]);
+            } else {
+                if (a[i].value != b[j].value) note(b[j]);
+                i++;
+                j++;
+            }
+        }
+        _values = std::move(next);
+
+        if (change.keys.empty()) {
+            _counters.sameValues++;
+            return Result::Unchanged;
+        }
+        _counters.changed++;
+        return Result::Changed;
+    }
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// =============================================================================
+// Config file change detection
+// The plugin reloads its INI files when a file watcher reports a write, but a
+// write is not a change. MCM rewrites the whole file, and the plugin's own
+// Stats page writes the same file. ConfigFileWatch::Check() reads the file
+// and compares an FNV-1a hash of the bytes with the last one. Only on a new
+// hash does it parse the file (sections, keys and values, case-insensitive
+// like SimpleIni) and diff it against the last parse. Each changed, added or
+// removed key maps to subsystem bits through its section
+// (SectionRoute; "TerrainManager" also covers "TerrainManager:Level1"), so
+// the caller re-applies only what a change touches. Comments, formatting
+// and unrouted sections never trigger a reload. Portable;
+// tools/config_watch_check tests it with temp files.
+// =============================================================================
+
+namespace CascadePatch
+{
+    // INI text as (section, key, value), sorted by section and key; section
+    // and key are lowercased, values trimmed
+    class IniValues
+    {
+    public:
+        struct Entry
+        {
+            std::string section;
+            std::string key;
+            std::string value;
+        };
+
+        void Parse(std::string_view text);
+        const std::vector<Entry>& Entries() const { return _entries; }
+        const std::string* Find(std::string_view section, std::string_view key) const;
+
+    private:
+        std::vector<Entry> _entries;
+    };
+
+    struct SectionRoute
+    {
+        const char* section;
+        uint32_t    subsystems;
+    };
+
+    // Subsystem bits for `section`, case-insensitive; a route also covers
+    // its ":"-suffixed sections
+    uint32_t RouteSection(const SectionRoute* routes, size_t routeCount, std::string_view section);
+
+    struct ConfigChange
+    {
+        uint32_t subsystems = 0;
+        std::vector<std::string> keys;  // "section/key" changed, added or removed
+    };
+
+    class ConfigFileWatch
+    {
+    public:
+        enum class Result : uint8_t
+        {
+            Unchanged,  // same bytes, or only comments, formatting or equal values
+            Changed,    // at least one key differs; see ConfigChange
+            Missing,    // unreadable or empty; the last values are kept
+        };
+
+        struct Counters
+        {
+            uint64_t checks = 0;
+            uint64_t sameHash = 0;      // returned without parsing
+            uint64_t sameValues = 0;    // new bytes, no key changed
+            uint64_t changed = 0;
+            uint64_t missing = 0;
+        };
+
+        // Reads the file as the baseline; later checks report changes against it
+        void Open(std::string path, const SectionRoute* routes, size_t routeCount);
+        Result Check(ConfigChange& change);
+
+        const std::string& Path() const { return _path; }
+        const IniValues& Values() const { return _values; }
+        const std::string& Text() const { return _text; }   // as of the last Open()/Check(); empty if missing
+        uint64_t Hash() const { return _hash; }
+        const Counters& Stats() const { return _counters; }
+
+    private:
+        std::string          _path;
+        const SectionRoute*  _routes = nullptr;
+        size_t               _routeCount = 0;
+        IniValues            _values;
+        uint64_t             _hash = 0;
+        std::string          _text;     // read buffer, reused
+        Counters             _counters;
+    };
+}
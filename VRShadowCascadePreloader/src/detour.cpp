@@ -0,0 +1,108 @@
+#include "detour.h"
+
+#include "x64_asm.h"
+#include "x64_decode.h"
+
+#include <cstring>
+
+namespace CascadePatch::Detour
+{
+    // Ends the function's straight-line code: ret, ret imm16, int3, jmp
+    static bool EndsFlow(const uint8_t* code, const X64::Insn& in)
+    {
+        if (in.map != 0) return false;
+        switch (in.opcode) {
+        case 0xC3: case 0xC2: case 0xCC: case 0xE9: case 0xEB:
+            return true;
+        case 0xFF: {
+            uint8_t reg = (code[in.modrmOffset] >> 3) & 7;
+            return reg == 4 || reg == 5;
+        }
+        default:
+            return false;
+        }
+    }
+
+    static bool Fail(Hook& hook, Error error)
+    {
+        hook.error = error;
+        hook.trampoline = nullptr;
+        return false;
+    }
+
+    bool Prepare(Hook& hook, const char* name, uintptr_t target, const void* detour, CodeArena& arena)
+    {
+        hook = Hook{};
+        hook.name = name;
+        hook.target = target;
+        hook.detour = detour;
+
+        uint8_t code[Patch::MaxBytes];
+        memcpy(code, reinterpret_cast<const void*>(target), sizeof(code));
+
+        size_t length = 0, count = 0;
+        while (length < 5) {
+            X64::Insn in = X64::DecodeOne(code + length, sizeof(code) - length);
+            if (!in.length) return Fail(hook, Error::Decode);
+            // A jump or return may end the stolen bytes, but not come before them
+            if (EndsFlow(code + length, in) && length + in.length < 5) return Fail(hook, Error::ShortFunction);
+            length += in.length;
+            count++;
+        }
+
+        size_t capacity = X64::RelocatedSize(length, count) + 5;
+        uint8_t* relay = static_cast<uint8_t*>(arena.AllocCode(RelaySize + capacity));
+        if (!relay) return Fail(hook, Error::Arena);
+        uint8_t* trampoline = relay + RelaySize;
+
+        size_t moved = X64::Relocate(code, length, target, trampoline, capacity - 5,
+                                     reinterpret_cast<uintptr_t>(trampoline));
+        if (!moved) return Fail(hook, Error::Relocate);
+        uint8_t* back = trampoline + moved;
+        if (!X64::EncodeJmp(back, 5, reinterpret_cast<uintptr_t>(back), target + length)) {
+            return Fail(hook, Error::Range);
+        }
+
+        relay[0] = 0xFF;
+        relay[1] = 0x25;
+        memset(relay + 2, 0, 4);
+        memcpy(relay + 6, &detour, 8);
+
+        if (!X64::EncodeJmp(hook.jump, length, target, reinterpret_cast<uintptr_t>(relay))) {
+            return Fail(hook, Error::Range);
+        }
+        OS::FlushInstructionCache(relay, RelaySize + moved + 5);
+
+        memcpy(hook.original, code, length);
+        hook.relay = relay;
+        hook.trampoline = trampoline;
+        hook.length = static_cast<uint8_t>(length);
+        hook.instructions = static_cast<uint8_t>(count);
+        return true;
+    }
+
+    Patch::Write* QueueInstall(const Hook& hook, Patch::Batch& batch, uint8_t group)
+    {
+        if (!hook.Prepared()) return nullptr;
+        return batch.Add(hook.name, hook.target, hook.original, hook.jump, hook.length, group);
+    }
+
+    Patch::Write* QueueRemove(const Hook& hook, Patch::Batch& batch, uint8_t group)
+    {
+        if (!hook.Prepared()) return nullptr;
+        return batch.Add(hook.name, hook.target, hook.jump, hook.original, hook.length, group);
+    }
+
+    const char* ErrorName(Error error)
+    {
+        switch (error) {
+        case Error::None:          return "none";
+        case Error::Decode:        return "prologue does not decode";
+        case Error::ShortFunction: return "function shorter than the JMP";
+        case Error::Arena:         return "code arena full";
+        case Error::Relocate:      return "prologue cannot be relocated";
+        case Error::Range:         return "out of rel32 range";
+        }
+        return "?";
+    }
+}
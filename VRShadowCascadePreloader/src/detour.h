@@ -0,0 +1,68 @@
+#pragma once
+
+#include "code_arena.h"
+#include "patch_engine.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Inline function detours
+// Prepare() decodes the whole instructions under a 5-byte JMP at a function
+// entry and relocates them into a trampoline in the code arena, followed by
+// a jump back to the rest of the function. Next to it goes a relay
+// (jmp [rip]; dq detour), so the detour itself can live anywhere in the
+// address space. The entry JMP goes through a Patch::Batch like every other
+// site write: it is verified against the decoded bytes and applied with the
+// rest of its batch. The detour has the hooked function's signature and calls
+// Original() to run it. Remove only queues the original bytes back; the
+// trampoline stays, since a thread may still be inside it.
+// Reads of the target are unguarded: Windows callers wrap Prepare() in __try.
+// =============================================================================
+
+namespace CascadePatch::Detour
+{
+    enum class Error : uint8_t
+    {
+        None,
+        Decode,         // prologue does not decode
+        ShortFunction,  // ret/jmp/int3 before 5 bytes: the JMP would spill past the function
+        Arena,          // no room in the code arena
+        Relocate,       // prologue cannot move (rel8 loop, branch into itself, out of range)
+        Range,          // relay out of rel32 reach of the entry
+    };
+
+    // Relay: FF 25 00000000 (jmp [rip]) + 8-byte address
+    inline constexpr size_t RelaySize = 14;
+
+    // Trivially destructible so it can live in functions that use SEH
+    struct Hook
+    {
+        const char* name = "";
+        uintptr_t   target = 0;
+        const void* detour = nullptr;
+        uint8_t*    relay = nullptr;
+        uint8_t*    trampoline = nullptr;      // relocated prologue + jmp back
+        uint8_t     length = 0;                // entry bytes replaced by the JMP
+        uint8_t     instructions = 0;
+        uint8_t     original[Patch::MaxBytes] = {};
+        uint8_t     jump[Patch::MaxBytes] = {};
+        Error       error = Error::None;
+
+        bool Prepared() const { return trampoline != nullptr; }
+
+        // The hooked function, for the detour to call
+        template <typename Fn>
+        Fn Original() const { return reinterpret_cast<Fn>(trampoline); }
+    };
+
+    // Builds the relay and trampoline for `target`; false (and hook.error) if
+    // the entry cannot be hooked. Nothing at `target` is written.
+    bool Prepare(Hook& hook, const char* name, uintptr_t target, const void* detour, CodeArena& arena);
+
+    // Queue the entry JMP, or the original bytes back
+    Patch::Write* QueueInstall(const Hook& hook, Patch::Batch& batch, uint8_t group);
+    Patch::Write* QueueRemove(const Hook& hook, Patch::Batch& batch, uint8_t group);
+
+    const char* ErrorName(Error error);
+}
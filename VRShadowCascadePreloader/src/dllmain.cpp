@@ -21,7 +21,7 @@ BOOL APIENTRY DllMain(HMODULE hModule, DWORD ul_reason_for_call, LPVOID lpReserv
         break;
 
     case DLL_PROCESS_DETACH:
-        CascadePatch::Shutdown();
+        CascadePatch::Shutdown(lpReserved != nullptr);
         CleanupProxy();
         break;
     }
@@ -0,0 +1,29 @@
+#include "flight_recorder.h"
+
+namespace CascadePatch
+{
+    bool FlightRecorder::Open(const char* path, uint32_t capacity, uint64_t moduleBase)
+    {
+        if (Ready() || capacity == 0) return false;
+
+        uint32_t slots = RingFile::Slots(capacity);
+        auto* header = static_cast<Flight::FileHeader*>(RingFile::Create(_file, path, Flight::Format, slots));
+        if (!header) return false;
+        header->info.ticksPerSecond = OS::TicksPerSecond();
+        header->info.startTicks = OS::Ticks();
+        header->info.moduleBase = moduleBase;
+
+        _header = header;
+        _mask = slots - 1;
+        _records.store(RingFile::Records<Flight::Record>(header), std::memory_order_release);
+        return true;
+    }
+
+    void FlightRecorder::Close()
+    {
+        _records.store(nullptr, std::memory_order_release);
+        _header = nullptr;
+        _mask = 0;
+        _file.Close();
+    }
+}
@@ -0,0 +1,112 @@
+#pragma once
+
+#include "os_file.h"
+#include "os_time.h"
+#include "ring_file.h"
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Binary flight recorder
+// Fixed-size events (id, timestamp, thread, five raw argument words) are
+// stored into a mapped ring file (ring_file.h). Recording is a ticket
+// fetch_add and a handful of plain stores; nothing is formatted and no
+// syscall is made. Event ids and how to print their arguments live in
+// cascade_events.h; tools/flight_decode turns a file back into text or a
+// Chrome trace.
+// =============================================================================
+
+namespace CascadePatch::Flight
+{
+    inline constexpr char     Magic[4] = { 'V', 'S', 'F', 'R' };
+    inline constexpr uint32_t Version  = 1;
+    inline constexpr size_t   MaxArgs  = 5;
+
+    struct Info
+    {
+        uint64_t ticksPerSecond;
+        uint64_t startTicks;
+        uint64_t moduleBase;
+        uint8_t  reserved[16];
+    };
+
+    // head counts the tickets handed out; a record's seq is its ticket + 1
+    using FileHeader = RingFile::Header<Info>;
+
+    struct Record
+    {
+        std::atomic<uint64_t> seq;
+        uint64_t ticks;
+        uint16_t event;
+        uint16_t reserved;
+        uint32_t threadId;
+        uint64_t args[MaxArgs];
+    };
+
+    static_assert(sizeof(FileHeader) == 128);
+    static_assert(sizeof(Record) == 64);
+    static_assert(std::atomic<uint64_t>::is_always_lock_free);
+
+    inline constexpr RingFile::Format Format = { Magic, Version, sizeof(FileHeader), sizeof(Record) };
+}
+
+namespace CascadePatch
+{
+    class FlightRecorder
+    {
+    public:
+        static constexpr uint32_t DefaultCapacity = 16384;  // 1 MB file
+
+        FlightRecorder() = default;
+        FlightRecorder(const FlightRecorder&) = delete;
+        FlightRecorder& operator=(const FlightRecorder&) = delete;
+
+        // Creates (truncates) `path` and maps it. Capacity is rounded up to a
+        // power of two. Record() is a no-op until this succeeds.
+        bool Open(const char* path, uint32_t capacity = DefaultCapacity, uint64_t moduleBase = 0);
+
+        // Unmaps the file. Only safe once no thread can be inside Record();
+        // at process exit leave it mapped and let the OS write it back.
+        void Close();
+
+        bool Ready() const { return _records.load(std::memory_order_acquire) != nullptr; }
+        uint64_t Recorded() const { return _header ? _header->head.load(std::memory_order_relaxed) : 0; }
+        uint32_t Capacity() const { return _mask + 1; }
+
+        // Wait-free; the oldest record is overwritten once the ring is full
+        void Record(uint16_t event, uint64_t a0 = 0, uint64_t a1 = 0, uint64_t a2 = 0,
+                    uint64_t a3 = 0, uint64_t a4 = 0)
+        {
+            Flight::Record* records = _records.load(std::memory_order_acquire);
+            if (!records) return;
+
+            uint64_t ticket = _header->head.fetch_add(1, std::memory_order_relaxed);
+            Flight::Record& r = records[ticket & _mask];
+            RingFile::BeginWrite(r);
+            r.ticks = OS::Ticks();
+            r.event = event;
+            r.reserved = 0;
+            r.threadId = OS::CurrentThreadId();
+            r.args[0] = a0;
+            r.args[1] = a1;
+            r.args[2] = a2;
+            r.args[3] = a3;
+            r.args[4] = a4;
+            RingFile::EndWrite(r, ticket);
+        }
+
+    private:
+        OS::WritableMapping _file;
+        Flight::FileHeader* _header = nullptr;
+        std::atomic<Flight::Record*> _records{ nullptr };
+        uint32_t _mask = 0;
+    };
+
+    // Argument word for a Float field (see cascade_events.h)
+    inline uint64_t FloatArg(float value)
+    {
+        return std::bit_cast<uint32_t>(value);
+    }
+}
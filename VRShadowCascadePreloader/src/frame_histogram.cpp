@@ -0,0 +1,86 @@
+#include "frame_histogram.h"
+
+#include <cmath>
+#include <cstring>
+
+namespace CascadePatch
+{
+    void FrameHistogram::Clear()
+    {
+        memset(_counts, 0, sizeof(_counts));
+        memset(_octaves, 0, sizeof(_octaves));
+        _count = 0;
+        _maxUs = 0;
+        _sumUs = 0;
+    }
+
+    void FrameHistogram::Percentiles(const double* percentiles, uint32_t* out, size_t n, const FrameHistogram* other) const
+    {
+        uint64_t total = _count + (other ? other->_count : 0);
+        if (total == 0) {
+            for (size_t i = 0; i < n; i++) out[i] = 0;
+            return;
+        }
+
+        // Rank of each percentile: the smallest count whose share reaches it
+        auto rankOf = [&](double p) {
+            uint64_t rank = static_cast<uint64_t>(std::ceil(p / 100.0 * static_cast<double>(total)));
+            return rank < 1 ? 1 : rank > total ? total : rank;
+        };
+
+        size_t next = 0;
+        uint64_t rank = rankOf(percentiles[0]);
+        uint64_t seen = 0;
+        size_t index = 0;
+        for (uint32_t octave = 0; octave < Octaves && next < n; octave++) {
+            size_t end = static_cast<size_t>(octave + 2) << (SubBits - 1);
+            uint64_t inOctave = _octaves[octave] + (other ? other->_octaves[octave] : 0);
+            if (seen + inOctave < rank) {
+                seen += inOctave;
+                index = end;
+                continue;
+            }
+            for (; index < end && next < n; index++) {
+                seen += _counts[index] + (other ? other->_counts[index] : 0);
+                while (next < n && seen >= rank) {
+                    out[next++] = Highest(index);
+                    if (next < n) rank = rankOf(percentiles[next]);
+                }
+            }
+            index = end;
+        }
+
+        // Only reached with percentiles past 100
+        for (; next < n; next++) out[next] = Highest(Buckets - 1);
+    }
+
+    void FrameTimeWindow::Clear()
+    {
+        _hist[0].Clear();
+        _hist[1].Clear();
+        _current = 0;
+    }
+
+    FrameTimeStats FrameTimeWindow::Query() const
+    {
+        const FrameHistogram& a = _hist[0];
+        const FrameHistogram& b = _hist[1];
+
+        FrameTimeStats s;
+        s.frames = a.Count() + b.Count();
+        if (s.frames == 0) return s;
+
+        static constexpr double Ranks[] = { 50.0, 95.0, 99.0 };
+        uint32_t us[3];
+        a.Percentiles(Ranks, us, 3, &b);
+
+        double sumUs = a.MeanUs() * a.Count() + b.MeanUs() * b.Count();
+        uint32_t maxUs = a.MaxValue() > b.MaxValue() ? a.MaxValue() : b.MaxValue();
+        s.meanMs = static_cast<float>(sumUs / s.frames / 1000.0);
+        s.p50Ms = us[0] / 1000.0f;
+        s.p95Ms = us[1] / 1000.0f;
+        s.p99Ms = us[2] / 1000.0f;
+        s.maxMs = maxUs / 1000.0f;
+        return s;
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Frame-time histograms
+// Log-linear buckets in the HdrHistogram layout: values below 2^SubBits us get
+// one bucket each, and every octave above that is split into 2^(SubBits-1)
+// linear buckets. A bucket is at most 1/64 of its value wide (64 us around
+// 11 ms), and 960 uint32 counters cover 0 to 1 s. Recording is an index
+// computation and two increments, with no allocation. A percentile walks the
+// per-octave totals first and only scans the octave that holds it.
+// FrameTimeWindow rotates two histograms, so its percentiles cover the last
+// `window` to 2 x `window` frames. Shared with the ShadowBoost plugin;
+// tools/histogram_bench measures record and query cost.
+// =============================================================================
+
+namespace CascadePatch
+{
+    class FrameHistogram
+    {
+    public:
+        static constexpr uint32_t SubBits  = 7;
+        static constexpr uint32_t MaxUs    = (1u << 20) - 1;      // longer frames (loading) clamp here
+        static constexpr uint32_t Octaves  = 20 - SubBits + 1;
+        static constexpr size_t   Buckets  = (Octaves + 1) << (SubBits - 1);
+
+        static constexpr size_t Index(uint32_t us)
+        {
+            if (us > MaxUs) us = MaxUs;
+            uint32_t width = static_cast<uint32_t>(std::bit_width(us));
+            uint32_t shift = width > SubBits ? width - SubBits : 0;
+            return (static_cast<size_t>(shift) << (SubBits - 1)) + (us >> shift);
+        }
+
+        static constexpr uint32_t OctaveOf(size_t index)
+        {
+            return index < (1u << SubBits) ? 0 : static_cast<uint32_t>(index >> (SubBits - 1)) - 1;
+        }
+
+        // Smallest and largest value recorded into bucket `index`
+        static constexpr uint32_t Lowest(size_t index)
+        {
+            uint32_t shift = OctaveOf(index);
+            return static_cast<uint32_t>(index - (static_cast<size_t>(shift) << (SubBits - 1))) << shift;
+        }
+        static constexpr uint32_t Highest(size_t index) { return Lowest(index) + (1u << OctaveOf(index)) - 1; }
+
+        void Clear();
+        void Record(uint32_t us)
+        {
+            size_t index = Index(us);
+            _counts[index]++;
+            _octaves[OctaveOf(index)]++;
+            _count++;
+            _sumUs += us > MaxUs ? MaxUs : us;
+            if (us > _maxUs) _maxUs = us;
+        }
+
+        uint32_t Count() const { return _count; }
+        uint32_t MaxValue() const { return _maxUs; }
+        double MeanUs() const { return _count ? static_cast<double>(_sumUs) / _count : 0.0; }
+
+        // Values at `percentiles` (ascending, 0-100) over this histogram and,
+        // if given, `other` merged: the highest value of the bucket holding
+        // each rank, so a reported p99 is never below the true one. One pass
+        // over the buckets for all of them; 0 when both are empty.
+        void Percentiles(const double* percentiles, uint32_t* out, size_t n, const FrameHistogram* other = nullptr) const;
+        uint32_t Percentile(double percentile) const
+        {
+            uint32_t v = 0;
+            Percentiles(&percentile, &v, 1);
+            return v;
+        }
+
+    private:
+        uint32_t _counts[Buckets] = {};
+        uint32_t _octaves[Octaves] = {};
+        uint32_t _count = 0;
+        uint32_t _maxUs = 0;
+        uint64_t _sumUs = 0;
+    };
+
+    static_assert(FrameHistogram::Index(FrameHistogram::MaxUs) == FrameHistogram::Buckets - 1);
+    static_assert(FrameHistogram::Lowest(FrameHistogram::Index(11111)) <= 11111 &&
+                  FrameHistogram::Highest(FrameHistogram::Index(11111)) >= 11111);
+
+    struct FrameTimeStats
+    {
+        uint32_t frames = 0;
+        float    meanMs = 0.0f;
+        float    p50Ms = 0.0f;
+        float    p95Ms = 0.0f;
+        float    p99Ms = 0.0f;
+        float    maxMs = 0.0f;
+    };
+
+    class FrameTimeWindow
+    {
+    public:
+        static constexpr uint32_t MinWindow = 30;
+
+        void SetWindow(uint32_t frames) { _window = frames < MinWindow ? MinWindow : frames; }
+        uint32_t Window() const { return _window; }
+
+        void Record(uint32_t us)
+        {
+            _hist[_current].Record(us);
+            if (_hist[_current].Count() >= _window) {
+                _current ^= 1;
+                _hist[_current].Clear();
+            }
+        }
+
+        void Clear();
+        FrameTimeStats Query() const;
+
+    private:
+        FrameHistogram _hist[2];
+        uint32_t _current = 0;
+        uint32_t _window = 450;     // 5 s at 90 fps
+    };
+}
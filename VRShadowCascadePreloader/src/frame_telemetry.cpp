@@ -0,0 +1,37 @@
+#include "frame_telemetry.h"
+
+namespace CascadePatch
+{
+    bool FrameTelemetry::Open(const char* path, uint32_t capacity)
+    {
+        if (Ready() || capacity == 0) return false;
+
+        uint32_t slots = RingFile::Slots(capacity);
+        auto* header = static_cast<Telemetry::FileHeader*>(RingFile::Create(_file, path, Telemetry::Format, slots));
+        if (!header) return false;
+
+        _header = header;
+        _head = 0;
+        _mask = slots - 1;
+        _records = RingFile::Records<Telemetry::Record>(header);
+        return true;
+    }
+
+    void FrameTelemetry::Close()
+    {
+        _records = nullptr;
+        _header = nullptr;
+        _head = 0;
+        _mask = 0;
+        _file.Close();
+    }
+
+    bool TelemetryReader::Open(const char* path, const char** error)
+    {
+        auto* header = static_cast<const Telemetry::FileHeader*>(RingFile::Open(_file, path, Telemetry::Format, error));
+        if (!header) return false;
+        _header = header;
+        _records = RingFile::Records<Telemetry::Record>(header);
+        return true;
+    }
+}
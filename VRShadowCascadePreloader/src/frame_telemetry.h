@@ -0,0 +1,140 @@
+#pragma once
+
+#include "os_file.h"
+#include "quality_governor.h"
+#include "ring_file.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Per-frame ShadowBoost telemetry
+// One 64-byte record per frame, in a mapped ring file (ring_file.h) like the
+// flight recorder's. The record holds the frame time, what the
+// last adjustment measured and decided, and the knob values it wrote. There
+// is a single writer (the render thread), so recording is a dozen plain
+// stores and two release stores, with no allocation, lock or syscall. The
+// knob values come from the governor's decision, not from the game, so no
+// setting is read. tools/telemetry_export turns a file into CSV, and
+// governor_sim replays that CSV as a trace.
+// =============================================================================
+
+namespace CascadePatch::Telemetry
+{
+    inline constexpr char     Magic[4] = { 'V', 'S', 'F', 'T' };
+    inline constexpr uint32_t Version  = 1;
+
+    enum Flags : uint8_t
+    {
+        Adjusted   = 1 << 0,    // this frame ran an adjustment
+        AutoAdjust = 1 << 1,
+    };
+
+    struct Info
+    {
+        uint8_t reserved[40];
+    };
+
+    // head counts the frames recorded; a record's seq is its frame + 1
+    using FileHeader = RingFile::Header<Info>;
+
+    struct Record
+    {
+        std::atomic<uint64_t> seq;
+        uint32_t frameUs;
+        uint32_t adjustment;        // adjustments since the governor's reset
+        uint8_t  flags;
+        uint8_t  blockIndex;
+        uint8_t  controller;        // ControllerMode
+        uint8_t  metric;            // FrameMetric
+        float    avgMs;             // values of the last adjustment
+        float    measuredMs;
+        float    targetMs;
+        float    errorMs;
+        float    step;
+        float    knobs[KnobCount];  // in Knob order
+        uint32_t reserved;
+    };
+
+    static_assert(sizeof(FileHeader) == 128);
+    static_assert(sizeof(Record) == 64);
+
+    inline constexpr RingFile::Format Format = { Magic, Version, sizeof(FileHeader), sizeof(Record) };
+}
+
+namespace CascadePatch
+{
+    class FrameTelemetry
+    {
+    public:
+        static constexpr uint32_t DefaultCapacity = 65536;  // 4 MB, 12 minutes at 90 fps
+
+        FrameTelemetry() = default;
+        FrameTelemetry(const FrameTelemetry&) = delete;
+        FrameTelemetry& operator=(const FrameTelemetry&) = delete;
+
+        // Creates (truncates) `path` and maps it. Capacity is rounded up to a
+        // power of two. Record() is a no-op until this succeeds.
+        bool Open(const char* path, uint32_t capacity = DefaultCapacity);
+        void Close();
+
+        bool Ready() const { return _records != nullptr; }
+        uint64_t Recorded() const { return _head; }
+        uint32_t Capacity() const { return _mask + 1; }
+
+        // Render thread only; the oldest record is overwritten once the ring is full
+        void Record(uint32_t frameUs, bool adjusted, const GovernorConfig& config, const GovernorDecision& d)
+        {
+            if (!_records) return;
+
+            Telemetry::Record& r = _records[_head & _mask];
+            RingFile::BeginWrite(r);
+            r.frameUs = frameUs;
+            r.adjustment = static_cast<uint32_t>(d.adjustment);
+            r.flags = static_cast<uint8_t>((adjusted ? Telemetry::Adjusted : 0) |
+                                           (config.autoAdjust ? Telemetry::AutoAdjust : 0));
+            r.blockIndex = static_cast<uint8_t>(d.blockIndex);
+            r.controller = static_cast<uint8_t>(config.controller);
+            r.metric = static_cast<uint8_t>(config.metric);
+            r.avgMs = d.avgMs;
+            r.measuredMs = d.measuredMs;
+            r.targetMs = d.targetMs;
+            r.errorMs = d.errorMs;
+            r.step = d.step;
+            for (size_t i = 0; i < KnobCount; i++) r.knobs[i] = d.knobs[i];
+            r.reserved = 0;
+            RingFile::EndWrite(r, _head++);
+            _header->head.store(_head, std::memory_order_release);
+        }
+
+    private:
+        OS::WritableMapping _file;
+        Telemetry::FileHeader* _header = nullptr;
+        Telemetry::Record* _records = nullptr;
+        uint64_t _head = 0;
+        uint32_t _mask = 0;
+    };
+
+    // A mapped telemetry file, oldest complete record first
+    class TelemetryReader
+    {
+    public:
+        // False (with `error` set) when the file is not a telemetry file
+        bool Open(const char* path, const char** error);
+
+        const Telemetry::FileHeader& Header() const { return *_header; }
+
+        // Calls fn(frame, record) for every complete record in order
+        template <typename Fn>
+        size_t ForEach(Fn&& fn) const
+        {
+            return RingFile::ForEach(_records, _header->capacity, _header->head.load(std::memory_order_acquire), fn);
+        }
+
+    private:
+        OS::MappedFile _file;
+        const Telemetry::FileHeader* _header = nullptr;
+        const Telemetry::Record* _records = nullptr;
+    };
+}
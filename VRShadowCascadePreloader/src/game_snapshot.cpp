@@ -0,0 +1,215 @@
+#include "game_snapshot.h"
+
+#include <cstring>
+
+namespace CascadePatch::Snapshot
+{
+    static constexpr size_t Align8(size_t n) { return (n + 7) & ~size_t(7); }
+
+    // Caps on counts read from game memory, so a garbage count cannot blow
+    // up the capture
+    static constexpr uint32_t MaxFlatEntries = 8;
+    static constexpr uint32_t MaxVREntries   = 8;
+    static constexpr uint32_t MaxDescEntries = 16;
+    static constexpr size_t   CodeBytes      = 16;
+
+    static size_t SitesSize() { return Align8(Sites::Count * sizeof(uint32_t)); }
+
+    void Writer::Init(uint8_t* storage, size_t capacity, uintptr_t moduleBase, const char* label)
+    {
+        _data = storage;
+        _capacity = capacity;
+        _regionsStart = sizeof(Header) + SitesSize();
+        _size = _regionsStart;
+        memset(_data, 0, _regionsStart);
+
+        Header* h = Head();
+        h->magic = Magic;
+        h->version = Version;
+        h->siteCount = static_cast<uint16_t>(Sites::Count);
+        h->moduleBase = moduleBase;
+        strncpy(h->label, label, sizeof(h->label) - 1);
+    }
+
+    void Writer::SetSites(const SigScan::Resolution* sites, size_t count)
+    {
+        uint32_t* rvas = reinterpret_cast<uint32_t*>(_data + sizeof(Header));
+        for (size_t i = 0; i < count && i < Sites::Count; i++) rvas[i] = static_cast<uint32_t>(sites[i].rva);
+    }
+
+    const uint8_t* Writer::Add(Kind kind, uintptr_t addr, size_t size, bool moduleRelative, ReadFn read,
+                               void* context)
+    {
+        if (addr == 0 || size == 0) return nullptr;
+        uint16_t flags = moduleRelative ? ModuleRelative : 0;
+
+        for (size_t at = _regionsStart; at < _size;) {
+            const RegionHeader* r = reinterpret_cast<const RegionHeader*>(_data + at);
+            if (r->addr == addr && r->flags == flags && r->size >= size) {
+                return _data + at + sizeof(RegionHeader);
+            }
+            at += sizeof(RegionHeader) + Align8(r->size);
+        }
+
+        size_t need = sizeof(RegionHeader) + Align8(size);
+        if (_size + need > _capacity) {
+            Head()->skipped++;
+            return nullptr;
+        }
+
+        uint8_t* bytes = _data + _size + sizeof(RegionHeader);
+        uintptr_t source = moduleRelative ? Head()->moduleBase + addr : addr;
+        if (!read(bytes, source, size, context)) {
+            Head()->skipped++;
+            return nullptr;
+        }
+        memset(bytes + size, 0, Align8(size) - size);
+
+        RegionHeader* r = reinterpret_cast<RegionHeader*>(_data + _size);
+        r->addr = addr;
+        r->size = static_cast<uint32_t>(size);
+        r->kind = kind;
+        r->flags = flags;
+        _size += need;
+        Head()->regionCount++;
+        return bytes;
+    }
+
+    template <typename T>
+    static T Field(const uint8_t* bytes, size_t offset)
+    {
+        T v;
+        memcpy(&v, bytes + offset, sizeof(v));
+        return v;
+    }
+
+    static uint32_t Clamp(uint32_t n, uint32_t max) { return n < max ? n : max; }
+
+    static void CaptureCascadeGroup(Writer& out, uintptr_t cg, ReadFn read, void* context)
+    {
+        const uint8_t* group = out.Add(Kind::CascadeGroup, cg, ShaderObjectOffset + 8, false, read, context);
+        if (!group) return;
+
+        uintptr_t shader = Field<uintptr_t>(group, ShaderObjectOffset);
+        out.Add(Kind::Shader, shader, 0x1E0, false, read, context);
+
+        uintptr_t flatBuf = Field<uintptr_t>(group, FlatBufferOffset);
+        uint32_t flatCount = Clamp(Field<uint32_t>(group, FlatCountOffset), MaxFlatEntries);
+        out.Add(Kind::FlatEntries, flatBuf, flatCount * FlatEntrySize, false, read, context);
+    }
+
+    void Capture(Writer& out, ReadFn read, void* context)
+    {
+        using namespace VRArrayExpansion;
+
+        static constexpr struct { uintptr_t rva; size_t size; } Globals[] = {
+            { CascadeMaskGlobal,               4 },
+            { CascadeCountPatch::CountGlobal,  4 },
+            { ShadowDist4Cascade,              4 },
+            { ShadowDist2Cascade,              4 },
+            { ShadowSceneNodePtr,              8 },
+            { ShadowSceneNodePtr2,             8 },
+            { ArrayPtr,                        0x18 },   // ptr, capacity, count
+            { VRInstStereoFlag,                4 },
+            { VRInstDrawFlag,                  4 },
+            { DescArray0,                      0x48 },   // all three descriptors
+        };
+        for (const auto& g : Globals) out.Add(Kind::Global, g.rva, g.size, true, read, context);
+
+        const uint32_t* sites = reinterpret_cast<const uint32_t*>(out.Data() + sizeof(Header));
+        for (size_t i = 0; i < Sites::Count; i++) {
+            out.Add(Kind::Code, sites[i], CodeBytes, true, read, context);
+        }
+
+        // Scene nodes and what hangs off them
+        const uintptr_t nodeGlobals[] = { ShadowSceneNodePtr, ShadowSceneNodePtr2 };
+        for (uintptr_t rva : nodeGlobals) {
+            const uint8_t* slot = out.Add(Kind::Global, rva, 8, true, read, context);
+            if (!slot) continue;
+            uintptr_t node = Field<uintptr_t>(slot, 0);
+            const uint8_t* bytes = out.Add(Kind::SceneNode, node, CascadeGroupOffset + 8, false, read, context);
+            if (!bytes) continue;
+            uintptr_t cg = Field<uintptr_t>(bytes, CascadeGroupOffset);
+            if (cg) CaptureCascadeGroup(out, cg, read, context);
+        }
+
+        // VR cascade array: every slot up to its capacity
+        if (const uint8_t* vr = out.Add(Kind::Global, ArrayPtr, 0x18, true, read, context)) {
+            uint32_t capacity = Field<uint32_t>(vr, 8);
+            uint32_t count = Field<uint32_t>(vr, 0x10);
+            uint32_t entries = Clamp(capacity > count ? capacity : count, MaxVREntries);
+            out.Add(Kind::VREntries, Field<uintptr_t>(vr, 0), entries * EntrySize, false, read, context);
+        }
+
+        // Shadow map descriptor arrays: ptr, capacity, count
+        if (const uint8_t* desc = out.Add(Kind::Global, DescArray0, 0x48, true, read, context)) {
+            for (size_t i = 0; i < 3; i++) {
+                const uint8_t* d = desc + i * 0x18;
+                uint32_t count = Clamp(Field<uint32_t>(d, 0x10), MaxDescEntries);
+                out.Add(Kind::DescEntries, Field<uintptr_t>(d, 0), count * 8, false, read, context);
+            }
+        }
+    }
+
+    bool Reader::Open(const uint8_t* data, size_t size)
+    {
+        if (size < sizeof(Header)) return false;
+        const Header* h = reinterpret_cast<const Header*>(data);
+        if (h->magic != Magic || h->version != Version) return false;
+
+        size_t start = sizeof(Header) + Align8(h->siteCount * sizeof(uint32_t));
+        if (start > size) return false;
+
+        // Every region must fit, so Next() needs no further checks
+        size_t at = start;
+        for (uint32_t i = 0; i < h->regionCount; i++) {
+            if (at + sizeof(RegionHeader) > size) return false;
+            const RegionHeader* r = reinterpret_cast<const RegionHeader*>(data + at);
+            at += sizeof(RegionHeader) + Align8(r->size);
+            if (at > size || r->kind >= Kind::Count) return false;
+        }
+
+        _data = data;
+        _size = size;
+        _regionsStart = start;
+        _next = start;
+        _end = at;
+        return true;
+    }
+
+    uint32_t Reader::SiteRVA(size_t id) const
+    {
+        if (id >= Head().siteCount) return 0;
+        return reinterpret_cast<const uint32_t*>(_data + sizeof(Header))[id];
+    }
+
+    bool Reader::Next(Region& out)
+    {
+        if (_next >= _end) return false;
+
+        const RegionHeader* r = reinterpret_cast<const RegionHeader*>(_data + _next);
+        out.addr = static_cast<uintptr_t>(r->addr);
+        out.size = r->size;
+        out.kind = r->kind;
+        out.flags = r->flags;
+        out.bytes = _data + _next + sizeof(RegionHeader);
+        _next += sizeof(RegionHeader) + Align8(r->size);
+        return true;
+    }
+
+    const char* KindName(Kind kind)
+    {
+        switch (kind) {
+        case Kind::Global:       return "global";
+        case Kind::Code:         return "code";
+        case Kind::SceneNode:    return "scene_node";
+        case Kind::CascadeGroup: return "cascade_group";
+        case Kind::Shader:       return "shader";
+        case Kind::FlatEntries:  return "flat_entries";
+        case Kind::VREntries:    return "vr_entries";
+        case Kind::DescEntries:  return "desc_entries";
+        case Kind::Count:        break;
+        }
+        return "?";
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "cascade_sites.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Game memory snapshots
+// Capture() walks everything game_state.h and the mask restore batch touch,
+// starting from the module globals, and stores each object as a region: its
+// address, size, kind and bytes. Module regions are stored by RVA, heap
+// regions by their address in the game. Every read goes through a caller's
+// ReadFn, so a pointer that faults drops that region (and what hangs off it)
+// instead of the capture. tools/snapshot_replay maps a file back into memory
+// and runs the game_state.h fixes and the mask restore batch against it.
+//
+// File layout (little endian):
+//   Header         magic "VSNP", version, region count, module base, label
+//   uint32         siteRVA[siteCount]     resolved sites at capture time
+//   per region:    RegionHeader, then `size` bytes padded to 8
+// =============================================================================
+
+namespace CascadePatch::Snapshot
+{
+    inline constexpr uint32_t Magic   = 0x504E5356;  // "VSNP"
+    inline constexpr uint16_t Version = 1;
+    inline constexpr size_t   MaxBytes = 64 * 1024;   // everything Capture() takes fits easily
+
+    enum class Kind : uint16_t
+    {
+        Global,         // .data globals read by the fixes
+        Code,           // bytes at each resolved patch site
+        SceneNode,      // render / setup ShadowSceneNode, up to the cascade group pointer
+        CascadeGroup,   // up to the ISCopy shader pointer
+        Shader,         // BSImagespaceShaderCopyShadowMapToArray, up to +0x1D8
+        FlatEntries,    // flat cascade array, 0x110 per entry
+        VREntries,      // VR cascade array, 0x180 per entry
+        DescEntries,    // shadow map pointers behind a descriptor array
+        Count
+    };
+
+    enum RegionFlags : uint16_t
+    {
+        ModuleRelative = 1,     // addr is an RVA
+    };
+
+    struct Header
+    {
+        uint32_t magic;
+        uint16_t version;
+        uint16_t siteCount;
+        uint32_t regionCount;
+        uint32_t skipped;           // regions whose read faulted
+        uint64_t moduleBase;
+        uint32_t steps;             // StepScheduler::State() at capture
+        uint32_t captureUs;
+        char     label[16];
+    };
+    static_assert(sizeof(Header) == 48, "snapshot header layout changed");
+
+    struct RegionHeader
+    {
+        uint64_t addr;
+        uint32_t size;
+        Kind     kind;
+        uint16_t flags;
+    };
+    static_assert(sizeof(RegionHeader) == 16, "snapshot region layout changed");
+
+    // Copies `size` bytes at `addr` into `dst`; false if the memory is not readable
+    using ReadFn = bool (*)(void* dst, uintptr_t addr, size_t size, void* context);
+
+    // Builds a snapshot into caller-owned storage
+    class Writer
+    {
+    public:
+        void Init(uint8_t* storage, size_t capacity, uintptr_t moduleBase, const char* label);
+
+        void SetSites(const SigScan::Resolution* sites, size_t count);
+        void SetSteps(uint32_t steps) { Head()->steps = steps; }
+        void SetCaptureUs(uint32_t us) { Head()->captureUs = us; }
+
+        // Reads and appends one region; a region already stored at `addr`
+        // is not stored twice. Returns the stored bytes, nullptr if the read
+        // faulted or the storage is full.
+        const uint8_t* Add(Kind kind, uintptr_t addr, size_t size, bool moduleRelative, ReadFn read, void* context);
+
+        const uint8_t* Data() const { return _data; }
+        size_t Size() const { return _size; }
+        uint32_t Regions() const { return Head()->regionCount; }
+        uint32_t Skipped() const { return Head()->skipped; }
+
+    private:
+        Header* Head() const { return reinterpret_cast<Header*>(_data); }
+
+        uint8_t* _data = nullptr;
+        size_t _capacity = 0;
+        size_t _size = 0;
+        size_t _regionsStart = 0;
+    };
+
+    // Walks the module globals, scene nodes, cascade groups, shaders, flat
+    // and VR arrays and the descriptor arrays into `out`. Sites must be set
+    // first; their code bytes are captured too.
+    void Capture(Writer& out, ReadFn read, void* context);
+
+    struct Region
+    {
+        uintptr_t      addr;        // RVA if ModuleRelative
+        size_t         size;
+        Kind           kind;
+        uint16_t       flags;
+        const uint8_t* bytes;
+    };
+
+    // Reads a snapshot file image in place
+    class Reader
+    {
+    public:
+        bool Open(const uint8_t* data, size_t size);
+
+        const Header& Head() const { return *reinterpret_cast<const Header*>(_data); }
+        uint32_t SiteRVA(size_t id) const;
+
+        // Iterates the regions from the first; false after the last
+        void Rewind() { _next = _regionsStart; }
+        bool Next(Region& out);
+
+    private:
+        const uint8_t* _data = nullptr;
+        size_t _size = 0;
+        size_t _regionsStart = 0;
+        size_t _next = 0;
+        size_t _end = 0;
+    };
+
+    const char* KindName(Kind kind);
+}
@@ -0,0 +1,228 @@
+#include "game_state.h"
+
+#include <cstring>
+
+namespace CascadePatch::GameState
+{
+    template <typename T>
+    static T& At(uintptr_t addr)
+    {
+        return *reinterpret_cast<T*>(addr);
+    }
+
+    VRArray ReadVRArray(uintptr_t base)
+    {
+        using namespace VRArrayExpansion;
+        VRArray a;
+        a.buf = At<uintptr_t>(base + ArrayPtr);
+        a.capacity = At<uint32_t>(base + ArrayPtr + 8);
+        a.count = At<uint32_t>(base + ArrayCount);
+        return a;
+    }
+
+    void CopyVREntry(uintptr_t dst, uintptr_t src)
+    {
+        using namespace VRArrayExpansion;
+        memcpy(reinterpret_cast<void*>(dst), reinterpret_cast<const void*>(src), EntrySize);
+
+        // Pool lists must point at their own entry: empty head, tail -> head
+        for (size_t poolOff : PoolOffsets) {
+            At<uintptr_t>(dst + poolOff) = 0;
+            At<uintptr_t>(dst + poolOff + 8) = dst + poolOff;
+        }
+
+        // Spinlock (thread ID + lock count)
+        At<uint32_t>(dst + 0x00) = 0;
+        At<uint32_t>(dst + 0x04) = 0;
+    }
+
+    ExpandResult ExpandVRArray(uintptr_t base, void* (*allocate)(size_t size))
+    {
+        using namespace VRArrayExpansion;
+        ExpandResult r;
+        r.before = ReadVRArray(base);
+        uintptr_t buf = r.before.buf;
+        if (buf == 0) return r;
+
+        if (r.before.capacity >= TargetCount) {
+            // Entry 0 is fully initialized by the game; entries 2-3 may have
+            // incomplete pool metadata causing render node corruption
+            for (uint32_t i = 2; i < TargetCount; i++) {
+                CopyVREntry(buf + i * EntrySize, buf);
+                r.entriesFixed++;
+            }
+
+            // Entries 0-1 keep their data but need valid pool tails
+            for (uint32_t i = 0; i < 2; i++) {
+                uintptr_t entry = buf + i * EntrySize;
+                for (size_t poolOff : PoolOffsets) {
+                    uintptr_t& tail = At<uintptr_t>(entry + poolOff + 8);
+                    if (tail == 0) tail = entry + poolOff;
+                }
+            }
+
+            if (r.before.count < TargetCount) At<uint32_t>(base + ArrayCount) = TargetCount;
+            r.result = Expand::InPlace;
+            return r;
+        }
+
+        // Capacity < 4 (shouldn't happen with the count=4 patches)
+        void* newBuf = allocate(TargetCount * EntrySize);
+        if (!newBuf) {
+            r.result = Expand::AllocFailed;
+            return r;
+        }
+
+        // Every existing entry (capacity, not count), then entry 0 as template
+        uintptr_t dst = reinterpret_cast<uintptr_t>(newBuf);
+        memcpy(newBuf, reinterpret_cast<const void*>(buf), r.before.capacity * EntrySize);
+        for (uint32_t i = r.before.capacity; i < TargetCount; i++) {
+            CopyVREntry(dst + i * EntrySize, dst);
+            r.entriesFixed++;
+        }
+
+        At<uintptr_t>(base + ArrayPtr) = dst;
+        At<uint32_t>(base + ArrayCount) = TargetCount;
+        r.newBuf = dst;
+        r.result = Expand::Reallocated;
+        return r;
+    }
+
+    RefreshResult RefreshVRArrayEntries(uintptr_t base)
+    {
+        using namespace VRArrayExpansion;
+        RefreshResult r;
+        uintptr_t buf = At<uintptr_t>(base + ArrayPtr);
+        if (buf == 0) return r;
+
+        const uint8_t* entries = reinterpret_cast<const uint8_t*>(buf);
+        r.changedWords = Watch::ChangedWords(entries, entries + 2 * EntrySize, EntrySize) & VREntryDataWords;
+        if (!r.changedWords) return r;
+
+        for (uint32_t i = 0; i < TargetCount; i++) {
+            r.nonZeroBefore[i] = Watch::NonZeroBytes(entries + i * EntrySize, EntrySize);
+        }
+
+        // 0 -> 2, 1 -> 3: far cascades get the near cascades' per-eye data,
+        // which the game's per-frame update then adjusts
+        for (uint32_t i = 2; i < TargetCount; i++) {
+            CopyVREntry(buf + i * EntrySize, buf + (i - 2) * EntrySize);
+        }
+
+        for (uint32_t i = 0; i < TargetCount; i++) {
+            r.nonZeroAfter[i] = Watch::NonZeroBytes(entries + i * EntrySize, EntrySize);
+        }
+        r.refreshed = true;
+        return r;
+    }
+
+    SceneNodeResult FixSetupSceneNode(uintptr_t base)
+    {
+        SceneNodeResult r;
+        r.renderNode = At<uintptr_t>(base + ShadowSceneNodePtr);
+        if (r.renderNode == 0) return r;
+
+        if (At<uintptr_t>(base + ShadowSceneNodePtr2) != 0) {
+            r.result = SceneNode::AlreadySet;
+            return r;
+        }
+
+        // .data is already read/write
+        At<volatile uintptr_t>(base + ShadowSceneNodePtr2) = r.renderNode;
+        r.cascadeGroup = At<uintptr_t>(r.renderNode + CascadeGroupOffset);
+        r.result = SceneNode::Copied;
+        return r;
+    }
+
+    bool ForceShaderFields(uintptr_t base, ShaderResult (&out)[2])
+    {
+        const uintptr_t nodes[] = { ShadowSceneNodePtr, ShadowSceneNodePtr2 };
+        for (int n = 0; n < 2; n++) {
+            ShaderResult& s = out[n];
+            s = ShaderResult{};
+
+            uintptr_t sceneNode = At<uintptr_t>(base + nodes[n]);
+            if (sceneNode == 0) continue;
+            uintptr_t cg = At<uintptr_t>(sceneNode + CascadeGroupOffset);
+            if (cg == 0) continue;
+            uintptr_t shader = At<uintptr_t>(cg + ShaderObjectOffset);
+            if (shader == 0) continue;
+
+            s.shader = shader;
+            uint32_t& stored = At<uint32_t>(shader + 0x1D8);
+            uint16_t& capacity = At<uint16_t>(shader + 0x168);
+            uint16_t& count = At<uint16_t>(shader + 0x16A);
+            s.stored = stored;
+            s.capacity = capacity;
+            s.count = count;
+
+            if (stored < 4)   { stored = 4;   s.forced |= ShaderStored; }
+            if (capacity < 4) { capacity = 4; s.forced |= ShaderCap; }
+            if (count < 4)    { count = 4;    s.forced |= ShaderCount; }
+        }
+        return out[0].shader != 0;
+    }
+
+    bool ForceCascadeGroups(uintptr_t base)
+    {
+        uintptr_t renderNode = At<uintptr_t>(base + ShadowSceneNodePtr);
+        if (renderNode == 0) return false;
+        uintptr_t cg1 = At<uintptr_t>(renderNode + CascadeGroupOffset);
+        if (cg1 == 0) return false;
+
+        uint8_t& flag1 = At<uint8_t>(cg1 + CascadeGroupVRFlag);
+        if (flag1 == 0) flag1 = 1;
+
+        // Same object as the render group once the setup node is fixed
+        uintptr_t setupNode = At<uintptr_t>(base + ShadowSceneNodePtr2);
+        if (setupNode != 0) {
+            uintptr_t cg2 = At<uintptr_t>(setupNode + CascadeGroupOffset);
+            if (cg2 != 0) {
+                uint8_t& flag2 = At<uint8_t>(cg2 + CascadeGroupVRFlag);
+                if (flag2 == 0) flag2 = 1;
+            }
+        }
+        return true;
+    }
+
+    bool ReadFlatArray(uintptr_t base, FlatArray& out)
+    {
+        uintptr_t sceneNode = At<uintptr_t>(base + ShadowSceneNodePtr);
+        if (sceneNode == 0) return false;
+        out.cascadeGroup = At<uintptr_t>(sceneNode + CascadeGroupOffset);
+        if (out.cascadeGroup == 0) return false;
+        out.count = At<uint32_t>(out.cascadeGroup + FlatCountOffset);
+        out.buf = At<uintptr_t>(out.cascadeGroup + FlatBufferOffset);
+        return true;
+    }
+
+    bool FlatArrayReady(const FlatArray& flat)
+    {
+        if (flat.buf == 0 || flat.count < 4) return false;
+        for (uint32_t i = 0; i < 4; i++) {
+            if (At<uintptr_t>(flat.buf + i * FlatEntrySize + FlatShadowMapOff) == 0) return false;
+        }
+        return true;
+    }
+
+    const char* ExpandName(Expand e)
+    {
+        switch (e) {
+        case Expand::NotAllocated: return "not allocated";
+        case Expand::InPlace:      return "in place";
+        case Expand::Reallocated:  return "reallocated";
+        case Expand::AllocFailed:  return "allocation failed";
+        }
+        return "?";
+    }
+
+    const char* SceneNodeName(SceneNode s)
+    {
+        switch (s) {
+        case SceneNode::NoRenderNode: return "no render node";
+        case SceneNode::AlreadySet:   return "already set";
+        case SceneNode::Copied:       return "copied";
+        }
+        return "?";
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include "cascade_patch.h"
+#include "region_watch.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Game object fixes
+// The data-side half of the preloader: VR cascade array expansion and
+// refresh, the setup scene node, cascade group flags, ISCopy shader fields and
+// the flat array readiness check. Every function takes the module base and
+// reads and writes game memory directly, so the same code runs against the
+// live game and against a snapshot mapped by tools/snapshot_replay. Results
+// come back as structs for the caller to log; nothing here logs.
+// Reads are unguarded: Windows callers wrap each call in __try.
+// =============================================================================
+
+namespace CascadePatch::GameState
+{
+    // DAT_146878b18 container: buffer, capacity, count (see VRArrayExpansion)
+    struct VRArray
+    {
+        uintptr_t buf = 0;
+        uint32_t  capacity = 0;
+        uint32_t  count = 0;
+    };
+
+    VRArray ReadVRArray(uintptr_t base);
+
+    // Words of a VR entry that hold per-eye data: everything but the
+    // spinlock and the pool list heads/tails, which differ between any two
+    // entries (see CopyVREntry)
+    constexpr uint64_t VREntryWords()
+    {
+        using namespace VRArrayExpansion;
+        uint64_t words = Watch::Words(0, EntrySize) & ~Watch::Words(0x00, 8);
+        for (size_t poolOff : PoolOffsets) words &= ~Watch::Words(poolOff, 16);
+        return words;
+    }
+    inline constexpr uint64_t VREntryDataWords = VREntryWords();
+    static_assert(VRArrayExpansion::EntrySize <= Watch::MaxRegionBytes);
+
+    // Copies one 0x180-byte VR entry over another, then points the copy's
+    // pool lists back at itself and clears its spinlock
+    void CopyVREntry(uintptr_t dst, uintptr_t src);
+
+    enum class Expand : uint8_t
+    {
+        NotAllocated,   // the game has not created the array yet
+        InPlace,        // capacity already 4: entries 2-3 template-copied
+        Reallocated,    // moved to a 4-entry buffer from `allocate`
+        AllocFailed,
+    };
+
+    struct ExpandResult
+    {
+        Expand    result = Expand::NotAllocated;
+        VRArray   before;
+        uintptr_t newBuf = 0;           // Reallocated only
+        uint32_t  entriesFixed = 0;     // entries template-copied from entry 0
+    };
+
+    // Grows the VR cascade array to VRArrayExpansion::TargetCount entries.
+    // `allocate` returns zeroed read/write memory, or nullptr.
+    ExpandResult ExpandVRArray(uintptr_t base, void* (*allocate)(size_t size));
+
+    struct RefreshResult
+    {
+        bool     refreshed = false;         // entries 0-1 copied to 2-3
+        uint64_t changedWords = 0;          // VREntryDataWords where entry 0 differs from entry 2
+        uint32_t nonZeroBefore[VRArrayExpansion::TargetCount] = {};
+        uint32_t nonZeroAfter[VRArrayExpansion::TargetCount] = {};
+    };
+
+    // Copies entries 0-1 over 2-3 once the game has written entry 0 since the
+    // template copy: entry 2 still holds that copy, so any data word that
+    // differs between them is the game's. Non-zero counts are only taken
+    // when the copy happens, for the log.
+    RefreshResult RefreshVRArrayEntries(uintptr_t base);
+
+    enum class SceneNode : uint8_t
+    {
+        NoRenderNode,   // DAT_146879520 not set yet
+        AlreadySet,     // DAT_146885d40 already holds a node
+        Copied,         // render node copied into the setup slot
+    };
+
+    struct SceneNodeResult
+    {
+        SceneNode result = SceneNode::NoRenderNode;
+        uintptr_t renderNode = 0;
+        uintptr_t cascadeGroup = 0;     // Copied only: render node+0x248
+    };
+
+    SceneNodeResult FixSetupSceneNode(uintptr_t base);
+
+    // One scene node's ISCopy shader: values found, and which were raised to 4
+    enum ShaderField : uint8_t
+    {
+        ShaderStored = 1,   // shader+0x1D8, uint32
+        ShaderCap    = 2,   // shader+0x168, uint16
+        ShaderCount  = 4,   // shader+0x16A, uint16
+    };
+
+    struct ShaderResult
+    {
+        uintptr_t shader = 0;           // 0 if the node, group or shader is missing
+        uint32_t  stored = 0;
+        uint16_t  capacity = 0;
+        uint16_t  count = 0;
+        uint8_t   forced = 0;           // ShaderField bits
+    };
+
+    // [0] render node, [1] setup node. True once the render node's shader
+    // exists (its fields are then all at least 4).
+    bool ForceShaderFields(uintptr_t base, ShaderResult (&out)[2]);
+
+    // cascade_group+0x173 = 1 on the render node's group and, if set, the
+    // setup node's. False while the render node or its group is missing.
+    bool ForceCascadeGroups(uintptr_t base);
+
+    // Render scene node -> cascade group -> flat cascade array
+    struct FlatArray
+    {
+        uintptr_t cascadeGroup = 0;
+        uintptr_t buf = 0;
+        uint32_t  count = 0;
+    };
+
+    bool ReadFlatArray(uintptr_t base, FlatArray& out);
+
+    // 4 flat entries, each with a left shadow map
+    bool FlatArrayReady(const FlatArray& flat);
+
+    const char* ExpandName(Expand e);
+    const char* SceneNodeName(SceneNode s);
+}
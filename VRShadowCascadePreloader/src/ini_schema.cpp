@@ -0,0 +1,234 @@
+#include "ini_schema.h"
+#include "offset_cache.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+
+namespace CascadePatch
+{
+    namespace
+    {
+        constexpr uint64_t FnvBasis = 0xCBF29CE484222325ull;
+        constexpr uint64_t FnvPrime = 0x100000001B3ull;
+
+        char Lower(char c) { return c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c; }
+
+        // FNV-1a of "section\x1Fkey", lowercased as it goes
+        uint64_t KeyHash(std::string_view section, std::string_view key)
+        {
+            uint64_t h = FnvBasis;
+            for (char c : section) h = (h ^ static_cast<uint8_t>(Lower(c))) * FnvPrime;
+            h = (h ^ 0x1Fu) * FnvPrime;
+            for (char c : key) h = (h ^ static_cast<uint8_t>(Lower(c))) * FnvPrime;
+            return h;
+        }
+
+        bool EqualNoCase(std::string_view a, std::string_view b)
+        {
+            if (a.size() != b.size()) return false;
+            for (size_t i = 0; i < a.size(); i++) {
+                if (Lower(a[i]) != Lower(b[i])) return false;
+            }
+            return true;
+        }
+
+        void AppendFloat(std::string& out, float v)
+        {
+            char buffer[32];
+            auto r = std::to_chars(buffer, buffer + sizeof(buffer), v);
+            std::string_view s(buffer, static_cast<size_t>(r.ptr - buffer));
+            out += s;
+            if (s.find_first_of(".eEn") == std::string_view::npos) out += ".0";
+        }
+    }
+
+    IniSchema::IniSchema(const IniField* fields, size_t count, size_t structSize)
+        : _fields(fields), _count(count), _structSize(structSize)
+    {
+        _index.reserve(count);
+        _hash = OffsetCache::Fnv1a(&structSize, sizeof(structSize));
+        for (size_t i = 0; i < count; i++) {
+            const IniField& f = fields[i];
+            _index.push_back({ KeyHash(f.section, f.key), static_cast<uint32_t>(i) });
+            _hash = OffsetCache::Fnv1a(f.section, strlen(f.section) + 1, _hash);
+            _hash = OffsetCache::Fnv1a(f.key, strlen(f.key) + 1, _hash);
+            const double numbers[] = { static_cast<double>(f.type), static_cast<double>(f.offset), f.def, f.min, f.max };
+            _hash = OffsetCache::Fnv1a(numbers, sizeof(numbers), _hash);
+        }
+        std::sort(_index.begin(), _index.end(), [](const Slot& a, const Slot& b) { return a.hash < b.hash; });
+    }
+
+    const IniField* IniSchema::Find(std::string_view section, std::string_view key) const
+    {
+        uint64_t h = KeyHash(section, key);
+        auto it = std::lower_bound(_index.begin(), _index.end(), h, [](const Slot& s, uint64_t v) { return s.hash < v; });
+        for (; it != _index.end() && it->hash == h; ++it) {
+            const IniField& f = _fields[it->field];
+            if (EqualNoCase(section, f.section) && EqualNoCase(key, f.key)) return &f;
+        }
+        return nullptr;
+    }
+
+    size_t IniSchema::Load(void* values, std::string_view text) const
+    {
+        size_t applied = 0;
+        ForEachIniValue(text, [&](std::string_view section, std::string_view key, std::string_view value) {
+            const IniField* f = Find(section, key);
+            if (!f) return;
+            bool ok = false;
+            switch (f->type) {
+            case IniType::Bool: {
+                bool b;
+                if ((ok = ParseBool(value, b))) Set(*f, values, b ? 1.0 : 0.0);
+                break;
+            }
+            case IniType::Int: {
+                int32_t i;
+                if ((ok = ParseInt(value, i))) Set(*f, values, i);
+                break;
+            }
+            case IniType::Float: {
+                float v;
+                if ((ok = ParseFloat(value, v))) Set(*f, values, v);
+                break;
+            }
+            }
+            applied += ok;
+        });
+        return applied;
+    }
+
+    void IniSchema::Save(const void* values, std::string& out) const
+    {
+        const char* section = nullptr;
+        for (size_t i = 0; i < _count; i++) {
+            const IniField& f = _fields[i];
+            if (!section || strcmp(section, f.section) != 0) {
+                if (section) out += '\n';
+                section = f.section;
+                out += '[';
+                out += section;
+                out += "]\n";
+            }
+            out += f.key;
+            out += " = ";
+            double v = Get(f, values);
+            switch (f.type) {
+            case IniType::Bool:  out += v != 0.0 ? "true" : "false"; break;
+            case IniType::Int:   out += std::to_string(static_cast<int32_t>(v)); break;
+            case IniType::Float: AppendFloat(out, static_cast<float>(v)); break;
+            }
+            out += '\n';
+        }
+    }
+
+    void IniSchema::SetDefaults(void* values) const
+    {
+        for (size_t i = 0; i < _count; i++) Set(_fields[i], values, _fields[i].def);
+    }
+
+    double IniSchema::Get(const IniField& f, const void* values)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(values) + f.offset;
+        switch (f.type) {
+        case IniType::Bool: {
+            bool b;
+            memcpy(&b, p, sizeof(b));
+            return b ? 1.0 : 0.0;
+        }
+        case IniType::Int: {
+            int32_t i;
+            memcpy(&i, p, sizeof(i));
+            return i;
+        }
+        case IniType::Float: {
+            float v;
+            memcpy(&v, p, sizeof(v));
+            return v;
+        }
+        }
+        return 0.0;
+    }
+
+    void IniSchema::Set(const IniField& f, void* values, double v)
+    {
+        uint8_t* p = static_cast<uint8_t*>(values) + f.offset;
+        if (f.type == IniType::Bool) {
+            bool b = v != 0.0;
+            memcpy(p, &b, sizeof(b));
+            return;
+        }
+        if (std::isnan(v)) return;
+        v = std::clamp(v, f.min, f.max);
+        if (f.type == IniType::Int) {
+            int32_t i = static_cast<int32_t>(std::llround(std::clamp(v, -2147483648.0, 2147483647.0)));
+            memcpy(p, &i, sizeof(i));
+        } else {
+            float x = static_cast<float>(v);
+            memcpy(p, &x, sizeof(x));
+        }
+    }
+
+    // SimpleIni::GetBoolValue: decided by the first letter ("on"/"off" by two)
+    bool IniSchema::ParseBool(std::string_view s, bool& out)
+    {
+        if (s.empty()) return false;
+        switch (s[0]) {
+        case 't': case 'T': case 'y': case 'Y': case '1':
+            out = true;
+            return true;
+        case 'f': case 'F': case 'n': case 'N': case '0':
+            out = false;
+            return true;
+        case 'o': case 'O':
+            if (s.size() < 2) return false;
+            if (s[1] == 'n' || s[1] == 'N') out = true;
+            else if (s[1] == 'f' || s[1] == 'F') out = false;
+            else return false;
+            return true;
+        }
+        return false;
+    }
+
+    // SimpleIni::GetLongValue: 0x hex or signed decimal, the whole value or
+    // nothing; out of range saturates like strtol with a 32-bit long
+    bool IniSchema::ParseInt(std::string_view s, int32_t& out)
+    {
+        int base = 10;
+        bool negative = false;
+        if (s.size() > 2 && s[0] == '0' && (s[1] == 'x' || s[1] == 'X')) {
+            base = 16;
+            s.remove_prefix(2);
+        } else if (!s.empty() && (s[0] == '+' || s[0] == '-')) {
+            negative = s[0] == '-';
+            s.remove_prefix(1);
+        }
+        if (s.empty()) return false;
+
+        uint64_t magnitude = 0;
+        auto r = std::from_chars(s.data(), s.data() + s.size(), magnitude, base);
+        if (r.ptr != s.data() + s.size()) return false;
+        if (r.ec == std::errc::result_out_of_range) magnitude = UINT64_MAX;
+        else if (r.ec != std::errc{}) return false;
+
+        int64_t v = negative ? -static_cast<int64_t>(std::min<uint64_t>(magnitude, 2147483648ull))
+                             : static_cast<int64_t>(std::min<uint64_t>(magnitude, 2147483647ull));
+        out = static_cast<int32_t>(v);
+        return true;
+    }
+
+    // SimpleIni::GetDoubleValue (strtod): the whole value or nothing; NaN and
+    // values beyond double range are rejected
+    bool IniSchema::ParseFloat(std::string_view s, float& out)
+    {
+        if (!s.empty() && s[0] == '+') s.remove_prefix(1);
+        if (s.empty()) return false;
+        double v = 0.0;
+        auto r = std::from_chars(s.data(), s.data() + s.size(), v);
+        if (r.ec != std::errc{} || r.ptr != s.data() + s.size() || std::isnan(v)) return false;
+        out = static_cast<float>(std::clamp(v, -3.0e38, 3.0e38));
+        return true;
+    }
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+// =============================================================================
+// Settings schema and single-pass INI reader
+// A settings struct is described once, as a constexpr table of IniField:
+// section, key, type, offset in the struct, default and range. IniSchema
+// generates both directions from it. Load() applies INI text to the struct,
+// Save() writes the struct back as INI text, and the plugin drives its
+// SimpleIni overrides from the same table.
+// Load() makes one pass over the text and allocates nothing. Sections, keys
+// and values are views into the caller's buffer (a mapped file or a read
+// buffer). A key is found by a case-insensitive hash of section and key, and
+// numbers are parsed with from_chars. Value syntax follows SimpleIni's
+// GetBoolValue/GetLongValue/GetDoubleValue, so both readers agree on every
+// file: a value that does not parse keeps the current one, and a parsed
+// value is clamped to the field's range. Fields are offsets rather than
+// member pointers so array elements (block levels) can be fields too.
+// Hash() covers the whole table, for caches of the loaded struct
+// (config_blob.h). tools/ini_schema_check tests it and times Load().
+// =============================================================================
+
+namespace CascadePatch
+{
+    enum class IniType : uint8_t
+    {
+        Bool,
+        Int,    // int32_t
+        Float,  // float
+    };
+
+    template <typename V>
+    constexpr IniType IniTypeOf()
+    {
+        if constexpr (std::is_same_v<V, bool>) return IniType::Bool;
+        else if constexpr (std::is_same_v<V, int32_t>) return IniType::Int;
+        else {
+            static_assert(std::is_same_v<V, float>, "settings are bool, int32_t or float");
+            return IniType::Float;
+        }
+    }
+
+    // Range of a field that is not clamped
+    constexpr double IniUnbounded = 1e30;
+
+    struct IniField
+    {
+        const char* section;
+        const char* key;
+        IniType     type;
+        uint32_t    offset;     // into the settings struct
+        double      def;
+        double      min;
+        double      max;
+    };
+
+    // Calls fn(section, key, value) for every key line, in file order, with
+    // views into `text` (section as written, all three trimmed). A UTF-8 BOM,
+    // comment lines (';', '#') and lines without '=' are skipped.
+    template <typename Fn>
+    void ForEachIniValue(std::string_view text, Fn&& fn)
+    {
+        auto trim = [](std::string_view s) {
+            size_t b = 0, e = s.size();
+            while (b < e && (s[b] == ' ' || s[b] == '\t' || s[b] == '\r')) b++;
+            while (e > b && (s[e - 1] == ' ' || s[e - 1] == '\t' || s[e - 1] == '\r')) e--;
+            return s.substr(b, e - b);
+        };
+        if (text.substr(0, 3) == "\xEF\xBB\xBF") text.remove_prefix(3);
+        std::string_view section;
+        while (!text.empty()) {
+            size_t eol = text.find('\n');
+            std::string_view line = trim(text.substr(0, eol));
+            text = eol == std::string_view::npos ? std::string_view{} : text.substr(eol + 1);
+
+            if (line.empty() || line[0] == ';' || line[0] == '#') continue;
+            if (line[0] == '[') {
+                size_t close = line.find(']');
+                section = trim(line.substr(1, close == std::string_view::npos ? line.size() - 1 : close - 1));
+                continue;
+            }
+            size_t eq = line.find('=');
+            if (eq == std::string_view::npos) continue;
+            fn(section, trim(line.substr(0, eq)), trim(line.substr(eq + 1)));
+        }
+    }
+
+    class IniSchema
+    {
+    public:
+        // `fields` must outlive the schema; structSize is sizeof the struct
+        IniSchema(const IniField* fields, size_t count, size_t structSize);
+        template <size_t N>
+        IniSchema(const IniField (&fields)[N], size_t structSize) : IniSchema(fields, N, structSize) {}
+
+        // Applies every known key in `text`; unknown keys are ignored and a
+        // key set twice keeps its last value. Returns the values applied.
+        size_t Load(void* values, std::string_view text) const;
+
+        // All fields as INI text, one section header per run of fields
+        void Save(const void* values, std::string& out) const;
+
+        void SetDefaults(void* values) const;
+        const IniField* Find(std::string_view section, std::string_view key) const;
+
+        const IniField* Fields() const { return _fields; }
+        size_t Count() const { return _count; }
+        size_t StructSize() const { return _structSize; }
+        uint64_t Hash() const { return _hash; }
+
+        // One field as a double, and back (clamped, rounded for Int)
+        static double Get(const IniField& f, const void* values);
+        static void Set(const IniField& f, void* values, double v);
+
+        // SimpleIni's value syntax; false leaves `out` untouched
+        static bool ParseBool(std::string_view s, bool& out);
+        static bool ParseInt(std::string_view s, int32_t& out);
+        static bool ParseFloat(std::string_view s, float& out);
+
+    private:
+        struct Slot
+        {
+            uint64_t hash;
+            uint32_t field;
+        };
+
+        const IniField*   _fields;
+        size_t            _count;
+        size_t            _structSize;
+        std::vector<Slot> _index;   // sorted by hash
+        uint64_t          _hash;
+    };
+}
@@ -0,0 +1,86 @@
+#include "log_ring.h"
+
+namespace CascadePatch
+{
+    static_assert((LogRing::Slots & (LogRing::Slots - 1)) == 0, "Slots must be a power of two");
+
+    LogRing::LogRing()
+    {
+        for (size_t i = 0; i < Slots; i++) {
+            _slots[i].seq.store(i, std::memory_order_relaxed);
+            _slots[i].length = 0;
+        }
+    }
+
+    bool LogRing::Push(const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        bool ok = PushV(format, args);
+        va_end(args);
+        return ok;
+    }
+
+    bool LogRing::PushV(const char* format, va_list args)
+    {
+        // Bounded-queue slot claim: a slot is free for ticket t when its
+        // sequence equals t, and holds a record for the consumer at t + 1
+        uint64_t pos = _head.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &_slots[pos & (Slots - 1)];
+            uint64_t seq = slot->seq.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq - pos);
+            if (diff == 0) {
+                if (_head.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                _overflows.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = _head.load(std::memory_order_relaxed);
+            }
+        }
+
+        int n = vsnprintf(slot->text, RecordSize, format, args);
+        if (n < 0) n = 0;
+        slot->length = static_cast<uint16_t>(n < static_cast<int>(RecordSize) ? n : RecordSize - 1);
+        slot->seq.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    size_t LogRing::Drain(FILE* out, Echo echo, bool force)
+    {
+        bool expected = false;
+        if (!_draining.compare_exchange_strong(expected, true, std::memory_order_acquire)) {
+            if (!force) return 0;
+            _draining.exchange(true, std::memory_order_acquire);
+        }
+
+        size_t count = 0;
+        for (;;) {
+            Slot& slot = _slots[_tail & (Slots - 1)];
+            if (slot.seq.load(std::memory_order_acquire) != _tail + 1) break;  // empty or still being written
+
+            if (out) {
+                fwrite(slot.text, 1, slot.length, out);
+                fputc('\n', out);
+            }
+            if (echo) echo(slot.text, slot.length);
+
+            slot.seq.store(_tail + Slots, std::memory_order_release);
+            _tail++;
+            count++;
+        }
+
+        if (count && out) fflush(out);
+        _written.fetch_add(count, std::memory_order_relaxed);
+        _draining.store(false, std::memory_order_release);
+        return count;
+    }
+
+    size_t LogRing::Pending() const
+    {
+        // Dropped records never took a ticket; claimed-but-unwritten ones count
+        return static_cast<size_t>(_head.load(std::memory_order_relaxed) - _written.load(std::memory_order_relaxed));
+    }
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstdarg>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+// =============================================================================
+// Multi-producer / single-consumer log ring
+// Producers claim a slot with one CAS and format straight into it; nothing
+// blocks and nothing touches the disk. A consumer (the background writer, or
+// a caller at a flush point) drains committed records to a FILE in one
+// buffered batch. A full ring makes Push() fail (counted in Overflows());
+// the caller decides whether to drain on its own thread or drop the line.
+// =============================================================================
+
+namespace CascadePatch
+{
+    class LogRing
+    {
+    public:
+        static constexpr size_t Slots      = 1024;  // power of two
+        static constexpr size_t RecordSize = 512;   // including the terminator
+
+        // Called once per record while draining, e.g. OutputDebugStringA
+        using Echo = void (*)(const char* text, size_t length);
+
+        LogRing();
+        LogRing(const LogRing&) = delete;
+        LogRing& operator=(const LogRing&) = delete;
+
+        // Lock-free; false if the ring is full. Lines longer than
+        // RecordSize - 1 are truncated.
+        bool Push(const char* format, ...);
+        bool PushV(const char* format, va_list args);
+
+        // Writes every committed record to `out` (may be null) followed by a
+        // newline, then flushes it once. Records are consumed in push order.
+        // Only one consumer drains at a time: without `force` a busy ring
+        // returns 0 at once. `force` takes the consumer role over from a
+        // thread that is known to be gone (the writer, killed mid-drain at
+        // process exit); never use it while another consumer may be running.
+        size_t Drain(FILE* out, Echo echo = nullptr, bool force = false);
+
+        size_t   Pending() const;
+        uint64_t Overflows() const { return _overflows.load(std::memory_order_relaxed); }
+        uint64_t Written() const { return _written.load(std::memory_order_relaxed); }
+
+    private:
+        struct alignas(64) Slot
+        {
+            std::atomic<uint64_t> seq;
+            uint16_t length;
+            char text[RecordSize];
+        };
+
+        Slot _slots[Slots];
+        alignas(64) std::atomic<uint64_t> _head{ 0 };   // next ticket for producers
+        alignas(64) uint64_t _tail = 0;                 // next record to drain
+        std::atomic<bool> _draining{ false };
+        std::atomic<uint64_t> _overflows{ 0 };
+        std::atomic<uint64_t> _written{ 0 };
+    };
+}
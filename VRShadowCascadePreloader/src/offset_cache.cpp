@@ -0,0 +1,112 @@
+#include "offset_cache.h"
+#include "os_file.h"
+#include <cstring>
+#include <vector>
+
+namespace CascadePatch::OffsetCache
+{
+    uint64_t Fnv1a(const void* data, size_t size, uint64_t seed)
+    {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        uint64_t h = seed;
+        for (size_t i = 0; i < size; i++) {
+            h ^= p[i];
+            h *= 0x100000001B3ull;
+        }
+        return h;
+    }
+
+    template <typename T>
+    static uint64_t HashValue(uint64_t h, const T& v)
+    {
+        return Fnv1a(&v, sizeof(v), h);
+    }
+
+    static uint64_t HashTable(const SigScan::Signature* table, size_t count)
+    {
+        uint64_t h = Fnv1a(nullptr, 0);
+        for (size_t i = 0; i < count; i++) {
+            const SigScan::Signature& sig = table[i];
+            h = Fnv1a(sig.source, strlen(sig.source), h);
+            h = HashValue(h, static_cast<uint64_t>(sig.hintRVA));
+            h = HashValue(h, sig.siteOffset);
+            h = HashValue(h, sig.derivedFrom);
+            h = HashValue(h, sig.xrefTarget);
+            h = HashValue(h, sig.dispOffset);
+            h = HashValue(h, sig.instrEnd);
+            h = HashValue(h, sig.ordinal);
+            h = HashValue(h, sig.expectedHits);
+            h = HashValue(h, sig.flags);
+        }
+        return h;
+    }
+
+    bool ComputeFingerprint(const uint8_t* image, size_t imageSize,
+                            const SigScan::Signature* table, size_t count, Fingerprint& out)
+    {
+        PE::ImageInfo info;
+        if (!PE::ReadImageInfo(image, imageSize, info)) return false;
+
+        size_t tableBytes = static_cast<size_t>(info.sectionCount) * PE::SectionHeaderSize;
+        if (info.sectionTable > imageSize || imageSize - info.sectionTable < tableBytes) return false;
+
+        out.timeDateStamp = info.timeDateStamp;
+        out.sizeOfImage = info.sizeOfImage;
+        out.sectionHash = Fnv1a(image + info.sectionTable, tableBytes);
+        out.tableHash = HashTable(table, count);
+        return true;
+    }
+
+    Status Load(const char* path, const Fingerprint& fp, uint32_t* rvas, size_t count)
+    {
+        OS::MappedFile file;
+        if (!file.Open(path)) return Status::Missing;
+
+        Header header;
+        if (file.Size() < sizeof(header)) return Status::Corrupt;
+        memcpy(&header, file.Data(), sizeof(header));
+
+        if (header.magic != Magic || header.version != Version) return Status::Corrupt;
+        size_t entryBytes = static_cast<size_t>(header.entryCount) * sizeof(uint32_t);
+        if (file.Size() != sizeof(header) + entryBytes) return Status::Corrupt;
+
+        const uint8_t* entries = file.Data() + sizeof(header);
+        if (Fnv1a(entries, entryBytes) != header.checksum) return Status::Corrupt;
+        if (!(header.fingerprint == fp) || header.entryCount != count) return Status::Stale;
+
+        memcpy(rvas, entries, entryBytes);
+        return Status::Ok;
+    }
+
+    bool Save(const char* path, const Fingerprint& fp, const SigScan::Resolution* sites, size_t count)
+    {
+        if (count > UINT16_MAX) return false;
+
+        std::vector<uint8_t> buffer(sizeof(Header) + count * sizeof(uint32_t));
+        uint32_t* entries = reinterpret_cast<uint32_t*>(buffer.data() + sizeof(Header));
+        for (size_t i = 0; i < count; i++) {
+            entries[i] = static_cast<uint32_t>(sites[i].rva);
+        }
+
+        Header header{};
+        header.magic = Magic;
+        header.version = Version;
+        header.entryCount = static_cast<uint16_t>(count);
+        header.fingerprint = fp;
+        header.checksum = Fnv1a(entries, count * sizeof(uint32_t));
+        memcpy(buffer.data(), &header, sizeof(header));
+
+        return OS::WriteFileAtomic(path, buffer.data(), buffer.size());
+    }
+
+    const char* StatusName(Status s)
+    {
+        switch (s) {
+        case Status::Ok:      return "ok";
+        case Status::Missing: return "missing";
+        case Status::Corrupt: return "corrupt";
+        case Status::Stale:   return "stale";
+        }
+        return "?";
+    }
+}
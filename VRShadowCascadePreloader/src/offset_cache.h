@@ -0,0 +1,63 @@
+#pragma once
+
+#include "sig_scan.h"
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// On-disk cache of resolved patch sites
+// Stored next to VRShadowCascade.log and mapped at Initialize(). Keyed by an
+// exe fingerprint (PE timestamp, image size, hash of the section table) plus a
+// hash of the site table itself, so both a game update and an edited
+// cascade_sites.h invalidate it. Cached RVAs are still checked against their
+// pattern before use; a stale entry just falls back to hint/scan.
+//
+// File layout (little endian):
+//   Header  magic "VSOC", version, entry count, fingerprint, entry checksum
+//   uint32  rva[entryCount]   0 = site was not found under this fingerprint
+// =============================================================================
+
+namespace CascadePatch::OffsetCache
+{
+    constexpr uint32_t Magic   = 0x434F5356;  // "VSOC"
+    constexpr uint16_t Version = 1;
+    constexpr const char* FileName = "VRShadowCascade.offsets";
+
+    struct Fingerprint
+    {
+        uint32_t timeDateStamp = 0;
+        uint32_t sizeOfImage   = 0;
+        uint64_t sectionHash   = 0;   // section headers (names, RVAs, sizes, flags)
+        uint64_t tableHash     = 0;   // site table the entries were resolved with
+
+        bool operator==(const Fingerprint&) const = default;
+    };
+
+    struct Header
+    {
+        uint32_t    magic;
+        uint16_t    version;
+        uint16_t    entryCount;
+        Fingerprint fingerprint;
+        uint64_t    checksum;         // FNV-1a of the entry array
+    };
+    static_assert(sizeof(Header) == 40, "cache header layout changed");
+
+    enum class Status : uint8_t { Ok, Missing, Corrupt, Stale };
+
+    uint64_t Fnv1a(const void* data, size_t size, uint64_t seed = 0xCBF29CE484222325ull);
+
+    // Section table hash is taken from the headers only: they are readable
+    // before SteamStub decrypts .text, and an in-place byte edit is still
+    // caught by the per-entry pattern check.
+    bool ComputeFingerprint(const uint8_t* image, size_t imageSize,
+                            const SigScan::Signature* table, size_t count, Fingerprint& out);
+
+    // Maps `path` and copies its entries into rvas[count] if the fingerprint
+    // and entry count match. `rvas` is left untouched otherwise.
+    Status Load(const char* path, const Fingerprint& fp, uint32_t* rvas, size_t count);
+
+    bool Save(const char* path, const Fingerprint& fp, const SigScan::Resolution* sites, size_t count);
+
+    const char* StatusName(Status s);
+}
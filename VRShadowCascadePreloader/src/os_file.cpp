@@ -0,0 +1,201 @@
+#include "os_file.h"
+#include <cstdio>
+#include <string>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace CascadePatch::OS
+{
+#ifdef _WIN32
+    bool MappedFile::Open(const char* path)
+    {
+        Close();
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+            CloseHandle(file);
+            return false;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!view) {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        _file = file;
+        _mapping = mapping;
+        _data = static_cast<const uint8_t*>(view);
+        _size = static_cast<size_t>(size.QuadPart);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (_data) UnmapViewOfFile(_data);
+        if (_mapping) CloseHandle(_mapping);
+        if (_file) CloseHandle(_file);
+        _data = nullptr;
+        _mapping = nullptr;
+        _file = nullptr;
+        _size = 0;
+    }
+
+    bool WritableMapping::Create(const char* path, size_t size)
+    {
+        Close();
+        HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                                  CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return false;
+
+        ULARGE_INTEGER length;
+        length.QuadPart = size;
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READWRITE, length.HighPart, length.LowPart, nullptr);
+        void* view = mapping ? MapViewOfFile(mapping, FILE_MAP_WRITE, 0, 0, size) : nullptr;
+        if (!view) {
+            if (mapping) CloseHandle(mapping);
+            CloseHandle(file);
+            return false;
+        }
+
+        _file = file;
+        _mapping = mapping;
+        _data = static_cast<uint8_t*>(view);
+        _size = size;
+        return true;
+    }
+
+    void WritableMapping::Close()
+    {
+        if (_data) {
+            FlushViewOfFile(_data, 0);
+            UnmapViewOfFile(_data);
+        }
+        if (_mapping) CloseHandle(_mapping);
+        if (_file) CloseHandle(_file);
+        _data = nullptr;
+        _mapping = nullptr;
+        _file = nullptr;
+        _size = 0;
+    }
+
+    static bool ReplaceFile(const char* from, const char* to)
+    {
+        return MoveFileExA(from, to, MOVEFILE_REPLACE_EXISTING) != 0;
+    }
+
+    bool FileStamp(const char* path, uint64_t& size, uint64_t& writeTime)
+    {
+        WIN32_FILE_ATTRIBUTE_DATA data;
+        if (!GetFileAttributesExA(path, GetFileExInfoStandard, &data)) return false;
+        size = (static_cast<uint64_t>(data.nFileSizeHigh) << 32) | data.nFileSizeLow;
+        writeTime = (static_cast<uint64_t>(data.ftLastWriteTime.dwHighDateTime) << 32) |
+                    data.ftLastWriteTime.dwLowDateTime;
+        return true;
+    }
+#else
+    bool MappedFile::Open(const char* path)
+    {
+        Close();
+        int fd = open(path, O_RDONLY | O_CLOEXEC);
+        if (fd < 0) return false;
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (view == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+
+        _fd = fd;
+        _data = static_cast<const uint8_t*>(view);
+        _size = static_cast<size_t>(st.st_size);
+        return true;
+    }
+
+    void MappedFile::Close()
+    {
+        if (_data) munmap(const_cast<uint8_t*>(_data), _size);
+        if (_fd >= 0) close(_fd);
+        _data = nullptr;
+        _fd = -1;
+        _size = 0;
+    }
+
+    bool WritableMapping::Create(const char* path, size_t size)
+    {
+        Close();
+        int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) return false;
+
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            close(fd);
+            return false;
+        }
+
+        void* view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (view == MAP_FAILED) {
+            close(fd);
+            return false;
+        }
+
+        _fd = fd;
+        _data = static_cast<uint8_t*>(view);
+        _size = size;
+        return true;
+    }
+
+    void WritableMapping::Close()
+    {
+        if (_data) munmap(_data, _size);
+        if (_fd >= 0) close(_fd);
+        _data = nullptr;
+        _fd = -1;
+        _size = 0;
+    }
+
+    static bool ReplaceFile(const char* from, const char* to)
+    {
+        return rename(from, to) == 0;
+    }
+
+    bool FileStamp(const char* path, uint64_t& size, uint64_t& writeTime)
+    {
+        struct stat st;
+        if (stat(path, &st) != 0) return false;
+        size = static_cast<uint64_t>(st.st_size);
+        writeTime = static_cast<uint64_t>(st.st_mtim.tv_sec) * 1000000000ull + static_cast<uint64_t>(st.st_mtim.tv_nsec);
+        return true;
+    }
+#endif
+
+    bool WriteFileAtomic(const char* path, const void* data, size_t size)
+    {
+        std::string tmp = std::string(path) + ".tmp";
+        FILE* f = fopen(tmp.c_str(), "wb");
+        if (!f) return false;
+
+        bool ok = fwrite(data, 1, size, f) == size;
+        ok = (fclose(f) == 0) && ok;
+        if (ok) ok = ReplaceFile(tmp.c_str(), path);
+        if (!ok) remove(tmp.c_str());
+        return ok;
+    }
+}
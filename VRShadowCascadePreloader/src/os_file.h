@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Thin file-mapping layer over Win32 / POSIX
+// Keeps the portable core (offset cache, tools) free of platform headers.
+// =============================================================================
+
+namespace CascadePatch::OS
+{
+    // Read-only view of a whole file. Unmapped on Close() or destruction.
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        ~MappedFile() { Close(); }
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool Open(const char* path);
+        void Close();
+
+        const uint8_t* Data() const { return _data; }
+        size_t Size() const { return _size; }
+
+    private:
+        const uint8_t* _data = nullptr;
+        size_t _size = 0;
+#ifdef _WIN32
+        void* _file = nullptr;
+        void* _mapping = nullptr;
+#else
+        int _fd = -1;
+#endif
+    };
+
+    // Shared read/write view of a file created (or truncated) at a fixed
+    // size. Stores land in the OS page cache, so they reach the disk even if
+    // the process dies without unmapping.
+    class WritableMapping
+    {
+    public:
+        WritableMapping() = default;
+        ~WritableMapping() { Close(); }
+        WritableMapping(const WritableMapping&) = delete;
+        WritableMapping& operator=(const WritableMapping&) = delete;
+
+        bool Create(const char* path, size_t size);
+        void Close();
+
+        uint8_t* Data() const { return _data; }
+        size_t Size() const { return _size; }
+
+    private:
+        uint8_t* _data = nullptr;
+        size_t _size = 0;
+#ifdef _WIN32
+        void* _file = nullptr;
+        void* _mapping = nullptr;
+#else
+        int _fd = -1;
+#endif
+    };
+
+    // Writes `path` through a temporary file and rename, so a reader never
+    // sees a partially written file
+    bool WriteFileAtomic(const char* path, const void* data, size_t size);
+
+    // Size and last write time (opaque ticks) without opening the file;
+    // false if it does not exist
+    bool FileStamp(const char* path, uint64_t& size, uint64_t& writeTime);
+}
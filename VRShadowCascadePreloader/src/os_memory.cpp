@@ -0,0 +1,176 @@
+#include "os_memory.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <iterator>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace CascadePatch::OS
+{
+#ifdef _WIN32
+    size_t PageSize()
+    {
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        return si.dwPageSize;
+    }
+
+    bool MakeWritable(void* addr, size_t size, Protection& previous)
+    {
+        DWORD old = 0;
+        if (!VirtualProtect(addr, size, PAGE_EXECUTE_READWRITE, &old)) return false;
+        previous.value = old;
+        return true;
+    }
+
+    bool RestoreProtection(void* addr, size_t size, Protection previous)
+    {
+        DWORD old = 0;
+        return VirtualProtect(addr, size, previous.value, &old) != 0;
+    }
+
+    void FlushInstructionCache(const void* addr, size_t size)
+    {
+        ::FlushInstructionCache(GetCurrentProcess(), addr, size);
+    }
+
+    uint32_t LastError()
+    {
+        return GetLastError();
+    }
+
+    size_t AllocationGranularity()
+    {
+        SYSTEM_INFO si;
+        GetSystemInfo(&si);
+        return si.dwAllocationGranularity;
+    }
+
+    bool AddressMap::Refresh()
+    {
+        return true;
+    }
+
+    bool AddressMap::Query(uintptr_t addr, Region& out) const
+    {
+        MEMORY_BASIC_INFORMATION mbi;
+        if (VirtualQuery(reinterpret_cast<void*>(addr), &mbi, sizeof(mbi)) != sizeof(mbi)) return false;
+        out.base = reinterpret_cast<uintptr_t>(mbi.BaseAddress);
+        out.size = mbi.RegionSize;
+        out.free = (mbi.State == MEM_FREE);
+        return true;
+    }
+
+    void* MapAt(uintptr_t addr, size_t size)
+    {
+        return VirtualAlloc(reinterpret_cast<void*>(addr), size, MEM_COMMIT | MEM_RESERVE, PAGE_EXECUTE_READWRITE);
+    }
+
+    void Unmap(void* addr, size_t /*size*/)
+    {
+        VirtualFree(addr, 0, MEM_RELEASE);
+    }
+#else
+    size_t PageSize()
+    {
+        long size = sysconf(_SC_PAGESIZE);
+        return size > 0 ? static_cast<size_t>(size) : 4096;
+    }
+
+    bool MakeWritable(void* addr, size_t size, Protection& previous)
+    {
+        previous.value = PROT_READ | PROT_EXEC;
+        return mprotect(addr, size, PROT_READ | PROT_WRITE | PROT_EXEC) == 0;
+    }
+
+    bool RestoreProtection(void* addr, size_t size, Protection previous)
+    {
+        return mprotect(addr, size, static_cast<int>(previous.value)) == 0;
+    }
+
+    void FlushInstructionCache(const void* addr, size_t size)
+    {
+        char* begin = static_cast<char*>(const_cast<void*>(addr));
+        __builtin___clear_cache(begin, begin + size);
+    }
+
+    uint32_t LastError()
+    {
+        return static_cast<uint32_t>(errno);
+    }
+
+    size_t AllocationGranularity()
+    {
+        return PageSize();
+    }
+
+    // Top of the 47-bit user address space
+    static constexpr uintptr_t UserSpaceEnd = 0x7FFFFFFFF000ull;
+
+    bool AddressMap::Refresh()
+    {
+        FILE* f = fopen("/proc/self/maps", "r");
+        if (!f) return false;
+
+        _mapped.clear();
+        char line[512];
+        while (fgets(line, sizeof(line), f)) {
+            unsigned long long lo = 0, hi = 0;
+            if (sscanf(line, "%llx-%llx", &lo, &hi) != 2 || hi <= lo) continue;
+            if (!_mapped.empty() && _mapped.back().base + _mapped.back().size == lo) {
+                _mapped.back().size += static_cast<size_t>(hi - lo);
+                continue;
+            }
+            _mapped.push_back({ static_cast<uintptr_t>(lo), static_cast<size_t>(hi - lo), false });
+        }
+        fclose(f);
+        return !_mapped.empty();
+    }
+
+    bool AddressMap::Query(uintptr_t addr, Region& out) const
+    {
+        if (addr >= UserSpaceEnd) return false;
+
+        // First mapping that ends above addr
+        auto it = std::upper_bound(_mapped.begin(), _mapped.end(), addr,
+                                   [](uintptr_t a, const Region& r) { return a < r.base + r.size; });
+        if (it != _mapped.end() && it->base <= addr) {
+            out = *it;
+            return true;
+        }
+
+        // In the gap between the previous mapping and `it`
+        uintptr_t gapBase = (it == _mapped.begin()) ? 0 : std::prev(it)->base + std::prev(it)->size;
+        uintptr_t gapEnd = (it == _mapped.end()) ? UserSpaceEnd : it->base;
+        out = { gapBase, static_cast<size_t>(gapEnd - gapBase), true };
+        return true;
+    }
+
+    void* MapAt(uintptr_t addr, size_t size)
+    {
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS;
+#ifdef MAP_FIXED_NOREPLACE
+        flags |= MAP_FIXED_NOREPLACE;
+#endif
+        void* p = mmap(reinterpret_cast<void*>(addr), size, PROT_READ | PROT_WRITE | PROT_EXEC, flags, -1, 0);
+        if (p == MAP_FAILED) return nullptr;
+        if (reinterpret_cast<uintptr_t>(p) != addr) {
+            // Kernels without MAP_FIXED_NOREPLACE treat the address as a hint
+            munmap(p, size);
+            return nullptr;
+        }
+        return p;
+    }
+
+    void Unmap(void* addr, size_t size)
+    {
+        munmap(addr, size);
+    }
+#endif
+}
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// =============================================================================
+// Page protection, instruction cache and address space over Win32 / POSIX
+// Used by the patch engine and code arena so they can be built and exercised
+// off Windows.
+// =============================================================================
+
+namespace CascadePatch::OS
+{
+    size_t PageSize();
+
+    // Opaque previous protection, handed back to RestoreProtection()
+    struct Protection
+    {
+        uint32_t value = 0;
+    };
+
+    // Makes [addr, addr + size) read/write/execute
+    bool MakeWritable(void* addr, size_t size, Protection& previous);
+
+    // POSIX has no way to read the old protection back; code pages are
+    // restored to read/execute there
+    bool RestoreProtection(void* addr, size_t size, Protection previous);
+
+    void FlushInstructionCache(const void* addr, size_t size);
+
+    // GetLastError() / errno of the last failed call
+    uint32_t LastError();
+
+    // ---- Address space ----
+
+    // VirtualAlloc placement granularity (64 KB on Windows, a page elsewhere)
+    size_t AllocationGranularity();
+
+    struct Region
+    {
+        uintptr_t base = 0;
+        size_t    size = 0;
+        bool      free = false;
+    };
+
+    // The process address space as VirtualQuery sees it. Windows answers each
+    // Query() live; POSIX has no per-address query, so Refresh() snapshots
+    // /proc/self/maps and queries are served from that snapshot.
+    class AddressMap
+    {
+    public:
+        bool Refresh();
+        bool Query(uintptr_t addr, Region& out) const;
+
+    private:
+#ifndef _WIN32
+        std::vector<Region> _mapped;  // sorted, non-overlapping
+#endif
+    };
+
+    // Commits read/write/execute memory at exactly `addr`; nullptr if the
+    // range is not free
+    void* MapAt(uintptr_t addr, size_t size);
+    void Unmap(void* addr, size_t size);
+}
@@ -0,0 +1,62 @@
+#include "os_time.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <ctime>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace CascadePatch::OS
+{
+#ifdef _WIN32
+    uint64_t Ticks()
+    {
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return static_cast<uint64_t>(now.QuadPart);
+    }
+
+    uint64_t TicksPerSecond()
+    {
+        LARGE_INTEGER freq;
+        QueryPerformanceFrequency(&freq);
+        return static_cast<uint64_t>(freq.QuadPart);
+    }
+
+    uint32_t CurrentThreadId()
+    {
+        return GetCurrentThreadId();
+    }
+
+    uint32_t CurrentProcessId()
+    {
+        return GetCurrentProcessId();
+    }
+#else
+    uint64_t Ticks()
+    {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<uint64_t>(ts.tv_sec) * 1000000000ull + static_cast<uint64_t>(ts.tv_nsec);
+    }
+
+    uint64_t TicksPerSecond()
+    {
+        return 1000000000ull;
+    }
+
+    uint32_t CurrentThreadId()
+    {
+        // gettid is a real syscall; GetCurrentThreadId is a TEB read
+        thread_local uint32_t id = static_cast<uint32_t>(syscall(SYS_gettid));
+        return id;
+    }
+
+    uint32_t CurrentProcessId()
+    {
+        return static_cast<uint32_t>(getpid());
+    }
+#endif
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstdint>
+
+// =============================================================================
+// Clock and identity queries over Win32 / POSIX
+// Cheap enough to call per event: QueryPerformanceCounter / clock_gettime.
+// =============================================================================
+
+namespace CascadePatch::OS
+{
+    uint64_t Ticks();
+    uint64_t TicksPerSecond();
+    uint32_t CurrentThreadId();
+    uint32_t CurrentProcessId();
+}
@@ -0,0 +1,161 @@
+#include "patch_engine.h"
+#include "os_memory.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+namespace CascadePatch::Patch
+{
+    Write* Batch::Add(const char* name, uintptr_t addr, const uint8_t* expected,
+                      const uint8_t* replacement, size_t length, uint8_t group)
+    {
+        if (_count >= MaxWrites || addr == 0 || length == 0 || length > MaxBytes) return nullptr;
+
+        Write& w = _writes[_count++];
+        w = Write{};
+        w.name = name;
+        w.addr = reinterpret_cast<uint8_t*>(addr);
+        w.length = static_cast<uint8_t>(length);
+        w.group = group;
+        memcpy(w.expected, expected, length);
+        memcpy(w.replacement, replacement, length);
+        return &w;
+    }
+
+    Write* Batch::Add(const char* name, uintptr_t addr, const Bytes& expected,
+                      const Bytes& replacement, uint8_t group)
+    {
+        if (expected.length != replacement.length) return nullptr;
+        return Add(name, addr, expected.data, replacement.data, expected.length, group);
+    }
+
+    int Batch::Applied(uint8_t group) const
+    {
+        int n = 0;
+        for (size_t i = 0; i < _count; i++) {
+            if (_writes[i].group == group && _writes[i].Ok()) n++;
+        }
+        return n;
+    }
+
+    int Batch::Total(uint8_t group) const
+    {
+        int n = 0;
+        for (size_t i = 0; i < _count; i++) {
+            if (_writes[i].group == group) n++;
+        }
+        return n;
+    }
+
+    // Fails every still-pending write of an atomic group that has a failed member
+    static void FailBrokenGroups(Write* writes, size_t count, uint32_t atomicGroups)
+    {
+        uint32_t broken = 0;
+        for (size_t i = 0; i < count; i++) {
+            const Write& w = writes[i];
+            if (w.group < 32 && (atomicGroups & (1u << w.group)) && !w.Ok() && w.status != Status::Pending) {
+                broken |= 1u << w.group;
+            }
+        }
+        for (size_t i = 0; i < count; i++) {
+            Write& w = writes[i];
+            if (w.status == Status::Pending && w.group < 32 && (broken & (1u << w.group))) {
+                w.status = Status::GroupFailed;
+            }
+        }
+    }
+
+    void Batch::Apply(uint32_t atomicGroups, ApplyStats* stats)
+    {
+        auto start = std::chrono::steady_clock::now();
+        ApplyStats local;
+
+        // ---- Verify ----
+        for (size_t i = 0; i < _count; i++) {
+            Write& w = _writes[i];
+            if (w.status != Status::Pending) continue;
+            memcpy(w.found, w.addr, w.length);
+            if (memcmp(w.found, w.replacement, w.length) == 0) {
+                w.status = Status::AlreadyApplied;
+            } else if (memcmp(w.found, w.expected, w.length) != 0) {
+                w.status = Status::Mismatch;
+            }
+        }
+        FailBrokenGroups(_writes, _count, atomicGroups);
+
+        // ---- Pages touched by pending writes, ascending and unique ----
+        const uintptr_t pageSize = OS::PageSize();
+        uintptr_t pages[MaxWrites * 2];
+        OS::Protection previous[MaxWrites * 2];
+        bool writable[MaxWrites * 2] = {};
+        uint32_t pageError[MaxWrites * 2] = {};
+        size_t pageCount = 0;
+
+        for (size_t i = 0; i < _count; i++) {
+            const Write& w = _writes[i];
+            if (w.status != Status::Pending) continue;
+            uintptr_t first = reinterpret_cast<uintptr_t>(w.addr) & ~(pageSize - 1);
+            uintptr_t last = (reinterpret_cast<uintptr_t>(w.addr) + w.length - 1) & ~(pageSize - 1);
+            for (uintptr_t p = first; p <= last; p += pageSize) {
+                pages[pageCount++] = p;
+            }
+        }
+        std::sort(pages, pages + pageCount);
+        pageCount = std::unique(pages, pages + pageCount) - pages;
+
+        // Protection is per page: neighbouring pages may differ (.text / .rdata)
+        for (size_t p = 0; p < pageCount; p++) {
+            writable[p] = OS::MakeWritable(reinterpret_cast<void*>(pages[p]), pageSize, previous[p]);
+            if (!writable[p]) pageError[p] = OS::LastError();
+            local.protectCalls++;
+        }
+
+        // 0 when the page was made writable, otherwise the OS error
+        auto pageFailure = [&](uintptr_t page) -> uint32_t {
+            size_t idx = std::lower_bound(pages, pages + pageCount, page) - pages;
+            return writable[idx] ? 0 : (pageError[idx] ? pageError[idx] : 1);
+        };
+
+        for (size_t i = 0; i < _count; i++) {
+            Write& w = _writes[i];
+            if (w.status != Status::Pending) continue;
+            uintptr_t first = reinterpret_cast<uintptr_t>(w.addr) & ~(pageSize - 1);
+            uintptr_t last = (reinterpret_cast<uintptr_t>(w.addr) + w.length - 1) & ~(pageSize - 1);
+            uint32_t error = pageFailure(first);
+            if (!error) error = pageFailure(last);
+            if (error) {
+                w.status = Status::ProtectFailed;
+                w.error = error;
+            }
+        }
+        FailBrokenGroups(_writes, _count, atomicGroups);
+
+        // ---- Write ----
+        uintptr_t lo = UINTPTR_MAX, hi = 0;
+        for (size_t i = 0; i < _count; i++) {
+            Write& w = _writes[i];
+            if (w.status != Status::Pending) continue;
+            memcpy(w.addr, w.replacement, w.length);
+            w.status = Status::Applied;
+            local.writes++;
+            lo = std::min(lo, reinterpret_cast<uintptr_t>(w.addr));
+            hi = std::max(hi, reinterpret_cast<uintptr_t>(w.addr) + w.length);
+        }
+
+        // ---- Restore and flush ----
+        for (size_t p = 0; p < pageCount; p++) {
+            if (!writable[p]) continue;
+            OS::RestoreProtection(reinterpret_cast<void*>(pages[p]), pageSize, previous[p]);
+            local.protectCalls++;
+        }
+        if (local.writes) {
+            OS::FlushInstructionCache(reinterpret_cast<void*>(lo), hi - lo);
+            local.flushes = 1;
+        }
+
+        local.pages = static_cast<uint32_t>(pageCount);
+        local.elapsedUs = std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start).count();
+        if (stats) *stats = local;
+    }
+}
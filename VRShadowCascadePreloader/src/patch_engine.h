@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Batched code patching
+// Writes are collected into a Batch and applied in one pass:
+//   1. verify every site (already patched / expected bytes / mismatch)
+//   2. drop whole groups that are all-or-nothing and had a failure
+//   3. make each touched page writable once
+//   4. write, restore each page once, flush the icache once for the batch
+// Reads and writes are unguarded: Windows callers wrap Apply() in __try.
+// =============================================================================
+
+namespace CascadePatch::Patch
+{
+    constexpr size_t MaxBytes  = 16;
+    constexpr size_t MaxWrites = 32;
+
+    // Fixed-size byte string built from "4A 89 94" style text at compile time
+    struct Bytes
+    {
+        uint8_t data[MaxBytes] = {};
+        uint8_t length = 0;
+    };
+
+    constexpr Bytes Hex(const char* text)
+    {
+        auto nibble = [](char c) -> int {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            return -1;
+        };
+
+        Bytes b;
+        for (const char* s = text; *s;) {
+            if (*s == ' ') { s++; continue; }
+            int hi = nibble(s[0]);
+            int lo = (hi < 0) ? -1 : nibble(s[1]);
+            if (lo < 0 || b.length >= MaxBytes) return Bytes{};
+            b.data[b.length++] = static_cast<uint8_t>((hi << 4) | lo);
+            s += 2;
+        }
+        return b;
+    }
+
+    enum class Status : uint8_t
+    {
+        Pending,
+        Applied,
+        AlreadyApplied,   // site already holds the replacement bytes
+        Mismatch,         // site holds neither expected nor replacement bytes
+        GroupFailed,      // verified, but another write in its all-or-nothing group failed
+        ProtectFailed,
+    };
+
+    struct Write
+    {
+        const char* name = "";
+        uint8_t*    addr = nullptr;
+        uint8_t     length = 0;
+        uint8_t     group = 0;
+        Status      status = Status::Pending;
+        uint32_t    error = 0;                  // OS error for ProtectFailed
+        uint8_t     expected[MaxBytes] = {};
+        uint8_t     replacement[MaxBytes] = {};
+        uint8_t     found[MaxBytes] = {};       // bytes seen at verify time
+        char        detail[64] = {};            // optional text for the OK log line
+
+        bool Ok() const { return status == Status::Applied || status == Status::AlreadyApplied; }
+    };
+
+    struct ApplyStats
+    {
+        uint32_t writes       = 0;   // writes actually performed
+        uint32_t pages        = 0;
+        uint32_t protectCalls = 0;   // MakeWritable + RestoreProtection
+        uint32_t flushes      = 0;
+        double   elapsedUs    = 0.0;
+    };
+
+    // Trivially destructible so it can live in functions that use SEH
+    class Batch
+    {
+    public:
+        // Returns the queued write (to fill `detail`), nullptr when full or too long
+        Write* Add(const char* name, uintptr_t addr, const uint8_t* expected,
+                   const uint8_t* replacement, size_t length, uint8_t group);
+        Write* Add(const char* name, uintptr_t addr, const Bytes& expected,
+                   const Bytes& replacement, uint8_t group);
+
+        // `atomicGroups` is a bitmask (1 << group) of all-or-nothing groups
+        void Apply(uint32_t atomicGroups = 0, ApplyStats* stats = nullptr);
+
+        size_t Size() const { return _count; }
+        const Write& operator[](size_t i) const { return _writes[i]; }
+
+        int Applied(uint8_t group) const;   // Ok() writes in group
+        int Total(uint8_t group) const;
+
+    private:
+        Write  _writes[MaxWrites];
+        size_t _count = 0;
+    };
+}
@@ -0,0 +1,107 @@
+#include "pe_image.h"
+#include <cstring>
+
+namespace CascadePatch::PE
+{
+    // PE/COFF layout constants (PE32+ only)
+    constexpr size_t   DosLfanewOff      = 0x3C;
+    constexpr uint32_t NtSignature       = 0x00004550;  // "PE\0\0"
+    constexpr size_t   FileHeaderSize    = 20;
+    constexpr uint16_t OptMagicPE32Plus  = 0x20B;
+
+    template <typename T>
+    static bool ReadAt(const uint8_t* image, size_t size, size_t off, T& out)
+    {
+        if (off > size || size - off < sizeof(T)) return false;
+        memcpy(&out, image + off, sizeof(T));
+        return true;
+    }
+
+    // Locates the NT headers and returns the offset of the first section header
+    static bool LocateHeaders(const uint8_t* image, size_t size, ImageInfo& info, size_t& sectionTable)
+    {
+        uint16_t mz = 0;
+        if (!ReadAt(image, size, 0, mz) || mz != 0x5A4D) return false;
+
+        uint32_t lfanew = 0;
+        uint32_t sig = 0;
+        if (!ReadAt(image, size, DosLfanewOff, lfanew)) return false;
+        if (!ReadAt(image, size, lfanew, sig) || sig != NtSignature) return false;
+
+        size_t fileHdr = lfanew + 4;
+        size_t optHdr = fileHdr + FileHeaderSize;
+        uint16_t optSize = 0;
+        uint16_t magic = 0;
+        if (!ReadAt(image, size, fileHdr + 2, info.sectionCount)) return false;
+        if (!ReadAt(image, size, fileHdr + 4, info.timeDateStamp)) return false;
+        if (!ReadAt(image, size, fileHdr + 16, optSize)) return false;
+        if (!ReadAt(image, size, optHdr, magic) || magic != OptMagicPE32Plus) return false;
+        if (!ReadAt(image, size, optHdr + 56, info.sizeOfImage)) return false;
+        if (!ReadAt(image, size, optHdr + 60, info.sizeOfHeaders)) return false;
+
+        sectionTable = optHdr + optSize;
+        info.sectionTable = static_cast<uint32_t>(sectionTable);
+        return true;
+    }
+
+    static bool ReadSection(const uint8_t* image, size_t size, size_t hdr, Section& out)
+    {
+        if (hdr > size || size - hdr < SectionHeaderSize) return false;
+        memcpy(out.name, image + hdr, 8);
+        out.name[8] = '\0';
+        return ReadAt(image, size, hdr + 8, out.virtualSize) &&
+               ReadAt(image, size, hdr + 12, out.rva) &&
+               ReadAt(image, size, hdr + 16, out.rawSize) &&
+               ReadAt(image, size, hdr + 20, out.rawOffset);
+    }
+
+    bool ReadImageInfo(const uint8_t* image, size_t size, ImageInfo& out)
+    {
+        size_t sectionTable = 0;
+        return image && LocateHeaders(image, size, out, sectionTable);
+    }
+
+    bool FindSection(const uint8_t* image, size_t size, const char* name, Section& out)
+    {
+        ImageInfo info;
+        size_t sectionTable = 0;
+        if (!image || !LocateHeaders(image, size, info, sectionTable)) return false;
+
+        for (uint16_t i = 0; i < info.sectionCount; i++) {
+            Section s;
+            if (!ReadSection(image, size, sectionTable + i * SectionHeaderSize, s)) return false;
+            if (strncmp(s.name, name, 8) == 0) {
+                out = s;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool MapFileImage(const uint8_t* file, size_t fileSize, std::vector<uint8_t>& out)
+    {
+        ImageInfo info;
+        size_t sectionTable = 0;
+        if (!file || !LocateHeaders(file, fileSize, info, sectionTable)) return false;
+        if (info.sizeOfImage == 0 || info.sizeOfHeaders > fileSize) return false;
+
+        out.assign(info.sizeOfImage, 0);
+        memcpy(out.data(), file, info.sizeOfHeaders < info.sizeOfImage ? info.sizeOfHeaders : info.sizeOfImage);
+
+        for (uint16_t i = 0; i < info.sectionCount; i++) {
+            Section s;
+            if (!ReadSection(file, fileSize, sectionTable + i * SectionHeaderSize, s)) return false;
+
+            // Dumps taken from a running process often have raw == virtual layout
+            // with SizeOfRawData covering the whole section; clamp to both sides.
+            size_t n = s.rawSize;
+            if (s.virtualSize && s.virtualSize < n) n = s.virtualSize;
+            if (s.rawOffset > fileSize) continue;
+            if (n > fileSize - s.rawOffset) n = fileSize - s.rawOffset;
+            if (s.rva > out.size()) continue;
+            if (n > out.size() - s.rva) n = out.size() - s.rva;
+            memcpy(out.data() + s.rva, file + s.rawOffset, n);
+        }
+        return true;
+    }
+}
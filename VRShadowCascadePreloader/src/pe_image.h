@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// =============================================================================
+// Minimal PE32+ header reader
+// Works on the live module (mapped layout) and on image dumps read from disk,
+// so the site resolver can run both in-game and from the command-line tools.
+// No Windows headers: offsets are taken from the PE/COFF spec directly.
+// =============================================================================
+
+namespace CascadePatch::PE
+{
+    struct ImageInfo
+    {
+        uint32_t timeDateStamp = 0;
+        uint32_t sizeOfImage   = 0;
+        uint32_t sizeOfHeaders = 0;
+        uint16_t sectionCount  = 0;
+        uint32_t sectionTable  = 0;  // file offset of the first section header
+    };
+
+    constexpr size_t SectionHeaderSize = 40;
+
+    struct Section
+    {
+        char     name[9]     = {};
+        uint32_t rva         = 0;
+        uint32_t virtualSize = 0;
+        uint32_t rawOffset   = 0;
+        uint32_t rawSize     = 0;
+    };
+
+    // `size` bounds every read. Pass SIZE_MAX for the live module, whose
+    // headers are always mapped.
+    bool ReadImageInfo(const uint8_t* image, size_t size, ImageInfo& out);
+    bool FindSection(const uint8_t* image, size_t size, const char* name, Section& out);
+
+    // Expand a file-layout image (as dumped to disk) into mapped layout so
+    // RVAs can be used as plain offsets into `out`.
+    bool MapFileImage(const uint8_t* file, size_t fileSize, std::vector<uint8_t>& out);
+}
@@ -0,0 +1,143 @@
+#include "proxy_thunks.h"
+
+#include "os_memory.h"
+
+#include <atomic>
+
+#ifndef _WIN32
+// Bounds of the "vthunk" section, provided by the linker
+extern "C" char __start_vthunk[];
+extern "C" char __stop_vthunk[];
+#endif
+
+namespace CascadePatch::Thunks
+{
+    using namespace X64;
+
+    // push the argument registers of both ABIs, reserve shadow space (the
+    // stack is 16-byte aligned at the call), pass the index in ecx and edi
+    inline constexpr auto Save = Assemble<32>([](auto& a) {
+        a.Push(rcx);
+        a.Push(rdx);
+        a.Push(rsi);
+        a.Push(rdi);
+        a.Push(r8);
+        a.Push(r9);
+        a.Sub(rsp, 0x28);
+        a.Mov(ecx, r10d);
+        a.Mov(edi, r10d);
+    });
+
+    // call Resolve (in rax), restore and jump to the entry it returned
+    inline constexpr auto Restore = Assemble<32>([](auto& a) {
+        a.Call(rax);
+        a.Add(rsp, 0x28);
+        a.Pop(r9);
+        a.Pop(r8);
+        a.Pop(rdi);
+        a.Pop(rsi);
+        a.Pop(rdx);
+        a.Pop(rcx);
+        a.Jmp(rax);
+    });
+
+    static_assert(Save.ok && Restore.ok);
+
+#pragma pack(push, 1)
+    struct Trampoline
+    {
+        uint8_t   save[Save.size];
+        uint8_t   loadResolve[2];           // mov rax, imm64
+        ResolveFn resolve;
+        uint8_t   restore[Restore.size];
+    };
+#pragma pack(pop)
+
+    static const void* Resolve(uint32_t index);
+
+    static constexpr Trampoline MakeTrampoline()
+    {
+        Trampoline t{};
+        for (size_t i = 0; i < Save.size; i++) t.save[i] = Save.bytes[i];
+        t.loadResolve[0] = 0x48;
+        t.loadResolve[1] = 0xB8;
+        t.resolve = &Resolve;
+        for (size_t i = 0; i < Restore.size; i++) t.restore[i] = Restore.bytes[i];
+        return t;
+    }
+
+    PROXY_THUNK_SECTION static const Trampoline SharedTrampoline = MakeTrampoline();
+
+    static constexpr InitTable MakeInitTable()
+    {
+        InitTable table{};
+        for (uint32_t i = 0; i < MaxExports; i++) {
+            table.entries[i] = { { 0x41, 0xBA }, i, { 0x48, 0xB8 }, &SharedTrampoline, { 0xFF, 0xE0 },
+                                 { 0xCC, 0xCC, 0xCC, 0xCC, 0xCC, 0xCC } };
+        }
+        return table;
+    }
+
+    PROXY_THUNK_SECTION const InitTable Inits = MakeInitTable();
+
+    static Exports               g_exports;
+    static std::atomic<bool>     g_retargeted{ false };
+    static std::atomic<uint64_t> g_initCalls{ 0 };
+
+    // Stands in for an export the real DLL does not have (the old proxy
+    // returned FALSE / 0 for a null function pointer)
+    static uint64_t ReturnZero() { return 0; }
+
+    static const void* RealEntry(uint32_t index)
+    {
+        const void* real = g_exports.real ? g_exports.real[index] : nullptr;
+        return real ? real : reinterpret_cast<const void*>(&ReturnZero);
+    }
+
+    static const void* Resolve(uint32_t index)
+    {
+        g_initCalls.fetch_add(1, std::memory_order_relaxed);
+        if (g_exports.enter) g_exports.enter();
+        if (!g_exports.finished || g_exports.finished()) Retarget();
+        return RealEntry(index);
+    }
+
+    bool Install(const Exports& exports)
+    {
+        if (exports.count > MaxExports || !exports.slots) return false;
+
+#ifndef _WIN32
+        uintptr_t page = OS::PageSize();
+        uintptr_t begin = reinterpret_cast<uintptr_t>(__start_vthunk) & ~(page - 1);
+        uintptr_t end = reinterpret_cast<uintptr_t>(__stop_vthunk);
+        OS::Protection previous;
+        if (!OS::MakeWritable(reinterpret_cast<void*>(begin), end - begin, previous)) return false;
+#endif
+
+        g_exports = exports;
+        g_retargeted.store(false, std::memory_order_relaxed);
+        return true;
+    }
+
+    void Retarget()
+    {
+        if (g_retargeted.load(std::memory_order_acquire)) return;
+
+        // Aligned 8-byte stores: a thunk running concurrently sees either the
+        // init entry or the real one, and both end up in the same function
+        for (uint32_t i = 0; i < g_exports.count; i++) {
+            std::atomic_ref<const void*>(g_exports.slots[i]).store(RealEntry(i), std::memory_order_release);
+        }
+        g_retargeted.store(true, std::memory_order_release);
+    }
+
+    bool Retargeted()
+    {
+        return g_retargeted.load(std::memory_order_acquire);
+    }
+
+    uint64_t InitCalls()
+    {
+        return g_initCalls.load(std::memory_order_relaxed);
+    }
+}
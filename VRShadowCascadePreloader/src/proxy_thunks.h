@@ -0,0 +1,105 @@
+#pragma once
+
+#include "x64_asm.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Self-retargeting proxy export thunks
+// Each export is a 16-byte thunk, mov rax, [slot] / jmp rax, over a slot in
+// .data. A slot starts out at its export's init entry, which loads the export
+// index into r10d and enters the shared trampoline: save the argument
+// registers, Resolve(index) (runs the enter hook, i.e. EnsureInitialized),
+// restore, tail-jump to the real function. Once the finished hook reports
+// that setup is over, every slot is pointed at the real version.dll entry
+// and the init path is never taken again.
+//
+// The export list is generated from version.def by proxy_gen: an X-macro
+// header (PROXY_EXPORTS) plus a linker .def that exports each name as its
+// ProxyThunk_ symbol. The trampoline preserves the integer argument
+// registers of both Win64 and SysV, so the same bytes run on Linux under
+// thunk_check; no version.dll export takes floating-point arguments.
+// =============================================================================
+
+#if defined(_MSC_VER)
+#pragma section(".vthunk", read, execute)
+#define PROXY_THUNK_SECTION __declspec(allocate(".vthunk"))
+#else
+// ELF has no portable way to ask for an executable data section; Install()
+// makes the section's pages executable instead
+#define PROXY_THUNK_SECTION __attribute__((section("vthunk"), used))
+#endif
+
+namespace CascadePatch::Thunks
+{
+    constexpr size_t MaxExports = 32;
+
+    using ResolveFn = const void* (*)(uint32_t index);
+
+#pragma pack(push, 1)
+    // Exported entry point: 48 A1 <slot> (mov rax, [moffs64]), FF E0 (jmp rax)
+    struct Thunk
+    {
+        uint8_t            load[2];
+        const void* const* slot;
+        uint8_t            jump[2];
+        uint8_t            pad[4];
+    };
+
+    // Initial slot target: 41 BA <index> (mov r10d, imm32),
+    // 48 B8 <trampoline> (mov rax, imm64), FF E0 (jmp rax)
+    struct InitEntry
+    {
+        uint8_t     loadIndex[2];
+        uint32_t    index;
+        uint8_t     loadTrampoline[2];
+        const void* trampoline;
+        uint8_t     jump[2];
+        uint8_t     pad[6];
+    };
+#pragma pack(pop)
+
+    static_assert(sizeof(Thunk) == 16 && sizeof(InitEntry) == 24);
+
+    struct InitTable
+    {
+        InitEntry entries[MaxExports];
+    };
+
+    // In the thunk section, defined in proxy_thunks.cpp
+    extern const InitTable Inits;
+
+    constexpr Thunk MakeThunk(const void* const* slot)
+    {
+        return { { 0x48, 0xA1 }, slot, { 0xFF, 0xE0 }, { 0xCC, 0xCC, 0xCC, 0xCC } };
+    }
+
+    // ---- Runtime ----
+
+    struct Exports
+    {
+        const void**       slots    = nullptr;  // one per export, read by its thunk
+        const void* const* real     = nullptr;  // real entries; null returns 0
+        uint32_t           count    = 0;
+        void             (*enter)() = nullptr;  // called on every init-path call
+        bool             (*finished)() = nullptr;  // true once enter() has nothing left to do
+    };
+
+    // Call before any export can run (DllMain). Fails if count exceeds
+    // MaxExports or, off Windows, the thunk section cannot be made executable.
+    bool Install(const Exports& exports);
+
+    // Points every slot at its real entry now
+    void Retarget();
+
+    bool     Retargeted();
+    uint64_t InitCalls();   // calls that went through the trampoline
+}
+
+// Slot initializer and thunk definition for one PROXY_EXPORTS entry
+#define PROXY_THUNK_INIT_SLOT(index, name) &CascadePatch::Thunks::Inits.entries[index],
+
+#define PROXY_THUNK_DEFINE(slots, index, name)                                   \
+    extern "C" PROXY_THUNK_SECTION const CascadePatch::Thunks::Thunk ProxyThunk_##name = \
+        CascadePatch::Thunks::MakeThunk(&slots[index]);
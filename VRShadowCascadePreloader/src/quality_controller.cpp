@@ -0,0 +1,51 @@
+#include "quality_controller.h"
+
+#include <algorithm>
+
+namespace CascadePatch
+{
+    void QualityController::Reset()
+    {
+        _primed = false;
+        _error = 0.0f;
+        _filtered[0] = _filtered[1] = 0.0f;
+        _step = 0.0f;
+    }
+
+    float QualityController::Update(float errorMs)
+    {
+        // Dead zone: barely over target counts as on target
+        float e = errorMs;
+        if (e >= 0.0f && e <= _params.tolerance) e = 0.0f;
+
+        // First update after a reset has no history: no P or D kick
+        if (!_primed) {
+            _error = e;
+            _filtered[0] = _filtered[1] = e;
+            _primed = true;
+        }
+
+        float filtered = _filtered[0] + _params.derivativeFilter * (e - _filtered[0]);
+        float de = e - _error;
+        float d2e = filtered - 2.0f * _filtered[0] + _filtered[1];
+
+        _filtered[1] = _filtered[0];
+        _filtered[0] = filtered;
+        _error = e;
+        _step = _params.kp * de + _params.ki * e + _params.kd * d2e;
+        return _step;
+    }
+
+    float QualityController::Apply(float current, float factor, float min, float max) const
+    {
+        float delta = -_step * factor;
+        if (delta < 0.0f) {
+            delta *= _params.degradeGain;
+            if (_params.maxDegradeStep > 0.0f) delta = std::max(delta, -_params.maxDegradeStep * (max - min));
+        } else {
+            delta *= _params.restoreGain;
+            if (_params.maxRestoreStep > 0.0f) delta = std::min(delta, _params.maxRestoreStep * (max - min));
+        }
+        return std::clamp(current + delta, min, max);
+    }
+}
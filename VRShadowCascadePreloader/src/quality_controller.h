@@ -0,0 +1,96 @@
+#pragma once
+
+#include <cstdint>
+
+// =============================================================================
+// Quality controller
+// Drives the ShadowBoost knobs (shadow distance, LOD multipliers, grass
+// distance) from the frame-time error, once per adjustment. It is a PID in
+// velocity form: each update moves a knob by
+//
+//   -factor * gain * (Kp * de + Ki * e + Kd * d2e)
+//
+// where e is the error in ms (measured minus target), de its change since the
+// last update and d2e the second difference of a low-pass filtered e. The knob
+// value itself is the integrator. Clamping it to [min, max] is the
+// anti-windup: nothing accumulates past a limit, so the first update with the
+// opposite error moves the knob off it. Degrading (e > 0) and restoring
+// quality have separate gains and slew limits, so a knob can be cut quickly
+// and brought back slowly. Per-knob factors keep their existing meaning.
+// Params::P() is the original controller exactly:
+// clamp(cur - e * factor, min, max), with the same dead zone.
+// Shared with the ShadowBoost plugin; tools/controller_check tests it.
+// =============================================================================
+
+namespace CascadePatch
+{
+    enum class ControllerMode : int32_t
+    {
+        P   = 0,    // the original per-adjustment step, Params::P()
+        PID = 1,
+    };
+
+    class QualityController
+    {
+    public:
+        struct Params
+        {
+            float kp = 0.0f;
+            float ki = 1.0f;
+            float kd = 0.0f;
+            float derivativeFilter = 1.0f;  // weight of the newest error in the D term's low-pass (1 = off)
+            float tolerance = 0.0f;         // ms; errors in [0, tolerance] count as 0
+            float degradeGain = 1.0f;       // applied when the step lowers quality
+            float restoreGain = 1.0f;       // applied when it raises quality
+            float maxDegradeStep = 0.0f;    // per update, as a fraction of [min, max]; 0 = unlimited
+            float maxRestoreStep = 0.0f;
+
+            static Params P(float tolerance)
+            {
+                Params p;
+                p.tolerance = tolerance;
+                return p;
+            }
+
+            // Defaults for ControllerMode::PID (tools/controller_check)
+            static Params PID(float tolerance)
+            {
+                Params p;
+                p.kp = 1.5f;
+                p.ki = 2.0f;
+                p.kd = 0.3f;
+                p.derivativeFilter = 0.5f;
+                p.tolerance = tolerance;
+                p.degradeGain = 2.0f;
+                p.restoreGain = 0.5f;
+                p.maxDegradeStep = 0.10f;
+                p.maxRestoreStep = 0.02f;
+                return p;
+            }
+        };
+
+        void SetParams(const Params& params) { _params = params; }
+        const Params& GetParams() const { return _params; }
+
+        // Forgets the error history (after a pause, a load or a mode change)
+        void Reset();
+
+        // Once per adjustment, before Apply(): takes the error in ms and
+        // returns the step in ms, positive when quality must drop
+        float Update(float errorMs);
+
+        // The dead-zoned error and step of the last Update()
+        float Error() const { return _error; }
+        float Step() const { return _step; }
+
+        // Moves one knob by the current step scaled by `factor`
+        float Apply(float current, float factor, float min, float max) const;
+
+    private:
+        Params _params;
+        bool  _primed = false;
+        float _error = 0.0f;
+        float _filtered[2] = {};    // newest first
+        float _step = 0.0f;
+    };
+}
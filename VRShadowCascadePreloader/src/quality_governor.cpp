@@ -0,0 +1,185 @@
+#include "quality_governor.h"
+
+#include <algorithm>
+
+namespace CascadePatch
+{
+    namespace
+    {
+        constexpr float Millisecond = 1000.0f;
+        constexpr float MinCostMs = 0.05f;  // floor for an estimate near 0 or negative
+    }
+
+    QualityController::Params GovernorConfig::ControllerParams() const
+    {
+        if (controller != ControllerMode::PID) return QualityController::Params::P(msTolerance);
+        QualityController::Params p = pid;
+        p.tolerance = msTolerance;
+        return p;
+    }
+
+    void QualityGovernor::Reset(const GovernorConfig& config)
+    {
+        _frameTimes.Clear();
+        _frameTimes.SetWindow(config.percentileFrames);
+        _controller.Reset();
+        _controllerMode = config.controller;
+        _last = GovernorDecision{};
+        _last.targetMs = Millisecond / config.fpsTarget;
+        RlsEstimator::Params cost;
+        cost.forgetting = config.costForgetting;
+        _cost.Reset(KnobCount, cost, _last.targetMs);
+        _frameCount = 0.0f;
+        _sumUs = 0;
+    }
+
+    bool QualityGovernor::Frame(uint32_t frameUs, const GovernorConfig& config, SettingsBackend& settings)
+    {
+        _frameTimes.Record(frameUs);
+        _sumUs += frameUs;
+
+        // Throttle: only adjust every fFpsDelay frames
+        _frameCount += 1.0f;
+        if (_frameCount < config.fpsDelay) return false;
+        _frameCount = 0.0f;
+
+        Adjust(config, settings);
+        return true;
+    }
+
+    void QualityGovernor::Adjust(const GovernorConfig& config, SettingsBackend& settings)
+    {
+        GovernorDecision& d = _last;
+        d.adjustment++;
+        d.avgMs = static_cast<float>(_sumUs) / Millisecond / config.fpsDelay;
+        d.targetMs = Millisecond / config.fpsTarget;
+        _sumUs = 0;
+
+        // Percentiles over the last 1-2 windows: a few hitches vanish in the
+        // average but set p99 (window changes apply here)
+        _frameTimes.SetWindow(config.percentileFrames);
+        d.stats = _frameTimes.Query();
+        switch (config.metric) {
+        case FrameMetric::P95: d.measuredMs = d.stats.p95Ms; break;
+        case FrameMetric::P99: d.measuredMs = d.stats.p99Ms; break;
+        default: d.measuredMs = d.avgMs; break;
+        }
+
+        // A new controller mode starts without history
+        if (_controllerMode != config.controller) {
+            _controllerMode = config.controller;
+            _controller.Reset();
+        }
+        _controller.SetParams(config.ControllerParams());
+
+        d.errorMs = d.step = 0.0f;
+        if (config.autoAdjust) {
+            d.step = _controller.Update(d.measuredMs - d.targetMs);
+            d.errorMs = _controller.Error();
+        } else {
+            // Resume from the current knob values, not from a stale error
+            _controller.Reset();
+        }
+
+        // What the knobs cost: their positions over the frames just measured
+        // against the mean frame time
+        float positions[KnobCount];
+        for (size_t i = 0; i < KnobCount; i++) {
+            const KnobConfig& k = config.knobs[i];
+            Knob knob = static_cast<Knob>(i);
+            float range = k.max - k.min;
+            positions[i] = !settings.Has(knob) ? 0.0f
+                         : range > 0.0f       ? std::clamp((settings.Get(knob) - k.min) / range, 0.0f, 1.0f)
+                                              : 1.0f;
+        }
+        _cost.SetForgetting(config.costForgetting);
+        _cost.Observe(positions, d.avgMs);
+        for (size_t i = 0; i < KnobCount; i++) d.costMs[i] = _cost.Theta(i);
+
+        if (config.autoAdjust && config.allocation == Allocation::CostModel) {
+            AllocateByCost(config, settings, positions);
+        } else {
+            // Knobs: the controller step between min and max, or the max
+            // directly when auto-adjust or the knob is off
+            for (size_t i = 0; i < KnobCount; i++) {
+                Knob knob = static_cast<Knob>(i);
+                const KnobConfig& k = config.knobs[i];
+                d.knobs[i] = 0.0f;
+                if (!settings.Has(knob)) continue;
+                d.knobs[i] = config.autoAdjust && k.enabled
+                                 ? _controller.Apply(settings.Get(knob), k.factor, k.min, k.max)
+                                 : k.max;
+                settings.Set(knob, d.knobs[i]);
+            }
+        }
+
+        // Block level: one tier down while shadows are at their floor and
+        // still over budget, one up while they are at their ceiling
+        if (config.autoAdjust && config.blockEnable && config.blockLevels > 0 && settings.HasBlockLevels()) {
+            const KnobConfig& shadow = config.Of(Knob::ShadowDistance);
+            float shadowDist = settings.Get(Knob::ShadowDistance);
+            if (shadowDist <= shadow.min && d.errorMs > 0.0f) {
+                d.blockIndex = std::clamp(d.blockIndex + 1, 0, config.blockLevels - 1);
+            }
+            if (shadowDist >= shadow.max && d.errorMs <= 0.0f) {
+                d.blockIndex = std::clamp(d.blockIndex - 1, 0, config.blockLevels - 1);
+            }
+            settings.SetBlockLevel(d.blockIndex);
+        }
+    }
+
+    void QualityGovernor::AllocateByCost(const GovernorConfig& config, SettingsBackend& settings, const float* positions)
+    {
+        GovernorDecision& d = _last;
+        const QualityController::Params& p = _controller.GetParams();
+        float step = _controller.Step();
+        bool degrade = step > 0.0f;
+        float ms = (degrade ? step * p.degradeGain : -step * p.restoreGain) * config.costGain;
+        float slew = degrade ? p.maxDegradeStep : p.maxRestoreStep;
+
+        // Cut the knob that saves the most per unit of range first, restore
+        // the one that costs the least first
+        size_t order[KnobCount];
+        size_t n = 0;
+        for (size_t i = 0; i < KnobCount; i++) {
+            Knob knob = static_cast<Knob>(i);
+            d.knobs[i] = 0.0f;
+            if (!settings.Has(knob)) continue;
+            if (!config.knobs[i].enabled) {
+                d.knobs[i] = config.knobs[i].max;
+                settings.Set(knob, d.knobs[i]);
+                continue;
+            }
+            order[n++] = i;
+        }
+        // Insertion sort: at most KnobCount entries
+        auto before = [&](size_t a, size_t b) {
+            return degrade ? d.costMs[a] > d.costMs[b] : d.costMs[a] < d.costMs[b];
+        };
+        for (size_t o = 1; o < n; o++) {
+            size_t i = order[o], j = o;
+            for (; j > 0 && before(i, order[j - 1]); j--) order[j] = order[j - 1];
+            order[j] = i;
+        }
+
+        for (size_t o = 0; o < n; o++) {
+            size_t i = order[o];
+            const KnobConfig& k = config.knobs[i];
+            float cost = std::max(d.costMs[i], MinCostMs);
+            float room = degrade ? positions[i] : 1.0f - positions[i];
+            if (slew > 0.0f) room = std::min(room, slew);
+            float move = std::clamp(ms / cost, 0.0f, room);
+            ms -= move * cost;
+
+            float position = degrade ? positions[i] - move : positions[i] + move;
+
+            // Dither: knobs take turns, alternating up and down each round
+            if (i == d.adjustment % KnobCount) {
+                bool up = (d.adjustment / KnobCount) % 2 != 0;
+                position = std::clamp(position + (up ? config.costProbe : -config.costProbe), 0.0f, 1.0f);
+            }
+            d.knobs[i] = std::clamp(k.min + position * (k.max - k.min), k.min, k.max);
+            settings.Set(static_cast<Knob>(i), d.knobs[i]);
+        }
+    }
+}
@@ -0,0 +1,148 @@
+#pragma once
+
+#include "frame_histogram.h"
+#include "quality_controller.h"
+#include "rls_estimator.h"
+
+#include <cstdint>
+
+// =============================================================================
+// Quality governor
+// The decision logic of ShadowBoost::update without the game: frame times go
+// in, every fFpsDelay frames the measured frame time (average, p95 or p99)
+// goes through the QualityController, and the knobs are moved through a
+// SettingsBackend. The plugin's backend reads and writes RE::Setting values
+// and the renderer's shadow distance. tools/governor_sim's backend is a
+// struct of floats behind a frame-time cost model. GovernorConfig is plain
+// data that mirrors the plugin's INI, so the simulator can sweep it and the
+// plugin can rebuild it from Config every frame.
+// Every adjustment also fits what each knob costs (RlsEstimator on the knob
+// positions and the window's mean frame time). With Allocation::CostModel the
+// controller step is spent in ms instead of through the per-knob factors.
+// Over budget, the knob that saves the most ms per unit of range is cut first.
+// Under budget, the one that costs the least is restored first. A small
+// dither on one knob per adjustment keeps every knob's cost observable, even
+// for knobs the allocation would otherwise never move.
+// =============================================================================
+
+namespace CascadePatch
+{
+    enum class Knob : uint8_t
+    {
+        ShadowDistance,
+        LodObjects,
+        LodItems,
+        LodActors,
+        GrassDistance,
+        Count
+    };
+    constexpr size_t KnobCount = static_cast<size_t>(Knob::Count);
+
+    // Values match the plugin's iFrameTimeMetric
+    enum class FrameMetric : int32_t
+    {
+        Average = 0,    // over the fFpsDelay frames since the last adjustment
+        P95     = 1,
+        P99     = 2,
+    };
+
+    // Values match the plugin's iAllocation
+    enum class Allocation : int32_t
+    {
+        Factors   = 0,  // every knob moves by step x its factor (the original)
+        CostModel = 1,  // the step in ms goes to the knobs by estimated cost
+    };
+
+    class SettingsBackend
+    {
+    public:
+        virtual ~SettingsBackend() = default;
+
+        // False when the game has no such setting; the governor skips it
+        virtual bool  Has(Knob knob) const = 0;
+        virtual float Get(Knob knob) const = 0;
+        virtual void  Set(Knob knob, float value) = 0;
+
+        // Draw-distance tier (0 = the highest of GovernorConfig::blockLevels)
+        virtual bool HasBlockLevels() const = 0;
+        virtual void SetBlockLevel(int index) = 0;
+    };
+
+    struct KnobConfig
+    {
+        bool  enabled = true;
+        float factor = 30.0f;   // knob units per ms of controller step
+        float min = 0.0f;
+        float max = 0.0f;
+    };
+
+    struct GovernorConfig
+    {
+        bool        autoAdjust = false;
+        float       fpsTarget = 90.0f;
+        float       fpsDelay = 10.0f;       // frames between adjustments
+        float       msTolerance = 0.5f;     // dead zone above the target
+        FrameMetric metric = FrameMetric::Average;
+        uint32_t    percentileFrames = 450;
+        ControllerMode controller = ControllerMode::P;
+        QualityController::Params pid = QualityController::Params::PID(0.0f);   // tolerance comes from msTolerance
+        KnobConfig  knobs[KnobCount] = {
+            { true, 30.0f, 500.0f, 8000.0f },   // ShadowDistance
+            { true, 0.1f, 4.5f, 10.0f },        // LodObjects
+            { true, 0.1f, 2.5f, 8.0f },         // LodItems
+            { true, 0.1f, 6.0f, 15.0f },        // LodActors
+            { true, 30.0f, 3500.0f, 7000.0f },  // GrassDistance
+        };
+        bool        blockEnable = false;
+        int         blockLevels = 4;
+        Allocation  allocation = Allocation::Factors;
+        float       costForgetting = 0.98f;     // RLS forgetting per adjustment
+        float       costGain = 0.5f;            // share of the step's ms spent per adjustment
+        float       costProbe = 0.02f;          // dither per adjustment, fraction of one knob's range
+
+        KnobConfig&       Of(Knob knob) { return knobs[static_cast<size_t>(knob)]; }
+        const KnobConfig& Of(Knob knob) const { return knobs[static_cast<size_t>(knob)]; }
+        QualityController::Params ControllerParams() const;
+    };
+
+    // What the last adjustment saw and did
+    struct GovernorDecision
+    {
+        uint64_t       adjustment = 0;  // count since Reset()
+        float          avgMs = 0.0f;    // mean over the fFpsDelay frames
+        float          measuredMs = 0.0f;
+        float          targetMs = 0.0f;
+        float          errorMs = 0.0f;  // dead-zoned; 0 with auto-adjust off
+        float          step = 0.0f;
+        FrameTimeStats stats;
+        float          knobs[KnobCount] = {};  // values written; 0 for knobs the backend lacks
+        int            blockIndex = 0;
+        float          costMs[KnobCount] = {}; // estimated ms over each knob's whole range
+    };
+
+    class QualityGovernor
+    {
+    public:
+        void Reset(const GovernorConfig& config);
+
+        // Once per frame with its duration. Returns true when the frame ran
+        // an adjustment, i.e. Last() changed and the knobs were written.
+        bool Frame(uint32_t frameUs, const GovernorConfig& config, SettingsBackend& settings);
+
+        const GovernorDecision& Last() const { return _last; }
+        int BlockIndex() const { return _last.blockIndex; }
+        const RlsEstimator& Cost() const { return _cost; }
+
+    private:
+        void Adjust(const GovernorConfig& config, SettingsBackend& settings);
+        void AllocateByCost(const GovernorConfig& config, SettingsBackend& settings, const float* positions);
+
+        FrameTimeWindow   _frameTimes;
+        QualityController _controller;
+        RlsEstimator      _cost;
+        ControllerMode    _controllerMode = ControllerMode::P;    // mode the history belongs to
+        GovernorDecision  _last;
+        float    _frameCount = 0.0f;
+        uint64_t _sumUs = 0;            // frame time since the last adjustment
+    };
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// =============================================================================
+// Read-mostly cell of immutable snapshots
+// Writers build a complete new T and publish it with one pointer exchange, so a
+// reader never sees half of one version and half of another. Reading takes no
+// lock and never blocks on a writer:
+//   load the pointer, store it in the reader's hazard slot, load it again
+// The second load catches a publish that slipped in between; the reader then
+// retries with the newer pointer. A replaced snapshot is retired, not
+// deleted. Every Publish() and Reclaim() frees the retired snapshots that no
+// hazard slot points at. Writers serialize on a mutex, which readers never take.
+// Each reading thread registers once for a slot. A slot holds one snapshot at
+// a time, and a Read() nested inside another on the same slot returns the
+// outer snapshot, so one update sees one version throughout.
+// tools/rcu_stress runs readers against a publishing writer, also under
+// ThreadSanitizer, and times Read().
+// =============================================================================
+
+namespace CascadePatch
+{
+    template <typename T, size_t MaxReaders = 4>
+    class RcuCell
+    {
+    public:
+        class ReadGuard
+        {
+        public:
+            ReadGuard(ReadGuard&& other) noexcept : _value(other._value), _slot(other._slot) { other._slot = nullptr; }
+            ReadGuard(const ReadGuard&) = delete;
+            ReadGuard& operator=(const ReadGuard&) = delete;
+            ~ReadGuard()
+            {
+                if (_slot) _slot->store(nullptr, std::memory_order_release);
+            }
+
+            const T* Get() const { return _value; }
+            const T* operator->() const { return _value; }
+            const T& operator*() const { return *_value; }
+
+        private:
+            friend class RcuCell;
+            ReadGuard(const T* value, std::atomic<const T*>* slot) : _value(value), _slot(slot) {}
+
+            const T*               _value;
+            std::atomic<const T*>* _slot;   // null for a nested read
+        };
+
+        explicit RcuCell(T initial = T{}) : _current(new T(std::move(initial))) {}
+        RcuCell(const RcuCell&) = delete;
+        RcuCell& operator=(const RcuCell&) = delete;
+        ~RcuCell()
+        {
+            delete _current.load(std::memory_order_relaxed);
+            for (const T* p : _retired) delete p;
+        }
+
+        // A hazard slot for the calling thread; -1 when all are taken
+        int RegisterReader()
+        {
+            for (size_t i = 0; i < MaxReaders; i++) {
+                bool expected = false;
+                if (_slots[i].claimed.compare_exchange_strong(expected, true)) return static_cast<int>(i);
+            }
+            return -1;
+        }
+        void ReleaseReader(int reader) { _slots[reader].claimed.store(false); }
+
+        ReadGuard Read(int reader) const
+        {
+            std::atomic<const T*>& slot = _slots[reader].hazard;
+            if (const T* held = slot.load(std::memory_order_relaxed)) return ReadGuard(held, nullptr);
+
+            const T* p = _current.load(std::memory_order_acquire);
+            for (;;) {
+                slot.store(p, std::memory_order_seq_cst);
+                const T* again = _current.load(std::memory_order_seq_cst);
+                if (again == p) return ReadGuard(p, &slot);
+                p = again;
+            }
+        }
+
+        // Number of snapshots published so far (the initial one is 0)
+        uint64_t Version() const { return _version.load(std::memory_order_acquire); }
+
+        void Publish(T value)
+        {
+            const T* next = new T(std::move(value));
+            std::lock_guard lock(_writeLock);
+            const T* old = _current.exchange(next, std::memory_order_seq_cst);
+            _version.fetch_add(1, std::memory_order_release);
+            _retired.push_back(old);
+            ReclaimLocked();
+        }
+
+        // Frees what no reader holds; returns the snapshots still retired
+        size_t Reclaim()
+        {
+            std::lock_guard lock(_writeLock);
+            return ReclaimLocked();
+        }
+
+    private:
+        size_t ReclaimLocked()
+        {
+            size_t kept = 0;
+            for (const T* p : _retired) {
+                bool held = false;
+                for (size_t i = 0; i < MaxReaders; i++) held |= _slots[i].hazard.load(std::memory_order_seq_cst) == p;
+                if (held) _retired[kept++] = p;
+                else delete p;
+            }
+            _retired.resize(kept);
+            return kept;
+        }
+
+        // One line per reader, so readers never share a written cache line
+        struct alignas(64) Slot
+        {
+            std::atomic<const T*> hazard{ nullptr };
+            std::atomic<bool>     claimed{ false };
+        };
+
+        std::atomic<const T*> _current;
+        std::atomic<uint64_t> _version{ 0 };
+        mutable Slot          _slots[MaxReaders];
+        std::mutex            _writeLock;
+        std::vector<const T*> _retired;
+    };
+}
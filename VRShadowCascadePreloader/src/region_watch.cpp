@@ -0,0 +1,214 @@
+#include "region_watch.h"
+
+#include <cstring>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#include <emmintrin.h>
+#define CASCADE_WATCH_SSE2 1
+#endif
+
+namespace CascadePatch::Watch
+{
+    // Lane keys and per-block key step (XXH3 secret / prime constants)
+    static constexpr uint64_t Key0 = 0xBE4BA423396CFEB8ull;
+    static constexpr uint64_t Key1 = 0x1CAD21F72C81017Cull;
+    static constexpr uint64_t KeyStep = 0x9E3779B185EBCA87ull;
+
+    static uint64_t Mix(uint64_t h)
+    {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+#if CASCADE_WATCH_SSE2
+    // acc += swap64(data) + lo32(data ^ key) * hi32(data ^ key), per 64-bit lane
+    static inline __m128i Accumulate(__m128i acc, __m128i data, __m128i key)
+    {
+        __m128i dk = _mm_xor_si128(data, key);
+        __m128i hi = _mm_shuffle_epi32(dk, _MM_SHUFFLE(0, 3, 0, 1));
+        __m128i product = _mm_mul_epu32(dk, hi);
+        __m128i swapped = _mm_shuffle_epi32(data, _MM_SHUFFLE(1, 0, 3, 2));
+        return _mm_add_epi64(acc, _mm_add_epi64(swapped, product));
+    }
+
+    uint64_t Hash(const uint8_t* data, size_t size)
+    {
+        __m128i acc = _mm_set_epi64x(static_cast<long long>(Key1), static_cast<long long>(Key0 ^ size));
+        __m128i key = _mm_set_epi64x(static_cast<long long>(Key0), static_cast<long long>(Key1));
+        const __m128i step = _mm_set1_epi64x(static_cast<long long>(KeyStep));
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            acc = Accumulate(acc, _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i)), key);
+            key = _mm_add_epi64(key, step);
+        }
+        if (i < size) {
+            alignas(16) uint8_t tail[16] = {};
+            memcpy(tail, data + i, size - i);
+            acc = Accumulate(acc, _mm_load_si128(reinterpret_cast<const __m128i*>(tail)), key);
+        }
+
+        alignas(16) uint64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), acc);
+        return Mix(lanes[0] ^ Mix(lanes[1]));
+    }
+
+    uint64_t ChangedWords(const uint8_t* a, const uint8_t* b, size_t size)
+    {
+        if (size > MaxRegionBytes) size = MaxRegionBytes;
+        uint64_t changed = 0;
+
+        // movemask: bit per equal byte; a word changed unless all 8 are equal
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            unsigned equal = static_cast<unsigned>(_mm_movemask_epi8(_mm_cmpeq_epi8(va, vb)));
+            if (equal == 0xFFFF) continue;
+            if ((equal & 0xFF) != 0xFF) changed |= 1ull << (i / 8);
+            if ((equal >> 8) != 0xFF)   changed |= 1ull << (i / 8 + 1);
+        }
+        for (; i < size; i += 8) {
+            size_t n = size - i < 8 ? size - i : 8;
+            if (memcmp(a + i, b + i, n) != 0) changed |= 1ull << (i / 8);
+        }
+        return changed;
+    }
+
+    uint32_t NonZeroBytes(const uint8_t* data, size_t size)
+    {
+        // cmpeq gives -1 per zero byte; the byte counters are folded into
+        // 64-bit sums with psadbw before any of them can wrap
+        const __m128i zero = _mm_setzero_si128();
+        __m128i sums = zero;
+        size_t i = 0;
+        while (i + 16 <= size) {
+            __m128i counts = zero;
+            for (int n = 0; n < 255 && i + 16 <= size; n++, i += 16) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+                counts = _mm_sub_epi8(counts, _mm_cmpeq_epi8(v, zero));
+            }
+            sums = _mm_add_epi64(sums, _mm_sad_epu8(counts, zero));
+        }
+
+        alignas(16) uint64_t lanes[2];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), sums);
+        size_t zeros = lanes[0] + lanes[1];
+        for (; i < size; i++) {
+            if (data[i] == 0) zeros++;
+        }
+        return static_cast<uint32_t>(size - zeros);
+    }
+#else
+    // Same hash as the SSE2 path, one 64-bit lane at a time
+    uint64_t Hash(const uint8_t* data, size_t size)
+    {
+        uint64_t acc[2] = { Key0 ^ size, Key1 };
+        uint64_t key[2] = { Key1, Key0 };
+
+        auto accumulate = [&](const uint8_t* block) {
+            uint64_t d[2];
+            memcpy(d, block, 16);
+            for (int lane = 0; lane < 2; lane++) {
+                uint64_t dk = d[lane] ^ key[lane];
+                acc[lane] += d[lane ^ 1] + (dk & 0xFFFFFFFF) * (dk >> 32);
+            }
+        };
+
+        size_t i = 0;
+        for (; i + 16 <= size; i += 16) {
+            accumulate(data + i);
+            key[0] += KeyStep;
+            key[1] += KeyStep;
+        }
+        if (i < size) {
+            uint8_t tail[16] = {};
+            memcpy(tail, data + i, size - i);
+            accumulate(tail);
+        }
+        return Mix(acc[0] ^ Mix(acc[1]));
+    }
+
+    uint64_t ChangedWords(const uint8_t* a, const uint8_t* b, size_t size)
+    {
+        if (size > MaxRegionBytes) size = MaxRegionBytes;
+        uint64_t changed = 0;
+        for (size_t i = 0; i < size; i += 8) {
+            size_t n = size - i < 8 ? size - i : 8;
+            if (memcmp(a + i, b + i, n) != 0) changed |= 1ull << (i / 8);
+        }
+        return changed;
+    }
+
+    uint32_t NonZeroBytes(const uint8_t* data, size_t size)
+    {
+        uint32_t n = 0;
+        for (size_t i = 0; i < size; i++) {
+            if (data[i] != 0) n++;
+        }
+        return n;
+    }
+#endif
+}
+
+namespace CascadePatch
+{
+    int RegionWatch::Add(const char* name, uintptr_t addr, size_t size, uint64_t watch)
+    {
+        if (_count >= Watch::MaxRegions || size == 0 || size > Watch::MaxRegionBytes) return -1;
+
+        int id = static_cast<int>(_count++);
+        Region& r = _regions[id];
+        r = Region{};
+        r.name = name;
+        r.addr = addr;
+        r.size = static_cast<uint32_t>(size);
+        r.watch = watch & Watch::Words(0, size);
+        Rebase(id);
+        return id;
+    }
+
+    uint32_t RegionWatch::Poll(uint32_t regions)
+    {
+        uint32_t changed = 0;
+        for (size_t id = 0; id < _count; id++) {
+            if (!(regions & (1u << id))) continue;
+            Region& r = _regions[id];
+            r.stats.polls++;
+            r.last = 0;
+
+            const uint8_t* live = reinterpret_cast<const uint8_t*>(r.addr);
+            uint64_t hash = Watch::Hash(live, r.size);
+            if (hash == r.hash) {
+                r.stats.unchanged++;
+                continue;
+            }
+
+            // Unwatched words still move the hash; take the new copy either
+            // way so they do not force a compare on every poll
+            r.last = Watch::ChangedWords(live, _copies[id], r.size) & r.watch;
+            memcpy(_copies[id], live, r.size);
+            r.hash = hash;
+
+            if (r.last) {
+                r.accumulated |= r.last;
+                r.stats.changes++;
+                changed |= 1u << id;
+            }
+        }
+        return changed;
+    }
+
+    void RegionWatch::Rebase(int id)
+    {
+        Region& r = _regions[id];
+        memcpy(_copies[id], reinterpret_cast<const void*>(r.addr), r.size);
+        r.hash = Watch::Hash(_copies[id], r.size);
+        r.last = 0;
+        r.accumulated = 0;
+    }
+}
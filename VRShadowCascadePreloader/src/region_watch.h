@@ -0,0 +1,100 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Region watch
+// Game structs registered by address and size are compared against a copy
+// taken at the previous poll, 16 bytes per SSE2 compare. A change is
+// reported per 8-byte word: bit n of a mask is bytes [8n, 8n + 8), so a
+// region of up to 512 bytes fits one uint64_t. Each poll first hashes the
+// region; if the hash did not move, the compare and the copy are skipped.
+// A watch mask per region drops words the game churns without meaning
+// anything (spinlocks, list heads), so they never count as a change.
+// Reads are unguarded: Windows callers wrap Add() and Poll() in __try. A
+// RegionWatch is not thread-safe; the preloader polls it from scheduler
+// hooks, which never overlap.
+// =============================================================================
+
+namespace CascadePatch::Watch
+{
+    inline constexpr size_t MaxRegionBytes = 512;     // one mask bit per 8-byte word
+    inline constexpr size_t MaxRegions = 16;
+    inline constexpr uint64_t AllWords = ~0ull;
+
+    // Mask of the words covering [offset, offset + size)
+    constexpr uint64_t Words(size_t offset, size_t size)
+    {
+        uint64_t mask = 0;
+        for (size_t w = offset / 8; w * 8 < offset + size && w < 64; w++) mask |= 1ull << w;
+        return mask;
+    }
+
+    // 64-bit hash of `size` bytes (any size), SSE2 over 16-byte blocks
+    uint64_t Hash(const uint8_t* data, size_t size);
+
+    // Words that differ between `a` and `b`; size up to MaxRegionBytes
+    uint64_t ChangedWords(const uint8_t* a, const uint8_t* b, size_t size);
+
+    // Bytes that are not zero (any size)
+    uint32_t NonZeroBytes(const uint8_t* data, size_t size);
+}
+
+namespace CascadePatch
+{
+    class RegionWatch
+    {
+    public:
+        struct Stats
+        {
+            uint32_t polls = 0;
+            uint32_t unchanged = 0;     // polls settled by the hash alone
+            uint32_t changes = 0;       // polls that found a watched word changed
+        };
+
+        // Registers [addr, addr + size) and takes its first copy. `watch`
+        // selects the words that count (Watch::Words). Returns the region
+        // id, or -1 if the table is full or the size is out of range.
+        int Add(const char* name, uintptr_t addr, size_t size, uint64_t watch = Watch::AllWords);
+
+        // Compares each region in `regions` (bit per id) with its last copy
+        // and takes a new one. Returns the regions in which a watched word
+        // changed.
+        uint32_t Poll(uint32_t regions = ~0u);
+
+        // Watched words changed at the last Poll(), and since Add()/Rebase()
+        uint64_t Changed(int id) const { return _regions[id].last; }
+        uint64_t ChangedSinceBase(int id) const { return _regions[id].accumulated; }
+        bool FieldChanged(int id, size_t offset, size_t size) const
+        {
+            return (_regions[id].accumulated & Watch::Words(offset, size)) != 0;
+        }
+
+        // Takes a new copy and clears the accumulated changes, e.g. after
+        // the caller wrote the region itself
+        void Rebase(int id);
+
+        size_t Count() const { return _count; }
+        const char* Name(int id) const { return _regions[id].name; }
+        uintptr_t Address(int id) const { return _regions[id].addr; }
+        const Stats& GetStats(int id) const { return _regions[id].stats; }
+
+    private:
+        struct Region
+        {
+            const char* name = "";
+            uintptr_t addr = 0;
+            uint32_t size = 0;
+            uint64_t watch = 0;
+            uint64_t hash = 0;
+            uint64_t last = 0;
+            uint64_t accumulated = 0;
+            Stats stats;
+        };
+
+        Region _regions[Watch::MaxRegions];
+        alignas(16) uint8_t _copies[Watch::MaxRegions][Watch::MaxRegionBytes] = {};
+        size_t _count = 0;
+    };
+}
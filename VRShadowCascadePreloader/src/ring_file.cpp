@@ -0,0 +1,59 @@
+#include "ring_file.h"
+#include "os_time.h"
+
+#include <cstring>
+
+namespace CascadePatch::RingFile
+{
+    uint32_t Slots(uint32_t capacity)
+    {
+        uint32_t slots = 1;
+        while (slots < capacity && slots < (1u << 24)) slots <<= 1;
+        return slots;
+    }
+
+    Prefix* Create(OS::WritableMapping& file, const char* path, const Format& format, uint32_t slots)
+    {
+        size_t size = format.headerSize + size_t(slots) * format.recordSize;
+        if (!file.Create(path, size)) return nullptr;
+
+        auto* header = reinterpret_cast<Prefix*>(file.Data());
+        memcpy(header->magic, format.magic, sizeof(header->magic));
+        header->version = format.version;
+        header->headerSize = format.headerSize;
+        header->recordSize = format.recordSize;
+        header->capacity = slots;
+        header->processId = OS::CurrentProcessId();
+        return header;
+    }
+
+    const Prefix* Open(OS::MappedFile& file, const char* path, const Format& format, const char** error)
+    {
+        *error = nullptr;
+        if (!file.Open(path)) {
+            *error = "cannot open file";
+            return nullptr;
+        }
+        if (file.Size() < format.headerSize) {
+            *error = "file too small for a header";
+            return nullptr;
+        }
+        auto* header = reinterpret_cast<const Prefix*>(file.Data());
+        if (memcmp(header->magic, format.magic, sizeof(header->magic)) != 0) {
+            *error = "wrong file type (bad magic)";
+            return nullptr;
+        }
+        if (header->version != format.version || header->headerSize != format.headerSize ||
+            header->recordSize != format.recordSize) {
+            *error = "unsupported version";
+            return nullptr;
+        }
+        uint32_t capacity = header->capacity;
+        if (capacity == 0 || (capacity & (capacity - 1)) != 0 ||
+            file.Size() < format.headerSize + size_t(capacity) * format.recordSize) {
+            *error = "truncated file";
+            return nullptr;
+        }
+        return header;
+    }
+}
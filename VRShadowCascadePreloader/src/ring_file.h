@@ -0,0 +1,105 @@
+#pragma once
+
+#include "os_file.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Mapped record rings
+// The file format under the flight recorder and the frame telemetry: a
+// 128-byte header, then a power-of-two ring of fixed-size records, all in a
+// shared file mapping. The OS owns the mapped pages, so everything recorded
+// up to a crash is in the file. Record i lives in slot i & (capacity - 1)
+// and starts with a `seq` word: 0 while it is being written, i + 1 once it
+// is complete, so a reader (or a decoder after a crash) skips torn and
+// overwritten records. A format is its magic, version, the 40 header bytes
+// of its own (Info) and its record type.
+// =============================================================================
+
+namespace CascadePatch::RingFile
+{
+    // The fields every ring file starts with
+    struct Prefix
+    {
+        char     magic[4];
+        uint32_t version;
+        uint32_t headerSize;
+        uint32_t recordSize;
+        uint32_t capacity;          // power of two
+        uint32_t processId;
+    };
+
+    // File layout: Header, then `capacity` records
+    template <typename Info>
+    struct Header : Prefix
+    {
+        Info     info;
+        alignas(64) std::atomic<uint64_t> head;  // records started so far
+        uint8_t  padding[56];
+    };
+
+    struct Format
+    {
+        const char* magic;          // 4 chars
+        uint32_t    version;
+        uint32_t    headerSize;
+        uint32_t    recordSize;
+    };
+
+    // Slots for `capacity` records: the next power of two, at most 2^24
+    uint32_t Slots(uint32_t capacity);
+
+    // Creates (truncates) `path` with room for `slots` records, maps it and
+    // fills in the prefix. A new file reads as zeros: head is 0 and every
+    // record starts out invalid. Null if the file cannot be created.
+    Prefix* Create(OS::WritableMapping& file, const char* path, const Format& format, uint32_t slots);
+
+    // Maps `path` read-only; null (with `error` set) unless it is a whole
+    // file of `format`
+    const Prefix* Open(OS::MappedFile& file, const char* path, const Format& format, const char** error);
+
+    template <typename Record>
+    Record* Records(Prefix* header)
+    {
+        return reinterpret_cast<Record*>(reinterpret_cast<uint8_t*>(header) + header->headerSize);
+    }
+
+    template <typename Record>
+    const Record* Records(const Prefix* header)
+    {
+        return reinterpret_cast<const Record*>(reinterpret_cast<const uint8_t*>(header) + header->headerSize);
+    }
+
+    // Invalidates the slot before its fields are written...
+    template <typename Record>
+    void BeginWrite(Record& r)
+    {
+        r.seq.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    // ...and publishes it as record `index` once they are
+    template <typename Record>
+    void EndWrite(Record& r, uint64_t index)
+    {
+        r.seq.store(index + 1, std::memory_order_release);
+    }
+
+    // Calls fn(index, record) for every complete record still in the ring,
+    // oldest first; `head` is the header's head as read by the caller
+    template <typename Record, typename Fn>
+    size_t ForEach(const Record* records, uint32_t capacity, uint64_t head, Fn&& fn)
+    {
+        uint64_t first = head > capacity ? head - capacity : 0;
+        size_t count = 0;
+        for (uint64_t index = first; index < head; index++) {
+            const Record& r = records[index & (capacity - 1)];
+            if (r.seq.load(std::memory_order_acquire) != index + 1) continue;
+            fn(index, r);
+            count++;
+        }
+        return count;
+    }
+}
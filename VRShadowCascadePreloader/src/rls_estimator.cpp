@@ -0,0 +1,68 @@
+#include "rls_estimator.h"
+
+#include <algorithm>
+
+namespace CascadePatch
+{
+    void RlsEstimator::Reset(size_t inputs, const Params& params, float initialBias)
+    {
+        _params = params;
+        _n = std::min(inputs, MaxInputs);
+        size_t m = _n + 1;
+        for (size_t i = 0; i < Max; i++) {
+            _theta[i] = i == 0 ? initialBias : i < m ? params.initialTheta : 0.0;
+            for (size_t j = 0; j < Max; j++) _p[i][j] = (i == j && i < m) ? params.initialVariance : 0.0;
+        }
+        _maxTrace = static_cast<double>(params.initialVariance) * m;
+        _observations = 0;
+    }
+
+    float RlsEstimator::Predict(const float* x) const
+    {
+        double y = _theta[0];
+        for (size_t i = 0; i < _n; i++) y += _theta[i + 1] * x[i];
+        return static_cast<float>(y);
+    }
+
+    void RlsEstimator::Observe(const float* x, float y)
+    {
+        const size_t m = _n + 1;
+        double phi[Max];
+        phi[0] = 1.0;
+        for (size_t i = 0; i < _n; i++) phi[i + 1] = x[i];
+
+        // P * phi and phi' * P * phi
+        double pphi[Max];
+        double denom = 0.0;
+        for (size_t i = 0; i < m; i++) {
+            double s = 0.0;
+            for (size_t j = 0; j < m; j++) s += _p[i][j] * phi[j];
+            pphi[i] = s;
+            denom += phi[i] * s;
+        }
+
+        double trace = 0.0;
+        for (size_t i = 0; i < m; i++) trace += _p[i][i];
+        double lambda = trace < _maxTrace ? _params.forgetting : 1.0;
+        denom += lambda;
+
+        double error = y - Predict(x);
+        double clip = _params.maxInnovation;
+        error = std::clamp(error, -clip, clip);
+
+        double gain[Max];
+        for (size_t i = 0; i < m; i++) {
+            gain[i] = pphi[i] / denom;
+            _theta[i] += gain[i] * error;
+        }
+
+        // P = (P - k * phi' * P) / lambda, kept symmetric
+        for (size_t i = 0; i < m; i++) {
+            for (size_t j = i; j < m; j++) {
+                double v = (_p[i][j] - gain[i] * pphi[j]) / lambda;
+                _p[i][j] = _p[j][i] = v;
+            }
+        }
+        _observations++;
+    }
+}
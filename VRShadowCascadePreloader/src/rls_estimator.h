@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Recursive least squares with forgetting
+// Fits y = b + sum(theta_i * x_i) online, one observation at a time, with
+// exponential forgetting so the fit follows a scene that changes. The
+// governor uses it with x = knob positions in [0, 1] and y = the mean frame
+// time over an adjustment window, so theta_i is the ms a knob costs over its
+// whole range. Positions keep the inputs on one scale, whatever the knob's
+// units. Two guards keep it usable in a game:
+// - The innovation is clipped, so a loading hitch moves the fit like a
+//   modest error, not like a 40 ms one.
+// - Forgetting stops while the covariance trace is at its cap. Otherwise a
+//   stretch with the knobs pinned (no excitation) would blow the covariance
+//   up until the next observation throws the fit away.
+// Fixed-size arrays, no allocation; tools/cost_check tests it on traces with
+// known sensitivities.
+// =============================================================================
+
+namespace CascadePatch
+{
+    class RlsEstimator
+    {
+    public:
+        static constexpr size_t MaxInputs = 8;
+
+        struct Params
+        {
+            float forgetting = 0.98f;       // weight of the past per observation (1 = none forgotten)
+            float initialTheta = 1.0f;      // prior for every input
+            float initialVariance = 100.0f; // prior covariance diagonal
+            float maxInnovation = 3.0f;     // |y - prediction| is clipped to this
+        };
+
+        // Forgets everything; `inputs` is clamped to MaxInputs
+        void Reset(size_t inputs, const Params& params, float initialBias = 0.0f);
+        void SetForgetting(float forgetting) { _params.forgetting = forgetting; }
+
+        void  Observe(const float* x, float y);
+        float Predict(const float* x) const;
+
+        size_t   Inputs() const { return _n; }
+        float    Theta(size_t i) const { return static_cast<float>(_theta[i + 1]); }
+        float    Bias() const { return static_cast<float>(_theta[0]); }
+        uint32_t Observations() const { return _observations; }
+
+    private:
+        static constexpr size_t Max = MaxInputs + 1;   // bias first
+
+        Params   _params;
+        size_t   _n = 0;
+        double   _theta[Max] = {};
+        double   _p[Max][Max] = {};
+        double   _maxTrace = 0.0;
+        uint32_t _observations = 0;
+    };
+}
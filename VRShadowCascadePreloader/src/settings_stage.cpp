@@ -0,0 +1,82 @@
+#include "settings_stage.h"
+
+#include <cmath>
+
+namespace CascadePatch
+{
+    void SettingsStage::Reset()
+    {
+        for (Slot& s : _slots) s = Slot{};
+        _blockDesired = -1;
+        _blockWritten = -1;
+    }
+
+    float SettingsStage::Get(Knob knob) const
+    {
+        Slot& s = _slots[static_cast<size_t>(knob)];
+        if (s.staged) return s.desired;
+        if (!s.known) {
+            s.written = _target.Get(knob);
+            s.known = true;
+        }
+        return s.written;
+    }
+
+    void SettingsStage::Set(Knob knob, float value)
+    {
+        Slot& s = _slots[static_cast<size_t>(knob)];
+        s.desired = value;
+        s.staged = true;
+        s.fresh = true;
+        _counters.staged++;
+    }
+
+    void SettingsStage::SetBlockLevel(int index)
+    {
+        _blockDesired = index;
+    }
+
+    uint32_t SettingsStage::Commit()
+    {
+        uint32_t commit = static_cast<uint32_t>(++_counters.commits);
+        uint32_t writes = 0;
+        for (size_t i = 0; i < KnobCount; i++) {
+            Slot& s = _slots[i];
+            if (!s.staged) continue;
+            const WriteLimit& limit = _limits[i];
+            // A value never written is compared with the game's, once
+            if (!s.known) {
+                s.written = _target.Get(static_cast<Knob>(i));
+                s.known = true;
+                s.lastWrite = commit - limit.minFrames - 1;
+            }
+            bool fresh = s.fresh;
+            s.fresh = false;
+            if (std::fabs(s.desired - s.written) <= limit.epsilon) {
+                _counters.unchanged += fresh;
+                continue;
+            }
+            if (commit - s.lastWrite <= limit.minFrames) {
+                _counters.deferred += fresh;
+                continue;
+            }
+            _target.Set(static_cast<Knob>(i), s.desired);
+            s.written = s.desired;
+            s.lastWrite = commit;
+            writes++;
+        }
+        _counters.written += writes;
+
+        if (_blockDesired >= 0) {
+            if (_blockDesired != _blockWritten) {
+                _target.SetBlockLevel(_blockDesired);
+                _blockWritten = _blockDesired;
+                _counters.blockWritten++;
+            } else {
+                _counters.blockUnchanged++;
+            }
+            _blockDesired = -1;
+        }
+        return writes;
+    }
+}
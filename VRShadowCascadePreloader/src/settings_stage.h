@@ -0,0 +1,82 @@
+#pragma once
+
+#include "quality_governor.h"
+
+#include <cstdint>
+
+// =============================================================================
+// Staged settings writes
+// A SettingsBackend in front of another one. Set() only records the value the
+// governor wants; Commit() writes to the real backend once, at a fixed point in
+// the frame, and only what actually changed:
+// - A knob is written when it moved more than its epsilon from the value last
+//   written. Smaller moves stay staged and add up, and Get() returns the
+//   staged value, so the governor's own steps never get lost.
+// - A knob is written at most once every minFrames commits. A change held
+//   back by this stays staged and goes out on the first commit allowed.
+// - The block level is written only when the tier changes.
+// With auto-adjust off, the governor sets every knob to its max on every
+// adjustment. Those writes now cost nothing after the first. Counters say
+// how many writes went out and how many were avoided. tools/stage_check runs
+// it against a fake backend.
+// =============================================================================
+
+namespace CascadePatch
+{
+    struct WriteLimit
+    {
+        float    epsilon = 0.0f;    // knob units; 0 = any change is written
+        uint32_t minFrames = 0;     // commits between two writes of the knob
+    };
+
+    struct StageCounters
+    {
+        uint64_t commits = 0;
+        uint64_t staged = 0;        // Set() calls
+        uint64_t written = 0;       // knob writes that reached the backend
+        uint64_t unchanged = 0;     // Set() values within epsilon of the last write
+        uint64_t deferred = 0;      // Set() values held back by the rate limit
+        uint64_t blockWritten = 0;
+        uint64_t blockUnchanged = 0;
+    };
+
+    class SettingsStage final : public SettingsBackend
+    {
+    public:
+        explicit SettingsStage(SettingsBackend& target) : _target(target) {}
+
+        // Forgets every staged and written value; the next Get() reads through
+        void Reset();
+        void SetLimit(Knob knob, const WriteLimit& limit) { _limits[static_cast<size_t>(knob)] = limit; }
+        const WriteLimit& Limit(Knob knob) const { return _limits[static_cast<size_t>(knob)]; }
+
+        // Writes what changed; returns the number of backend writes
+        uint32_t Commit();
+
+        const StageCounters& Counters() const { return _counters; }
+
+        bool  Has(Knob knob) const override { return _target.Has(knob); }
+        float Get(Knob knob) const override;
+        void  Set(Knob knob, float value) override;
+        bool  HasBlockLevels() const override { return _target.HasBlockLevels(); }
+        void  SetBlockLevel(int index) override;
+
+    private:
+        struct Slot
+        {
+            float    desired = 0.0f;
+            float    written = 0.0f;
+            bool     staged = false;    // desired is valid
+            bool     fresh = false;     // Set() since the last commit
+            bool     known = false;     // written is valid (written or read through)
+            uint32_t lastWrite = 0;     // commit of the last write
+        };
+
+        SettingsBackend& _target;
+        WriteLimit       _limits[KnobCount];
+        mutable Slot     _slots[KnobCount];
+        int              _blockDesired = -1;
+        int              _blockWritten = -1;
+        StageCounters    _counters;
+    };
+}
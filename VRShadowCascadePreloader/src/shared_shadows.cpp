@@ -0,0 +1,125 @@
+#include "shared_shadows.h"
+
+#include <algorithm>
+
+namespace CascadePatch
+{
+    bool SharedShadowToggle::Attach(const uintptr_t (&sites)[SiteCount], const char* const (&names)[SiteCount])
+    {
+        _attached = false;
+        uint8_t first = *reinterpret_cast<const uint8_t*>(sites[0]);
+        for (size_t i = 0; i < SiteCount; i++) {
+            uint8_t b = *reinterpret_cast<const uint8_t*>(sites[i]);
+            if (b != first || (b != SeparateDisp && b != SharedDisp)) return false;
+            _sites[i] = sites[i];
+            _names[i] = names[i];
+        }
+        _shared = first == SharedDisp;
+        _autoShared = _shared;
+        _attached = true;
+        return true;
+    }
+
+    void SharedShadowToggle::Configure(const SharedShadowConfig& config)
+    {
+        if (_configured && config == _config) return;
+        if (!_configured || config.savingMs != _config.savingMs) _savingMs = std::max(config.savingMs, 0.0f);
+        bool reset = !_configured || config.mode != _config.mode || config.adapt != _config.adapt;
+        _config = config;
+        _configured = true;
+        if (!reset) return;
+
+        // Auto starts from the code as it is and may decide after one window
+        _autoShared = _shared;
+        _windowFrames = 0;
+        _windowUs = 0;
+        _windowsSinceSwitch = config.minWindows;
+        _measuring = false;
+    }
+
+    bool SharedShadowToggle::Want() const
+    {
+        switch (_config.mode) {
+        case SharedShadowMode::Separate: return false;
+        case SharedShadowMode::Shared:   return true;
+        default:                         return _config.adapt ? _autoShared : true;
+        }
+    }
+
+    // The first full window after a switch against the last one before it
+    void SharedShadowToggle::Learn(float meanMs)
+    {
+        float saved = _measuredShared ? _beforeMs - meanMs : meanMs - _beforeMs;
+        saved = std::clamp(saved, 0.0f, _config.budgetMs);
+        _savingMs += 0.5f * (saved - _savingMs);
+        _measuring = false;
+    }
+
+    bool SharedShadowToggle::Frame(uint32_t frameUs)
+    {
+        if (!_configured) Configure(_config);
+        _counters.frames++;
+        if (_shared) {
+            _counters.sharedFrames++;
+            _counters.sharedUs += frameUs;
+        }
+
+        float meanMs = -1.0f;
+        if (_config.mode == SharedShadowMode::Auto && _config.adapt) {
+            // A loading hitch is not a cost sharing can buy back
+            _windowUs += std::min<uint64_t>(frameUs, static_cast<uint64_t>(_config.budgetMs * 2000.0f));
+            if (++_windowFrames >= std::max(_config.windowFrames, 1u)) {
+                meanMs = static_cast<float>(_windowUs) / 1000.0f / static_cast<float>(_windowFrames);
+                _windowFrames = 0;
+                _windowUs = 0;
+                _lastMeanMs = meanMs;
+                _counters.windows++;
+                if (_measuring) Learn(meanMs);
+                _windowsSinceSwitch++;
+
+                if (_windowsSinceSwitch >= _config.minWindows) {
+                    if (!_autoShared) _autoShared = meanMs - _config.budgetMs >= _config.onOverMs;
+                    else _autoShared = _config.budgetMs - meanMs - _savingMs < _config.offHeadroomMs;
+                }
+            }
+        }
+
+        bool want = Want();
+        if (!_attached || want == _shared) return false;
+        if (!Switch(want)) return false;
+        if (meanMs >= 0.0f) {
+            _measuring = true;
+            _measuredShared = want;
+            _beforeMs = meanMs;
+        }
+        return true;
+    }
+
+    bool SharedShadowToggle::Switch(bool shared)
+    {
+        const uint8_t from = shared ? SeparateDisp : SharedDisp;
+        const uint8_t to = shared ? SharedDisp : SeparateDisp;
+
+        // Both bytes or neither: one eye on the other's map and the second
+        // MOV still on its own would dispatch a map that was never activated.
+        // This only keeps the code consistent between passes; a pass already
+        // between the two MOVs still sees one old byte and one new
+        _batch = Patch::Batch{};
+        for (size_t i = 0; i < SiteCount; i++) _batch.Add(_names[i], _sites[i], &from, &to, 1, 0);
+        _batch.Apply(1u << 0);
+
+        if (_batch.Applied(0) != static_cast<int>(SiteCount)) {
+            // Someone else owns the bytes now; stop touching them
+            _counters.failures++;
+            _attached = false;
+            return false;
+        }
+        _shared = shared;
+        _counters.toggles++;
+        _windowsSinceSwitch = 0;
+        _measuring = false;
+        _windowFrames = 0;
+        _windowUs = 0;
+        return true;
+    }
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "patch_engine.h"
+
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Shared-eye shadow maps, switched at runtime
+// The game's VR instanced path (FUN_14290d640) loads the right eye's shadow
+// map with two MOVs from [R15+0x58]. Patching both disp8 bytes to 0x50 makes
+// the right eye reuse the left eye's maps, saving one eye's worth of shadow
+// work. SharedShadowToggle owns those two bytes and flips them both ways,
+// always as one all-or-nothing batch, so they never stay mixed. The rewrite
+// happens on the caller's thread and is not synchronized with the renderer:
+// a pass that runs the first MOV before it and the second after it uses a
+// different map for each for that frame. The plugin switches from its frame
+// update, and minWindows keeps that to a handful of switches per session.
+// In Auto mode it decides once per window of frames (hitches clipped at twice
+// the budget). It shares when the mean frame time is over the budget by
+// onOverMs. It separates again when the budget minus the mean and the
+// saving still leaves offHeadroomMs. The saving is learned from the windows
+// around each switch. Both ways it waits minWindows after a switch, so
+// toggles are bounded whatever the frame times do. Shared and Separate hold
+// their mode. Auto with adapt off holds Shared, which is what the plugin
+// patched permanently before.
+// The addresses are plain pointers, so tools/shared_toggle_check drives it
+// against an mprotect'd buffer standing in for the code.
+// =============================================================================
+
+namespace CascadePatch
+{
+    // Values match the plugin's [SharedShadows] iMode
+    enum class SharedShadowMode : int32_t
+    {
+        Separate = 0,  // each eye renders its own maps (the game)
+        Shared   = 1,  // right eye uses the left eye's maps
+        Auto     = 2,  // shared while over budget
+    };
+
+    struct SharedShadowConfig
+    {
+        SharedShadowMode mode = SharedShadowMode::Auto;
+        bool     adapt = true;             // false holds Auto at Shared (bAutoAdjust off)
+        float    budgetMs = 1000.0f / 90.0f;
+        uint32_t windowFrames = 45;        // frames per decision
+        float    onOverMs = 0.5f;          // mean over the budget by this: share
+        float    offHeadroomMs = 1.0f;     // headroom left after the saving: separate
+        uint32_t minWindows = 4;           // windows after a switch before the next
+        float    savingMs = 1.0f;          // first guess of what sharing saves
+
+        bool operator==(const SharedShadowConfig&) const = default;
+    };
+
+    class SharedShadowToggle
+    {
+    public:
+        static constexpr uint8_t SeparateDisp = 0x58;
+        static constexpr uint8_t SharedDisp   = 0x50;
+        static constexpr size_t  SiteCount    = 2;
+
+        struct Counters
+        {
+            uint64_t frames = 0;
+            uint64_t windows = 0;
+            uint64_t toggles = 0;          // code rewrites, either way
+            uint64_t failures = 0;         // rewrites that did not apply
+            uint64_t sharedFrames = 0;
+            uint64_t sharedUs = 0;         // frame time spent in shared mode
+        };
+
+        // Takes the two disp8 bytes; false unless both hold the same known
+        // value, which becomes the current mode
+        bool Attach(const uintptr_t (&sites)[SiteCount], const char* const (&names)[SiteCount]);
+        bool Attached() const { return _attached; }
+
+        // A changed mode resets the window; other changes apply from the next one
+        void Configure(const SharedShadowConfig& config);
+
+        // One rendered frame; true when the code was rewritten with it
+        bool Frame(uint32_t frameUs);
+
+        bool IsShared() const { return _shared; }
+        float SavingMs() const { return _savingMs; }
+        float LastMeanMs() const { return _lastMeanMs; }
+        const SharedShadowConfig& Config() const { return _config; }
+        const Counters& Stats() const { return _counters; }
+
+        // The batch of the last rewrite, for its per-site status
+        const Patch::Batch& LastBatch() const { return _batch; }
+
+    private:
+        bool Want() const;              // the mode the config asks for now
+        bool Switch(bool shared);
+        void Learn(float meanMs);
+
+        SharedShadowConfig _config;
+        bool        _configured = false;
+        bool        _attached = false;
+        bool        _shared = false;
+        uintptr_t   _sites[SiteCount] = {};
+        const char* _names[SiteCount] = {};
+        Patch::Batch _batch;
+
+        bool     _autoShared = false;   // Auto's own decision
+        uint32_t _windowFrames = 0;
+        uint64_t _windowUs = 0;
+        uint32_t _windowsSinceSwitch = 0;
+        float    _lastMeanMs = 0.0f;
+        float    _savingMs = 0.0f;
+
+        // The switch being measured: the window mean before it and its direction
+        bool     _measuring = false;
+        bool     _measuredShared = false;
+        float    _beforeMs = 0.0f;
+
+        Counters _counters;
+    };
+}
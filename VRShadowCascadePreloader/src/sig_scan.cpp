@@ -0,0 +1,440 @@
+#include "sig_scan.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#define SIGSCAN_X64 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#define SIGSCAN_AVX2_TARGET
+#else
+#define SIGSCAN_AVX2_TARGET __attribute__((target("avx2")))
+#endif
+
+namespace CascadePatch::SigScan
+{
+    // =========================================================================
+    // CPU feature detection
+    // =========================================================================
+    bool CpuHasAvx2()
+    {
+#if SIGSCAN_X64
+        static const bool s_avx2 = []() {
+#if defined(_MSC_VER)
+            int regs[4];
+            __cpuid(regs, 0);
+            if (regs[0] < 7) return false;
+            __cpuid(regs, 1);
+            bool osxsave = (regs[2] & (1 << 27)) != 0;
+            bool avx = (regs[2] & (1 << 28)) != 0;
+            if (!osxsave || !avx) return false;
+            if ((_xgetbv(0) & 0x6) != 0x6) return false;  // XMM+YMM state enabled by the OS
+            __cpuidex(regs, 7, 0);
+            return (regs[1] & (1 << 5)) != 0;
+#else
+            __builtin_cpu_init();
+            return __builtin_cpu_supports("avx2") != 0;
+#endif
+        }();
+        return s_avx2;
+#else
+        return false;
+#endif
+    }
+
+    // =========================================================================
+    // Match filter: optional RIP-relative operand check applied to every hit
+    // =========================================================================
+    struct HitFilter
+    {
+        const uint8_t* data = nullptr;  // start of scanned range
+        uintptr_t baseRVA = 0;          // RVA of data[0]
+        int8_t    dispOffset = -1;
+        uint8_t   instrEnd = 0;
+        uintptr_t target = 0;           // 0 = no operand check
+
+        bool Accept(size_t pos) const
+        {
+            if (target == 0) return true;
+            int32_t disp;
+            memcpy(&disp, data + pos + dispOffset, 4);
+            uintptr_t next = baseRVA + pos + instrEnd;
+            return next + static_cast<intptr_t>(disp) == target;
+        }
+    };
+
+    struct HitList
+    {
+        std::vector<size_t> positions;
+        uint32_t total = 0;  // keeps counting past MaxHitsPerPattern
+
+        void Add(size_t pos)
+        {
+            if (positions.size() < MaxHitsPerPattern) positions.push_back(pos);
+            total++;
+        }
+    };
+
+    // Positions p in [begin, end) with p + length <= size
+    static size_t ScanLimit(size_t size, size_t end, const Pattern& pat)
+    {
+        if (size < pat.length) return 0;
+        return std::min(end, size - pat.length + 1);
+    }
+
+    static void ScanRangeScalar(const uint8_t* data, size_t size, size_t begin, size_t end,
+                                const Pattern& pat, const HitFilter& filter, HitList& hits)
+    {
+        const size_t limit = ScanLimit(size, end, pat);
+        const size_t a = pat.anchorA;
+        const int byteA = pat.bytes[a];
+
+        size_t p = begin;
+        while (p < limit) {
+            const void* found = memchr(data + p + a, byteA, limit - p);
+            if (!found) break;
+            p = static_cast<size_t>(static_cast<const uint8_t*>(found) - data) - a;
+            if (pat.MatchesAt(data + p) && filter.Accept(p)) hits.Add(p);
+            p++;
+        }
+    }
+
+#if SIGSCAN_X64
+    // Compares both anchor bytes for 32 candidate positions per iteration and
+    // only runs the full masked compare on positions where both hit.
+    SIGSCAN_AVX2_TARGET
+    static void ScanRangeAvx2(const uint8_t* data, size_t size, size_t begin, size_t end,
+                              const Pattern& pat, const HitFilter& filter, HitList& hits)
+    {
+        const size_t limit = ScanLimit(size, end, pat);
+        const __m256i va = _mm256_set1_epi8(static_cast<char>(pat.bytes[pat.anchorA]));
+        const __m256i vb = _mm256_set1_epi8(static_cast<char>(pat.bytes[pat.anchorB]));
+
+        size_t p = begin;
+        for (; p + 32 <= limit; p += 32) {
+            __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + p + pat.anchorA));
+            __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + p + pat.anchorB));
+            __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(a, va), _mm256_cmpeq_epi8(b, vb));
+            uint32_t bits = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+            while (bits) {
+                size_t pos = p + std::countr_zero(bits);
+                bits &= bits - 1;
+                if (pat.MatchesAt(data + pos) && filter.Accept(pos)) hits.Add(pos);
+            }
+        }
+        if (p < limit) ScanRangeScalar(data, size, p, limit, pat, filter, hits);
+    }
+#endif
+
+    static void ScanRange(const uint8_t* data, size_t size, size_t begin, size_t end,
+                          const Pattern& pat, const HitFilter& filter, HitList& hits, bool avx2)
+    {
+#if SIGSCAN_X64
+        if (avx2) {
+            ScanRangeAvx2(data, size, begin, end, pat, filter, hits);
+            return;
+        }
+#endif
+        (void)avx2;
+        ScanRangeScalar(data, size, begin, end, pat, filter, hits);
+    }
+
+    void FindAll(const uint8_t* data, size_t size, const Pattern& pattern,
+                 std::vector<size_t>& hits, bool allowAvx2)
+    {
+        hits.clear();
+        if (!pattern.valid || pattern.length == 0) return;
+
+        HitFilter filter;
+        HitList list;
+        const bool avx2 = allowAvx2 && CpuHasAvx2();
+        const size_t limit = ScanLimit(size, size, pattern);
+
+        // Hit lists are capped per call, so walk in chunks to return every match
+        for (size_t begin = 0; begin < limit; begin += 1 << 20) {
+            list.positions.clear();
+            ScanRange(data, size, begin, std::min(limit, begin + (1 << 20)), pattern, filter, list, avx2);
+            hits.insert(hits.end(), list.positions.begin(), list.positions.end());
+        }
+    }
+
+    // =========================================================================
+    // Parallel scan job
+    // Work is split into fixed-size chunks claimed through an atomic counter.
+    // The calling thread always participates and helpers are detached: if the
+    // caller holds the loader lock (proxy exports can be called from other
+    // DLLs' DllMain) new threads cannot start, and the caller simply scans
+    // every chunk itself instead of deadlocking on a join.
+    // =========================================================================
+    struct ScanGroup
+    {
+        const Pattern* pattern = nullptr;
+        HitFilter filter;
+        HitList hits;
+    };
+
+    struct ScanJob
+    {
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+        size_t chunkSize = 0;
+        size_t chunkCount = 0;
+        bool avx2 = false;
+        std::vector<ScanGroup> groups;
+
+        std::atomic<size_t> nextChunk{ 0 };
+        std::atomic<size_t> doneChunks{ 0 };
+        std::mutex mergeLock;
+
+        void Work()
+        {
+            std::vector<HitList> local(groups.size());
+            for (;;) {
+                size_t chunk = nextChunk.fetch_add(1, std::memory_order_relaxed);
+                if (chunk >= chunkCount) return;
+
+                size_t begin = chunk * chunkSize;
+                size_t end = std::min(size, begin + chunkSize);
+                for (size_t g = 0; g < groups.size(); g++) {
+                    local[g].positions.clear();
+                    local[g].total = 0;
+                    ScanRange(data, size, begin, end, *groups[g].pattern, groups[g].filter, local[g], avx2);
+                }
+
+                {
+                    std::lock_guard<std::mutex> lock(mergeLock);
+                    for (size_t g = 0; g < groups.size(); g++) {
+                        HitList& dst = groups[g].hits;
+                        for (size_t pos : local[g].positions) {
+                            if (dst.positions.size() < MaxHitsPerPattern) dst.positions.push_back(pos);
+                        }
+                        dst.total += local[g].total;
+                    }
+                }
+                doneChunks.fetch_add(1, std::memory_order_release);
+            }
+        }
+    };
+
+    static void RunJob(const std::shared_ptr<ScanJob>& job, unsigned threads)
+    {
+        for (unsigned i = 1; i < threads && i < job->chunkCount; i++) {
+            try {
+                std::thread([job]() { job->Work(); }).detach();
+            }
+            catch (...) {
+                break;  // fewer helpers is fine; the caller covers the rest
+            }
+        }
+
+        job->Work();
+
+        // Remaining chunks are in flight on helpers that are already running
+        while (job->doneChunks.load(std::memory_order_acquire) < job->chunkCount) {
+            std::this_thread::yield();
+        }
+    }
+
+    // =========================================================================
+    // Resolution
+    // =========================================================================
+    static bool IsRex(uint8_t b) { return (b & 0xF0) == 0x40; }
+
+    static bool ReadDisp(const uint8_t* image, size_t imageSize, uintptr_t rva, int32_t& disp)
+    {
+        if (rva > imageSize || imageSize - rva < 4) return false;
+        memcpy(&disp, image + rva, 4);
+        return true;
+    }
+
+    // Checks the pattern (and operand target) with its match starting at `matchRVA`
+    static bool MatchesAtRVA(const uint8_t* image, size_t imageSize, const Signature& sig,
+                             uintptr_t matchRVA, uintptr_t xrefRVA)
+    {
+        if (matchRVA > imageSize || imageSize - matchRVA < sig.pattern.length) return false;
+        if (!sig.pattern.MatchesAt(image + matchRVA)) return false;
+        if (xrefRVA == 0) return true;
+
+        int32_t disp;
+        if (!ReadDisp(image, imageSize, matchRVA + sig.dispOffset, disp)) return false;
+        return matchRVA + sig.instrEnd + static_cast<intptr_t>(disp) == xrefRVA;
+    }
+
+    // Checks a known site RVA (hint or cache entry)
+    static bool VerifyAt(const uint8_t* image, size_t imageSize, const Signature& sig,
+                         uintptr_t siteRVA, uintptr_t xrefRVA)
+    {
+        if (siteRVA == 0 || siteRVA < static_cast<uintptr_t>(sig.siteOffset)) return false;
+        uintptr_t match = siteRVA - sig.siteOffset;
+        if (MatchesAtRVA(image, imageSize, sig, match, xrefRVA)) return true;
+
+        // A known site marks the instruction start, so a REX there is known to be a prefix
+        if ((sig.flags & OptionalRex) && match < imageSize && IsRex(image[match])) {
+            return MatchesAtRVA(image, imageSize, sig, match + 1, xrefRVA);
+        }
+        return false;
+    }
+
+    static bool SameScan(const Signature& a, const Signature& b)
+    {
+        return strcmp(a.source, b.source) == 0 && a.xrefTarget == b.xrefTarget &&
+               a.dispOffset == b.dispOffset && a.instrEnd == b.instrEnd;
+    }
+
+    void ResolveAll(const uint8_t* image, size_t imageSize, const PE::Section& text,
+                    const Signature* table, size_t count, Resolution* out,
+                    const ScanOptions& options, ScanStats* stats)
+    {
+        auto start = std::chrono::steady_clock::now();
+        ScanStats local;
+
+        auto xrefOf = [&](const Signature& sig) -> uintptr_t {
+            return (sig.xrefTarget == NoSite) ? 0 : out[sig.xrefTarget].rva;
+        };
+
+        // ---- Pass 1: data entries and hint checks ----
+        std::vector<size_t> pending;
+        for (size_t i = 0; i < count; i++) {
+            const Signature& sig = table[i];
+            out[i] = Resolution{};
+            if (sig.IsDerived()) continue;
+
+            if (sig.IsData()) {
+                out[i].rva = sig.hintRVA;
+                out[i].from = Source::Hint;
+                continue;
+            }
+
+            // An xref constraint with an unresolved target can never be satisfied
+            if (sig.xrefTarget != NoSite && xrefOf(sig) == 0) continue;
+
+            bool knownMiss = false;
+            if (!options.forceScan && options.cachedRVAs) {
+                uintptr_t cached = options.cachedRVAs[i];
+                knownMiss = (cached == 0);  // not found last time on this exe: hint only
+                if (VerifyAt(image, imageSize, sig, cached, xrefOf(sig))) {
+                    out[i].rva = cached;
+                    out[i].from = Source::Cache;
+                    local.cacheHits++;
+                    continue;
+                }
+                // Stale entry: fall through to hint and scan
+            }
+
+            if (!options.forceScan && VerifyAt(image, imageSize, sig, sig.hintRVA, xrefOf(sig))) {
+                out[i].rva = sig.hintRVA;
+                out[i].from = Source::Hint;
+                local.hintHits++;
+                continue;
+            }
+            if (!(sig.flags & HintOnly) && !knownMiss) pending.push_back(i);
+        }
+
+        // ---- Pass 2: one parallel pass over .text for every pattern still pending ----
+        const bool textValid = text.rva < imageSize && text.virtualSize > 0;
+        if (!pending.empty() && textValid) {
+            auto job = std::make_shared<ScanJob>();
+            job->data = image + text.rva;
+            job->size = std::min<size_t>(text.virtualSize, imageSize - text.rva);
+            job->chunkSize = options.chunkSize ? options.chunkSize : (1 << 20);
+            job->chunkCount = (job->size + job->chunkSize - 1) / job->chunkSize;
+            job->avx2 = options.allowAvx2 && CpuHasAvx2();
+
+            std::vector<size_t> groupOf(pending.size());
+            for (size_t k = 0; k < pending.size(); k++) {
+                const Signature& sig = table[pending[k]];
+                size_t g = 0;
+                while (g < k && !SameScan(table[pending[g]], sig)) g++;
+                if (g < k) {
+                    groupOf[k] = groupOf[g];
+                    continue;
+                }
+                ScanGroup group;
+                group.pattern = &sig.pattern;
+                group.filter.data = job->data;
+                group.filter.baseRVA = text.rva;
+                group.filter.dispOffset = sig.dispOffset;
+                group.filter.instrEnd = sig.instrEnd;
+                group.filter.target = xrefOf(sig);
+                groupOf[k] = job->groups.size();
+                job->groups.push_back(group);
+            }
+
+            unsigned threads = options.threads;
+            if (threads == 0) threads = std::min(8u, std::max(1u, std::thread::hardware_concurrency()));
+            RunJob(job, threads);
+
+            for (size_t k = 0; k < pending.size(); k++) {
+                const Signature& sig = table[pending[k]];
+                HitList& hits = job->groups[groupOf[k]].hits;
+                std::sort(hits.positions.begin(), hits.positions.end());
+
+                Resolution& r = out[pending[k]];
+                r.hits = hits.total;
+                if (hits.total != sig.expectedHits || sig.ordinal >= hits.positions.size()) continue;
+
+                uintptr_t match = text.rva + hits.positions[sig.ordinal];
+                // x86 cannot be decoded backwards: a 0x4X byte before the match may be
+                // a REX prefix or the tail of the previous instruction. Without a
+                // known instruction boundary, leave the site unresolved.
+                if ((sig.flags & OptionalRex) && match > 0 && IsRex(image[match - 1])) continue;
+
+                r.rva = match + sig.siteOffset;
+                r.from = Source::Scan;
+            }
+
+            local.patternsScanned = static_cast<uint32_t>(job->groups.size());
+            local.bytesScanned = job->size * job->groups.size();
+            local.threads = threads;
+            local.usedAvx2 = job->avx2;
+        }
+
+        // ---- Pass 3: derived entries, in table order ----
+        for (size_t i = 0; i < count; i++) {
+            const Signature& sig = table[i];
+            if (!sig.IsDerived()) continue;
+
+            uintptr_t from = out[sig.derivedFrom].rva;
+            if (from == 0) continue;
+
+            if (sig.dispOffset < 0) {
+                out[i].rva = from + sig.siteOffset;
+                out[i].from = Source::Derived;
+                continue;
+            }
+
+            int32_t disp;
+            if (ReadDisp(image, imageSize, from + sig.dispOffset, disp)) {
+                out[i].rva = from + sig.instrEnd + static_cast<intptr_t>(disp);
+                out[i].from = Source::Derived;
+            }
+        }
+
+        local.elapsedMs = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - start).count();
+        if (stats) *stats = local;
+    }
+
+    const char* SourceName(Source s)
+    {
+        switch (s) {
+        case Source::Hint:    return "hint";
+        case Source::Cache:   return "cache";
+        case Source::Scan:    return "scan";
+        case Source::Derived: return "derived";
+        default:              return "UNRESOLVED";
+        }
+    }
+}
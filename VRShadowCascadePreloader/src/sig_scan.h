@@ -0,0 +1,279 @@
+#pragma once
+
+#include "pe_image.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// =============================================================================
+// Byte-pattern scanner used to resolve patch sites at startup
+// Every site keeps its 1.2.72 RVA as a hint: the pattern is checked there first
+// (one compare, no scan). Only when the hint fails is .text scanned, with an
+// AVX2 prefilter (scalar memchr fallback) spread over worker threads.
+// A site resolves only on an unambiguous match, otherwise it stays 0 and the
+// patch that needs it SKIPs exactly as a bytes mismatch did before.
+// =============================================================================
+
+namespace CascadePatch::SigScan
+{
+    constexpr size_t  MaxPatternLength = 320;
+    constexpr uint8_t NoSite = 0xFF;
+    constexpr size_t  MaxHitsPerPattern = 64;  // beyond this a pattern is hopelessly ambiguous
+
+    // Pattern text is a list of space-separated tokens:
+    //   "4D"     exact byte
+    //   "??"     any byte
+    //   "05/C7"  (byte & 0xC7) == 0x05, e.g. a RIP-relative ModRM with any reg
+    //   "[54]"   run of 54 wildcard bytes
+    struct Pattern
+    {
+        uint8_t  bytes[MaxPatternLength] = {};
+        uint8_t  mask[MaxPatternLength]  = {};
+        uint16_t length  = 0;
+        uint16_t anchorA = 0;  // fully specified bytes used by the SIMD prefilter
+        uint16_t anchorB = 0;
+        bool     valid   = false;
+
+        bool MatchesAt(const uint8_t* p) const
+        {
+            for (uint16_t i = 0; i < length; i++) {
+                if ((p[i] & mask[i]) != bytes[i]) return false;
+            }
+            return true;
+        }
+    };
+
+    namespace detail
+    {
+        constexpr int HexValue(char c)
+        {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            return -1;
+        }
+
+        constexpr int HexByte(const char* s)
+        {
+            int hi = HexValue(s[0]);
+            int lo = (hi < 0) ? -1 : HexValue(s[1]);
+            return (lo < 0) ? -1 : (hi << 4) | lo;
+        }
+    }
+
+    // Returns a pattern with valid == false on any syntax error; the site
+    // table static_asserts on validity so a typo fails the build.
+    constexpr Pattern ParsePattern(const char* text)
+    {
+        Pattern p;
+        const char* s = text;
+        while (*s) {
+            if (*s == ' ') { s++; continue; }
+
+            if (*s == '[') {
+                int run = 0;
+                s++;
+                while (*s >= '0' && *s <= '9') run = run * 10 + (*s++ - '0');
+                if (*s++ != ']' || run == 0 || p.length + run > (int)MaxPatternLength) return Pattern{};
+                p.length = static_cast<uint16_t>(p.length + run);  // mask stays 0
+                continue;
+            }
+
+            if (p.length >= MaxPatternLength) return Pattern{};
+            if (s[0] == '?' && s[1] == '?') {
+                s += 2;
+                p.length++;
+                continue;
+            }
+
+            int value = detail::HexByte(s);
+            if (value < 0) return Pattern{};
+            s += 2;
+            int mask = 0xFF;
+            if (*s == '/') {
+                mask = detail::HexByte(s + 1);
+                if (mask < 0) return Pattern{};
+                s += 3;
+            }
+            if (*s != ' ' && *s != '\0') return Pattern{};
+            p.bytes[p.length] = static_cast<uint8_t>(value & mask);
+            p.mask[p.length] = static_cast<uint8_t>(mask);
+            p.length++;
+        }
+
+        // Prefilter anchors: first and last fully specified bytes, preferring
+        // non-zero ones (padding and small immediates make 0x00 noisy)
+        int first = -1, firstNonZero = -1, last = -1, lastNonZero = -1;
+        for (int i = 0; i < p.length; i++) {
+            if (p.mask[i] != 0xFF) continue;
+            if (first < 0) first = i;
+            if (firstNonZero < 0 && p.bytes[i] != 0x00) firstNonZero = i;
+            last = i;
+            if (p.bytes[i] != 0x00) lastNonZero = i;
+        }
+        if (first < 0) return Pattern{};
+        p.anchorA = static_cast<uint16_t>(firstNonZero >= 0 ? firstNonZero : first);
+        p.anchorB = static_cast<uint16_t>(lastNonZero >= 0 ? lastNonZero : last);
+        p.valid = true;
+        return p;
+    }
+
+    // ---- Site descriptors ----
+    enum SignatureFlags : uint8_t
+    {
+        OptionalRex = 1 << 0,  // the site may start with a REX prefix in front of the match
+        HintOnly    = 1 << 1,  // pattern too short to scan for; verify at the hint only
+    };
+
+    struct Signature
+    {
+        const char* name   = "";
+        const char* source = "";    // pattern text; "" for data and derived entries
+        Pattern     pattern{};
+        uintptr_t   hintRVA = 0;    // Fallout4VR 1.2.72 RVA of the site
+        int32_t     siteOffset = 0; // site = match + siteOffset (or base site + offset)
+
+        // Derived entries compute their site from an earlier entry
+        uint8_t     derivedFrom = NoSite;
+
+        // RIP-relative operand: disp32 at dispOffset, instruction ends at instrEnd.
+        // Offsets are from the match (pattern entries) or from the base site
+        // (derived branch targets). With xrefTarget set, a hit only counts when
+        // the operand points at that entry's address.
+        uint8_t     xrefTarget = NoSite;
+        int8_t      dispOffset = -1;
+        uint8_t     instrEnd   = 0;
+
+        // When a pattern legitimately matches several sites, pick the Nth hit
+        // by address, provided exactly expectedHits were found.
+        uint8_t     ordinal      = 0;
+        uint8_t     expectedHits = 1;
+        uint8_t     flags        = 0;
+
+        constexpr Signature Xref(uint8_t target, int8_t disp, uint8_t end) const
+        {
+            Signature s = *this;
+            s.xrefTarget = target;
+            s.dispOffset = disp;
+            s.instrEnd = end;
+            return s;
+        }
+
+        constexpr Signature Nth(uint8_t n, uint8_t expected) const
+        {
+            Signature s = *this;
+            s.ordinal = n;
+            s.expectedHits = expected;
+            return s;
+        }
+
+        constexpr Signature WithFlags(uint8_t f) const
+        {
+            Signature s = *this;
+            s.flags = static_cast<uint8_t>(s.flags | f);
+            return s;
+        }
+
+        constexpr bool IsData() const    { return source[0] == '\0' && derivedFrom == NoSite; }
+        constexpr bool IsDerived() const { return derivedFrom != NoSite; }
+    };
+
+    // Code site located by pattern
+    constexpr Signature Sig(const char* name, const char* text, uintptr_t hint, int32_t siteOffset = 0)
+    {
+        Signature s;
+        s.name = name;
+        s.source = text;
+        s.pattern = ParsePattern(text);
+        s.hintRVA = hint;
+        s.siteOffset = siteOffset;
+        return s;
+    }
+
+    // .data/.bss global: taken from the hint as-is
+    constexpr Signature Data(const char* name, uintptr_t hint)
+    {
+        Signature s;
+        s.name = name;
+        s.hintRVA = hint;
+        s.pattern.valid = true;
+        return s;
+    }
+
+    // Fixed offset from an earlier entry (e.g. the immediate inside a matched instruction)
+    constexpr Signature Derived(const char* name, uint8_t from, uintptr_t hint, int32_t offset)
+    {
+        Signature s = Data(name, hint);
+        s.derivedFrom = from;
+        s.siteOffset = offset;
+        return s;
+    }
+
+    // rel32 target of the branch at an earlier entry
+    constexpr Signature BranchTarget(const char* name, uint8_t from, uintptr_t hint, int8_t disp, uint8_t end)
+    {
+        Signature s = Derived(name, from, hint, 0);
+        s.dispOffset = disp;
+        s.instrEnd = end;
+        return s;
+    }
+
+    template <size_t N>
+    constexpr bool AllValid(const Signature (&table)[N])
+    {
+        for (size_t i = 0; i < N; i++) {
+            if (!table[i].pattern.valid) return false;
+            if (table[i].derivedFrom != NoSite && table[i].derivedFrom >= i) return false;
+            if (table[i].xrefTarget != NoSite && table[i].xrefTarget >= i) return false;
+        }
+        return true;
+    }
+
+    // ---- Resolution ----
+    enum class Source : uint8_t { Unresolved, Hint, Cache, Scan, Derived };
+
+    struct Resolution
+    {
+        uintptr_t rva  = 0;   // 0 = unresolved
+        Source    from = Source::Unresolved;
+        uint32_t  hits = 0;   // matches seen by the scan (diagnostics)
+    };
+
+    struct ScanOptions
+    {
+        unsigned threads   = 0;        // 0 = hardware concurrency (capped at 8)
+        bool     allowAvx2 = true;
+        bool     forceScan = false;    // ignore hints (tools / throughput tracking)
+        size_t   chunkSize = 1 << 20;
+
+        // Per-entry RVAs from the offset cache, tried before the hint. An entry
+        // of 0 records that the site was not found under the same fingerprint,
+        // so it is not scanned for again.
+        const uint32_t* cachedRVAs = nullptr;
+    };
+
+    struct ScanStats
+    {
+        size_t   bytesScanned    = 0;  // .text bytes x patterns scanned
+        uint32_t patternsScanned = 0;
+        uint32_t hintHits        = 0;
+        uint32_t cacheHits       = 0;
+        unsigned threads         = 0;
+        bool     usedAvx2        = false;
+        double   elapsedMs       = 0.0;
+    };
+
+    bool CpuHasAvx2();
+
+    // All match offsets of `pattern` in [data, data + size), ascending
+    void FindAll(const uint8_t* data, size_t size, const Pattern& pattern,
+                 std::vector<size_t>& hits, bool allowAvx2 = true);
+
+    // Resolves `table` against a mapped image. `text` bounds the scan; hint
+    // checks and derived entries may read anywhere inside imageSize.
+    void ResolveAll(const uint8_t* image, size_t imageSize, const PE::Section& text,
+                    const Signature* table, size_t count, Resolution* out,
+                    const ScanOptions& options = {}, ScanStats* stats = nullptr);
+
+    const char* SourceName(Source s);
+}
@@ -0,0 +1,106 @@
+#include "step_scheduler.h"
+#include <bit>
+
+namespace CascadePatch
+{
+    bool StepScheduler::Init(const Sched::StepDesc* steps, const Sched::Hooks* hooks, size_t count, void* context)
+    {
+        if (count == 0 || count > Sched::MaxSteps) return false;
+
+        _steps = steps;
+        _hooks = hooks;
+        _context = context;
+        _count = count;
+        _all = (count == 32) ? ~0u : Sched::Bit(count) - 1;
+        _armed = 0;
+        for (size_t i = 0; i < count; i++) {
+            _nextDue[i] = 0;
+            _backoff[i] = steps[i].minBackoffMs;
+            _stats[i] = {};
+        }
+        _state.store(0, std::memory_order_release);
+        _woken.store(0, std::memory_order_release);
+        return true;
+    }
+
+    void StepScheduler::Wake(uint32_t steps)
+    {
+        _woken.fetch_or(steps & _all, std::memory_order_release);
+    }
+
+    void StepScheduler::MarkDone(size_t id, uint64_t nowMs)
+    {
+        if (id >= _count || Done(id)) return;
+        _stats[id].doneAtMs = nowMs ? nowMs : 1;
+        _state.fetch_or(Sched::Bit(id), std::memory_order_release);
+    }
+
+    uint32_t StepScheduler::Poll(uint64_t nowMs, uint8_t lane)
+    {
+        bool expected = false;
+        if (!_polling.compare_exchange_strong(expected, true, std::memory_order_acquire)) return 0;
+
+        uint32_t before = _state.load(std::memory_order_relaxed);
+        uint32_t woken = _woken.exchange(0, std::memory_order_acquire);
+        for (bool progress = true; progress;) {
+            progress = false;
+            uint32_t state = _state.load(std::memory_order_relaxed);
+
+            for (uint32_t pending = _all & ~state; pending; pending &= pending - 1) {
+                size_t id = static_cast<size_t>(std::countr_zero(pending));
+                const Sched::StepDesc& step = _steps[id];
+                if ((step.after & state) != step.after) continue;
+
+                // Prerequisites just finished: start the step's delay
+                if (!(_armed & Sched::Bit(id))) {
+                    _armed |= Sched::Bit(id);
+                    _nextDue[id] = nowMs + step.delayMs;
+                } else if (woken & Sched::Bit(id)) {
+                    _nextDue[id] = nowMs;
+                    _backoff[id] = step.minBackoffMs;
+                }
+                woken &= ~Sched::Bit(id);
+                if (!(step.lanes & lane) || nowMs < _nextDue[id]) continue;
+
+                const Sched::Hooks& hooks = _hooks[id];
+                _stats[id].probes++;
+                bool ok = (!hooks.probe || hooks.probe(_context)) && hooks.run(_context);
+
+                state = _state.load(std::memory_order_relaxed);   // hooks may MarkDone()
+                if (ok) {
+                    MarkDone(id, nowMs);
+                    state |= Sched::Bit(id);
+                    progress = true;
+                    continue;
+                }
+
+                _stats[id].failures++;
+                _nextDue[id] = nowMs + _backoff[id];
+                uint32_t next = _backoff[id] ? _backoff[id] * 2 : 0;
+                _backoff[id] = next < step.maxBackoffMs ? next : step.maxBackoffMs;
+            }
+        }
+
+        // Wakes for steps still waiting on prerequisites keep for later
+        woken &= ~_state.load(std::memory_order_relaxed);
+        if (woken) _woken.fetch_or(woken, std::memory_order_relaxed);
+        _polling.store(false, std::memory_order_release);
+        return _state.load(std::memory_order_relaxed) & ~before;
+    }
+
+    uint64_t StepScheduler::NextDue(uint8_t lanes) const
+    {
+        uint32_t state = State();
+        uint32_t woken = _woken.load(std::memory_order_acquire);
+        uint64_t due = Sched::Never;
+        for (uint32_t pending = _all & ~state; pending; pending &= pending - 1) {
+            size_t id = static_cast<size_t>(std::countr_zero(pending));
+            const Sched::StepDesc& step = _steps[id];
+            if ((step.after & state) != step.after || !(step.lanes & lanes)) continue;
+            // Not armed yet: its delay starts at the next Poll()
+            uint64_t at = (_armed & Sched::Bit(id)) && !(woken & Sched::Bit(id)) ? _nextDue[id] : 0;
+            if (at < due) due = at;
+        }
+        return due;
+    }
+}
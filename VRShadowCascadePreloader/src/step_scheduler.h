@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// =============================================================================
+// Dependency-graph step scheduler
+// Each step is a node: the steps it requires, the lanes (callers) allowed to
+// run it, a delay after its prerequisites finish, and probe/run hooks. Poll()
+// only looks at steps that are pending with every prerequisite done; a probe
+// or run that fails pushes that step's next attempt out by an exponentially
+// growing backoff. Completed steps are bits in one atomic word, so "is X
+// done" anywhere is a single acquire load. Time is passed in, which keeps
+// the scheduler deterministic under a simulated clock.
+// =============================================================================
+
+namespace CascadePatch::Sched
+{
+    inline constexpr size_t MaxSteps = 32;
+
+    constexpr uint32_t Bit(size_t id) { return 1u << id; }
+
+    struct StepDesc
+    {
+        const char* name;
+        uint32_t after;           // Bit() of every prerequisite step
+        uint8_t  lanes;           // Poll() lanes that may run this step
+        uint32_t delayMs;         // wait after the prerequisites are done
+        uint32_t minBackoffMs;    // first retry interval after a failed attempt
+        uint32_t maxBackoffMs;
+    };
+
+    // Hooks receive the context passed to Init(). `probe` (optional) is the
+    // cheap readiness check; `run` does the work and returns true when the
+    // step is complete. A false from either counts as one failed attempt.
+    struct Hooks
+    {
+        bool (*probe)(void* context);
+        bool (*run)(void* context);
+    };
+
+    struct StepStats
+    {
+        uint32_t probes = 0;      // attempts (probe or run called)
+        uint32_t failures = 0;
+        uint64_t doneAtMs = 0;    // 0 while pending
+    };
+
+    inline constexpr uint64_t Never = UINT64_MAX;
+}
+
+namespace CascadePatch
+{
+    class StepScheduler
+    {
+    public:
+        StepScheduler() = default;
+        StepScheduler(const StepScheduler&) = delete;
+        StepScheduler& operator=(const StepScheduler&) = delete;
+
+        // The tables must outlive the scheduler. Steps should be listed after
+        // their prerequisites so a chain can finish within one Poll().
+        bool Init(const Sched::StepDesc* steps, const Sched::Hooks* hooks, size_t count, void* context);
+
+        // Attempts every due step on `lane` (a Sched::Bit-style lane mask)
+        // until nothing more completes. Returns the steps completed by this
+        // call. Non-blocking: if another thread is polling, returns 0 at once,
+        // so hooks never run concurrently with each other.
+        uint32_t Poll(uint64_t nowMs, uint8_t lane);
+
+        // Marks a step complete from inside a hook, e.g. when one run also
+        // finished a sibling step's work
+        void MarkDone(size_t id, uint64_t nowMs);
+
+        // Makes `steps` (Bit() mask) due at the next Poll() with their backoff
+        // reset, for when an event reports that what they wait for happened.
+        // Safe from any thread.
+        void Wake(uint32_t steps);
+
+        uint32_t State() const { return _state.load(std::memory_order_acquire); }
+        bool Done(size_t id) const { return (State() & Sched::Bit(id)) != 0; }
+        bool AllDone() const { return State() == _all; }
+
+        // Earliest time a pending step runnable from `lanes` may be attempted;
+        // Sched::Never if there is none (all done, or waiting on other lanes).
+        // Reads polling state: call it from the thread that polls.
+        uint64_t NextDue(uint8_t lanes) const;
+
+        size_t Count() const { return _count; }
+        const Sched::StepDesc& Step(size_t id) const { return _steps[id]; }
+        const Sched::StepStats& Stats(size_t id) const { return _stats[id]; }
+
+    private:
+        const Sched::StepDesc* _steps = nullptr;
+        const Sched::Hooks* _hooks = nullptr;
+        void* _context = nullptr;
+        size_t _count = 0;
+        uint32_t _all = 0;
+
+        std::atomic<uint32_t> _state{ 0 };         // Bit(id) per completed step
+        std::atomic<uint32_t> _woken{ 0 };         // Wake() requests not yet seen by Poll()
+        std::atomic<bool> _polling{ false };
+
+        // Owned by the polling thread
+        uint32_t _armed = 0;                        // prerequisites done, nextDue set
+        uint64_t _nextDue[Sched::MaxSteps] = {};
+        uint32_t _backoff[Sched::MaxSteps] = {};
+        Sched::StepStats _stats[Sched::MaxSteps];
+    };
+}
@@ -0,0 +1,422 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// =============================================================================
+// Minimal x86-64 assembler for code caves
+// Covers the subset the caves and proxy thunks use: mov / lea / test / xor /
+// shr / add / sub, push / pop, SSE stores, jcc / jmp / call with labels and
+// jmp / call through a register. Everything is constexpr, so caves are
+// assembled at compile time; installing one is a memcpy plus a rel32 fixup
+// per jump that leaves the cave (Code::Link).
+//
+// Branches to labels start out short (rel8) and are widened to rel32 only
+// when the displacement does not fit. Widening is monotonic, so assembly
+// settles in a few passes and the output matches hand-picked encodings.
+// =============================================================================
+
+namespace CascadePatch::X64
+{
+    struct R64 { uint8_t id; };
+    struct R32 { uint8_t id; };
+    struct Xmm { uint8_t id; };
+
+    inline constexpr R64 rax{ 0 }, rcx{ 1 }, rdx{ 2 }, rbx{ 3 }, rsp{ 4 }, rbp{ 5 }, rsi{ 6 }, rdi{ 7 },
+                         r8{ 8 }, r9{ 9 }, r10{ 10 }, r11{ 11 }, r12{ 12 }, r13{ 13 }, r14{ 14 }, r15{ 15 };
+
+    inline constexpr R32 eax{ 0 }, ecx{ 1 }, edx{ 2 }, ebx{ 3 }, esp{ 4 }, ebp{ 5 }, esi{ 6 }, edi{ 7 },
+                         r8d{ 8 }, r9d{ 9 }, r10d{ 10 }, r11d{ 11 }, r12d{ 12 }, r13d{ 13 }, r14d{ 14 }, r15d{ 15 };
+
+    inline constexpr Xmm xmm0{ 0 }, xmm1{ 1 }, xmm2{ 2 }, xmm3{ 3 }, xmm4{ 4 }, xmm5{ 5 }, xmm6{ 6 }, xmm7{ 7 },
+                         xmm8{ 8 }, xmm9{ 9 }, xmm10{ 10 }, xmm11{ 11 }, xmm12{ 12 }, xmm13{ 13 }, xmm14{ 14 }, xmm15{ 15 };
+
+    constexpr uint8_t NoIndex = 0xFF;
+
+    // [base + index*scale + disp]
+    struct Mem
+    {
+        uint8_t base;
+        uint8_t index = NoIndex;
+        uint8_t scale = 1;
+        int32_t disp  = 0;
+    };
+
+    constexpr Mem Ptr(R64 base, int32_t disp = 0) { return { base.id, NoIndex, 1, disp }; }
+    constexpr Mem Ptr(R64 base, R64 index, uint8_t scale = 1, int32_t disp = 0)
+    {
+        return { base.id, index.id, scale, disp };
+    }
+
+    enum class Cond : uint8_t
+    {
+        O, NO, B, AE, E, NE, BE, A, S, NS, P, NP, L, GE, LE, G,
+        Z = E,
+        NZ = NE,
+    };
+
+    struct Label { uint8_t id; };
+
+    // Address outside the cave, supplied to Code::Link() by slot number
+    struct Target { uint8_t slot; };
+
+    // rel32 at `offset`, relative to the end of the field
+    struct Fixup
+    {
+        uint16_t offset = 0;
+        uint8_t  slot   = 0;
+    };
+
+    constexpr size_t MaxFixups = 8;
+
+    constexpr bool FitsRel8(int64_t v) { return v >= -128 && v <= 127; }
+    constexpr bool FitsRel32(int64_t v) { return v >= INT32_MIN && v <= INT32_MAX; }
+
+    template <size_t Cap>
+    struct Code
+    {
+        uint8_t bytes[Cap] = {};
+        size_t  size = 0;
+        Fixup   fixups[MaxFixups] = {};
+        size_t  fixupCount = 0;
+        bool    ok = false;
+
+        // Compares against a reference encoding, external rel32 fields as 00
+        constexpr bool Equals(const uint8_t* expected, size_t n) const
+        {
+            if (!ok || n != size) return false;
+            for (size_t i = 0; i < n; i++) {
+                if (bytes[i] != expected[i]) return false;
+            }
+            return true;
+        }
+
+        // Copies the cave to `dst` and points every external jump at
+        // targets[slot]. Nothing is written if a target is out of rel32 range.
+        bool Link(uint8_t* dst, const uintptr_t* targets, size_t targetCount) const
+        {
+            int32_t rel[MaxFixups] = {};
+            for (size_t i = 0; i < fixupCount; i++) {
+                if (fixups[i].slot >= targetCount) return false;
+                int64_t d = static_cast<int64_t>(targets[fixups[i].slot]) -
+                            static_cast<int64_t>(reinterpret_cast<uintptr_t>(dst) + fixups[i].offset + 4);
+                if (!FitsRel32(d)) return false;
+                rel[i] = static_cast<int32_t>(d);
+            }
+
+            memcpy(dst, bytes, size);
+            for (size_t i = 0; i < fixupCount; i++) {
+                memcpy(dst + fixups[i].offset, &rel[i], 4);
+            }
+            return true;
+        }
+    };
+
+    template <size_t Cap, typename Fn>
+    constexpr Code<Cap> Assemble(Fn&& fn);
+
+    template <size_t Cap>
+    class Assembler
+    {
+    public:
+        static constexpr size_t MaxLabels   = 16;
+        static constexpr size_t MaxBranches = 32;
+
+        constexpr Label NewLabel()
+        {
+            if (_labelCount >= MaxLabels) {
+                _failed = true;
+                return Label{ 0 };
+            }
+            return Label{ static_cast<uint8_t>(_labelCount++) };
+        }
+
+        constexpr void Bind(Label l) { _labels[l.id] = static_cast<int32_t>(_pos); }
+
+        constexpr size_t Position() const { return _pos; }
+
+        // Relocated original instructions, copied verbatim
+        constexpr void Raw(const uint8_t* data, size_t n)
+        {
+            for (size_t i = 0; i < n; i++) Byte(data[i]);
+        }
+
+        // ---- Integer ----
+
+        constexpr void Push(R64 r)
+        {
+            if (r.id >= 8) Byte(0x41);
+            Byte(0x50 | (r.id & 7));
+        }
+
+        constexpr void Pop(R64 r)
+        {
+            if (r.id >= 8) Byte(0x41);
+            Byte(0x58 | (r.id & 7));
+        }
+
+        constexpr void Mov(R64 dst, R64 src) { RegReg(true, 0x89, src.id, dst.id); }
+        constexpr void Mov(R32 dst, R32 src) { RegReg(false, 0x89, src.id, dst.id); }
+        constexpr void Mov(R64 dst, Mem src) { RegMem(true, 0x8B, dst.id, src); }
+        constexpr void Mov(Mem dst, R64 src) { RegMem(true, 0x89, src.id, dst); }
+
+        // mov qword/dword ptr [m], imm32 (sign-extended for qword)
+        constexpr void MovQword(Mem dst, int32_t imm) { RegMem(true, 0xC7, 0, dst); Dword(imm); }
+        constexpr void MovDword(Mem dst, int32_t imm) { RegMem(false, 0xC7, 0, dst); Dword(imm); }
+
+        constexpr void Lea(R64 dst, Mem src) { RegMem(true, 0x8D, dst.id, src); }
+
+        constexpr void Test(R64 a, R64 b) { RegReg(true, 0x85, b.id, a.id); }
+        constexpr void Test(R32 a, R32 b) { RegReg(false, 0x85, b.id, a.id); }
+
+        constexpr void Xor(R64 dst, R64 src) { RegReg(true, 0x31, src.id, dst.id); }
+        constexpr void Xor(R32 dst, R32 src) { RegReg(false, 0x31, src.id, dst.id); }
+
+        // Always the C1 /5 ib form
+        constexpr void Shr(R64 r, uint8_t count)
+        {
+            RegReg(true, 0xC1, 5, r.id);
+            Byte(count);
+        }
+
+        constexpr void Add(R64 r, int32_t imm) { ArithImm(0, r, imm); }
+        constexpr void Sub(R64 r, int32_t imm) { ArithImm(5, r, imm); }
+
+        // ---- SSE stores ----
+
+        constexpr void Movss(Mem dst, Xmm src) { Byte(0xF3); SseMem(src.id, dst); }
+        constexpr void Movsd(Mem dst, Xmm src) { Byte(0xF2); SseMem(src.id, dst); }
+        constexpr void Movups(Mem dst, Xmm src) { SseMem(src.id, dst); }
+
+        // ---- Control flow ----
+
+        constexpr void Jmp(Label l) { Branch(0xEB, 0, 0xE9, l); }
+        constexpr void Jcc(Cond c, Label l) { Branch(0x70 | uint8_t(c), 0x0F, 0x80 | uint8_t(c), l); }
+
+        // Indirect through a register (FF /4, FF /2)
+        constexpr void Jmp(R64 r) { RegReg(false, 0xFF, 4, r.id); }
+        constexpr void Call(R64 r) { RegReg(false, 0xFF, 2, r.id); }
+
+        constexpr void Jmp(Target t) { Byte(0xE9); External(t); }
+        constexpr void Call(Target t) { Byte(0xE8); External(t); }
+        constexpr void Jcc(Cond c, Target t)
+        {
+            Byte(0x0F);
+            Byte(0x80 | uint8_t(c));
+            External(t);
+        }
+
+    private:
+        template <size_t N, typename Fn>
+        friend constexpr Code<N> Assemble(Fn&& fn);
+
+        struct BranchRef
+        {
+            uint16_t at    = 0;  // displacement offset
+            uint8_t  width = 0;  // 1 or 4
+            uint8_t  label = 0;
+        };
+
+        constexpr void Byte(uint8_t b)
+        {
+            if (_pos >= Cap) {
+                _failed = true;
+                return;
+            }
+            _bytes[_pos++] = b;
+        }
+
+        constexpr void Dword(int32_t v)
+        {
+            uint32_t u = static_cast<uint32_t>(v);
+            for (int i = 0; i < 4; i++) Byte(static_cast<uint8_t>(u >> (8 * i)));
+        }
+
+        constexpr void Rex(bool w, uint8_t reg, uint8_t index, uint8_t base)
+        {
+            uint8_t rex = 0x40;
+            if (w) rex |= 0x08;
+            if (reg & 8) rex |= 0x04;
+            if (index != NoIndex && (index & 8)) rex |= 0x02;
+            if (base & 8) rex |= 0x01;
+            if (rex != 0x40) Byte(rex);
+        }
+
+        constexpr void RegReg(bool w, uint8_t op, uint8_t reg, uint8_t rm)
+        {
+            Rex(w, reg, NoIndex, rm);
+            Byte(op);
+            Byte(0xC0 | ((reg & 7) << 3) | (rm & 7));
+        }
+
+        constexpr void RegMem(bool w, uint8_t op, uint8_t reg, Mem m)
+        {
+            Rex(w, reg, m.index, m.base);
+            Byte(op);
+            ModRM(reg, m);
+        }
+
+        constexpr void SseMem(uint8_t reg, Mem m)
+        {
+            Rex(false, reg, m.index, m.base);
+            Byte(0x0F);
+            Byte(0x11);
+            ModRM(reg, m);
+        }
+
+        constexpr void ModRM(uint8_t reg, Mem m)
+        {
+            // rbp/r13 as base have no disp-less form; rsp/r12 as base need a SIB
+            uint8_t mod = 2;
+            if (m.disp == 0 && (m.base & 7) != 5) mod = 0;
+            else if (FitsRel8(m.disp)) mod = 1;
+
+            bool sib = m.index != NoIndex || (m.base & 7) == 4;
+            Byte(static_cast<uint8_t>((mod << 6) | ((reg & 7) << 3) | (sib ? 4 : (m.base & 7))));
+
+            if (sib) {
+                uint8_t ss = 0;
+                switch (m.scale) {
+                case 1: ss = 0; break;
+                case 2: ss = 1; break;
+                case 4: ss = 2; break;
+                case 8: ss = 3; break;
+                default: _failed = true; break;
+                }
+                if (m.index == 4) _failed = true;  // rsp cannot be an index
+                uint8_t index = (m.index == NoIndex) ? 4 : (m.index & 7);
+                Byte(static_cast<uint8_t>((ss << 6) | (index << 3) | (m.base & 7)));
+            }
+
+            if (mod == 1) Byte(static_cast<uint8_t>(static_cast<int8_t>(m.disp)));
+            else if (mod == 2) Dword(m.disp);
+        }
+
+        constexpr void ArithImm(uint8_t ext, R64 r, int32_t imm)
+        {
+            if (FitsRel8(imm)) {
+                RegReg(true, 0x83, ext, r.id);
+                Byte(static_cast<uint8_t>(static_cast<int8_t>(imm)));
+            } else {
+                RegReg(true, 0x81, ext, r.id);
+                Dword(imm);
+            }
+        }
+
+        constexpr void Branch(uint8_t shortOp, uint8_t nearPrefix, uint8_t nearOp, Label l)
+        {
+            if (_branchCount >= MaxBranches) {
+                _failed = true;
+                return;
+            }
+            size_t i = _branchCount++;
+            if (_wide[i]) {
+                if (nearPrefix) Byte(nearPrefix);
+                Byte(nearOp);
+                _branches[i] = { static_cast<uint16_t>(_pos), 4, l.id };
+                Dword(0);
+            } else {
+                Byte(shortOp);
+                _branches[i] = { static_cast<uint16_t>(_pos), 1, l.id };
+                Byte(0);
+            }
+        }
+
+        constexpr void External(Target t)
+        {
+            if (_fixupCount >= MaxFixups) {
+                _failed = true;
+                return;
+            }
+            _fixups[_fixupCount++] = { static_cast<uint16_t>(_pos), t.slot };
+            Dword(0);
+        }
+
+        constexpr void Reset()
+        {
+            _pos = 0;
+            _labelCount = 0;
+            _branchCount = 0;
+            _fixupCount = 0;
+            _failed = false;
+            for (auto& l : _labels) l = -1;
+        }
+
+        // Fills in label displacements. Returns false if a short branch had
+        // to be widened and another pass is needed.
+        constexpr bool Resolve()
+        {
+            if (_failed) return true;
+
+            bool widened = false;
+            for (size_t i = 0; i < _branchCount; i++) {
+                const BranchRef& b = _branches[i];
+                if (b.label >= _labelCount || _labels[b.label] < 0) {
+                    _failed = true;
+                    return true;
+                }
+                int64_t rel = int64_t(_labels[b.label]) - int64_t(b.at + b.width);
+                if (b.width == 1) {
+                    if (!FitsRel8(rel)) {
+                        _wide[i] = true;
+                        widened = true;
+                        continue;
+                    }
+                    _bytes[b.at] = static_cast<uint8_t>(static_cast<int8_t>(rel));
+                } else {
+                    uint32_t u = static_cast<uint32_t>(static_cast<int32_t>(rel));
+                    for (int k = 0; k < 4; k++) _bytes[b.at + k] = static_cast<uint8_t>(u >> (8 * k));
+                }
+            }
+            return !widened;
+        }
+
+        uint8_t   _bytes[Cap] = {};
+        size_t    _pos = 0;
+        bool      _failed = false;
+        int32_t   _labels[MaxLabels] = {};
+        size_t    _labelCount = 0;
+        BranchRef _branches[MaxBranches] = {};
+        bool      _wide[MaxBranches] = {};  // persists across passes
+        size_t    _branchCount = 0;
+        Fixup     _fixups[MaxFixups] = {};
+        size_t    _fixupCount = 0;
+    };
+
+    // Runs `fn(Assembler<Cap>&)` until branch sizes settle. The result has
+    // ok == false on overflow, an unbound label or a bad operand.
+    template <size_t Cap, typename Fn>
+    constexpr Code<Cap> Assemble(Fn&& fn)
+    {
+        Assembler<Cap> a;
+        for (int pass = 0; pass < 8; pass++) {
+            a.Reset();
+            fn(a);
+            if (!a.Resolve()) continue;
+
+            Code<Cap> code;
+            if (a._failed) return code;
+            for (size_t i = 0; i < a._pos; i++) code.bytes[i] = a._bytes[i];
+            code.size = a._pos;
+            for (size_t i = 0; i < a._fixupCount; i++) code.fixups[i] = a._fixups[i];
+            code.fixupCount = a._fixupCount;
+            code.ok = true;
+            return code;
+        }
+        return Code<Cap>{};
+    }
+
+    // Site patch: jmp rel32 from `site` to `target`, NOP-padded to `length`
+    inline bool EncodeJmp(uint8_t* out, size_t length, uintptr_t site, uintptr_t target)
+    {
+        int64_t rel = static_cast<int64_t>(target) - static_cast<int64_t>(site + 5);
+        if (length < 5 || !FitsRel32(rel)) return false;
+
+        int32_t rel32 = static_cast<int32_t>(rel);
+        out[0] = 0xE9;
+        memcpy(out + 1, &rel32, 4);
+        memset(out + 5, 0x90, length - 5);
+        return true;
+    }
+}
@@ -0,0 +1,106 @@
+#include "x64_decode.h"
+
+#include "x64_asm.h"
+
+#include <cstring>
+
+namespace CascadePatch::X64
+{
+    static int32_t Read32(const uint8_t* p)
+    {
+        int32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    static bool Rel32(uintptr_t target, uintptr_t next, int32_t& out)
+    {
+        int64_t d = static_cast<int64_t>(target - next);
+        if (!FitsRel32(d)) return false;
+        out = static_cast<int32_t>(d);
+        return true;
+    }
+
+    size_t Relocate(const uint8_t* src, size_t length, uintptr_t srcAddr,
+                    uint8_t* dst, size_t capacity, uintptr_t dstAddr)
+    {
+        size_t out = 0;
+        for (size_t off = 0; off < length;) {
+            Insn in = DecodeOne(src + off, length - off);
+            if (!in.length) return 0;
+
+            const uint8_t* s = src + off;
+            uintptr_t next = srcAddr + off + in.length;
+            uintptr_t at = dstAddr + out;
+
+            if (in.Has(Insn::RelBranch)) {
+                int64_t rel = (in.immSize == 1) ? static_cast<int8_t>(s[in.immOffset]) : Read32(s + in.immOffset);
+                uintptr_t target = next + rel;
+                if (target > srcAddr && target < srcAddr + length) return 0;
+
+                if (in.immSize == 1) {
+                    // jmp rel8 -> E9 rel32, jcc rel8 -> 0F 8x rel32; loop/jrcxz have no rel32 form
+                    bool jmp = in.opcode == 0xEB;
+                    if (!jmp && (in.opcode & 0xF0) != 0x70) return 0;
+                    size_t size = in.opcodeOffset + (jmp ? 5u : 6u);
+                    int32_t rel32;
+                    if (out + size > capacity || !Rel32(target, at + size, rel32)) return 0;
+                    uint8_t* d = dst + out;
+                    memcpy(d, s, in.opcodeOffset);
+                    d += in.opcodeOffset;
+                    if (jmp) {
+                        *d++ = 0xE9;
+                    } else {
+                        *d++ = 0x0F;
+                        *d++ = static_cast<uint8_t>(0x80 | (in.opcode & 0x0F));
+                    }
+                    memcpy(d, &rel32, 4);
+                    out += size;
+                    off += in.length;
+                    continue;
+                }
+
+                int32_t rel32;
+                if (out + in.length > capacity || !Rel32(target, at + in.length, rel32)) return 0;
+                memcpy(dst + out, s, in.length);
+                memcpy(dst + out + in.immOffset, &rel32, 4);
+            } else {
+                if (out + in.length > capacity) return 0;
+                memcpy(dst + out, s, in.length);
+                if (in.Has(Insn::RipRelative)) {
+                    int32_t disp;
+                    if (!Rel32(next + Read32(s + in.dispOffset), at + in.length, disp)) return 0;
+                    memcpy(dst + out + in.dispOffset, &disp, 4);
+                }
+            }
+            out += in.length;
+            off += in.length;
+        }
+        return out;
+    }
+
+    Location Locate(const uint8_t* entry, size_t avail, size_t target, Boundary kind)
+    {
+        Location loc;
+        for (size_t off = 0; off <= target && off < avail;) {
+            Insn in = DecodeOne(entry + off, avail - off);
+            if (!in.length) return loc;
+            loc.instructions++;
+
+            if (target < off + in.length) {
+                loc.start = off;
+                loc.insn = in;
+                size_t at = target - off;
+                if (kind == Boundary::Start) {
+                    loc.ok = at <= in.opcodeOffset;
+                } else {
+                    loc.ok = in.immSize && !in.Has(Insn::RelBranch) &&
+                             at >= in.immOffset && at < static_cast<size_t>(in.immOffset + in.immSize);
+                }
+                return loc;
+            }
+            off += in.length;
+        }
+        return loc;
+    }
+}
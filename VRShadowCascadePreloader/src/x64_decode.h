@@ -0,0 +1,308 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+
+// =============================================================================
+// x86-64 instruction-length decoder
+// Table-driven: legacy prefixes, REX, the one-byte / 0F / 0F38 / 0F3A maps,
+// VEX (C4/C5) and EVEX (62), ModRM/SIB, displacement, immediates and
+// relative branch operands. It only measures and classifies instructions;
+// it never names them. Everything here is constexpr, so site patterns can
+// be checked for whole-instruction boundaries at compile time.
+//
+// Relocate() moves whole instructions into a cave, rewriting RIP-relative
+// displacements and relative branches (rel8 branches are widened to rel32).
+// Locate() walks a function from its entry to prove that an address is an
+// instruction start or lies inside an immediate.
+// =============================================================================
+
+namespace CascadePatch::X64
+{
+    constexpr size_t MaxInstructionLength = 15;
+
+    struct Insn
+    {
+        enum Flag : uint8_t
+        {
+            RipRelative = 1 << 0,   // ModRM disp32 relative to the next instruction
+            RelBranch   = 1 << 1,   // imm field is a rel8 / rel32 branch displacement
+            Vex         = 1 << 2,   // VEX or EVEX encoded
+            Rex         = 1 << 3,
+        };
+
+        uint8_t length       = 0;   // 0: invalid or truncated
+        uint8_t map          = 0;   // 0 one-byte, 1 0F, 2 0F38, 3 0F3A (VEX/EVEX maps alike)
+        uint8_t opcode       = 0;
+        uint8_t opcodeOffset = 0;
+        uint8_t modrmOffset  = 0;   // 0: no ModRM
+        uint8_t dispOffset   = 0;
+        uint8_t dispSize     = 0;
+        uint8_t immOffset    = 0;
+        uint8_t immSize      = 0;
+        uint8_t flags        = 0;
+
+        constexpr bool Has(Flag f) const { return (flags & f) != 0; }
+    };
+
+    namespace Decode
+    {
+        enum : uint8_t
+        {
+            M       = 1 << 0,   // ModRM follows
+            I8      = 1 << 1,
+            I16     = 1 << 2,
+            Iz      = 1 << 3,   // 16 with 66, else 32
+            Iv      = 1 << 4,   // B8+r: 64 with REX.W, 16 with 66, else 32
+            Rel8    = 1 << 5,
+            Relz    = 1 << 6,   // rel32 (66 is ignored on 64-bit near branches)
+            Invalid = 1 << 7,
+        };
+
+        struct Tables
+        {
+            uint8_t oneByte[256] = {};
+            uint8_t map0F[256]   = {};
+        };
+
+        constexpr Tables Build()
+        {
+            Tables t{};
+            uint8_t* o = t.oneByte;
+
+            // ALU block: op r/m,r / r,r/m (M), op al,ib, op eax,iz, two invalid or prefix slots
+            for (int base = 0x00; base < 0x40; base += 8) {
+                o[base + 0] = o[base + 1] = o[base + 2] = o[base + 3] = M;
+                o[base + 4] = I8;
+                o[base + 5] = Iz;
+            }
+            for (int op : { 0x06, 0x07, 0x0E, 0x16, 0x17, 0x1E, 0x1F, 0x27, 0x2F, 0x37, 0x3F }) o[op] = Invalid;
+
+            o[0x60] = o[0x61] = Invalid;
+            o[0x63] = M;
+            o[0x68] = Iz;
+            o[0x69] = M | Iz;
+            o[0x6A] = I8;
+            o[0x6B] = M | I8;
+            for (int op = 0x70; op <= 0x7F; op++) o[op] = Rel8;
+            o[0x80] = M | I8;
+            o[0x81] = M | Iz;
+            o[0x82] = Invalid;
+            o[0x83] = M | I8;
+            for (int op = 0x84; op <= 0x8F; op++) o[op] = M;
+            o[0x9A] = Invalid;
+            o[0xA8] = I8;
+            o[0xA9] = Iz;
+            for (int op = 0xB0; op <= 0xB7; op++) o[op] = I8;
+            for (int op = 0xB8; op <= 0xBF; op++) o[op] = Iv;
+            o[0xC0] = o[0xC1] = M | I8;
+            o[0xC2] = I16;
+            o[0xC6] = M | I8;
+            o[0xC7] = M | Iz;
+            o[0xC8] = I16 | I8;
+            o[0xCA] = I16;
+            o[0xCD] = I8;
+            o[0xCE] = Invalid;
+            for (int op = 0xD0; op <= 0xD3; op++) o[op] = M;
+            o[0xD4] = o[0xD5] = o[0xD6] = Invalid;
+            for (int op = 0xD8; op <= 0xDF; op++) o[op] = M;
+            for (int op = 0xE0; op <= 0xE3; op++) o[op] = Rel8;
+            for (int op = 0xE4; op <= 0xE7; op++) o[op] = I8;
+            o[0xE8] = o[0xE9] = Relz;
+            o[0xEA] = Invalid;
+            o[0xEB] = Rel8;
+            o[0xF6] = o[0xF7] = M;          // TEST immediates handled by the decoder
+            o[0xFE] = o[0xFF] = M;
+
+            uint8_t* z = t.map0F;
+            for (int op = 0; op < 256; op++) z[op] = M;
+            for (int op : { 0x05, 0x06, 0x07, 0x08, 0x09, 0x0B, 0x0E, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35,
+                            0x37, 0x77, 0xA0, 0xA1, 0xA2, 0xA8, 0xA9, 0xAA }) {
+                z[op] = 0;
+            }
+            for (int op = 0xC8; op <= 0xCF; op++) z[op] = 0;
+            for (int op : { 0x04, 0x0A, 0x0C, 0x24, 0x25, 0x26, 0x27, 0x36, 0x39, 0x3B, 0x3C, 0x3D, 0x3E,
+                            0x3F, 0x7A, 0x7B, 0xA6, 0xA7 }) {
+                z[op] = Invalid;
+            }
+            for (int op = 0x80; op <= 0x8F; op++) z[op] = Relz;
+            for (int op : { 0x0F, 0x70, 0x71, 0x72, 0x73, 0xA4, 0xAC, 0xBA, 0xC2, 0xC4, 0xC5, 0xC6 }) {
+                z[op] = M | I8;
+            }
+            return t;
+        }
+
+        inline constexpr Tables Table = Build();
+
+        constexpr bool IsLegacyPrefix(uint8_t b)
+        {
+            return b == 0x66 || b == 0x67 || b == 0xF0 || b == 0xF2 || b == 0xF3 ||
+                   b == 0x2E || b == 0x36 || b == 0x3E || b == 0x26 || b == 0x64 || b == 0x65;
+        }
+    }
+
+    // Decodes one instruction; length 0 if it is invalid in 64-bit mode or
+    // runs past `avail`
+    constexpr Insn DecodeOne(const uint8_t* code, size_t avail)
+    {
+        using namespace Decode;
+
+        Insn in{};
+        if (avail > MaxInstructionLength) avail = MaxInstructionLength;
+        size_t pos = 0;
+        bool opsize16 = false, addr32 = false, rexW = false;
+
+        while (pos < avail && IsLegacyPrefix(code[pos])) {
+            if (code[pos] == 0x66) opsize16 = true;
+            if (code[pos] == 0x67) addr32 = true;
+            pos++;
+        }
+        if (pos < avail && (code[pos] & 0xF0) == 0x40) {
+            rexW = (code[pos] & 0x08) != 0;
+            in.flags |= Insn::Rex;
+            pos++;
+        }
+        if (pos >= avail) return Insn{};
+
+        uint8_t flags = 0;
+        uint8_t b = code[pos];
+        if (b == 0xC4 || b == 0xC5 || b == 0x62) {
+            // VEX3 C4 RXBmmmmm WvvvvLpp / VEX2 C5 RvvvvLpp / EVEX 62 P0 P1 P2
+            size_t prefixLength = (b == 0xC5) ? 2 : (b == 0xC4) ? 3 : 4;
+            if (pos + prefixLength >= avail) return Insn{};
+            uint8_t map = (b == 0xC5) ? 1 : (code[pos + 1] & ((b == 0x62) ? 0x07 : 0x1F));
+            if (b == 0xC4) rexW = (code[pos + 2] & 0x80) != 0;
+            if (map < 1 || map > ((b == 0x62) ? 6 : 3) || map == 4) return Insn{};
+            in.flags |= Insn::Vex;
+            pos += prefixLength;
+            in.map = map > 3 ? 2 : map;     // EVEX maps 5/6 have no immediates, like 0F38
+            in.opcodeOffset = static_cast<uint8_t>(pos);
+            in.opcode = code[pos++];
+            flags = (in.map == 1 && in.opcode == 0x77) ? 0 : M;    // vzeroupper / vzeroall
+            if (in.map == 3) flags |= I8;
+            else if (in.map == 1) flags |= Table.map0F[in.opcode] & I8;
+        } else if (b == 0x0F) {
+            pos++;
+            if (pos >= avail) return Insn{};
+            uint8_t b2 = code[pos];
+            if (b2 == 0x38 || b2 == 0x3A) {
+                in.map = (b2 == 0x38) ? 2 : 3;
+                pos++;
+                if (pos >= avail) return Insn{};
+                flags = (b2 == 0x3A) ? (M | I8) : M;
+            } else {
+                in.map = 1;
+                flags = Table.map0F[b2];
+            }
+            in.opcodeOffset = static_cast<uint8_t>(pos);
+            in.opcode = code[pos++];
+        } else {
+            in.opcodeOffset = static_cast<uint8_t>(pos);
+            in.opcode = b;
+            pos++;
+            flags = Table.oneByte[b];
+            if (b >= 0xA0 && b <= 0xA3) {
+                // mov al/eax/rax <-> moffs: address-sized offset
+                in.immOffset = static_cast<uint8_t>(pos);
+                in.immSize = addr32 ? 4 : 8;
+                pos += in.immSize;
+                if (pos > avail) return Insn{};
+                in.length = static_cast<uint8_t>(pos);
+                return in;
+            }
+        }
+        if (flags & Invalid) return Insn{};
+
+        if (flags & M) {
+            if (pos >= avail) return Insn{};
+            uint8_t modrm = code[pos];
+            in.modrmOffset = static_cast<uint8_t>(pos++);
+            uint8_t mod = modrm >> 6, rm = modrm & 7;
+
+            // F6 /0-/1 and F7 /0-/1 are TEST with an immediate
+            if (in.map == 0 && (in.opcode == 0xF6 || in.opcode == 0xF7) && ((modrm >> 3) & 7) < 2) {
+                flags |= (in.opcode == 0xF6) ? I8 : Iz;
+            }
+
+            if (mod != 3) {
+                if (rm == 4) {
+                    if (pos >= avail) return Insn{};
+                    uint8_t sib = code[pos++];
+                    if (mod == 0 && (sib & 7) == 5) in.dispSize = 4;
+                } else if (mod == 0 && rm == 5) {
+                    in.dispSize = 4;
+                    in.flags |= Insn::RipRelative;
+                }
+                if (mod == 1) in.dispSize = 1;
+                if (mod == 2) in.dispSize = 4;
+                if (in.dispSize) {
+                    in.dispOffset = static_cast<uint8_t>(pos);
+                    pos += in.dispSize;
+                }
+            }
+        }
+
+        uint8_t imm = 0;
+        if (flags & I8) imm += 1;
+        if (flags & I16) imm += 2;
+        if (flags & Iz) imm += (opsize16 && !rexW) ? 2 : 4;
+        if (flags & Iv) imm += rexW ? 8 : opsize16 ? 2 : 4;
+        if (flags & Rel8) imm += 1;
+        if (flags & Relz) imm += 4;
+        if (flags & (Rel8 | Relz)) in.flags |= Insn::RelBranch;
+        if (imm) {
+            in.immOffset = static_cast<uint8_t>(pos);
+            in.immSize = imm;
+            pos += imm;
+        }
+
+        if (pos > avail) return Insn{};
+        in.length = static_cast<uint8_t>(pos);
+        return in;
+    }
+
+    // Length of the shortest run of whole instructions covering at least
+    // `minBytes`; 0 if one of them does not decode
+    constexpr size_t CoverLength(const uint8_t* code, size_t avail, size_t minBytes)
+    {
+        size_t length = 0;
+        while (length < minBytes) {
+            Insn in = DecodeOne(code + length, avail - length);
+            if (!in.length) return 0;
+            length += in.length;
+        }
+        return length;
+    }
+
+    // Copies the whole instructions in [src, src + length), which execute at
+    // `srcAddr`, to `dst`, which will execute at `dstAddr`. RIP-relative
+    // operands and rel32 branches are re-aimed at their original targets;
+    // jcc/jmp rel8 become their rel32 forms. Returns the bytes written, or 0
+    // if an instruction does not decode, a target is out of rel32 range, a
+    // branch lands inside the moved range, or the instruction cannot be moved
+    // (loop/jrcxz).
+    size_t Relocate(const uint8_t* src, size_t length, uintptr_t srcAddr,
+                    uint8_t* dst, size_t capacity, uintptr_t dstAddr);
+
+    // Upper bound on Relocate() output for `count` instructions
+    constexpr size_t RelocatedSize(size_t length, size_t count) { return length + 4 * count; }
+
+    enum class Boundary : uint8_t
+    {
+        Start,      // an instruction (or its opcode, after prefixes) starts at the target
+        Imm,        // the target byte is inside an instruction's immediate
+    };
+
+    struct Location
+    {
+        bool     ok = false;
+        uint32_t instructions = 0;    // decoded from the entry up to the target
+        size_t   start = 0;           // offset of the instruction holding the target
+        Insn     insn{};
+    };
+
+    // Linear sweep from `entry` until the instruction containing
+    // entry[target] is found
+    Location Locate(const uint8_t* entry, size_t avail, size_t target, Boundary kind);
+}
@@ -0,0 +1,213 @@
+// =============================================================================
+// arena_search - code arena placement: region walk vs. granule probing
+//
+//   arena_search [--packed MB] [--repeat N]
+//   arena_search --synthetic [--packed MB] [--repeat N] [--seed N]
+//
+// The preloader used to find cave memory by trying VirtualAlloc at every
+// 64 KB step out from the site until one succeeded. The code arena walks the
+// free regions of the address space instead (code_arena.h).
+//
+// Live mode runs both against this process with mmap: --packed maps MB of
+// 64 KB-aligned blocks directly above and below the executable first, the way
+// the game's heaps crowd Fallout4VR.exe. --synthetic builds an address-space
+// map around a 1.2.72-sized image and answers queries with VirtualQuery
+// semantics, so Windows layouts can be replayed without Windows.
+// =============================================================================
+
+#include "code_arena.h"
+#include "os_memory.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace CascadePatch;
+
+using Clock = std::chrono::steady_clock;
+
+constexpr size_t Granule = 64 * 1024;
+
+static double ElapsedUs(Clock::time_point t0)
+{
+    return std::chrono::duration<double, std::micro>(Clock::now() - t0).count();
+}
+
+// ---- Synthetic address space ----
+
+struct SyntheticMap
+{
+    std::vector<OS::Region> mapped;  // sorted, non-overlapping
+
+    bool Taken(uintptr_t addr, size_t size) const
+    {
+        for (const OS::Region& m : mapped) {
+            if (addr < m.base + m.size && m.base < addr + size) return true;
+        }
+        return false;
+    }
+
+    // VirtualQuery semantics: a free region starts at the queried page
+    bool Query(uintptr_t addr, OS::Region& out) const
+    {
+        auto it = std::upper_bound(mapped.begin(), mapped.end(), addr,
+                                   [](uintptr_t a, const OS::Region& r) { return a < r.base + r.size; });
+        if (it != mapped.end() && it->base <= addr) {
+            out = *it;
+            return true;
+        }
+        uintptr_t page = AlignDown(addr, 4096);
+        uintptr_t end = (it == mapped.end()) ? 0x7FFFFFFF0000ull : it->base;
+        out = { page, static_cast<size_t>(end - page), true };
+        return true;
+    }
+};
+
+// Old AllocateNearby: one allocation attempt per granule, above then below
+template <typename TryAt>
+static uintptr_t ProbeNearby(uintptr_t target, size_t size, TryAt&& tryAt, uint32_t& probes)
+{
+    probes = 0;
+    for (uintptr_t offset = Granule; offset < 0x7F000000; offset += Granule) {
+        probes++;
+        if (tryAt(AlignDown(target + offset, Granule), size)) return AlignDown(target + offset, Granule);
+        if (target > offset) {
+            probes++;
+            if (tryAt(AlignDown(target - offset, Granule), size)) return AlignDown(target - offset, Granule);
+        }
+    }
+    return 0;
+}
+
+static int RunSynthetic(size_t packedMB, int repeat, unsigned seed)
+{
+    const uintptr_t moduleBase = 0x140000000ull;
+    const size_t moduleSize = 0x6900000;  // Fallout4VR.exe 1.2.72 SizeOfImage, rounded
+
+    std::mt19937_64 rng(seed);
+    std::uniform_int_distribution<size_t> blocks(1, 64);  // 64 KB .. 4 MB allocations
+
+    SyntheticMap map;
+    const size_t packed = packedMB * 1024 * 1024;
+    std::vector<OS::Region> below;
+    for (uintptr_t top = moduleBase; moduleBase - top < packed;) {
+        size_t sz = blocks(rng) * Granule;
+        below.push_back({ top - sz, sz, false });
+        top -= sz;
+    }
+    map.mapped.assign(below.rbegin(), below.rend());
+    map.mapped.push_back({ moduleBase, moduleSize, false });
+    for (uintptr_t base = moduleBase + moduleSize; base - (moduleBase + moduleSize) < packed;) {
+        size_t sz = blocks(rng) * Granule;
+        map.mapped.push_back({ base, sz, false });
+        base += sz;
+    }
+
+    printf("synthetic: %zu mapped regions, %zu MB packed on each side of the image\n",
+           map.mapped.size(), packedMB);
+
+    uint32_t queries = 0;
+    uintptr_t found = 0;
+    auto t0 = Clock::now();
+    for (int i = 0; i < repeat; i++) {
+        FindFreeNear([&](uintptr_t a, OS::Region& r) { return map.Query(a, r); },
+                     moduleBase, moduleBase + moduleSize, CodeArena::DefaultSize, Granule, found, &queries);
+    }
+    double walkUs = ElapsedUs(t0) / repeat;
+
+    uint32_t probes = 0;
+    uintptr_t probed = 0;
+    t0 = Clock::now();
+    for (int i = 0; i < repeat; i++) {
+        probed = ProbeNearby(moduleBase, 64, [&](uintptr_t a, size_t sz) { return !map.Taken(a, sz); }, probes);
+    }
+    double probeUs = ElapsedUs(t0) / repeat;
+
+    printf("  region walk:   0x%llX  %6u queries  %9.2f us\n", (unsigned long long)found, queries, walkUs);
+    printf("  granule probe: 0x%llX  %6u probes   %9.2f us (one VirtualAlloc attempt each, per cave)\n",
+           (unsigned long long)probed, probes, probeUs);
+    return found ? 0 : 1;
+}
+
+// ---- Live (this process, mmap) ----
+
+static int RunLive(size_t packedMB, int repeat)
+{
+    OS::AddressMap map;
+    OS::Region self;
+    if (!map.Refresh() || !map.Query(reinterpret_cast<uintptr_t>(&RunLive), self)) {
+        fprintf(stderr, "cannot read the address space map\n");
+        return 1;
+    }
+
+    // Crowd the executable the way the game's heaps crowd Fallout4VR.exe
+    std::vector<void*> crowd;
+    const size_t packed = packedMB * 1024 * 1024;
+    for (size_t off = 0; off < packed; off += Granule) {
+        uintptr_t above = AlignUp(self.base + self.size, Granule) + off;
+        uintptr_t below = AlignDown(self.base, Granule) - Granule - off;
+        if (void* p = OS::MapAt(above, Granule)) crowd.push_back(p);
+        if (void* p = OS::MapAt(below, Granule)) crowd.push_back(p);
+    }
+
+    printf("live: image mapping 0x%llX-0x%llX, %zu x 64 KB blocks mapped around it\n",
+           (unsigned long long)self.base, (unsigned long long)(self.base + self.size), crowd.size());
+
+    double walkUs = 0.0, probeUs = 0.0;
+    uint32_t queries = 0, probes = 0;
+    uintptr_t walkAt = 0, probeAt = 0;
+    for (int i = 0; i < repeat; i++) {
+        auto t0 = Clock::now();
+        CodeArena* arena = new CodeArena;
+        bool ok = arena->Init(self.base, self.size);
+        walkUs += ElapsedUs(t0);
+        if (!ok) {
+            fprintf(stderr, "arena reservation failed\n");
+            return 1;
+        }
+        queries = arena->Queries();
+        walkAt = arena->Base();
+        OS::Unmap(reinterpret_cast<void*>(arena->Base()), arena->Size());
+        delete arena;
+
+        t0 = Clock::now();
+        void* cave = nullptr;
+        probeAt = ProbeNearby(self.base, 64, [&](uintptr_t a, size_t sz) { return (cave = OS::MapAt(a, sz)) != nullptr; },
+                              probes);
+        probeUs += ElapsedUs(t0);
+        if (cave) OS::Unmap(cave, 64);
+    }
+
+    printf("  region walk:   0x%llX  %6u queries  %9.2f us (incl. /proc/self/maps snapshot)\n",
+           (unsigned long long)walkAt, queries, walkUs / repeat);
+    printf("  granule probe: 0x%llX  %6u probes   %9.2f us per cave\n",
+           (unsigned long long)probeAt, probes, probeUs / repeat);
+
+    for (void* p : crowd) OS::Unmap(p, Granule);
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    bool synthetic = false;
+    size_t packedMB = 256;
+    int repeat = 20;
+    unsigned seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--synthetic")) synthetic = true;
+        else if (!strcmp(argv[i], "--packed") && i + 1 < argc) packedMB = strtoul(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) repeat = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = static_cast<unsigned>(atoi(argv[++i]));
+        else {
+            fprintf(stderr, "usage: arena_search [--synthetic] [--packed MB] [--repeat N] [--seed N]\n");
+            return 2;
+        }
+    }
+    if (repeat < 1) repeat = 1;
+
+    return synthetic ? RunSynthetic(packedMB, repeat, seed) : RunLive(packedMB, repeat);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdarg>
+#include <cstdio>
+
+// =============================================================================
+// Pass/fail bookkeeping for the tools/*_check and *_sim programs
+// Check() and Fail() print a "FAIL:" line and count it; Report() prints the
+// summary and returns the exit code, which is what CTest reads.
+// =============================================================================
+
+namespace ToolCheck
+{
+    inline int failures = 0;
+
+    inline void Fail(const char* format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        printf("FAIL: ");
+        vprintf(format, args);
+        printf("\n");
+        va_end(args);
+        failures++;
+    }
+
+    inline void Check(bool ok, const char* what)
+    {
+        if (!ok) Fail("%s", what);
+    }
+
+    inline void Check(bool ok, const char* what, const char* detail)
+    {
+        if (!ok) Fail("%s (%s)", what, detail);
+    }
+
+    inline int Report()
+    {
+        if (failures) {
+            printf("\n%d check(s) FAILED\n", failures);
+            return 1;
+        }
+        printf("\nall checks passed\n");
+        return 0;
+    }
+}
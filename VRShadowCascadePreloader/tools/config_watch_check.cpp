@@ -0,0 +1,212 @@
+// =============================================================================
+// config_watch_check - INI change detection with temp files
+//
+//   config_watch_check [--bench]
+//
+// Writes an INI shaped like ShadowBoostF4VR's MCM settings to a temp file,
+// then rewrites it the ways MCM, an editor and the plugin itself do. After
+// each rewrite it checks the Result, the changed keys and the subsystem
+// bits:
+// - the same bytes, or only comments and whitespace, count as unchanged
+// - a value, an added key or a removed key is reported, routed by section
+// - case differences (SimpleIni ignores case) are not changes
+// - a missing file keeps the last values, so recreating it diffs against them
+// and that RouteSection() routes the plugin's mixed-case field sections.
+// --bench times Check() on an unchanged and a changed file.
+// =============================================================================
+
+#include "check.h"
+#include "config_watch.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    enum Subsystem : uint32_t
+    {
+        Governor = 1 << 0,
+        GodRays  = 1 << 1,
+        Writes   = 1 << 2,
+    };
+
+    // Mirrors the plugin's table; [Stats] is deliberately unrouted
+    const SectionRoute Routes[] = {
+        { "Main", Governor },  { "Controller", Governor },     { "CostModel", Governor },
+        { "Shadow", Governor }, { "Lod", Governor },           { "Grass", Governor },
+        { "TerrainManager", Governor }, { "GodRays", GodRays }, { "Writes", Writes },
+    };
+
+    const char* const Base =
+        "[Main]\n"
+        "bAutoAdjust=0\n"
+        "fFpsTarget=90.0\n"
+        "\n"
+        "[Stats]\n"
+        "fFrameTimeMean=0.0\n"
+        "\n"
+        "[Shadow]\n"
+        "fMinDistance=500.0\n"
+        "fMaxDistance=8000.0\n"
+        "\n"
+        "[TerrainManager:Level2]\n"
+        "fBlockLevel0Distance=20000.0\n"
+        "\n"
+        "[GodRays]\n"
+        "bEnable=0\n"
+        "fScale=0.4\n";
+
+    std::string Replace(std::string s, const char* from, const char* to)
+    {
+        size_t at = s.find(from);
+        if (at != std::string::npos) s.replace(at, strlen(from), to);
+        return s;
+    }
+
+    void Write(const std::string& path, const std::string& text)
+    {
+        FILE* f = fopen(path.c_str(), "wb");
+        fwrite(text.data(), 1, text.size(), f);
+        fclose(f);
+    }
+
+    struct Case
+    {
+        const char* name;
+        std::string text;               // empty = delete the file
+        ConfigFileWatch::Result result;
+        uint32_t    subsystems;
+        const char* keys;               // comma-separated, in diff order
+    };
+
+    std::string Join(const ConfigChange& c)
+    {
+        std::string s;
+        for (const auto& k : c.keys) s += (s.empty() ? "" : ",") + k;
+        return s;
+    }
+
+    void CheckCases(const std::string& path)
+    {
+        using R = ConfigFileWatch::Result;
+        std::string base = Base;
+        std::string godRays = Replace(base, "fScale=0.4", "fScale=0.6");
+        const Case cases[] = {
+            { "rewritten, same bytes", base, R::Unchanged, 0, "" },
+            { "comments and spacing", "; written by MCM\r\n" + Replace(base, "bAutoAdjust=0", "bAutoAdjust = 0  "),
+              R::Unchanged, 0, "" },
+            { "god rays scale", godRays, R::Changed, GodRays, "godrays/fscale" },
+            { "stats only (the plugin's own write)", Replace(godRays, "fFrameTimeMean=0.0", "fFrameTimeMean=11.3"),
+              R::Changed, 0, "stats/fframetimemean" },
+            { "block level tier section", Replace(godRays, "fBlockLevel0Distance=20000.0", "fBlockLevel0Distance=25000.0"),
+              R::Changed, Governor, "stats/fframetimemean,terrainmanager:level2/fblocklevel0distance" },
+            { "key added", godRays + "[Writes]\nfShadowEpsilon=2.0\n", R::Changed, Governor | Writes,
+              "terrainmanager:level2/fblocklevel0distance,writes/fshadowepsilon" },
+            { "key removed", Replace(godRays + "[Writes]\nfShadowEpsilon=2.0\n", "fMinDistance=500.0\n", ""),
+              R::Changed, Governor, "shadow/fmindistance" },
+            { "case only", Replace(Replace(godRays + "[Writes]\nfShadowEpsilon=2.0\n", "fMinDistance=500.0\n", ""),
+                                   "[GodRays]", "[GODRAYS]"),
+              R::Unchanged, 0, "" },
+            { "deleted", "", R::Missing, 0, "" },
+            { "recreated with two changes", Replace(Replace(base, "fFpsTarget=90.0", "fFpsTarget=80.0"), "bEnable=0", "bEnable=1"),
+              R::Changed, Governor | GodRays | Writes,
+              "godrays/benable,godrays/fscale,main/ffpstarget,shadow/fmindistance,writes/fshadowepsilon" },
+        };
+
+        ConfigFileWatch watch;
+        Write(path, base);
+        watch.Open(path, Routes, sizeof(Routes) / sizeof(Routes[0]));
+        Check(watch.Values().Find("GodRays", "fScale") && *watch.Values().Find("GodRays", "fScale") == "0.4",
+              "baseline not parsed");
+
+        const char* results[] = { "unchanged", "changed", "missing" };
+        for (const Case& c : cases) {
+            if (c.text.empty()) remove(path.c_str());
+            else Write(path, c.text);
+            ConfigChange change;
+            ConfigFileWatch::Result r = watch.Check(change);
+            std::string keys = Join(change);
+            bool ok = r == c.result && change.subsystems == c.subsystems && keys == c.keys;
+            printf("  %-38s %-9s mask %u  %s\n", c.name, results[static_cast<int>(r)], change.subsystems,
+                   keys.c_str());
+            if (!ok) {
+                Fail("%s: expected %s mask %u keys '%s'", c.name, results[static_cast<int>(c.result)],
+                     c.subsystems, c.keys);
+            }
+        }
+        const auto& s = watch.Stats();
+        printf("  checks %llu: same hash %llu, same values %llu, changed %llu, missing %llu\n",
+               static_cast<unsigned long long>(s.checks), static_cast<unsigned long long>(s.sameHash),
+               static_cast<unsigned long long>(s.sameValues), static_cast<unsigned long long>(s.changed),
+               static_cast<unsigned long long>(s.missing));
+    }
+
+    // The plugin routes schema fields (mixed case) through the same table
+    void CheckRoutes()
+    {
+        const size_t n = sizeof(Routes) / sizeof(Routes[0]);
+        Check(RouteSection(Routes, n, "Writes") == Writes, "field section routed");
+        Check(RouteSection(Routes, n, "godrays") == GodRays, "lowercase section routed");
+        Check(RouteSection(Routes, n, "TerrainManager:Level3") == Governor, "suffixed section routed");
+        Check(RouteSection(Routes, n, "TerrainManagerX") == 0, "prefix without ':' routed");
+        Check(RouteSection(Routes, n, "Stats") == 0, "[Stats] routed");
+    }
+
+    void Bench(const std::string& path)
+    {
+        // About the size of the real MCM settings file
+        std::string text;
+        for (int s = 0; s < 12; s++) {
+            text += "[Section" + std::to_string(s) + "]\n";
+            for (int k = 0; k < 8; k++) text += "fKey" + std::to_string(k) + "=" + std::to_string(s * 100 + k) + ".0\n";
+        }
+        Write(path, text);
+        ConfigFileWatch watch;
+        watch.Open(path, Routes, sizeof(Routes) / sizeof(Routes[0]));
+        ConfigChange change;
+
+        const int n = 2000;
+        auto t0 = Clock::now();
+        for (int i = 0; i < n; i++) watch.Check(change);
+        double same = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / n;
+
+        std::string alt = Replace(text, "fKey3=503.0", "fKey3=999.0");
+        double changed = 0.0;
+        for (int i = 0; i < n; i++) {
+            Write(path, (i & 1) ? text : alt);
+            auto t1 = Clock::now();
+            watch.Check(change);
+            changed += std::chrono::duration<double, std::micro>(Clock::now() - t1).count();
+        }
+        printf("\nCheck() on a %zu-byte file: %.1f us unchanged (read + hash), %.1f us changed (+ parse + diff)\n",
+               text.size(), same, changed / n);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--bench")) bench = true;
+        else {
+            fprintf(stderr, "usage: config_watch_check [--bench]\n");
+            return 2;
+        }
+    }
+
+    std::string path = "config_watch_check.ini";
+    printf("%s:\n", path.c_str());
+    CheckCases(path);
+    CheckRoutes();
+    if (bench) Bench(path);
+    remove(path.c_str());
+
+    return Report();
+}
@@ -0,0 +1,238 @@
+// =============================================================================
+// controller_check - QualityController checks and step response
+//
+//   controller_check [--seed N] [--verbose]
+//
+// Checks that Params::P() reproduces the original update
+// (clamp(cur - dyn * factor, min, max) with the dead zone) bit for bit on
+// random error sequences. Checks that a saturated knob leaves its limit on
+// the first update with the opposite error (anti-windup), that the slew
+// limits and the degrade/restore asymmetry hold, and that an unfiltered D
+// term is the plain second difference.
+// Then runs P and PID against a shadow-distance plant: frame time rises
+// linearly with the distance and reacts one adjustment late, with
+// measurement noise and a heavier scene from adjustment 100 to 250. For each
+// controller it reports the settling time, overshoot and oscillation count
+// after each load change.
+// =============================================================================
+
+#include "check.h"
+#include "quality_controller.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+namespace
+{
+    // ShadowBoost::update() before the controller module
+    float OriginalStep(float cur, float avgMs, float targetMs, float tolerance, float factor, float min, float max)
+    {
+        float dyn = avgMs - targetMs;
+        if (dyn >= 0.0f && dyn <= tolerance) dyn = 0.0f;
+        return std::clamp(cur - dyn * factor, min, max);
+    }
+
+    void CheckOriginal(std::mt19937_64& rng)
+    {
+        std::uniform_real_distribution<float> frame(6.0f, 30.0f), factor(0.05f, 200.0f), tol(0.0f, 2.0f);
+        int mismatches = 0, updates = 0;
+        for (int run = 0; run < 200; run++) {
+            float f = factor(rng), t = tol(rng);
+            float min = 500.0f, max = 8000.0f, target = 1000.0f / 90.0f;
+            QualityController c;
+            c.SetParams(QualityController::Params::P(t));
+            float a = 4000.0f, b = 4000.0f;
+            for (int i = 0; i < 500; i++, updates++) {
+                float avg = frame(rng);
+                a = OriginalStep(a, avg, target, t, f, min, max);
+                c.Update(avg - target);
+                b = c.Apply(b, f, min, max);
+                if (memcmp(&a, &b, sizeof(float)) != 0) mismatches++;
+            }
+        }
+        Check(mismatches == 0, "Params::P() differs from the original update");
+        printf("P preset: %d updates, %d differ from the original update\n", updates, mismatches);
+    }
+
+    void CheckLimits()
+    {
+        const float min = 500.0f, max = 8000.0f, factor = 30.0f;
+
+        // Anti-windup: 200 updates far over budget pin the knob at min; the
+        // first update under budget must move it up
+        QualityController c;
+        c.SetParams(QualityController::Params::PID(0.5f));
+        float v = 4000.0f;
+        for (int i = 0; i < 200; i++) {
+            c.Update(20.0f);
+            v = c.Apply(v, factor, min, max);
+        }
+        Check(v == min, "knob not saturated at min");
+        c.Update(-3.0f);
+        float after = c.Apply(v, factor, min, max);
+        Check(after > min, "knob stayed at min after the error changed sign (windup)");
+        printf("anti-windup: at %.0f after 200 updates over budget, %.1f after one under\n", v, after);
+
+        // Slew limits: one huge error moves at most 10% (degrade) / 2% (restore) of the range
+        QualityController::Params p = QualityController::Params::PID(0.0f);
+        c.SetParams(p);
+        c.Reset();
+        c.Update(0.0f);
+        c.Update(100.0f);
+        float down = 4000.0f - c.Apply(4000.0f, factor, min, max);
+        c.Reset();
+        c.Update(0.0f);
+        c.Update(-100.0f);
+        float up = c.Apply(4000.0f, factor, min, max) - 4000.0f;
+        Check(std::fabs(down - p.maxDegradeStep * (max - min)) < 0.01f, "degrade slew limit");
+        Check(std::fabs(up - p.maxRestoreStep * (max - min)) < 0.01f, "restore slew limit");
+        printf("slew limits: %.0f down, %.0f up per update at +/-100 ms\n", down, up);
+
+        // Asymmetric gains below the slew limits
+        p.maxDegradeStep = p.maxRestoreStep = 0.0f;
+        p.kp = p.kd = 0.0f;
+        p.ki = 1.0f;
+        c.SetParams(p);
+        c.Reset();
+        c.Update(1.0f);
+        float d = 4000.0f - c.Apply(4000.0f, factor, min, max);
+        c.Reset();
+        c.Update(-1.0f);
+        float r = c.Apply(4000.0f, factor, min, max) - 4000.0f;
+        Check(std::fabs(d - factor * p.degradeGain) < 0.01f && std::fabs(r - factor * p.restoreGain) < 0.01f,
+              "degrade/restore gains");
+
+        // Unfiltered D term is the second difference of the error
+        p = QualityController::Params{};
+        p.ki = 0.0f;
+        p.kd = 1.0f;
+        c.SetParams(p);
+        c.Reset();
+        const float e[] = { 1.0f, 3.0f, 2.0f, 7.0f };
+        c.Update(e[0]);
+        c.Update(e[1]);
+        bool second = true;
+        for (int i = 2; i < 4; i++) {
+            float step = c.Update(e[i]);
+            second &= std::fabs(step - (e[i] - 2 * e[i - 1] + e[i - 2])) < 1e-5f;
+        }
+        Check(second, "unfiltered D term");
+    }
+
+    // ---- Shadow distance plant ----
+    struct Response
+    {
+        int settle[2] = {};         // adjustments until |error| stays under 1 ms, per load change
+        float overshootMs[2] = {};  // worst error past the target, per load change
+        int oscillations = 0;       // sign changes of the error outside the tolerance
+        float overMs = 0.0f;        // sum of positive errors (ms x adjustments)
+        float meanAbsMs = 0.0f;
+    };
+
+    Response Run(const QualityController::Params& params, uint64_t seed, bool verbose, const char* name)
+    {
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<float> noise(0.0f, 0.25f);
+        const float min = 500.0f, max = 8000.0f, factor = 30.0f, target = 1000.0f / 90.0f;
+        const int steps = 400, change[2] = { 100, 250 };
+
+        QualityController c;
+        c.SetParams(params);
+        float shadow = 8000.0f, applied = shadow;
+        Response r;
+        int lastSign = 0, lastOutside[2] = { change[0], change[1] };
+        for (int i = 0; i < steps; i++) {
+            // 7 ms base, +2.5 ms in the heavy scene; 0.8 ms per 1000 units of distance
+            float base = (i >= change[0] && i < change[1]) ? 9.5f : 7.0f;
+            float frameMs = base + applied * 0.0008f + noise(rng);
+            float error = frameMs - target;
+
+            int phase = i >= change[1] ? 1 : i >= change[0] ? 0 : -1;
+            if (phase >= 0) {
+                if (std::fabs(error) > 1.0f) lastOutside[phase] = i;
+                float past = phase == 0 ? -error : error;     // heavy scene undershoots, light overshoots
+                r.overshootMs[phase] = std::max(r.overshootMs[phase], past);
+            }
+            if (i >= change[0]) {
+                int sign = error > params.tolerance ? 1 : error < -params.tolerance ? -1 : 0;
+                if (sign && lastSign && sign != lastSign) r.oscillations++;
+                if (sign) lastSign = sign;
+                r.overMs += std::max(0.0f, error);
+                r.meanAbsMs += std::fabs(error) / (steps - change[0]);
+            }
+            if (verbose) printf("  %-4s %3d  %6.2f ms  shadow %5.0f\n", name, i, frameMs, shadow);
+
+            // The renderer picks up the new distance one adjustment later
+            applied = shadow;
+            c.Update(error);
+            shadow = c.Apply(shadow, factor, min, max);
+        }
+        r.settle[0] = lastOutside[0] - change[0] + 1;
+        r.settle[1] = lastOutside[1] - change[1] + 1;
+        return r;
+    }
+
+    void StepResponse(uint64_t seed, bool verbose)
+    {
+        struct Config
+        {
+            const char* name;
+            QualityController::Params params;
+        };
+        QualityController::Params fast = QualityController::Params::P(0.5f);
+        fast.ki = 4.0f;
+        const Config configs[] = {
+            { "P", QualityController::Params::P(0.5f) },
+            { "P x4", fast },
+            { "PID", QualityController::Params::PID(0.5f) },
+        };
+
+        printf("\nstep response (load +2.5 ms at 100, -2.5 ms at 250; fShadowFactor 30, 10 seeds):\n");
+        printf("  %-6s %14s %14s %14s %14s %8s %10s\n", "", "settle heavy", "settle light", "undershoot", "overshoot",
+               "osc", "over-ms");
+        for (const Config& cfg : configs) {
+            Response sum;
+            for (uint64_t s = 0; s < 10; s++) {
+                Response r = Run(cfg.params, seed + s, verbose && s == 0, cfg.name);
+                for (int k = 0; k < 2; k++) {
+                    sum.settle[k] += r.settle[k];
+                    sum.overshootMs[k] += r.overshootMs[k];
+                }
+                sum.oscillations += r.oscillations;
+                sum.overMs += r.overMs;
+            }
+            printf("  %-6s %10.1f adj %10.1f adj %11.2f ms %11.2f ms %8.1f %10.1f\n", cfg.name, sum.settle[0] / 10.0,
+                   sum.settle[1] / 10.0, sum.overshootMs[0] / 10.0, sum.overshootMs[1] / 10.0,
+                   sum.oscillations / 10.0, sum.overMs / 10.0);
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t seed = 1;
+    bool verbose = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--verbose")) verbose = true;
+        else {
+            fprintf(stderr, "usage: controller_check [--seed N] [--verbose]\n");
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    CheckOriginal(rng);
+    CheckLimits();
+    StepResponse(seed, verbose);
+
+    return Report();
+}
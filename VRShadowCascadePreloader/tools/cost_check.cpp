@@ -0,0 +1,252 @@
+// =============================================================================
+// cost_check - online knob cost estimation and cost-ordered allocation
+//
+//   cost_check [--seed N] [--bench]
+//
+// Feeds RlsEstimator synthetic adjustment windows whose frame time is a
+// known baseline plus known per-knob costs (ms over each knob's range), with
+// noise and loading hitches. Checks that:
+// - the estimates converge to the true costs
+// - they follow a scene change (shadows suddenly costing more)
+// - a long stretch with every knob pinned at max neither blows the fit up
+//   nor stops it from recovering
+// Then runs the governor closed loop with a heavy scene, once with the
+// per-knob factors and once with Allocation::CostModel. Both have to hold
+// the frame time at the target. The cost model must get there at a higher
+// mean knob position, by cutting the knobs that buy back the most frame time
+// per unit of range. --bench times Observe().
+// =============================================================================
+
+#include "check.h"
+#include "quality_governor.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    const char* const Names[KnobCount] = { "shadow", "lod objects", "lod items", "lod actors", "grass" };
+
+    // Mean frame time of one window: baseline + costs, noise, sometimes a hitch
+    struct Scene
+    {
+        float baseline = 6.0f;
+        float cost[KnobCount] = { 3.0f, 0.3f, 0.2f, 0.4f, 2.5f };
+        std::normal_distribution<float> noise{ 0.0f, 0.3f };
+        std::uniform_real_distribution<float> roll{ 0.0f, 1.0f };
+
+        float Window(std::mt19937_64& rng, const float* positions)
+        {
+            float ms = baseline + noise(rng);
+            for (size_t i = 0; i < KnobCount; i++) ms += cost[i] * positions[i];
+            if (roll(rng) < 0.01f) ms += 15.0f;
+            return ms;
+        }
+    };
+
+    float WorstError(const RlsEstimator& rls, const Scene& scene)
+    {
+        float worst = 0.0f;
+        for (size_t i = 0; i < KnobCount; i++) worst = std::max(worst, std::fabs(rls.Theta(i) - scene.cost[i]));
+        return worst;
+    }
+
+    void Wander(std::mt19937_64& rng, float* positions)
+    {
+        std::normal_distribution<float> step(0.0f, 0.15f);
+        for (size_t i = 0; i < KnobCount; i++) positions[i] = std::clamp(positions[i] + step(rng), 0.0f, 1.0f);
+    }
+
+    void CheckEstimator(std::mt19937_64& rng)
+    {
+        Scene scene;
+        RlsEstimator rls;
+        rls.Reset(KnobCount, RlsEstimator::Params{}, 11.1f);
+        float positions[KnobCount] = { 1, 1, 1, 1, 1 };
+
+        // With forgetting the estimate keeps some noise, so bias is judged on
+        // its mean over the second half and spread on the worst single error
+        int converged = -1;
+        double mean[KnobCount] = {};
+        float worst = 0.0f;
+        for (int i = 0; i < 2000; i++) {
+            Wander(rng, positions);
+            rls.Observe(positions, scene.Window(rng, positions));
+            if (converged < 0 && WorstError(rls, scene) < 0.3f) converged = i + 1;
+            if (i >= 1000) {
+                for (size_t k = 0; k < KnobCount; k++) mean[k] += rls.Theta(k) / 1000.0;
+                worst = std::max(worst, WorstError(rls, scene));
+            }
+        }
+        printf("estimates over windows 1000-2000 (true / mean estimate ms over the range):\n");
+        float meanError = 0.0f;
+        for (size_t i = 0; i < KnobCount; i++) {
+            printf("  %-12s %5.2f %6.2f\n", Names[i], scene.cost[i], mean[i]);
+            meanError = std::max(meanError, static_cast<float>(std::fabs(mean[i] - scene.cost[i])));
+        }
+        printf("  %-12s %5.2f %6.2f (last)\n", "baseline", scene.baseline, rls.Bias());
+        printf("  within 0.3 ms after %d windows, worst error since %.2f ms\n", converged, worst);
+        Check(converged > 0 && meanError < 0.15f, "estimates did not converge");
+        Check(worst < 1.0f, "estimates too noisy");
+
+        // Scene change: shadows get more expensive
+        scene.cost[0] = 5.0f;
+        int tracked = -1;
+        for (int i = 0; i < 1000; i++) {
+            Wander(rng, positions);
+            rls.Observe(positions, scene.Window(rng, positions));
+            if (tracked < 0 && std::fabs(rls.Theta(0) - scene.cost[0]) < 0.3f) tracked = i + 1;
+        }
+        printf("shadow cost 3.0 -> 5.0 ms: estimate %.2f, within 0.3 ms after %d windows\n", rls.Theta(0), tracked);
+        Check(tracked > 0, "estimate did not follow the scene change");
+
+        // Pinned: no excitation for 5000 windows, then wandering again
+        float pinned[KnobCount] = { 1, 1, 1, 1, 1 };
+        for (int i = 0; i < 5000; i++) rls.Observe(pinned, scene.Window(rng, pinned));
+        bool finite = true;
+        for (size_t i = 0; i < KnobCount; i++) finite &= std::isfinite(rls.Theta(i));
+        float pinnedError = WorstError(rls, scene);
+        int recovered = -1;
+        for (int i = 0; i < 1000; i++) {
+            Wander(rng, positions);
+            rls.Observe(positions, scene.Window(rng, positions));
+            if (recovered < 0 && WorstError(rls, scene) < 0.3f) recovered = i + 1;
+        }
+        printf("5000 windows pinned at max: worst error %.2f ms, within 0.3 ms %d windows after release\n", pinnedError,
+               recovered);
+        Check(finite && recovered > 0, "fit lost after a pinned stretch");
+    }
+
+    // ---- Closed loop ----
+    struct SimSettings final : SettingsBackend
+    {
+        float value[KnobCount] = {};
+        bool  Has(Knob) const override { return true; }
+        float Get(Knob knob) const override { return value[static_cast<size_t>(knob)]; }
+        void  Set(Knob knob, float v) override { value[static_cast<size_t>(knob)] = v; }
+        bool  HasBlockLevels() const override { return false; }
+        void  SetBlockLevel(int) override {}
+    };
+
+    struct LoopResult
+    {
+        float meanMs = 0.0f;
+        float quality = 0.0f;
+        float position[KnobCount] = {};
+        float costMs[KnobCount] = {};
+    };
+
+    LoopResult Loop(Allocation allocation, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<float> noise(0.0f, 0.5f);
+        Scene scene;
+        scene.baseline = 8.0f;      // at max: 8 + 6.4 = 14.4 ms against 11.1
+
+        GovernorConfig config;
+        config.autoAdjust = true;
+        config.allocation = allocation;
+        SimSettings s;
+        for (size_t i = 0; i < KnobCount; i++) s.value[i] = config.knobs[i].max;
+        QualityGovernor g;
+        g.Reset(config);
+
+        const int frames = 90 * 300, measureFrom = 90 * 150;
+        LoopResult r;
+        double sumMs = 0.0, sumPos[KnobCount] = {};
+        int measured = 0;
+        for (int f = 0; f < frames; f++) {
+            float ms = scene.baseline + noise(rng);
+            float positions[KnobCount];
+            for (size_t i = 0; i < KnobCount; i++) {
+                const KnobConfig& k = config.knobs[i];
+                positions[i] = (s.value[i] - k.min) / (k.max - k.min);
+                ms += scene.cost[i] * positions[i];
+            }
+            if (f >= measureFrom) {
+                sumMs += ms;
+                for (size_t i = 0; i < KnobCount; i++) sumPos[i] += positions[i];
+                measured++;
+            }
+            g.Frame(static_cast<uint32_t>(std::max(1.0f, ms) * 1000.0f), config, s);
+        }
+        r.meanMs = static_cast<float>(sumMs / measured);
+        for (size_t i = 0; i < KnobCount; i++) {
+            r.position[i] = static_cast<float>(sumPos[i] / measured);
+            r.quality += r.position[i] / KnobCount;
+            r.costMs[i] = g.Last().costMs[i];
+        }
+        return r;
+    }
+
+    void CheckAllocation(uint64_t seed)
+    {
+        LoopResult factors = Loop(Allocation::Factors, seed);
+        LoopResult cost = Loop(Allocation::CostModel, seed);
+        const float target = 1000.0f / 90.0f;
+
+        printf("\nclosed loop, heavy scene (%.2f ms target, last 150 s of 300):\n", target);
+        printf("  %-12s %6s %10s %10s %14s\n", "", "true", "factors", "cost model", "estimated cost");
+        Scene scene;
+        for (size_t i = 0; i < KnobCount; i++) {
+            printf("  %-12s %6.2f %10.2f %10.2f %14.2f\n", Names[i], scene.cost[i], factors.position[i],
+                   cost.position[i], cost.costMs[i]);
+        }
+        printf("  %-12s %6s %10.2f %10.2f\n", "quality", "", factors.quality, cost.quality);
+        printf("  %-12s %6s %7.2f ms %7.2f ms\n", "frame time", "", factors.meanMs, cost.meanMs);
+
+        Check(std::fabs(cost.meanMs - target) < 0.6f, "cost model does not hold the target");
+        Check(cost.quality > factors.quality + 0.05f, "cost model does not keep more quality than the factors");
+    }
+
+    void Bench()
+    {
+        std::mt19937_64 rng(7);
+        Scene scene;
+        RlsEstimator rls;
+        rls.Reset(KnobCount, RlsEstimator::Params{}, 11.1f);
+        const int n = 1000000;
+        static float positions[1024][KnobCount], ms[1024];
+        float p[KnobCount] = { 1, 1, 1, 1, 1 };
+        for (int i = 0; i < 1024; i++) {
+            Wander(rng, p);
+            memcpy(positions[i], p, sizeof(p));
+            ms[i] = scene.Window(rng, p);
+        }
+        auto t0 = Clock::now();
+        for (int i = 0; i < n; i++) rls.Observe(positions[i & 1023], ms[i & 1023]);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+        printf("\nObserve: %.1f ns per adjustment (%zu inputs + bias)\n", ns, rls.Inputs());
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t seed = 1;
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--bench")) bench = true;
+        else {
+            fprintf(stderr, "usage: cost_check [--seed N] [--bench]\n");
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    CheckEstimator(rng);
+    CheckAllocation(seed);
+    if (bench) Bench();
+
+    return Report();
+}
@@ -0,0 +1,362 @@
+// =============================================================================
+// decode_check - exercise the x86-64 length decoder and prologue relocation
+//
+//   decode_check [--listing FILE] [--bench] [--repeat N]
+//
+// Always runs
+//   - a corpus of the instructions the patches and site patterns depend on
+//     (count reads, shader ctor stores, the overwritten sites, MSVC prologue
+//     and VEX/EVEX forms) against their known lengths and RIP-relative flag
+//   - every Caves encoding, which must decode to its exact size
+//   - relocation: RIP-relative retargeting, rel8 widening and the rejected
+//     cases (out of rel32 range, branch into the moved range, loop/jrcxz)
+// --listing FILE cross-checks every instruction of an objdump listing made
+// with `objdump -d --insn-width=15 -M intel BINARY`; lines objdump itself
+// could not decode ((bad), .byte, lone prefixes) are skipped.
+// --bench sweeps the executable segments of this process and its libraries
+// and reports decode throughput. Game bytes cannot be shipped; run
+// resolve_sites on a dumped image to check the sites in place.
+// =============================================================================
+
+#include "cascade_caves.h"
+#include "cascade_sites.h"
+#include "check.h"
+#include "x64_decode.h"
+
+#ifdef __linux__
+#include <elf.h>
+#include <link.h>
+#endif
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+namespace
+{
+    std::vector<uint8_t> Bytes(const char* hex)
+    {
+        std::vector<uint8_t> out;
+        for (const char* p = hex; *p;) {
+            if (*p == ' ') {
+                p++;
+                continue;
+            }
+            out.push_back(static_cast<uint8_t>(strtoul(std::string(p, 2).c_str(), nullptr, 16)));
+            p += 2;
+        }
+        return out;
+    }
+
+    struct Case
+    {
+        const char* hex;
+        uint8_t     length;
+        bool        rip;
+    };
+
+    const Case Corpus[] = {
+        // Count reads of DAT_143924818 and the setup CMP
+        { "8B 05 10 32 54 76", 6, true },
+        { "44 8B 05 10 32 54 76", 7, true },
+        { "83 3D 10 32 54 76 02", 7, true },
+        // Shader ctor pieces
+        { "48 89 5C 24 08", 5, false },
+        { "BA 02 00 00 00", 5, false },
+        { "C7 83 D8 01 00 00 02 00 00 00", 10, false },
+        // Overwritten sites
+        { "49 8B AA 80 01 00 00", 7, false },
+        { "48 83 EC 68", 4, false },
+        { "4D 8B D1", 3, false },
+        { "4A 89 94 10 90 00 00 00", 8, false },
+        { "4D 85 F6", 3, false },
+        { "0F 84 8A 00 00 00", 6, false },
+        { "74 13", 2, false },
+        // MSVC prologue / epilogue
+        { "40 53", 2, false },
+        { "48 81 EC 80 00 00 00", 7, false },
+        { "48 8B 05 00 10 00 00", 7, true },
+        { "48 33 C4", 3, false },
+        { "48 89 84 24 70 00 00 00", 8, false },
+        { "0F 29 74 24 20", 5, false },
+        { "4C 8D 0D 00 10 00 00", 7, true },
+        { "E8 00 00 00 00", 5, false },
+        { "FF 15 00 10 00 00", 6, true },
+        { "FF 25 00 10 00 00", 6, true },
+        { "C3", 1, false },
+        { "C2 08 00", 3, false },
+        { "CC", 1, false },
+        { "66 0F 1F 44 00 00", 6, false },
+        { "0F 1F 84 00 00 00 00 00", 8, false },
+        { "66 2E 0F 1F 84 00 00 00 00 00", 10, false },
+        // Immediates that depend on prefixes and ModRM.reg
+        { "48 B8 01 02 03 04 05 06 07 08", 10, false },
+        { "66 B8 01 00", 4, false },
+        { "66 C7 05 00 10 00 00 01 00", 9, true },
+        { "F6 05 00 10 00 00 01", 7, true },
+        { "F6 D8", 2, false },
+        { "F7 C1 00 00 01 00", 6, false },
+        { "48 F7 D8", 3, false },
+        { "A1 00 00 00 00 00 00 00 00", 9, false },
+        { "67 A1 00 00 00 00", 6, false },
+        { "C8 10 00 00", 4, false },
+        { "67 8B 00", 3, false },
+        // SSE / VEX / EVEX
+        { "F3 0F 10 05 00 10 00 00", 8, true },
+        { "66 0F 3A 0F C1 08", 6, false },
+        { "66 0F 38 00 C1", 5, false },
+        { "0F C6 C1 1B", 4, false },
+        { "C5 F8 57 C0", 4, false },
+        { "C5 FA 10 05 00 10 00 00", 8, true },
+        { "C5 F8 77", 3, false },
+        { "C4 E3 79 04 C0 1B", 6, false },
+        { "C4 E2 79 18 05 00 10 00 00", 9, true },
+        { "C5 F9 70 C0 1B", 5, false },
+        { "62 F1 7C 48 10 05 00 10 00 00", 10, true },
+    };
+
+    void CheckCorpus()
+    {
+        for (const Case& c : Corpus) {
+            std::vector<uint8_t> code = Bytes(c.hex);
+            X64::Insn in = X64::DecodeOne(code.data(), code.size());
+            char detail[96];
+            snprintf(detail, sizeof(detail), "[%s] decoded %u bytes%s", c.hex, in.length,
+                     in.Has(X64::Insn::RipRelative) ? " rip" : "");
+            Check(code.size() == c.length, "corpus entry length", c.hex);
+            Check(in.length == c.length && in.Has(X64::Insn::RipRelative) == c.rip, "corpus", detail);
+            Check(X64::DecodeOne(code.data(), code.size() - 1).length == 0, "truncated input rejected", c.hex);
+        }
+        printf("corpus: %zu instructions\n", sizeof(Corpus) / sizeof(Corpus[0]));
+    }
+
+    void CheckCave(const char* name, const uint8_t* code, size_t size)
+    {
+        size_t off = 0;
+        while (off < size) {
+            X64::Insn in = X64::DecodeOne(code + off, size - off);
+            if (!in.length) break;
+            off += in.length;
+        }
+        Check(off == size, "cave decodes to its exact size", name);
+    }
+
+    void CheckCaves()
+    {
+        CheckCave("NullSafety", Caves::NullSafety.bytes, Caves::NullSafety.size);
+        CheckCave("NodeAlloc", Caves::NodeAlloc.bytes, Caves::NodeAlloc.size);
+        CheckCave("EntryZeroInit", Caves::EntryZeroInit.bytes, Caves::EntryZeroInit.size);
+        CheckCave("PtrValidation", Caves::PtrValidation.bytes, Caves::PtrValidation.size);
+    }
+
+    int32_t Rel32At(const uint8_t* p)
+    {
+        int32_t v;
+        memcpy(&v, p, 4);
+        return v;
+    }
+
+    void CheckRelocate()
+    {
+        constexpr uintptr_t Src = 0x140001000, Dst = 0x140801000;
+        uint8_t out[64];
+
+        // mov rax, [rip+0x10]: same absolute target from the new address
+        std::vector<uint8_t> mov = Bytes("48 8B 05 10 00 00 00");
+        size_t n = X64::Relocate(mov.data(), mov.size(), Src, out, sizeof(out), Dst);
+        Check(n == 7 && Dst + 7 + Rel32At(out + 3) == Src + 7 + 0x10, "RIP-relative retarget");
+
+        // cmp dword [rip+x], 2: displacement is relative to the end, after the imm8
+        std::vector<uint8_t> cmp = Bytes("83 3D 10 00 00 00 02");
+        n = X64::Relocate(cmp.data(), cmp.size(), Src, out, sizeof(out), Dst);
+        Check(n == 7 && Dst + 7 + Rel32At(out + 2) == Src + 7 + 0x10 && out[6] == 2, "RIP-relative with imm8");
+
+        // jz rel8 -> 0F 84 rel32, jmp rel8 -> E9 rel32
+        std::vector<uint8_t> jz = Bytes("74 10");
+        n = X64::Relocate(jz.data(), jz.size(), Src, out, sizeof(out), Dst);
+        Check(n == 6 && out[0] == 0x0F && out[1] == 0x84 && Dst + 6 + Rel32At(out + 2) == Src + 2 + 0x10,
+              "jcc rel8 widened");
+        std::vector<uint8_t> jmp = Bytes("EB F0");
+        n = X64::Relocate(jmp.data(), jmp.size(), Src, out, sizeof(out), Dst);
+        Check(n == 5 && out[0] == 0xE9 && Dst + 5 + Rel32At(out + 1) == Src + 2 - 0x10, "jmp rel8 widened");
+        Check(X64::RelocatedSize(2, 1) >= 6, "RelocatedSize covers widening");
+
+        // The node allocator prologue moves unchanged
+        n = X64::Relocate(Caves::NodeAllocSite.data, Caves::NodeAllocSite.length, Src, out, sizeof(out), Dst);
+        Check(n == Caves::NodeAllocSite.length && !memcmp(out, Caves::NodeAllocSite.data, n), "prologue copied");
+
+        // The hooks the node allocator fallback accepts in place of its prologue
+        std::vector<uint8_t> hook = Bytes("E9 00 10 00 00 90 90");
+        n = X64::Relocate(hook.data(), X64::CoverLength(hook.data(), hook.size(), 5), Src, out, sizeof(out), Dst);
+        Check(n == 5 && Dst + 5 + Rel32At(out + 1) == Src + 5 + 0x1000, "jmp rel32 hook moved");
+        std::vector<uint8_t> hookAbs = Bytes("FF 25 00 10 00 00 90");
+        n = X64::Relocate(hookAbs.data(), X64::CoverLength(hookAbs.data(), hookAbs.size(), 5), Src, out, sizeof(out), Dst);
+        Check(n == 6 && Dst + 6 + Rel32At(out + 2) == Src + 6 + 0x1000, "jmp [rip] hook moved");
+
+        // Rejected: too far, branch into the moved bytes, no rel32 form, no room
+        Check(X64::Relocate(mov.data(), mov.size(), Src, out, sizeof(out), Src + (1ull << 33)) == 0,
+              "out of rel32 range rejected");
+        std::vector<uint8_t> inner = Bytes("EB 01 90 90 90");
+        Check(X64::Relocate(inner.data(), inner.size(), Src, out, sizeof(out), Dst) == 0,
+              "branch into moved range rejected");
+        std::vector<uint8_t> loop = Bytes("E2 10");
+        Check(X64::Relocate(loop.data(), loop.size(), Src, out, sizeof(out), Dst) == 0, "loop rejected");
+        Check(X64::Relocate(jz.data(), jz.size(), Src, out, 5, Dst) == 0, "capacity respected");
+    }
+
+    void CheckLocate()
+    {
+        // sub rsp,0x68 / mov r10,r9 / mov edx,2 / ret
+        std::vector<uint8_t> fn = Bytes("48 83 EC 68 4D 8B D1 BA 02 00 00 00 C3");
+        Check(X64::Locate(fn.data(), fn.size(), 4, X64::Boundary::Start).ok, "Locate start");
+        Check(!X64::Locate(fn.data(), fn.size(), 6, X64::Boundary::Start).ok, "Locate mid-instruction");
+        Check(X64::Locate(fn.data(), fn.size(), 8, X64::Boundary::Imm).ok, "Locate immediate");
+        Check(X64::Locate(fn.data(), fn.size(), 3, X64::Boundary::Imm).ok, "Locate imm8 of sub");
+        Check(!X64::Locate(fn.data(), fn.size(), 6, X64::Boundary::Imm).ok, "Locate ModRM is not an immediate");
+    }
+
+    bool IsPrefixOnly(const char* mnemonic)
+    {
+        static const char* const Prefixes[] = {
+            "rex", "data16", "addr32", "lock", "rep", "repz", "repnz", "cs", "ds", "es", "fs", "gs", "ss",
+            "bnd", "notrack", "xacquire", "xrelease",
+        };
+        for (const char* p : Prefixes) {
+            size_t n = strlen(p);
+            if (!strncmp(mnemonic, p, n) && (mnemonic[n] == 0 || mnemonic[n] == '.' || mnemonic[n] == ' ' ||
+                                              mnemonic[n] == '\n')) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Lines look like "  4011d6:\t48 89 5c 24 08 \tmov    QWORD PTR [rsp+0x8],rbx"
+    int CheckListing(const char* path)
+    {
+        FILE* f = fopen(path, "r");
+        if (!f) {
+            fprintf(stderr, "cannot read %s\n", path);
+            return 1;
+        }
+        char line[512];
+        uint64_t checked = 0, skipped = 0, mismatched = 0;
+        while (fgets(line, sizeof(line), f)) {
+            char* colon = strchr(line, ':');
+            char* tab1 = strchr(line, '\t');
+            if (!colon || !tab1 || colon > tab1) continue;
+            char* tab2 = strchr(tab1 + 1, '\t');
+            if (!tab2) continue;
+
+            uint8_t code[16];
+            size_t length = 0;
+            for (char* p = tab1 + 1; p + 1 < tab2 && length < sizeof(code); p++) {
+                if (*p == ' ') continue;
+                code[length++] = static_cast<uint8_t>(strtoul(std::string(p, 2).c_str(), nullptr, 16));
+                p++;
+            }
+            const char* mnemonic = tab2 + 1;
+            if (!length || strstr(mnemonic, "(bad)") || !strncmp(mnemonic, ".byte", 5) || IsPrefixOnly(mnemonic)) {
+                skipped++;
+                continue;
+            }
+
+            checked++;
+            X64::Insn in = X64::DecodeOne(code, length);
+            if (in.length == length) continue;
+            if (mismatched++ < 20) {
+                printf("mismatch: decoded %u, objdump %zu:%.*s", in.length, length, (int)(strlen(line) - (tab1 - line)),
+                       tab1);
+            }
+        }
+        fclose(f);
+        printf("listing %s: %llu instructions checked, %llu skipped, %llu mismatched\n", path,
+               (unsigned long long)checked, (unsigned long long)skipped, (unsigned long long)mismatched);
+        Check(mismatched == 0, "listing cross-check", path);
+        return 0;
+    }
+
+#ifdef __linux__
+    struct Segment
+    {
+        const uint8_t* begin;
+        size_t         size;
+    };
+
+    int CollectSegment(dl_phdr_info* info, size_t, void* data)
+    {
+        auto* out = static_cast<std::vector<Segment>*>(data);
+        for (int i = 0; i < info->dlpi_phnum; i++) {
+            const ElfW(Phdr)& ph = info->dlpi_phdr[i];
+            if (ph.p_type != PT_LOAD || !(ph.p_flags & PF_X) || !(ph.p_flags & PF_R)) continue;
+            out->push_back({ reinterpret_cast<const uint8_t*>(info->dlpi_addr + ph.p_vaddr), ph.p_memsz });
+        }
+        return 0;
+    }
+
+    void Bench(int repeat)
+    {
+        std::vector<Segment> segments;
+        dl_iterate_phdr(CollectSegment, &segments);
+
+        uint64_t bytes = 0, instructions = 0, invalid = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeat; r++) {
+            for (const Segment& s : segments) {
+                // Linear sweep; padding and data in .text resynchronise a byte at a time
+                for (size_t off = 0; off < s.size;) {
+                    X64::Insn in = X64::DecodeOne(s.begin + off, s.size - off);
+                    if (in.length) {
+                        off += in.length;
+                        instructions++;
+                    } else {
+                        off++;
+                        invalid++;
+                    }
+                }
+                bytes += s.size;
+            }
+        }
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        printf("bench: %zu segments, %.1f MB x %d: %.0f MB/s, %.1f M instructions/s (%.2f%% invalid bytes)\n",
+               segments.size(), bytes / repeat / 1e6, repeat, bytes / sec / 1e6, instructions / sec / 1e6,
+               bytes ? 100.0 * invalid / bytes : 0.0);
+        printf("       a %u-byte site walk takes about %.1f us\n", (unsigned)Sites::MaxFunctionWalk,
+               Sites::MaxFunctionWalk / (bytes / sec) * 1e6);
+    }
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    const char* listing = nullptr;
+    bool bench = false;
+    int repeat = 5;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--listing") && i + 1 < argc) listing = argv[++i];
+        else if (!strcmp(argv[i], "--bench")) bench = true;
+        else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) repeat = atoi(argv[++i]);
+        else {
+            fprintf(stderr, "usage: decode_check [--listing FILE] [--bench] [--repeat N]\n");
+            return 2;
+        }
+    }
+
+    CheckCorpus();
+    CheckCaves();
+    CheckRelocate();
+    CheckLocate();
+    if (listing && CheckListing(listing)) return 1;
+#ifdef __linux__
+    if (bench) Bench(repeat > 0 ? repeat : 1);
+#else
+    if (bench) printf("--bench needs Linux (dl_iterate_phdr)\n");
+#endif
+    return Report();
+}
@@ -0,0 +1,278 @@
+// =============================================================================
+// detour_check - hook functions of this binary with the detour engine
+//
+//   detour_check [--iterations N]
+//
+// Hooks hand-written functions whose prologues cover what the engine has to
+// handle (a RIP-relative load, a short jcc widened to rel32, an MSVC-style
+// stack frame) plus a compiled six-argument function, through the same
+// CodeArena and Patch::Batch path as the preloader. Each hook is checked to
+// see every argument, to reach the original through the trampoline, and to
+// restore the original bytes on removal. Entries that must be refused
+// (shorter than the JMP, jrcxz, a branch back into the stolen bytes) are
+// checked to fail without writing anything. Then a hooked call is timed
+// against a direct one. Linux x86-64 only.
+// =============================================================================
+
+#include "check.h"
+#include "code_arena.h"
+#include "detour.h"
+#include "patch_engine.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+extern "C" char __executable_start[];
+extern "C" char _end[];
+
+extern "C" uint64_t dc_value;
+uint64_t dc_value = 0x1000;
+
+extern "C" uint64_t dc_rip(uint64_t a, uint64_t b);
+extern "C" uint64_t dc_jcc(uint64_t a, uint64_t b);
+extern "C" uint64_t dc_frame(uint64_t a, uint64_t b);
+extern "C" uint64_t dc_tiny(uint64_t a, uint64_t b);
+extern "C" uint64_t dc_jrcxz(uint64_t a, uint64_t b);
+extern "C" uint64_t dc_inner(uint64_t a, uint64_t b);
+
+asm(R"(
+    .intel_syntax noprefix
+    .text
+
+    .p2align 4
+    .globl dc_rip
+dc_rip:                                 # mov rax, [rip+dc_value] is the whole JMP
+    mov rax, qword ptr [rip + dc_value]
+    add rax, rdi
+    add rax, rsi
+    ret
+
+    .p2align 4
+    .globl dc_jcc
+dc_jcc:                                 # test + jz rel8: the jz moves and widens
+    test rdi, rdi
+    jz 1f
+    lea rax, [rdi + rsi]
+    ret
+1:  mov rax, -1
+    ret
+
+    .p2align 4
+    .globl dc_frame
+dc_frame:                               # sub rsp, 0x28 + mov
+    sub rsp, 0x28
+    mov rax, rdi
+    imul rax, rsi
+    add rsp, 0x28
+    ret
+
+    .p2align 4
+    .globl dc_tiny
+dc_tiny:                                # 3 bytes: refused
+    xor eax, eax
+    ret
+    int3
+    int3
+    int3
+
+    .p2align 4
+    .globl dc_jrcxz
+dc_jrcxz:                               # jrcxz has no rel32 form: refused
+    jrcxz 1f
+    mov rax, rdi
+    ret
+1:  xor eax, eax
+    ret
+
+    .p2align 4
+    .globl dc_inner
+dc_inner:                               # branches into its own first 5 bytes: refused
+    jnz 1f
+    nop
+1:  mov rax, rsi
+    ret
+
+    .att_syntax prefix
+)");
+
+namespace
+{
+    using Fn2 = uint64_t (*)(uint64_t, uint64_t);
+    using Fn6 = uint64_t (*)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+
+    CodeArena g_arena;
+
+    __attribute__((noinline)) uint64_t Mix6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f)
+    {
+        uint64_t h = 0xCBF29CE484222325ull;
+        for (uint64_t v : { a, b, c, d, e, f }) h = (h ^ v) * 0x100000001B3ull;
+        return h;
+    }
+
+    // Keeps calls indirect so the compiler cannot fold them
+    template <typename Fn>
+    Fn Opaque(Fn fn)
+    {
+        Fn volatile v = fn;
+        return v;
+    }
+
+    // ---- Detours: record what they saw, call the original, tag the result ----
+    Detour::Hook g_hook2, g_hook6;
+    uint64_t g_seen[6];
+    uint64_t g_calls = 0;
+
+    uint64_t Detour2(uint64_t a, uint64_t b)
+    {
+        g_calls++;
+        g_seen[0] = a;
+        g_seen[1] = b;
+        return g_hook2.Original<Fn2>()(a, b) + 1000000;
+    }
+
+    uint64_t Detour6(uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f)
+    {
+        g_calls++;
+        uint64_t in[] = { a, b, c, d, e, f };
+        memcpy(g_seen, in, sizeof(in));
+        return g_hook6.Original<Fn6>()(a, b, c, d, e, f) ^ 1;
+    }
+
+    bool Apply(const Detour::Hook& hook, bool install)
+    {
+        Patch::Batch batch;
+        Patch::Write* w = install ? Detour::QueueInstall(hook, batch, 0) : Detour::QueueRemove(hook, batch, 0);
+        if (!w) return false;
+        batch.Apply();
+        return batch[0].status == Patch::Status::Applied;
+    }
+
+    void CheckHook2(const char* name, Fn2 fn, const uint64_t (*cases)[2], size_t count)
+    {
+        uint64_t expect[8];
+        for (size_t i = 0; i < count; i++) expect[i] = Opaque(fn)(cases[i][0], cases[i][1]);
+
+        uint8_t before[Patch::MaxBytes];
+        memcpy(before, reinterpret_cast<const void*>(fn), sizeof(before));
+
+        if (!Detour::Prepare(g_hook2, name, reinterpret_cast<uintptr_t>(fn), reinterpret_cast<const void*>(&Detour2),
+                             g_arena)) {
+            Check(false, Detour::ErrorName(g_hook2.error), name);
+            return;
+        }
+        Check(Apply(g_hook2, true), "install", name);
+        printf("%-10s %u bytes (%u instructions) -> relay 0x%llX\n", name, g_hook2.length, g_hook2.instructions,
+               (unsigned long long)reinterpret_cast<uintptr_t>(g_hook2.relay));
+
+        for (size_t i = 0; i < count; i++) {
+            uint64_t calls = g_calls;
+            uint64_t got = Opaque(fn)(cases[i][0], cases[i][1]);
+            Check(g_calls == calls + 1, "detour called", name);
+            Check(g_seen[0] == cases[i][0] && g_seen[1] == cases[i][1], "detour arguments", name);
+            Check(got == expect[i] + 1000000, "original through the trampoline", name);
+            Check(g_hook2.Original<Fn2>()(cases[i][0], cases[i][1]) == expect[i], "trampoline alone", name);
+        }
+
+        Check(Apply(g_hook2, false), "remove", name);
+        Check(!memcmp(before, reinterpret_cast<const void*>(fn), sizeof(before)), "original bytes restored", name);
+        uint64_t calls = g_calls;
+        Check(Opaque(fn)(cases[0][0], cases[0][1]) == expect[0] && g_calls == calls, "unhooked call", name);
+    }
+
+    void CheckRefused(const char* name, Fn2 fn, Detour::Error expected)
+    {
+        uint8_t before[Patch::MaxBytes];
+        memcpy(before, reinterpret_cast<const void*>(fn), sizeof(before));
+        Detour::Hook hook;
+        bool ok = Detour::Prepare(hook, name, reinterpret_cast<uintptr_t>(fn), reinterpret_cast<const void*>(&Detour2),
+                                  g_arena);
+        Check(!ok && hook.error == expected, "refused with the right error", name);
+        Patch::Batch batch;
+        Check(!Detour::QueueInstall(hook, batch, 0), "nothing queued for a refused hook", name);
+        Check(!memcmp(before, reinterpret_cast<const void*>(fn), sizeof(before)), "refused entry untouched", name);
+        printf("%-10s refused: %s\n", name, Detour::ErrorName(hook.error));
+    }
+
+    void CheckCompiled()
+    {
+        Fn6 fn = &Mix6;
+        uint64_t expect = Opaque(fn)(1, 2, 3, 4, 5, 6);
+        if (!Detour::Prepare(g_hook6, "Mix6", reinterpret_cast<uintptr_t>(fn), reinterpret_cast<const void*>(&Detour6),
+                             g_arena)) {
+            Check(false, Detour::ErrorName(g_hook6.error), "Mix6");
+            return;
+        }
+        Check(Apply(g_hook6, true), "install", "Mix6");
+        printf("%-10s %u bytes (%u instructions)\n", "Mix6", g_hook6.length, g_hook6.instructions);
+        uint64_t got = Opaque(fn)(1, 2, 3, 4, 5, 6);
+        const uint64_t args[] = { 1, 2, 3, 4, 5, 6 };
+        Check(!memcmp(g_seen, args, sizeof(args)), "six arguments", "Mix6");
+        Check(got == (expect ^ 1), "original through the trampoline", "Mix6");
+        Check(Apply(g_hook6, false), "remove", "Mix6");
+        Check(Opaque(fn)(1, 2, 3, 4, 5, 6) == expect, "unhooked call", "Mix6");
+    }
+
+    // A detour that only forwards, like the scene node hook's common case
+    uint64_t Forward2(uint64_t a, uint64_t b) { return g_hook2.Original<Fn2>()(a, b); }
+
+    void Bench(uint64_t iterations)
+    {
+        auto time = [&](const char* label) {
+            Fn2 fn = Opaque<Fn2>(&dc_frame);
+            uint64_t sink = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t n = 0; n < iterations; n++) sink += fn(n, 3);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            printf("%-32s %6.2f ns/call (%llu)\n", label, ns / iterations, (unsigned long long)(sink & 1));
+        };
+
+        time("direct call");
+        if (!Detour::Prepare(g_hook2, "dc_frame", reinterpret_cast<uintptr_t>(&dc_frame),
+                             reinterpret_cast<const void*>(&Forward2), g_arena) ||
+            !Apply(g_hook2, true)) {
+            Check(false, "bench hook");
+            return;
+        }
+        time("hooked, forwarding detour");
+        Apply(g_hook2, false);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t iterations = 20000000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = strtoull(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: detour_check [--iterations N]\n");
+            return 2;
+        }
+    }
+
+    uintptr_t base = reinterpret_cast<uintptr_t>(__executable_start);
+    if (!g_arena.Init(base, reinterpret_cast<uintptr_t>(_end) - base)) {
+        fprintf(stderr, "cannot reserve a code arena near the executable\n");
+        return 1;
+    }
+
+    static const uint64_t ripCases[][2] = { { 1, 2 }, { 0, 0 }, { ~0ull, 5 } };
+    static const uint64_t jccCases[][2] = { { 0, 7 }, { 3, 4 }, { 100, ~0ull } };
+    static const uint64_t frameCases[][2] = { { 6, 7 }, { 0, 9 }, { 1ull << 40, 3 } };
+    CheckHook2("dc_rip", &dc_rip, ripCases, 3);
+    CheckHook2("dc_jcc", &dc_jcc, jccCases, 3);
+    CheckHook2("dc_frame", &dc_frame, frameCases, 3);
+    CheckCompiled();
+
+    CheckRefused("dc_tiny", &dc_tiny, Detour::Error::ShortFunction);
+    CheckRefused("dc_jrcxz", &dc_jrcxz, Detour::Error::Relocate);
+    CheckRefused("dc_inner", &dc_inner, Detour::Error::Relocate);
+
+    printf("arena %zu bytes used\n", g_arena.Used());
+    if (iterations && !failures) Bench(iterations);
+    return Report();
+}
@@ -0,0 +1,37 @@
+// =============================================================================
+// dump_caves - print the compile-time safety cave encodings
+//
+//   dump_caves
+//
+// Lists each cave's bytes and the rel32 fields Code::Link() fills in at
+// install time. Building this tool also evaluates the static_asserts in
+// cascade_caves.h that pin the caves to their hand-assembled originals.
+// =============================================================================
+
+#include "cascade_caves.h"
+
+#include <cstdio>
+
+using namespace CascadePatch;
+
+template <size_t Cap>
+static void Dump(const char* name, const X64::Code<Cap>& code)
+{
+    printf("%s: %zu bytes, %zu external jump(s)\n", name, code.size, code.fixupCount);
+    for (size_t i = 0; i < code.size; i++) {
+        printf("%s%02X", (i % 16) ? " " : "  ", code.bytes[i]);
+        if (i % 16 == 15 || i + 1 == code.size) printf("\n");
+    }
+    for (size_t i = 0; i < code.fixupCount; i++) {
+        printf("  rel32 @ +%u -> target %u\n", code.fixups[i].offset, code.fixups[i].slot);
+    }
+}
+
+int main()
+{
+    Dump("null safety", Caves::NullSafety);
+    Dump("node alloc", Caves::NodeAlloc);
+    Dump("entry zero-init", Caves::EntryZeroInit);
+    Dump("cascade ptr validation", Caves::PtrValidation);
+    return 0;
+}
@@ -0,0 +1,222 @@
+// =============================================================================
+// flight_decode - print a VRShadowCascade.flight recording
+//
+//   flight_decode <file.flight> [--json] [--out FILE]
+//   flight_decode --bench <file.flight> [--events N] [--threads N]
+//
+// Records are printed oldest first, one line each, with their arguments named
+// and formatted from cascade_events.h. --json writes the Chrome trace event
+// format instead (chrome://tracing, ui.perfetto.dev): every record becomes an
+// instant event on its thread, timestamps in microseconds since the recorder
+// was opened. Records that were being written when the process died are
+// skipped and counted. --bench fills a new recording from N threads through
+// FlightRecorder and reports the cost of Record(); decode the file afterwards
+// to check nothing was torn.
+// =============================================================================
+
+#include "cascade_events.h"
+#include "flight_recorder.h"
+#include "os_file.h"
+#include "os_time.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace CascadePatch;
+
+static int Usage()
+{
+    fprintf(stderr,
+        "usage: flight_decode <file.flight> [--json] [--out FILE]\n"
+        "       flight_decode --bench <file.flight> [--events N] [--threads N]\n");
+    return 2;
+}
+
+// One decoded record, copied out of the mapping
+struct Entry
+{
+    uint64_t seq;
+    uint64_t ticks;
+    uint16_t event;
+    uint32_t threadId;
+    uint64_t args[Flight::MaxArgs];
+};
+
+static void FormatArg(char* out, size_t size, Events::Arg kind, uint64_t value, bool json)
+{
+    const char* quote = json ? "\"" : "";
+    switch (kind) {
+    case Events::Arg::Hex:
+        snprintf(out, size, "%s0x%" PRIX64 "%s", quote, value, quote);
+        break;
+    case Events::Arg::Signed:
+        snprintf(out, size, "%d", static_cast<int32_t>(static_cast<uint32_t>(value)));
+        break;
+    case Events::Arg::Float:
+        snprintf(out, size, "%.3f", std::bit_cast<float>(static_cast<uint32_t>(value)));
+        break;
+    case Events::Arg::Bytes: {
+        int n = snprintf(out, size, "%s", quote);
+        for (int i = 0; i < 8; i++) {
+            n += snprintf(out + n, size - n, "%02X", static_cast<unsigned>((value >> (8 * i)) & 0xFF));
+        }
+        snprintf(out + n, size - n, "%s", quote);
+        break;
+    }
+    case Events::Arg::Eye:
+        snprintf(out, size, "%s%s%s", quote, value == 0 ? "L" : value == 1 ? "R" : "-", quote);
+        break;
+    case Events::Arg::Bool:
+        snprintf(out, size, "%s", value ? "true" : "false");
+        break;
+    default:
+        snprintf(out, size, "%" PRIu64, value);
+        break;
+    }
+}
+
+// Unknown ids (a newer preloader) still print their raw words
+static const Events::Descriptor& Describe(uint16_t id, Events::Descriptor& fallback)
+{
+    if (const Events::Descriptor* d = Events::Find(id)) return *d;
+    static char name[32];
+    snprintf(name, sizeof(name), "event_%u", id);
+    fallback = { id, name, "unknown",
+                 { { "a0", Events::Arg::Hex }, { "a1", Events::Arg::Hex }, { "a2", Events::Arg::Hex },
+                   { "a3", Events::Arg::Hex }, { "a4", Events::Arg::Hex } } };
+    return fallback;
+}
+
+static void WriteText(FILE* out, const Flight::FileHeader& header, const std::vector<Entry>& entries)
+{
+    for (const Entry& e : entries) {
+        double ms = double(e.ticks - header.info.startTicks) * 1000.0 / double(header.info.ticksPerSecond);
+        Events::Descriptor fallback;
+        const Events::Descriptor& d = Describe(e.event, fallback);
+        fprintf(out, "%12.3f ms  tid %-6u %-20s", ms, e.threadId, d.name);
+        for (size_t i = 0; i < Flight::MaxArgs && d.fields[i].name; i++) {
+            char value[64];
+            FormatArg(value, sizeof(value), d.fields[i].kind, e.args[i], false);
+            fprintf(out, " %s=%s", d.fields[i].name, value);
+        }
+        fputc('\n', out);
+    }
+}
+
+static void WriteJson(FILE* out, const Flight::FileHeader& header, const std::vector<Entry>& entries)
+{
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":0,"
+                 "\"args\":{\"name\":\"Fallout4VR (module 0x%" PRIX64 ")\"}}",
+            header.processId, header.info.moduleBase);
+    for (const Entry& e : entries) {
+        double us = double(e.ticks - header.info.startTicks) * 1e6 / double(header.info.ticksPerSecond);
+        Events::Descriptor fallback;
+        const Events::Descriptor& d = Describe(e.event, fallback);
+        fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":%u,\"tid\":%u,"
+                     "\"args\":{\"seq\":%" PRIu64,
+                d.name, d.category, us, header.processId, e.threadId, e.seq);
+        for (size_t i = 0; i < Flight::MaxArgs && d.fields[i].name; i++) {
+            char value[64];
+            FormatArg(value, sizeof(value), d.fields[i].kind, e.args[i], true);
+            fprintf(out, ",\"%s\":%s", d.fields[i].name, value);
+        }
+        fprintf(out, "}}");
+    }
+    fprintf(out, "\n]}\n");
+}
+
+static int Decode(const char* path, bool json, const char* outPath)
+{
+    OS::MappedFile file;
+    const char* error = nullptr;
+    const auto* header = static_cast<const Flight::FileHeader*>(RingFile::Open(file, path, Flight::Format, &error));
+    if (!header || header->info.ticksPerSecond == 0) {
+        fprintf(stderr, "%s: not a version %u flight recording (%s)\n", path, Flight::Version,
+                error ? error : "no tick rate");
+        return 1;
+    }
+
+    const auto* records = RingFile::Records<Flight::Record>(header);
+    uint64_t head = header->head.load(std::memory_order_acquire);
+
+    std::vector<Entry> entries;
+    entries.reserve(header->capacity);
+    RingFile::ForEach(records, header->capacity, head, [&](uint64_t ticket, const Flight::Record& r) {
+        Entry e{ ticket + 1, r.ticks, r.event, r.threadId, {} };
+        memcpy(e.args, r.args, sizeof(e.args));
+        entries.push_back(e);
+    });
+
+    uint64_t retained = std::min<uint64_t>(head, header->capacity);
+    fprintf(stderr, "%s: %" PRIu64 " events recorded, %zu decoded, %" PRIu64 " overwritten, %" PRIu64 " torn\n",
+            path, head, entries.size(), head - retained, retained - std::min<uint64_t>(retained, entries.size()));
+
+    FILE* out = outPath ? fopen(outPath, "w") : stdout;
+    if (!out) {
+        fprintf(stderr, "cannot write %s\n", outPath);
+        return 1;
+    }
+    if (json) WriteJson(out, *header, entries);
+    else WriteText(out, *header, entries);
+    if (out != stdout) fclose(out);
+    return 0;
+}
+
+static int Bench(const char* path, uint64_t events, int threads)
+{
+    FlightRecorder recorder;
+    if (!recorder.Open(path, FlightRecorder::DefaultCapacity, 0x140000000ull)) {
+        fprintf(stderr, "cannot create %s\n", path);
+        return 1;
+    }
+
+    uint64_t perThread = events / threads;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (int t = 0; t < threads; t++) {
+        workers.emplace_back([&recorder, perThread, t] {
+            for (uint64_t i = 0; i < perThread; i++) {
+                recorder.Record(Events::FlatEntry, i & 7, 0x1000 + i, 0x2000 + i, uint64_t(t));
+            }
+        });
+    }
+    for (std::thread& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t total = perThread * threads;
+    printf("%" PRIu64 " events from %d threads in %.1f ms: %.1f ns/event per thread, %.1fM events/s\n",
+           total, threads, seconds * 1e3, seconds * 1e9 * threads / double(total), double(total) / seconds / 1e6);
+    recorder.Close();
+    return 0;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) return Usage();
+
+    const char* path = nullptr;
+    const char* outPath = nullptr;
+    bool json = false, bench = false;
+    uint64_t events = 10000000;
+    int threads = 1;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--json")) json = true;
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) outPath = argv[++i];
+        else if (!strcmp(argv[i], "--bench")) bench = true;
+        else if (!strcmp(argv[i], "--events") && i + 1 < argc) events = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (argv[i][0] == '-') return Usage();
+        else path = argv[i];
+    }
+    if (!path || threads < 1) return Usage();
+
+    return bench ? Bench(path, events, threads) : Decode(path, json, outPath);
+}
@@ -0,0 +1,491 @@
+// =============================================================================
+// governor_sim - headless ShadowBoost tuning on frame-time traces
+//
+//   governor_sim [--trace FILE] [--seconds N] [--seed N] [--threads N]
+//                [--top N] [--csv FILE] [--quality-weight W]
+//                [--cost-shadow MS] [--cost-lod MS] [--cost-grass MS]
+//
+// Runs QualityGovernor, the decision logic of ShadowBoost::update, against a
+// cost model instead of the game. A frame takes the scene load plus
+// cost-shadow ms per unit of shadow distance, cost-lod per unit of each LOD
+// fade multiplier and cost-grass per unit of grass distance. Settings written
+// by an adjustment apply from the next frame.
+//
+// Without --trace the scene is synthetic: a light scene, a heavy one
+// (+3.5 ms) from 30% to 60% of the run, light again, with noise and rare
+// hitches. A --trace file has one frame time in ms per line (first field of
+// CSV rows, '#' lines skipped). The knob cost is subtracted to get the scene
+// load: the knob values of telemetry_export's columns, or the max settings
+// for a plain list. Every config sees the same frames. A trace is one phase from its first frame; the synthetic scene
+// has three.
+//
+// First checks that the governor with the P controller and the average
+// metric reproduces the update loop it was split from, bit for bit. Then it
+// sweeps fShadowFactor, fLodFactor, fGrassFactor, fFpsDelay, fMsTolerance,
+// iController and iFrameTimeMetric. Per config it reports, on 0.5 s samples
+// of the mean knob position (quality: 0 = every knob at min, 1 = at max):
+//   settle  seconds after each load change until quality stays within 0.05
+//           of where it ends up (its mean over the last quarter of the phase)
+//   over    worst excursion of quality past that end value, % of the range
+//   osc     direction reversals of quality larger than 0.02
+//   budget  share of frames over the target
+//   quality mean over the run
+// Configs are ranked by budget% + 10 x W x (1 - quality), W = 1 by default.
+// =============================================================================
+
+#include "check.h"
+#include "quality_governor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    // ---- Settings backend: plain floats ----
+    struct SimSettings final : SettingsBackend
+    {
+        float value[KnobCount] = {};
+        int   block = 0;
+        bool  hasBlocks = true;
+
+        bool  Has(Knob) const override { return true; }
+        float Get(Knob knob) const override { return value[static_cast<size_t>(knob)]; }
+        void  Set(Knob knob, float v) override { value[static_cast<size_t>(knob)] = v; }
+        bool  HasBlockLevels() const override { return hasBlocks; }
+        void  SetBlockLevel(int index) override { block = index; }
+    };
+
+    // ---- The update loop before the split (average metric, P step) ----
+    struct Original
+    {
+        float frameCount = 0.0f;
+        uint64_t sumUs = 0;
+        int blockIndex = 0;
+
+        void Frame(uint32_t us, const GovernorConfig& c, float* v, int& block)
+        {
+            sumUs += us;
+            frameCount += 1.0f;
+            if (frameCount < c.fpsDelay) return;
+            frameCount = 0.0f;
+
+            float dyn = 0.0f;
+            float avgMs = static_cast<float>(sumUs) / 1000.0f / c.fpsDelay;
+            sumUs = 0;
+            float targetMs = 1000.0f / c.fpsTarget;
+            if (c.autoAdjust) {
+                dyn = avgMs - targetMs;
+                if (dyn >= 0.0f && dyn <= c.msTolerance) dyn = 0.0f;
+            }
+            for (size_t i = 0; i < KnobCount; i++) {
+                const KnobConfig& k = c.knobs[i];
+                v[i] = c.autoAdjust && k.enabled ? std::clamp(v[i] - dyn * k.factor, k.min, k.max) : k.max;
+            }
+            if (c.autoAdjust && c.blockEnable) {
+                const KnobConfig& s = c.Of(Knob::ShadowDistance);
+                float shadowDist = v[static_cast<size_t>(Knob::ShadowDistance)];
+                if (shadowDist <= s.min && dyn > 0.0f) blockIndex = std::clamp(blockIndex + 1, 0, c.blockLevels - 1);
+                if (shadowDist >= s.max && dyn <= 0.0f) blockIndex = std::clamp(blockIndex - 1, 0, c.blockLevels - 1);
+                block = blockIndex;
+            }
+        }
+    };
+
+    void CheckOriginal(std::mt19937_64& rng)
+    {
+        std::uniform_real_distribution<float> frameMs(5.0f, 30.0f), factor(0.05f, 100.0f), tol(0.0f, 2.0f);
+        std::uniform_int_distribution<int> delay(1, 30), coin(0, 3);
+        int mismatches = 0, adjustments = 0;
+        for (int run = 0; run < 200; run++) {
+            GovernorConfig c;
+            c.autoAdjust = coin(rng) != 0;
+            c.fpsDelay = static_cast<float>(delay(rng));
+            c.msTolerance = tol(rng);
+            c.blockEnable = coin(rng) != 0;
+            for (KnobConfig& k : c.knobs) {
+                k.enabled = coin(rng) != 0;
+                k.factor = factor(rng);
+            }
+
+            SimSettings s;
+            float ref[KnobCount];
+            int refBlock = 0;
+            for (size_t i = 0; i < KnobCount; i++) s.value[i] = ref[i] = c.knobs[i].max;
+            QualityGovernor g;
+            g.Reset(c);
+            Original o;
+            for (int i = 0; i < 3000; i++) {
+                uint32_t us = static_cast<uint32_t>(frameMs(rng) * 1000.0f);
+                o.Frame(us, c, ref, refBlock);
+                if (!g.Frame(us, c, s)) continue;
+                adjustments++;
+                if (memcmp(ref, s.value, sizeof(ref)) != 0 || refBlock != s.block) mismatches++;
+            }
+        }
+        Check(mismatches == 0, "governor differs from the original update");
+        printf("original update: %d adjustments, %d differ\n", adjustments, mismatches);
+    }
+
+    // ---- Scene and cost model ----
+    struct CostModel
+    {
+        float shadow = 0.0005f;     // ms per unit of shadow distance
+        float lod = 0.05f;          // ms per unit of each LOD fade multiplier
+        float grass = 0.0002f;      // ms per unit of grass distance
+
+        float Ms(const float* v) const
+        {
+            return shadow * v[static_cast<size_t>(Knob::ShadowDistance)] +
+                   lod * (v[static_cast<size_t>(Knob::LodObjects)] + v[static_cast<size_t>(Knob::LodItems)] +
+                          v[static_cast<size_t>(Knob::LodActors)]) +
+                   grass * v[static_cast<size_t>(Knob::GrassDistance)];
+        }
+    };
+
+    struct Scene
+    {
+        std::vector<float>  loadMs;     // frame time without the knobs
+        std::vector<size_t> changes;    // frames where the load steps
+    };
+
+    Scene Synthetic(std::mt19937_64& rng, double seconds, float fps)
+    {
+        Scene scene;
+        size_t frames = static_cast<size_t>(seconds * fps);
+        scene.changes = { 0, frames * 3 / 10, frames * 6 / 10 };
+        std::normal_distribution<float> noise(0.0f, 0.35f);
+        std::uniform_real_distribution<float> roll(0.0f, 1.0f), hitch(20.0f, 35.0f);
+        scene.loadMs.resize(frames);
+        for (size_t i = 0; i < frames; i++) {
+            float base = (i >= scene.changes[1] && i < scene.changes[2]) ? 8.5f : 5.0f;
+            scene.loadMs[i] = roll(rng) < 0.003f ? hitch(rng) : std::max(1.0f, base + noise(rng));
+        }
+        return scene;
+    }
+
+    // Splits a CSV line in place; returns the number of fields
+    size_t Fields(char* line, char** fields, size_t max)
+    {
+        size_t n = 0;
+        for (char* p = line; n < max;) {
+            fields[n++] = p;
+            p = strchr(p, ',');
+            if (!p) break;
+            *p++ = '\0';
+        }
+        return n;
+    }
+
+    bool LoadTrace(const char* path, const CostModel& cost, const GovernorConfig& defaults, Scene& scene)
+    {
+        FILE* f = fopen(path, "r");
+        if (!f) return false;
+
+        // Knobs at their max unless the trace says otherwise
+        float knobs[KnobCount];
+        for (size_t i = 0; i < KnobCount; i++) knobs[i] = defaults.knobs[i].max;
+
+        // telemetry_export columns: the knobs a frame ran with are the ones
+        // recorded on the frame before it
+        static const char* const knobColumns[KnobCount] = { "shadow", "lod_objects", "lod_items", "lod_actors", "grass" };
+        int column[KnobCount] = { -1, -1, -1, -1, -1 };
+        char line[512];
+        char* fields[32];
+        while (fgets(line, sizeof(line), f)) {
+            if (line[0] == '#') continue;
+            line[strcspn(line, "\r\n")] = '\0';
+            size_t n = Fields(line, fields, 32);
+            char* end = nullptr;
+            float ms = strtof(fields[0], &end);
+            if (end == fields[0]) {
+                // Header row
+                for (size_t k = 0; k < KnobCount; k++)
+                    for (size_t c = 0; c < n; c++)
+                        if (!strcmp(fields[c], knobColumns[k])) column[k] = static_cast<int>(c);
+                continue;
+            }
+            scene.loadMs.push_back(std::max(0.5f, ms - cost.Ms(knobs)));
+            for (size_t k = 0; k < KnobCount; k++) {
+                // 0 before the first adjustment: the game's own value, unknown
+                float v = column[k] >= 0 && static_cast<size_t>(column[k]) < n ? strtof(fields[column[k]], nullptr) : 0.0f;
+                if (v > 0.0f) knobs[k] = v;
+            }
+        }
+        fclose(f);
+        scene.changes = { 0 };
+        return !scene.loadMs.empty();
+    }
+
+    // ---- One simulated run ----
+    struct Result
+    {
+        float settleSec = 0.0f;     // mean over load changes
+        float overshootPct = 0.0f;  // worst over load changes
+        int   oscillations = 0;
+        float budgetPct = 0.0f;     // frames over the target
+        float quality = 0.0f;
+        float score = 0.0f;
+    };
+
+    constexpr size_t WindowFrames = 45; // 0.5 s at 90 fps
+    constexpr float  SettleBand = 0.05f;
+    constexpr float  ReversalBand = 0.02f;
+
+    // Mean position of the enabled knobs in [min, max]
+    float Quality(const GovernorConfig& c, const SimSettings& s)
+    {
+        float q = 0.0f;
+        int enabled = 0;
+        for (size_t k = 0; k < KnobCount; k++) {
+            const KnobConfig& kc = c.knobs[k];
+            if (!kc.enabled || kc.max <= kc.min) continue;
+            q += (s.value[k] - kc.min) / (kc.max - kc.min);
+            enabled++;
+        }
+        return enabled ? q / enabled : 1.0f;
+    }
+
+    Result Run(const Scene& scene, const CostModel& cost, const GovernorConfig& c, float qualityWeight)
+    {
+        SimSettings s;
+        for (size_t i = 0; i < KnobCount; i++) s.value[i] = c.knobs[i].max;
+        QualityGovernor g;
+        g.Reset(c);
+
+        // Knob position once per window
+        const float targetMs = 1000.0f / c.fpsTarget;
+        const size_t frames = scene.loadMs.size();
+        float samples[1 << 12];
+        const size_t maxSamples = sizeof(samples) / sizeof(samples[0]);
+        size_t count = 0, over = 0;
+        for (size_t i = 0; i < frames; i++) {
+            float frameMs = scene.loadMs[i] + cost.Ms(s.value);
+            if (frameMs > targetMs) over++;
+            if (i % WindowFrames == 0 && count < maxSamples) samples[count++] = Quality(c, s);
+            g.Frame(static_cast<uint32_t>(frameMs * 1000.0f), c, s);
+        }
+
+        Result r;
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++) sum += samples[i];
+        r.quality = count ? static_cast<float>(sum / count) : 1.0f;
+        r.budgetPct = 100.0f * over / frames;
+
+        // Step response of the knobs after each load change: the settled
+        // position is the mean over the last quarter of the phase
+        double settleSum = 0.0;
+        for (size_t p = 0; p < scene.changes.size(); p++) {
+            size_t first = scene.changes[p] / WindowFrames;
+            size_t last = std::min(count, (p + 1 < scene.changes.size() ? scene.changes[p + 1] : frames) / WindowFrames);
+            if (last <= first + 4) continue;
+            size_t tail = first + (last - first) * 3 / 4;
+            double settled = 0.0;
+            for (size_t i = tail; i < last; i++) settled += samples[i];
+            float final = static_cast<float>(settled / (last - tail));
+
+            size_t settleAt = first;
+            float direction = final >= samples[first] ? 1.0f : -1.0f;
+            for (size_t i = first; i < last; i++) {
+                if (std::fabs(samples[i] - final) > SettleBand) settleAt = i + 1;
+                r.overshootPct = std::max(r.overshootPct, 100.0f * direction * (samples[i] - final));
+            }
+            settleSum += static_cast<double>((settleAt - first) * WindowFrames) / c.fpsTarget;
+        }
+        r.settleSec = static_cast<float>(settleSum / scene.changes.size());
+
+        // Direction reversals bigger than ReversalBand
+        int direction = 0;
+        float extreme = count ? samples[0] : 0.0f;
+        for (size_t i = 1; i < count; i++) {
+            float q = samples[i];
+            if (direction >= 0 && q > extreme) extreme = q;
+            else if (direction <= 0 && q < extreme) extreme = q;
+            if (direction >= 0 && q < extreme - ReversalBand) {
+                if (direction > 0) r.oscillations++;
+                direction = -1;
+                extreme = q;
+            } else if (direction <= 0 && q > extreme + ReversalBand) {
+                if (direction < 0) r.oscillations++;
+                direction = 1;
+                extreme = q;
+            }
+        }
+
+        r.score = r.budgetPct + qualityWeight * (1.0f - r.quality) * 10.0f;
+        return r;
+    }
+
+    // ---- Sweep ----
+    struct Entry
+    {
+        GovernorConfig config;
+        Result result;
+    };
+
+    std::vector<GovernorConfig> Sweep(const GovernorConfig& base)
+    {
+        const float shadowFactors[] = { 10.0f, 30.0f, 60.0f, 120.0f };
+        const float lodFactors[] = { 0.05f, 0.1f, 0.2f };
+        const float grassFactors[] = { 10.0f, 30.0f, 60.0f };
+        const float delays[] = { 5.0f, 10.0f, 20.0f, 45.0f };
+        const float tolerances[] = { 0.0f, 0.5f, 1.0f };
+        const ControllerMode controllers[] = { ControllerMode::P, ControllerMode::PID };
+        const FrameMetric metrics[] = { FrameMetric::Average, FrameMetric::P95, FrameMetric::P99 };
+
+        std::vector<GovernorConfig> configs;
+        for (float sf : shadowFactors)
+            for (float lf : lodFactors)
+                for (float gf : grassFactors)
+                    for (float delay : delays)
+                        for (float tol : tolerances)
+                            for (ControllerMode mode : controllers)
+                                for (FrameMetric metric : metrics) {
+                                    GovernorConfig c = base;
+                                    c.Of(Knob::ShadowDistance).factor = sf;
+                                    c.Of(Knob::LodObjects).factor = lf;
+                                    c.Of(Knob::LodItems).factor = lf;
+                                    c.Of(Knob::LodActors).factor = lf;
+                                    c.Of(Knob::GrassDistance).factor = gf;
+                                    c.fpsDelay = delay;
+                                    c.msTolerance = tol;
+                                    c.controller = mode;
+                                    c.metric = metric;
+                                    configs.push_back(c);
+                                }
+        return configs;
+    }
+
+    const char* MetricName(FrameMetric m)
+    {
+        return m == FrameMetric::P95 ? "p95" : m == FrameMetric::P99 ? "p99" : "avg";
+    }
+
+    void PrintHeader()
+    {
+        printf("  %6s %5s %6s %5s %4s %4s %4s | %8s %8s %5s %8s %7s %7s\n", "shadow", "lod", "grass", "delay", "tol",
+               "ctl", "fps", "settle", "over", "osc", "budget", "quality", "score");
+    }
+
+    void PrintRow(const Entry& e)
+    {
+        const GovernorConfig& c = e.config;
+        const Result& r = e.result;
+        printf("  %6.0f %5.2f %6.0f %5.0f %4.1f %4s %4s | %6.2f s %6.1f%% %5d %7.2f%% %7.3f %7.2f\n",
+               c.Of(Knob::ShadowDistance).factor, c.Of(Knob::LodObjects).factor, c.Of(Knob::GrassDistance).factor,
+               c.fpsDelay, c.msTolerance, c.controller == ControllerMode::PID ? "PID" : "P", MetricName(c.metric),
+               r.settleSec, r.overshootPct, r.oscillations, r.budgetPct, r.quality, r.score);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* trace = nullptr;
+    const char* csv = nullptr;
+    double seconds = 120.0;
+    uint64_t seed = 1;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    size_t top = 10;
+    float qualityWeight = 1.0f;
+    CostModel cost;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--trace") && i + 1 < argc) trace = argv[++i];
+        else if (!strcmp(argv[i], "--csv") && i + 1 < argc) csv = argv[++i];
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--top") && i + 1 < argc) top = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--quality-weight") && i + 1 < argc) qualityWeight = static_cast<float>(atof(argv[++i]));
+        else if (!strcmp(argv[i], "--cost-shadow") && i + 1 < argc) cost.shadow = static_cast<float>(atof(argv[++i]));
+        else if (!strcmp(argv[i], "--cost-lod") && i + 1 < argc) cost.lod = static_cast<float>(atof(argv[++i]));
+        else if (!strcmp(argv[i], "--cost-grass") && i + 1 < argc) cost.grass = static_cast<float>(atof(argv[++i]));
+        else {
+            fprintf(stderr, "usage: governor_sim [--trace FILE] [--seconds N] [--seed N] [--threads N] [--top N]\n"
+                            "                    [--csv FILE] [--quality-weight W]\n"
+                            "                    [--cost-shadow MS] [--cost-lod MS] [--cost-grass MS]\n");
+            return 2;
+        }
+    }
+
+    std::mt19937_64 rng(seed);
+    CheckOriginal(rng);
+
+    // Plugin defaults with auto-adjust on
+    GovernorConfig base;
+    base.autoAdjust = true;
+
+    Scene scene;
+    if (trace) {
+        if (!LoadTrace(trace, cost, base, scene)) {
+            fprintf(stderr, "cannot read frame times from %s\n", trace);
+            return 1;
+        }
+        printf("\ntrace %s: %zu frames\n", trace, scene.loadMs.size());
+    } else {
+        scene = Synthetic(rng, seconds, base.fpsTarget);
+        printf("\nsynthetic scene: %zu frames, +3.5 ms from frame %zu to %zu\n", scene.loadMs.size(), scene.changes[1],
+               scene.changes[2]);
+    }
+
+    std::vector<GovernorConfig> configs = Sweep(base);
+    std::vector<Entry> entries(configs.size());
+    std::atomic<size_t> next{ 0 };
+    auto t0 = Clock::now();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back([&] {
+            for (size_t i; (i = next.fetch_add(1)) < configs.size();) {
+                entries[i] = { configs[i], Run(scene, cost, configs[i], qualityWeight) };
+            }
+        });
+    }
+    for (std::thread& w : workers) w.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - t0).count();
+
+    Entry defaults{ base, Run(scene, cost, base, qualityWeight) };
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.result.score < b.result.score; });
+
+    printf("%zu configs x %zu frames in %.2f s on %u threads: %.0f configs/s, %.1f M frames/s\n\n", configs.size(),
+           scene.loadMs.size(), elapsed, threads, configs.size() / elapsed,
+           configs.size() * scene.loadMs.size() / elapsed / 1e6);
+    PrintHeader();
+    printf("  defaults:\n");
+    PrintRow(defaults);
+    printf("  best %zu:\n", std::min(top, entries.size()));
+    for (size_t i = 0; i < top && i < entries.size(); i++) PrintRow(entries[i]);
+
+    if (csv) {
+        FILE* f = fopen(csv, "w");
+        if (!f) {
+            fprintf(stderr, "cannot write %s\n", csv);
+            return 1;
+        }
+        fprintf(f, "fShadowFactor,fLodFactor,fGrassFactor,fFpsDelay,fMsTolerance,iController,iFrameTimeMetric,"
+                   "settle_s,overshoot_pct,oscillations,over_budget_pct,quality,score\n");
+        for (const Entry& e : entries) {
+            const GovernorConfig& c = e.config;
+            const Result& r = e.result;
+            fprintf(f, "%g,%g,%g,%g,%g,%d,%d,%.3f,%.3f,%d,%.3f,%.4f,%.3f\n", c.Of(Knob::ShadowDistance).factor,
+                    c.Of(Knob::LodObjects).factor, c.Of(Knob::GrassDistance).factor, c.fpsDelay, c.msTolerance,
+                    static_cast<int>(c.controller), static_cast<int>(c.metric), r.settleSec, r.overshootPct,
+                    r.oscillations, r.budgetPct, r.quality, r.score);
+        }
+        fclose(f);
+        printf("\n%zu rows written to %s\n", entries.size(), csv);
+    }
+
+    return Report();
+}
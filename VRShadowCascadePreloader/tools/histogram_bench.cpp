@@ -0,0 +1,196 @@
+// =============================================================================
+// histogram_bench - frame-time histogram accuracy and cost
+//
+//   histogram_bench [--frames N] [--window N] [--hitch-rate R] [--seed N]
+//
+// Generates a VR-like frame-time trace (11.1 ms frames with jitter and a
+// share of 25-40 ms hitches). It checks every bucket boundary, then compares
+// FrameHistogram percentiles with exact ones from a sorted copy. The
+// reported value must never be below the true one and may be at most one
+// bucket above it. It also shows what the average over fFpsDelay frames
+// hides. Record() is timed per frame, Query() per controller adjustment,
+// and both are compared with keeping a ring of raw frame times and
+// sorting it for each query.
+// =============================================================================
+
+#include "check.h"
+#include "frame_histogram.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    void Check(bool ok, const char* what, uint32_t value)
+    {
+        if (!ok) Fail("%s (%u)", what, value);
+    }
+
+    void CheckBuckets()
+    {
+        size_t previous = 0;
+        for (uint32_t us = 0; us <= FrameHistogram::MaxUs; us++) {
+            size_t index = FrameHistogram::Index(us);
+            Check(index < FrameHistogram::Buckets, "index out of range", us);
+            Check(index == previous || index == previous + 1, "indices not contiguous", us);
+            Check(FrameHistogram::Lowest(index) <= us && us <= FrameHistogram::Highest(index), "value outside its bucket", us);
+            // Bucket width at most 1/64 of its lowest value above the linear range
+            uint32_t width = FrameHistogram::Highest(index) - FrameHistogram::Lowest(index) + 1;
+            Check(us < 128 || width * 64 <= FrameHistogram::Lowest(index), "bucket too wide", us);
+            previous = index;
+        }
+        printf("buckets: %zu (%zu bytes per histogram), every value 0-%u in range and contiguous\n",
+               FrameHistogram::Buckets, sizeof(FrameHistogram), FrameHistogram::MaxUs);
+    }
+
+    std::vector<uint32_t> Trace(std::mt19937_64& rng, size_t frames, double hitchRate)
+    {
+        std::normal_distribution<double> frame(11111.0, 600.0);
+        std::uniform_real_distribution<double> hitch(25000.0, 40000.0);
+        std::uniform_real_distribution<double> roll(0.0, 1.0);
+        std::vector<uint32_t> us(frames);
+        for (uint32_t& v : us) {
+            double t = roll(rng) < hitchRate ? hitch(rng) : frame(rng);
+            v = static_cast<uint32_t>(std::max(1000.0, t));
+        }
+        return us;
+    }
+
+    uint32_t Exact(std::vector<uint32_t> sorted, double p)
+    {
+        std::sort(sorted.begin(), sorted.end());
+        size_t rank = static_cast<size_t>(std::max(1.0, std::ceil(p / 100.0 * sorted.size())));
+        return sorted[rank - 1];
+    }
+
+    void CheckAccuracy(const std::vector<uint32_t>& trace, uint32_t window, float fpsDelay)
+    {
+        // The last window..2*window frames, as FrameTimeWindow sees them
+        FrameTimeWindow w;
+        w.SetWindow(window);
+        for (uint32_t us : trace) w.Record(us);
+        FrameTimeStats s = w.Query();
+        std::vector<uint32_t> tail(trace.end() - s.frames, trace.end());
+
+        printf("\nlast %u frames (window %u):\n", s.frames, window);
+        printf("  %-6s %10s %10s %8s\n", "", "histogram", "exact", "error");
+        const double ranks[] = { 50.0, 95.0, 99.0 };
+        const float reported[] = { s.p50Ms, s.p95Ms, s.p99Ms };
+        for (int i = 0; i < 3; i++) {
+            uint32_t exact = Exact(tail, ranks[i]);
+            uint32_t got = static_cast<uint32_t>(reported[i] * 1000.0f + 0.5f);
+            printf("  p%-5.0f %8.2f ms %7.2f ms %+7.2f%%\n", ranks[i], reported[i], exact / 1000.0,
+                   (got - static_cast<double>(exact)) * 100.0 / exact);
+            size_t bucket = FrameHistogram::Index(exact);
+            Check(got >= exact && got <= FrameHistogram::Highest(bucket), "percentile outside the exact value's bucket", exact);
+        }
+
+        // What the controller saw before: the mean of each fFpsDelay-frame block
+        size_t block = static_cast<size_t>(fpsDelay);
+        double worstBlock = 0.0;
+        for (size_t i = 0; i + block <= tail.size(); i += block) {
+            double sum = 0.0;
+            for (size_t j = 0; j < block; j++) sum += tail[i + j];
+            worstBlock = std::max(worstBlock, sum / block);
+        }
+        printf("  mean %.2f ms, max %.2f ms; worst %zu-frame average %.2f ms\n", s.meanMs, s.maxMs, block,
+               worstBlock / 1000.0);
+    }
+
+    volatile uint64_t sink;
+
+    template <typename Fn>
+    double NsPer(size_t count, Fn&& fn)
+    {
+        double best = 1e30;
+        for (int batch = 0; batch < 5; batch++) {
+            auto t0 = Clock::now();
+            fn();
+            best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / count);
+        }
+        return best;
+    }
+
+    void Bench(const std::vector<uint32_t>& trace, uint32_t window, float fpsDelay)
+    {
+        printf("\ncost (%zu frames, best of 5):\n", trace.size());
+
+        FrameTimeWindow w;
+        w.SetWindow(window);
+        double record = NsPer(trace.size(), [&] {
+            for (uint32_t us : trace) w.Record(us);
+        });
+        printf("  %-38s %8.2f ns/frame\n", "FrameTimeWindow::Record", record);
+
+        size_t queries = trace.size() / static_cast<size_t>(fpsDelay);
+        double query = NsPer(queries, [&] {
+            for (size_t q = 0; q < queries; q++) sink = w.Query().frames;
+        });
+        printf("  %-38s %8.1f ns/query\n", "FrameTimeWindow::Query (p50/p95/p99)", query);
+
+        double combined = NsPer(trace.size(), [&] {
+            for (size_t i = 0; i < trace.size(); i++) {
+                w.Record(trace[i]);
+                if (i % static_cast<size_t>(fpsDelay) == 0) sink = w.Query().frames;
+            }
+        });
+        printf("  %-38s %8.2f ns/frame\n", "record + query every fFpsDelay frames", combined);
+
+        // Raw ring of the last 2*window frames, sorted per query
+        std::vector<uint32_t> ring(2 * window), scratch;
+        scratch.reserve(ring.size());
+        size_t head = 0;
+        double sorted = NsPer(trace.size(), [&] {
+            for (size_t i = 0; i < trace.size(); i++) {
+                ring[head] = trace[i];
+                head = (head + 1) % ring.size();
+                if (i % static_cast<size_t>(fpsDelay) == 0) {
+                    scratch.assign(ring.begin(), ring.end());
+                    size_t r99 = scratch.size() * 99 / 100;
+                    std::nth_element(scratch.begin(), scratch.begin() + r99, scratch.end());
+                    sink = scratch[r99];
+                }
+            }
+        });
+        printf("  %-38s %8.2f ns/frame (%.0fx)\n", "raw ring + nth_element per query", sorted, sorted / combined);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    size_t frames = 200000;
+    uint32_t window = 450;
+    double hitchRate = 0.02;
+    uint64_t seed = 1;
+    const float fpsDelay = 10.0f;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--window") && i + 1 < argc) window = static_cast<uint32_t>(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--hitch-rate") && i + 1 < argc) hitchRate = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: histogram_bench [--frames N] [--window N] [--hitch-rate R] [--seed N]\n");
+            return 2;
+        }
+    }
+    window = std::max(window, FrameTimeWindow::MinWindow);
+    frames = std::max<size_t>(frames, 2 * window);
+
+    std::mt19937_64 rng(seed);
+    CheckBuckets();
+    std::vector<uint32_t> trace = Trace(rng, frames, hitchRate);
+    CheckAccuracy(trace, window, fpsDelay);
+    Bench(trace, window, fpsDelay);
+
+    return Report();
+}
@@ -0,0 +1,591 @@
+// =============================================================================
+// ini_schema_check - settings schema, INI reader and blob cache
+//
+//   ini_schema_check [--bench] [--ini PATH]...
+//
+// Uses a copy of ShadowBoostF4VR's settings struct and schema and checks:
+// - defaults come from the table, and Load() allocates nothing
+// - SimpleIni's value syntax: bool words, hex, signs, case-insensitive
+//   sections and keys, comments, CRLF, the last duplicate wins, values that
+//   do not parse keep the current one, and parsed values are clamped
+// - Save() then Load() reproduces every field
+// - Load() agrees with SimpleIni (or, when SimpleIni is not installed, with
+//   a DOM reader that parses values with strtol/strtod like SimpleIni does)
+// - the blob cache loads only with matching source stamps and schema hash
+// Each --ini file (e.g. the plugin's data/ShadowBoostF4VR.ini) is also
+// loaded both ways and compared.
+// --bench times Load() against the DOM reader(s) and a cache hit.
+// =============================================================================
+
+#include "check.h"
+#include "config_blob.h"
+#include "ini_schema.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <new>
+#include <string>
+#include <vector>
+
+#ifdef HAVE_SIMPLEINI
+#include <SimpleIni.h>
+#endif
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+// Every allocation in the process, so Load() can be shown not to make any.
+// Kept out of line: inlined into std::allocator, GCC pairs the new
+// expression with the free() and warns about a mismatch that is not there
+static std::atomic<uint64_t> g_allocations{ 0 };
+
+__attribute__((noinline)) void* operator new(size_t size)
+{
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+__attribute__((noinline)) void operator delete(void* p) noexcept { free(p); }
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept { free(p); }
+
+namespace
+{
+    // ---- Copy of ShadowBoostF4VR::ConfigValues and its schema ----
+
+    struct BlockLevel
+    {
+        float fLevel2;
+        float fLevel1;
+        float fLevel0;
+    };
+
+    struct Values
+    {
+        bool  bAutoAdjust = false;
+        float fFpsTarget = 90.0f;
+        float fFpsDelay = 10.0f;
+        float fMsTolerance = 0.5f;
+        int32_t iFrameTimeMetric = 0;
+        int32_t iPercentileFrames = 450;
+        int32_t iController = 0;
+        int32_t iAllocation = 0;
+        float fKp = 1.5f;
+        float fKi = 2.0f;
+        float fKd = 0.3f;
+        float fDerivativeFilter = 0.5f;
+        float fDegradeGain = 2.0f;
+        float fRestoreGain = 0.5f;
+        float fMaxDegradeStep = 0.10f;
+        float fMaxRestoreStep = 0.02f;
+        float fCostForgetting = 0.98f;
+        float fCostGain = 0.5f;
+        float fCostProbe = 0.02f;
+        bool  bShadowEnable = true;
+        float fShadowFactor = 30.0f;
+        float fShadowMin = 500.0f;
+        float fShadowMax = 8000.0f;
+        bool  bLodEnable = true;
+        float fLodFactor = 0.1f;
+        float fLodObjectsMin = 4.5f;
+        float fLodObjectsMax = 10.0f;
+        float fLodItemsMin = 2.5f;
+        float fLodItemsMax = 8.0f;
+        float fLodActorsMin = 6.0f;
+        float fLodActorsMax = 15.0f;
+        bool  bGrassEnable = true;
+        float fGrassFactor = 30.0f;
+        float fGrassMin = 3500.0f;
+        float fGrassMax = 7000.0f;
+        bool  bBlockEnable = false;
+        BlockLevel blockLevels[4] = {
+            { 110000.0f, 90000.0f, 60000.0f },
+            { 80000.0f, 60000.0f, 30000.0f },
+            { 80000.0f, 32000.0f, 20000.0f },
+            { 75000.0f, 25000.0f, 15000.0f },
+        };
+        bool    bGodRaysEnable = false;
+        int32_t iGodRaysQuality = 3;
+        int32_t iGodRaysGrid = 8;
+        float   fGodRaysScale = 0.4f;
+        int32_t iGodRaysCascade = 1;
+        float   fShadowEpsilon = 1.0f;
+        float   fLodEpsilon = 0.01f;
+        float   fGrassEpsilon = 1.0f;
+        int32_t iWriteMinFrames = 0;
+        bool    bTelemetry = false;
+        int32_t iTelemetryFrames = 65536;
+    };
+
+#define FIELD(section, key, member, lo, hi)                                                                     \
+    IniField { section, key, IniTypeOf<decltype(Values::member)>(), static_cast<uint32_t>(offsetof(Values, member)), \
+               static_cast<double>(Values{}.member), lo, hi }
+#define BLOCK(section, level)                                                                                        \
+    IniField { section, "fBlockLevel2Distance", IniType::Float,                                                      \
+               static_cast<uint32_t>(offsetof(Values, blockLevels) + level * sizeof(BlockLevel) +                    \
+                                     offsetof(BlockLevel, fLevel2)),                                                 \
+               static_cast<double>(Values{}.blockLevels[level].fLevel2), -IniUnbounded, IniUnbounded },              \
+    IniField { section, "fBlockLevel1Distance", IniType::Float,                                                      \
+               static_cast<uint32_t>(offsetof(Values, blockLevels) + level * sizeof(BlockLevel) +                    \
+                                     offsetof(BlockLevel, fLevel1)),                                                 \
+               static_cast<double>(Values{}.blockLevels[level].fLevel1), -IniUnbounded, IniUnbounded },              \
+    IniField { section, "fBlockLevel0Distance", IniType::Float,                                                      \
+               static_cast<uint32_t>(offsetof(Values, blockLevels) + level * sizeof(BlockLevel) +                    \
+                                     offsetof(BlockLevel, fLevel0)),                                                 \
+               static_cast<double>(Values{}.blockLevels[level].fLevel0), -IniUnbounded, IniUnbounded }
+
+    constexpr double U = IniUnbounded;
+
+    constexpr IniField Fields[] = {
+        FIELD("Main", "bAutoAdjust", bAutoAdjust, 0, 1),
+        FIELD("Main", "fFpsTarget", fFpsTarget, -U, U),
+        FIELD("Main", "fFpsDelay", fFpsDelay, -U, U),
+        FIELD("Main", "fMsTolerance", fMsTolerance, -U, U),
+        FIELD("Main", "iFrameTimeMetric", iFrameTimeMetric, 0, 2),
+        FIELD("Main", "iPercentileFrames", iPercentileFrames, 30, 100000),
+        FIELD("Main", "iController", iController, 0, 1),
+        FIELD("Main", "iAllocation", iAllocation, 0, 1),
+        FIELD("Controller", "fKp", fKp, -U, U),
+        FIELD("Controller", "fKi", fKi, -U, U),
+        FIELD("Controller", "fKd", fKd, -U, U),
+        FIELD("Controller", "fDerivativeFilter", fDerivativeFilter, 0.01, 1.0),
+        FIELD("Controller", "fDegradeGain", fDegradeGain, 0.0, U),
+        FIELD("Controller", "fRestoreGain", fRestoreGain, 0.0, U),
+        FIELD("Controller", "fMaxDegradeStep", fMaxDegradeStep, 0.0, 1.0),
+        FIELD("Controller", "fMaxRestoreStep", fMaxRestoreStep, 0.0, 1.0),
+        FIELD("CostModel", "fForgetting", fCostForgetting, 0.8, 1.0),
+        FIELD("CostModel", "fGain", fCostGain, 0.0, 4.0),
+        FIELD("CostModel", "fProbe", fCostProbe, 0.0, 0.2),
+        FIELD("Shadow", "bEnable", bShadowEnable, 0, 1),
+        FIELD("Shadow", "fDynamicValueFactor", fShadowFactor, -U, U),
+        FIELD("Shadow", "fMinDistance", fShadowMin, -U, U),
+        FIELD("Shadow", "fMaxDistance", fShadowMax, -U, U),
+        FIELD("Lod", "bEnable", bLodEnable, 0, 1),
+        FIELD("Lod", "fDynamicValueFactor", fLodFactor, -U, U),
+        FIELD("Lod", "fLODFadeOutMultObjectsMin", fLodObjectsMin, -U, U),
+        FIELD("Lod", "fLODFadeOutMultObjectsMax", fLodObjectsMax, -U, U),
+        FIELD("Lod", "fLODFadeOutMultItemsMin", fLodItemsMin, -U, U),
+        FIELD("Lod", "fLODFadeOutMultItemsMax", fLodItemsMax, -U, U),
+        FIELD("Lod", "fLODFadeOutMultActorsMin", fLodActorsMin, -U, U),
+        FIELD("Lod", "fLODFadeOutMultActorsMax", fLodActorsMax, -U, U),
+        FIELD("Grass", "bEnable", bGrassEnable, 0, 1),
+        FIELD("Grass", "fDynamicValueFactor", fGrassFactor, -U, U),
+        FIELD("Grass", "fGrassStartFadeDistanceMin", fGrassMin, -U, U),
+        FIELD("Grass", "fGrassStartFadeDistanceMax", fGrassMax, -U, U),
+        FIELD("TerrainManager", "bEnable", bBlockEnable, 0, 1),
+        BLOCK("TerrainManager", 0),
+        BLOCK("TerrainManager:Level1", 1),
+        BLOCK("TerrainManager:Level2", 2),
+        BLOCK("TerrainManager:Level3", 3),
+        FIELD("GodRays", "bEnable", bGodRaysEnable, 0, 1),
+        FIELD("GodRays", "iQuality", iGodRaysQuality, -U, U),
+        FIELD("GodRays", "iGrid", iGodRaysGrid, -U, U),
+        FIELD("GodRays", "fScale", fGodRaysScale, -U, U),
+        FIELD("GodRays", "iCascade", iGodRaysCascade, -U, U),
+        FIELD("Writes", "fShadowEpsilon", fShadowEpsilon, 0.0, U),
+        FIELD("Writes", "fLodEpsilon", fLodEpsilon, 0.0, U),
+        FIELD("Writes", "fGrassEpsilon", fGrassEpsilon, 0.0, U),
+        FIELD("Writes", "iMinFrames", iWriteMinFrames, 0, 900),
+        FIELD("Telemetry", "bEnable", bTelemetry, 0, 1),
+        FIELD("Telemetry", "iFrames", iTelemetryFrames, 1024, 1 << 24),
+    };
+
+#undef FIELD
+#undef BLOCK
+
+    const IniSchema Schema(Fields, sizeof(Values));
+
+    bool Same(const Values& a, const Values& b, const char* what)
+    {
+        bool same = true;
+        for (size_t i = 0; i < Schema.Count(); i++) {
+            const IniField& f = Schema.Fields()[i];
+            double x = IniSchema::Get(f, &a), y = IniSchema::Get(f, &b);
+            if (x != y) {
+                printf("  %s: [%s] %s %g vs %g\n", what, f.section, f.key, x, y);
+                same = false;
+            }
+        }
+        return same;
+    }
+
+    // ---- Reference readers ----
+
+    // Section -> key -> value, case-insensitive, built like SimpleIni's
+    // DOM: one node per section and key, every string copied
+    struct NoCase
+    {
+        bool operator()(const std::string& a, const std::string& b) const
+        {
+            return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), [](char x, char y) {
+                return tolower(static_cast<unsigned char>(x)) < tolower(static_cast<unsigned char>(y));
+            });
+        }
+    };
+
+    class DomIni
+    {
+    public:
+        void Load(std::string_view text)
+        {
+            _sections.clear();
+            ForEachIniValue(text, [&](std::string_view s, std::string_view k, std::string_view v) {
+                _sections[std::string(s)][std::string(k)] = std::string(v);
+            });
+        }
+
+        const char* Get(const char* section, const char* key) const
+        {
+            auto s = _sections.find(section);
+            if (s == _sections.end()) return nullptr;
+            auto k = s->second.find(key);
+            return k == s->second.end() ? nullptr : k->second.c_str();
+        }
+
+    private:
+        std::map<std::string, std::map<std::string, std::string, NoCase>, NoCase> _sections;
+    };
+
+    // The value functions of SimpleIni 4.x: strtol/strtod with the whole
+    // value consumed, bools by first letter
+    bool DomBool(const char* v, bool def)
+    {
+        if (!v || !*v) return def;
+        switch (v[0]) {
+        case 't': case 'T': case 'y': case 'Y': case '1': return true;
+        case 'f': case 'F': case 'n': case 'N': case '0': return false;
+        case 'o': case 'O':
+            if (v[1] == 'n' || v[1] == 'N') return true;
+            if (v[1] == 'f' || v[1] == 'F') return false;
+            break;
+        }
+        return def;
+    }
+
+    long DomLong(const char* v, long def)
+    {
+        if (!v || !*v) return def;
+        char* end = nullptr;
+        long long n = v[0] == '0' && (v[1] == 'x' || v[1] == 'X') && v[2] ? strtoll(v + 2, &end, 16)
+                                                                           : strtoll(v, &end, 10);
+        // long is 32 bits on Windows, where the plugin runs
+        return *end ? def : static_cast<long>(std::clamp<long long>(n, INT32_MIN, INT32_MAX));
+    }
+
+    double DomDouble(const char* v, double def)
+    {
+        if (!v || !*v) return def;
+        char* end = nullptr;
+        double d = strtod(v, &end);
+        return *end ? def : d;
+    }
+
+    // How the plugin's loadFromIni used to apply a file: every key looked up
+    // by name, then clamped
+    template <typename Ini>
+    void ApplyDom(const Ini& ini, Values& v)
+    {
+        for (size_t i = 0; i < Schema.Count(); i++) {
+            const IniField& f = Schema.Fields()[i];
+            double cur = IniSchema::Get(f, &v);
+            switch (f.type) {
+            case IniType::Bool:
+                IniSchema::Set(f, &v, ini.GetBoolValue(f.section, f.key, cur != 0.0) ? 1.0 : 0.0);
+                break;
+            case IniType::Int:
+                IniSchema::Set(f, &v, static_cast<double>(static_cast<int32_t>(
+                                          ini.GetLongValue(f.section, f.key, static_cast<long>(cur)))));
+                break;
+            case IniType::Float:
+                IniSchema::Set(f, &v, static_cast<float>(ini.GetDoubleValue(f.section, f.key, cur)));
+                break;
+            }
+        }
+    }
+
+    struct DomAdapter
+    {
+        const DomIni& dom;
+        bool GetBoolValue(const char* s, const char* k, bool d) const { return DomBool(dom.Get(s, k), d); }
+        long GetLongValue(const char* s, const char* k, long d) const { return DomLong(dom.Get(s, k), d); }
+        double GetDoubleValue(const char* s, const char* k, double d) const { return DomDouble(dom.Get(s, k), d); }
+    };
+
+    // ---- Checks ----
+
+    const char* const Tricky =
+        "\xEF\xBB\xBF; comment\r\n"
+        "# another\r\n"
+        "[ main ]\r\n"
+        "BAUTOADJUST = yes\r\n"
+        "fFpsTarget=+72.5\r\n"
+        "fFpsDelay = 12 frames\r\n"            // does not parse: keeps 10
+        "iFrameTimeMetric = 7\r\n"             // clamped to 2
+        "iPercentileFrames = 0x100\r\n"
+        "iController = -3\r\n"                 // clamped to 0
+        "fMsTolerance = 0.25\r\n"
+        "fMsTolerance = 0.75\r\n"              // last one wins
+        "unknownKey = 1\r\n"
+        "\r\n"
+        "[Controller]\n"
+        "fDerivativeFilter = 0\n"              // clamped to 0.01
+        "fKp = 1e1\n"
+        "fKi = nan\n"                          // ignored
+        "[Shadow]\n"
+        "bEnable = off\n"
+        "fMinDistance = -inf\n"
+        "fMaxDistance=\n"                      // empty: keeps 8000
+        "[terrainmanager:LEVEL2]\n"
+        "fBlockLevel0Distance = 25000\n"
+        "[GodRays]\n"
+        "bEnable = On\n"
+        "iGrid = 99999999999\n"                // saturates like strtol on 32-bit long
+        "[Telemetry]\n"
+        "iFrames = 100\n"                      // clamped to 1024
+        "[Stats]\n"
+        "fFrameTimeMean = 11.2\n"
+        "noEquals\n";
+
+    void CheckDefaults()
+    {
+        Values v;
+        Check(Schema.Load(&v, Tricky) > 0, "nothing loaded to reset");
+        Schema.SetDefaults(&v);
+        Check(Same(v, Values{}, "defaults"), "SetDefaults differs from the struct's initializers");
+        Check(Schema.Find("TERRAINMANAGER:level3", "FBLOCKLEVEL1DISTANCE") != nullptr, "case-insensitive find");
+        Check(Schema.Find("Stats", "fFrameTimeMean") == nullptr, "unknown key found");
+    }
+
+    void CheckSyntax()
+    {
+        Values v;
+        uint64_t before = g_allocations.load();
+        size_t applied = Schema.Load(&v, Tricky);
+        uint64_t allocations = g_allocations.load() - before;
+        printf("  tricky file: %zu values applied, %llu allocations\n", applied,
+               static_cast<unsigned long long>(allocations));
+        Check(allocations == 0, "Load() allocated");
+        Check(v.bAutoAdjust, "yes as true");
+        Check(v.fFpsTarget == 72.5f, "+72.5");
+        Check(v.fFpsDelay == 10.0f, "trailing text must keep the old value");
+        Check(v.iFrameTimeMetric == 2, "int clamp to max");
+        Check(v.iPercentileFrames == 256, "hex int");
+        Check(v.iController == 0, "negative int clamp to min");
+        Check(v.fMsTolerance == 0.75f, "last duplicate wins");
+        Check(v.fDerivativeFilter == 0.01f, "float clamp to min");
+        Check(v.fKp == 10.0f, "exponent");
+        Check(v.fKi == 2.0f, "nan must be ignored");
+        Check(!v.bShadowEnable, "off as false");
+        Check(v.fShadowMin < -1e29f, "-inf clamps to the unbounded range");
+        Check(v.fShadowMax == 8000.0f, "empty value keeps the old one");
+        Check(v.blockLevels[2].fLevel0 == 25000.0f && v.blockLevels[2].fLevel1 == 32000.0f, "block level section");
+        Check(v.bGodRaysEnable, "On as true");
+        Check(v.iGodRaysGrid == INT32_MAX, "int overflow saturates");
+        Check(v.iTelemetryFrames == 1024, "telemetry clamp");
+
+        Values dom;
+        DomIni ini;
+        ini.Load(Tricky);
+        ApplyDom(DomAdapter{ ini }, dom);
+        Check(Same(v, dom, "tricky vs strtol/strtod"), "Load() disagrees with the strtol/strtod reader");
+#ifdef HAVE_SIMPLEINI
+        CSimpleIniA simple;
+        simple.LoadData(Tricky, strlen(Tricky));
+        Values si;
+        ApplyDom(simple, si);
+        Check(Same(v, si, "tricky vs SimpleIni"), "Load() disagrees with SimpleIni");
+#endif
+    }
+
+    void CheckRoundTrip()
+    {
+        Values v;
+        for (size_t i = 0; i < Schema.Count(); i++) {
+            const IniField& f = Schema.Fields()[i];
+            double x = f.type == IniType::Bool ? (i & 1) : f.type == IniType::Int ? f.min + 1 : f.def * 1.37 + 0.1;
+            IniSchema::Set(f, &v, x);
+        }
+        std::string text;
+        Schema.Save(&v, text);
+        Values back;
+        Schema.Load(&back, text);
+        Check(Same(v, back, "round trip"), "Save() then Load() changed a value");
+        printf("  round trip: %zu fields, %zu bytes\n", Schema.Count(), text.size());
+    }
+
+    void Write(const char* path, const std::string& text)
+    {
+        FILE* f = fopen(path, "wb");
+        fwrite(text.data(), 1, text.size(), f);
+        fclose(f);
+    }
+
+    void CheckBlob()
+    {
+        using ConfigBlob::Status;
+        const char* ini = "ini_schema_check.ini";
+        const char* blob = "ini_schema_check.blob";
+        Write(ini, "[Main]\nfFpsTarget = 80\n");
+
+        Values v;
+        Schema.Load(&v, "[Main]\nfFpsTarget = 80\n");
+        ConfigBlob::SourceStamp stamps[2] = { ConfigBlob::Stamp(ini), ConfigBlob::Stamp("missing.ini") };
+        Check(stamps[0].size != 0 && stamps[1] == ConfigBlob::SourceStamp{}, "stamps");
+        Check(ConfigBlob::Save(blob, Schema.Hash(), stamps, 2, &v, sizeof(v)), "blob save");
+
+        Values out;
+        Check(ConfigBlob::Load(blob, Schema.Hash(), stamps, 2, &out, sizeof(out)) == Status::Ok && out.fFpsTarget == 80.0f,
+              "blob load");
+        Check(ConfigBlob::Load(blob, Schema.Hash() ^ 1, stamps, 2, &out, sizeof(out)) == Status::Stale,
+              "schema change must invalidate");
+        Check(ConfigBlob::Load(blob, Schema.Hash(), stamps, 1, &out, sizeof(out)) == Status::Stale,
+              "source count change must invalidate");
+
+        Write(ini, "[Main]\nfFpsTarget = 72.0\n");
+        ConfigBlob::SourceStamp edited[2] = { ConfigBlob::Stamp(ini), stamps[1] };
+        Values untouched;
+        Check(ConfigBlob::Load(blob, Schema.Hash(), edited, 2, &untouched, sizeof(untouched)) == Status::Stale &&
+                  untouched.fFpsTarget == 90.0f,
+              "edited source must invalidate and leave the values alone");
+
+        FILE* f = fopen(blob, "r+b");
+        fseek(f, -1, SEEK_END);
+        fputc(0x7F, f);
+        fclose(f);
+        Check(ConfigBlob::Load(blob, Schema.Hash(), stamps, 2, &out, sizeof(out)) == Status::Corrupt, "corrupt blob");
+        remove(blob);
+        Check(ConfigBlob::Load(blob, Schema.Hash(), stamps, 2, &out, sizeof(out)) == Status::Missing, "missing blob");
+        remove(ini);
+        printf("  blob: %zu bytes (header %zu + values %zu)\n", sizeof(ConfigBlob::Header) + sizeof(Values),
+               sizeof(ConfigBlob::Header), sizeof(Values));
+    }
+
+    bool ReadFile(const char* path, std::string& out)
+    {
+        FILE* f = fopen(path, "rb");
+        if (!f) return false;
+        char buffer[4096];
+        size_t n;
+        while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) out.append(buffer, n);
+        fclose(f);
+        return true;
+    }
+
+    void CheckFile(const char* path)
+    {
+        std::string text;
+        if (!ReadFile(path, text)) {
+            Fail("cannot read %s", path);
+            return;
+        }
+        Values a, b;
+        size_t applied = Schema.Load(&a, text);
+        DomIni ini;
+        ini.Load(text);
+        ApplyDom(DomAdapter{ ini }, b);
+        printf("  %s: %zu values applied\n", path, applied);
+        Check(Same(a, b, path), "Load() disagrees with the strtol/strtod reader on a file");
+    }
+
+    template <typename Fn>
+    double TimeUs(Fn&& fn, int n)
+    {
+        auto t0 = Clock::now();
+        for (int i = 0; i < n; i++) fn();
+        return std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / n;
+    }
+
+    void Bench()
+    {
+        // The plugin's own INI: every key, with a comment line over each
+        Values defaults;
+        std::string saved, text;
+        Schema.Save(&defaults, saved);
+        for (size_t at = 0, eol; at < saved.size(); at = eol + 1) {
+            eol = saved.find('\n', at);
+            if (saved[at] != '[' && saved[at] != '\n') text += "; what the next setting does, in a sentence or two\n";
+            text.append(saved, at, eol - at + 1);
+        }
+
+        const int n = 20000;
+        Values v;
+        uint64_t a0 = g_allocations.load();
+        double schema = TimeUs([&] { Schema.Load(&v, text); }, n);
+        double schemaAllocs = double(g_allocations.load() - a0) / n;
+
+        DomIni dom;
+        a0 = g_allocations.load();
+        double domUs = TimeUs([&] {
+            dom.Load(text);
+            ApplyDom(DomAdapter{ dom }, v);
+        }, n);
+        double domAllocs = double(g_allocations.load() - a0) / n;
+
+        printf("\nLoad of a %zu-byte, %zu-key INI (us per load, allocations per load):\n", text.size(),
+               Schema.Count());
+        printf("  IniSchema::Load          %7.2f  %7.1f\n", schema, schemaAllocs);
+        printf("  DOM + strtod lookups     %7.2f  %7.1f\n", domUs, domAllocs);
+#ifdef HAVE_SIMPLEINI
+        a0 = g_allocations.load();
+        double simpleUs = TimeUs([&] {
+            CSimpleIniA ini;
+            ini.LoadData(text.data(), text.size());
+            ApplyDom(ini, v);
+        }, n);
+        printf("  SimpleIni                %7.2f  %7.1f\n", simpleUs, double(g_allocations.load() - a0) / n);
+#else
+        printf("  SimpleIni                (not installed; the DOM reader stands in)\n");
+#endif
+
+        const char* ini = "ini_schema_check.ini";
+        const char* blob = "ini_schema_check.blob";
+        Write(ini, text);
+        ConfigBlob::SourceStamp stamps[1] = { ConfigBlob::Stamp(ini) };
+        ConfigBlob::Save(blob, Schema.Hash(), stamps, 1, &v, sizeof(v));
+        double hit = TimeUs([&] {
+            ConfigBlob::SourceStamp now[1] = { ConfigBlob::Stamp(ini) };
+            ConfigBlob::Load(blob, Schema.Hash(), now, 1, &v, sizeof(v));
+        }, n);
+        double read = TimeUs([&] {
+            std::string t;
+            ReadFile(ini, t);
+            Schema.Load(&v, t);
+        }, n);
+        printf("  blob cache hit (stat + map)        %7.2f\n", hit);
+        printf("  read file + IniSchema::Load        %7.2f\n", read);
+        remove(ini);
+        remove(blob);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    bool bench = false;
+    std::vector<const char*> files;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--bench")) bench = true;
+        else if (!strcmp(argv[i], "--ini") && i + 1 < argc) files.push_back(argv[++i]);
+        else {
+            fprintf(stderr, "usage: ini_schema_check [--bench] [--ini PATH]...\n");
+            return 2;
+        }
+    }
+
+    printf("schema: %zu fields, hash %016llx\n", Schema.Count(), static_cast<unsigned long long>(Schema.Hash()));
+    CheckDefaults();
+    CheckSyntax();
+    CheckRoundTrip();
+    CheckBlob();
+    for (const char* path : files) CheckFile(path);
+    if (bench) Bench();
+
+    return Report();
+}
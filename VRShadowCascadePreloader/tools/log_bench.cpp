@@ -0,0 +1,140 @@
+// =============================================================================
+// log_bench - preloader logging: synchronous vs. LogRing
+//
+//   log_bench [--threads N] [--lines N] [--out FILE]
+//
+// "sync" reproduces the old Log(): a lock around fprintf + fflush for every
+// line (OutputDebugStringA has no Linux equivalent and is left out, which
+// flatters the old path). "ring" is LogRing with a background writer that
+// drains every 20 ms, as in the preloader. Each producer thread logs N lines
+// shaped like the timer tick diagnostics; per-call latency is sampled on
+// every call, throughput is measured until the last line is on disk.
+// =============================================================================
+
+#include "log_ring.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace CascadePatch;
+
+using Clock = std::chrono::steady_clock;
+
+struct Result
+{
+    std::vector<double> latencyNs;
+    double totalMs = 0.0;
+};
+
+template <typename LogFn>
+static void Produce(LogFn&& log, int lines, long id, std::vector<double>& latency)
+{
+    latency.reserve(lines);
+    for (int i = 0; i < lines; i++) {
+        auto t0 = Clock::now();
+        log("Timer tick #%ld: vrExpanded=%ld, maskRestored=%ld (thread %ld)", (long)i, 1L, 0L, id);
+        latency.push_back(std::chrono::duration<double, std::nano>(Clock::now() - t0).count());
+    }
+}
+
+template <typename LogFn>
+static Result RunProducers(int threads, int lines, LogFn&& log)
+{
+    std::vector<std::vector<double>> perThread(threads);
+    std::vector<std::thread> pool;
+    for (int t = 0; t < threads; t++) {
+        pool.emplace_back([&, t] { Produce(log, lines, t, perThread[t]); });
+    }
+    for (std::thread& th : pool) th.join();
+
+    Result r;
+    for (auto& v : perThread) r.latencyNs.insert(r.latencyNs.end(), v.begin(), v.end());
+    return r;
+}
+
+static void Report(const char* name, Result& r, uint64_t dropped)
+{
+    std::sort(r.latencyNs.begin(), r.latencyNs.end());
+    auto pct = [&](double p) { return r.latencyNs[static_cast<size_t>(p * (r.latencyNs.size() - 1))]; };
+    double linesPerSec = r.latencyNs.size() / (r.totalMs / 1000.0);
+    printf("%-5s p50 %8.0f ns  p99 %8.0f ns  max %10.0f ns  %10.0f lines/s  (%llu overflows)\n",
+           name, pct(0.5), pct(0.99), r.latencyNs.back(), linesPerSec, (unsigned long long)dropped);
+}
+
+int main(int argc, char** argv)
+{
+    int threads = 4;
+    int lines = 20000;
+    const char* outPath = "log_bench.log";
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--lines") && i + 1 < argc) lines = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--out") && i + 1 < argc) outPath = argv[++i];
+        else {
+            fprintf(stderr, "usage: log_bench [--threads N] [--lines N] [--out FILE]\n");
+            return 2;
+        }
+    }
+    if (threads < 1 || lines < 1) return 2;
+
+    printf("%d threads x %d lines -> %s\n", threads, lines, outPath);
+
+    // ---- sync ----
+    {
+        FILE* f = fopen(outPath, "w");
+        if (!f) return 1;
+        std::mutex lock;
+        auto t0 = Clock::now();
+        Result r = RunProducers(threads, lines, [&](const char* fmt, auto... args) {
+            char buffer[1024];
+            snprintf(buffer, sizeof(buffer), fmt, args...);
+            std::lock_guard<std::mutex> guard(lock);
+            fprintf(f, "%s\n", buffer);
+            fflush(f);
+        });
+        r.totalMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        fclose(f);
+        Report("sync", r, 0);
+    }
+
+    // ---- ring ----
+    {
+        FILE* f = fopen(outPath, "w");
+        if (!f) return 1;
+        static LogRing ring;
+        std::atomic<bool> stop{ false };
+        std::thread writer([&] {
+            while (!stop.load()) {
+                ring.Drain(f);
+                std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            }
+        });
+
+        auto t0 = Clock::now();
+        Result r = RunProducers(threads, lines, [&](const char* fmt, auto... args) {
+            // Same overflow policy as the preloader: help drain until it fits
+            while (!ring.Push(fmt, args...)) {
+                if (!ring.Drain(f)) std::this_thread::yield();
+            }
+        });
+        stop.store(true);
+        writer.join();
+        ring.Drain(f);
+        r.totalMs = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        fclose(f);
+        Report("ring", r, ring.Overflows());
+        if (ring.Written() != static_cast<uint64_t>(threads) * lines) {
+            fprintf(stderr, "ring wrote %llu of %llu lines\n", (unsigned long long)ring.Written(),
+                    (unsigned long long)threads * lines);
+            return 1;
+        }
+    }
+    return 0;
+}
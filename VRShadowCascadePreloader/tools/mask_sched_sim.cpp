@@ -0,0 +1,274 @@
+// =============================================================================
+// mask_sched_sim - cascade mask scheduling on frame-time traces
+//
+//   mask_sched_sim [--trace FILE] [--seconds N] [--seed N] [--budget MS]
+//                  [--cost-near MS] [--cost-far MS] [--bench]
+//
+// Runs CascadeScheduler against a cost model instead of the game. A frame
+// takes the scene load, cost-near ms for cascades 0 and 1, and cost-far ms
+// for each of cascades 2 and 3 that the frame's rotation slot renders. A
+// pattern change applies from the next frame.
+//
+// Without --trace the scene is synthetic: a light scene, a heavy one
+// (+2 ms) from 30% to 60% of the run, light again, with noise and rare
+// hitches. A --trace file has one frame time in ms per line (first field of
+// CSV rows, '#' lines skipped), recorded with every cascade on; the cascade
+// cost is subtracted to get the scene load.
+//
+// Checks the rotations first: every ladder level keeps the near cascades in
+// every slot, renders each far cascade at least once per rotation, and has
+// slots 0 and 2 equal. The fixed modes must hold their pattern. Then every
+// mode runs on the same frames. Adaptive must have fewer frames over the
+// budget than All and render the far cascades more often than FarQuarter,
+// without flapping between levels. Per mode it reports:
+//   over    share of frames over the budget
+//   far     share of far cascade renders (1 = every frame, both cascades)
+//   mean    mean frame time
+//   changes pattern changes (each one is a code patch in the plugin)
+// --bench times Frame().
+// =============================================================================
+
+#include "cascade_schedule.h"
+#include "check.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    struct CostModel
+    {
+        float nearMs = 1.2f;
+        float farMs = 1.1f;     // each of cascades 2 and 3
+
+        float Ms(uint8_t mask) const
+        {
+            return nearMs + farMs * static_cast<float>(((mask >> 2) & 1) + ((mask >> 3) & 1));
+        }
+    };
+
+    std::vector<float> SyntheticScene(size_t frames, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<float> noise(0.0f, 0.4f);
+        std::uniform_real_distribution<float> roll(0.0f, 1.0f);
+        std::uniform_real_distribution<float> hitch(20.0f, 40.0f);
+        std::vector<float> scene(frames);
+        for (size_t i = 0; i < frames; i++) {
+            bool heavy = i >= frames * 3 / 10 && i < frames * 6 / 10;
+            float base = heavy ? 8.0f : 6.0f;
+            scene[i] = roll(rng) < 0.003f ? hitch(rng) : std::max(1.0f, base + noise(rng));
+        }
+        return scene;
+    }
+
+    bool LoadTrace(const char* path, const CostModel& cost, std::vector<float>& scene)
+    {
+        FILE* f = fopen(path, "r");
+        if (!f) return false;
+        char line[512];
+        while (fgets(line, sizeof(line), f)) {
+            if (line[0] == '#') continue;
+            char* end = nullptr;
+            float ms = strtof(line, &end);
+            if (end == line) continue;  // header row
+            scene.push_back(std::max(0.5f, ms - cost.Ms(0xF)));
+        }
+        fclose(f);
+        return !scene.empty();
+    }
+
+    // ---- Rotations ----
+    void CheckPatterns()
+    {
+        for (size_t level = 0; level < MaskLevels; level++) {
+            const MaskPattern& p = MaskLadder[level];
+            int far2 = 0, far3 = 0;
+            bool near = true;
+            for (uint8_t m : p.slot) {
+                near &= (m & 0x3) == 0x3;
+                far2 += (m >> 2) & 1;
+                far3 += (m >> 3) & 1;
+            }
+            Check(near, "ladder level drops a near cascade");
+            Check(far2 >= 1 && far3 >= 1, "ladder level never renders a far cascade");
+            Check(far2 + far3 == static_cast<int>(8 - 2 * level), "ladder level far rate is not 4, 3, 2, 1 in 4");
+            Check(p.slot[0] == p.slot[2], "ladder level has different slots 0 and 2");
+        }
+        Check(MaskOriginal.slot[0] == MaskOriginal.slot[2], "original rotation has different slots 0 and 2");
+
+        struct Fixed
+        {
+            CascadeSchedule   mode;
+            const MaskPattern* pattern;
+            int               level;
+        };
+        const Fixed fixed[] = {
+            { CascadeSchedule::All,        &MaskLadder[0], 0 },
+            { CascadeSchedule::Original,   &MaskOriginal,  -1 },
+            { CascadeSchedule::FarHalf,    &MaskLadder[2], 2 },
+            { CascadeSchedule::FarQuarter, &MaskLadder[3], 3 },
+        };
+        for (const Fixed& f : fixed) {
+            CascadeScheduler s;
+            CascadeScheduleConfig c;
+            c.mode = f.mode;
+            s.Configure(c);
+            bool changed = false;
+            // Over budget, then far under it: a fixed mode ignores both
+            for (int i = 0; i < 2000; i++) changed |= s.Frame(i < 1000 ? 20000 : 3000);
+            Check(!changed && s.Pattern() == *f.pattern && s.Level() == f.level, "fixed mode changed its pattern");
+        }
+
+        // A mode change resets; adapt off walks back to level 0
+        CascadeScheduler s;
+        CascadeScheduleConfig c;
+        s.Configure(c);
+        for (int i = 0; i < 2000; i++) s.Frame(20000);
+        Check(s.Level() == static_cast<int>(MaskLevels) - 1, "adaptive did not reach the cheapest level over budget");
+        c.adapt = false;
+        s.Configure(c);
+        for (int i = 0; i < 200; i++) s.Frame(20000);
+        Check(s.Level() == 0, "adapt off did not return to level 0");
+        c.adapt = true;
+        c.mode = CascadeSchedule::Original;
+        s.Configure(c);
+        Check(s.Pattern() == MaskOriginal, "mode change did not reset the pattern");
+    }
+
+    // ---- One simulated run ----
+    struct Result
+    {
+        float    overPct = 0.0f;
+        float    farRate = 0.0f;
+        float    meanMs = 0.0f;
+        uint64_t changes = 0;
+        CascadeScheduler scheduler;
+    };
+
+    Result Run(const std::vector<float>& scene, const CostModel& cost, const CascadeScheduleConfig& config, uint64_t seed)
+    {
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<float> jitter(0.0f, 0.15f);
+        Result r;
+        r.scheduler.Configure(config);
+        uint64_t over = 0, far = 0;
+        double total = 0.0;
+        for (size_t i = 0; i < scene.size(); i++) {
+            uint8_t mask = r.scheduler.Pattern().ForFrame(i);
+            float ms = std::max(0.5f, scene[i] + cost.Ms(mask) + jitter(rng));
+            over += ms > config.budgetMs;
+            far += ((mask >> 2) & 1) + ((mask >> 3) & 1);
+            total += ms;
+            r.changes += r.scheduler.Frame(static_cast<uint32_t>(ms * 1000.0f));
+        }
+        float n = static_cast<float>(scene.size());
+        r.overPct = 100.0f * static_cast<float>(over) / n;
+        r.farRate = static_cast<float>(far) / (2.0f * n);
+        r.meanMs = static_cast<float>(total / scene.size());
+        return r;
+    }
+
+    void Bench()
+    {
+        std::mt19937_64 rng(7);
+        std::normal_distribution<float> ms(11.0f, 1.0f);
+        static uint32_t us[1024];
+        for (uint32_t& u : us) u = static_cast<uint32_t>(std::max(1.0f, ms(rng)) * 1000.0f);
+        CascadeScheduler s;
+        s.Configure(CascadeScheduleConfig{});
+        const int n = 10000000;
+        uint64_t changes = 0;
+        auto t0 = Clock::now();
+        for (int i = 0; i < n; i++) changes += s.Frame(us[i & 1023]);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+        printf("\nFrame: %.2f ns per frame (%llu changes)\n", ns, static_cast<unsigned long long>(changes));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* trace = nullptr;
+    float seconds = 120.0f;
+    uint64_t seed = 1;
+    float budgetMs = 1000.0f / 90.0f;
+    CostModel cost;
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--trace") && i + 1 < argc) trace = argv[++i];
+        else if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--budget") && i + 1 < argc) budgetMs = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--cost-near") && i + 1 < argc) cost.nearMs = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--cost-far") && i + 1 < argc) cost.farMs = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--bench")) bench = true;
+        else {
+            fprintf(stderr, "usage: mask_sched_sim [--trace FILE] [--seconds N] [--seed N] [--budget MS]\n"
+                            "                      [--cost-near MS] [--cost-far MS] [--bench]\n");
+            return 2;
+        }
+    }
+
+    CheckPatterns();
+
+    std::vector<float> scene;
+    if (trace) {
+        if (!LoadTrace(trace, cost, scene)) {
+            fprintf(stderr, "cannot read frame times from %s\n", trace);
+            return 1;
+        }
+        printf("trace %s: %zu frames\n", trace, scene.size());
+    } else {
+        scene = SyntheticScene(static_cast<size_t>(std::max(seconds, 1.0f) * 90.0f), seed);
+        printf("synthetic scene: %zu frames\n", scene.size());
+    }
+
+    static const char* const names[] = { "All", "Adaptive", "Original", "FarHalf", "FarQuarter" };
+    Result results[5];
+    printf("\n%-11s %7s %6s %8s %8s\n", "mode", "over", "far", "mean", "changes");
+    for (int m = 0; m < 5; m++) {
+        CascadeScheduleConfig c;
+        c.mode = static_cast<CascadeSchedule>(m);
+        c.budgetMs = budgetMs;
+        results[m] = Run(scene, cost, c, seed);
+        const Result& r = results[m];
+        printf("%-11s %6.1f%% %6.2f %6.2fms %8llu\n", names[m], r.overPct, r.farRate, r.meanMs,
+               static_cast<unsigned long long>(r.changes));
+    }
+
+    const CascadeScheduler& a = results[static_cast<int>(CascadeSchedule::Adaptive)].scheduler;
+    const auto& st = a.Stats();
+    printf("\nadaptive: %llu windows, %llu drops, %llu raises; frames at level 0-3: %llu %llu %llu %llu\n",
+           static_cast<unsigned long long>(st.windows), static_cast<unsigned long long>(st.drops),
+           static_cast<unsigned long long>(st.raises), static_cast<unsigned long long>(st.framesAt[0]),
+           static_cast<unsigned long long>(st.framesAt[1]), static_cast<unsigned long long>(st.framesAt[2]),
+           static_cast<unsigned long long>(st.framesAt[3]));
+    printf("learned level costs: %.2f %.2f %.2f ms (model %.2f)\n", a.LevelCost(0), a.LevelCost(1),
+           a.LevelCost(2), cost.farMs / 2.0f);
+
+    if (!trace) {
+        const Result& all = results[static_cast<int>(CascadeSchedule::All)];
+        const Result& adaptive = results[static_cast<int>(CascadeSchedule::Adaptive)];
+        const Result& quarter = results[static_cast<int>(CascadeSchedule::FarQuarter)];
+        Check(adaptive.overPct < all.overPct, "adaptive is over budget as often as All");
+        Check(adaptive.farRate > quarter.farRate, "adaptive renders the far cascades no more than FarQuarter");
+        // Two load changes: down and back up the ladder once each, plus noise
+        Check(adaptive.changes <= 4 * MaskLevels, "adaptive flaps between levels");
+        for (int m : { 0, 2, 3, 4 }) Check(results[m].changes == 0, "fixed mode changed its pattern");
+    }
+
+    if (bench) Bench();
+
+    return Report();
+}
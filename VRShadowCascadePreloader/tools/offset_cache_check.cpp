@@ -0,0 +1,225 @@
+// =============================================================================
+// offset_cache_check - the resolved-site cache against a temp file
+//
+//   offset_cache_check
+//
+// Fingerprints a synthetic PE header with the real site table, saves a cache
+// and loads it back through every path the preloader takes at startup:
+// - a missing file, then a hit with every entry intact
+// - Stale after a game update (PE timestamp, image size, a section header)
+//   or an edited site table, with the caller's RVAs left untouched
+// - Corrupt for a truncated, extended or bit-flipped file and a wrong
+//   magic or version; Missing for an empty one
+// - a rewrite under the new fingerprint hitting again
+// and that a header that is not PE32+ (or cut off in its section table)
+// gives no fingerprint at all.
+// =============================================================================
+
+#include "cascade_sites.h"
+#include "check.h"
+#include "offset_cache.h"
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+namespace
+{
+    constexpr uint32_t Lfanew       = 0x80;
+    constexpr uint32_t OptionalSize = 240;
+    constexpr uint16_t SectionCount = 2;
+    constexpr size_t   FileHeader   = Lfanew + 4;
+    constexpr size_t   Optional     = FileHeader + 20;
+    constexpr size_t   Sections     = Optional + OptionalSize;
+
+    template <typename T>
+    void Put(std::vector<uint8_t>& image, size_t offset, T value)
+    {
+        memcpy(image.data() + offset, &value, sizeof(value));
+    }
+
+    // MZ stub, PE32+ headers and a .text and .data section header: all
+    // ComputeFingerprint() reads
+    std::vector<uint8_t> SyntheticImage(uint32_t timeDateStamp)
+    {
+        std::vector<uint8_t> image(0x400, 0);
+        Put<uint16_t>(image, 0, 0x5A4D);
+        Put<uint32_t>(image, 0x3C, Lfanew);
+        Put<uint32_t>(image, Lfanew, 0x00004550);
+        Put<uint16_t>(image, FileHeader, 0x8664);
+        Put<uint16_t>(image, FileHeader + 2, SectionCount);
+        Put<uint32_t>(image, FileHeader + 4, timeDateStamp);
+        Put<uint16_t>(image, FileHeader + 16, static_cast<uint16_t>(OptionalSize));
+        Put<uint16_t>(image, Optional, 0x20B);
+        Put<uint32_t>(image, Optional + 56, 0x6A00000);    // SizeOfImage
+        Put<uint32_t>(image, Optional + 60, 0x400);        // SizeOfHeaders
+
+        const struct { const char* name; uint32_t rva, size; } sections[SectionCount] = {
+            { ".text", 0x1000, 0x2C00000 },
+            { ".data", 0x3900000, 0x3000000 },
+        };
+        for (uint16_t i = 0; i < SectionCount; i++) {
+            size_t hdr = Sections + i * PE::SectionHeaderSize;
+            memcpy(image.data() + hdr, sections[i].name, strlen(sections[i].name));
+            Put<uint32_t>(image, hdr + 8, sections[i].size);
+            Put<uint32_t>(image, hdr + 12, sections[i].rva);
+            Put<uint32_t>(image, hdr + 16, sections[i].size);
+            Put<uint32_t>(image, hdr + 20, sections[i].rva);
+        }
+        return image;
+    }
+
+    bool Fingerprint(const std::vector<uint8_t>& image, OffsetCache::Fingerprint& fp, int count = Sites::Count)
+    {
+        return OffsetCache::ComputeFingerprint(image.data(), image.size(), Sites::Table, count, fp);
+    }
+
+    std::vector<uint8_t> ReadAll(const char* path)
+    {
+        std::vector<uint8_t> bytes;
+        if (FILE* f = fopen(path, "rb")) {
+            uint8_t buffer[4096];
+            size_t n;
+            while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) bytes.insert(bytes.end(), buffer, buffer + n);
+            fclose(f);
+        }
+        return bytes;
+    }
+
+    void WriteAll(const char* path, const std::vector<uint8_t>& bytes)
+    {
+        if (FILE* f = fopen(path, "wb")) {
+            fwrite(bytes.data(), 1, bytes.size(), f);
+            fclose(f);
+        }
+    }
+
+    // Loads into a sentinel-filled array: only Ok may write it
+    OffsetCache::Status Load(const char* path, const OffsetCache::Fingerprint& fp, bool* touched)
+    {
+        uint32_t rvas[Sites::Count];
+        for (uint32_t& r : rvas) r = 0xDEADBEEF;
+        OffsetCache::Status status = OffsetCache::Load(path, fp, rvas, Sites::Count);
+        *touched = false;
+        for (uint32_t r : rvas) *touched |= r != 0xDEADBEEF;
+        return status;
+    }
+
+    void Expect(const char* path, const OffsetCache::Fingerprint& fp, OffsetCache::Status want, const char* what)
+    {
+        bool touched = false;
+        OffsetCache::Status got = Load(path, fp, &touched);
+        printf("  %-40s %s\n", what, OffsetCache::StatusName(got));
+        Check(got == want, what, OffsetCache::StatusName(got));
+        if (want != OffsetCache::Status::Ok) Check(!touched, "RVAs written without a hit", what);
+    }
+
+    void CheckFingerprint()
+    {
+        OffsetCache::Fingerprint fp;
+        std::vector<uint8_t> image = SyntheticImage(0x5F000000);
+        Check(Fingerprint(image, fp), "synthetic image fingerprints");
+
+        std::vector<uint8_t> notPe = image;
+        Put<uint16_t>(notPe, Optional, 0x10B);
+        Check(!Fingerprint(notPe, fp), "PE32 header fingerprinted");
+
+        std::vector<uint8_t> cut(image.begin(), image.begin() + Sections + PE::SectionHeaderSize);
+        Check(!Fingerprint(cut, fp), "cut-off section table fingerprinted");
+    }
+
+    void CheckCache(const char* path)
+    {
+        using OffsetCache::Status;
+        std::vector<uint8_t> image = SyntheticImage(0x5F000000);
+        OffsetCache::Fingerprint fp;
+        Fingerprint(image, fp);
+
+        SigScan::Resolution sites[Sites::Count];
+        for (size_t i = 0; i < Sites::Count; i++) {
+            // Every other site unresolved: 0 is cached as "not found" too
+            if (i % 2 == 0) sites[i].rva = 0x1000 + i * 0x111;
+        }
+
+        remove(path);
+        Expect(path, fp, Status::Missing, "no file");
+
+        Check(OffsetCache::Save(path, fp, sites, Sites::Count), "Save");
+        uint32_t rvas[Sites::Count] = {};
+        Status status = OffsetCache::Load(path, fp, rvas, Sites::Count);
+        printf("  %-40s %s\n", "saved under the same fingerprint", OffsetCache::StatusName(status));
+        Check(status == Status::Ok, "hit after Save");
+        for (size_t i = 0; i < Sites::Count; i++) Check(rvas[i] == sites[i].rva, "cached RVA", Sites::Table[i].name);
+
+        // A game update or an edited site table
+        OffsetCache::Fingerprint other;
+        Fingerprint(SyntheticImage(0x5F000001), other);
+        Expect(path, other, Status::Stale, "PE timestamp changed");
+
+        std::vector<uint8_t> grown = image;
+        Put<uint32_t>(grown, Optional + 56, 0x6B00000);
+        Fingerprint(grown, other);
+        Expect(path, other, Status::Stale, "image size changed");
+
+        std::vector<uint8_t> moved = image;
+        Put<uint32_t>(moved, Sections + PE::SectionHeaderSize + 12, 0x3910000);
+        Fingerprint(moved, other);
+        Expect(path, other, Status::Stale, "section header changed");
+
+        Fingerprint(image, other, Sites::Count - 1);
+        Expect(path, other, Status::Stale, "site table changed");
+
+        // Damaged files
+        const std::vector<uint8_t> good = ReadAll(path);
+        Check(good.size() == sizeof(OffsetCache::Header) + Sites::Count * sizeof(uint32_t), "file size");
+
+        auto damaged = [&](const char* what, auto&& damage) {
+            std::vector<uint8_t> bytes = good;
+            damage(bytes);
+            WriteAll(path, bytes);
+            Expect(path, fp, Status::Corrupt, what);
+        };
+        damaged("truncated entries", [](std::vector<uint8_t>& b) { b.resize(b.size() - 2); });
+        damaged("truncated header", [](std::vector<uint8_t>& b) { b.resize(sizeof(OffsetCache::Header) - 1); });
+        damaged("trailing bytes", [](std::vector<uint8_t>& b) { b.push_back(0); });
+        damaged("entry bit flipped", [](std::vector<uint8_t>& b) { b[sizeof(OffsetCache::Header) + 1] ^= 0x10; });
+        damaged("checksum bit flipped", [](std::vector<uint8_t>& b) { b[offsetof(OffsetCache::Header, checksum)] ^= 1; });
+        damaged("wrong magic", [](std::vector<uint8_t>& b) { b[0] ^= 0xFF; });
+        damaged("wrong version", [](std::vector<uint8_t>& b) { b[offsetof(OffsetCache::Header, version)]++; });
+
+        // An empty file cannot be mapped: it reads as no cache at all
+        WriteAll(path, {});
+        Expect(path, fp, Status::Missing, "empty file");
+
+        // The preloader rewrites the cache after a miss: it hits again
+        WriteAll(path, good);
+        Expect(path, fp, Status::Ok, "restored file");
+        Fingerprint(SyntheticImage(0x5F000001), other);
+        Check(OffsetCache::Save(path, other, sites, Sites::Count), "Save under a new fingerprint");
+        status = OffsetCache::Load(path, other, rvas, Sites::Count);
+        printf("  %-40s %s\n", "rewritten after the update", OffsetCache::StatusName(status));
+        Check(status == Status::Ok, "hit after rewrite");
+        Expect(path, fp, Status::Stale, "old fingerprint after rewrite");
+
+        remove(path);
+    }
+}
+
+int main(int argc, char**)
+{
+    if (argc > 1) {
+        fprintf(stderr, "usage: offset_cache_check\n");
+        return 2;
+    }
+
+    const char* path = "offset_cache_check.offsets";
+    CheckFingerprint();
+    printf("%s (%d sites):\n", path, Sites::Count);
+    CheckCache(path);
+
+    return Report();
+}
@@ -0,0 +1,146 @@
+// =============================================================================
+// proxy_gen - generate the proxy export list from version.def
+//
+//   proxy_gen <version.def> <out_dir>
+//
+// Writes <out_dir>/proxy_exports.h, an X-macro list of the exports
+// (PROXY_EXPORTS(X) expands X(index, name) per export), and
+// <out_dir>/version_thunks.def, the linker .def exporting each name as its
+// ProxyThunk_ symbol. Files are only rewritten when their content changes.
+// Run by the build; see src/proxy_thunks.h.
+// =============================================================================
+
+#include "proxy_thunks.h"
+
+#include <cctype>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace CascadePatch;
+
+namespace
+{
+    bool ReadFile(const std::string& path, std::string& out)
+    {
+        FILE* f = fopen(path.c_str(), "rb");
+        if (!f) return false;
+        char buf[4096];
+        size_t n;
+        while ((n = fread(buf, 1, sizeof(buf), f)) > 0) out.append(buf, n);
+        fclose(f);
+        return true;
+    }
+
+    bool WriteIfChanged(const std::string& path, const std::string& content)
+    {
+        std::string existing;
+        if (ReadFile(path, existing) && existing == content) return true;
+
+        FILE* f = fopen(path.c_str(), "wb");
+        if (!f) return false;
+        bool ok = fwrite(content.data(), 1, content.size(), f) == content.size();
+        return fclose(f) == 0 && ok;
+    }
+
+    bool IsIdentifier(const std::string& s)
+    {
+        if (s.empty() || isdigit(static_cast<unsigned char>(s[0]))) return false;
+        for (char c : s) {
+            if (!isalnum(static_cast<unsigned char>(c)) && c != '_') return false;
+        }
+        return true;
+    }
+
+    // Names from the EXPORTS section; ordinals, aliases and keywords are
+    // rejected since the generated .def assigns its own
+    bool ParseDef(const std::string& text, std::string& library, std::vector<std::string>& names)
+    {
+        bool inExports = false;
+        size_t lineNo = 0;
+        for (size_t pos = 0; pos < text.size();) {
+            size_t end = text.find('\n', pos);
+            if (end == std::string::npos) end = text.size();
+            std::string line = text.substr(pos, end - pos);
+            pos = end + 1;
+            lineNo++;
+
+            size_t comment = line.find(';');
+            if (comment != std::string::npos) line.resize(comment);
+            std::vector<std::string> tokens;
+            for (size_t i = 0; i < line.size();) {
+                while (i < line.size() && isspace(static_cast<unsigned char>(line[i]))) i++;
+                size_t start = i;
+                while (i < line.size() && !isspace(static_cast<unsigned char>(line[i]))) i++;
+                if (i > start) tokens.push_back(line.substr(start, i - start));
+            }
+            if (tokens.empty()) continue;
+
+            if (tokens[0] == "LIBRARY") {
+                if (tokens.size() > 1) library = tokens[1];
+                inExports = false;
+            } else if (tokens[0] == "EXPORTS") {
+                inExports = true;
+            } else if (inExports) {
+                if (tokens.size() != 1 || !IsIdentifier(tokens[0])) {
+                    fprintf(stderr, "line %zu: expected a plain export name\n", lineNo);
+                    return false;
+                }
+                for (const std::string& n : names) {
+                    if (n == tokens[0]) {
+                        fprintf(stderr, "line %zu: duplicate export %s\n", lineNo, n.c_str());
+                        return false;
+                    }
+                }
+                names.push_back(tokens[0]);
+            }
+        }
+        return true;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: proxy_gen <version.def> <out_dir>\n");
+        return 2;
+    }
+
+    std::string text, library = "version";
+    std::vector<std::string> names;
+    if (!ReadFile(argv[1], text)) {
+        fprintf(stderr, "cannot read %s\n", argv[1]);
+        return 1;
+    }
+    if (!ParseDef(text, library, names)) return 1;
+    if (names.empty() || names.size() > Thunks::MaxExports) {
+        fprintf(stderr, "%zu exports (1..%zu supported)\n", names.size(), Thunks::MaxExports);
+        return 1;
+    }
+
+    std::string header =
+        "#pragma once\n"
+        "\n"
+        "// Generated by proxy_gen from version.def - do not edit\n"
+        "\n"
+        "#define PROXY_EXPORT_COUNT " + std::to_string(names.size()) + "\n"
+        "\n"
+        "#define PROXY_EXPORTS(X) \\\n";
+    for (size_t i = 0; i < names.size(); i++) {
+        header += "    X(" + std::to_string(i) + ", " + names[i] + ")";
+        header += (i + 1 < names.size()) ? " \\\n" : "\n";
+    }
+
+    std::string def = "; Generated by proxy_gen from version.def - do not edit\n"
+                      "LIBRARY " + library + "\n"
+                      "EXPORTS\n";
+    for (const std::string& n : names) def += "    " + n + " = ProxyThunk_" + n + "\n";
+
+    std::string dir = argv[2];
+    if (!WriteIfChanged(dir + "/proxy_exports.h", header) || !WriteIfChanged(dir + "/version_thunks.def", def)) {
+        fprintf(stderr, "cannot write to %s\n", argv[2]);
+        return 1;
+    }
+    printf("proxy_gen: %zu exports\n", names.size());
+    return 0;
+}
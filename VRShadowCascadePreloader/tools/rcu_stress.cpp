@@ -0,0 +1,195 @@
+// =============================================================================
+// rcu_stress - RcuCell readers against a publishing writer
+//
+//   rcu_stress [--readers N] [--ms N] [--bench]
+//
+// Readers take snapshots in a loop while a writer publishes new ones as fast
+// as it can. It stands in for ShadowBoost::update on the render thread racing
+// the MCM reload thread. Every snapshot is filled from its generation number,
+// so a reader notices a torn or freed snapshot (the fields disagree) and a
+// generation going backwards. After the run nothing may stay retired, and
+// every snapshot ever allocated must be freed. The rcu_stress_tsan target is
+// the same program built with -fsanitize=thread.
+// --bench times Read() against a plain pointer load and a mutex-guarded
+// shared_ptr copy, with the writer idle and publishing every millisecond.
+// =============================================================================
+
+#include "check.h"
+#include "rcu_cell.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    std::atomic<int64_t> live{ 0 };
+
+    // Shaped like the plugin's config: min/max pairs that must come from one version
+    struct Values
+    {
+        uint64_t generation = 0;
+        float    min = 0.0f;
+        float    max = 1.0f;
+        uint64_t fill[24] = {};
+
+        Values() { live.fetch_add(1, std::memory_order_relaxed); }
+        explicit Values(uint64_t g) : generation(g), min(float(g % 1000)), max(float(g % 1000) + 1.0f)
+        {
+            for (uint64_t& f : fill) f = g;
+            live.fetch_add(1, std::memory_order_relaxed);
+        }
+        Values(const Values& o) : generation(o.generation), min(o.min), max(o.max)
+        {
+            memcpy(fill, o.fill, sizeof(fill));
+            live.fetch_add(1, std::memory_order_relaxed);
+        }
+        Values(Values&& o) noexcept : Values(static_cast<const Values&>(o)) {}
+        ~Values() { live.fetch_sub(1, std::memory_order_relaxed); }
+
+        bool Consistent() const
+        {
+            if (max != min + 1.0f || min != float(generation % 1000)) return false;
+            for (uint64_t f : fill)
+                if (f != generation) return false;
+            return true;
+        }
+    };
+
+    using Cell = RcuCell<Values, 8>;
+
+    void Stress(int readers, int ms)
+    {
+        {
+            Cell cell{ Values(0) };
+            std::atomic<bool> stop{ false };
+            std::atomic<uint64_t> reads{ 0 }, torn{ 0 }, backwards{ 0 }, nestedMismatch{ 0 };
+
+            std::vector<std::thread> threads;
+            for (int r = 0; r < readers; r++) {
+                threads.emplace_back([&] {
+                    int slot = cell.RegisterReader();
+                    uint64_t last = 0, n = 0;
+                    while (!stop.load(std::memory_order_relaxed)) {
+                        auto snapshot = cell.Read(slot);
+                        if (!snapshot->Consistent()) torn.fetch_add(1, std::memory_order_relaxed);
+                        if (snapshot->generation < last) backwards.fetch_add(1, std::memory_order_relaxed);
+                        last = snapshot->generation;
+                        if ((n & 63) == 0) {
+                            auto nested = cell.Read(slot);
+                            if (nested.Get() != snapshot.Get()) nestedMismatch.fetch_add(1, std::memory_order_relaxed);
+                        }
+                        n++;
+                    }
+                    cell.ReleaseReader(slot);
+                    reads.fetch_add(n, std::memory_order_relaxed);
+                });
+            }
+
+            uint64_t published = 0;
+            auto end = Clock::now() + std::chrono::milliseconds(ms);
+            while (Clock::now() < end) cell.Publish(Values(++published));
+            stop.store(true);
+            for (auto& t : threads) t.join();
+            size_t retired = cell.Reclaim();
+
+            printf("%d readers, %d ms: %llu snapshots published, %llu reads\n", readers, ms,
+                   static_cast<unsigned long long>(published), static_cast<unsigned long long>(reads.load()));
+            printf("  torn %llu, backwards %llu, nested mismatch %llu, retired after the run %zu\n",
+                   static_cast<unsigned long long>(torn.load()), static_cast<unsigned long long>(backwards.load()),
+                   static_cast<unsigned long long>(nestedMismatch.load()), retired);
+            Check(torn == 0, "reader saw a torn or freed snapshot");
+            Check(backwards == 0, "reader saw an older snapshot after a newer one");
+            Check(nestedMismatch == 0, "nested read returned another snapshot");
+            Check(retired == 0, "snapshots left retired with no reader");
+            Check(live.load() == 1, "snapshots leaked or freed twice");
+            Check(cell.Version() == published, "version does not count publishes");
+        }
+        Check(live.load() == 0, "cell destructor leaked a snapshot");
+    }
+
+    template <typename Fn>
+    double TimeReads(Fn&& read, bool publishing, Cell& cell)
+    {
+        std::atomic<bool> stop{ false };
+        std::thread writer;
+        if (publishing) {
+            writer = std::thread([&] {
+                uint64_t g = 1000000;
+                while (!stop.load()) {
+                    cell.Publish(Values(++g));
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            });
+        }
+        const int n = 5000000;
+        uint64_t sink = 0;
+        auto t0 = Clock::now();
+        for (int i = 0; i < n; i++) sink += read();
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+        stop.store(true);
+        if (writer.joinable()) writer.join();
+        if (sink == 42) printf(" ");
+        return ns;
+    }
+
+    void Bench()
+    {
+        Cell cell{ Values(1) };
+        int slot = cell.RegisterReader();
+        std::atomic<const Values*> plain{ new Values(1) };
+        std::mutex lock;
+        auto shared = std::make_shared<const Values>(1);
+
+        auto rcu = [&] { return cell.Read(slot)->generation; };
+        auto raw = [&] { return plain.load(std::memory_order_acquire)->generation; };
+        auto mutexCopy = [&] {
+            std::shared_ptr<const Values> p;
+            {
+                std::lock_guard guard(lock);
+                p = shared;
+            }
+            return p->generation;
+        };
+
+        printf("\nread cost, ns per snapshot (writer idle / publishing every 1 ms):\n");
+        printf("  RcuCell::Read          %6.1f %6.1f\n", TimeReads(rcu, false, cell), TimeReads(rcu, true, cell));
+        printf("  atomic pointer load    %6.1f %6.1f\n", TimeReads(raw, false, cell), TimeReads(raw, true, cell));
+        printf("  mutex + shared_ptr     %6.1f %6.1f\n", TimeReads(mutexCopy, false, cell),
+               TimeReads(mutexCopy, true, cell));
+        delete plain.load();
+        cell.ReleaseReader(slot);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int readers = 3, ms = 2000;
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--readers") && i + 1 < argc) readers = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--ms") && i + 1 < argc) ms = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--bench")) bench = true;
+        else {
+            fprintf(stderr, "usage: rcu_stress [--readers N] [--ms N] [--bench]\n");
+            return 2;
+        }
+    }
+
+    Stress(std::clamp(readers, 1, 8), std::max(ms, 1));
+    if (bench) Bench();
+
+    return Report();
+}
@@ -0,0 +1,171 @@
+// =============================================================================
+// resolve_sites - run the preloader's site resolver outside the game
+//
+//   resolve_sites <dump.exe> [--scan] [--scalar] [--threads N] [--repeat N] [--cache FILE]
+//   resolve_sites --synthetic <MB> [--scalar] [--threads N] [--repeat N]
+//
+// <dump.exe> must be a decrypted image (e.g. dumped from a running process);
+// the SteamStub-encrypted .text on disk will not match anything.
+// --scan ignores the 1.2.72 hints so every pattern is scanned, which is what
+// the throughput figure should be tracked with. --synthetic builds a random
+// .text of the given size (no sites) to measure raw scan throughput.
+// --cache uses FILE as the offset cache exactly like the preloader does with
+// VRShadowCascade.offsets: read if the fingerprint matches, rewritten if not.
+// Each resolved site is also checked to sit on an instruction boundary of its
+// function, decoding from the function entry as the preloader does.
+// =============================================================================
+
+#include "cascade_sites.h"
+#include "offset_cache.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace CascadePatch;
+
+static bool ReadFile(const char* path, std::vector<uint8_t>& out)
+{
+    FILE* f = fopen(path, "rb");
+    if (!f) return false;
+    fseek(f, 0, SEEK_END);
+    long size = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    out.resize(size > 0 ? static_cast<size_t>(size) : 0);
+    size_t n = out.empty() ? 0 : fread(out.data(), 1, out.size(), f);
+    fclose(f);
+    return n == out.size();
+}
+
+static int Usage()
+{
+    fprintf(stderr,
+        "usage: resolve_sites <dump.exe> [--scan] [--scalar] [--threads N] [--repeat N] [--cache FILE]\n"
+        "       resolve_sites --synthetic <MB> [--scalar] [--threads N] [--repeat N]\n");
+    return 2;
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) return Usage();
+
+    const char* path = nullptr;
+    const char* cachePath = nullptr;
+    size_t syntheticMB = 0;
+    int repeat = 1;
+    SigScan::ScanOptions options;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--scan")) options.forceScan = true;
+        else if (!strcmp(argv[i], "--scalar")) options.allowAvx2 = false;
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) options.threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--repeat") && i + 1 < argc) repeat = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--cache") && i + 1 < argc) cachePath = argv[++i];
+        else if (!strcmp(argv[i], "--synthetic") && i + 1 < argc) syntheticMB = strtoul(argv[++i], nullptr, 10);
+        else if (argv[i][0] == '-') return Usage();
+        else path = argv[i];
+    }
+    if (!path && syntheticMB == 0) return Usage();
+    if (repeat < 1) repeat = 1;
+
+    std::vector<uint8_t> image;
+    PE::Section text;
+
+    if (syntheticMB) {
+        // Headerless image: .text starts at RVA 0x1000, filled with random bytes
+        constexpr uint32_t TextRVA = 0x1000;
+        text.rva = TextRVA;
+        text.virtualSize = static_cast<uint32_t>(syntheticMB << 20);
+        image.resize(TextRVA + text.virtualSize);
+        std::mt19937_64 rng(0x5EED);
+        for (size_t i = TextRVA; i + 8 <= image.size(); i += 8) {
+            uint64_t v = rng();
+            memcpy(image.data() + i, &v, 8);
+        }
+        options.forceScan = true;
+    } else {
+        std::vector<uint8_t> file;
+        if (!ReadFile(path, file)) {
+            fprintf(stderr, "cannot read %s\n", path);
+            return 1;
+        }
+        if (!PE::MapFileImage(file.data(), file.size(), image) ||
+            !PE::FindSection(image.data(), image.size(), ".text", text)) {
+            fprintf(stderr, "%s is not a PE32+ image with a .text section\n", path);
+            return 1;
+        }
+    }
+
+    OffsetCache::Fingerprint fingerprint;
+    uint32_t cached[Sites::Count] = {};
+    bool cacheHit = false;
+    if (cachePath) {
+        if (syntheticMB || !OffsetCache::ComputeFingerprint(image.data(), image.size(),
+                                                            Sites::Table, Sites::Count, fingerprint)) {
+            fprintf(stderr, "--cache needs a PE image, ignored\n");
+            cachePath = nullptr;
+        } else {
+            OffsetCache::Status status = OffsetCache::Load(cachePath, fingerprint, cached, Sites::Count);
+            cacheHit = (status == OffsetCache::Status::Ok);
+            if (cacheHit) options.cachedRVAs = cached;
+            printf("offset cache %s: %s\n", cachePath, OffsetCache::StatusName(status));
+        }
+    }
+
+    SigScan::Resolution results[Sites::Count];
+    SigScan::ScanStats stats;
+    double totalMs = 0.0;
+    size_t totalBytes = 0;
+    for (int r = 0; r < repeat; r++) {
+        SigScan::ResolveAll(image.data(), image.size(), text, Sites::Table, Sites::Count,
+                            results, options, &stats);
+        totalMs += stats.elapsedMs;
+        totalBytes += stats.bytesScanned;
+    }
+
+    if (!syntheticMB) {
+        int resolved = 0;
+        for (size_t i = 0; i < Sites::Count; i++) {
+            const SigScan::Signature& sig = Sites::Table[i];
+            const SigScan::Resolution& res = results[i];
+            if (res.rva) resolved++;
+            printf("%-40s 0x%08X  %-10s hint 0x%08X%s  hits=%u\n",
+                sig.name, (uint32_t)res.rva, SigScan::SourceName(res.from), (uint32_t)sig.hintRVA,
+                (res.rva && res.rva != sig.hintRVA) ? " (moved)" : "", res.hits);
+        }
+        printf("%d/%d sites resolved (%u cached, %u at hint)\n", resolved, (int)Sites::Count,
+            stats.cacheHits, stats.hintHits);
+
+        X64::Location where[Sites::FunctionCount];
+        uint32_t misplaced = Sites::CheckBoundaries(image.data(), text, results, where);
+        for (size_t i = 0; i < Sites::FunctionCount; i++) {
+            const Sites::SiteFunction& f = Sites::Functions[i];
+            uintptr_t rva = results[f.site].rva;
+            if (!rva) continue;
+            printf("  %-38s entry 0x%08X  %4u insns  %s\n", Sites::Table[f.site].name,
+                (uint32_t)Sites::FunctionEntry(f, rva), where[i].instructions,
+                where[i].ok ? "on boundary" : "NOT ON BOUNDARY");
+        }
+        printf("instruction boundaries: %u misplaced\n", misplaced);
+    }
+
+    if (cachePath) {
+        bool changed = !cacheHit;
+        for (size_t i = 0; i < Sites::Count; i++) {
+            if (results[i].rva != cached[i]) changed = true;
+        }
+        if (changed && !options.forceScan) {
+            bool ok = OffsetCache::Save(cachePath, fingerprint, results, Sites::Count);
+            printf("offset cache %s\n", ok ? "written" : "write FAILED");
+        }
+    }
+
+    double avgMs = totalMs / repeat;
+    double gbps = totalMs > 0.0 ? (totalBytes / (totalMs / 1000.0)) / 1e9 : 0.0;
+    printf(".text %.1f MB, %u patterns, %s, %u threads: %.3f ms/resolve, %.2f GB/s\n",
+        text.virtualSize / (1024.0 * 1024.0), stats.patternsScanned,
+        stats.usedAvx2 ? "AVX2" : "scalar", stats.threads, avgMs, gbps);
+    return 0;
+}
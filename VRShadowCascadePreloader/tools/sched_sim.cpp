@@ -0,0 +1,455 @@
+// =============================================================================
+// sched_sim - run the preloader's staging graph against a simulated game
+//
+//   sched_sim [--seeds N] [--verbose] [--no-hook]
+//   sched_sim --bench [--iterations N]
+//   sched_sim --threads N
+//
+// Each seed builds a game whose readiness points (SteamStub decryption, VR
+// array, scene nodes, shader, flat shadow maps, .data distance) land at
+// random times, with flaky steps (stereo fix, safety caves) failing a random
+// number of times. Exports arrive in bursts the way version.dll calls do and
+// the timer is re-armed from NextDue() exactly like the preloader does. The
+// engine's SetShadowSceneNode call polls the Hook lane when the detour is in
+// (--no-hook simulates an image it cannot be installed on). Every
+// run is checked for ordering: no step before its prerequisites or before
+// the game state it touches exists, timer-only steps never on an export,
+// the full mask never before the safety caves. The step attempts are
+// compared with the old fixed 500 ms timer that called everything each tick.
+// --bench times Poll() itself; --threads polls one scheduler from N threads
+// and checks that hooks never overlap and each step completes once.
+// =============================================================================
+
+#include "cascade_steps.h"
+#include "check.h"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+namespace
+{
+    // ---- Simulated game memory ----
+    struct Game
+    {
+        uint64_t now = 0;
+        uint8_t lane = 0;                   // lane currently polling
+
+        // When each piece of game state becomes valid
+        uint64_t decryptAt, vrArrayAt, renderNodeAt, shaderAt, flatMapsAt, distanceAt;
+        int stereoFailures, caveFailures;
+
+        // State the steps write
+        uint32_t countGlobal = 2;
+        bool sitesResolved = false, startupPatched = false, stereoFixed = false;
+        bool distanceWritten = false, vrExpanded = false, timerRunning = false;
+        bool setupNode = false, groupsForced = false, shaderForced = false;
+        bool flatPrepared = false, cavesLive = false, maskRestored = false, diagnostics = false;
+        bool hookAvailable = true, hookInstalled = false, nodeSeen = false, nodeCalled = false;
+        uint64_t timerDue = Sched::Never;
+
+        std::vector<const char*> violations;
+        uint32_t attempts = 0;
+
+        bool At(uint64_t t) const { return now >= t; }
+        void Expect(bool ok, const char* what)
+        {
+            if (!ok) violations.push_back(what);
+        }
+    };
+
+    Game& G(void* c) { return *static_cast<Game*>(c); }
+
+    template <bool (*Fn)(Game&)>
+    bool Hook(void* c)
+    {
+        G(c).attempts++;
+        return Fn(G(c));
+    }
+
+    bool ForceCount(Game& g) { g.countGlobal = 4; return true; }
+    bool ProbeDecrypted(Game& g) { return g.At(g.decryptAt); }
+    bool Resolve(Game& g)
+    {
+        g.Expect(g.At(g.decryptAt), "sites resolved before decryption");
+        g.sitesResolved = true;
+        return true;
+    }
+    bool Startup(Game& g)
+    {
+        g.Expect(g.sitesResolved, "startup batch before site resolution");
+        g.startupPatched = true;
+        return true;
+    }
+    bool Stereo(Game& g)
+    {
+        g.Expect(g.startupPatched, "stereo retry before startup batch");
+        if (g.stereoFailures > 0) { g.stereoFailures--; return false; }
+        return g.stereoFixed = true;
+    }
+    bool Distance(Game& g)
+    {
+        g.Expect(g.sitesResolved, ".data distance written before decryption");
+        if (!g.At(g.distanceAt)) return false;
+        return g.distanceWritten = true;
+    }
+    bool Expand(Game& g)
+    {
+        if (!g.At(g.vrArrayAt)) return false;
+        return g.vrExpanded = true;
+    }
+    bool StartTimer(Game& g)
+    {
+        g.Expect(g.startupPatched, "timer started before safe mode");
+        g.timerRunning = true;
+        g.timerDue = g.now + Steps::TimerStartMs;
+        return true;
+    }
+    bool InstallHook(Game& g)
+    {
+        g.Expect(g.startupPatched, "detour installed before the startup batch");
+        if (!g.hookAvailable) return true;
+        g.hookInstalled = true;
+        // The engine already set the node: the call was missed, the global is read instead
+        if (g.At(g.renderNodeAt)) g.nodeSeen = g.nodeCalled = true;
+        return true;
+    }
+    bool ProbeNode(Game& g) { return !g.hookInstalled || g.nodeSeen; }
+    bool SetupNode(Game& g)
+    {
+        g.Expect(g.lane != Steps::Export, "setup scene node fixed from an export");
+        if (!g.At(g.renderNodeAt)) return false;
+        return g.setupNode = true;
+    }
+    bool Groups(Game& g)
+    {
+        g.Expect(g.setupNode, "cascade groups forced before setup node");
+        if (!g.At(g.renderNodeAt)) return false;
+        return g.groupsForced = true;
+    }
+    bool Shader(Game& g)
+    {
+        g.Expect(g.lane != Steps::Export, "shader fields forced from an export");
+        if (!g.At(g.shaderAt)) return false;
+        return g.shaderForced = true;
+    }
+    bool ProbeFlat(Game& g) { return g.At(g.flatMapsAt) && g.At(g.renderNodeAt); }
+    bool PrepareFlat(Game& g)
+    {
+        g.Expect(g.vrExpanded && g.startupPatched, "flat array prepared before VR array / safe mode");
+        return g.flatPrepared = true;
+    }
+    bool Caves(Game& g)
+    {
+        g.Expect(g.flatPrepared, "caves before flat array");
+        if (g.caveFailures > 0) { g.caveFailures--; return false; }
+        return g.cavesLive = true;
+    }
+    bool Mask(Game& g)
+    {
+        g.Expect(g.cavesLive, "full mask before safety caves");
+        return g.maskRestored = true;
+    }
+    bool Diagnostics(Game& g)
+    {
+        g.Expect(g.maskRestored && g.groupsForced && g.shaderForced, "diagnostics before activation");
+        return g.diagnostics = true;
+    }
+
+    constexpr Sched::Hooks SimHooks[Steps::Count] = {
+        { nullptr,               Hook<ForceCount> },
+        { Hook<ProbeDecrypted>,  Hook<Resolve> },
+        { nullptr,               Hook<Startup> },
+        { nullptr,               Hook<Stereo> },
+        { nullptr,               Hook<Distance> },
+        { nullptr,               Hook<Expand> },
+        { nullptr,               Hook<StartTimer> },
+        { nullptr,               Hook<InstallHook> },
+        { Hook<ProbeNode>,       Hook<SetupNode> },
+        { nullptr,               Hook<Groups> },
+        { nullptr,               Hook<Shader> },
+        { Hook<ProbeFlat>,       Hook<PrepareFlat> },
+        { nullptr,               Hook<Caves> },
+        { nullptr,               Hook<Mask> },
+        { nullptr,               Hook<Diagnostics> },
+    };
+
+    Game RandomGame(std::mt19937_64& rng)
+    {
+        auto between = [&](uint64_t lo, uint64_t hi) { return lo + rng() % (hi - lo + 1); };
+        Game g;
+        g.decryptAt = between(50, 800);
+        g.distanceAt = g.decryptAt + between(0, 3000);
+        g.vrArrayAt = between(1000, 20000);
+        g.renderNodeAt = g.vrArrayAt + between(0, 10000);
+        g.shaderAt = g.renderNodeAt + between(0, 5000);
+        g.flatMapsAt = g.renderNodeAt + between(0, 30000);
+        g.stereoFailures = static_cast<int>(rng() % 3);
+        g.caveFailures = static_cast<int>(rng() % 3);
+        return g;
+    }
+
+    // Old staging: every export ran the whole ladder until the timer started,
+    // then a fixed 500 ms timer called every step until diagnostics ran
+    uint64_t FixedTimerAttempts(const Game& g, uint64_t timerStart, uint64_t exports)
+    {
+        uint64_t attempts = exports * 8;    // ladder length before the timer
+        uint64_t active = std::max(std::max(g.flatMapsAt, g.shaderAt), timerStart + 2000);
+        uint64_t end = std::max(active + 5000, timerStart + 2000 + 30 * 500);
+        attempts += ((end - timerStart) / 500) * 6;
+        return attempts;
+    }
+
+    struct RunResult
+    {
+        bool ok;
+        uint64_t activeAt, endAt, exports, timerTicks, attempts, baseline, nodeLate;
+    };
+
+    RunResult Simulate(uint64_t seed, bool verbose, bool hook)
+    {
+        std::mt19937_64 rng(seed);
+        Game game = RandomGame(rng);
+        game.hookAvailable = hook;
+        StepScheduler steps;
+        steps.Init(Steps::Table, SimHooks, Steps::Count, &game);
+
+        RunResult r{};
+        uint64_t nextExport = 0, timerStart = 0;
+        const uint64_t horizon = 120000;
+
+        while (game.now < horizon && !steps.AllDone()) {
+            // Next event: an export call (while exports still poll), the
+            // engine setting the render node through the detour, or the timer
+            bool exportsPoll = !steps.Done(Steps::StartTimer);
+            bool nodeCall = game.hookInstalled && !game.nodeCalled;
+            uint64_t next = game.timerRunning ? game.timerDue : Sched::Never;
+            if (exportsPoll && nextExport < next) next = nextExport;
+            if (nodeCall && game.renderNodeAt < next) next = game.renderNodeAt;
+            if (next == Sched::Never || next >= horizon) break;
+            game.now = next;
+
+            if (nodeCall && next == game.renderNodeAt) {
+                game.nodeSeen = game.nodeCalled = true;
+                steps.Wake(Sched::Bit(Steps::SetupSceneNode));
+                game.lane = Steps::Hook;
+                steps.Poll(game.now, Steps::Hook);
+                continue;
+            }
+
+            if (exportsPoll && next == nextExport) {
+                game.lane = Steps::Export;
+                steps.Poll(game.now, Steps::Export);
+                r.exports++;
+                // version.dll exports come in bursts during startup
+                nextExport = game.now + ((rng() % 4) ? rng() % 20 : 200 + rng() % 2000);
+                if (steps.Done(Steps::StartTimer) && timerStart == 0) timerStart = game.now;
+                continue;
+            }
+
+            game.lane = Steps::Timer;
+            steps.Poll(game.now, Steps::Timer);
+            r.timerTicks++;
+            uint64_t due = steps.NextDue(Steps::Timer);
+            if (due == Sched::Never) {
+                game.timerRunning = false;
+                game.timerDue = Sched::Never;
+                continue;
+            }
+            uint64_t wait = due > game.now ? due - game.now : 0;
+            wait = std::clamp<uint64_t>(wait, Steps::TimerMinMs, Steps::TimerMaxMs);
+            game.timerDue = game.now + wait;
+        }
+
+        // Ordering: every step after its prerequisites
+        for (size_t id = 0; id < Steps::Count; id++) {
+            uint64_t at = steps.Stats(id).doneAtMs;
+            if (!at) {
+                game.violations.push_back("step never completed");
+                if (verbose) printf("  seed %llu: %s pending\n", (unsigned long long)seed, Steps::Table[id].name);
+                continue;
+            }
+            for (size_t dep = 0; dep < Steps::Count; dep++) {
+                if ((Steps::Table[id].after & Sched::Bit(dep)) && steps.Stats(dep).doneAtMs > at) {
+                    game.violations.push_back("step completed before a prerequisite");
+                }
+            }
+        }
+        if (game.countGlobal != 4) game.violations.push_back("count never forced");
+
+        r.ok = game.violations.empty();
+        r.activeAt = steps.Stats(Steps::MaskRestore).doneAtMs;
+        uint64_t nodeAt = steps.Stats(Steps::SetupSceneNode).doneAtMs;
+        r.nodeLate = nodeAt > game.renderNodeAt ? nodeAt - game.renderNodeAt : 0;
+        r.endAt = game.now;
+        r.attempts = game.attempts;
+        r.baseline = FixedTimerAttempts(game, timerStart, r.exports);
+
+        if (verbose || !r.ok) {
+            printf("seed %llu: decrypt %llu, vr %llu, node %llu, shader %llu, flat %llu -> active at %llu ms, "
+                   "%llu exports, %llu timer ticks, %llu attempts (fixed timer ~%llu)\n",
+                   (unsigned long long)seed, (unsigned long long)game.decryptAt,
+                   (unsigned long long)game.vrArrayAt, (unsigned long long)game.renderNodeAt,
+                   (unsigned long long)game.shaderAt, (unsigned long long)game.flatMapsAt,
+                   (unsigned long long)r.activeAt, (unsigned long long)r.exports,
+                   (unsigned long long)r.timerTicks, (unsigned long long)r.attempts,
+                   (unsigned long long)r.baseline);
+            for (const char* v : game.violations) Fail("seed %llu: %s", (unsigned long long)seed, v);
+        }
+        return r;
+    }
+
+    int RunSeeds(uint64_t seeds, bool verbose, bool hook)
+    {
+        uint64_t failed = 0, attempts = 0, baseline = 0, ticks = 0, lateMs = 0, nodeLateMs = 0;
+        for (uint64_t seed = 1; seed <= seeds; seed++) {
+            RunResult r = Simulate(seed, verbose, hook);
+            nodeLateMs += r.nodeLate;
+            if (!r.ok) failed++;
+            attempts += r.attempts;
+            baseline += r.baseline;
+            ticks += r.timerTicks;
+
+            // Activation latency past the moment the game was ready
+            std::mt19937_64 rng(seed);
+            Game g = RandomGame(rng);
+            uint64_t ready = std::max(std::max(g.flatMapsAt, g.vrArrayAt), g.decryptAt);
+            if (r.activeAt > ready) lateMs += r.activeAt - ready;
+        }
+        printf("%llu seeds: %llu ordering failures\n", (unsigned long long)seeds, (unsigned long long)failed);
+        printf("step attempts: %.1f per run (fixed 500 ms timer ~%.1f), %.1f timer ticks per run\n",
+               double(attempts) / seeds, double(baseline) / seeds, double(ticks) / seeds);
+        printf("activation latency after the game is ready: %.0f ms average\n", double(lateMs) / seeds);
+        printf("setup node fixed %.0f ms after the engine sets the render node (%s)\n", double(nodeLateMs) / seeds,
+               hook ? "SetShadowSceneNode detour" : "timer only");
+        return Report();
+    }
+
+    // ---- Concurrency: N threads polling one scheduler ----
+    std::atomic<int> g_inHook{ 0 };
+    std::atomic<int> g_overlaps{ 0 };
+    std::atomic<uint32_t> g_runs[Steps::Count];
+
+    template <size_t Id>
+    bool CountedRun(void*)
+    {
+        if (g_inHook.fetch_add(1) != 0) g_overlaps++;
+        std::this_thread::yield();
+        g_runs[Id]++;
+        g_inHook.fetch_sub(1);
+        return true;
+    }
+
+    template <size_t... I>
+    constexpr auto MakeCountedHooks(std::index_sequence<I...>)
+    {
+        return std::array<Sched::Hooks, sizeof...(I)>{ Sched::Hooks{ nullptr, CountedRun<I> }... };
+    }
+
+    int RunThreads(int threads)
+    {
+        static constexpr auto hooks = MakeCountedHooks(std::make_index_sequence<Steps::Count>{});
+        StepScheduler steps;
+        steps.Init(Steps::Table, hooks.data(), Steps::Count, nullptr);
+
+        std::atomic<uint64_t> clock{ 0 };
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++) {
+            pool.emplace_back([&, t] {
+                uint8_t lane = (t % 2) ? Steps::Timer : Steps::Export;
+                while (!steps.AllDone()) steps.Poll(clock.fetch_add(7), lane | Steps::Export);
+            });
+        }
+        for (std::thread& th : pool) th.join();
+
+        bool ok = g_overlaps.load() == 0;
+        for (size_t id = 0; id < Steps::Count; id++) ok = ok && g_runs[id].load() == 1;
+        printf("%d threads: %d overlapping hooks, every step ran once: %s\n",
+               threads, g_overlaps.load(), ok ? "yes" : "NO");
+        Check(ok, "hooks overlapped or a step did not run exactly once");
+        return Report();
+    }
+
+    // ---- Poll() cost ----
+    bool NotReady(void*) { return false; }
+
+    int RunBench(uint64_t iterations)
+    {
+        Sched::Hooks hooks[Steps::Count];
+        for (auto& h : hooks) h = { nullptr, NotReady };
+
+        auto time = [&](const char* label, StepScheduler& steps, uint8_t lane, uint64_t step) {
+            uint64_t now = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t i = 0; i < iterations; i++) steps.Poll(now += step, lane);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            printf("%-44s %6.1f ns/poll\n", label, ns / iterations);
+        };
+
+        StepScheduler idle;
+        idle.Init(Steps::Table, hooks, Steps::Count, nullptr);
+        time("all pending, backing off (typical tick)", idle, Steps::AnyLane, 1);
+
+        StepScheduler busy;
+        busy.Init(Steps::Table, hooks, Steps::Count, nullptr);
+        time("all pending, every probe due", busy, Steps::AnyLane, 1000000);
+
+        StepScheduler done;
+        Sched::Hooks doneHooks[Steps::Count];
+        for (auto& h : doneHooks) h = { nullptr, [](void*) { return true; } };
+        done.Init(Steps::Table, doneHooks, Steps::Count, nullptr);
+        done.Poll(1 << 20, Steps::AnyLane);
+        done.Poll(1 << 21, Steps::AnyLane);
+        time("all done", done, Steps::AnyLane, 1);
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t active = 0;
+        for (uint64_t i = 0; i < iterations; i++) active += done.Done(Steps::MaskRestore);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        printf("%-44s %6.1f ns/call (%llu)\n", "IsFullyActive (state word load)", ns / iterations,
+               (unsigned long long)(active % 2));
+        return 0;
+    }
+
+    int Usage()
+    {
+        fprintf(stderr,
+            "usage: sched_sim [--seeds N] [--verbose] [--no-hook]\n"
+            "       sched_sim --bench [--iterations N]\n"
+            "       sched_sim --threads N\n");
+        return 2;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint64_t seeds = 1000, iterations = 10000000;
+    int threads = 0;
+    bool bench = false, verbose = false, hook = true;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seeds") && i + 1 < argc) seeds = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--bench")) bench = true;
+        else if (!strcmp(argv[i], "--verbose")) verbose = true;
+        else if (!strcmp(argv[i], "--no-hook")) hook = false;
+        else return Usage();
+    }
+    if (seeds == 0 || iterations == 0) return Usage();
+
+    if (bench) return RunBench(iterations);
+    if (threads > 0) return RunThreads(threads);
+    return RunSeeds(seeds, verbose, hook);
+}
@@ -0,0 +1,324 @@
+// =============================================================================
+// shared_toggle_check - shared-eye shadow map switching against stand-in code
+//
+//   shared_toggle_check [--seconds N] [--seed N] [--bench]
+//
+// Maps a read/execute page holding the two MOVs of FUN_14290d640's VR
+// instanced path (49 8B 4F 58 ... 49 8B 57 58) and attaches
+// SharedShadowToggle to their disp8 bytes, the way the plugin does on the
+// game's .text. Checks that:
+// - Attach refuses bytes that are neither both 0x58 nor both 0x50
+// - the fixed modes rewrite both bytes and restore the originals exactly,
+//   and the page is read/execute again afterwards
+// - a rewrite that finds one byte changed by someone else writes neither
+//   and detaches
+// - Auto shares in a heavy scene and separates again in a light one, with
+//   at most one toggle per minWindows windows, fewer frames over the budget
+//   than never sharing, time in shared mode counted, and the learned saving
+//   close to the model's
+// - Auto with adapt off holds Shared
+// --bench times Frame().
+// =============================================================================
+
+#include "check.h"
+#include "os_memory.h"
+#include "shared_shadows.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    // ---- Stand-in code page ----
+    constexpr uint8_t CodeBytes[] = {
+        0x49, 0x8B, 0x4F, 0x58,                     // mov rcx, [r15+0x58]
+        0xE8, 0x00, 0x00, 0x00, 0x00,               // call (activate)
+        0x49, 0x8B, 0x57, 0x58,                     // mov rdx, [r15+0x58]
+    };
+    constexpr size_t CodeOffset = 0x9C0;
+    constexpr size_t DispOffsets[2] = { 3, 12 };
+    const char* const SiteNames[2] = { "activate disp", "dispatch disp" };
+
+    struct CodePage
+    {
+        uint8_t* base = nullptr;
+        size_t   size = 0;
+
+        bool Map()
+        {
+            size = OS::PageSize();
+#ifdef _WIN32
+            base = static_cast<uint8_t*>(VirtualAlloc(nullptr, size, MEM_COMMIT | MEM_RESERVE, PAGE_READWRITE));
+            if (!base) return false;
+            memcpy(base + CodeOffset, CodeBytes, sizeof(CodeBytes));
+            DWORD old;
+            return VirtualProtect(base, size, PAGE_EXECUTE_READ, &old) != 0;
+#else
+            void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (p == MAP_FAILED) return false;
+            base = static_cast<uint8_t*>(p);
+            memcpy(base + CodeOffset, CodeBytes, sizeof(CodeBytes));
+            return mprotect(base, size, PROT_READ | PROT_EXEC) == 0;
+#endif
+        }
+
+        uint8_t* Disp(size_t i) const { return base + CodeOffset + DispOffsets[i]; }
+
+        void Sites(uintptr_t (&out)[2]) const
+        {
+            for (size_t i = 0; i < 2; i++) out[i] = reinterpret_cast<uintptr_t>(Disp(i));
+        }
+
+        // Writes outside the toggle, as another patcher would
+        void Poke(size_t i, uint8_t value)
+        {
+            OS::Protection previous;
+            OS::MakeWritable(base, size, previous);
+            *Disp(i) = value;
+            OS::RestoreProtection(base, size, previous);
+        }
+
+        bool Holds(uint8_t value) const { return *Disp(0) == value && *Disp(1) == value; }
+
+        // Every byte but the two displacements is the original code
+        bool RestIntact() const
+        {
+            for (size_t i = 0; i < sizeof(CodeBytes); i++) {
+                if (i == DispOffsets[0] || i == DispOffsets[1]) continue;
+                if (base[CodeOffset + i] != CodeBytes[i]) return false;
+            }
+            return true;
+        }
+
+        // Read/execute and not writable, per /proc/self/maps
+        bool ReadOnly() const
+        {
+#ifdef _WIN32
+            MEMORY_BASIC_INFORMATION info;
+            return VirtualQuery(base, &info, sizeof(info)) && info.Protect == PAGE_EXECUTE_READ;
+#else
+            FILE* f = fopen("/proc/self/maps", "r");
+            if (!f) return true;  // nothing to check against
+            char line[512];
+            bool found = false, ok = false;
+            uintptr_t addr = reinterpret_cast<uintptr_t>(base);
+            while (fgets(line, sizeof(line), f)) {
+                unsigned long long lo, hi;
+                char perms[8] = {};
+                if (sscanf(line, "%llx-%llx %7s", &lo, &hi, perms) != 3) continue;
+                if (addr < lo || addr >= hi) continue;
+                found = true;
+                ok = perms[0] == 'r' && perms[1] == '-' && perms[2] == 'x';
+                break;
+            }
+            fclose(f);
+            return found && ok;
+#endif
+        }
+    };
+
+    // ---- Attach, fixed modes, atomic restore ----
+    void CheckModes(CodePage& code)
+    {
+        uintptr_t sites[2];
+        code.Sites(sites);
+
+        // Mixed or unknown bytes are refused
+        code.Poke(1, SharedShadowToggle::SharedDisp);
+        SharedShadowToggle mixed;
+        Check(!mixed.Attach(sites, SiteNames), "attached to one shared and one separate disp");
+        code.Poke(1, 0x90);
+        code.Poke(0, 0x90);
+        Check(!mixed.Attach(sites, SiteNames), "attached to unknown disp bytes");
+        code.Poke(0, SharedShadowToggle::SeparateDisp);
+        code.Poke(1, SharedShadowToggle::SeparateDisp);
+
+        SharedShadowToggle t;
+        Check(t.Attach(sites, SiteNames) && !t.IsShared(), "attach to the original code failed");
+
+        SharedShadowConfig c;
+        c.mode = SharedShadowMode::Shared;
+        t.Configure(c);
+        Check(t.Frame(12000) && t.IsShared() && code.Holds(SharedShadowToggle::SharedDisp), "Shared did not patch both bytes");
+        for (int i = 0; i < 500; i++) t.Frame(4000);
+        Check(t.IsShared() && t.Stats().toggles == 1, "Shared did not hold");
+
+        c.mode = SharedShadowMode::Separate;
+        t.Configure(c);
+        Check(t.Frame(4000) && !t.IsShared() && code.Holds(SharedShadowToggle::SeparateDisp), "Separate did not restore both bytes");
+        Check(code.RestIntact(), "toggling touched bytes around the displacements");
+        Check(code.ReadOnly(), "code page left writable");
+        Check(t.Stats().toggles == 2 && t.Stats().sharedFrames == 501, "toggle or shared frame count off");
+
+        c.mode = SharedShadowMode::Auto;
+        c.adapt = false;
+        t.Configure(c);
+        for (int i = 0; i < 500; i++) t.Frame(4000);
+        Check(t.IsShared() && t.Stats().toggles == 3, "Auto with adapt off does not hold Shared");
+
+        // Someone rewrote one byte: the restore writes neither and lets go
+        code.Poke(1, 0x90);
+        c.mode = SharedShadowMode::Separate;
+        t.Configure(c);
+        Check(!t.Frame(4000), "rewrite over a foreign byte reported success");
+        Check(*code.Disp(0) == SharedShadowToggle::SharedDisp && *code.Disp(1) == 0x90, "failed rewrite was not all-or-nothing");
+        Check(!t.Attached() && t.Stats().failures == 1 && t.IsShared(), "failed rewrite did not detach");
+        for (int i = 0; i < 100; i++) t.Frame(4000);
+        Check(t.Stats().failures == 1, "detached toggle kept rewriting");
+
+        code.Poke(0, SharedShadowToggle::SeparateDisp);
+        code.Poke(1, SharedShadowToggle::SeparateDisp);
+    }
+
+    // ---- Auto on a cost model ----
+    struct Result
+    {
+        float    overPct = 0.0f;
+        float    sharedPct = 0.0f;
+        uint64_t toggles = 0;
+        float    savingMs = 0.0f;
+        double   sharedSec = 0.0;
+    };
+
+    constexpr float EyeShadowMs = 1.4f;   // what the right eye's own maps cost
+
+    Result Run(CodePage& code, const std::vector<float>& scene, SharedShadowMode mode, uint64_t seed)
+    {
+        uintptr_t sites[2];
+        code.Sites(sites);
+        code.Poke(0, SharedShadowToggle::SeparateDisp);
+        code.Poke(1, SharedShadowToggle::SeparateDisp);
+
+        SharedShadowToggle t;
+        t.Attach(sites, SiteNames);
+        SharedShadowConfig c;
+        c.mode = mode;
+        t.Configure(c);
+
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<float> jitter(0.0f, 0.15f);
+        uint64_t over = 0;
+        for (float s : scene) {
+            // The code decides what the frame costs, as the game's would
+            bool shared = *code.Disp(0) == SharedShadowToggle::SharedDisp;
+            float ms = std::max(0.5f, s + (shared ? 0.0f : EyeShadowMs) + jitter(rng));
+            over += ms > c.budgetMs;
+            t.Frame(static_cast<uint32_t>(ms * 1000.0f));
+        }
+        Result r;
+        float n = static_cast<float>(scene.size());
+        r.overPct = 100.0f * static_cast<float>(over) / n;
+        r.sharedPct = 100.0f * static_cast<float>(t.Stats().sharedFrames) / n;
+        r.toggles = t.Stats().toggles;
+        r.savingMs = t.SavingMs();
+        r.sharedSec = static_cast<double>(t.Stats().sharedUs) / 1e6;
+        Check(code.Holds(t.IsShared() ? SharedShadowToggle::SharedDisp : SharedShadowToggle::SeparateDisp), "code and mode disagree");
+        return r;
+    }
+
+    void CheckAuto(CodePage& code, float seconds, uint64_t seed)
+    {
+        // Light, heavy (+3.5 ms) from 30% to 60%, light again; rare hitches
+        size_t frames = static_cast<size_t>(std::max(seconds, 10.0f) * 90.0f);
+        std::mt19937_64 rng(seed);
+        std::normal_distribution<float> noise(0.0f, 0.4f);
+        std::uniform_real_distribution<float> roll(0.0f, 1.0f), hitch(20.0f, 40.0f);
+        std::vector<float> scene(frames);
+        for (size_t i = 0; i < frames; i++) {
+            bool heavy = i >= frames * 3 / 10 && i < frames * 6 / 10;
+            scene[i] = roll(rng) < 0.003f ? hitch(rng) : std::max(1.0f, (heavy ? 10.5f : 7.0f) + noise(rng));
+        }
+
+        Result never = Run(code, scene, SharedShadowMode::Separate, seed);
+        Result autoR = Run(code, scene, SharedShadowMode::Auto, seed);
+        printf("\n%-9s %7s %7s %8s %8s %9s\n", "mode", "over", "shared", "toggles", "saving", "shared s");
+        printf("%-9s %6.1f%% %6.1f%% %8llu %6.2fms %8.1fs\n", "Separate", never.overPct, never.sharedPct,
+               static_cast<unsigned long long>(never.toggles), never.savingMs, never.sharedSec);
+        printf("%-9s %6.1f%% %6.1f%% %8llu %6.2fms %8.1fs\n", "Auto", autoR.overPct, autoR.sharedPct,
+               static_cast<unsigned long long>(autoR.toggles), autoR.savingMs, autoR.sharedSec);
+
+        Check(autoR.overPct < never.overPct, "Auto is over budget as often as never sharing");
+        Check(autoR.toggles >= 2, "Auto did not share and separate again");
+        Check(autoR.toggles <= 4, "Auto flaps between modes");
+        Check(autoR.sharedPct > 20.0f && autoR.sharedPct < 50.0f, "Auto shared outside the heavy stretch");
+        Check(autoR.sharedSec > 0.0, "time in shared mode not counted");
+        Check(std::fabs(autoR.savingMs - EyeShadowMs) < 0.5f, "learned saving far from the model's");
+    }
+
+    void Bench(CodePage& code)
+    {
+        uintptr_t sites[2];
+        code.Sites(sites);
+        SharedShadowToggle t;
+        t.Attach(sites, SiteNames);
+        SharedShadowConfig c;
+        c.minWindows = 1000000;   // decide, never rewrite
+        t.Configure(c);
+        std::mt19937_64 rng(7);
+        std::normal_distribution<float> ms(11.0f, 1.0f);
+        static uint32_t us[1024];
+        for (uint32_t& u : us) u = static_cast<uint32_t>(std::max(1.0f, ms(rng)) * 1000.0f);
+        const int n = 10000000;
+        auto t0 = Clock::now();
+        for (int i = 0; i < n; i++) t.Frame(us[i & 1023]);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+        printf("\nFrame: %.2f ns per frame\n", ns);
+
+        // One rewrite each way: protect, two bytes, restore, flush
+        c.mode = SharedShadowMode::Shared;
+        const int toggles = 2000;
+        t0 = Clock::now();
+        for (int i = 0; i < toggles; i++) {
+            c.mode = (i & 1) ? SharedShadowMode::Separate : SharedShadowMode::Shared;
+            t.Configure(c);
+            t.Frame(11000);
+        }
+        double us1 = std::chrono::duration<double, std::micro>(Clock::now() - t0).count() / toggles;
+        printf("toggle: %.2f us per rewrite (%llu done)\n", us1, static_cast<unsigned long long>(t.Stats().toggles));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    float seconds = 120.0f;
+    uint64_t seed = 1;
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--seconds") && i + 1 < argc) seconds = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--bench")) bench = true;
+        else {
+            fprintf(stderr, "usage: shared_toggle_check [--seconds N] [--seed N] [--bench]\n");
+            return 2;
+        }
+    }
+
+    CodePage code;
+    if (!code.Map()) {
+        fprintf(stderr, "cannot map a code page\n");
+        return 1;
+    }
+
+    CheckModes(code);
+    CheckAuto(code, seconds, seed);
+    if (bench) Bench(code);
+
+    return Report();
+}
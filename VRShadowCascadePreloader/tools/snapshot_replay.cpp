@@ -0,0 +1,597 @@
+// =============================================================================
+// snapshot_replay - run the preloader's game object fixes against a snapshot
+//
+//   snapshot_replay FILE [--relocate] [--iterations N] [--regions]
+//   snapshot_replay --synthesize FILE
+//
+// Maps every region of a VRShadowCascade.<point>.snap (see game_snapshot.h)
+// back into memory: the module regions as one span whose base may move, the
+// heap regions page-merged into spans mapped at their game addresses. A
+// span that cannot be placed there (or every span, with --relocate) goes
+// anywhere, and pointer-sized words inside the snapshot that point into it
+// are rewritten. Then the pipeline runs in the preloader's step order -
+// VR array expansion, setup scene node, cascade groups, shader fields, flat
+// array check, the mask restore batch, VR entry refresh - with the real
+// game_state.h functions and Patch::Batch, each under a SIGSEGV guard that
+// reports a fault instead of dying. Prints each step's result, the state
+// it leaves, and per-step timings over N fresh runs (state is restored
+// between runs). The state digest is taken in game addresses, so a
+// --relocate run must print the same digest as a fixed one.
+// --synthesize writes a snapshot of a made-up 1.2.72 state through the same
+// Capture() walk, for trying the runner without the game. Linux x86-64 only.
+// =============================================================================
+
+#include "cascade_patches.h"
+#include "game_snapshot.h"
+#include "game_state.h"
+#include "offset_cache.h"
+#include "os_file.h"
+#include "os_memory.h"
+#include "os_time.h"
+
+#include <algorithm>
+#include <bit>
+#include <csetjmp>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <vector>
+
+#include <sys/mman.h>
+
+using namespace CascadePatch;
+
+namespace
+{
+    // ---- Fault guard ----
+    sigjmp_buf g_faultJump;
+    volatile uintptr_t g_faultAddr = 0;
+
+    void OnFault(int /*sig*/, siginfo_t* info, void* /*context*/)
+    {
+        g_faultAddr = reinterpret_cast<uintptr_t>(info->si_addr);
+        siglongjmp(g_faultJump, 1);
+    }
+
+    void InstallFaultHandler()
+    {
+        struct sigaction sa = {};
+        sa.sa_sigaction = OnFault;
+        sa.sa_flags = SA_SIGINFO | SA_NODEFER;
+        sigaction(SIGSEGV, &sa, nullptr);
+        sigaction(SIGBUS, &sa, nullptr);
+    }
+
+    // Runs `fn`; false (and g_faultAddr) if it touched unmapped memory
+    template <typename Fn>
+    bool Guarded(Fn&& fn)
+    {
+        if (sigsetjmp(g_faultJump, 1)) return false;
+        fn();
+        return true;
+    }
+
+    // ---- Mapped snapshot ----
+    struct Span
+    {
+        uintptr_t lo = 0, hi = 0;       // game addresses, page aligned
+        uint8_t*  mapped = nullptr;
+        bool      module = false;
+
+        intptr_t Delta() const { return reinterpret_cast<intptr_t>(mapped) - static_cast<intptr_t>(lo); }
+        bool Moved() const { return Delta() != 0; }
+    };
+
+    struct MappedRegion
+    {
+        Snapshot::Region     region;
+        uintptr_t            gameAddr;  // absolute, module regions included
+        uint8_t*             mapped;
+        std::vector<uint8_t> pristine;  // after pointer fixups
+    };
+
+    struct Replay
+    {
+        Snapshot::Reader reader;
+        std::vector<Span> spans;
+        std::vector<MappedRegion> regions;
+        uintptr_t base = 0;             // module base to hand the fixes
+        uint32_t fixups = 0;
+
+        // Bump allocator for a reallocated VR array, reset with the state
+        uint8_t* heap = nullptr;
+        size_t heapUsed = 0;
+        static constexpr size_t HeapSize = 64 * 1024;
+
+        const Span* SpanOf(uintptr_t gameAddr) const
+        {
+            for (const Span& s : spans) {
+                if (gameAddr >= s.lo && gameAddr < s.hi) return &s;
+            }
+            return nullptr;
+        }
+
+        uint8_t* ToMapped(uintptr_t gameAddr) const
+        {
+            const Span* s = SpanOf(gameAddr);
+            return s ? s->mapped + (gameAddr - s->lo) : nullptr;
+        }
+
+        // Mapped address back to the game's, for printing and the digest
+        uintptr_t ToGame(uintptr_t addr) const
+        {
+            for (const Span& s : spans) {
+                uintptr_t m = reinterpret_cast<uintptr_t>(s.mapped);
+                if (addr >= m && addr < m + (s.hi - s.lo)) return s.lo + (addr - m);
+            }
+            return addr;
+        }
+    } g_replay;
+
+    void* AllocateVRArray(size_t size)
+    {
+        Replay& r = g_replay;
+        size = (size + 15) & ~size_t(15);
+        if (r.heapUsed + size > Replay::HeapSize) return nullptr;
+        void* p = r.heap + r.heapUsed;
+        r.heapUsed += size;
+        return p;
+    }
+
+    bool Load(Replay& r, const char* path, OS::MappedFile& file, bool relocate)
+    {
+        if (!file.Open(path) || !r.reader.Open(file.Data(), file.Size())) {
+            fprintf(stderr, "%s: not a snapshot\n", path);
+            return false;
+        }
+        const Snapshot::Header& h = r.reader.Head();
+        const uintptr_t page = OS::PageSize();
+        auto down = [&](uintptr_t a) { return a & ~(page - 1); };
+        auto up = [&](uintptr_t a) { return (a + page - 1) & ~(page - 1); };
+
+        // Module regions share one span so base + RVA holds; heap regions
+        // are merged by page
+        Span module;
+        module.module = true;
+        std::vector<Span> heap;
+        Snapshot::Region reg;
+        while (r.reader.Next(reg)) {
+            bool isModule = reg.flags & Snapshot::ModuleRelative;
+            uintptr_t addr = isModule ? h.moduleBase + reg.addr : reg.addr;
+            r.regions.push_back({ reg, addr, nullptr, {} });
+            if (isModule) {
+                module.lo = module.lo ? std::min(module.lo, down(addr)) : down(addr);
+                module.hi = std::max(module.hi, up(addr + reg.size));
+            } else {
+                heap.push_back({ down(addr), up(addr + reg.size), nullptr, false });
+            }
+        }
+        std::sort(heap.begin(), heap.end(), [](const Span& a, const Span& b) { return a.lo < b.lo; });
+        if (module.hi) r.spans.push_back(module);
+        for (const Span& s : heap) {
+            if (r.spans.size() > (module.hi ? 1u : 0u) && s.lo <= r.spans.back().hi) {
+                r.spans.back().hi = std::max(r.spans.back().hi, s.hi);
+            } else {
+                r.spans.push_back(s);
+            }
+        }
+
+        for (Span& s : r.spans) {
+            size_t size = s.hi - s.lo;
+            void* p = relocate ? nullptr : OS::MapAt(s.lo, size);
+            if (!p) {
+                p = mmap(nullptr, size, PROT_READ | PROT_WRITE | PROT_EXEC, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE,
+                         -1, 0);
+                if (p == MAP_FAILED) {
+                    fprintf(stderr, "cannot map %zu bytes for 0x%llX\n", size, (unsigned long long)s.lo);
+                    return false;
+                }
+            }
+            s.mapped = static_cast<uint8_t*>(p);
+        }
+
+        for (MappedRegion& m : r.regions) {
+            m.mapped = r.ToMapped(m.gameAddr);
+            memcpy(m.mapped, m.region.bytes, m.region.size);
+        }
+
+        // Pointers into a moved span follow it
+        for (MappedRegion& m : r.regions) {
+            for (size_t off = 0; off + 8 <= m.region.size; off += 8) {
+                uintptr_t v;
+                memcpy(&v, m.mapped + off, 8);
+                const Span* s = r.SpanOf(v);
+                if (!s || !s->Moved()) continue;
+                v += s->Delta();
+                memcpy(m.mapped + off, &v, 8);
+                r.fixups++;
+            }
+            m.pristine.assign(m.mapped, m.mapped + m.region.size);
+        }
+
+        r.base = h.moduleBase + (r.spans.empty() || !r.spans[0].module ? 0 : r.spans[0].Delta());
+        r.heap = static_cast<uint8_t*>(mmap(nullptr, Replay::HeapSize, PROT_READ | PROT_WRITE,
+                                            MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+        return r.heap != MAP_FAILED;
+    }
+
+    // Back to the captured state; the patch batch may have left code pages read/execute
+    void Reset(Replay& r)
+    {
+        for (const Span& s : r.spans) {
+            mprotect(s.mapped, s.hi - s.lo, PROT_READ | PROT_WRITE | PROT_EXEC);
+        }
+        for (MappedRegion& m : r.regions) memcpy(m.mapped, m.pristine.data(), m.pristine.size());
+        memset(r.heap, 0, r.heapUsed);
+        r.heapUsed = 0;
+    }
+
+    // FNV-1a of every region in game addresses: moved pointers are hashed
+    // as the values the game had
+    uint64_t Digest(const Replay& r)
+    {
+        uint64_t h = OffsetCache::Fnv1a(nullptr, 0);
+        for (const MappedRegion& m : r.regions) {
+            std::vector<uint8_t> bytes(m.mapped, m.mapped + m.region.size);
+            for (size_t off = 0; off + 8 <= bytes.size(); off += 8) {
+                uintptr_t v;
+                memcpy(&v, bytes.data() + off, 8);
+                v = r.ToGame(v);
+                memcpy(bytes.data() + off, &v, 8);
+            }
+            h = OffsetCache::Fnv1a(&m.gameAddr, sizeof(m.gameAddr), h);
+            h = OffsetCache::Fnv1a(bytes.data(), bytes.size(), h);
+        }
+        return h;
+    }
+
+    // ---- Pipeline, in cascade_steps.h order ----
+    struct Step
+    {
+        const char* name;
+        bool (*run)(const Replay& r, char* detail, size_t size);
+    };
+
+    bool RunExpand(const Replay& r, char* detail, size_t size)
+    {
+        GameState::ExpandResult e = GameState::ExpandVRArray(r.base, AllocateVRArray);
+        snprintf(detail, size, "%s: capacity %u, count %u, %u entries template-copied",
+                 GameState::ExpandName(e.result), e.before.capacity, e.before.count, e.entriesFixed);
+        return e.result == GameState::Expand::InPlace || e.result == GameState::Expand::Reallocated;
+    }
+
+    bool RunSceneNode(const Replay& r, char* detail, size_t size)
+    {
+        GameState::SceneNodeResult s = GameState::FixSetupSceneNode(r.base);
+        snprintf(detail, size, "%s: render node 0x%llX", GameState::SceneNodeName(s.result),
+                 (unsigned long long)r.ToGame(s.renderNode));
+        return s.result != GameState::SceneNode::NoRenderNode;
+    }
+
+    bool RunCascadeGroups(const Replay& r, char* detail, size_t size)
+    {
+        bool ok = GameState::ForceCascadeGroups(r.base);
+        snprintf(detail, size, "%s", ok ? "+0x173 set" : "no render node / cascade group");
+        return ok;
+    }
+
+    bool RunShaderFields(const Replay& r, char* detail, size_t size)
+    {
+        GameState::ShaderResult s[2];
+        bool ok = GameState::ForceShaderFields(r.base, s);
+        snprintf(detail, size, "render %u/%u/%u forced 0x%X, setup %u/%u/%u forced 0x%X", s[0].stored,
+                 s[0].capacity, s[0].count, s[0].forced, s[1].stored, s[1].capacity, s[1].count, s[1].forced);
+        return ok;
+    }
+
+    bool RunFlatArray(const Replay& r, char* detail, size_t size)
+    {
+        GameState::FlatArray flat;
+        bool ok = GameState::ReadFlatArray(r.base, flat) && GameState::FlatArrayReady(flat);
+        snprintf(detail, size, "%u entries at 0x%llX", flat.count, (unsigned long long)r.ToGame(flat.buf));
+        return ok;
+    }
+
+    bool RunMaskRestore(const Replay& r, char* detail, size_t size)
+    {
+        Patch::Batch batch;
+        for (const Patches::Desc& desc : Patches::MaskRestoreAll) {
+            uint32_t rva = r.reader.SiteRVA(desc.site);
+            if (rva) batch.Add(desc.name, r.base + rva, desc.expected, desc.replacement, desc.group);
+        }
+        Patch::ApplyStats stats;
+        batch.Apply(0, &stats);
+        int applied = batch.Applied(Patches::MaskRestore);
+        snprintf(detail, size, "%d/4 applied, %u pages, %u protect calls", applied, stats.pages, stats.protectCalls);
+        return applied == 4;
+    }
+
+    bool RunRefresh(const Replay& r, char* detail, size_t size)
+    {
+        GameState::RefreshResult f = GameState::RefreshVRArrayEntries(r.base);
+        if (!f.refreshed) {
+            snprintf(detail, size, "not populated: entry 0 data matches entry 2");
+        } else {
+            const uint32_t* nz = f.nonZeroAfter;
+            snprintf(detail, size, "refreshed: %d data words changed, non-zero %u/%u/%u/%u",
+                     std::popcount(f.changedWords), nz[0], nz[1], nz[2], nz[3]);
+        }
+        return f.refreshed;
+    }
+
+    constexpr Step Pipeline[] = {
+        { "expand_vr_array",  RunExpand },
+        { "setup_scene_node", RunSceneNode },
+        { "cascade_groups",   RunCascadeGroups },
+        { "shader_fields",    RunShaderFields },
+        { "flat_array_ready", RunFlatArray },
+        { "mask_restore",     RunMaskRestore },
+        { "refresh_vr",       RunRefresh },
+    };
+    constexpr size_t StepCount = sizeof(Pipeline) / sizeof(Pipeline[0]);
+
+    double Us(uint64_t ticks) { return ticks * 1e6 / OS::TicksPerSecond(); }
+
+    int RunPipeline(const Replay& r)
+    {
+        int faults = 0;
+        for (const Step& step : Pipeline) {
+            char detail[160] = "";
+            bool ok = false;
+            uint64_t start = OS::Ticks();
+            bool clean = Guarded([&] { ok = step.run(r, detail, sizeof(detail)); });
+            double us = Us(OS::Ticks() - start);
+            if (!clean) {
+                faults++;
+                printf("  %-18s FAULT at 0x%llX (game 0x%llX, outside the snapshot)\n", step.name,
+                       (unsigned long long)g_faultAddr, (unsigned long long)r.ToGame(g_faultAddr));
+                continue;
+            }
+            printf("  %-18s %-4s %8.2f us  %s\n", step.name, ok ? "done" : "wait", us, detail);
+        }
+        return faults;
+    }
+
+    template <typename T>
+    T Read(uintptr_t addr)
+    {
+        T v = {};
+        Guarded([&] { memcpy(&v, reinterpret_cast<const void*>(addr), sizeof(v)); });
+        return v;
+    }
+
+    void PrintState(const Replay& r)
+    {
+        using namespace VRArrayExpansion;
+        printf("state:\n");
+
+        GameState::VRArray vr;
+        Guarded([&] { vr = GameState::ReadVRArray(r.base); });
+        printf("  vr array      0x%llX capacity %u count %u, non-zero", (unsigned long long)r.ToGame(vr.buf),
+               vr.capacity, vr.count);
+        for (uint32_t i = 0; vr.buf && i < TargetCount; i++) {
+            uint32_t nz = 0;
+            if (Guarded([&] { nz = Watch::NonZeroBytes(reinterpret_cast<const uint8_t*>(vr.buf + i * EntrySize),
+                                                       EntrySize); })) {
+                printf(" %u", nz);
+            } else {
+                printf(" ?");
+            }
+        }
+        printf("\n");
+
+        uintptr_t nodes[2] = { Read<uintptr_t>(r.base + ShadowSceneNodePtr), Read<uintptr_t>(r.base + ShadowSceneNodePtr2) };
+        const char* labels[] = { "render", "setup" };
+        for (int n = 0; n < 2; n++) {
+            uintptr_t cg = nodes[n] ? Read<uintptr_t>(nodes[n] + CascadeGroupOffset) : 0;
+            uintptr_t shader = cg ? Read<uintptr_t>(cg + ShaderObjectOffset) : 0;
+            printf("  %-6s node   0x%llX group 0x%llX +0x173=%u", labels[n], (unsigned long long)r.ToGame(nodes[n]),
+                   (unsigned long long)r.ToGame(cg), cg ? Read<uint8_t>(cg + CascadeGroupVRFlag) : 0);
+            if (shader) {
+                printf(" shader +0x1D8=%u +0x168=%u +0x16A=%u", Read<uint32_t>(shader + 0x1D8),
+                       Read<uint16_t>(shader + 0x168), Read<uint16_t>(shader + 0x16A));
+            }
+            printf("\n");
+        }
+
+        printf("  mask sites   ");
+        for (const Patches::Desc& desc : Patches::MaskRestoreAll) {
+            uint32_t rva = r.reader.SiteRVA(desc.site);
+            if (rva) printf(" 0x%02X", Read<uint8_t>(r.base + rva));
+            else printf(" --");
+        }
+        printf("\n");
+
+        uint32_t changed = 0, bytes = 0;
+        for (const MappedRegion& m : r.regions) {
+            uint32_t n = 0;
+            for (size_t i = 0; i < m.pristine.size(); i++) n += m.mapped[i] != m.pristine[i];
+            changed += n != 0;
+            bytes += n;
+        }
+        printf("  %u regions changed, %u bytes, digest %016llX\n", changed, bytes, (unsigned long long)Digest(r));
+    }
+
+    void Bench(Replay& r, uint64_t iterations)
+    {
+        printf("timings over %llu fresh runs (state restored before each):\n", (unsigned long long)iterations);
+        for (size_t i = 0; i < StepCount; i++) {
+            std::vector<uint64_t> ticks;
+            ticks.reserve(iterations);
+            for (uint64_t n = 0; n < iterations; n++) {
+                Reset(r);
+                // Earlier steps run untimed, so each step sees the state it would in the pipeline
+                char detail[160];
+                for (size_t j = 0; j < i; j++) Guarded([&] { Pipeline[j].run(r, detail, sizeof(detail)); });
+                uint64_t start = OS::Ticks();
+                if (!Guarded([&] { Pipeline[i].run(r, detail, sizeof(detail)); })) break;
+                ticks.push_back(OS::Ticks() - start);
+            }
+            if (ticks.empty()) {
+                printf("  %-18s faults\n", Pipeline[i].name);
+                continue;
+            }
+            std::sort(ticks.begin(), ticks.end());
+            printf("  %-18s min %8.3f us  median %8.3f us  p99 %8.3f us\n", Pipeline[i].name, Us(ticks.front()),
+                   Us(ticks[ticks.size() / 2]), Us(ticks[ticks.size() * 99 / 100]));
+        }
+    }
+
+    // ---- --synthesize: a made-up game, read through the real Capture() ----
+    struct FakeMemory
+    {
+        std::map<uintptr_t, std::vector<uint8_t>> pages;
+
+        uint8_t* At(uintptr_t addr)
+        {
+            std::vector<uint8_t>& p = pages[addr & ~uintptr_t(0xFFF)];
+            if (p.empty()) p.resize(0x1000);
+            return p.data() + (addr & 0xFFF);
+        }
+
+        template <typename T>
+        void Put(uintptr_t addr, T value)
+        {
+            memcpy(At(addr), &value, sizeof(value));
+        }
+
+        static bool Read(void* dst, uintptr_t addr, size_t size, void* context)
+        {
+            FakeMemory& m = *static_cast<FakeMemory*>(context);
+            for (size_t i = 0; i < size; i++) {
+                auto it = m.pages.find((addr + i) & ~uintptr_t(0xFFF));
+                if (it == m.pages.end()) return false;
+                static_cast<uint8_t*>(dst)[i] = it->second[(addr + i) & 0xFFF];
+            }
+            return true;
+        }
+    };
+
+    int Synthesize(const char* path)
+    {
+        using namespace VRArrayExpansion;
+        constexpr uintptr_t base = 0x140000000;
+        constexpr uintptr_t node = 0x2A010000000, group = 0x2A010001000, shader = 0x2A010002000;
+        constexpr uintptr_t flat = 0x2A010003000, vr = 0x2A020000000, desc = 0x2A030000000;
+
+        FakeMemory m;
+        SigScan::Resolution sites[Sites::Count];
+        for (size_t i = 0; i < Sites::Count; i++) {
+            sites[i].rva = Sites::Table[i].hintRVA;
+            for (uintptr_t b = 0; b < 16; b++) m.Put<uint8_t>(base + sites[i].rva + b, 0x90);
+        }
+        // Safe mode mask (0x3) from the startup batch
+        for (const Patches::Desc& d : Patches::MaskRestoreAll) m.Put<uint8_t>(base + sites[d.site].rva, 0x03);
+
+        m.Put<uint32_t>(base + CascadeMaskGlobal, 0x3);
+        m.Put<uint32_t>(base + CascadeCountPatch::CountGlobal, 4);
+        m.Put<float>(base + ShadowDist4Cascade, 8000.0f);
+        m.Put<float>(base + ShadowDist2Cascade, 8000.0f);
+        m.Put<uint32_t>(base + VRInstStereoFlag, 1);
+        m.Put<uint32_t>(base + VRInstDrawFlag, 1);
+
+        // Render node only: the setup slot is what FixSetupSceneNode fills
+        m.Put<uintptr_t>(base + ShadowSceneNodePtr, node);
+        m.Put<uintptr_t>(base + ShadowSceneNodePtr2, 0);
+        m.Put<uintptr_t>(node + CascadeGroupOffset, group);
+        m.Put<uintptr_t>(group, base + 0x2D00000);          // vtable
+        m.Put<uintptr_t>(group + ShaderObjectOffset, shader);
+        m.Put<uint32_t>(group + FlatCountOffset, 4);
+        m.Put<uintptr_t>(group + FlatBufferOffset, flat);
+        m.Put<uint32_t>(group + 0x1A0, 4);
+        m.Put<uint32_t>(shader + 0x1D8, 2);
+        m.Put<uint16_t>(shader + 0x168, 2);
+        m.Put<uint16_t>(shader + 0x16A, 2);
+        for (uint32_t i = 0; i < 4; i++) {
+            m.Put<uintptr_t>(flat + i * FlatEntrySize + FlatShadowMapOff, 0x2A040000000 + i * 0x10000);
+            m.Put<uintptr_t>(flat + i * FlatEntrySize + FlatShadowMapRightOff, 0x2A040008000 + i * 0x10000);
+        }
+
+        // VR array: capacity 4, count 2, entries 0-1 written by the game
+        m.Put<uintptr_t>(base + ArrayPtr, vr);
+        m.Put<uint32_t>(base + ArrayPtr + 8, TargetCount);
+        m.Put<uint32_t>(base + ArrayCount, 2);
+        uint64_t seed = 0x9E3779B97F4A7C15ull;
+        for (uint32_t e = 0; e < 2; e++) {
+            uintptr_t entry = vr + e * EntrySize;
+            for (size_t off = 0x20; off < 0x70; off += 4) {
+                seed = seed * 6364136223846793005ull + 1442695040888963407ull;
+                m.Put<float>(entry + off, static_cast<float>(seed >> 40) / 65536.0f);
+            }
+            for (size_t poolOff : PoolOffsets) m.Put<uintptr_t>(entry + poolOff + 8, entry + poolOff);
+            m.Put<uintptr_t>(entry + 0x18, node);
+        }
+
+        // Descriptor arrays; the third points at memory that is not there
+        for (uint32_t d = 0; d < 3; d++) {
+            uintptr_t slot = base + DescArray0 + d * 0x18;
+            uintptr_t arr = d < 2 ? desc + d * 0x100 : 0x2A0FF000000;
+            m.Put<uintptr_t>(slot, arr);
+            m.Put<uint32_t>(slot + 8, 4);
+            m.Put<uint32_t>(slot + 0x10, 4);
+            for (uint32_t i = 0; d < 2 && i < 4; i++) m.Put<uintptr_t>(arr + i * 8, 0x2A040000000 + i * 0x10000);
+        }
+
+        static uint8_t storage[Snapshot::MaxBytes];
+        Snapshot::Writer w;
+        w.Init(storage, sizeof(storage), base, "synthetic");
+        w.SetSites(sites, Sites::Count);
+        Snapshot::Capture(w, FakeMemory::Read, &m);
+        if (!OS::WriteFileAtomic(path, w.Data(), w.Size())) {
+            fprintf(stderr, "cannot write %s\n", path);
+            return 1;
+        }
+        printf("%s: %u regions (%u unreadable), %zu bytes\n", path, w.Regions(), w.Skipped(), w.Size());
+        return 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = nullptr;
+    const char* synthesize = nullptr;
+    bool relocate = false, listRegions = false;
+    uint64_t iterations = 2000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--relocate")) relocate = true;
+        else if (!strcmp(argv[i], "--regions")) listRegions = true;
+        else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--synthesize") && i + 1 < argc) synthesize = argv[++i];
+        else if (argv[i][0] != '-' && !path) path = argv[i];
+        else path = nullptr, i = argc;
+    }
+    if (synthesize) return Synthesize(synthesize);
+    if (!path) {
+        fprintf(stderr, "usage: snapshot_replay FILE [--relocate] [--iterations N] [--regions]\n"
+                        "       snapshot_replay --synthesize FILE\n");
+        return 2;
+    }
+
+    InstallFaultHandler();
+    OS::MappedFile file;
+    Replay& r = g_replay;
+    if (!Load(r, path, file, relocate)) return 1;
+
+    const Snapshot::Header& h = r.reader.Head();
+    printf("%s: '%.16s', %u regions (%u unreadable at capture), steps 0x%X, captured in %u us\n", path, h.label,
+           h.regionCount, h.skipped, h.steps, h.captureUs);
+    uint32_t moved = 0;
+    for (const Span& s : r.spans) moved += s.Moved();
+    printf("%zu spans (%u relocated), module base 0x%llX -> 0x%llX, %u pointers rewritten\n", r.spans.size(), moved,
+           (unsigned long long)h.moduleBase, (unsigned long long)r.base, r.fixups);
+    if (listRegions) {
+        for (const MappedRegion& m : r.regions) {
+            printf("  %-14s 0x%llX %5zu bytes -> %p\n", Snapshot::KindName(m.region.kind),
+                   (unsigned long long)m.gameAddr, m.region.size, static_cast<void*>(m.mapped));
+        }
+    }
+
+    printf("pipeline:\n");
+    int faults = RunPipeline(r);
+    PrintState(r);
+    if (iterations) Bench(r, iterations);
+    printf("%d faults\n", faults);
+    return faults ? 1 : 0;
+}
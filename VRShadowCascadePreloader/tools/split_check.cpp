@@ -0,0 +1,194 @@
+// =============================================================================
+// split_check - cascade split layouts and texel density per cascade
+//
+//   split_check [--range UNITS] [--fov DEG] [--resolution N] [--lambda L]
+//
+// Checks ComputeSplits() on a grid of ranges and lambdas: exact ends, splits
+// strictly increasing, equal depths at lambda 0 and equal depth ratios at
+// lambda 1. RangeForNearPair() must put the end of cascade 1 on the game's
+// 2-cascade range (--range, default 3000) and reach further as lambda grows.
+// Then the texel density per cascade: for a VR view (--fov vertical degrees,
+// default 110, aspect 0.9) and a --resolution shadow map (default 2048), it
+// falls from cascade to cascade in every layout. A screen pixel at depth z
+// covers about z times the pixel angle, so density x depth is the shadow
+// texels per pixel. Its worst point in a cascade is the near end, where the
+// pixels are smallest and the cascade's map is the same. Against the
+// old range (5x the 2-cascade range, laid out uniformly) the scheme at
+// --lambda (default 0.75) must be sharper in cascade 0 and in its worst
+// cascade, and spread texels per pixel more evenly. The same must hold
+// against the uniform layout at the plugin's maximum shadow distance.
+// =============================================================================
+
+#include "cascade_splits.h"
+#include "check.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+namespace
+{
+    struct View
+    {
+        float    tanHalfFov = std::tan(55.0f * 3.14159265f / 180.0f);
+        float    aspect = 0.9f;
+        uint32_t resolution = 2048;
+    };
+
+    // ---- Layouts ----
+    void CheckLayouts(float range)
+    {
+        const float lambdas[] = { 0.0f, 0.25f, 0.5f, 0.75f, 1.0f };
+        const float fars[] = { 500.0f, 3000.0f, 8000.0f, 15000.0f, 100000.0f };
+        for (float lambda : lambdas) {
+            for (float far : fars) {
+                SplitScheme scheme;
+                scheme.lambda = lambda;
+                CascadeSplits s = ComputeSplits(scheme, far);
+                Check(s.count == 4 && s.split[0] == scheme.nearDist && s.split[4] == far, "splits do not end at near and far");
+                bool increasing = true;
+                for (uint32_t i = 0; i < s.count; i++) increasing &= s.End(i) > s.Start(i);
+                Check(increasing, "splits not strictly increasing");
+                for (uint32_t i = 1; i < s.count; i++) {
+                    if (lambda == 0.0f) {
+                        float depth0 = s.End(0) - s.Start(0);
+                        Check(std::fabs((s.End(i) - s.Start(i)) - depth0) < 1e-3f * far, "uniform layout with unequal depths");
+                    }
+                    if (lambda == 1.0f) {
+                        float ratio0 = s.End(0) / s.Start(0);
+                        Check(std::fabs(s.End(i) / s.Start(i) - ratio0) < 1e-3f * ratio0, "log layout with unequal ratios");
+                    }
+                }
+            }
+        }
+
+        // Degenerate input is clamped, not propagated
+        SplitScheme odd;
+        odd.count = 9;
+        odd.lambda = 3.0f;
+        CascadeSplits s = ComputeSplits(odd, 10.0f);
+        Check(s.count == MaxCascades && s.split[MaxCascades] == 2.0f * odd.nearDist, "out-of-range scheme not clamped");
+
+        float last = 0.0f;
+        for (float lambda : lambdas) {
+            SplitScheme scheme;
+            scheme.lambda = lambda;
+            float far = RangeForNearPair(scheme, range);
+            float end1 = ComputeSplits(scheme, far).End(1);
+            Check(std::fabs(end1 - range) < 1e-3f * range, "near pair does not end at the 2-cascade range");
+            Check(far > last, "range does not grow with lambda");
+            last = far;
+        }
+        SplitScheme uniform;
+        uniform.lambda = 0.0f;
+        Check(std::fabs(RangeForNearPair(uniform, range) - (2.0f * range - uniform.nearDist)) < 1e-3f * range,
+              "uniform near pair range is not 2 x range - near");
+    }
+
+    // ---- Texel density ----
+    struct Quality
+    {
+        float density[MaxCascades];
+        float perPixel[MaxCascades];    // density x near end of the cascade
+        float worst;
+        float spread;                   // best over worst texels per pixel
+    };
+
+    Quality Measure(const CascadeSplits& s, const View& v)
+    {
+        Quality q{};
+        q.worst = 1e30f;
+        float best = 0.0f;
+        for (uint32_t i = 0; i < s.count; i++) {
+            q.density[i] = TexelDensity(s, i, v.tanHalfFov, v.aspect, v.resolution);
+            q.perPixel[i] = q.density[i] * s.Start(i);
+            q.worst = std::min(q.worst, q.perPixel[i]);
+            best = std::max(best, q.perPixel[i]);
+        }
+        q.spread = best / q.worst;
+        return q;
+    }
+
+    void Print(const char* name, const CascadeSplits& s, const Quality& q)
+    {
+        printf("%-22s", name);
+        for (uint32_t i = 0; i < s.count; i++)
+            printf(" | %5.0f-%-6.0f %6.3f %6.1f", s.Start(i), s.End(i), q.density[i], q.perPixel[i]);
+        printf(" | worst %5.1f spread %6.2f\n", q.worst, q.spread);
+    }
+
+    void CheckDensity(float range, float lambda, const View& v)
+    {
+        printf("\n%-22s | per cascade: range, texels/unit, texels per pixel at its near end\n", "layout");
+
+        const float lambdas[] = { 0.0f, 0.5f, 0.75f, 1.0f };
+        for (float l : lambdas) {
+            SplitScheme scheme;
+            scheme.lambda = l;
+            CascadeSplits s = ComputeSplits(scheme, 8000.0f);
+            Quality q = Measure(s, v);
+            bool falling = true;
+            for (uint32_t i = 1; i < s.count; i++) falling &= q.density[i] < q.density[i - 1];
+            Check(falling, "texel density does not fall from cascade to cascade");
+            char name[32];
+            snprintf(name, sizeof(name), "8000, lambda %.2f", l);
+            Print(name, s, q);
+        }
+
+        SplitScheme old;
+        old.lambda = 0.0f;
+        CascadeSplits oldSplits = ComputeSplits(old, 5.0f * range);
+        Quality oldQ = Measure(oldSplits, v);
+
+        SplitScheme scheme;
+        scheme.lambda = lambda;
+        CascadeSplits newSplits = ComputeSplits(scheme, RangeForNearPair(scheme, range));
+        Quality newQ = Measure(newSplits, v);
+
+        CascadeSplits uniformMax = ComputeSplits(old, 8000.0f);
+        Quality uniformQ = Measure(uniformMax, v);
+        CascadeSplits schemeMax = ComputeSplits(scheme, 8000.0f);
+        Quality schemeQ = Measure(schemeMax, v);
+
+        printf("\n");
+        Print("old 5x, uniform", oldSplits, oldQ);
+        Print("near pair at range", newSplits, newQ);
+        Print("8000, uniform", uniformMax, uniformQ);
+        Print("8000, scheme", schemeMax, schemeQ);
+
+        Check(newQ.density[0] > oldQ.density[0], "cascade 0 not sharper than the old 5x range");
+        Check(newQ.worst > oldQ.worst, "worst cascade not sharper than the old 5x range");
+        Check(newQ.spread < oldQ.spread, "texels per pixel less even than the old 5x range");
+        Check(schemeQ.density[0] > uniformQ.density[0], "cascade 0 not sharper than uniform at 8000");
+        Check(schemeQ.spread < uniformQ.spread, "texels per pixel less even than uniform at 8000");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    float range = DefaultTwoCascadeRange;
+    float fovDeg = 110.0f;
+    float lambda = SplitScheme{}.lambda;
+    View view;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--range") && i + 1 < argc) range = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--fov") && i + 1 < argc) fovDeg = strtof(argv[++i], nullptr);
+        else if (!strcmp(argv[i], "--resolution") && i + 1 < argc) view.resolution = static_cast<uint32_t>(strtoul(argv[++i], nullptr, 10));
+        else if (!strcmp(argv[i], "--lambda") && i + 1 < argc) lambda = strtof(argv[++i], nullptr);
+        else {
+            fprintf(stderr, "usage: split_check [--range UNITS] [--fov DEG] [--resolution N] [--lambda L]\n");
+            return 2;
+        }
+    }
+    view.tanHalfFov = std::tan(0.5f * fovDeg * 3.14159265f / 180.0f);
+
+    CheckLayouts(range);
+    CheckDensity(range, lambda, view);
+
+    return Report();
+}
@@ -0,0 +1,238 @@
+// =============================================================================
+// stage_check - SettingsStage against a fake settings backend
+//
+//   stage_check [--frames N] [--bench]
+//
+// The fake backend counts every write. Checks that:
+// - values equal to the game's, or within epsilon of the last write, are
+//   dropped, while small steps still add up to a write
+// - the rate limit holds writes back and the last value still arrives
+// - the block level is written only when the tier changes
+// - with auto-adjust off, only the first adjustment writes anything
+// - with auto-adjust on, the governor makes the same decisions behind the
+//   stage as it does writing straight through, and the game never drifts
+//   more than epsilon from them
+// --bench times Commit() for a frame with and without an adjustment.
+// =============================================================================
+
+#include "check.h"
+#include "settings_stage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    struct FakeSettings final : SettingsBackend
+    {
+        float    value[KnobCount] = { 8000.0f, 10.0f, 8.0f, 15.0f, 7000.0f };
+        uint32_t writes[KnobCount] = {};
+        uint32_t blockWrites = 0;
+        int      block = 0;
+
+        bool  Has(Knob) const override { return true; }
+        float Get(Knob knob) const override { return value[static_cast<size_t>(knob)]; }
+        void  Set(Knob knob, float v) override
+        {
+            value[static_cast<size_t>(knob)] = v;
+            writes[static_cast<size_t>(knob)]++;
+        }
+        bool HasBlockLevels() const override { return true; }
+        void SetBlockLevel(int index) override
+        {
+            block = index;
+            blockWrites++;
+        }
+
+        uint32_t Writes() const
+        {
+            uint32_t n = 0;
+            for (uint32_t w : writes) n += w;
+            return n;
+        }
+    };
+
+    void SetLimits(SettingsStage& stage)
+    {
+        stage.SetLimit(Knob::ShadowDistance, { 1.0f, 0 });
+        stage.SetLimit(Knob::LodObjects, { 0.01f, 0 });
+        stage.SetLimit(Knob::LodItems, { 0.01f, 0 });
+        stage.SetLimit(Knob::LodActors, { 0.01f, 0 });
+        stage.SetLimit(Knob::GrassDistance, { 1.0f, 0 });
+    }
+
+    void CheckUnits()
+    {
+        FakeSettings game;
+        SettingsStage stage(game);
+        SetLimits(stage);
+
+        // The game's own value is not written back
+        stage.Set(Knob::ShadowDistance, 8000.0f);
+        stage.Commit();
+        Check(game.Writes() == 0, "value equal to the game's was written");
+
+        // Steps under epsilon add up
+        const float steps[] = { 7999.7f, 7999.4f, 7999.1f, 7998.8f };
+        uint32_t writesAt[4];
+        for (int i = 0; i < 4; i++) {
+            stage.Set(Knob::ShadowDistance, steps[i]);
+            Check(stage.Get(Knob::ShadowDistance) == steps[i], "Get() does not return the staged value");
+            stage.Commit();
+            writesAt[i] = game.writes[0];
+        }
+        Check(writesAt[0] == 0 && writesAt[1] == 0 && writesAt[2] == 0 && writesAt[3] == 1,
+              "sub-epsilon steps not accumulated into one write");
+        Check(game.value[0] == 7998.8f, "accumulated value not written exactly");
+
+        // Nothing staged, nothing written
+        uint32_t before = game.Writes();
+        for (int i = 0; i < 100; i++) stage.Commit();
+        Check(game.Writes() == before, "commit without Set() wrote");
+
+        // Rate limit: a change every commit, at most one write per 4 commits
+        stage.SetLimit(Knob::GrassDistance, { 1.0f, 3 });
+        uint32_t grassBefore = game.writes[4];
+        for (int i = 1; i <= 20; i++) {
+            stage.Set(Knob::GrassDistance, 7000.0f - 10.0f * i);
+            stage.Commit();
+        }
+        uint32_t limited = game.writes[4] - grassBefore;
+        Check(limited == 5, "rate limit not applied");
+        for (int i = 0; i < 4; i++) stage.Commit();
+        Check(game.value[4] == 6800.0f, "last value held back by the rate limit never arrived");
+        printf("rate limit 1/4 commits: 20 changes -> %u writes, last value %.0f\n", limited, game.value[4]);
+
+        // Block level: only tier changes
+        const int tiers[] = { 0, 0, 1, 1, 1, 2, 2, 1, 1, 0 };
+        for (int t : tiers) {
+            stage.SetBlockLevel(t);
+            stage.Commit();
+        }
+        Check(game.blockWrites == 5 && game.block == 0, "block level written without a change");
+
+        // Reset reads through again
+        game.value[1] = 9.5f;
+        stage.Reset();
+        Check(stage.Get(Knob::LodObjects) == 9.5f, "Reset() did not drop the staged value");
+    }
+
+    struct RunResult
+    {
+        uint32_t adjustments = 0;
+        uint32_t writes = 0;
+        uint32_t blockWrites = 0;
+        std::vector<float> knobs;   // decisions, KnobCount per adjustment
+        float drift = 0.0f;         // worst |game - decision| relative to the knob's epsilon
+    };
+
+    RunResult Run(bool autoAdjust, bool staged, uint32_t frames)
+    {
+        std::mt19937_64 rng(3);
+        std::normal_distribution<float> noise(0.0f, 1.0f);
+        GovernorConfig config;
+        config.autoAdjust = autoAdjust;
+        config.blockEnable = true;
+        QualityGovernor governor;
+        governor.Reset(config);
+        FakeSettings game;
+        SettingsStage stage(game);
+        SetLimits(stage);
+        SettingsBackend& settings = staged ? static_cast<SettingsBackend&>(stage) : game;
+
+        RunResult r;
+        for (uint32_t f = 0; f < frames; f++) {
+            // Heavy stretch in the middle so the knobs and block level move
+            float load = (f > frames / 3 && f < frames * 2 / 3) ? 14.0f : 10.0f;
+            float ms = std::max(1.0f, load + noise(rng));
+            bool adjusted = governor.Frame(static_cast<uint32_t>(ms * 1000.0f), config, settings);
+            if (staged) stage.Commit();
+            if (!adjusted) continue;
+            r.adjustments++;
+            const GovernorDecision& d = governor.Last();
+            for (size_t i = 0; i < KnobCount; i++) {
+                r.knobs.push_back(d.knobs[i]);
+                float eps = std::max(stage.Limit(static_cast<Knob>(i)).epsilon, 1e-6f);
+                r.drift = std::max(r.drift, std::fabs(game.value[i] - d.knobs[i]) / eps);
+            }
+        }
+        r.writes = game.Writes();
+        r.blockWrites = game.blockWrites;
+        return r;
+    }
+
+    void CheckGovernor(uint32_t frames)
+    {
+        RunResult directOff = Run(false, false, frames);
+        RunResult stagedOff = Run(false, true, frames);
+        printf("\nauto-adjust off, %u frames (%u adjustments):\n", frames, directOff.adjustments);
+        printf("  straight through %7u writes\n", directOff.writes);
+        printf("  staged           %7u writes\n", stagedOff.writes);
+        Check(stagedOff.writes == 0, "auto-adjust off wrote a value the game already has");
+
+        RunResult directOn = Run(true, false, frames);
+        RunResult stagedOn = Run(true, true, frames);
+        printf("auto-adjust on, %u frames (%u adjustments):\n", frames, directOn.adjustments);
+        printf("  straight through %7u writes, %5u block level\n", directOn.writes, directOn.blockWrites);
+        printf("  staged           %7u writes, %5u block level (%.1f%% avoided)\n", stagedOn.writes,
+               stagedOn.blockWrites,
+               100.0 * (1.0 - double(stagedOn.writes + stagedOn.blockWrites) /
+                                  std::max(1u, directOn.writes + directOn.blockWrites)));
+        printf("  game within %.2f x epsilon of the decisions\n", stagedOn.drift);
+        Check(directOn.knobs == stagedOn.knobs, "decisions differ behind the stage");
+        Check(stagedOn.drift <= 1.0f, "game drifted more than epsilon from the decisions");
+        Check(stagedOn.writes < directOn.writes, "no write avoided with auto-adjust on");
+    }
+
+    void Bench()
+    {
+        FakeSettings game;
+        SettingsStage stage(game);
+        SetLimits(stage);
+        const int n = 1000000;
+        auto t0 = Clock::now();
+        for (int i = 0; i < n; i++) stage.Commit();
+        double idle = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+
+        t0 = Clock::now();
+        for (int i = 0; i < n; i++) {
+            for (size_t k = 0; k < KnobCount; k++) stage.Set(static_cast<Knob>(k), game.value[k] + (i & 1) * 0.001f);
+            stage.SetBlockLevel(1);
+            stage.Commit();
+        }
+        double adjust = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / n;
+        printf("\nCommit: %.1f ns with nothing staged, %.1f ns after an adjustment (%zu knobs, all within epsilon)\n",
+               idle, adjust, KnobCount);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t frames = 90 * 600;
+    bool bench = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = static_cast<uint32_t>(atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--bench")) bench = true;
+        else {
+            fprintf(stderr, "usage: stage_check [--frames N] [--bench]\n");
+            return 2;
+        }
+    }
+
+    CheckUnits();
+    CheckGovernor(std::max(frames, 90u));
+    if (bench) Bench();
+
+    return Report();
+}
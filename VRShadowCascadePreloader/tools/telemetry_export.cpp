@@ -0,0 +1,170 @@
+// =============================================================================
+// telemetry_export - ShadowBoostF4VR.telemetry to CSV
+//
+//   telemetry_export FILE [--out CSV]
+//   telemetry_export --bench [--frames N]
+//
+// Writes one CSV row per recorded frame, oldest first, to stdout or --out.
+// Torn records (the game died mid-write) are skipped. The first column is
+// the frame time in ms and the knob columns hold the values in effect, so
+// governor_sim --trace replays the file against its cost model.
+// --bench drives a governor with synthetic frames into a temporary file,
+// times Record() per frame, and checks that every exported field matches
+// what was recorded, including after the ring wraps.
+// =============================================================================
+
+#include "frame_telemetry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace CascadePatch;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    const char* const Columns =
+        "frame_ms,frame,adjusted,auto,adjustment,controller,metric,avg_ms,measured_ms,target_ms,dyn_ms,step,"
+        "shadow,lod_objects,lod_items,lod_actors,grass,block";
+
+    void WriteRow(FILE* out, uint64_t frame, const Telemetry::Record& r)
+    {
+        fprintf(out, "%.3f,%llu,%d,%d,%u,%u,%u,%.3f,%.3f,%.3f,%.3f,%.4f,%.1f,%.3f,%.3f,%.3f,%.1f,%u\n",
+                r.frameUs / 1000.0, static_cast<unsigned long long>(frame), (r.flags & Telemetry::Adjusted) ? 1 : 0,
+                (r.flags & Telemetry::AutoAdjust) ? 1 : 0, r.adjustment, r.controller, r.metric, r.avgMs,
+                r.measuredMs, r.targetMs, r.errorMs, r.step, r.knobs[0], r.knobs[1], r.knobs[2], r.knobs[3],
+                r.knobs[4], r.blockIndex);
+    }
+
+    int Export(const char* path, const char* outPath)
+    {
+        TelemetryReader reader;
+        const char* error = nullptr;
+        if (!reader.Open(path, &error)) {
+            fprintf(stderr, "%s: %s\n", path, error);
+            return 1;
+        }
+        FILE* out = outPath ? fopen(outPath, "w") : stdout;
+        if (!out) {
+            fprintf(stderr, "cannot write %s\n", outPath);
+            return 1;
+        }
+        fprintf(out, "%s\n", Columns);
+        uint64_t head = reader.Header().head.load();
+        size_t rows = reader.ForEach([&](uint64_t frame, const Telemetry::Record& r) { WriteRow(out, frame, r); });
+        if (outPath) {
+            fclose(out);
+            fprintf(stderr, "%zu frames (%llu recorded, ring of %u) written to %s\n", rows,
+                    static_cast<unsigned long long>(head), reader.Header().capacity, outPath);
+        }
+        return 0;
+    }
+
+    struct NullSettings final : SettingsBackend
+    {
+        float value[KnobCount] = { 8000.0f, 10.0f, 8.0f, 15.0f, 7000.0f };
+        bool  Has(Knob) const override { return true; }
+        float Get(Knob knob) const override { return value[static_cast<size_t>(knob)]; }
+        void  Set(Knob knob, float v) override { value[static_cast<size_t>(knob)] = v; }
+        bool  HasBlockLevels() const override { return true; }
+        void  SetBlockLevel(int) override {}
+    };
+
+    int Bench(uint32_t frames)
+    {
+        std::string path = "telemetry_export_bench.telemetry";
+        const uint32_t capacity = 4096;
+        FrameTelemetry telemetry;
+        if (!telemetry.Open(path.c_str(), capacity)) {
+            fprintf(stderr, "cannot create %s\n", path.c_str());
+            return 1;
+        }
+
+        // Frame times and the governor's decisions, computed ahead so only Record() is timed
+        std::mt19937_64 rng(1);
+        std::normal_distribution<float> frameMs(11.5f, 1.0f);
+        GovernorConfig config;
+        config.autoAdjust = true;
+        config.blockEnable = true;
+        QualityGovernor governor;
+        governor.Reset(config);
+        NullSettings settings;
+        std::vector<uint32_t> us(frames);
+        std::vector<uint8_t> adjusted(frames);
+        std::vector<GovernorDecision> decisions(frames);
+        for (uint32_t i = 0; i < frames; i++) {
+            us[i] = static_cast<uint32_t>(std::max(1.0f, frameMs(rng)) * 1000.0f);
+            adjusted[i] = governor.Frame(us[i], config, settings);
+            decisions[i] = governor.Last();
+        }
+
+        auto t0 = Clock::now();
+        for (uint32_t i = 0; i < frames; i++) telemetry.Record(us[i], adjusted[i] != 0, config, decisions[i]);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / frames;
+        printf("Record: %.2f ns/frame over %u frames (ring of %u, %zu-byte records)\n", ns, frames, capacity,
+               sizeof(Telemetry::Record));
+
+        // Read back through the exporter's path
+        TelemetryReader reader;
+        const char* error = nullptr;
+        int failures = 0;
+        if (!reader.Open(path.c_str(), &error)) {
+            printf("FAIL: reopen: %s\n", error);
+            failures++;
+        } else {
+            uint64_t expectFirst = frames > capacity ? frames - capacity : 0, expect = expectFirst;
+            size_t rows = reader.ForEach([&](uint64_t frame, const Telemetry::Record& r) {
+                const GovernorDecision& d = decisions[frame];
+                bool ok = frame == expect++ && r.frameUs == us[frame] &&
+                          ((r.flags & Telemetry::Adjusted) != 0) == (adjusted[frame] != 0) &&
+                          r.adjustment == d.adjustment && r.measuredMs == d.measuredMs && r.errorMs == d.errorMs &&
+                          r.step == d.step && r.blockIndex == d.blockIndex &&
+                          memcmp(r.knobs, d.knobs, sizeof(r.knobs)) == 0;
+                if (!ok && failures++ < 5) printf("FAIL: frame %llu differs\n", static_cast<unsigned long long>(frame));
+            });
+            if (rows != frames - expectFirst) {
+                printf("FAIL: %zu rows, expected %llu\n", rows, static_cast<unsigned long long>(frames - expectFirst));
+                failures++;
+            }
+            printf("read back: %zu frames (oldest %llu), %s\n", rows, static_cast<unsigned long long>(expectFirst),
+                   failures ? "MISMATCH" : "all fields match");
+        }
+        telemetry.Close();
+        remove(path.c_str());
+        return failures ? 1 : 0;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* path = nullptr;
+    const char* out = nullptr;
+    bool bench = false;
+    uint32_t frames = 200000;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--out") && i + 1 < argc) out = argv[++i];
+        else if (!strcmp(argv[i], "--bench")) bench = true;
+        else if (!strcmp(argv[i], "--frames") && i + 1 < argc) frames = static_cast<uint32_t>(atoi(argv[++i]));
+        else if (argv[i][0] != '-' && !path) path = argv[i];
+        else {
+            path = nullptr;
+            bench = false;
+            break;
+        }
+    }
+    if (bench) return Bench(std::max(frames, 1u));
+    if (!path) {
+        fprintf(stderr, "usage: telemetry_export FILE [--out CSV]\n"
+                        "       telemetry_export --bench [--frames N]\n");
+        return 2;
+    }
+    return Export(path, out);
+}
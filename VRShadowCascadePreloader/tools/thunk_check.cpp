@@ -0,0 +1,240 @@
+// =============================================================================
+// thunk_check - exercise the proxy export thunks against a stand-in library
+//
+//   thunk_check [libversion_standin.so] [--iterations N] [--threads N]
+//
+// Builds the same generated thunks as the preloader, with the stand-in's
+// exports as the "real" entries, and checks that
+//   - calls before setup finishes take the init path (enter hook runs, slots
+//     untouched) with all eight arguments intact, register and stack,
+//     even though the hook clobbers every argument register
+//   - the first call after the finished hook flips retargets every slot to
+//     its real entry and later calls never enter the hook
+//   - an export missing from the real library returns 0
+//   - threads calling while setup finishes all get correct results
+// then times a call through each path against a direct call and the old
+// EnsureInitialized + function pointer proxy body. Linux x86-64 only.
+// =============================================================================
+
+#include "check.h"
+#include "proxy_exports.h"
+#include "proxy_thunks.h"
+
+#include <dlfcn.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace ToolCheck;
+
+using Fn8 = uint64_t (*)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+
+static const void* g_slots[PROXY_EXPORT_COUNT] = { PROXY_EXPORTS(PROXY_THUNK_INIT_SLOT) };
+
+#define THUNK_CHECK_DEFINE(index, name) PROXY_THUNK_DEFINE(g_slots, index, name)
+PROXY_EXPORTS(THUNK_CHECK_DEFINE)
+
+#define THUNK_CHECK_ENTRY(index, name) { #name, &ProxyThunk_##name },
+static const struct
+{
+    const char*          name;
+    const Thunks::Thunk* thunk;
+} g_exports[] = { PROXY_EXPORTS(THUNK_CHECK_ENTRY) };
+
+namespace
+{
+    constexpr uint32_t Count = PROXY_EXPORT_COUNT;
+
+    const void*           g_real[Count];
+    std::atomic<uint64_t> g_enterCalls{ 0 };
+    std::atomic<bool>     g_finished{ false };
+
+    void Enter()
+    {
+        g_enterCalls.fetch_add(1, std::memory_order_relaxed);
+        // Whatever setup does, the argument registers must survive it
+        asm volatile(
+            "mov $-1, %%rdi\n\tmov $-1, %%rsi\n\tmov $-1, %%rdx\n\tmov $-1, %%rcx\n\t"
+            "mov $-1, %%r8\n\tmov $-1, %%r9\n\tmov $-1, %%r10\n\tmov $-1, %%r11"
+            ::: "rdi", "rsi", "rdx", "rcx", "r8", "r9", "r10", "r11");
+    }
+
+    bool Finished() { return g_finished.load(std::memory_order_acquire); }
+
+    Fn8 ThunkFn(uint32_t i) { return reinterpret_cast<Fn8>(g_exports[i].thunk); }
+
+    uint64_t CallWith(Fn8 fn, uint64_t seed)
+    {
+        return fn(seed, seed + 1, seed * 3, ~seed, seed << 7, seed ^ 0x5555, seed + 0x1000, seed * seed);
+    }
+
+    void Check(bool ok, const char* what, uint32_t index = UINT32_MAX)
+    {
+        if (ok) return;
+        if (index < Count) Fail("%s (%s)", what, g_exports[index].name);
+        else Fail("%s", what);
+    }
+
+    void ResetSlots()
+    {
+        for (uint32_t i = 0; i < Count; i++) g_slots[i] = &Thunks::Inits.entries[i];
+    }
+
+    bool Install(const void* const* real)
+    {
+        ResetSlots();
+        g_finished.store(false);
+        return Thunks::Install({ g_slots, real, Count, Enter, Finished });
+    }
+
+    void CheckInitPath()
+    {
+        for (uint32_t i = 0; i < Count; i++) {
+            for (uint64_t seed : { 1ull, 0x123456789ABCDEFull, ~0ull }) {
+                uint64_t before = g_enterCalls.load();
+                uint64_t got = CallWith(ThunkFn(i), seed);
+                Check(got == CallWith(reinterpret_cast<Fn8>(g_real[i]), seed), "init path result", i);
+                Check(g_enterCalls.load() == before + 1, "init path entered the hook", i);
+                Check(g_slots[i] == &Thunks::Inits.entries[i], "slot untouched before setup finished", i);
+            }
+        }
+        Check(!Thunks::Retargeted(), "not retargeted before setup finished");
+    }
+
+    void CheckRetarget()
+    {
+        g_finished.store(true);
+        uint64_t before = g_enterCalls.load();
+        Check(CallWith(ThunkFn(Count - 1), 42) == CallWith(reinterpret_cast<Fn8>(g_real[Count - 1]), 42),
+              "retargeting call result", Count - 1);
+        Check(Thunks::Retargeted(), "retargeted once setup finished");
+        for (uint32_t i = 0; i < Count; i++) Check(g_slots[i] == g_real[i], "slot points at the real entry", i);
+
+        for (uint32_t i = 0; i < Count; i++) {
+            Check(CallWith(ThunkFn(i), i * 977) == CallWith(reinterpret_cast<Fn8>(g_real[i]), i * 977),
+                  "direct path result", i);
+        }
+        Check(g_enterCalls.load() == before + 1, "no hook calls after retargeting");
+    }
+
+    void CheckMissing()
+    {
+        const void* real[Count];
+        memcpy(real, g_real, sizeof(real));
+        real[0] = nullptr;
+        Check(Install(real), "reinstall");
+        Check(CallWith(ThunkFn(0), 7) == 0, "missing export returns 0 on the init path", 0);
+        g_finished.store(true);
+        Check(CallWith(ThunkFn(1), 7) == CallWith(reinterpret_cast<Fn8>(g_real[1]), 7), "retarget result", 1);
+        Check(CallWith(ThunkFn(0), 7) == 0, "missing export returns 0 once retargeted", 0);
+    }
+
+    void CheckThreads(int threads, uint64_t calls)
+    {
+        Check(Install(g_real), "reinstall");
+        std::atomic<uint64_t> wrong{ 0 };
+        std::vector<std::thread> pool;
+        for (int t = 0; t < threads; t++) {
+            pool.emplace_back([&, t] {
+                for (uint64_t n = 0; n < calls; n++) {
+                    uint32_t i = static_cast<uint32_t>((n + t) % Count);
+                    uint64_t seed = n * 31 + t;
+                    if (CallWith(ThunkFn(i), seed) != CallWith(reinterpret_cast<Fn8>(g_real[i]), seed)) wrong++;
+                    if (t == 0 && n == calls / 4) g_finished.store(true, std::memory_order_release);
+                }
+            });
+        }
+        for (std::thread& th : pool) th.join();
+        Check(wrong.load() == 0, "concurrent results");
+        Check(Thunks::Retargeted(), "retargeted under concurrent calls");
+        printf("%d threads x %llu calls across setup finishing: %llu wrong results\n",
+               threads, (unsigned long long)calls, (unsigned long long)wrong.load());
+    }
+
+    // ---- Old proxy body: EnsureInitialized() fast path + null check + call ----
+    std::atomic<bool> g_oldInitDone{ true };
+    Fn8 g_oldTarget = nullptr;
+
+    __attribute__((noinline)) void OldEnsureInitialized()
+    {
+        if (g_oldInitDone.load(std::memory_order_acquire)) return;
+        Enter();
+    }
+
+    __attribute__((noinline)) uint64_t OldExport(uint64_t a, uint64_t b, uint64_t c, uint64_t d,
+                                                 uint64_t e, uint64_t f, uint64_t g, uint64_t h)
+    {
+        OldEnsureInitialized();
+        if (g_oldTarget) return g_oldTarget(a, b, c, d, e, f, g, h);
+        return 0;
+    }
+
+    void Bench(uint64_t iterations)
+    {
+        auto time = [&](const char* label, Fn8 fn) {
+            Fn8 volatile target = fn;   // keep the call indirect
+            uint64_t sink = 0;
+            auto start = std::chrono::steady_clock::now();
+            for (uint64_t n = 0; n < iterations; n++) sink += CallWith(target, n);
+            double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            printf("%-40s %6.2f ns/call (%llu)\n", label, ns / iterations, (unsigned long long)(sink & 1));
+        };
+
+        g_oldTarget = reinterpret_cast<Fn8>(g_real[0]);
+        time("direct call to the real entry", reinterpret_cast<Fn8>(g_real[0]));
+        time("old proxy body", &OldExport);
+
+        Install(g_real);
+        time("thunk, init path", ThunkFn(0));
+        g_finished.store(true);
+        CallWith(ThunkFn(0), 0);
+        time("thunk, retargeted", ThunkFn(0));
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const char* library = VERSION_STANDIN_PATH;
+    uint64_t iterations = 20000000;
+    int threads = 8;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = strtoull(argv[++i], nullptr, 10);
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (argv[i][0] != '-') library = argv[i];
+        else {
+            fprintf(stderr, "usage: thunk_check [libversion_standin.so] [--iterations N] [--threads N]\n");
+            return 2;
+        }
+    }
+
+    void* handle = dlopen(library, RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+        fprintf(stderr, "cannot load %s: %s\n", library, dlerror());
+        return 1;
+    }
+    for (uint32_t i = 0; i < Count; i++) {
+        g_real[i] = dlsym(handle, g_exports[i].name);
+        if (!g_real[i]) {
+            fprintf(stderr, "%s: missing %s\n", library, g_exports[i].name);
+            return 1;
+        }
+    }
+    if (!Install(g_real)) {
+        fprintf(stderr, "thunk section could not be made executable\n");
+        return 1;
+    }
+
+    CheckInitPath();
+    CheckRetarget();
+    CheckMissing();
+    CheckThreads(threads > 0 ? threads : 1, 200000);
+    printf("%u exports, %llu init-path calls\n", Count, (unsigned long long)Thunks::InitCalls());
+    if (iterations) Bench(iterations);
+    return Report();
+}
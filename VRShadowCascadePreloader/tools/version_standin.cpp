@@ -0,0 +1,32 @@
+// =============================================================================
+// version_standin - stand-in for the system version.dll on Linux
+// Exports every name from version.def as a function of eight integer
+// arguments (six in registers, two on the stack under SysV) that returns a
+// hash of its export index and arguments, so thunk_check can tell whether a
+// call reached the right entry with its arguments intact.
+// =============================================================================
+
+#include "proxy_exports.h"
+
+#include <cstdint>
+#include <initializer_list>
+
+namespace
+{
+    uint64_t Mix(uint64_t index, uint64_t a, uint64_t b, uint64_t c, uint64_t d,
+                 uint64_t e, uint64_t f, uint64_t g, uint64_t h)
+    {
+        uint64_t v = (index + 1) * 0x9E3779B97F4A7C15ull;
+        for (uint64_t arg : { a, b, c, d, e, f, g, h }) v = (v ^ arg) * 0x100000001B3ull;
+        return v;
+    }
+}
+
+#define STANDIN_EXPORT(index, name)                                                          \
+    extern "C" __attribute__((visibility("default"))) uint64_t name(                         \
+        uint64_t a, uint64_t b, uint64_t c, uint64_t d, uint64_t e, uint64_t f, uint64_t g, uint64_t h) \
+    {                                                                                        \
+        return Mix(index, a, b, c, d, e, f, g, h);                                           \
+    }
+
+PROXY_EXPORTS(STANDIN_EXPORT)
@@ -0,0 +1,255 @@
+// =============================================================================
+// watch_bench - region watch vs. the non-zero byte loop
+//
+//   watch_bench [--iterations N] [--seed N]
+//
+// Checks the SSE2 ChangedWords/NonZeroBytes against plain byte loops on
+// random buffers of every size up to 512 bytes and every start alignment,
+// and that a single flipped byte always moves Hash(). Then runs the old
+// RefreshVRArrayEntries test (non-zero bytes of entries 0 and 2, populated
+// if nz0 > nz2 + 2) and the new one (watched data words of entry 0 against
+// entry 2) on the same four VR entries through the cases the game produces:
+// untouched template copy, spinlock churn, the game rewriting a matrix with
+// other non-zero values, and the game filling a zeroed field. Finally times
+// one timer tick of each: the old loop over all four entries, the new word
+// compare, and a RegionWatch poll of entry 0 with and without a change.
+// =============================================================================
+
+#include "check.h"
+#include "game_state.h"
+#include "region_watch.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace CascadePatch;
+using namespace CascadePatch::VRArrayExpansion;
+using namespace ToolCheck;
+
+using Clock = std::chrono::steady_clock;
+
+namespace
+{
+    // The loops the preloader used before the region watch
+    uint32_t ScalarNonZero(const uint8_t* data, size_t size)
+    {
+        uint32_t n = 0;
+        for (size_t i = 0; i < size; i++) {
+            if (data[i] != 0) n++;
+        }
+        return n;
+    }
+
+    uint64_t ScalarChangedWords(const uint8_t* a, const uint8_t* b, size_t size)
+    {
+        uint64_t changed = 0;
+        for (size_t i = 0; i < size; i++) {
+            if (a[i] != b[i]) changed |= 1ull << (i / 8);
+        }
+        return changed;
+    }
+
+    bool OldPopulated(uintptr_t buf)
+    {
+        uint32_t nz[TargetCount];
+        for (uint32_t i = 0; i < TargetCount; i++) {
+            nz[i] = ScalarNonZero(reinterpret_cast<const uint8_t*>(buf + i * EntrySize), EntrySize);
+        }
+        return nz[0] > nz[2] + 2;
+    }
+
+    bool NewPopulated(uintptr_t buf)
+    {
+        const uint8_t* e = reinterpret_cast<const uint8_t*>(buf);
+        return (Watch::ChangedWords(e, e + 2 * EntrySize, EntrySize) & GameState::VREntryDataWords) != 0;
+    }
+
+    void CheckKernels(std::mt19937_64& rng)
+    {
+        alignas(16) uint8_t a[Watch::MaxRegionBytes + 16], b[Watch::MaxRegionBytes + 16];
+        int cases = 0;
+        for (size_t size = 1; size <= Watch::MaxRegionBytes; size++) {
+            for (size_t align = 0; align < 16; align += (size < 64 ? 1 : 5)) {
+                uint8_t* pa = a + align;
+                uint8_t* pb = b + align;
+                // Sparse data: about a third zero bytes, a few differing words
+                for (size_t i = 0; i < size; i++) pa[i] = (rng() % 3) ? static_cast<uint8_t>(rng()) : 0;
+                memcpy(pb, pa, size);
+                for (int flips = rng() % 4; flips > 0; flips--) pb[rng() % size] ^= static_cast<uint8_t>(1 + rng() % 255);
+
+                Check(Watch::NonZeroBytes(pa, size) == ScalarNonZero(pa, size), "NonZeroBytes");
+                Check(Watch::ChangedWords(pa, pb, size) == ScalarChangedWords(pa, pb, size), "ChangedWords");
+                Check(Watch::Hash(pa, size) == Watch::Hash(pa, size), "Hash is deterministic");
+
+                uint64_t h = Watch::Hash(pa, size);
+                size_t at = rng() % size;
+                pa[at] ^= static_cast<uint8_t>(1u << (rng() % 8));
+                Check(Watch::Hash(pa, size) != h, "Hash misses a single bit flip");
+                cases++;
+            }
+        }
+        Check(Watch::Words(0x70, 16) == (3ull << 14), "Words(0x70, 16)");
+        Check(std::popcount(GameState::VREntryDataWords) == 48 - 1 - 2 * 4, "VREntryDataWords");
+        printf("kernels: %d size/alignment cases checked against byte loops\n", cases);
+    }
+
+    // Four 0x180-byte entries: 0-1 populated by the game, 2-3 our template copies
+    struct Entries
+    {
+        alignas(16) uint8_t bytes[TargetCount * EntrySize];
+        uintptr_t Buf() { return reinterpret_cast<uintptr_t>(bytes); }
+        float* Floats(uint32_t entry, size_t offset) { return reinterpret_cast<float*>(bytes + entry * EntrySize + offset); }
+
+        void Populate(std::mt19937_64& rng)
+        {
+            memset(bytes, 0, sizeof(bytes));
+            std::uniform_real_distribution<float> value(-2000.0f, 2000.0f);
+            for (uint32_t e = 0; e < 2; e++) {
+                // Two 4x4 matrices and a few scalars; the rest stays zero
+                for (size_t f = 0; f < 32; f++) *Floats(e, 0x20 + f * 4) = value(rng);
+                *Floats(e, 0x138) = 0.5f;
+                *Floats(e, 0x150) = 1.0f;
+            }
+            for (uint32_t e = 2; e < TargetCount; e++) GameState::CopyVREntry(Buf() + e * EntrySize, Buf());
+        }
+    };
+
+    struct Case
+    {
+        const char* name;
+        bool populated;
+        void (*apply)(Entries&, std::mt19937_64&);
+    };
+
+    const Case Cases[] = {
+        { "template copy untouched", false, [](Entries&, std::mt19937_64&) {} },
+        { "spinlock taken on entry 0", false, [](Entries& e, std::mt19937_64&) {
+              *reinterpret_cast<uint32_t*>(e.bytes) = 0x1A2C;
+              *reinterpret_cast<uint32_t*>(e.bytes + 4) = 1;
+          } },
+        { "pool list pushed on entry 0", false, [](Entries& e, std::mt19937_64&) {
+              *reinterpret_cast<uintptr_t*>(e.bytes + 0x70) = 0x2A0400001230;
+              *reinterpret_cast<uintptr_t*>(e.bytes + 0x78) = 0x2A0400001230;
+          } },
+        { "matrix rewritten (non-zero -> non-zero)", true, [](Entries& e, std::mt19937_64& rng) {
+              std::uniform_real_distribution<float> value(1.0f, 1000.0f);
+              for (size_t f = 0; f < 16; f++) *e.Floats(0, 0x20 + f * 4) = value(rng);
+          } },
+        { "zeroed field filled", true, [](Entries& e, std::mt19937_64&) {
+              for (size_t f = 0; f < 8; f++) *e.Floats(0, 0xC0 + f * 4) = 3.0f + f;
+          } },
+    };
+
+    void CheckDetection(std::mt19937_64& rng)
+    {
+        Entries entries;
+        printf("\npopulated detection (entry 0 vs. template copy in entry 2):\n");
+        printf("  %-42s %-8s %-8s %s\n", "case", "expected", "old", "region watch");
+        for (const Case& c : Cases) {
+            entries.Populate(rng);
+            c.apply(entries, rng);
+            bool before = OldPopulated(entries.Buf());
+            bool after = NewPopulated(entries.Buf());
+            printf("  %-42s %-8s %-8s %s\n", c.name, c.populated ? "yes" : "no", before ? "yes" : "no",
+                   after ? "yes" : "no");
+            Check(after == c.populated, c.name);
+        }
+    }
+
+    template <typename Fn>
+    double NsPerCall(int iterations, Fn&& fn)
+    {
+        // Best of 5 batches
+        double best = 1e30;
+        for (int batch = 0; batch < 5; batch++) {
+            auto t0 = Clock::now();
+            for (int i = 0; i < iterations; i++) fn(i);
+            double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / iterations;
+            best = std::min(best, ns);
+        }
+        return best;
+    }
+
+    volatile uint64_t sink;
+
+    void Bench(std::mt19937_64& rng, int iterations)
+    {
+        Entries entries;
+        entries.Populate(rng);
+        uintptr_t buf = entries.Buf();
+
+        RegionWatch watch;
+        int id = watch.Add("vr_entry0", buf, EntrySize, GameState::VREntryDataWords);
+
+        printf("\none timer tick, %d iterations:\n", iterations);
+        double old = NsPerCall(iterations, [&](int) { sink = OldPopulated(buf); });
+        printf("  %-40s %8.1f ns\n", "byte loop, 4 entries (old)", old);
+
+        double refresh = NsPerCall(iterations, [&](int) {
+            uint32_t nz = 0;
+            for (uint32_t i = 0; i < 2 * TargetCount; i++) {
+                nz += ScalarNonZero(reinterpret_cast<const uint8_t*>(buf + (i % TargetCount) * EntrySize), EntrySize);
+            }
+            sink = nz;
+        });
+        printf("  %-40s %8.1f ns\n", "byte loop, before+after log counts (old)", refresh);
+
+        double words = NsPerCall(iterations, [&](int) { sink = NewPopulated(buf); });
+        printf("  %-40s %8.1f ns  (%.1fx)\n", "ChangedWords entry 0 vs 2", words, old / words);
+
+        double nonZero = NsPerCall(iterations, [&](int) {
+            uint32_t nz = 0;
+            for (uint32_t i = 0; i < 2 * TargetCount; i++) {
+                nz += Watch::NonZeroBytes(reinterpret_cast<const uint8_t*>(buf + (i % TargetCount) * EntrySize), EntrySize);
+            }
+            sink = nz;
+        });
+        printf("  %-40s %8.1f ns  (%.1fx)\n", "NonZeroBytes, log counts", nonZero, refresh / nonZero);
+
+        double hash = NsPerCall(iterations, [&](int) { sink = Watch::Hash(entries.bytes, EntrySize); });
+        printf("  %-40s %8.1f ns\n", "Hash, 0x180 bytes", hash);
+
+        double idle = NsPerCall(iterations, [&](int) { sink = watch.Poll(); });
+        printf("  %-40s %8.1f ns  (%.1fx)\n", "Poll, entry 0 unchanged", idle, old / idle);
+
+        float* field = entries.Floats(0, 0x20);
+        double changed = NsPerCall(iterations, [&](int i) {
+            *field = static_cast<float>(i + 1);
+            sink = watch.Poll();
+        });
+        printf("  %-40s %8.1f ns  (%.1fx)\n", "Poll, entry 0 written every tick", changed, old / changed);
+
+        const RegionWatch::Stats& stats = watch.GetStats(id);
+        Check(watch.FieldChanged(id, 0x20, 4) && !watch.FieldChanged(id, 0x70, 16), "FieldChanged");
+        printf("  watch stats: %u polls, %u unchanged by hash, %u with changes\n", stats.polls, stats.unchanged,
+               stats.changes);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int iterations = 200000;
+    uint64_t seed = 1;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--iterations") && i + 1 < argc) iterations = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && i + 1 < argc) seed = strtoull(argv[++i], nullptr, 10);
+        else {
+            fprintf(stderr, "usage: watch_bench [--iterations N] [--seed N]\n");
+            return 2;
+        }
+    }
+    if (iterations < 1) iterations = 1;
+
+    std::mt19937_64 rng(seed);
+    CheckKernels(rng);
+    CheckDetection(rng);
+    Bench(rng, iterations);
+
+    return Report();
+}